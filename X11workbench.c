@@ -344,8 +344,8 @@ next_argument:
   colormap = WBDefaultColormap(pX11Display);
 
   // additional allocated colors - in this case, GREEN
-  XParseColor(pX11Display, colormap, szGreen, &clrGreen);
-  XAllocColor(pX11Display, colormap, &clrGreen);  // NOTE:  do I need 'XFreeColors' for 'clrGreen' ?
+  PXM_ParseColor(pX11Display, colormap, szGreen, &clrGreen);
+  PXM_AllocColor(pX11Display, colormap, &clrGreen);
 
 #ifndef NO_SPLASH
 
@@ -445,6 +445,8 @@ next_argument:
       // I'll want to implement something that has WBDelay() calls when there
       // is nothing to do...
 
+      WBSubAllocTrashMasher(); // idle, so return completely unused memory to the OS
+
 //      if(1)
 //      {
         WBWaitForEvent(pX11Display);
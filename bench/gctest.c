@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////
+//                                                    //
+//                  _               _                 //
+//      __ _   ___ | |_   ___  ___ | |_       ___     //
+//     / _` | / __|| __| / _ \/ __|| __|     / __|    //
+//    | (_| || (__ | |_ |  __/\__ \| |_  _  | (__     //
+//     \__, | \___| \__| \___||___/ \__|(_)  \___|    //
+//     |___/                                          //
+//                                                    //
+////////////////////////////////////////////////////////
+
+
+/*****************************************************************************
+
+    X11workbench - X11 programmer's 'work bench' application and toolkit
+    Copyright (c) 2010-2019 by Bob Frazier (aka 'Big Bad Bombastic Bob')
+                           all rights reserved
+
+  DISCLAIMER:  The X11workbench application and toolkit software are supplied
+               'as-is', with no warranties, either implied or explicit.
+
+  BSD-like license:
+
+  There is no restriction as to what you can do with this software, so long
+  as you include the above copyright notice and DISCLAIMER for any distributed
+  work that is linked with, equivalent to, or derived from any portion of this
+  software, along with this paragraph that explains the terms of the license if
+  the source is also being made available.  "Linked with" includes the use of a
+  portion of any of the source and/or header files, or their compiled binary
+  output, as a part of your application or library.   A "derived work"
+  describes a work that uses a significant portion of the source files or the
+  algorithms that are included with this software.
+
+  EXCLUSIONS
+
+  Specifically excluded from this requirement are files that were generated by
+  the software, or anything that is included with the software that is part of
+  another package (such as files that were created or added during the
+  'configure' process).
+
+  DISTRIBUTION
+
+  The license also covers the use of part or all of any of the X11 workbench
+  toolkit source or header files in your distributed application, in source or
+  binary form.  If you do not ship the source, the above copyright statement
+  and DISCLAIMER is still required to be placed in a reasonably prominent
+  place, such as documentation, splash screens, and/or 'about the application'
+  dialog boxes.
+
+  Use and distribution are in accordance with GPL, LGPL, and/or the above
+  BSD-like license.  See COPYING and README.md files for more information.
+
+  Additionally, this software, in source or binary form, and in whole or in
+  part, may be used by explicit permission from the author, without the need
+  of a license.
+
+  Additional information at http://sourceforge.net/projects/X11workbench
+  and http://bombasticbob.github.io/X11workbench/
+
+******************************************************************************/
+
+
+// gctest - checks that the WBGC shadow values stay in sync with the server
+//
+// The WBGC wrappers skip requests that would not change anything, based on the 'values' member of the
+// WBGC.  Anything that changes the GC on the server as a side effect (like XSetRegion, which also sets
+// the clip origin to 0,0) has to update those values, or a later call is wrongly skipped.  Xlib keeps
+// its own copy of the GC values, updated for every request it sends, so XGetGCValues tells us what
+// the server actually has.
+//
+// This needs a display.  When there isn't one, it exits with 77 (the automake 'skipped' status).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include <string.h>
+
+#include "window_helper.h"
+#include "platform_helper.h"
+
+
+#define EXIT_SKIPPED 77 /* automake's exit code for a skipped test */
+
+static int nFailed = 0;
+
+
+// compare the clip origin that Xlib sent to the server with the expected value and the shadow value
+static void __CheckClipOrigin(WBGC hGC, int iX, int iY, const char *szStep)
+{
+XGCValues xgcv;
+
+
+  bzero(&xgcv, sizeof(xgcv));
+  XGetGCValues(hGC->display, hGC->gc, GCClipXOrigin | GCClipYOrigin, &xgcv);
+
+  if(xgcv.clip_x_origin != iX || xgcv.clip_y_origin != iY ||
+     hGC->values.clip_x_origin != iX || hGC->values.clip_y_origin != iY)
+  {
+    fprintf(stderr, "FAIL:  %s - clip origin %d,%d (shadow %d,%d), expected %d,%d\n",
+            szStep, xgcv.clip_x_origin, xgcv.clip_y_origin,
+            hGC->values.clip_x_origin, hGC->values.clip_y_origin, iX, iY);
+
+    nFailed++;
+  }
+  else
+  {
+    fprintf(stderr, "ok:  %s\n", szStep);
+  }
+}
+
+static Region __MakeRegion(void)
+{
+WB_RECT rct;
+
+
+  rct.left = 0;
+  rct.top = 0;
+  rct.right = 32;
+  rct.bottom = 16;
+
+  return WBRectToRegion(&rct);
+}
+
+int main(int argc, char *argv[], char *envp[])
+{
+WB_DISPLAY pDisplay;
+WBGC hGC;
+Region rgn;
+XGCValues xgcv;
+
+
+  if(WBParseStandardArguments(&argc, &argv, &envp))
+  {
+    return 1;
+  }
+
+  pDisplay = WBInit(NULL); // uses '--display' or $DISPLAY
+
+  if(!pDisplay)
+  {
+    fprintf(stderr, "gctest:  no display, skipped\n");
+    return EXIT_SKIPPED;
+  }
+
+  hGC = WBCreateGC(pDisplay, None, 0, NULL);
+  rgn = __MakeRegion();
+
+  if(!hGC || rgn == None)
+  {
+    fprintf(stderr, "gctest:  unable to create the GC or region\n");
+
+    WBExit();
+    return 1;
+  }
+
+  // the clip origin, then a region (which resets the origin), then the SAME clip origin again
+
+  WBSetClipOrigin(hGC, 5, 7);
+  __CheckClipOrigin(hGC, 5, 7, "WBSetClipOrigin");
+
+  WBSetRegion(hGC, rgn);
+  __CheckClipOrigin(hGC, 0, 0, "WBSetRegion resets the clip origin");
+
+  WBSetClipOrigin(hGC, 5, 7);
+  __CheckClipOrigin(hGC, 5, 7, "WBSetClipOrigin after WBSetRegion");
+
+  // the same sequence, restoring the origin with WBChangeGC instead
+
+  WBSetRegion(hGC, rgn);
+
+  bzero(&xgcv, sizeof(xgcv));
+  xgcv.clip_x_origin = 5;
+  xgcv.clip_y_origin = 7;
+
+  WBChangeGC(hGC, GCClipXOrigin | GCClipYOrigin, &xgcv);
+  __CheckClipOrigin(hGC, 5, 7, "WBChangeGC clip origin after WBSetRegion");
+
+  XDestroyRegion(rgn);
+  WBFreeGC(hGC);
+
+  WBExit();
+
+  if(nFailed)
+  {
+    fprintf(stderr, "gctest:  %d check%s FAILED\n", nFailed, nFailed == 1 ? "" : "s");
+    return 1;
+  }
+
+  return 0;
+}
+
@@ -0,0 +1,1150 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//                  _      _                          _                      //
+//       __      __| |__  | |__    ___   _ __    ___ | |__       ___         //
+//       \ \ /\ / /| '_ \ | '_ \  / _ \ | '_ \  / __|| '_ \     / __|        //
+//        \ V  V / | |_) || |_) ||  __/ | | | || (__ | | | | _ | (__         //
+//         \_/\_/  |_.__/ |_.__/  \___| |_| |_| \___||_| |_|(_) \___|        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+
+/*****************************************************************************
+
+    X11workbench - X11 programmer's 'work bench' application and toolkit
+    Copyright (c) 2010-2019 by Bob Frazier (aka 'Big Bad Bombastic Bob')
+                           all rights reserved
+
+  DISCLAIMER:  The X11workbench application and toolkit software are supplied
+               'as-is', with no warranties, either implied or explicit.
+
+  BSD-like license:
+
+  There is no restriction as to what you can do with this software, so long
+  as you include the above copyright notice and DISCLAIMER for any distributed
+  work that is linked with, equivalent to, or derived from any portion of this
+  software, along with this paragraph that explains the terms of the license if
+  the source is also being made available.  "Linked with" includes the use of a
+  portion of any of the source and/or header files, or their compiled binary
+  output, as a part of your application or library.   A "derived work"
+  describes a work that uses a significant portion of the source files or the
+  algorithms that are included with this software.
+
+  EXCLUSIONS
+
+  Specifically excluded from this requirement are files that were generated by
+  the software, or anything that is included with the software that is part of
+  another package (such as files that were created or added during the
+  'configure' process).
+
+  DISTRIBUTION
+
+  The license also covers the use of part or all of any of the X11 workbench
+  toolkit source or header files in your distributed application, in source or
+  binary form.  If you do not ship the source, the above copyright statement
+  and DISCLAIMER is still required to be placed in a reasonably prominent
+  place, such as documentation, splash screens, and/or 'about the application'
+  dialog boxes.
+
+  Use and distribution are in accordance with GPL, LGPL, and/or the above
+  BSD-like license.  See COPYING and README.md files for more information.
+
+  Additionally, this software, in source or binary form, and in whole or in
+  part, may be used by explicit permission from the author, without the need
+  of a license.
+
+  Additional information at http://sourceforge.net/projects/X11workbench
+  and http://bombasticbob.github.io/X11workbench/
+
+******************************************************************************/
+
+
+// wbbench - micro-benchmarks for the X11 workbench toolkit
+//
+// The default mode runs without an X server, and times the text buffer and text object operations,
+// the memory allocator, string utilities, configuration file and XML parsing, sorting, and the pointer
+// hash.  The '--x11' mode opens the display (run it under Xvfb for repeatable numbers) and times atom
+// lookups, plus the expose and scroll throughput of an edit window.
+//
+// Each benchmark is calibrated so that one sample takes at least BENCH_MIN_SAMPLE msec, and then the
+// median of BENCH_SAMPLES samples is reported, along with the spread between the fastest and slowest.
+
+#ifdef linux /* needed for debian, possibly others */
+#define _GNU_SOURCE /* in case features.h is involved on linux */
+#define __USE_GNU /* this enables a few more things in the headers like 'qsort_r' */
+#endif // linux
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+// project includes
+#include "window_helper.h"
+#include "platform_helper.h"
+#include "debug_helper.h"
+#include "conf_help.h"
+#include "text_object.h"
+#include "frame_window.h"
+#include "edit_window.h"
+#include "pixmap_helper.h"
+
+
+#define BENCH_MIN_SAMPLE 20   /* msec, minimum time for one sample */
+#define BENCH_SAMPLES    7    /* samples per benchmark, the median is reported */
+#define BENCH_TEXT_LINES 10000 /* lines of generated text for the text and string benchmarks */
+
+typedef struct __bench__
+{
+  const char *szName;
+  void (*pSetup)(void *pCtx, long nIter); // called before each sample (not timed), can be NULL
+  void (*pRun)(void *pCtx, long nIter);   // the timed part
+  long nMaxIter;                          // upper limit for the iteration count, zero for none
+  double dBytesPerOp;                     // non-zero to report throughput in MB/sec rather than operations/sec
+} BENCH;
+
+typedef struct __bench_context__
+{
+  char *pText;                // generated text, BENCH_TEXT_LINES lines
+  unsigned int cbText;
+  TEXT_BUFFER *pTextBuffer;
+  TEXT_OBJECT xTextObject;
+  void *pConf;                // configuration file from CHOpenConfFile()
+  char *pXML;                 // generated XML
+  int cbXML;
+  int *paSortSource, *paSort; // random and 'being sorted' arrays, 'nSort' elements each
+  int nSort;
+  WB_UINT32 auiHash[1024];    // pointer hashes
+  char szHome[64];            // temporary HOME for the configuration file (from mkdtemp)
+  WB_DISPLAY pDisplay;        // the remaining members are only valid in '--x11' mode
+  WBFrameWindow *pFrame;
+  WBEditWindow *pEdit;
+  Atom aAtoms[64];
+} BENCH_CONTEXT;
+
+static const char *szFilter = NULL; // only run benchmarks whose names contain this
+static int nSamples = BENCH_SAMPLES, nMinSample = BENCH_MIN_SAMPLE;
+static volatile unsigned long ulSink = 0; // keeps results from being optimized away
+static WB_UINT32 uiSeed = 1;
+
+
+static WB_UINT32 __BenchRandom(void) // repeatable from one run to the next, unlike rand()
+{
+  uiSeed = uiSeed * 1103515245U + 12345U;
+
+  return uiSeed >> 8;
+}
+
+static WB_UINT64 __BenchSample(const BENCH *pB, void *pCtx, long nIter)
+{
+WB_UINT64 nsStart;
+
+
+  if(pB->pSetup)
+  {
+    pB->pSetup(pCtx, nIter);
+  }
+
+  nsStart = WBGetMonotonicTimeNS();
+
+  pB->pRun(pCtx, nIter);
+
+  return WBGetMonotonicTimeNS() - nsStart;
+}
+
+static int __BenchCompare(const void *p1, const void *p2)
+{
+  return *(const double *)p1 < *(const double *)p2 ? -1 : *(const double *)p1 > *(const double *)p2 ? 1 : 0;
+}
+
+static void __BenchRun(const BENCH *pB, void *pCtx)
+{
+double adNsPerOp[BENCH_SAMPLES], dMedian, dSpread, dRate;
+WB_UINT64 nsSample, nsMin;
+long nIter, nNext;
+int i1;
+
+
+  if(szFilter && !strstr(pB->szName, szFilter))
+  {
+    return;
+  }
+
+  // calibrate the iteration count.  This also warms up the caches and the allocator.
+
+  nsMin = (WB_UINT64)nMinSample * 1000000;
+
+  for(nIter=1; ; nIter=nNext)
+  {
+    nsSample = __BenchSample(pB, pCtx, nIter);
+
+    if(nsSample >= nsMin || (pB->nMaxIter && nIter >= pB->nMaxIter))
+    {
+      break;
+    }
+
+    nNext = nsSample > nsMin / 100 ? (long)((double)nIter * 1.2 * (double)nsMin / (double)nsSample) + 1
+                                   : nIter * 10;
+
+    if(pB->nMaxIter && nNext > pB->nMaxIter)
+    {
+      nNext = pB->nMaxIter;
+    }
+  }
+
+  for(i1=0; i1 < nSamples; i1++)
+  {
+    adNsPerOp[i1] = (double)__BenchSample(pB, pCtx, nIter) / (double)nIter;
+  }
+
+  qsort(adNsPerOp, nSamples, sizeof(adNsPerOp[0]), __BenchCompare);
+
+  dMedian = adNsPerOp[nSamples / 2];
+  dSpread = dMedian > 0.0 ? 100.0 * (adNsPerOp[nSamples - 1] - adNsPerOp[0]) / dMedian : 0.0;
+
+  if(pB->dBytesPerOp > 0.0)
+  {
+    dRate = dMedian > 0.0 ? pB->dBytesPerOp * 1000.0 / dMedian : 0.0; // bytes per nsec * 1000 = MB/sec
+
+    printf("%-44s %10ld %14.1f %7.1f%% %10.1f MB/s\n", pB->szName, nIter, dMedian, dSpread, dRate);
+  }
+  else
+  {
+    dRate = dMedian > 0.0 ? 1000000000.0 / dMedian : 0.0;
+
+    printf("%-44s %10ld %14.1f %7.1f%% %10.0f op/s\n", pB->szName, nIter, dMedian, dSpread, dRate);
+  }
+
+  fflush(stdout);
+}
+
+static void __BenchHeading(const char *szTitle)
+{
+  printf("\n%-44s %10s %14s %8s %15s\n", szTitle, "iter", "ns/op", "spread", "throughput");
+}
+
+// generate 'C-like' text with a repeatable mix of line lengths, indents, and tabs
+static char * __BenchMakeText(int nLines, unsigned int *pcbText)
+{
+static const char * const aszWords[] =
+{
+  "if(", "pEntry", "->", "iValue", " = ", "WBAlloc(", "sizeof(", "*pRval", ");", "return", " ", "nCount",
+  "++", "{", "}", "while(", "\t", "0", "szText[i1]", "&&", "// a comment", "NULL", "+ 1", ","
+};
+char *pRval, *p1;
+int i1, i2, nWords, nIndent;
+
+
+  pRval = (char *)WBAlloc(nLines * 128 + 1);
+
+  if(!pRval)
+  {
+    return NULL;
+  }
+
+  p1 = pRval;
+
+  for(i1=0; i1 < nLines; i1++)
+  {
+    nIndent = __BenchRandom() % 4;
+
+    for(i2=0; i2 < nIndent; i2++)
+    {
+      *(p1++) = ' ';
+      *(p1++) = ' ';
+    }
+
+    nWords = __BenchRandom() % 12; // some lines are blank
+
+    for(i2=0; i2 < nWords; i2++)
+    {
+      const char *pW = aszWords[__BenchRandom() % (sizeof(aszWords) / sizeof(aszWords[0]))];
+      int cbW = strlen(pW);
+
+      memcpy(p1, pW, cbW);
+      p1 += cbW;
+    }
+
+    *(p1++) = '\n';
+  }
+
+  *p1 = 0;
+
+  *pcbText = p1 - pRval;
+
+  return pRval;
+}
+
+static char * __BenchMakeXML(int nItems, int *pcbXML)
+{
+char *pRval = NULL;
+char tbuf[256];
+int i1;
+
+
+  WBCatString(&pRval, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!-- generated by wbbench -->\n<root>\n");
+
+  for(i1=0; pRval && i1 < nItems; i1++)
+  {
+    snprintf(tbuf, sizeof(tbuf),
+             "  <item id=\"%d\" name=\"item_%d\" flags='%x'>\n"
+             "    <value>%u &amp; more &lt;text&gt;</value>\n"
+             "    <empty />\n"
+             "  </item>\n",
+             i1, i1, __BenchRandom() & 0xffff, __BenchRandom());
+
+    WBCatString(&pRval, tbuf);
+  }
+
+  if(pRval)
+  {
+    WBCatString(&pRval, "</root>\n");
+  }
+
+  *pcbXML = pRval ? strlen(pRval) : 0;
+
+  return pRval;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// MEMORY ALLOCATION
+//////////////////////////////////////////////////////////////////////////////
+
+static void __BenchAllocFree(long nIter, int cbSize)
+{
+char *p1;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    p1 = (char *)WBAlloc(cbSize);
+
+    if(p1)
+    {
+      p1[0] = (char)l1; // touch it
+      WBFree(p1);
+    }
+  }
+}
+
+static void __BenchAllocFree16(void *pCtx, long nIter)
+{
+  (void)pCtx;
+
+  __BenchAllocFree(nIter, 16);
+}
+
+static void __BenchAllocFree256(void *pCtx, long nIter)
+{
+  (void)pCtx;
+
+  __BenchAllocFree(nIter, 256);
+}
+
+static void __BenchAllocFree4096(void *pCtx, long nIter)
+{
+  (void)pCtx;
+
+  __BenchAllocFree(nIter, 4096);
+}
+
+static void __BenchAllocMixed(void *pCtx, long nIter) // random sizes, with 256 blocks in use at any time
+{
+void *apBlocks[256];
+long l1;
+int i1;
+
+
+  (void)pCtx;
+
+  bzero(apBlocks, sizeof(apBlocks));
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    i1 = __BenchRandom() & 255;
+
+    if(apBlocks[i1])
+    {
+      WBFree(apBlocks[i1]);
+    }
+
+    apBlocks[i1] = WBAlloc(8 + (__BenchRandom() % 1000));
+  }
+
+  for(i1=0; i1 < 256; i1++)
+  {
+    if(apBlocks[i1])
+    {
+      WBFree(apBlocks[i1]);
+    }
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// STRINGS, TEXT BUFFERS, AND TEXT OBJECTS
+//////////////////////////////////////////////////////////////////////////////
+
+static void __BenchLineCount(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    ulSink += WBStringLineCount(pC->pText, pC->cbText);
+  }
+}
+
+static void __BenchTextBufferLoad(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+TEXT_BUFFER *pBuf;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    pBuf = WBAllocTextBuffer(pC->pText, pC->cbText);
+
+    if(pBuf)
+    {
+      ulSink += pBuf->nEntries;
+      WBFreeTextBuffer(pBuf);
+    }
+  }
+}
+
+static void __BenchTextBufferRefresh(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    WBTextBufferRefreshCache(pC->pTextBuffer);
+  }
+}
+
+static void __BenchTextObjectLoad(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    pC->xTextObject.vtable->set_text(&(pC->xTextObject), pC->pText, pC->cbText);
+  }
+}
+
+static void __BenchTextObjectReload(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+
+
+  (void)nIter;
+
+  pC->xTextObject.vtable->set_text(&(pC->xTextObject), pC->pText, pC->cbText); // also discards the undo buffer
+  uiSeed = 1; // so that every sample edits the same places
+}
+
+static void __BenchTextObjectMoveTo(TEXT_OBJECT *pTO, int nRows)
+{
+  pTO->vtable->set_row(pTO, __BenchRandom() % nRows);
+  pTO->vtable->set_col(pTO, __BenchRandom() % 40);
+}
+
+static void __BenchTextObjectInsert(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+TEXT_OBJECT *pTO = &(pC->xTextObject);
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    __BenchTextObjectMoveTo(pTO, BENCH_TEXT_LINES);
+    pTO->vtable->ins_chars(pTO, "x", 1);
+  }
+}
+
+static void __BenchTextObjectDelete(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+TEXT_OBJECT *pTO = &(pC->xTextObject);
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    __BenchTextObjectMoveTo(pTO, BENCH_TEXT_LINES);
+    pTO->vtable->del_chars(pTO, 1);
+  }
+}
+
+// NOTE:  there is no 'undo' benchmark because text_object.c does not implement 'undo' yet (it only
+//        prints a TODO).  'del_chars' records the undo information, so that cost is part of 'delete'.
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONFIGURATION FILES, XML, SORTING, POINTER HASHES
+//////////////////////////////////////////////////////////////////////////////
+
+static void __BenchConfLookup(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+char szSection[32], szKey[32], szData[256];
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    snprintf(szSection, sizeof(szSection), "section%ld", l1 & 7);
+    snprintf(szKey, sizeof(szKey), "key%ld", (l1 >> 3) & 31);
+
+    ulSink += CHGetConfFileString(pC->pConf, szSection, szKey, szData, sizeof(szData));
+  }
+}
+
+static void __BenchParseXML(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+CHXMLEntry *pXML;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    pXML = CHParseXML(pC->pXML, pC->cbXML);
+
+    if(pXML)
+    {
+      ulSink += pXML->iNextIndex;
+      free(pXML); // CHParseXML uses malloc, not WBAlloc
+    }
+  }
+}
+
+static DECLARE_SORT_FUNCTION(__BenchSortCompare, pThunk, p1, p2)
+{
+  (void)pThunk;
+
+  return *(const int *)p1 < *(const int *)p2 ? -1 : *(const int *)p1 > *(const int *)p2 ? 1 : 0;
+}
+
+static void __BenchSort(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    memcpy(pC->paSort, pC->paSortSource, pC->nSort * sizeof(*(pC->paSort)));
+
+    QSORT_R(pC->paSort, pC->nSort, sizeof(*(pC->paSort)), pC, __BenchSortCompare);
+  }
+}
+
+static void __BenchPointerHashCreate(void *pCtx, long nIter)
+{
+char *pBase = (char *)pCtx;
+WB_UINT32 uiHash;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    uiHash = WBCreatePointerHash(pBase + (l1 & 4095));
+    WBDestroyPointerHash(uiHash);
+  }
+}
+
+static void __BenchPointerHashLookup(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    ulSink += (unsigned long)WBGetPointerFromHash(pC->auiHash[l1 & 1023]);
+  }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// X11 - ATOMS, EXPOSE, AND SCROLLING
+//////////////////////////////////////////////////////////////////////////////
+
+static void __BenchGetAtom(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+char tbuf[32];
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    snprintf(tbuf, sizeof(tbuf), "WBBENCH_ATOM_%ld", l1 & 63);
+
+    ulSink += WBGetAtom(pC->pDisplay, tbuf);
+  }
+}
+
+static void __BenchLookupServerAtom(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+static const char * const aszNames[] = { "WM_PROTOCOLS", "WM_DELETE_WINDOW", "_NET_WM_NAME", "UTF8_STRING" };
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    ulSink += WBLookupAtom(pC->pDisplay, aszNames[l1 & 3]);
+  }
+}
+
+static void __BenchGetAtomName(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+char *p1;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    p1 = WBGetAtomName(pC->pDisplay, pC->aAtoms[l1 & 63]);
+
+    if(p1)
+    {
+      ulSink += p1[0];
+      WBFree(p1);
+    }
+  }
+}
+
+// dispatch anything that's waiting (including the results of the last operation)
+static void __BenchDrainEvents(BENCH_CONTEXT *pC)
+{
+XEvent evt;
+
+
+  XSync(pC->pDisplay, False); // include the server's time
+
+  while(WBCheckGetEvent(pC->pDisplay, &evt))
+  {
+    WBDispatch(&evt);
+  }
+}
+
+static void __BenchExpose(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+Window wID = pC->pEdit->childframe.wID;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    WBInvalidateRect(wID, NULL, 0);
+    WBUpdateWindowImmediately(wID);
+
+    __BenchDrainEvents(pC);
+  }
+}
+
+static void __BenchScrollSetup(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+TEXT_OBJECT *pTO = &(pC->pEdit->xTextObject);
+
+
+  (void)nIter;
+
+  pTO->vtable->cursor_top(pTO);
+
+  __BenchDrainEvents(pC);
+}
+
+static void __BenchScroll(TEXT_OBJECT *pTO, BENCH_CONTEXT *pC, long nIter, int bPage)
+{
+Window wID = pC->pEdit->childframe.wID;
+long l1;
+
+
+  for(l1=0; l1 < nIter; l1++)
+  {
+    if(bPage)
+    {
+      pTO->vtable->page_down(pTO);
+    }
+    else
+    {
+      pTO->vtable->cursor_down(pTO); // scrolls once the cursor reaches the bottom
+    }
+
+    WBUpdateWindowImmediately(wID);
+
+    __BenchDrainEvents(pC);
+  }
+}
+
+static void __BenchScrollLine(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+
+  __BenchScroll(&(pC->pEdit->xTextObject), pC, nIter, 0);
+}
+
+static void __BenchScrollPage(void *pCtx, long nIter)
+{
+BENCH_CONTEXT *pC = (BENCH_CONTEXT *)pCtx;
+
+  __BenchScroll(&(pC->pEdit->xTextObject), pC, nIter, 1);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// SETUP AND MAIN
+//////////////////////////////////////////////////////////////////////////////
+
+// the configuration file goes in a temporary HOME so that the real one isn't touched
+static int __BenchOpenConf(BENCH_CONTEXT *pC)
+{
+char tbuf[PATH_MAX], szSection[32], szKey[32], szData[64];
+int i1, i2;
+
+
+  strlcpy(pC->szHome, "/tmp/wbbench.XXXXXX", sizeof(pC->szHome));
+
+  if(!mkdtemp(pC->szHome))
+  {
+    pC->szHome[0] = 0;
+    return -1;
+  }
+
+  snprintf(tbuf, sizeof(tbuf), "%s/.local", pC->szHome);
+  mkdir(tbuf, 0755);
+  strlcat(tbuf, "/share", sizeof(tbuf));
+  mkdir(tbuf, 0755);
+
+  setenv("HOME", pC->szHome, 1);
+
+  pC->pConf = CHOpenConfFile("wbbench", CH_FLAGS_DEFAULT);
+
+  if(!pC->pConf)
+  {
+    return -1;
+  }
+
+  for(i1=0; i1 < 8; i1++)
+  {
+    for(i2=0; i2 < 32; i2++)
+    {
+      snprintf(szSection, sizeof(szSection), "section%d", i1);
+      snprintf(szKey, sizeof(szKey), "key%d", i2);
+      snprintf(szData, sizeof(szData), "value %d for section %d", i2, i1);
+
+      CHWriteConfFileString(pC->pConf, szSection, szKey, szData);
+    }
+  }
+
+  return 0;
+}
+
+static void __BenchCloseConf(BENCH_CONTEXT *pC)
+{
+char tbuf[PATH_MAX];
+
+
+  if(pC->pConf)
+  {
+    CHDestroyConfFile(pC->pConf);
+    pC->pConf = NULL;
+  }
+
+  if(pC->szHome[0])
+  {
+    snprintf(tbuf, sizeof(tbuf), "%s/.local/share/wbbench/" LOCAL_CONF_NAME ".conf", pC->szHome);
+    unlink(tbuf);
+
+    snprintf(tbuf, sizeof(tbuf), "%s/.local/share/wbbench", pC->szHome);
+    rmdir(tbuf);
+
+    snprintf(tbuf, sizeof(tbuf), "%s/.local/share", pC->szHome);
+    rmdir(tbuf);
+
+    snprintf(tbuf, sizeof(tbuf), "%s/.local", pC->szHome);
+    rmdir(tbuf);
+
+    rmdir(pC->szHome);
+  }
+}
+
+static int __BenchHeadless(BENCH_CONTEXT *pC)
+{
+static char achPointerBase[4096];
+char tbuf[64];
+int i1;
+
+static const BENCH aAlloc[] =
+{
+  { "WBAlloc/WBFree 16 bytes", NULL, __BenchAllocFree16, 0, 0.0 },
+  { "WBAlloc/WBFree 256 bytes", NULL, __BenchAllocFree256, 0, 0.0 },
+  { "WBAlloc/WBFree 4096 bytes", NULL, __BenchAllocFree4096, 0, 0.0 },
+  { "WBAlloc/WBFree mixed sizes, 256 live", NULL, __BenchAllocMixed, 0, 0.0 },
+};
+
+
+  pC->pText = __BenchMakeText(BENCH_TEXT_LINES, &(pC->cbText));
+  pC->pTextBuffer = pC->pText ? WBAllocTextBuffer(pC->pText, pC->cbText) : NULL;
+  pC->pXML = __BenchMakeXML(1000, &(pC->cbXML));
+  pC->nSort = 10000;
+  pC->paSortSource = (int *)WBAlloc(pC->nSort * sizeof(int));
+  pC->paSort = (int *)WBAlloc(pC->nSort * sizeof(int));
+
+  if(!pC->pTextBuffer || !pC->pXML || !pC->paSortSource || !pC->paSort)
+  {
+    fprintf(stderr, "wbbench:  not enough memory\n");
+    return 1;
+  }
+
+  for(i1=0; i1 < pC->nSort; i1++)
+  {
+    pC->paSortSource[i1] = (int)__BenchRandom();
+  }
+
+  for(i1=0; i1 < 1024; i1++)
+  {
+    pC->auiHash[i1] = WBCreatePointerHash(achPointerBase + i1);
+  }
+
+  WBInitializeInPlaceTextObject(&(pC->xTextObject), None);
+
+  __BenchHeading("memory");
+
+  for(i1=0; i1 < (int)(sizeof(aAlloc) / sizeof(aAlloc[0])); i1++)
+  {
+    __BenchRun(aAlloc + i1, pC);
+  }
+
+  __BenchHeading("strings and text");
+
+  {
+    BENCH aText[] =
+    {
+      { NULL, NULL, __BenchLineCount, 0, (double)pC->cbText },
+      { NULL, NULL, __BenchTextBufferLoad, 0, (double)pC->cbText },
+      { NULL, NULL, __BenchTextBufferRefresh, 0, 0.0 },
+      { NULL, NULL, __BenchTextObjectLoad, 0, (double)pC->cbText },
+      { "text object insert 1 char", __BenchTextObjectReload, __BenchTextObjectInsert, 200000, 0.0 },
+      { "text object delete 1 char", __BenchTextObjectReload, __BenchTextObjectDelete, 200000, 0.0 },
+    };
+    char szName[4][64];
+
+    snprintf(szName[0], sizeof(szName[0]), "WBStringLineCount %u KB", pC->cbText / 1024);
+    snprintf(szName[1], sizeof(szName[1]), "TEXT_BUFFER load %d lines", BENCH_TEXT_LINES);
+    snprintf(szName[2], sizeof(szName[2]), "TEXT_BUFFER refresh cache %d lines", BENCH_TEXT_LINES);
+    snprintf(szName[3], sizeof(szName[3]), "text object set_text %d lines", BENCH_TEXT_LINES);
+
+    for(i1=0; i1 < 4; i1++)
+    {
+      aText[i1].szName = szName[i1];
+    }
+
+    for(i1=0; i1 < (int)(sizeof(aText) / sizeof(aText[0])); i1++)
+    {
+      __BenchRun(aText + i1, pC);
+    }
+  }
+
+  __BenchHeading("configuration, XML, sorting, hashes");
+
+  {
+    BENCH aMisc[] =
+    {
+      { "CHGetConfFileString (256 entries)", NULL, __BenchConfLookup, 0, 0.0 },
+      { NULL, NULL, __BenchParseXML, 0, (double)pC->cbXML },
+      { NULL, NULL, __BenchSort, 0, 0.0 },
+      { "pointer hash create/destroy", NULL, __BenchPointerHashCreate, 0, 0.0 },
+      { "pointer hash lookup (1024 entries)", NULL, __BenchPointerHashLookup, 0, 0.0 },
+    };
+    char szXML[64];
+
+    snprintf(szXML, sizeof(szXML), "CHParseXML %d KB", pC->cbXML / 1024);
+    snprintf(tbuf, sizeof(tbuf), "QSORT_R %d ints (includes copy)", pC->nSort);
+
+    aMisc[1].szName = szXML;
+    aMisc[2].szName = tbuf;
+
+    if(!__BenchOpenConf(pC))
+    {
+      __BenchRun(aMisc, pC);
+    }
+    else
+    {
+      printf("%-44s (skipped - unable to create a configuration file)\n", aMisc[0].szName);
+    }
+
+    __BenchCloseConf(pC);
+
+    __BenchRun(aMisc + 1, pC);
+    __BenchRun(aMisc + 2, pC);
+    __BenchRun(aMisc + 3, achPointerBase);
+    __BenchRun(aMisc + 4, pC);
+  }
+
+  printf("%-44s (needs a display - see '--x11')\n", "atom lookups");
+
+  WBDestroyInPlaceTextObject(&(pC->xTextObject));
+
+  for(i1=0; i1 < 1024; i1++)
+  {
+    WBDestroyPointerHash(pC->auiHash[i1]);
+  }
+
+  return 0;
+}
+
+static int __BenchX11(BENCH_CONTEXT *pC)
+{
+XEvent evt;
+WB_UINT64 nsStart;
+char tbuf[32];
+int i1;
+
+static const BENCH aAtoms[] =
+{
+  { "WBGetAtom (internal, cached)", NULL, __BenchGetAtom, 0, 0.0 },
+  { "WBLookupAtom (server, cached)", NULL, __BenchLookupServerAtom, 0, 0.0 },
+  { "WBGetAtomName", NULL, __BenchGetAtomName, 0, 0.0 },
+};
+
+static const BENCH aPaint[] =
+{
+  { "edit window full expose", NULL, __BenchExpose, 0, 0.0 },
+  { "edit window scroll 1 line", __BenchScrollSetup, __BenchScrollLine, BENCH_TEXT_LINES / 2, 0.0 },
+  { "edit window page down", __BenchScrollSetup, __BenchScrollPage, 200, 0.0 },
+};
+
+
+  pC->pDisplay = WBInit(NULL); // uses '--display' or $DISPLAY
+
+  if(!pC->pDisplay)
+  {
+    fprintf(stderr, "wbbench:  unable to open the display (try 'xvfb-run wbbench --x11')\n");
+    return 1;
+  }
+
+  pC->pText = __BenchMakeText(BENCH_TEXT_LINES, &(pC->cbText));
+
+  if(!pC->pText)
+  {
+    WBExit();
+    return 1;
+  }
+
+  for(i1=0; i1 < 64; i1++)
+  {
+    snprintf(tbuf, sizeof(tbuf), "WBBENCH_ATOM_%d", i1);
+    pC->aAtoms[i1] = WBGetAtom(pC->pDisplay, tbuf);
+  }
+
+  __BenchHeading("atoms");
+
+  for(i1=0; i1 < (int)(sizeof(aAtoms) / sizeof(aAtoms[0])); i1++)
+  {
+    __BenchRun(aAtoms + i1, pC);
+  }
+
+  pC->pFrame = FWCreateFrameWindow("wbbench", ID_APPLICATION, NULL, 0, 0, 800, 600, NULL,
+                                   WBFrameWindow_VISIBLE);
+
+  pC->pEdit = pC->pFrame ? WBCreateEditWindow(pC->pFrame, NULL, NULL, NULL, 0) : NULL;
+
+  if(!pC->pEdit)
+  {
+    fprintf(stderr, "wbbench:  unable to create the edit window\n");
+
+    if(pC->pFrame)
+    {
+      WBDestroyWindow(pC->pFrame->wID);
+    }
+
+    WBExit();
+    return 1;
+  }
+
+  pC->pEdit->xTextObject.vtable->set_text(&(pC->pEdit->xTextObject), pC->pText, pC->cbText);
+
+  // wait (up to 2 seconds) for the windows to be mapped and painted the first time
+
+  for(nsStart = WBGetMonotonicTimeNS(); WBGetMonotonicTimeNS() - nsStart < 2000000000; )
+  {
+    if(!WBCheckGetEvent(pC->pDisplay, &evt))
+    {
+      if(WBIsMapped(pC->pDisplay, pC->pEdit->childframe.wID))
+      {
+        break;
+      }
+
+      WBDelay(1000);
+      continue;
+    }
+
+    WBDispatch(&evt);
+  }
+
+  __BenchDrainEvents(pC);
+
+  __BenchHeading("edit window (800x600)");
+
+  for(i1=0; i1 < (int)(sizeof(aPaint) / sizeof(aPaint[0])); i1++)
+  {
+    __BenchRun(aPaint + i1, pC);
+  }
+
+  WBDestroyWindow(pC->pFrame->wID); // also destroys the edit window
+
+  __BenchDrainEvents(pC);
+
+  WBExit();
+
+  return 0;
+}
+
+static void usage(void)
+{
+  fputs("wbbench - X11 workbench toolkit benchmarks\n"
+        "\n"
+        "usage:  wbbench [toolkit options] [--x11] [--quick] [name]\n"
+        "\n"
+        "  --x11    time atom lookups, and edit window expose and scrolling, which\n"
+        "           requires a display.  For repeatable results, run it under Xvfb:\n"
+        "             xvfb-run -s '-screen 0 1024x768x24' ./wbbench --x11\n"
+        "           NOTE:  this mode has not yet been verified under Xvfb\n"
+        "  --quick  fewer and shorter samples (less stable results)\n"
+        "  name     only run the benchmarks whose names contain 'name'\n"
+        "\n"
+        "Without '--x11', no X server is needed.  Each result is the median of several\n"
+        "samples.  'spread' is the difference between the slowest and fastest samples.\n"
+        "\n", stderr);
+
+  WBToolkitUsage();
+}
+
+int main(int argc, char *argv[], char *envp[])
+{
+BENCH_CONTEXT *pC;
+int iRval, bX11 = 0;
+
+
+  iRval = WBParseStandardArguments(&argc, &argv, &envp);
+
+  if(iRval)
+  {
+    if(iRval < 0)
+    {
+      usage();
+    }
+
+    return 1;
+  }
+
+  while(argc > 1)
+  {
+    if(!strcmp(argv[1], "--x11"))
+    {
+      bX11 = 1;
+    }
+    else if(!strcmp(argv[1], "--quick"))
+    {
+      nSamples = 3;
+      nMinSample = 5;
+    }
+    else if(argv[1][0] == '-')
+    {
+      usage();
+      return 1;
+    }
+    else
+    {
+      szFilter = argv[1];
+    }
+
+    argc--;
+    argv++;
+  }
+
+  pC = (BENCH_CONTEXT *)WBAlloc(sizeof(*pC));
+
+  if(!pC)
+  {
+    return 1;
+  }
+
+  bzero(pC, sizeof(*pC));
+
+  printf("wbbench:  %d sample%s of at least %d msec each, median reported\n",
+         nSamples, nSamples == 1 ? "" : "s", nMinSample);
+  fflush(stdout); // so that it precedes any error output
+
+  if(bX11)
+  {
+    iRval = __BenchX11(pC); // WBInit() and WBExit() do the platform init and exit
+  }
+  else
+  {
+    WBPlatformOnInit();
+
+    iRval = __BenchHeadless(pC);
+  }
+
+  if(pC->pText)
+  {
+    WBFree(pC->pText);
+  }
+
+  if(pC->pTextBuffer)
+  {
+    WBFreeTextBuffer(pC->pTextBuffer);
+  }
+
+  if(pC->pXML)
+  {
+    WBFree(pC->pXML);
+  }
+
+  if(pC->paSortSource)
+  {
+    WBFree(pC->paSortSource);
+  }
+
+  if(pC->paSort)
+  {
+    WBFree(pC->paSort);
+  }
+
+  WBFree(pC);
+
+  if(!bX11)
+  {
+    WBPlatformOnExit(); // after everything has been freed, for the leak report (if enabled)
+  }
+
+  printf("\n");
+
+  return iRval;
+}
@@ -341,6 +341,34 @@
 
 #endif // COMPILER_SUPPORTS_UNUSED_ATTRIBUTE
 
+/** \brief full memory barrier (compiler and CPU).  use when data is shared between threads without a lock
+ **
+ ** \code
+
+    pShared->iValue = iNewValue;
+    WB_MEMORY_BARRIER(); // 'iValue' is visible to other threads before 'iReady' is
+    pShared->iReady = 1;
+
+ ** \endcode
+**/
+#define WB_MEMORY_BARRIER() __sync_synchronize()
+
+/** \brief atomic 'compare and swap' of a pointer (full barrier).  evaluates to non-zero if '*(pp)' was 'old' and is now 'new'
+**/
+#define WB_ATOMIC_CAS_PTR(pp, old, new) __sync_bool_compare_and_swap((pp), (old), (new))
+
+/** \brief atomic exchange of a pointer, returning the previous value (acquire barrier)
+**/
+#define WB_ATOMIC_XCHG_PTR(pp, new) __sync_lock_test_and_set((pp), (new))
+
+/** \brief atomic add to a 64-bit integer (full barrier), evaluating to the new value
+**/
+#define WB_ATOMIC_ADD64(p, n) __sync_add_and_fetch((p), (n))
+
+/** \brief atomic add to a 32-bit integer (full barrier), evaluating to the previous value
+**/
+#define WB_ATOMIC_FETCH_ADD(p, n) __sync_fetch_and_add((p), (n))
+
 
 
 \
@@ -374,6 +402,11 @@
 #define WB_UNLIKELY(x) (x)
 #define WB_LIKELY(x) (x)
 #define WB_UNUSED
+#define WB_MEMORY_BARRIER() MemoryBarrier()
+#define WB_ATOMIC_CAS_PTR(pp, old, new) (InterlockedCompareExchangePointer((PVOID volatile *)(pp), (new), (old)) == (old))
+#define WB_ATOMIC_XCHG_PTR(pp, new) InterlockedExchangePointer((PVOID volatile *)(pp), (new))
+#define WB_ATOMIC_ADD64(p, n) (InterlockedExchangeAdd64((LONGLONG volatile *)(p), (n)) + (n))
+#define WB_ATOMIC_FETCH_ADD(p, n) InterlockedExchangeAdd((LONG volatile *)(p), (n))
 
 #define WB_UNLIKELY(x) (x)
 #define WB_LIKELY(x) (x)
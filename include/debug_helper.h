@@ -223,6 +223,73 @@ void WBDebugPrint(const char *pFmt, ...) __attribute__ ((format(printf, 1, 2)));
 void WBDebugPrint(const char *pFmt, ...);
 #endif // __GNUC__
 
+/** \ingroup debug
+  * \brief Non-zero while the deferred debug log is running.  Use \ref WBDebugLogStart() to change it.
+**/
+extern volatile int bWBDebugLogEnabled;
+
+/** \ingroup debug
+  * \brief Record a debug message in the deferred debug log, without formatting it
+  *
+  * \param puiSig A pointer to a (static) 32-bit value that caches the argument types for 'pFmt'.  It must be zero initially.
+  * \param pFmt A pointer to a 'printf' compatible format string.  This MUST be a string constant.
+  *
+  * Additional parameters are those required by the format string
+  *
+  * The format string pointer and the argument values are copied into a fixed-size binary record
+  * in a ring buffer that belongs to the calling thread, with no locking.  String arguments are copied
+  * (and possibly truncated) since they may not exist by the time the record is formatted.  Formatting
+  * happens later, on the background thread started by \ref WBDebugLogStart().  A format that can't be
+  * deferred safely (more than 7 arguments, '%n', '%m', wide characters, or a '%s' with a precision)
+  * is formatted immediately instead.  If the ring buffer is full, the record is dropped and counted.\n
+  * This is normally called via \ref WB_DEBUG_PRINT() and related macros, which supply 'puiSig'.
+  *
+  * Header File:  debug_helper.h
+**/
+#ifdef __GNUC__
+void WBDebugLogRecord(volatile WB_UINT32 *puiSig, const char *pFmt, ...) __attribute__ ((format(printf, 2, 3)));
+#else // __GNUC__
+void WBDebugLogRecord(volatile WB_UINT32 *puiSig, const char *pFmt, ...);
+#endif // __GNUC__
+
+/** \ingroup debug
+  * \brief Start the deferred debug log
+  *
+  * \param szFileName The name of the output file, or NULL (or "-") for stderr
+  * \return 0 on success, non-zero on error
+  *
+  * While the deferred debug log is running, \ref WB_DEBUG_PRINT() (and related macros) record
+  * binary messages via \ref WBDebugLogRecord() rather than formatting them on the calling thread.
+  * A background thread formats them every few milliseconds, merging the records from all threads
+  * in time stamp order, and prefixes each line with the elapsed time and a thread number.\n
+  * Output from \ref WBDebugPrint() is formatted by the caller and queued for the same background thread,
+  * which writes it in time stamp order with the records.
+  * This is also enabled by the '--debug-log' command line option.
+  *
+  * Header File:  debug_helper.h
+**/
+int WBDebugLogStart(const char *szFileName);
+
+/** \ingroup debug
+  * \brief Stop the deferred debug log, formatting any records that are still waiting
+  *
+  * Debug output is formatted synchronously again, via \ref WBDebugPrint().  This is called
+  * automatically on exit.
+  *
+  * Header File:  debug_helper.h
+**/
+void WBDebugLogStop(void);
+
+/** \ingroup debug
+  * \brief Format all waiting deferred debug log records now, on the calling thread
+  *
+  * Use this before something that might prevent the background thread from doing it, such
+  * as a call to 'abort()'.
+  *
+  * Header File:  debug_helper.h
+**/
+void WBDebugLogFlush(void);
+
 /** \ingroup debug
   * \brief conditionally dumps binary data to debug message output
   *
@@ -347,10 +414,6 @@ int WBCheckDebugLevel(WB_UINT64 dwLevel);
 #define WB_TEMPORARY_PRINT(...)
 #define WB_DEBUG_DUMP(L,X,Y,Z)
 #define WB_IF_DEBUG_LEVEL(L) if(0) /* TODO:  turn off the warning? */
-#define WB_DEFINE_PROFILE(__name)
-#define WB_ENABLE_PROFILE(__name,__desc)
-#define WB_START_PROFILE(__name)
-#define WB_STOP_PROFILE(__name)
 #else // NO_DEBUG
 
 // NOTE:  this macro is the preferred method of implementing debug output.
@@ -369,10 +432,14 @@ int WBCheckDebugLevel(WB_UINT64 dwLevel);
   * Specifying NO subsystem bits assumes ALL subsystems.\n
   * The remaining parameters, format string (and a variable number of parameters), are
   * passed along to the WBDebugPrint function.\n
+  * While the deferred debug log is running (see \ref WBDebugLogStart()) they are passed to
+  * \ref WBDebugLogRecord() instead, so the format string must be a string constant.
   * \sa \ref DebugLevel
 **/
 #define WB_DEBUG_PRINT(L, ...) \
-    WB_IF_DEBUG_LEVEL(L) { WBDebugPrint(__VA_ARGS__); }
+    WB_IF_DEBUG_LEVEL(L) { if(WB_UNLIKELY(bWBDebugLogEnabled)) { static volatile WB_UINT32 __wb_log_sig__ = 0; \
+                                                                WBDebugLogRecord(&__wb_log_sig__, __VA_ARGS__); } \
+                           else { WBDebugPrint(__VA_ARGS__); } }
 
 /** \ingroup debug
   * \brief Preferred method of implementing conditional debug 'dump' output
@@ -431,8 +498,15 @@ int WBCheckDebugLevel(WB_UINT64 dwLevel);
 
 
 
+#endif // NO_DEBUG
+
+
+// NOTE:  the profiling macros are available in ALL builds.  Profiling is off until it is enabled at run time,
+//        either with 'WBProfileEnable()' or the '--profile' command line option, so each START/STOP costs
+//        only a test of 'bWBProfileEnabled' when it is not in use.
+
 /** \ingroup debug
-  * \brief Declaration of a profiling variable and description
+  * \brief Declaration of a profiling variable
   *
   * \param __name The variable's unique name suffix for profiling purposes.  This will be used to construct an actual variable name.
   *
@@ -441,18 +515,19 @@ int WBCheckDebugLevel(WB_UINT64 dwLevel);
 #define WB_DEFINE_PROFILE(__name) static int __wb_profile_##__name = -1
 
 /** \ingroup debug
-  * \brief Declaration of a profiling variable and description
+  * \brief Registration of a profiling variable and description
   *
   * \param __name The variable's unique name suffix for profiling purposes.  This will be used to construct an actual variable name.
   * \param __desc The variable's description as a text string.
   *
-  * This will register a static variable based on '__name' with the profiling system, along with the description.  Debug builds only.
+  * This will register a static variable based on '__name' with the profiling system, along with the description.
+  * Registration is thread-safe, and only happens once for each variable.
   *
   * NOTE:  if this is unique to a particular function, you should include the function name as part of '__desc'
 **/
-#define WB_ENABLE_PROFILE(__name,__desc) { if(__wb_profile_##__name < 0) \
-                                           __wb_profile_##__name = WBRegisterProfileVar(__FILE__, __LINE__, __FUNCTION__, \
-                                                                                        WB_STRINGIZE(__name), __desc); }
+#define WB_ENABLE_PROFILE(__name,__desc) { if(WB_UNLIKELY(__wb_profile_##__name < 0)) \
+                                             WBRegisterProfileVar(&(__wb_profile_##__name), __FILE__, __LINE__, __FUNCTION__, \
+                                                                  WB_STRINGIZE(__name), __desc); }
 
 
 /** \ingroup debug
@@ -460,10 +535,11 @@ int WBCheckDebugLevel(WB_UINT64 dwLevel);
   *
   * \param __name The variable's unique name suffix for profiling purposes (must have been declared with WB_ENABLE_PROFILE(), above)
   *
-  * Use this macro to begin profiling a portion of a function.  you must call 'WB_STOP_PROFILE()' for the counters to be meaningful.
+  * Use this macro to begin a profiled scope.  You must call 'WB_STOP_PROFILE()' with the same variable to end it.
+  * Scopes may be nested (including recursively), and are recorded separately for each thread.
   *
 **/
-#define WB_START_PROFILE(__name) WBStartProfile(__wb_profile_##__name)
+#define WB_START_PROFILE(__name) { if(WB_UNLIKELY(bWBProfileEnabled)) WBStartProfile(__wb_profile_##__name); }
 
 
 /** \ingroup debug
@@ -471,19 +547,71 @@ int WBCheckDebugLevel(WB_UINT64 dwLevel);
   *
   * \param __name The variable's unique name suffix for profiling purposes (must have been declared with WB_ENABLE_PROFILE(), above)
   *
-  * Use this macro to stop profiling a portion of a function.  you must have called 'WB_START_PROFILE()' for the counters to be meaningful.
+  * Use this macro to end a profiled scope that was started with 'WB_START_PROFILE()'.
   *
 **/
-#define WB_STOP_PROFILE(__name) WBStopProfile(__wb_profile_##__name)
+#define WB_STOP_PROFILE(__name) { if(WB_UNLIKELY(bWBProfileEnabled)) WBStopProfile(__wb_profile_##__name); }
 
 
-// internally defined functions to support profiling - debug builds only.  do not call these directly.
-int WBRegisterProfileVar(const char *szFile, WB_INT32 nLine, const char *szFunction, const char *szName, const char *szDesc);
-void WBStartProfile(int nProfileID);
-void WBStopProfile(int nProfileID);
+/** \ingroup debug
+  * \brief Non-zero while profiling is enabled.  Use \ref WBProfileEnable() to change it.
+**/
+extern volatile int bWBProfileEnabled;
+
+/** \ingroup debug
+  * \brief Enable or disable profiling at run time
+  *
+  * \param bEnable Non-zero to enable profiling, zero to disable it
+  *
+  * While profiling is enabled, each WB_START_PROFILE() and WB_STOP_PROFILE() records a time-stamped
+  * event in a ring buffer that belongs to the calling thread.  When a thread's ring buffer is full,
+  * its oldest events are overwritten.  Disabling profiling keeps the recorded events, so that they
+  * can still be exported with \ref WBProfileExportTrace() or summarized with \ref WBDumpProfileData().
+  *
+  * Header File:  debug_helper.h
+**/
+void WBProfileEnable(int bEnable);
+
+/** \ingroup debug
+  * \brief Discard all of the recorded profile events
+  *
+  * Registered profile variables remain valid.  Threads that are still recording may add
+  * a few events while this is running, so disable profiling first for a clean result.
+  *
+  * Header File:  debug_helper.h
+**/
+void WBProfileReset(void);
+
+/** \ingroup debug
+  * \brief Export the recorded profile events as a Chrome 'trace event' JSON file
+  *
+  * \param szFileName The name of the output file
+  * \return 0 on success, non-zero on error
+  *
+  * The output can be loaded into 'chrome://tracing' or Perfetto.  Each profiled scope becomes a
+  * 'complete' ('X') event on the thread that recorded it, with time stamps in microseconds.
+  * Scopes that are still open, or whose beginning was overwritten in the ring buffer, are not written.
+  *
+  * Header File:  debug_helper.h
+**/
+int WBProfileExportTrace(const char *szFileName);
+
+/** \ingroup debug
+  * \brief Write a flat summary of the recorded profile events via WBDebugPrint()
+  *
+  * For each profile variable this shows the number of calls along with the total (inclusive),
+  * self (exclusive of nested profiled scopes), average, and maximum times in microseconds,
+  * sorted by total time.  Nothing is written if no events were recorded.
+  *
+  * Header File:  debug_helper.h
+**/
 void WBDumpProfileData(void);
 
-#endif // NO_DEBUG
+// internally defined functions to support profiling.  do not call these directly.
+int WBRegisterProfileVar(int *pnProfileID, const char *szFile, WB_INT32 nLine, const char *szFunction,
+                         const char *szName, const char *szDesc);
+void WBStartProfile(int nProfileID);
+void WBStopProfile(int nProfileID);
 
 
 /** \ingroup debug
@@ -389,6 +389,8 @@ void DTDrawMultiLineText(WB_FONTC pFont, const char *szText, WB_DISPLAY pDisplay
   * \return A 'WBAlloc'd pointer to a DT_WORDS structure (variable length).  use 'WBFree()' to de-allocate
   * the memory block.
   *
+  * The text is only parsed and measured the first time; subsequent calls with the same font and text
+  * return a copy of the cached result (see DTFlushLayoutCache()).\n
   * The 'DT_WORDS' structure is intended to be used to cache rendering information, particularly for
   * a large block of text that may be calculation-expensive to re-render.  Call 'DTPreRender()' and
   * 'DTRender()' to manage rendering with the DT_WORDS structure.
@@ -398,6 +400,21 @@ void DTDrawMultiLineText(WB_FONTC pFont, const char *szText, WB_DISPLAY pDisplay
 **/
 DT_WORDS * DTGetWordsFromText(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iAlignment);
 
+/** \ingroup draw_text
+  * \brief Flush cached text layout information
+  *
+  * \param pFont The WB_FONTC whose cached layouts are to be discarded, or NULL to discard all of them
+  *
+  * DTGetWordsFromText(), DTCalcIdealBounds(), and DTDrawMultiLineText() keep a small LRU cache of the
+  * parsed and measured text, along with the most recently calculated layouts, so that re-painting or
+  * re-sizing does not need to re-measure every word.  The cache is keyed by font, text, bounds, tab
+  * settings, and alignment.  WBFreeFont() calls this function automatically, so you would normally only
+  * call it if a font's metrics change without the font being freed.
+  *
+  * Header File:  draw_text.h
+**/
+void DTFlushLayoutCache(WB_FONTC pFont);
+
 /** \ingroup draw_text
   * \brief Pre-render a 'DT_WORDS' structure for subsequent display
   *
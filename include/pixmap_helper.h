@@ -324,6 +324,44 @@ void PXM_PixelToRGB(XStandardColormap *pMap, XColor *pColor);
 void PXM_RGBToPixel(XStandardColormap *pMap, XColor *pColor);
 
 
+/** \ingroup pixmap
+  * \brief Cached equivalent of XParseColor()
+  *
+  * \param pDisplay A pointer to the Display (NULL for the default display)
+  * \param colormap The Colormap that the color specification applies to
+  * \param szSpec The color specification, either a color name or an RGB specification
+  * \param pColor A pointer to the XColor structure that receives the RGB values and flags
+  * \returns A non-zero value on success, zero on error (same as XParseColor)
+  *
+  * Use this function in place of XParseColor().  Successful results are cached for each display and
+  * colormap, so only the first request for a given color specification results in a round trip to
+  * the X server.
+  *
+  * Header File:  pixmap_helper.h
+**/
+Status PXM_ParseColor(WB_DISPLAY pDisplay, Colormap colormap, const char *szSpec, XColor *pColor);
+
+
+/** \ingroup pixmap
+  * \brief Cached equivalent of XAllocColor()
+  *
+  * \param pDisplay A pointer to the Display (NULL for the default display)
+  * \param colormap The Colormap in which to allocate the color
+  * \param pColor A pointer to the XColor structure.  The 'red' 'green' and 'blue' members must be valid on entry.
+  * On return the 'pixel' member is assigned, and the RGB members reflect the actual color.
+  * \returns A non-zero value on success, zero on error (same as XAllocColor)
+  *
+  * Use this function in place of XAllocColor().  For the default colormap on a TrueColor visual the
+  * pixel value is calculated from the visual's color masks without contacting the X server.  Otherwise
+  * the results are cached for each display, colormap, and RGB value, so only the first allocation
+  * of a given color results in a round trip.  Because of this, colors allocated with this function
+  * should NOT be freed with XFreeColors().
+  *
+  * Header File:  pixmap_helper.h
+**/
+Status PXM_AllocColor(WB_DISPLAY pDisplay, Colormap colormap, XColor *pColor);
+
+
 /** \ingroup pixmap
   * \brief Icon Registration for application 'large' and 'small' icons
   *
@@ -741,6 +741,19 @@ WB_UINT64 WBGetTimeIndex(void);
 WB_UINT32 WBGetTimeIndex(void);
 #endif // defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
 
+/** \ingroup platform_functions
+  * \brief Returns a monotonic time index, in nanoseconds, for measuring elapsed time
+  *
+  * \return An unsigned 64-bit time index value, in nanoseconds
+  *
+  * Unlike WBGetTimeIndex(), this uses CLOCK_MONOTONIC, so it is not affected by changes to the
+  * system time.  The value has no fixed starting point; use it only for differences.  The profiler,
+  * debug log, dispatch statistics, and X call statistics all use this.
+  *
+  * Header File:  platform_helper.h
+**/
+WB_UINT64 WBGetMonotonicTimeNS(void);
+
 
 /** \ingroup platform_functions
   * \brief Delay for a specified period in microseconds
@@ -759,6 +772,61 @@ WB_UINT32 WBGetTimeIndex(void);
 void WBDelay(uint32_t uiDelay);  // approximate delay for specified period (in microseconds).  may be interruptible
 
 
+#define WB_HISTOGRAM_SUB_BITS 4 /**< log2 of the number of buckets for each power of 2 (a bucket is within 1/16 of its value) **/
+#define WB_HISTOGRAM_BUCKETS  ((32 - WB_HISTOGRAM_SUB_BITS + 1) << WB_HISTOGRAM_SUB_BITS) /**< buckets needed for any 32-bit value **/
+
+/** \ingroup platform_types
+  * \brief A log-linear ('HDR' style) histogram of 32-bit values, typically latencies in microseconds
+  *
+  * Values below 16 have their own bucket.  Above that, each power of 2 is split into 16 buckets, so that
+  * a percentile is always within about 6% of the actual value, for any value from 0 to 2^32 - 1.  The
+  * structure is a fixed size, needs no initialization other than zeroing it, and recording a value
+  * never allocates.  A histogram must only be updated by one thread at a time.
+  *
+  * Header File:  platform_helper.h
+**/
+typedef struct __WB_HISTOGRAM__
+{
+  WB_UINT64 nCount;  ///< number of recorded values
+  WB_UINT64 nSum;    ///< sum of the recorded values (for the mean)
+  WB_UINT32 nMin;    ///< minimum recorded value (valid when nCount is non-zero)
+  WB_UINT32 nMax;    ///< maximum recorded value
+  WB_UINT32 aBuckets[WB_HISTOGRAM_BUCKETS]; ///< counts for each bucket
+} WB_HISTOGRAM;
+
+/** \ingroup platform_functions
+  * \brief Record a value in a WB_HISTOGRAM
+  *
+  * \param pHist A pointer to the histogram
+  * \param nValue The value to record
+  *
+  * Header File:  platform_helper.h
+**/
+void WBHistogramRecord(WB_HISTOGRAM *pHist, WB_UINT32 nValue);
+
+/** \ingroup platform_functions
+  * \brief Obtain a percentile value from a WB_HISTOGRAM
+  *
+  * \param pHist A pointer to the histogram
+  * \param dPercentile The percentile, from 0 to 100 (for example, 99.9)
+  * \return The highest value in the bucket that contains the percentile (never more than the maximum
+  *         recorded value), or zero if the histogram is empty
+  *
+  * Header File:  platform_helper.h
+**/
+WB_UINT32 WBHistogramPercentile(const WB_HISTOGRAM *pHist, double dPercentile);
+
+/** \ingroup platform_functions
+  * \brief Add the contents of one WB_HISTOGRAM to another
+  *
+  * \param pDest A pointer to the histogram that receives the sum
+  * \param pSrc A pointer to the histogram to add to it
+  *
+  * Header File:  platform_helper.h
+**/
+void WBHistogramMerge(WB_HISTOGRAM *pDest, const WB_HISTOGRAM *pSrc);
+
+
 /** \ingroup platform_functions
   * \brief Get the number of available CPU cores
   *
@@ -845,13 +913,250 @@ void * WBReAlloc(void *pBuf, int nNewSize);
   *
   * Sub-allocation sometimes leaves 'holes' in memory.  This function is intended to minimize that, by freeing
   * up blocks of allocated memory that are no longer in use.  It is not the same as 'garbage collection', but
-  * it may have the same basic effect.  Call this function within the main message loop in the main thread.
+  * it may have the same basic effect.  Call this function within the main message loop in the main thread.\n
+  * Blocks of up to 4k (including the header) are sub-allocated from 64k 'slabs', one set per power-of-2 size
+  * class, with a small per-thread cache of free blocks for each class.  This function returns the calling
+  * thread's cached blocks, then gives completely empty slabs back to the OS.
   *
   * Header File:  platform_helper.h
 **/
 void WBSubAllocTrashMasher(void);
 
 
+// allocator statistics and heap profiling
+
+#define WB_ALLOC_STATS_CLASSES 8 /**< number of size classes reported by WBAllocGetStats() - 7 sub-allocated (64 to 4096 bytes) plus 'malloc' **/
+
+/** \ingroup sub_alloc
+  * \brief Allocation statistics for a single size class (or for all of them)
+  *
+  * 'Requested' bytes are what the caller asked for.  'Block' bytes are what's actually in use, including
+  * the header and the power-of-2 rounding, so 'cbLiveBlock - cbLive' is the slack.
+  *
+  * Header File:  platform_helper.h
+**/
+typedef struct __WB_ALLOC_STATS__
+{
+  WB_INT64 nAllocs;      ///< total number of allocations
+  WB_INT64 nFrees;       ///< total number of 'free' operations
+  WB_INT64 nLive;        ///< number of blocks currently allocated
+  WB_INT64 cbLive;       ///< requested bytes for the blocks currently allocated
+  WB_INT64 cbLiveBlock;  ///< block bytes (including header and slack) for the blocks currently allocated
+  WB_INT64 cbPeak;       ///< high-water mark for 'cbLiveBlock' (approximate, see WBAllocGetStats)
+} WB_ALLOC_STATS;
+
+/** \ingroup sub_alloc
+  * \brief Obtain the current allocator statistics
+  *
+  * \param pTotal A pointer to a WB_ALLOC_STATS that receives the totals for all size classes.  May be NULL.
+  * \param paClass An array of WB_ALLOC_STATS_CLASSES WB_ALLOC_STATS structures that receive the statistics for
+  *        each size class, from smallest to largest, with 'malloc' blocks last.  May be NULL.
+  *
+  * The counters are kept per thread and added together by this function, so they cost next to nothing
+  * to maintain.  Because of that, the peak values can lag behind by up to 64k per thread.
+  *
+  * Header File:  platform_helper.h
+**/
+void WBAllocGetStats(WB_ALLOC_STATS *pTotal, WB_ALLOC_STATS *paClass);
+
+/** \ingroup sub_alloc
+  * \brief Dump the allocator statistics via WBDebugPrint()
+  *
+  * \param nTopSites The maximum number of allocation sites to list, by live bytes.  Sites are only
+  *        recorded when WB_ALLOC_TRACKING is defined (see WBAllocTrack).
+  *
+  * The output includes live bytes, peak, slack, and slab usage for each size class.
+  *
+  * Header File:  platform_helper.h
+**/
+void WBAllocDumpStats(int nTopSites);
+
+/** \ingroup sub_alloc
+  * \brief Report memory that hasn't been freed via WBDebugPrint()
+  *
+  * When allocation sites are recorded, every site with live blocks is listed.  Otherwise, only the totals
+  * are reported.  This is called automatically on exit when sites were recorded, or if the debug level
+  * includes DebugSubSystem_Memory.
+  *
+  * Header File:  platform_helper.h
+**/
+void WBAllocLeakReport(void);
+
+/** \ingroup sub_alloc
+  * \brief WBAlloc() that records the allocation site.  Normally used via the WBAlloc() macro with WB_ALLOC_TRACKING
+  *
+  * \param nSize The length of memory being requested
+  * \param szFile The source file name (must be a static string, normally __FILE__)
+  * \param iLine The source line number (normally __LINE__)
+  * \returns A pointer to the allocated buffer, or NULL on error
+  *
+  * When WB_ALLOC_TRACKING is defined (for example, 'CFLAGS=-DWB_ALLOC_TRACKING' when running 'configure')
+  * then WBAlloc(), WBReAlloc() and WBFree() are macros that call the 'Track' versions with __FILE__ and __LINE__,
+  * so that WBAllocDumpStats() and WBAllocLeakReport() can show where the memory came from.  The tracked and
+  * untracked functions can be mixed freely, so only the source files of interest need to be compiled with it.
+  *
+  * Header File:  platform_helper.h
+**/
+void *WBAllocTrack(int nSize, const char *szFile, int iLine);
+
+/** \ingroup sub_alloc
+  * \brief WBReAlloc() that records the allocation site.  Normally used via the WBReAlloc() macro with WB_ALLOC_TRACKING
+  *
+  * \param pBuf A pointer to the previously sub-allocated memory
+  * \param nNewSize The desired 'new' size of the memory block
+  * \param szFile The source file name (must be a static string, normally __FILE__)
+  * \param iLine The source line number (normally __LINE__)
+  * \return A pointer to the new allocated memory block, or NULL on error.
+  *
+  * A block keeps the site of its original allocation.  The site passed to this function is only
+  * used when the original allocation wasn't tracked.
+  *
+  * Header File:  platform_helper.h
+**/
+void *WBReAllocTrack(void *pBuf, int nNewSize, const char *szFile, int iLine);
+
+/** \ingroup sub_alloc
+  * \brief WBFree() that reports the caller's location on error.  Normally used via the WBFree() macro with WB_ALLOC_TRACKING
+  *
+  * \param pBuf A pointer to the previously sub-allocated memory
+  * \param szFile The source file name (normally __FILE__)
+  * \param iLine The source line number (normally __LINE__)
+  *
+  * Header File:  platform_helper.h
+**/
+void WBFreeTrack(void *pBuf, const char *szFile, int iLine);
+
+#if defined(WB_ALLOC_TRACKING) && !defined(__DOXYGEN__)
+#define WBAlloc(nSize) WBAllocTrack((nSize), __FILE__, __LINE__)
+#define WBReAlloc(pBuf, nNewSize) WBReAllocTrack((pBuf), (nNewSize), __FILE__, __LINE__)
+#define WBFree(pBuf) WBFreeTrack((pBuf), __FILE__, __LINE__)
+#endif // WB_ALLOC_TRACKING
+
+
+// scoped 'arena' allocation, for temporary buffers
+
+/** \ingroup sub_alloc
+  * \brief ARENA HANDLE for a 'bump pointer' allocator of temporary memory
+  *
+  * An arena hands out memory from large chunks by advancing a pointer.  Individual blocks are never
+  * freed.  Instead, WBArenaMark() records the current position, and WBArenaReset() frees everything
+  * that was allocated after it in one step.  Use it for short-lived buffers while painting or parsing.
+**/
+typedef struct __WB_ARENA__ * WB_ARENA;
+
+/** \ingroup sub_alloc
+  * \brief A position within a WB_ARENA, from WBArenaMark().  NULL is the (empty) beginning of the arena.
+**/
+typedef void * WB_ARENA_MARK;
+
+/** \ingroup sub_alloc
+  * \brief Create an arena
+  *
+  * \param cbChunk The size of each chunk of memory that the arena allocates, or 0 for the default (16k)
+  * \return A WB_ARENA, or NULL on error.  Destroy it with WBArenaDestroy()
+  *
+  * Header File:  platform_helper.h
+**/
+WB_ARENA WBArenaCreate(int cbChunk);
+
+/** \ingroup sub_alloc
+  * \brief Destroy an arena, freeing all of the memory that was allocated from it
+  *
+  * \param hArena The WB_ARENA from WBArenaCreate()
+  *
+  * Header File:  platform_helper.h
+**/
+void WBArenaDestroy(WB_ARENA hArena);
+
+/** \ingroup sub_alloc
+  * \brief Allocate memory from an arena
+  *
+  * \param hArena The WB_ARENA
+  * \param nSize The length of memory being requested
+  * \return A pointer to the memory, aligned on a 16 byte boundary, or NULL on error.  Do NOT pass it to WBFree()
+  *
+  * The memory remains valid until the arena is reset to a mark that was obtained before it was allocated,
+  * or until the arena is destroyed.
+  *
+  * Header File:  platform_helper.h
+**/
+void *WBArenaAlloc(WB_ARENA hArena, int nSize);
+
+/** \ingroup sub_alloc
+  * \brief Re-size memory that was allocated from an arena
+  *
+  * \param hArena The WB_ARENA
+  * \param pBuf The memory from WBArenaAlloc() or WBArenaReAlloc(), or NULL to allocate new memory
+  * \param nOldSize The current size of 'pBuf'
+  * \param nNewSize The new size
+  * \return A pointer to the re-sized memory, or NULL on error (in which case 'pBuf' is unchanged)
+  *
+  * The most recent allocation grows in place if there's room for it.  Otherwise the contents are copied
+  * to new memory, and the old memory is reclaimed when the arena is reset.
+  *
+  * Header File:  platform_helper.h
+**/
+void *WBArenaReAlloc(WB_ARENA hArena, void *pBuf, int nOldSize, int nNewSize);
+
+/** \ingroup sub_alloc
+  * \brief Copy a string into an arena, up to a maximum length (can also be 0-byte terminated)
+  *
+  * \param hArena The WB_ARENA
+  * \param pStr The string to copy
+  * \param nMaxChars The maximum number of characters to copy, or -1 to copy up to the 0-byte
+  * \return The copy (0-byte terminated), or NULL on error
+  *
+  * Header File:  platform_helper.h
+**/
+char *WBArenaCopyStringN(WB_ARENA hArena, const char *pStr, int nMaxChars);
+
+/** \ingroup sub_alloc
+  * \brief Get the current position of an arena, for use with WBArenaReset()
+  *
+  * \param hArena The WB_ARENA
+  * \return A WB_ARENA_MARK for the current position
+  *
+  * Header File:  platform_helper.h
+**/
+WB_ARENA_MARK WBArenaMark(WB_ARENA hArena);
+
+/** \ingroup sub_alloc
+  * \brief Free everything that was allocated from an arena after a mark
+  *
+  * \param hArena The WB_ARENA
+  * \param pMark A WB_ARENA_MARK from WBArenaMark(), or NULL to free everything
+  *
+  * Marks must be reset in the reverse order that they were obtained.  One emptied chunk is
+  * kept for re-use, so a mark/allocate/reset cycle normally doesn't call WBAlloc() at all.
+  *
+  * Header File:  platform_helper.h
+**/
+void WBArenaReset(WB_ARENA hArena, WB_ARENA_MARK pMark);
+
+/** \ingroup sub_alloc
+  * \brief The calling thread's 'scratch' arena, for temporary buffers within a single function
+  *
+  * \return The WB_ARENA for the calling thread, or NULL on error.  It is destroyed when the thread exits.
+  *
+  * Always take a mark with WBArenaMark() before allocating from it, and reset it to that mark with
+  * WBArenaReset() before returning, so that nested functions can share it:
+  * \code
+
+  WB_ARENA hScratch = WBArenaScratch();
+  WB_ARENA_MARK pMark = WBArenaMark(hScratch);
+  char *pTemp = WBArenaAlloc(hScratch, nLength);
+
+  ... // use 'pTemp'
+
+  WBArenaReset(hScratch, pMark);
+
+  * \endcode
+  *
+  * Header File:  platform_helper.h
+**/
+WB_ARENA WBArenaScratch(void);
+
+
 // BASIC STRING UTILITIES
 
 // simple but helpful string utilities
@@ -1476,6 +1781,9 @@ void WBDestroyPointerHashPtr(void *pPointer);
   * NOTE:  automatically freeing the reference does NOT free the pointer.  Failure to handle these
   *        correctly can result in memory leaks, but that is preferable to security vulnerabilities
   *
+  * This function does not take a lock, and never waits on one, so it can be called from any thread.
+  * The cost of a lookup does not depend on the number of hashes that currently exist.
+  *
   * Header File:  platform_helper.h
 **/
 void * WBGetPointerFromHash(WB_UINT32 uiHash);
@@ -1574,6 +1882,56 @@ Atom WBLookupAtom(WB_DISPLAY pDisplay, const char *szAtomName);
 **/
 char * WBGetAtomName(WB_DISPLAY pDisplay, Atom aAtom);
 
+/** \ingroup platform_functions
+  * \brief Lookup and/or allocate several internal Atoms at once (see WBGetAtom)
+  *
+  * \param pDisplay The display to search for matching X11 Atoms
+  * \param ppszNames An array of 'nCount' Atom names
+  * \param nCount The number of Atom names in 'ppszNames'
+  * \param paRval An array of 'nCount' Atoms that receives the results, in the same order as 'ppszNames'
+  * \returns The number of Atoms that could not be assigned (zero on success), or -1 on error
+  *
+  * This function is equivalent to calling WBGetAtom() for each of the names, except that all of the
+  * names that are not already known are looked up on the X11 server with a single request, rather than
+  * one round trip for each name.  Atoms that could not be assigned will be 'None'.
+  *
+  * Header File:  platform_helper.h
+**/
+int WBGetAtoms(WB_DISPLAY pDisplay, const char * const *ppszNames, int nCount, Atom *paRval);
+
+/** \ingroup platform_functions
+  * \brief Lookup and/or create several X11 Atoms at once, with caching
+  *
+  * \param pDisplay The display on which to look up (or create) the Atoms.  NULL implies the default display
+  * \param ppszNames An array of 'nCount' Atom names
+  * \param nCount The number of Atom names in 'ppszNames'
+  * \param bOnlyIfExists Non-zero to only return existing Atoms (the rest will be 'None'), zero to create them as needed
+  * \param paRval An array of 'nCount' Atoms that receives the results, in the same order as 'ppszNames'
+  * \returns The number of Atoms that are 'None' (zero on success), or -1 on error
+  *
+  * This function works like 'XInternAtoms()', and always returns X11 Atoms (never internal Atoms).
+  * For the default display, Atoms are cached, so that names that have already been looked up do not
+  * require a round trip to the X11 server.  All of the remaining names are requested at the same time.
+  *
+  * Header File:  platform_helper.h
+**/
+int WBInternAtoms(WB_DISPLAY pDisplay, const char * const *ppszNames, int nCount, int bOnlyIfExists, Atom *paRval);
+
+/** \ingroup platform_functions
+  * \brief Lookup and/or create an X11 Atom, with caching
+  *
+  * \param pDisplay The display on which to look up (or create) the Atom.  NULL implies the default display
+  * \param szAtomName The Atom name
+  * \param bOnlyIfExists Non-zero to return 'None' if the Atom does not already exist, zero to create it as needed
+  * \returns The X11 Atom, or 'None'
+  *
+  * This function works like 'XInternAtom()', and always returns an X11 Atom (never an internal Atom).
+  * See WBInternAtoms() for more information.
+  *
+  * Header File:  platform_helper.h
+**/
+Atom WBInternAtom(WB_DISPLAY pDisplay, const char *szAtomName, int bOnlyIfExists);
+
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -2322,6 +2680,166 @@ WB_UINT32 WBInterlockedExchange(volatile WB_UINT32 *pValue, WB_UINT32 nNewVal);
 WB_UINT32 WBInterlockedRead(volatile WB_UINT32 *pValue);
 
 
+// worker thread pool and 'task' API
+
+/** \ingroup threads
+  * \brief TASK HANDLE for a unit of work that runs on the worker thread pool
+  *
+  * A WB_TASK is returned by WBTaskSubmit() and must be released with WBTaskClose()
+**/
+typedef struct __WB_TASK__ * WB_TASK;
+
+/** \ingroup threads
+  * \brief Worker thread pool task state, as returned by WBTaskState()
+**/
+enum WBTaskStateEnum
+{
+  WBTaskState_Queued = 0,   ///< waiting for a worker thread
+  WBTaskState_Running = 1,  ///< running on a worker thread
+  WBTaskState_Complete = 2, ///< the task proc returned normally (its return value is the result)
+  WBTaskState_Canceled = 3  ///< canceled via WBTaskCancel() (it may or may not have run)
+};
+
+/** \ingroup threads
+  * \brief Task proc, run on one of the worker threads
+  *
+  * \param hTask The WB_TASK for this task, for use with WBTaskCanceled()
+  * \param pParam The 'pParam' value that was passed to WBTaskSubmit()
+  * \returns The task's result, which is passed to the completion callback and to WBTaskWait()
+  *
+  * A long-running task should check WBTaskCanceled() periodically and return early when it is non-zero.
+  * A task proc must not make X11 calls on the default display, nor wait for another task to complete.
+**/
+typedef void *(*WB_TASK_PROC)(WB_TASK hTask, void *pParam);
+
+/** \ingroup threads
+  * \brief Task completion callback, run on the UI (event loop) thread
+  *
+  * \param hTask The WB_TASK that completed
+  * \param pParam The 'pParam' value that was passed to WBTaskSubmit()
+  * \param pResult The task proc's return value, or NULL if it never ran
+  * \param iState One of the WBTaskStateEnum values, either WBTaskState_Complete or WBTaskState_Canceled
+**/
+typedef void (*WB_TASK_CALLBACK)(WB_TASK hTask, void *pParam, void *pResult, int iState);
+
+/** \ingroup threads
+  * \brief Start the worker thread pool with a specific number of threads
+  *
+  * \param nThreads The number of worker threads, or a value <= 0 to use the number of CPU cores (see WBCPUCount())
+  * \returns A zero value on success, non-zero on error (including 'already running')
+  *
+  * Calling this function is optional.  The first call to WBTaskSubmit() will start the pool
+  * automatically with one worker thread per CPU core.\n
+  * Each worker thread has its own task queue.  A worker takes the most recently queued task from its
+  * own queue first, and when its queue is empty it 'steals' the oldest task from another worker's
+  * queue, so the work stays balanced without a single shared queue becoming a bottleneck.
+  *
+  * Header File:  platform_helper.h
+**/
+int WBThreadPoolInit(int nThreads);
+
+/** \ingroup threads
+  * \brief Stop the worker thread pool
+  *
+  * Tasks that have not started yet are canceled, running tasks are asked to cancel (see WBTaskCanceled()),
+  * and this function waits for all of the worker threads to exit.  Completion callbacks that have not been
+  * delivered yet will not be called.  This is called automatically by WBExit() and WBPlatformOnExit().
+  *
+  * Header File:  platform_helper.h
+**/
+void WBThreadPoolExit(void);
+
+/** \ingroup threads
+  * \brief Submit a task to the worker thread pool
+  *
+  * \param pProc The task proc to run on a worker thread
+  * \param pParam A parameter to pass to 'pProc' and 'pCallback'
+  * \param pCallback An optional completion callback, called on the UI thread once the task completes or is canceled
+  * \returns A WB_TASK handle on success, or NULL on error (including while WBThreadPoolExit() is running).
+  * The caller must release it with WBTaskClose()
+  *
+  * Use this function to run work (such as loading files, searching, or reading directories) without
+  * blocking the UI thread.  When the task has completed (or been canceled) a WB_TASK ClientMessage is posted
+  * to the application's internal event queue, and 'pCallback' is called when that event is dispatched,
+  * in the order that it was posted relative to other events.  Alternately, WBTaskWait() can be used to
+  * wait for (and obtain) the result, similar to a 'future'.\n
+  * A task proc may submit additional tasks, which are placed into the same worker thread's queue.
+  *
+  * Header File:  platform_helper.h
+**/
+WB_TASK WBTaskSubmit(WB_TASK_PROC pProc, void *pParam, WB_TASK_CALLBACK pCallback);
+
+/** \ingroup threads
+  * \brief Cancel a task
+  *
+  * \param hTask The WB_TASK returned by WBTaskSubmit()
+  * \returns Zero if the task had not started (it will not run), a value > 0 if it was running (it has been asked to stop), or a value < 0 if it had already finished
+  *
+  * A canceled task still gets its completion callback, with 'iState' equal to WBTaskState_Canceled.
+  *
+  * Header File:  platform_helper.h
+**/
+int WBTaskCancel(WB_TASK hTask);
+
+/** \ingroup threads
+  * \brief Check whether a task has been canceled.  Typically called by the task proc.
+  *
+  * \param hTask The WB_TASK that was passed to the task proc
+  * \returns A non-zero value if WBTaskCancel() was called for this task (or the pool is shutting down)
+  *
+  * Header File:  platform_helper.h
+**/
+int WBTaskCanceled(WB_TASK hTask);
+
+/** \ingroup threads
+  * \brief Get the current state of a task
+  *
+  * \param hTask The WB_TASK returned by WBTaskSubmit()
+  * \returns One of the WBTaskStateEnum values, or -1 on error
+  *
+  * Header File:  platform_helper.h
+**/
+int WBTaskState(WB_TASK hTask);
+
+/** \ingroup threads
+  * \brief Wait for a task to finish and obtain its result
+  *
+  * \param hTask The WB_TASK returned by WBTaskSubmit()
+  * \param nTimeout the timeout (in microseconds), or a value < 0 to indicate 'INFINITE'
+  * \param ppResult An optional pointer that receives the task proc's return value
+  * \returns A zero if the task completed, a value > 0 on timeout, or a value < 0 if the task was canceled (or on error)
+  *
+  * Do not call this function from a task proc; the pool does not grow, so waiting on another task can deadlock.
+  *
+  * Header File:  platform_helper.h
+**/
+int WBTaskWait(WB_TASK hTask, int nTimeout, void **ppResult);
+
+/** \ingroup threads
+  * \brief Release a WB_TASK handle
+  *
+  * \param hTask The WB_TASK returned by WBTaskSubmit()
+  *
+  * Releasing the handle does not cancel the task, and the completion callback will still be called.
+  * The handle must not be used afterwards, including within the completion callback.
+  *
+  * Header File:  platform_helper.h
+**/
+void WBTaskClose(WB_TASK hTask);
+
+/** \ingroup threads
+  * \brief Handle a WB_TASK completion event, calling the task's completion callback
+  *
+  * \param pEvent A pointer to the WB_TASK ClientMessage event
+  * \returns A non-zero value if the event was a task completion event (it has been handled), else zero
+  *
+  * This is called by WBAppDispatch() for application events whose message_type is aWB_TASK.
+  *
+  * Header File:  platform_helper.h
+**/
+int WBTaskDispatch(XEvent *pEvent);
+
+
 
 //////////////////////////////////////////////////////
 //   ____  ____  ___ _   _ _____ ___ _   _  ____    //
@@ -198,16 +198,75 @@ extern const char *sz_xcall_func;
   * \brief debug helper variable indicating the line number of the function calling into the X11 library
 **/
 extern int i_xcall_line;
+/** \ingroup debug
+  * \brief Non-zero while X request statistics are being collected.  Use \ref WBXCallStatsEnable() to change it.
+**/
+extern volatile int bWBXCallStats;
+
+/** \ingroup debug
+  * \brief State for one BEGIN_XCALL_DEBUG_WRAPPER / END_XCALL_DEBUG_WRAPPER pair, for the X request statistics
+  *
+  * Declared on the stack by BEGIN_XCALL_DEBUG_WRAPPER.  Do not use this directly.
+**/
+typedef struct __WB_XCALL_SCOPE__
+{
+  WB_UINT64 tStart;        ///< time index (nanoseconds) when the scope began, or 0 if statistics aren't being collected
+  unsigned long ulRequest; ///< NextRequest() for the default display when the scope began
+  const char *szFunc;      ///< the function name for the call site
+  int iLine;               ///< the line number for the call site
+  int iDepth;              ///< nesting level of the scope, on the calling thread
+} WB_XCALL_SCOPE;
+
 /** \ingroup debug
   * \def BEGIN_XCALL_DEBUG_WRAPPER()
   * \brief wrapper macro for calls into the X11 library.  This macro precedes the call(s)
 **/
-#define BEGIN_XCALL_DEBUG_WRAPPER { const char *__szOldXCallFunc__ = sz_xcall_func; int __iOldXCallLine__ = i_xcall_line; sz_xcall_func = __FUNCTION__;  i_xcall_line = __LINE__; {
+#define BEGIN_XCALL_DEBUG_WRAPPER { const char *__szOldXCallFunc__ = sz_xcall_func; int __iOldXCallLine__ = i_xcall_line; WB_XCALL_SCOPE __xcall_scope__; \
+                                    sz_xcall_func = __FUNCTION__;  i_xcall_line = __LINE__; __xcall_scope__.tStart = 0; \
+                                    if(WB_UNLIKELY(bWBXCallStats)) { WBXCallStatsBegin(&__xcall_scope__, __FUNCTION__, __LINE__); } {
 /** \ingroup debug
   * \def END_XCALL_DEBUG_WRAPPER()
   * \brief wrapper macro for calls into the X11 library.  This macro follows the call(s)
 **/
-#define END_XCALL_DEBUG_WRAPPER   } sz_xcall_func = __szOldXCallFunc__;  i_xcall_line = __iOldXCallLine__; }
+#define END_XCALL_DEBUG_WRAPPER   } if(WB_UNLIKELY(__xcall_scope__.tStart != 0)) { WBXCallStatsEnd(&__xcall_scope__); } \
+                                    sz_xcall_func = __szOldXCallFunc__;  i_xcall_line = __iOldXCallLine__; }
+
+/** \ingroup debug
+  * \brief Enable or disable the X request statistics (disabled by default)
+  *
+  * \param bEnable Non-zero to enable the statistics, zero to disable them
+  *
+  * While enabled, each BEGIN_XCALL_DEBUG_WRAPPER / END_XCALL_DEBUG_WRAPPER pair records, for its call site
+  * (function name and line number), the number of calls, the wall time, the number of X requests that were
+  * sent to the default display, and whether a synchronous round trip occurred.  A round trip is detected when
+  * the X server has acknowledged one of the requests that were sent within the wrapper, before it ends, so at
+  * most one round trip is counted per call.  Time and requests in a nested wrapper are counted for the inner
+  * call site only.  Requests are only counted on the event loop's thread.\n
+  * The '--xstats' command line option enables the statistics, and WBExit() reports them if anything was recorded.
+  *
+  * Header File:  window_helper.h
+**/
+void WBXCallStatsEnable(int bEnable);
+
+/** \ingroup debug
+  * \brief Discard the X request statistics
+  *
+  * Header File:  window_helper.h
+**/
+void WBXCallStatsReset(void);
+
+/** \ingroup debug
+  * \brief Write the X request statistics via WBDebugPrint()
+  *
+  * \param nTopSites The maximum number of call sites to list (by total time), or 0 for all of them
+  *
+  * Header File:  window_helper.h
+**/
+void WBXCallStatsDump(int nTopSites);
+
+// internally defined functions to support the X request statistics.  do not call these directly.
+void WBXCallStatsBegin(WB_XCALL_SCOPE *pScope, const char *szFunc, int iLine);
+void WBXCallStatsEnd(WB_XCALL_SCOPE *pScope);
 
 
 /** \typedef WBWinEvent
@@ -763,6 +822,22 @@ WB_DISPLAY WBInit(const char *szDisplayName);
 **/
 int WBInitDisplay(WB_DISPLAY pDisplay);
 
+/** \ingroup startup
+  * \brief Assigns all of the toolkit's well-known Atoms, with as few round trips as possible
+  *
+  * \param pDisplay A pointer to the Display.  NULL implies the default display
+  * \return Zero value on success, non-zero if any of the Atoms could not be assigned
+  *
+  * This function assigns the global Atom variables (aMENU_COMMAND, aWM_PROTOCOLS, aCLIPBOARD, etc.).
+  * All of the 'internal' Atoms are assigned with one request to the X server (see WBGetAtoms()), and all
+  * of the 'global' Atoms, along with a few others that are used when creating windows, with one more
+  * request (see WBInternAtoms()).  This is important for remote displays, where each round trip can be
+  * expensive.  WBInitDisplay() calls this function, so there should be no need to call it directly.
+  *
+  * Header File:  window_helper.h
+**/
+int WBInitAtoms(WB_DISPLAY pDisplay);
+
 /** \ingroup startup
   * \brief initializes clipboard sub-system
   *
@@ -1023,6 +1098,7 @@ extern const Atom aSET_FOCUS;        // 'set focus' messages (send/post to appli
 extern const Atom aWB_CHAR;          // character notifications (generated by API; avoids key up/down handling)
 extern const Atom aWB_TIMER;         // timer notifications (generated by API)
 extern const Atom aWB_POINTER;       // pointer notifications (generated by API)
+extern const Atom aWB_TASK;          // worker thread pool task completion (generated by API)
 
 // things used by window managers
 extern const Atom aWM_PROTOCOLS;     // WM supported protocols (see 'freedesktop.org' WM docs)
@@ -1724,6 +1800,46 @@ void WBSetWindowClassName(Window wID, const char *szClassName);
 **/
 const char *WBGetWindowClassName(Window wID);
 
+/** \ingroup wcore
+  * \brief WBSetWindowEventCompression() flag - collapse consecutive MotionNotify events into the latest one
+**/
+#define WB_COMPRESS_MOTION    1
+
+/** \ingroup wcore
+  * \brief WBSetWindowEventCompression() flag - coalesce auto-repeated cursor movement keys into a single WB_CHAR with a repeat count
+**/
+#define WB_COMPRESS_KEYREPEAT 2
+
+/** \ingroup wcore
+  * \brief Assigns the event compression flags for a window
+  *
+  * \param wID The Window ID
+  * \param iFlags A combination of WB_COMPRESS_MOTION and WB_COMPRESS_KEYREPEAT, or 0 for none (the default)
+  *
+  * Event compression is 'opt-in', and is intended for windows whose handlers repaint in response to
+  * mouse motion or cursor movement, such as text editing and list controls.  Only events that are already
+  * waiting in the X11 queue are compressed, so no additional latency is introduced.\n
+  * With WB_COMPRESS_MOTION, a run of MotionNotify events for the window with the same button and
+  * modifier state is dispatched as a single event, the most recent one.\n
+  * With WB_COMPRESS_KEYREPEAT, a run of (auto-repeated) KeyPress events for the same cursor movement key
+  * (arrows, Home, End, Page Up, Page Down) is dispatched as a single KeyPress.  The resulting WB_CHAR
+  * notification carries the repeat count, which can be obtained with WBGetCharEventRepeat().  A window
+  * that uses this flag must honor the repeat count.
+  *
+  * Header File:  window_helper.h
+**/
+void WBSetWindowEventCompression(Window wID, int iFlags);
+
+/** \ingroup wcore
+  * \brief Returns the event compression flags for a window
+  *
+  * \param wID The Window ID
+  * \return A combination of WB_COMPRESS_MOTION and WB_COMPRESS_KEYREPEAT, or 0 for none
+  *
+  * Header File:  window_helper.h
+**/
+int WBGetWindowEventCompression(Window wID);
+
 /** \ingroup wcore
   * \brief Gets the data associated with this window and the specified index
   *
@@ -1801,6 +1917,38 @@ void WBGetWindowGeom2(Window wID, WB_GEOM *pGeom);
 **/
 void WBGetWindowGeom0(Window wID, WB_GEOM *pGeom);  // absolute window geometry (from latest notification)
 
+/** \ingroup wcore_geom
+  * \brief Returns the cached geometry of the window, without a round trip to the X server
+  *
+  * \param wID The Window ID to obtain the \ref WB_GEOM data for
+  * \param pGeom A pointer to the \ref WB_GEOM structure to receive the data (may be NULL)
+  * \returns zero if cached geometry was available and copied to 'pGeom', non-zero otherwise
+  *
+  * The geometry of each registered window is cached whenever a ConfigureNotify event is
+  * processed for it, and kept current from subsequent ConfigureNotify and ReparentNotify events.
+  * The cached values match what XGetGeometry would return (parent-relative position, size, and
+  * border width).  If this function returns non-zero (the window is unknown, not yet configured,
+  * or its cache has been invalidated) the caller should query the X server instead.
+  * WBGetWindowGeom() does this automatically.
+  *
+  * Header File:  window_helper.h
+**/
+int WBGetCachedWindowGeom(Window wID, WB_GEOM *pGeom);
+
+/** \ingroup wcore_geom
+  * \brief Marks the cached geometry of a window as 'stale' following a local change
+  *
+  * \param wID The Window ID whose cached geometry is no longer valid
+  *
+  * Call this after moving, re-sizing, or re-parenting a window directly with an X11 API
+  * call (XMoveWindow, XResizeWindow, XMoveResizeWindow, XConfigureWindow, etc.).  The next call to
+  * WBGetWindowGeom() will query the X server and re-validate the cache; the cache will also become
+  * valid again when the resulting ConfigureNotify event is processed.
+  *
+  * Header File:  window_helper.h
+**/
+void WBMarkWindowGeomStale(Window wID);
+
 /** \ingroup wcore_geom
   * \brief Returns the \ref WB_RECT (rectangle) defined by the window's geometry, including the border area
   *
@@ -2050,6 +2198,23 @@ int WBKeyEventProcessKey(const XKeyEvent *pEvent, char *pBuf, int *pcbLen, int *
   // data.l[1] is *piAltCtrlShift from WBKeyEventProcessKey
   // data.l[2] is number of characters decoded into data.l[3..4]
   // data.l[3..4] (as char[]) is decode buffer (at least 8 chars long, possibly 16 for 64-bit)
+  // data.l[4] is the repeat count for WB_KEYEVENT_KEYSYM when greater than 1 (see WBGetCharEventRepeat)
+
+/** \ingroup keyboard
+  * \brief Returns the repeat count for a WB_CHAR notification
+  *
+  * \param pEvent A const pointer to the WB_CHAR ClientMessage event
+  * \return The number of times the key was pressed, always at least 1
+  *
+  * When a window enables WB_COMPRESS_KEYREPEAT via WBSetWindowEventCompression(), auto-repeated cursor
+  * movement keys are coalesced into a single WB_CHAR notification.  The handler should perform the
+  * action once for each repeat, but only needs to update the display once.
+  *
+  * \sa \ref aWB_CHAR
+  *
+  * Header File:  window_helper.h
+**/
+int WBGetCharEventRepeat(const XClientMessageEvent *pEvent);
 
 
 
@@ -2277,6 +2442,9 @@ int WBCheckGetEvent(WB_DISPLAY pDisplay, XEvent *pEvent);
   *
   * Call this function to wait until a new event is available in the event queue.  This
   * function will block indefinitely until such an event is available.\n
+  * The function blocks in poll() on the display connection and an internal wakeup descriptor,
+  * with a timeout calculated from the next pending timer or delayed event, so it does not
+  * wake up at all while idle.  It also returns after another thread calls WBWakeEventLoop().\n
   * NOTE: if 'bQuitFlag' is set, this function will return immediately.
   *
   * See WBNextEvent(), WBCheckGetEvent()
@@ -2285,6 +2453,17 @@ int WBCheckGetEvent(WB_DISPLAY pDisplay, XEvent *pEvent);
 **/
 void WBWaitForEvent(WB_DISPLAY pDisplay);
 
+/** \ingroup events
+  * \brief Wake up a thread that is blocked in WBWaitForEvent()
+  *
+  * Call this function from another thread (or a signal handler) after doing something that the
+  * event loop needs to see, such as setting 'bQuitFlag' or queueing an event.  It is safe to call
+  * at any time; if nothing is waiting, the next call to WBWaitForEvent() returns immediately.
+  *
+  * Header File:  window_helper.h
+**/
+void WBWakeEventLoop(void);
+
 
 /** \ingroup events
   * \brief Generic Event Dispatcher, using message type to dispatch
@@ -2330,6 +2509,117 @@ int WBAppDispatch(XEvent *pEvent);
 **/
 int WBWindowDispatch(Window wID, XEvent *pEvent);
 
+
+/** \ingroup events
+  * \brief Event queue gauges, from WBDispatchStatsGauges()
+  *
+  * Header File:  window_helper.h
+**/
+typedef struct __WB_DISPATCH_GAUGES__
+{
+  int nQueued;          ///< events currently in the internal event queues (all displays, including paint events)
+  int nQueuedMax;       ///< high-water mark for 'nQueued'
+  int nXQueued;         ///< events in Xlib's queue the last time it was checked
+  int nXQueuedMax;      ///< high-water mark for 'nXQueued'
+  WB_UINT32 nOldestAge; ///< age (in microseconds) of the oldest event in the internal queues, or 0 if they are empty
+} WB_DISPATCH_GAUGES;
+
+/** \ingroup events
+  * \brief Enable or disable the dispatch latency statistics (enabled by default)
+  *
+  * \param bEnable Non-zero to enable the statistics, zero to disable them
+  *
+  * While enabled, WBDispatch() records how long each event takes to dispatch, in microseconds, in a
+  * histogram for the event type and another for the window's class name (see WBSetWindowClassName()).
+  * Keyboard and mouse events also record their 'input latency', the time from the X server's time stamp
+  * until the dispatch completes, relative to the fastest delivery seen so far.  The time that events spend
+  * in the internal event queues is recorded as well.  A dispatch that runs a nested event loop (such as a
+  * modal dialog box) is not recorded, though the events that the nested loop dispatches are.\n
+  * The statistics are only updated and read on the event loop's thread.
+  *
+  * Header File:  window_helper.h
+**/
+void WBDispatchStatsEnable(int bEnable);
+
+/** \ingroup events
+  * \brief Obtain the dispatch time histogram for an event type
+  *
+  * \param iEventType The event type (KeyPress, Expose, ClientMessage, and so on)
+  * \return A const pointer to the histogram, or NULL if nothing has been recorded for the event type
+  *
+  * Header File:  window_helper.h
+**/
+const WB_HISTOGRAM *WBDispatchStatsByType(int iEventType);
+
+/** \ingroup events
+  * \brief Obtain the dispatch time histogram for a window class
+  *
+  * \param szClassName The window class name, as assigned by WBSetWindowClassName().  Use "(none)" for windows
+  *        that have no class name, and "(application)" for application events.
+  * \return A const pointer to the histogram, or NULL if nothing has been recorded for the class
+  *
+  * Up to 32 distinct classes are tracked.  After that, other classes are combined as "(other)".
+  *
+  * Header File:  window_helper.h
+**/
+const WB_HISTOGRAM *WBDispatchStatsByClass(const char *szClassName);
+
+/** \ingroup events
+  * \brief Obtain the input latency histogram (keyboard and mouse events)
+  *
+  * \return A const pointer to the histogram
+  *
+  * Header File:  window_helper.h
+**/
+const WB_HISTOGRAM *WBDispatchStatsInputLatency(void);
+
+/** \ingroup events
+  * \brief Obtain the histogram of the time that events spend in the internal event queues
+  *
+  * \return A const pointer to the histogram
+  *
+  * Header File:  window_helper.h
+**/
+const WB_HISTOGRAM *WBDispatchStatsQueueAge(void);
+
+/** \ingroup events
+  * \brief Obtain the current event queue gauges
+  *
+  * \param pGauges A pointer to the WB_DISPATCH_GAUGES structure that receives the values
+  *
+  * Header File:  window_helper.h
+**/
+void WBDispatchStatsGauges(WB_DISPATCH_GAUGES *pGauges);
+
+/** \ingroup events
+  * \brief Discard all of the dispatch statistics, and reset the high-water marks
+  *
+  * Header File:  window_helper.h
+**/
+void WBDispatchStatsReset(void);
+
+/** \ingroup events
+  * \brief Write the dispatch statistics via WBDebugPrint()
+  *
+  * The output shows the count, mean, p50, p90, p99, p99.9 and maximum for each event type and window class
+  * that has been recorded, followed by the input latency, queue age, and the queue gauges.
+  *
+  * Header File:  window_helper.h
+**/
+void WBDispatchStatsDump(void);
+
+/** \ingroup events
+  * \brief Dump the dispatch statistics periodically
+  *
+  * \param nSeconds The interval between dumps, in seconds, or zero to disable the periodic dump (the default)
+  *
+  * WBDispatch() calls WBDispatchStatsDump() after an event, once the interval has passed since the
+  * previous dump.  The '--dispatch-stats' command line option calls this function.
+  *
+  * Header File:  window_helper.h
+**/
+void WBDispatchStatsSetDumpInterval(int nSeconds);
+
 /** \ingroup events
   * \brief debug function to return the name of an X11 event
   *
@@ -2411,7 +2701,11 @@ int WBNextEvent(WB_DISPLAY pDisplay, XEvent *pEvent);
   * You should always use this function for asynchronously posting non-priority events, such as
   * notifications and timers, or when recursion may occur.  Note that any pointers or X11 resources
   * that are passed using XEvent may not be valid by the time they are received. If you must pass
-  * volatile data to a window, use WBDispatch() or WBWindowDispatch() instead.
+  * volatile data to a window, use WBDispatch() or WBWindowDispatch() instead.\n
+  * This function may be called from any thread.  When called from a thread other than the one that
+  * runs the event loop, the event is handed off through a lock-free queue and the event loop is woken up
+  * (see WBWakeEventLoop()).  In that case the window ID is validated when the event loop receives it, so
+  * a zero return only indicates that the event was queued.
   *
   * Header File:  window_helper.h
 **/
@@ -2426,7 +2720,8 @@ int WBPostEvent(Window wID, XEvent *pEvent);
   *
   * The preferred method of event processing between windows is to post them to one of the internal
   * event queues, rather than using XSendEvent() or calling WBDispatch() or WBWindowDispatch() directly.\n
-  * Use WBPostPriorityEvent for priority events, such as UI handling (where performance is critical)
+  * Use WBPostPriorityEvent for priority events, such as UI handling (where performance is critical)\n
+  * This function may be called from any thread (see WBPostEvent()).
   *
   * Header File:  window_helper.h
 **/
@@ -2442,7 +2737,8 @@ int WBPostPriorityEvent(Window wID, XEvent *pEvent); // like above but it goes a
   * period of time, in milliseconds.  For application messages, specify 'None' for the Window ID
   * in the XEvent structure (otherwise specify the correct Window ID).
   * After the time delay, the event will be retrieved and returned via WBCheckGetEvent(), or WBNextEvent(), similar to a timer message.
-  * If the window specified in the message is destroyed before the timeout, the message will be ignored.
+  * If the window specified in the message is destroyed before the timeout, the message will be ignored.\n
+  * This function may be called from any thread (see WBPostEvent()).
   *
   * Header File:  window_helper.h
 **/
@@ -2456,7 +2752,8 @@ void WBPostDelayedEvent(XEvent *pEvent, unsigned int nDelay);
   *
   * The preferred method of event processing between windows is to post them to one of the internal
   * event queues, rather than using XSendEvent or calling WBDispatch directly.\n
-  * Use WBPostAppEvent for application events (where the window ID is 'None')
+  * Use WBPostAppEvent for application events (where the window ID is 'None')\n
+  * This function may be called from any thread (see WBPostEvent()).
   *
   * Header File:  window_helper.h
 **/
@@ -2863,7 +3160,10 @@ void WBUpdateWindowImmediately(Window wID);  // sends expose event synchronously
   * the invalid region as a 'clipping' region for the returned WBGC.  When you call WBEndPaint(), the
   * entire clipping region will be marked 'valid' automatically, so it is important for your 'paint'
   * function to update the entire WB_GEOM rectangle identified by pgRet.  This includes erasing the
-  * background as well as drawing whatever is in the foreground.
+  * background as well as drawing whatever is in the foreground.\n
+  * When several Expose events for the window were consolidated into one, the clipping region is limited
+  * to the areas that were actually exposed, rather than their bounding rectangle.  Any invalid area
+  * outside of them remains invalid.
   *
   * Header File:  window_helper.h
 **/
@@ -3207,6 +3507,8 @@ GContext WBGContextFromGC(WBGC hGC);
   * \param rgnClip The clipping region to assign to the WBGC
   * \returns an integer indicating success or fail
   *
+  * Like XSetRegion(), this also sets the clip origin to 0,0
+  *
   * Header File:  window_helper.h
 **/
 int WBSetRegion(WBGC hGC, Region rgnClip);
@@ -3389,6 +3691,52 @@ int WBSetLineAttributes(WBGC hGC, unsigned int line_width,
 **/
 int WBSetDashes(WBGC hGC, int dash_offset, const char dash_list[], int n);
 
+/** \struct s_WB_GC_STATS
+  * \ingroup graphics
+  * \copydoc WB_GC_STATS
+**/
+/** \typedef WB_GC_STATS
+  * \ingroup graphics
+  * \brief Counters for GC attribute changes, see WBGetGCStats()
+  *
+  * \code
+
+  typedef struct s_WB_GC_STATS
+  {
+    WB_UINT64 nRequests;   // GC attribute changes that were sent to the X server
+    WB_UINT64 nSuppressed; // GC attribute changes that were NOT sent because the cached values already matched
+  } WB_GC_STATS;
+
+  * \endcode
+**/
+typedef struct s_WB_GC_STATS
+{
+  WB_UINT64 nRequests;   ///< GC attribute changes that were sent to the X server
+  WB_UINT64 nSuppressed; ///< GC attribute changes that were NOT sent because the cached values already matched
+} WB_GC_STATS;
+
+/** \ingroup graphics
+  * \brief Obtain counters for sent and suppressed GC attribute changes
+  *
+  * \param pStats A pointer to a WB_GC_STATS structure that receives the current counter values
+  *
+  * The 'values' member of each WBGC shadows the X server's GC state.  WBSetForeground(), WBSetBackground(),
+  * WBSetFunction(), WBSetLineAttributes(), WBSetClipOrigin(), WBSetFont() and WBChangeGC() compare
+  * the requested attributes with the cached ones, and do not send a request when nothing would change.
+  * Use these counters to measure the savings.  WBChangeGC() counts once per call, even if only some
+  * of the attributes were removed from the request.
+  *
+  * Header File:  window_helper.h
+**/
+void WBGetGCStats(WB_GC_STATS *pStats);
+
+/** \ingroup graphics
+  * \brief Reset the counters returned by WBGetGCStats() to zero
+  *
+  * Header File:  window_helper.h
+**/
+void WBResetGCStats(void);
+
 
 
 /////////////////////////////////////////////////////////////////////
@@ -902,6 +902,8 @@ int nL, nL2, nC, nC2;
     // resize the window accordingly
     XMoveWindow(pDisplay, pChildFrame->wID, iL, iT);
     XResizeWindow(pDisplay, pChildFrame->wID, iW - 2, iH - 2); // allow 1 pixel for border
+
+    WBMarkWindowGeomStale(pChildFrame->wID); // until the ConfigureNotify arrives
   }
 
   // calculate new client 'geom', backing out 2 additional pixels in all 4 directions
@@ -1841,6 +1843,26 @@ int iRval = 0;
     return 0; // sanity check (temporary?)
   }
 
+  nChar = WBGetCharEventRepeat(pEvent);
+
+  if(nChar > 1) // coalesced auto-repeat (see WBSetWindowEventCompression), so do it once for each
+  {
+    XClientMessageEvent evt;
+
+    memcpy(&evt, pEvent, sizeof(evt));
+    evt.data.l[4] = 0;
+
+    while(nChar-- > 0)
+    {
+      if(ChildFrameDoCharEvent(&evt, pDisplay, wID, pC, pUI))
+      {
+        iRval = 1;
+      }
+    }
+
+    return iRval;
+  }
+
 //#ifndef NO_DEBUG
 //  WB_DEBUG_PRINT(DebugLevel_Heavy | DebugSubSystem_Keyboard,
 //                   "%s - WB_CHAR\n", __FUNCTION__);
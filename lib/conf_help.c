@@ -676,6 +676,8 @@ void * CHOpenConfFile(const char *szAppName, int iFlags)
 
   bzero(pRval, sizeof(*pRval));  // make sure it's zero'd out
 
+  pRval->iGlobal = pRval->iLocal = -1; // not open (zero is a valid file handle, 'stdin')
+
   // construct file names
 
   p1 = (char *)pRval + sizeof(*pRval);  // this is the start of string buffers
@@ -909,6 +911,8 @@ void CHDestroyConfFile(void * pFile)
   {
     FBDestroyFileBuf(pTemp->pfhbG);
   }
+
+  WBFree(pTemp); // allocated by CHOpenConfFile (the file name strings are part of the same block)
 }
 
 
@@ -2460,6 +2464,8 @@ static int CHGetSpecialXMLTagType(const char *pTag, const char *pEnd)
   return Special_NONE;
 }
 
+static char *InternalParseXMLTagContents(WB_ARENA hArena, const char *pTag, int cbLength, int *pcbRval);
+
 // add an XML entry at *ppCur, incrementing *ppCur and returning a pointer to it
 // re-allocates buffers as needed to fit the entry.  returns NULL if there was an error
 static CHXMLEntry *InternalAddXMLEntry(const char *szTagName, // NULL or "" for embedded data; else tag name
@@ -2602,6 +2608,9 @@ static const char *InternalParseXML(CHXMLEntry **ppOrigin, int *pcbOrigin, CHXML
 const char *pC, *pE, *p1; //, *pCE, *p2;
 char *p3, *p4, *p5;
 CHXMLEntry *pEntry;
+WB_ARENA hScratch = WBArenaScratch(); // temporary copies are made here, and reset for each tag
+WB_ARENA_MARK pMark;
+int cbTemp;
 
 
   // parse a section of XML, adding contents to the end of 'ppOrigin', and returning
@@ -2668,9 +2677,12 @@ CHXMLEntry *pEntry;
 
         // add this as a value to the container
 
-        p5 = WBCopyStringN(pV, pVE - pV);
+        pMark = WBArenaMark(hScratch);
+
+        p5 = WBArenaCopyStringN(hScratch, pV, pVE - pV);
         pTemp = InternalAddXMLEntry(NULL, p5, pContainer, ppOrigin, pcbOrigin, ppCur, ppData, pcbData, ppCurData);
-        WBFree(p5);
+
+        WBArenaReset(hScratch, pMark);
 
         if(!pTemp)
         {
@@ -2706,9 +2718,12 @@ CHXMLEntry *pEntry;
     if(p1 < (pE - 3) && p1[1] == '!' && p1[2] == '-' && p1[3] == '-') // comment
       continue; // skip the comment
 
-    p3 = CHParseXMLTagContents(p1, pE2 - p1);   // parse contents as name\tvalue\0
+    pMark = WBArenaMark(hScratch);
+
+    p3 = InternalParseXMLTagContents(hScratch, p1, pE2 - p1, &cbTemp);   // parse contents as name\tvalue\0
     if(!p3)
     {
+      WBArenaReset(hScratch, pMark);
       WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - returning NULL\n", __FUNCTION__, __LINE__);
       return NULL;
     }
@@ -2716,7 +2731,7 @@ CHXMLEntry *pEntry;
     // for each string pair in 'p3' store the value in the output array
     // the first is always the tag name, followed by a tab and no data.
     // the last string has a 0 byte as the first char,marking the end
-    // the buffer needs to be WBFree'd
+    // the buffer is in the scratch arena, reset to 'pMark' when I'm done with it
 
     p4 = p3;  // p3 points to the tag name and also is WBAlloc'd pointer
     while(*p4 && *p4 != '\t')
@@ -2733,7 +2748,7 @@ CHXMLEntry *pEntry;
 
     if(!pEntry)
     {
-      WBFree(p3);
+      WBArenaReset(hScratch, pMark);
       WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - returning NULL\n", __FUNCTION__, __LINE__);
       return NULL;
     }
@@ -2750,7 +2765,7 @@ CHXMLEntry *pEntry;
 
       if(!InternalAddXMLEntry(p5, p4, pEntry, ppOrigin, pcbOrigin, ppCur, ppData, pcbData, ppCurData))
       {
-        WBFree(p3);
+        WBArenaReset(hScratch, pMark);
         WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - returning NULL\n", __FUNCTION__, __LINE__);
         return NULL;
       }
@@ -2761,7 +2776,7 @@ CHXMLEntry *pEntry;
       p4++;  // point to next name, or zero byte if done
     }
 
-    WBFree(p3);
+    WBArenaReset(hScratch, pMark);
 
     // recurse - this handles raw values also
 
@@ -2945,8 +2960,8 @@ the_end:
 // end of data in returned value is '\0\0'
 // tags like CDATA are returned as-is except '<![CDATA[' and ']]>' are stripped away
 // the tag name, if any, is always the first entry in the returned string
-// the return value is WBAlloc'd and needs to be WBFree'd
-char *CHParseXMLTagContents(const char *pTag, int cbLength)
+// the return value is allocated from 'hArena', and '*pcbRval' receives its length (including the ending '\0\0')
+static char *InternalParseXMLTagContents(WB_ARENA hArena, const char *pTag, int cbLength, int *pcbRval)
 {
 const char *pCur, *pEnd;
 const char *p1, *p2, *p3;
@@ -2971,9 +2986,12 @@ int i1, cTag, nSpecial, cbRval = 4096;
 
   if(nSpecial == Special_Comment)
   {
-    pRval = malloc(4);
+    pRval = WBArenaAlloc(hArena, 4);
     if(pRval)
+    {
       memset(pRval, 0, 4);
+      *pcbRval = 4;
+    }
 
     return pRval;
   }
@@ -2981,7 +2999,7 @@ int i1, cTag, nSpecial, cbRval = 4096;
   {
     i1 = (pEnd - pCur - 12);
 
-    pRval = (char *)malloc(4 + i1);
+    pRval = (char *)WBArenaAlloc(hArena, 4 + i1);
     if(pRval)
     {
       pRval[0] = '\t';
@@ -2989,6 +3007,7 @@ int i1, cTag, nSpecial, cbRval = 4096;
       pRval[i1 + 1] = 0;
       pRval[i1 + 2] = 0;
       pRval[i1 + 3] = 0;
+      *pcbRval = 4 + i1;
     }
 
     return pRval;
@@ -3011,7 +3030,7 @@ int i1, cTag, nSpecial, cbRval = 4096;
 //   pEnd is now just before the tag end
   pCur++; // point to 1st char beyond the '<'
 
-  pC = pRval = WBAlloc(cbRval);
+  pC = pRval = WBArenaAlloc(hArena, cbRval);
   if(!pRval)
   {
     WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - returning NULL\n", __FUNCTION__, __LINE__);
@@ -3088,7 +3107,7 @@ int i1, cTag, nSpecial, cbRval = 4096;
           pCur++; // now past the quote
         }
 
-        p5 = WBCopyStringN(p3, pCur - p3); // copy all including start/end quotes
+        p5 = WBArenaCopyStringN(hArena, p3, pCur - p3); // copy all including start/end quotes
 
         // make de-quoted normalized version
         if(p5)
@@ -3108,7 +3127,7 @@ int i1, cTag, nSpecial, cbRval = 4096;
           goto no_value;
         }
 
-        p5 = WBCopyStringN(p3, pCur - p3);
+        p5 = WBArenaCopyStringN(hArena, p3, pCur - p3);
 
         // make normalized version
         if(p5)
@@ -3121,7 +3140,6 @@ int i1, cTag, nSpecial, cbRval = 4096;
 
       if(!p5)
       {
-        WBFree(pRval);
         WB_ERROR_PRINT("%s - not enough memory\n", __FUNCTION__);
         return NULL;
       }
@@ -3136,13 +3154,11 @@ int i1, cTag, nSpecial, cbRval = 4096;
           i1 += 4096; // to make sure it's big enough in 4k increments
         }
 
+        p4 = WBArenaReAlloc(hArena, pRval, cbRval, cbRval + i1);
         cbRval += i1;
-        p4 = WBReAlloc(pRval, cbRval);
 
         if(!p4)
         {
-          WBFree(p5);
-          WBFree(pRval);
           WB_ERROR_PRINT("%s - not enough memory\n", __FUNCTION__);
           return NULL;
         }
@@ -3164,7 +3180,7 @@ int i1, cTag, nSpecial, cbRval = 4096;
       pC += strlen(pC) + 1;
       *pC = 0;
 
-      WBFree(p5); // done with it
+      // NOTE:  'p5' is reclaimed when the caller resets the arena
     }
     else // no value
     {
@@ -3177,12 +3193,11 @@ no_value:
           i1 += 4096; // to make sure it's big enough in 4k increments
         }
 
+        p4 = WBArenaReAlloc(hArena, pRval, cbRval, cbRval + i1);
         cbRval += i1;
-        p4 = WBReAlloc(pRval, cbRval);
 
         if(!p4)
         {
-          WBFree(pRval);
           WB_ERROR_PRINT("%s - not enough memory\n", __FUNCTION__);
           return NULL;
         }
@@ -3205,10 +3220,40 @@ no_value:
     }
   }
 
+  *pcbRval = (pC - pRval) + 2; // there's always room for the extra '\0'
+
+  return pRval;
+}
+
+// the return value is WBAlloc'd and needs to be WBFree'd
+char *CHParseXMLTagContents(const char *pTag, int cbLength)
+{
+WB_ARENA hScratch = WBArenaScratch();
+WB_ARENA_MARK pMark = WBArenaMark(hScratch);
+char *p1, *pRval = NULL;
+int cbRval = 0;
+
+
+  // the work is done in the scratch arena, and the result copied to a WBAlloc'd buffer
+
+  p1 = InternalParseXMLTagContents(hScratch, pTag, cbLength, &cbRval);
+
+  if(p1)
+  {
+    pRval = WBAlloc(cbRval);
+
+    if(pRval)
+    {
+      memcpy(pRval, p1, cbRval);
+    }
+  }
+
+  WBArenaReset(hScratch, pMark);
 
   return pRval;
 }
 
+
 const char *CHFindNextXMLTag(const char *pTagContents, int cbLength, int nNestingFlags)
 {
 const char *p1, *pEnd = pTagContents + cbLength;
@@ -3418,7 +3463,7 @@ const char *CHFindEndOfXMLTag(const char *pTagContents, int cbLength)
 const char *CHFindEndingXMLTag(const char **ppTag, int cbLength, const char **ppOpenTagEnd)
 {
 const char *p1, *p2, *p3, *p4, *pE;
-char *pTagName;
+const char *pTagName;
 int nSpecial = 0, iNest, cbTagName;
 
 
@@ -3525,17 +3570,11 @@ int nSpecial = 0, iNest, cbTagName;
     p3++;
   }
 
-  // save as tag name
+  // the tag name, in place (no copy is needed to compare it)
   cbTagName = p3 - p1;
-  pTagName = WBCopyStringN(p1, cbTagName);
-
-  if(!pTagName)
-  {
-    WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - returning NULL\n", __FUNCTION__, __LINE__);
-    return NULL;
-  }
+  pTagName = p1;
 
-  WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - tag %s found\n", __FUNCTION__, __LINE__, pTagName);
+  WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - tag %.*s found\n", __FUNCTION__, __LINE__, cbTagName, pTagName);
 
   // search for a matching closing tag
 
@@ -3591,8 +3630,7 @@ int nSpecial = 0, iNest, cbTagName;
 
         if(iNest <= 0) // end of tag block
         {
-          WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - end of tag %s found\n", __FUNCTION__, __LINE__, pTagName);
-          free(pTagName);
+          WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - end of tag %.*s found\n", __FUNCTION__, __LINE__, cbTagName, pTagName);
           return p2;  // 1 past the end of the tag
         }
       }
@@ -3606,7 +3644,6 @@ int nSpecial = 0, iNest, cbTagName;
   }
 
   // assume the ending tag is after the end of text and return as-is
-  free(pTagName);
   *ppTag = pE;
   WB_DEBUG_PRINT(DebugLevel_Medium, "%s.%d - no tag end found, returning %s\n", __FUNCTION__, __LINE__, pE);
   return pE;
@@ -493,19 +493,19 @@ int iY, iU, iV, iR, iG, iB;
   COPY_COLOR_NAME(CHGetBorderColor,szBD,"#000000");
 
 
-  XParseColor(WBGetDefaultDisplay(), colormap, szFG, &(pDialogControl->clrFG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrFG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szBG, &(pDialogControl->clrBG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szAFG, &(pDialogControl->clrAFG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrAFG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szABG, &(pDialogControl->clrABG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrABG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szHFG, &(pDialogControl->clrHFG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHFG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szHBG, &(pDialogControl->clrHBG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHBG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szBD, &(pDialogControl->clrBD));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szFG, &(pDialogControl->clrFG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrFG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBG, &(pDialogControl->clrBG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szAFG, &(pDialogControl->clrAFG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrAFG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szABG, &(pDialogControl->clrABG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrABG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHFG, &(pDialogControl->clrHFG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHFG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHBG, &(pDialogControl->clrHBG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHBG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBD, &(pDialogControl->clrBD));
 
   // ---------------------------------------------------------------------------------------
   // 3D border colors - determine a decent set of border colors for clrBD2 and clrBD3 using
@@ -539,8 +539,8 @@ int iY, iU, iV, iR, iG, iB;
   PXM_RGBToPixel(PXM_StandardColormapFromColormap(NULL,colormap),
                 &(pDialogControl->clrBD3)); // re-assign pixel element from RGB values
 
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD2));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD3));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD2));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD3));
 }
 
 
@@ -607,19 +607,19 @@ static void old_alloc_control_colors(WBDialogControl *pDialogControl,
 //  WB_ERROR_PRINT("   %s=%s  default=%s\n", szBDName, szBD, "black");
 
 
-  XParseColor(WBGetDefaultDisplay(), colormap, szFG, &(pDialogControl->clrFG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrFG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szBG, &(pDialogControl->clrBG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szAFG, &(pDialogControl->clrAFG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrAFG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szABG, &(pDialogControl->clrABG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrABG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szHFG, &(pDialogControl->clrHFG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHFG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szHBG, &(pDialogControl->clrHBG));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHBG));
-  XParseColor(WBGetDefaultDisplay(), colormap, szBD, &(pDialogControl->clrBD));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szFG, &(pDialogControl->clrFG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrFG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBG, &(pDialogControl->clrBG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szAFG, &(pDialogControl->clrAFG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrAFG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szABG, &(pDialogControl->clrABG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrABG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHFG, &(pDialogControl->clrHFG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHFG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHBG, &(pDialogControl->clrHBG));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrHBG));
+  PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBD, &(pDialogControl->clrBD));
 
   // ---------------------------------------------------------------------------------------
   // 3D border colors - determine a decent set of border colors for clrBD2 and clrBD3 using
@@ -653,8 +653,8 @@ static void old_alloc_control_colors(WBDialogControl *pDialogControl,
   PXM_RGBToPixel(PXM_StandardColormapFromColormap(NULL,colormap),
                 &(pDialogControl->clrBD3)); // re-assign pixel element from RGB values
 
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD2));
-  XAllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD3));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD2));
+  PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pDialogControl->clrBD3));
 }
 
 #undef LOAD_COLOR0
@@ -1048,6 +1048,9 @@ BEGIN_CREATE_CONTROL(EDIT_CONTROL);
   // this one needs a special cursor
   WBSetWindowDefaultCursor(pDialogControl->wID, XC_xterm);//tcross);
 
+  // drag-select and held-down cursor keys don't need every intermediate event (see EditDoCharEvent)
+  WBSetWindowEventCompression(pDialogControl->wID, WB_COMPRESS_MOTION | WB_COMPRESS_KEYREPEAT);
+
   // assign colors to TEXT OBJECT
 
   // now allow certain kinds of input messages (I should be able to handle messages at this point)
@@ -1564,6 +1567,9 @@ BEGIN_CREATE_CONTROL(LIST_CONTROL);
 
   ((WBListControl *)pDialogControl)->pBold = NULL; // make sure
 
+  // held-down cursor keys don't need every intermediate event (see ListDoCharEvent)
+  WBSetWindowEventCompression(pDialogControl->wID, WB_COMPRESS_MOTION | WB_COMPRESS_KEYREPEAT);
+
 
   // now allow certain kinds of input messages (I should be able to handle messages at this point)
   XSelectInput(pDisplay, pDialogControl->wID,
@@ -3610,6 +3616,28 @@ char *pBuf, *pData;
 WB_RECT rctTemp;
 
 
+  nChar = WBGetCharEventRepeat(pEvent);
+
+  if(nChar > 1) // coalesced auto-repeat (see WBSetWindowEventCompression), so do it once for each
+  {
+    XClientMessageEvent evt;
+
+    memcpy(&evt, pEvent, sizeof(evt));
+    evt.data.l[4] = 0;
+
+    while(nChar-- > 0)
+    {
+      iKey = EditDoCharEvent(&evt, pDisplay, wID, pSelf);
+
+      if(iRval <= 0 && iKey) // 'text changed' takes precedence over 'handled'
+      {
+        iRval = iKey;
+      }
+    }
+
+    return iRval;
+  }
+
   iKey = pEvent->data.l[0];  // result from WBKeyEventProcessKey()
   iACS = pEvent->data.l[1];
   nChar = pEvent->data.l[2];
@@ -4423,6 +4451,28 @@ int iRval = 0, iACS, iKey, nChar;//, iLen;
 //char *pBuf;
 
 
+  nChar = WBGetCharEventRepeat(pEvent);
+
+  if(nChar > 1) // coalesced auto-repeat (see WBSetWindowEventCompression), so do it once for each
+  {
+    XClientMessageEvent evt;
+
+    memcpy(&evt, pEvent, sizeof(evt));
+    evt.data.l[4] = 0;
+
+    while(nChar-- > 0)
+    {
+      iKey = ListDoCharEvent(&evt, pDisplay, wID, pSelf);
+
+      if(iRval <= 0 && iKey) // 'selection changed' takes precedence over 'handled'
+      {
+        iRval = iKey;
+      }
+    }
+
+    return iRval;
+  }
+
   iKey = pEvent->data.l[0];  // result from WBKeyEventProcessKey()
   iACS = pEvent->data.l[1];
   nChar = pEvent->data.l[2];
@@ -246,12 +246,12 @@ static void InternalCheckColors(void)
      else LOAD_COLOR("*border", szBD, "black"); // default for gnome
 #endif // 0
 
-    XParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBD, &clrBD);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBD);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBD, &clrBD);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBD);
 
     iInitColorFlag = 1;
   }
@@ -390,6 +390,7 @@ WBDialogWindow *DLGCreateDialogWindow(Window wIDOwner, const char *szTitle, cons
                  __FUNCTION__, iX, iY, iWidth, iHeight, xsh.width, xsh.height);
 
   XMoveResizeWindow(pDisplay, pNew->wbDLG.wID, iX, iY, xsh.width, xsh.height); // do this FIRST before doing 'hints'
+  WBMarkWindowGeomStale(pNew->wbDLG.wID);
 
   if(1) // dialog cannot be re-sized
   {
@@ -1902,10 +1903,19 @@ struct _KIDS_
   int iID;        // ID for control entry
   int iX, iY, iWidth, iHeight;  // that too
   int iFlags;     // flags to be assigned when control is created
-  char *szTitle;  // pointer to WBAlloc'd string with title
-  char *szProp;   // pointer to WBAlloc'd string with additional properties
+  char *szTitle;  // pointer to string with title
+  char *szProp;   // pointer to string with additional properties
 } *pKids = NULL;
 char tbuf[256];
+WB_ARENA hScratch;
+WB_ARENA_MARK pMark;
+
+
+  // 'pKids' and the strings it points to are temporary, so they come from the scratch
+  // arena.  They're all freed by resetting it to 'pMark' before I return.
+
+  hScratch = WBArenaScratch();
+  pMark = WBArenaMark(hScratch);
 
 
   p1 = p2 = *pszDialogResource;
@@ -1933,6 +1943,7 @@ char tbuf[256];
             WB_WARN_PRINT("%s - Illegal newline/return character in embedded string within dialog resource\n",
                           __FUNCTION__);
             *pszDialogResource = p2;
+            WBArenaReset(hScratch, pMark);
             return 0;
           }
 
@@ -1973,6 +1984,7 @@ char tbuf[256];
       WB_WARN_PRINT("%s - NULL in aszKeywords in InternalCreateChildWindowsSub within dialog resource\n", __FUNCTION__);
       // TODO:  do I handle this as a custom property for a control?
       *pszDialogResource = p2;
+      WBArenaReset(hScratch, pMark);
       return 0;
     }
 
@@ -1980,7 +1992,7 @@ char tbuf[256];
     {
       if(!pKids)
       {
-        pKids = WBAlloc(sizeof(*pKids));  // because it can't be NULL
+        pKids = WBArenaAlloc(hScratch, sizeof(*pKids));  // because it can't be NULL
         nKids = 0;
       }
 
@@ -1992,6 +2004,7 @@ char tbuf[256];
       WB_WARN_PRINT("%s - nested dialogs not supported (yet)\n", __FUNCTION__);
 
       *pszDialogResource = p2;
+      WBArenaReset(hScratch, pMark);
       return 0;
     }
 
@@ -2001,7 +2014,7 @@ char tbuf[256];
 
         if(!pKids)
         {
-          pKids = WBAlloc(iCurSize = (256 * sizeof(*pKids)));
+          pKids = WBArenaAlloc(hScratch, iCurSize = (256 * sizeof(*pKids)));
           if(!pKids)
           {
             WB_ERROR_PRINT("%s - not enough memory for controls\n", __FUNCTION__);
@@ -2009,10 +2022,6 @@ char tbuf[256];
             break;
           }
 
-//#ifdef HAVE_MALLOC_USABLE_SIZE
-          iCurSize = WBAllocUsableSize(pKids); // re-evaluate actual size
-//#endif // HAVE_MALLOC_USABLE_SIZE
-
           nKids = 1;
         }
         else if((nKids + 1) * sizeof(*pKids) > iCurSize)
@@ -2021,7 +2030,7 @@ char tbuf[256];
           void *p0;
 
           iNewSize = (nKids + 128) * sizeof(*pKids);
-          p0 = WBReAlloc(pKids, iNewSize);
+          p0 = WBArenaReAlloc(hScratch, pKids, iCurSize, iNewSize);
 
           if(!p0)
           {
@@ -2030,11 +2039,7 @@ char tbuf[256];
             break;
           }
 
-//#ifdef HAVE_MALLOC_USABLE_SIZE
-          iCurSize = WBAllocUsableSize(p0); // re-evaluate actual size
-//#else  // HAVE_MALLOC_USABLE_SIZE
-//          iCurSize = iNewSize;
-//#endif // HAVE_MALLOC_USABLE_SIZE
+          iCurSize = iNewSize;
 
           pKids = (struct _KIDS_ *)p0;
           nKids++;
@@ -2335,10 +2340,7 @@ char tbuf[256];
         {
           struct _KIDS_ *pKid = pKids + nKids - 1;
 
-          if(pKid->szTitle)
-            WBFree(pKid->szTitle);
-
-          pKid->szTitle = WBAlloc(p1 - p3 + 1);
+          pKid->szTitle = WBArenaAlloc(hScratch, p1 - p3 + 1); // a previous title is reclaimed with the arena
           if(!pKid->szTitle)
           {
             WB_WARN_PRINT("%s - Not enough memory for control title %-.20s\n", __FUNCTION__, p3);
@@ -2462,23 +2464,7 @@ char tbuf[256];
 
     if(iKW < 0)  // error in control list
     {
-      if(pKids)
-      {
-        for(i1=0; i1 < nKids; i1++)
-        {
-          if(pKids[i1].szTitle)
-          {
-            WBFree(pKids[i1].szTitle);
-          }
-          if(pKids[i1].szProp)
-          {
-            WBFree(pKids[i1].szProp);
-          }
-        }
-
-        WBFree(pKids);
-        pKids = NULL;  // my error flag below
-      }
+      pKids = NULL;  // my error flag below (the memory is freed with the arena)
 
       break;  // error flag from above
     }
@@ -2492,6 +2478,7 @@ char tbuf[256];
     WB_ERROR_PRINT("%s - NULL 'pKids' in InternalCreateChildWindowsSub\n", __FUNCTION__);
     *pszDialogResource = p2;  // point of error
 
+    WBArenaReset(hScratch, pMark);
     return 0;
   }
 
@@ -2507,22 +2494,9 @@ char tbuf[256];
 
       WB_ERROR_PRINT("%s - NULL 'pwContents' in InternalCreateChildWindowsSub\n", __FUNCTION__);
 
-      for(i1=0; i1 < nKids; i1++)
-      {
-        if(pKids[i1].szTitle)
-        {
-          WBFree(pKids[i1].szTitle);
-        }
-        if(pKids[i1].szProp)
-        {
-          WBFree(pKids[i1].szProp);
-        }
-      }
-
-      WBFree(pKids);
-
       *pszDialogResource = p1;  // point of error
 
+      WBArenaReset(hScratch, pMark);
       return 0;
     }
 
@@ -2544,22 +2518,9 @@ char tbuf[256];
     if(!p0)
     {
       WB_ERROR_PRINT("%s - NULL 'pwContents' (re-alloc) in InternalCreateChildWindowsSub\n", __FUNCTION__);
-      for(i1=0; i1 < nKids; i1++)
-      {
-        if(pKids[i1].szTitle)
-        {
-          WBFree(pKids[i1].szTitle);
-        }
-        if(pKids[i1].szProp)
-        {
-          WBFree(pKids[i1].szProp);
-        }
-      }
-
-      WBFree(pKids);
-
       *pszDialogResource = p1;  // point of error
 
+      WBArenaReset(hScratch, pMark);
       return 0;
     }
 
@@ -2625,19 +2586,7 @@ char tbuf[256];
 
   // final cleanup
 
-  for(i1=0; i1 < nKids; i1++)
-  {
-    if(pKids[i1].szTitle)
-    {
-      WBFree(pKids[i1].szTitle);
-    }
-    if(pKids[i1].szProp)
-    {
-      WBFree(pKids[i1].szProp);
-    }
-  }
-
-  WBFree(pKids);   // not needed now
+  WBArenaReset(hScratch, pMark); // 'pKids' and its strings are not needed now
 
   *pszDialogResource = p1;
 
@@ -100,6 +100,45 @@ static void InternalDebugDumpWords(DT_WORDS *pWords); ///< \brief internal debug
 
 static void __internalDoAntiAlias(WB_DISPLAY pDisplay, Drawable dw, WBGC gc, int iX, int iY, int iWidth, int iHeight);
 
+static DT_WORDS * __internalParseWords(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iAlignment);
+
+
+// layout cache - an LRU cache of parsed 'words' for (font, text, parse flags), each with
+// a couple of computed layouts for (tab width, tab origin, source rectangle, alignment).
+// On a resize only the layout is re-calculated; the text is not re-measured.
+
+#define LAYOUT_CACHE_SIZE 32  /* number of (font, text) entries */
+#define LAYOUT_CACHE_SLOTS 2  /* layouts per entry; 'calc bounds' and 'draw' each use one */
+
+#define LAYOUT_CACHE_WORD_FLAGS (DTAlignment_SINGLELINE | DTAlignment_UNDERSCORE) /* flags that affect parsing */
+
+typedef struct __DT_LAYOUT_SLOT__
+{
+  DT_WORDS *pWords;   // WBAlloc'd copy of the entry's words with iX,iY assigned (NULL if unused)
+  int iTabWidth;      // tab width the layout was calculated with
+  int iTabOrigin;     // tab origin the layout was calculated with
+  int iAlignment;     // alignment flags the layout was calculated with
+  int bHasSource;     // non-zero if 'rcSource' is valid (source rectangle was not NULL)
+  WB_RECT rcSource;   // source rectangle
+  WB_RECT rcDest;     // resulting destination rectangle
+  int iRval;          // return value from InternalCalcIdealBounds()
+} DT_LAYOUT_SLOT;
+
+typedef struct __DT_LAYOUT_CACHE_ENTRY__
+{
+  WB_FONTC pFont;             // the font (NULL marks an unused entry)
+  WB_UINT32 uiHash;           // hash of szText
+  int iWordFlags;             // iAlignment & LAYOUT_CACHE_WORD_FLAGS
+  unsigned long ulLastUsed;   // LRU 'clock' value
+  char *szText;               // WBAlloc'd copy of the text.  'pText' in pWords points into this
+  DT_WORDS *pWords;           // parsed (and measured) words, no layout
+  int iNextSlot;              // next layout slot to replace
+  DT_LAYOUT_SLOT aSlot[LAYOUT_CACHE_SLOTS];
+} DT_LAYOUT_CACHE_ENTRY;
+
+static DT_LAYOUT_CACHE_ENTRY aLayoutCache[LAYOUT_CACHE_SIZE];
+static unsigned long ulLayoutCacheClock = 0;
+
 
 // *******************
 // DRAW TEXT UTILITIES
@@ -115,6 +154,8 @@ char tbuf[1024];
 char *pS;
 WB_EXTENT ext;
 XImage *pImage;
+WB_ARENA hScratch = NULL;
+WB_ARENA_MARK pMark = NULL;
 
 //#if defined(X_HAVE_UTF8_STRING)
 //#define DO_DRAW_STRING Xutf8DrawString
@@ -175,7 +216,12 @@ use_the_stack_buffer:
   }
   else
   {
-    pS = WBAlloc(nLength);
+    // larger strings use the scratch arena, which is reset when I'm done
+
+    hScratch = WBArenaScratch();
+    pMark = WBArenaMark(hScratch);
+
+    pS = WBArenaAlloc(hScratch, nLength);
     if(!pS)
     {
       nLength = sizeof(tbuf); // shorten the string and do it anyway, but not all of it.  desperate, yeah.
@@ -266,9 +312,9 @@ use_the_stack_buffer:
   }
 
   // free up buffer if I allocated it
-  if(pS && pS != &(tbuf[0]) && pS != (char *)pString)
+  if(hScratch)
   {
-    WBFree(pS);
+    WBArenaReset(hScratch, pMark);
   }
 }
 
@@ -362,7 +408,7 @@ DT_WORDS *pRval = *ppWords;
 // However the focus of THIS project is "only implement what is necessary" (and forget the rest).
 
 
-DT_WORDS * DTGetWordsFromText(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iAlignment)
+static DT_WORDS * __internalParseWords(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iAlignment)
 {
   const char *p1, *p2;
 
@@ -576,16 +622,268 @@ DT_WORDS * DTGetWordsFromText(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *s
   return pRval;
 }
 
+static WB_UINT32 __internalLayoutTextHash(const char *szText)
+{
+WB_UINT32 uiRval = 2166136261U; // FNV-1a
+
+  while(*szText)
+  {
+    uiRval = (uiRval ^ (unsigned char)*(szText++)) * 16777619U;
+  }
+
+  return uiRval;
+}
+
+// make a WBAlloc'd copy of a DT_WORDS, with all of the 'pText' pointers re-based to 'szText'
+// (which must contain the same text as pSrc->szText)
+static DT_WORDS * __internalCopyWords(const DT_WORDS *pSrc, const char *szText)
+{
+DT_WORDS *pRval;
+int i1, nCount;
+
+
+  nCount = pSrc->nCount > 0 ? pSrc->nCount : 1;
+
+  pRval = WBAlloc(sizeof(DT_WORDS) + sizeof(DT_WORD) * (nCount - 1));
+
+  if(!pRval)
+  {
+    return NULL;
+  }
+
+  memcpy(pRval, pSrc, sizeof(DT_WORDS) + sizeof(DT_WORD) * (nCount - 1));
+
+  pRval->szText = szText;
+  pRval->nMax = (WBAllocUsableSize(pRval) - sizeof(DT_WORDS))
+              / sizeof(DT_WORD)
+              + 1; // because DT_WORDS contains one DT_WORD
+
+  for(i1=0; i1 < pRval->nCount; i1++)
+  {
+    if(pRval->aWords[i1].pText)
+    {
+      pRval->aWords[i1].pText = szText + (pSrc->aWords[i1].pText - pSrc->szText);
+    }
+  }
+
+  return pRval;
+}
+
+static void __internalFreeLayoutEntry(DT_LAYOUT_CACHE_ENTRY *pEntry)
+{
+int i1;
+
+
+  for(i1=0; i1 < LAYOUT_CACHE_SLOTS; i1++)
+  {
+    if(pEntry->aSlot[i1].pWords)
+    {
+      WBFree(pEntry->aSlot[i1].pWords);
+    }
+  }
+
+  if(pEntry->pWords)
+  {
+    WBFree(pEntry->pWords);
+  }
+
+  if(pEntry->szText)
+  {
+    WBFree(pEntry->szText);
+  }
+
+  memset(pEntry, 0, sizeof(*pEntry));
+}
+
+// find (or create) the layout cache entry for the font, text, and parse flags.  'pFont' must not be NULL.
+// returns NULL on error.
+static DT_LAYOUT_CACHE_ENTRY * __internalGetLayoutEntry(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iAlignment)
+{
+DT_LAYOUT_CACHE_ENTRY *pEntry, *pLRU;
+WB_UINT32 uiHash;
+int i1, iWordFlags;
+
+
+  if(!szText)
+  {
+    szText = "";
+  }
+
+  uiHash = __internalLayoutTextHash(szText);
+  iWordFlags = iAlignment & LAYOUT_CACHE_WORD_FLAGS;
+
+  ulLayoutCacheClock++;
+
+  for(i1=0, pLRU=aLayoutCache; i1 < LAYOUT_CACHE_SIZE; i1++)
+  {
+    pEntry = aLayoutCache + i1;
+
+    if(pEntry->pFont == pFont && pEntry->uiHash == uiHash && pEntry->iWordFlags == iWordFlags &&
+       !strcmp(pEntry->szText, szText))
+    {
+      pEntry->ulLastUsed = ulLayoutCacheClock;
+      return pEntry;
+    }
+
+    if(pLRU->pFont && (!pEntry->pFont || pEntry->ulLastUsed < pLRU->ulLastUsed))
+    {
+      pLRU = pEntry; // least recently used, or unused
+    }
+  }
+
+  // not found - replace the least recently used entry
+
+  __internalFreeLayoutEntry(pLRU);
+
+  pLRU->szText = WBCopyString(szText);
+
+  if(!pLRU->szText)
+  {
+    return NULL;
+  }
+
+  pLRU->pWords = __internalParseWords(pDisplay, pFont, pLRU->szText, iAlignment);
+
+  if(!pLRU->pWords)
+  {
+    __internalFreeLayoutEntry(pLRU);
+    return NULL;
+  }
+
+  pLRU->pFont = pFont;
+  pLRU->uiHash = uiHash;
+  pLRU->iWordFlags = iWordFlags;
+  pLRU->ulLastUsed = ulLayoutCacheClock;
+
+  return pLRU;
+}
+
+// find (or calculate) the layout for the specified parameters, using the cached words in 'pEntry'.
+// returns NULL on error (not enough memory), else the slot (check 'iRval' for the result)
+static const DT_LAYOUT_SLOT * __internalGetLayout(DT_LAYOUT_CACHE_ENTRY *pEntry, WB_DISPLAY pDisplay, WB_FONTC pFont,
+                                                  int iTabWidth, unsigned int iTabOrigin,
+                                                  const WB_RECT *prcSource, int iAlignment)
+{
+DT_LAYOUT_SLOT *pSlot;
+int i1;
+
+
+  for(i1=0; i1 < LAYOUT_CACHE_SLOTS; i1++)
+  {
+    pSlot = pEntry->aSlot + i1;
+
+    if(pSlot->pWords &&
+       pSlot->iTabWidth == iTabWidth && pSlot->iTabOrigin == (int)iTabOrigin &&
+       pSlot->iAlignment == iAlignment &&
+       pSlot->bHasSource == (prcSource != NULL) &&
+       (!prcSource || !memcmp(&(pSlot->rcSource), prcSource, sizeof(*prcSource))))
+    {
+      return pSlot;
+    }
+  }
+
+  // not found, so calculate it (re-using the already measured words)
+
+  pSlot = pEntry->aSlot + pEntry->iNextSlot;
+  pEntry->iNextSlot = (pEntry->iNextSlot + 1) % LAYOUT_CACHE_SLOTS;
+
+  if(pSlot->pWords)
+  {
+    WBFree(pSlot->pWords);
+  }
+
+  pSlot->pWords = __internalCopyWords(pEntry->pWords, pEntry->szText);
+
+  if(!pSlot->pWords)
+  {
+    return NULL;
+  }
+
+  pSlot->iTabWidth = iTabWidth;
+  pSlot->iTabOrigin = (int)iTabOrigin;
+  pSlot->iAlignment = iAlignment;
+  pSlot->bHasSource = prcSource != NULL;
+
+  if(prcSource)
+  {
+    memcpy(&(pSlot->rcSource), prcSource, sizeof(pSlot->rcSource));
+    memcpy(&(pSlot->rcDest), prcSource, sizeof(pSlot->rcDest));
+  }
+  else
+  {
+    bzero(&(pSlot->rcSource), sizeof(pSlot->rcSource));
+    bzero(&(pSlot->rcDest), sizeof(pSlot->rcDest));
+  }
+
+  pSlot->iRval = InternalCalcIdealBounds(pDisplay, pFont, pSlot->pWords, iTabWidth, iTabOrigin, prcSource,
+                                         &(pSlot->rcDest), iAlignment, 0, -1);
+
+  return pSlot;
+}
+
+void DTFlushLayoutCache(WB_FONTC pFont)
+{
+int i1;
+
+
+  for(i1=0; i1 < LAYOUT_CACHE_SIZE; i1++)
+  {
+    if(aLayoutCache[i1].pFont &&
+       (!pFont || aLayoutCache[i1].pFont == pFont))
+    {
+      __internalFreeLayoutEntry(aLayoutCache + i1);
+    }
+  }
+}
+
+DT_WORDS * DTGetWordsFromText(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iAlignment)
+{
+DT_LAYOUT_CACHE_ENTRY *pEntry;
+WB_FONTC pKeyFont;
+
+
+  pKeyFont = pFont ? pFont : WBGetDefaultFont();
+
+  if(!pKeyFont)
+  {
+    return __internalParseWords(pDisplay, pFont, szText, iAlignment);
+  }
+
+  pEntry = __internalGetLayoutEntry(pDisplay, pKeyFont, szText, iAlignment);
+
+  if(!pEntry)
+  {
+    return NULL;
+  }
+
+  // the caller owns the returned copy, with 'pText' pointing into the caller's buffer as before
+
+  return __internalCopyWords(pEntry->pWords, szText);
+}
+
 int DTCalcIdealBounds(WB_DISPLAY pDisplay, WB_FONTC pFont, const char *szText, int iTabWidth, unsigned int iTabOrigin,
                       const WB_RECT *prcSource, WB_RECT *prcDest, int iAlignment)
 {
-int iRval;
-DT_WORDS *pWords;
+DT_LAYOUT_CACHE_ENTRY *pEntry;
+const DT_LAYOUT_SLOT *pSlot;
 
 
-  pWords = DTGetWordsFromText(pDisplay, pFont, szText, iAlignment);
+  if(!prcSource && !prcDest)
+  {
+    WB_ERROR_PRINT("%s - returns ERROR (bad values prcSource=%p, prcDest=%p)\n",
+                   __FUNCTION__, prcSource, prcDest);
+    return -1;
+  }
 
-  if(!pWords)
+  if(!pFont)
+  {
+    pFont = WBGetDefaultFont();
+  }
+
+  pEntry = pFont ? __internalGetLayoutEntry(pDisplay, pFont, szText, iAlignment) : NULL;
+  pSlot = pEntry ? __internalGetLayout(pEntry, pDisplay, pFont, iTabWidth, iTabOrigin, prcSource, iAlignment) : NULL;
+
+  if(!pSlot)
   {
     if(prcDest)
       prcDest->left = prcDest->right = prcDest->top = prcDest->bottom = 0;
@@ -593,13 +891,14 @@ DT_WORDS *pWords;
     return -1; // error
   }
 
-//  InternalDebugDumpWords(pWords);
+//  InternalDebugDumpWords(pSlot->pWords);
 
-  iRval = InternalCalcIdealBounds(pDisplay, pFont, pWords, iTabWidth, iTabOrigin, prcSource, prcDest, iAlignment, 0, -1);
-
-  WBFree(pWords);
+  if(prcDest && pSlot->iRval >= 0)
+  {
+    memcpy(prcDest, &(pSlot->rcDest), sizeof(*prcDest));
+  }
 
-  return iRval;
+  return pSlot->iRval;
 }
 
 
@@ -1386,9 +1685,21 @@ Region rgnClip;
                  "%s.%d - geom %d,%d,%d,%d\n", __FUNCTION__, __LINE__, iX, iY, iWidth, iHeight);
 
   // use XGetGeometry to obtain the characteristics of the pixmap or window.  iX and iY SHOULD be zero...
-  BEGIN_XCALL_DEBUG_WRAPPER
-  XGetGeometry(pDisplay, dw, &winRoot, &iX0, &iY0, &iWidth0, &iHeight0, &iBorder, &uiDepth);
-  END_XCALL_DEBUG_WRAPPER
+  // for a window with cached geometry, use that instead (avoids a round trip)
+
+  if(!WBGetCachedWindowGeom((Window)dw, &geom))
+  {
+    iX0 = geom.x;
+    iY0 = geom.y;
+    iWidth0 = geom.width;
+    iHeight0 = geom.height;
+  }
+  else
+  {
+    BEGIN_XCALL_DEBUG_WRAPPER
+    XGetGeometry(pDisplay, dw, &winRoot, &iX0, &iY0, &iWidth0, &iHeight0, &iBorder, &uiDepth);
+    END_XCALL_DEBUG_WRAPPER
+  }
 
   geom.x = 0;
   geom.y = 0;
@@ -1539,8 +1850,10 @@ void DTDrawMultiLineText(WB_FONTC pFont, const char *szText, WB_DISPLAY pDisplay
                          int iTabWidth, int iTabOrigin, const WB_RECT *prcBounds, int iAlignment)
 {
 int i1, i2, i3, iH, iH2, iFontDescent; //, iW2, iFontWidth, iFontHeight;
-DT_WORDS *pWords;
-DT_WORD *pW;
+DT_LAYOUT_CACHE_ENTRY *pEntry;
+const DT_LAYOUT_SLOT *pSlot;
+const DT_WORDS *pWords;
+const DT_WORD *pW;
 WB_RECT rcDest;
 XPoint xpt[3];
 XCharStruct xMaxBounds;
@@ -1571,32 +1884,34 @@ XCharStruct xMaxBounds;
 //  iFontHeight = pFont->ascent + pFont->descent;
 
   WB_DEBUG_PRINT(DebugLevel_Verbose | DebugSubSystem_DrawText,
-                 "%s.%d call to DTGetWordsFromText\n", __FUNCTION__, __LINE__);
-  pWords = DTGetWordsFromText(pDisplay, pFont, szText, iAlignment);
+                 "%s.%d get cached words for text\n", __FUNCTION__, __LINE__);
+  pEntry = __internalGetLayoutEntry(pDisplay, pFont, szText, iAlignment);
 
-  if(!pWords)
+  if(!pEntry)
   {
-    WB_ERROR_PRINT("%s - ERROR:  DTGetWordsFromText returns NULL\n",
+    WB_ERROR_PRINT("%s - ERROR:  unable to parse words from text\n",
                    __FUNCTION__);
 
     return; // error
   }
 
-  memcpy(&rcDest, prcBounds, sizeof(rcDest));
-
   WB_DEBUG_PRINT(DebugLevel_Verbose | DebugSubSystem_DrawText,
                  "%s.%d bounds rectangle is INITIALLY %d,%d,%d,%d\n",
-                 __FUNCTION__, __LINE__, rcDest.left, rcDest.top, rcDest.right, rcDest.bottom);
+                 __FUNCTION__, __LINE__, prcBounds->left, prcBounds->top, prcBounds->right, prcBounds->bottom);
+
+  // the layout is only re-calculated when the font, text, bounds, tabs, or alignment change
 
   WB_DEBUG_PRINT(DebugLevel_Verbose | DebugSubSystem_DrawText,
-                 "%s.%d call to InternalCalcIdealBounds\n", __FUNCTION__, __LINE__);
-  if(InternalCalcIdealBounds(pDisplay, pFont, pWords, iTabWidth, iTabOrigin, prcBounds, &rcDest,
-                             iAlignment | DTAlignment_PRINTING, 0, -1)
-    < 0)
-  {
-    InternalDebugDumpWords(pWords);
+                 "%s.%d get cached layout\n", __FUNCTION__, __LINE__);
+  pSlot = __internalGetLayout(pEntry, pDisplay, pFont, iTabWidth, iTabOrigin, prcBounds,
+                              iAlignment | DTAlignment_PRINTING);
 
-    WBFree(pWords);
+  if(!pSlot || pSlot->iRval < 0)
+  {
+    if(pSlot)
+    {
+      InternalDebugDumpWords(pSlot->pWords);
+    }
 
     WB_ERROR_PRINT("%s - ERROR:  InternalCalcIdealBounds returns error\n",
                    __FUNCTION__);
@@ -1604,6 +1919,9 @@ XCharStruct xMaxBounds;
     return; // bad (error)
   }
 
+  pWords = pSlot->pWords;
+  memcpy(&rcDest, &(pSlot->rcDest), sizeof(rcDest));
+
   iFontDescent = WBFontDescent(pFont);
   xMaxBounds = WBFontMaxBounds(pFont); // font's 'max_bounds' structure member, maximized for all of them
 
@@ -1731,8 +2049,6 @@ XCharStruct xMaxBounds;
                           rcDest.right - rcDest.left,
                           rcDest.bottom - rcDest.top);
   }
-
-  WBFree(pWords);
 }
 
 
@@ -60,6 +60,7 @@
 #include "conf_help.h"
 #include "file_help.h"
 #include "draw_text.h"
+#include "pixmap_helper.h"
 
 #include "dialog_window.h" // for message boxen
 #include "dialog_controls.h" // for 'aDIALOG_INIT'
@@ -261,14 +262,14 @@ static void InternalCheckEWColorsAndAtoms(void)
                    szFG, szBG, szAFG, szABG);
 #endif // 0
 
-    XParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szHFG, &clrHFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrHFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szHBG, &clrHBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrHBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHFG, &clrHFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrHFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHBG, &clrHBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrHBG);
 
     iInitColorFlag = 1;
   }
@@ -334,6 +335,10 @@ int iRet;
 
   pRval->xTextObject.wIDOwner = pRval->childframe.wID; // TODO:  make assigning this an API function?
 
+  // drag-select and held-down cursor keys only need the most recent state.  the child frame's
+  // WB_CHAR handler repeats the cursor movement as needed, and the window is painted once.
+  WBSetWindowEventCompression(pRval->childframe.wID, WB_COMPRESS_MOTION | WB_COMPRESS_KEYREPEAT);
+
 
   // assign my 'UI' vtable pointer, which will be (intelligently) called by the 'Child Frame' event handler
   // this standardizes the various UI methods and makes coding a complex UI quite a bit easier
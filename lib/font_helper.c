@@ -156,6 +156,8 @@ Display *pDisplay = WBGetDefaultDisplay();
 
 void __internal_font_helper_exit(void)
 {
+  DTFlushLayoutCache(NULL); // cached text layouts refer to fonts
+
 #ifdef X11WORKBENCH_TOOLKIT_HAVE_XFT
   if(bInitFtLibOnce)
   {
@@ -290,6 +292,8 @@ void WBFreeFont(WB_DISPLAY pDisplay, WB_FONT pFont)
 
   if(pFont)
   {
+    DTFlushLayoutCache(pFont); // cached layouts for this font are no longer valid
+
 #ifdef X11WORKBENCH_TOOLKIT_HAVE_XFT
     if(pFont->pxftFont)
     {
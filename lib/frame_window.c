@@ -372,14 +372,14 @@ int iY, iU, iV, iR, iG, iB;
     LOAD_COLOR("selected_bg_color", szABG, "#0040FF"); // a slightly greenish blue for the 'selected' color
 #endif // 0
 
-    XParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBD, &clrBD);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBD);
-    XParseColor(WBGetDefaultDisplay(), colormap, szHBG, &clrHBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrHBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBD, &clrBD);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBD);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHBG, &clrHBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrHBG);
 
 
     // ---------------------------------------------------------------------------------------
@@ -414,8 +414,8 @@ int iY, iU, iV, iR, iG, iB;
     PXM_RGBToPixel(PXM_StandardColormapFromColormap(NULL,colormap),
                   &clrBD3); // re-assign pixel element from RGB values
 
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBD2);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrBD3);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBD2);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrBD3);
 
     iInitColorFlag = 1;
   }
@@ -85,6 +85,13 @@
 #include "conf_help.h"
 
 
+// GC attribute shadowing - the WBGC 'values' member mirrors the X server's GC state,
+// so any attribute change whose value already matches is not sent at all.  These
+// counters measure how effective that is (see WBGetGCStats)
+
+static WB_GC_STATS xGCStats = {0, 0};
+
+
 static XImage *__internalGetClipImage(WBGC hGC)
 {
 XImage *pRval = NULL;
@@ -673,12 +680,62 @@ WBGC pRval;
   return pRval;
 }
 
+static unsigned long __internalShadowGCMask(const XGCValues *pOld, unsigned long valuemask,
+                                            const XGCValues *pNew)
+{
+unsigned long ulRval = valuemask;
+
+  // remove any scalar attribute from 'valuemask' that already matches the cached value
+
+#define SHADOW_CHECK(X,Y) if((valuemask & (X)) && pOld->Y == pNew->Y) { ulRval &= ~(X); }
+
+  SHADOW_CHECK(GCFunction, function);
+  SHADOW_CHECK(GCPlaneMask, plane_mask);
+  SHADOW_CHECK(GCForeground, foreground);
+  SHADOW_CHECK(GCBackground, background);
+  SHADOW_CHECK(GCLineWidth, line_width);
+  SHADOW_CHECK(GCLineStyle, line_style);
+  SHADOW_CHECK(GCCapStyle, cap_style);
+  SHADOW_CHECK(GCJoinStyle, join_style);
+  SHADOW_CHECK(GCFillStyle, fill_style);
+  SHADOW_CHECK(GCFillRule, fill_rule);
+  SHADOW_CHECK(GCArcMode, arc_mode);
+  SHADOW_CHECK(GCTileStipXOrigin, ts_x_origin);
+  SHADOW_CHECK(GCTileStipYOrigin, ts_y_origin);
+  SHADOW_CHECK(GCSubwindowMode, subwindow_mode);
+  SHADOW_CHECK(GCGraphicsExposures, graphics_exposures);
+  SHADOW_CHECK(GCClipXOrigin, clip_x_origin);
+  SHADOW_CHECK(GCClipYOrigin, clip_y_origin);
+
+#undef SHADOW_CHECK
+
+  if(ulRval != valuemask)
+  {
+    xGCStats.nSuppressed++;
+  }
+
+  return ulRval;
+}
+
 int WBChangeGC(WBGC hGC, unsigned long valuemask,
                const XGCValues *values)
 {
 int iRval;
 XGCValues valtemp;
 
+
+  if(values) // strip out anything that wouldn't actually change
+  {
+    valuemask = __internalShadowGCMask(&(hGC->values), valuemask, values);
+
+    if(!valuemask)
+    {
+      return 1; // nothing to do (XChangeGC would have returned 1)
+    }
+  }
+
+  xGCStats.nRequests++;
+
   // if I'm changing something that has a cache, destroy the old one
   // or the same thing if I can't actually read the value like GCDash, GC
 
@@ -1384,10 +1441,18 @@ int WBSetRegion(WBGC hGC, Region rgnClip)
 int iRet;
 
 
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetRegion(hGC->display, hGC->gc, rgnClip);
   END_XCALL_DEBUG_WRAPPER
 
+  // XSetRegion also resets the clip origin to 0,0 - keep the shadow values in sync so that
+  // a later WBSetClipOrigin or WBChangeGC isn't suppressed by a stale origin
+
+  hGC->values.clip_x_origin = 0;
+  hGC->values.clip_y_origin = 0;
+
   if(hGC->clip_image)
   {
     WBXDestroyImage(hGC->clip_image);
@@ -1423,6 +1488,15 @@ int WBSetClipOrigin(WBGC hGC, int clip_x_origin, int clip_y_origin)
 {
 int iRet;
 
+  if(hGC->values.clip_x_origin == clip_x_origin &&
+     hGC->values.clip_y_origin == clip_y_origin)
+  {
+    xGCStats.nSuppressed++;
+    return 1; // already set (XSetClipOrigin would have returned 1)
+  }
+
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetClipOrigin(hGC->display, hGC->gc, clip_x_origin, clip_y_origin);
   END_XCALL_DEBUG_WRAPPER
@@ -1437,6 +1511,8 @@ int WBSetClipMask(WBGC hGC, WB_PIXMAP pixmap)
 {
 int iRet;
 
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetClipMask(hGC->display, hGC->gc, pixmap);
   END_XCALL_DEBUG_WRAPPER
@@ -1465,6 +1541,14 @@ int WBSetFunction(WBGC hGC, int function)
 {
 int iRet;
 
+  if(hGC->values.function == function)
+  {
+    xGCStats.nSuppressed++;
+    return 1; // already set (XSetFunction would have returned 1)
+  }
+
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetFunction(hGC->display, hGC->gc, function);
   END_XCALL_DEBUG_WRAPPER
@@ -1478,6 +1562,14 @@ int WBSetForeground(WBGC hGC, unsigned long foreground)
 {
 int iRet;
 
+  if(hGC->values.foreground == foreground)
+  {
+    xGCStats.nSuppressed++;
+    return 1; // already set (XSetForeground would have returned 1)
+  }
+
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetForeground(hGC->display, hGC->gc, foreground);
   END_XCALL_DEBUG_WRAPPER
@@ -1491,6 +1583,14 @@ int WBSetBackground(WBGC hGC, unsigned long background)
 {
 int iRet;
 
+  if(hGC->values.background == background)
+  {
+    xGCStats.nSuppressed++;
+    return 1; // already set (XSetBackground would have returned 1)
+  }
+
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetBackground(hGC->display, hGC->gc, background);
   END_XCALL_DEBUG_WRAPPER
@@ -1537,12 +1637,18 @@ int iRet = 0;
   if(pFont && pFont->pFontStruct &&
      pFont->pFontStruct->fid != hGC->values.font)
   {
+    xGCStats.nRequests++;
+
     BEGIN_XCALL_DEBUG_WRAPPER
     iRet = XSetFont(hGC->display, hGC->gc, pFont->pFontStruct->fid);
     END_XCALL_DEBUG_WRAPPER
 
     hGC->values.font = pFont->pFontStruct->fid; // updated (TODO set mask as well?)
   }
+  else if(pFont && pFont->pFontStruct)
+  {
+    xGCStats.nSuppressed++; // font ID already assigned
+  }
 
   if(hGC->pFont)
   {
@@ -1567,6 +1673,17 @@ int WBSetLineAttributes(WBGC hGC, unsigned int line_width,
 {
 int iRet;
 
+  if(hGC->values.line_width == (int)line_width &&
+     hGC->values.line_style == line_style &&
+     hGC->values.cap_style  == cap_style &&
+     hGC->values.join_style == join_style)
+  {
+    xGCStats.nSuppressed++;
+    return 1; // already set (XSetLineAttributes would have returned 1)
+  }
+
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetLineAttributes(hGC->display, hGC->gc, line_width, line_style, cap_style, join_style);
   END_XCALL_DEBUG_WRAPPER
@@ -1601,6 +1718,8 @@ char c1 = 0;
     pDashList = &c1;
   }
 
+  xGCStats.nRequests++;
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XSetDashes(hGC->display, hGC->gc, dash_offset, pDashList, n);
   END_XCALL_DEBUG_WRAPPER
@@ -1615,3 +1734,17 @@ char c1 = 0;
   return iRet;
 }
 
+
+void WBGetGCStats(WB_GC_STATS *pStats)
+{
+  if(pStats)
+  {
+    memcpy(pStats, &xGCStats, sizeof(*pStats));
+  }
+}
+
+void WBResetGCStats(void)
+{
+  bzero(&xGCStats, sizeof(xGCStats));
+}
+
@@ -260,26 +260,26 @@ int MBInitGlobal(void)
     // NOTE:  'DEBUG_VALIDATE' (defined above) simply validates the return and prints a message if it failed.
     //        in a release build, the code is still executed, but no error checks are performed on the return value
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuFG, &clrMenuFG));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuFG));  // NOTE:  do I need 'XFreeColors' for these ?
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuFG, &clrMenuFG));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuFG));
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuBG, &clrMenuBG));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBG));
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuBG, &clrMenuBG));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBG));
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuActiveFG, &clrMenuActiveFG));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuActiveFG));  // NOTE:  do I need 'XFreeColors' for these ?
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuActiveFG, &clrMenuActiveFG));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuActiveFG));
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuActiveBG, &clrMenuActiveBG));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuActiveBG));
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuActiveBG, &clrMenuActiveBG));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuActiveBG));
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuDisabledFG, &clrMenuDisabledFG));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuDisabledFG));
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuDisabledFG, &clrMenuDisabledFG));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuDisabledFG));
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuActiveDisabledFG, &clrMenuActiveDisabledFG));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuActiveDisabledFG));
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuActiveDisabledFG, &clrMenuActiveDisabledFG));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuActiveDisabledFG));
 
-    DEBUG_VALIDATE(XParseColor(WBGetDefaultDisplay(), colormap, szMenuBorder1, &clrMenuBorder1));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBorder1));
+    DEBUG_VALIDATE(PXM_ParseColor(WBGetDefaultDisplay(), colormap, szMenuBorder1, &clrMenuBorder1));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBorder1));
 
 
     if((clrMenuBG.flags & (DoRed | DoGreen | DoBlue)) != (DoRed | DoGreen | DoBlue))
@@ -309,8 +309,8 @@ int MBInitGlobal(void)
                   &(clrMenuBorder3)); // re-assign pixel element from RGB values
 
 
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBorder2));
-    DEBUG_VALIDATE(XAllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBorder3));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBorder2));
+    DEBUG_VALIDATE(PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrMenuBorder3));
 
 
     // TODO:  make sure I was able to actually allocate these colors
@@ -577,6 +577,7 @@ int MBMenuParentEvent(Window wIDMenu, XEvent *pEvent)
     XWindowChanges chg;
     chg.width = pEvent->xconfigure.width;
     XConfigureWindow(pDisplay, wIDMenu, CWWidth, &chg);
+    WBMarkWindowGeomStale(wIDMenu);
 
     WBInvalidateGeom(wIDMenu, NULL, 0);
 
@@ -715,6 +716,8 @@ int i1; //, iHPos, iVPos;
                    __FUNCTION__, (int)wID, (int)wID, xswa.width, xswa.height);
 
     XResizeWindow(pDisplay, wID, xswa.width, xswa.height);
+    WBMarkWindowGeomStale(wID);
+
     return 0;  // still requesting default handling on this one
   }
 
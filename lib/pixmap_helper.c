@@ -125,6 +125,23 @@ static int nAtomResourceList = 0, nAtomResourceListMax = 0;
 static char **ppRegAppLarge_Internal = NULL;
 static char **ppRegAppSmall_Internal = NULL;
 
+// color cache - see PXM_ParseColor() and PXM_AllocColor()
+
+#define MINIMUM_COLOR_CACHE_SIZE 256 /* must be a power of 2 */
+
+typedef struct __INTERNAL_COLOR_CACHE_ENTRY__
+{
+  WB_DISPLAY pDisplay;  // display for the entry; NULL marks an unused slot
+  Colormap colormap;    // colormap for the entry
+  WB_UINT32 uiHash;     // hash of the key (includes display and colormap)
+  char *szSpec;         // WBAlloc'd color spec for 'parse' entries, NULL for RGB 'alloc' entries
+  WB_UINT64 ullRGB;     // packed requested RGB for 'alloc' entries
+  XColor clr;           // cached result (parsed RGB, or allocated pixel with actual RGB)
+} INTERNAL_COLOR_CACHE_ENTRY;
+
+static INTERNAL_COLOR_CACHE_ENTRY *pColorCache = NULL;
+static int nColorCache = 0, nColorCacheMax = 0; // nColorCacheMax is always 0 or a power of 2
+
 XStandardColormap PXM_StandardColormapFromColormap_rval; // storage for static var for PXM_StandardColormapFromColormap()
 
 
@@ -145,6 +162,25 @@ void PXM_OnExit(void)
 
   ppRegAppLarge_Internal = NULL;
   ppRegAppSmall_Internal = NULL;
+
+  if(pColorCache)
+  {
+    int i1;
+
+    for(i1=0; i1 < nColorCacheMax; i1++)
+    {
+      if(pColorCache[i1].szSpec)
+      {
+        WBFree(pColorCache[i1].szSpec);
+      }
+    }
+
+    WBFree(pColorCache);
+    pColorCache = NULL;
+  }
+
+  nColorCache = 0;
+  nColorCacheMax = 0;
 }
 
 
@@ -824,6 +860,325 @@ XStandardColormap map;
 }
 
 
+//-------------
+// COLOR CACHE
+//-------------
+
+static WB_UINT32 __internalColorCacheHash(WB_DISPLAY pDisplay, Colormap colormap,
+                                          const char *szSpec, WB_UINT64 ullRGB)
+{
+WB_UINT32 uiRval = 2166136261U; // FNV-1a
+WB_UINT64 ullTemp;
+int i1;
+
+
+  ullTemp = (WB_UINT64)(unsigned long)pDisplay ^ ((WB_UINT64)colormap << 1);
+
+  for(i1=0; i1 < 8; i1++, ullTemp >>= 8)
+  {
+    uiRval = (uiRval ^ (WB_UINT32)(ullTemp & 0xff)) * 16777619U;
+  }
+
+  if(szSpec)
+  {
+    while(*szSpec)
+    {
+      uiRval = (uiRval ^ (unsigned char)*(szSpec++)) * 16777619U;
+    }
+  }
+  else
+  {
+    for(i1=0; i1 < 6; i1++, ullRGB >>= 8)
+    {
+      uiRval = (uiRval ^ (WB_UINT32)(ullRGB & 0xff)) * 16777619U;
+    }
+  }
+
+  return uiRval;
+}
+
+// returns the matching entry, or the unused slot where it belongs.  Table must not be full.
+static INTERNAL_COLOR_CACHE_ENTRY *__internalColorCacheFind(WB_DISPLAY pDisplay, Colormap colormap, WB_UINT32 uiHash,
+                                                            const char *szSpec, WB_UINT64 ullRGB)
+{
+INTERNAL_COLOR_CACHE_ENTRY *pE;
+int iMask = nColorCacheMax - 1;
+int i1;
+
+
+  for(i1=(int)(uiHash & iMask); ; i1 = (i1 + 1) & iMask)
+  {
+    pE = pColorCache + i1;
+
+    if(!pE->pDisplay) // empty slot
+    {
+      return pE;
+    }
+
+    if(pE->uiHash == uiHash && pE->pDisplay == pDisplay && pE->colormap == colormap)
+    {
+      if(szSpec)
+      {
+        if(pE->szSpec && !strcmp(pE->szSpec, szSpec))
+        {
+          return pE;
+        }
+      }
+      else if(!pE->szSpec && pE->ullRGB == ullRGB)
+      {
+        return pE;
+      }
+    }
+  }
+}
+
+// make room for one more entry, growing (and re-hashing) the table as needed to keep the load factor <= 50%
+static int __internalColorCacheReserve(void)
+{
+INTERNAL_COLOR_CACHE_ENTRY *pOld, *pE;
+int i1, nOldMax;
+
+
+  if(pColorCache && (nColorCache + 1) * 2 <= nColorCacheMax)
+  {
+    return 0;
+  }
+
+  pOld = pColorCache;
+  nOldMax = nColorCacheMax;
+
+  nColorCacheMax = nOldMax ? nOldMax * 2 : MINIMUM_COLOR_CACHE_SIZE;
+
+  pColorCache = (INTERNAL_COLOR_CACHE_ENTRY *)WBAlloc(nColorCacheMax * sizeof(*pColorCache));
+
+  if(!pColorCache)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory for color cache\n", __FUNCTION__);
+
+    pColorCache = pOld; // leave the original intact
+    nColorCacheMax = nOldMax;
+
+    return -1;
+  }
+
+  memset(pColorCache, 0, nColorCacheMax * sizeof(*pColorCache));
+
+  for(i1=0; i1 < nOldMax; i1++)
+  {
+    if(pOld[i1].pDisplay)
+    {
+      pE = __internalColorCacheFind(pOld[i1].pDisplay, pOld[i1].colormap, pOld[i1].uiHash,
+                                    pOld[i1].szSpec, pOld[i1].ullRGB);
+      *pE = pOld[i1];
+    }
+  }
+
+  if(pOld)
+  {
+    WBFree(pOld);
+  }
+
+  return 0;
+}
+
+static unsigned long __internalTrueColorChannel(unsigned long lMask, unsigned short *pwValue)
+{
+unsigned long lMax;
+int iShift, iBits;
+
+
+  if(!lMask)
+  {
+    *pwValue = 0;
+    return 0;
+  }
+
+  for(iShift=0; !(lMask & 1); iShift++)
+  {
+    lMask >>= 1;
+  }
+
+  for(iBits=0, lMax=lMask; lMax & 1; iBits++)
+  {
+    lMax >>= 1;
+  }
+
+  if(iBits > 16)
+  {
+    iBits = 16;
+  }
+
+  lMax = (1UL << iBits) - 1;
+
+  // same rounding the X server uses for a TrueColor XAllocColor
+  lMask = ((unsigned long)*pwValue) >> (16 - iBits);
+  *pwValue = (unsigned short)((lMask * 65535UL) / lMax);
+
+  return lMask << iShift;
+}
+
+// for the default colormap on a TrueColor visual the pixel value is entirely determined by the
+// visual's masks, so there is no need to ask the server.  returns non-zero if it did the work.
+static int __internalTrueColorAlloc(WB_DISPLAY pDisplay, Colormap colormap, XColor *pColor)
+{
+Visual *pVisual;
+int iScreen;
+
+
+  iScreen = DefaultScreen(pDisplay);
+
+  if(colormap != DefaultColormap(pDisplay, iScreen))
+  {
+    return 0;
+  }
+
+  pVisual = DefaultVisual(pDisplay, iScreen);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+  if(!pVisual || pVisual->c_class != TrueColor)
+#else // C
+  if(!pVisual || pVisual->class != TrueColor)
+#endif // __cplusplus
+  {
+    return 0;
+  }
+
+  pColor->pixel = __internalTrueColorChannel(pVisual->red_mask, &(pColor->red))
+                | __internalTrueColorChannel(pVisual->green_mask, &(pColor->green))
+                | __internalTrueColorChannel(pVisual->blue_mask, &(pColor->blue));
+
+  return 1;
+}
+
+Status PXM_ParseColor(WB_DISPLAY pDisplay, Colormap colormap, const char *szSpec, XColor *pColor)
+{
+INTERNAL_COLOR_CACHE_ENTRY *pE;
+WB_UINT32 uiHash;
+Status iRval;
+
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+  }
+
+  if(!szSpec || !pColor)
+  {
+    return 0;
+  }
+
+  if(__internalColorCacheReserve()) // memory problem, just do it the old way
+  {
+    BEGIN_XCALL_DEBUG_WRAPPER
+    iRval = XParseColor(pDisplay, colormap, szSpec, pColor);
+    END_XCALL_DEBUG_WRAPPER
+
+    return iRval;
+  }
+
+  uiHash = __internalColorCacheHash(pDisplay, colormap, szSpec, 0);
+  pE = __internalColorCacheFind(pDisplay, colormap, uiHash, szSpec, 0);
+
+  if(pE->pDisplay) // cache hit
+  {
+    pColor->red = pE->clr.red;
+    pColor->green = pE->clr.green;
+    pColor->blue = pE->clr.blue;
+    pColor->flags = pE->clr.flags;
+
+    return 1;
+  }
+
+  BEGIN_XCALL_DEBUG_WRAPPER
+  iRval = XParseColor(pDisplay, colormap, szSpec, pColor);
+  END_XCALL_DEBUG_WRAPPER
+
+  if(iRval) // only cache successful results
+  {
+    pE->szSpec = WBCopyString(szSpec);
+
+    if(pE->szSpec)
+    {
+      pE->pDisplay = pDisplay;
+      pE->colormap = colormap;
+      pE->uiHash = uiHash;
+      pE->ullRGB = 0;
+      pE->clr = *pColor;
+
+      nColorCache++;
+    }
+  }
+
+  return iRval;
+}
+
+Status PXM_AllocColor(WB_DISPLAY pDisplay, Colormap colormap, XColor *pColor)
+{
+INTERNAL_COLOR_CACHE_ENTRY *pE;
+WB_UINT32 uiHash;
+WB_UINT64 ullRGB;
+Status iRval;
+
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+  }
+
+  if(!pColor)
+  {
+    return 0;
+  }
+
+  if(__internalTrueColorAlloc(pDisplay, colormap, pColor))
+  {
+    return 1;
+  }
+
+  ullRGB = ((WB_UINT64)pColor->red << 32) | ((WB_UINT64)pColor->green << 16) | (WB_UINT64)pColor->blue;
+
+  if(__internalColorCacheReserve())
+  {
+    BEGIN_XCALL_DEBUG_WRAPPER
+    iRval = XAllocColor(pDisplay, colormap, pColor);
+    END_XCALL_DEBUG_WRAPPER
+
+    return iRval;
+  }
+
+  uiHash = __internalColorCacheHash(pDisplay, colormap, NULL, ullRGB);
+  pE = __internalColorCacheFind(pDisplay, colormap, uiHash, NULL, ullRGB);
+
+  if(pE->pDisplay) // cache hit
+  {
+    pColor->pixel = pE->clr.pixel;
+    pColor->red = pE->clr.red;
+    pColor->green = pE->clr.green;
+    pColor->blue = pE->clr.blue;
+
+    return 1;
+  }
+
+  BEGIN_XCALL_DEBUG_WRAPPER
+  iRval = XAllocColor(pDisplay, colormap, pColor);
+  END_XCALL_DEBUG_WRAPPER
+
+  if(iRval)
+  {
+    pE->pDisplay = pDisplay;
+    pE->colormap = colormap;
+    pE->uiHash = uiHash;
+    pE->szSpec = NULL;
+    pE->ullRGB = ullRGB;
+    pE->clr = *pColor;
+
+    nColorCache++;
+  }
+
+  return iRval;
+}
+
+
 void PXM_RegisterAppIcons(char *ppRegAppLarge[], char *ppRegAppSmall[])
 {
   ppRegAppLarge_Internal = ppRegAppLarge;
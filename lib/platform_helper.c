@@ -90,6 +90,7 @@
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <sys/param.h> // for MAXPATHLEN and PATH_MAX (also includes limits.h in some cases)
+#include <sys/mman.h>  // for 'mmap' (sub-allocator slabs)
 #ifdef __FreeBSD__
 #include <sys/sysctl.h> // to use the 'sysctlXXX' APIs
 #endif // __FreeBSD__
@@ -103,6 +104,12 @@
 #include "file_help.h"
 //#include "draw_text.h"
 
+#ifdef WB_ALLOC_TRACKING // this file implements them, so don't use the site-tracking macros
+#undef WBAlloc
+#undef WBReAlloc
+#undef WBFree
+#endif // WB_ALLOC_TRACKING
+
 #ifdef HAVE_MALLOC_USABLE_SIZE
 #ifdef __FreeBSD__
 #include <malloc_np.h>
@@ -112,8 +119,8 @@
 #endif // HAVE_MALLOC_USABLE_SIZE
 
 
-#define WB_POINTER_HASH_INITIAL_SIZE 512 /* initial size of pointer hash table for event messages */
-#define WB_HASH_JAM_PREVENTER_SIZE 8192  /* size of hash aging table */
+#define WB_POINTER_HASH_INITIAL_SIZE 512 /* initial size of pointer hash table for event messages, must be a power of 2 */
+#define WB_POINTER_HASH_SWEEP_COUNT 8     /* number of pointer hash slots checked for aging on each create/destroy */
 
 
 static char *pTempFileList = NULL, *pTempFileListEnd = NULL;
@@ -122,7 +129,14 @@ unsigned long cbTempFileList; // size of pointer
 static volatile int fInterlockedRWLockInitFlag = 0;
 static pthread_rwlock_t xInterlockedRWLock;
 
+static unsigned int nAllocSites = 0; // number of recorded allocation sites (see WB_ALLOC_TRACKING)
+
 static void WBFreePointerHashes(void);
+static void __ArenaScratchFree(void);
+static void __ProfileFree(void);
+static void __DebugLogVPrint(const char *szFmt, va_list va);
+static void __DebugLogFree(void);
+static void WBFreeAtoms(void);
 static void __add_to_temp_file_list(const char *szFile);
 
 
@@ -134,6 +148,9 @@ WB_UINT64 iWBDebugLevel = 0; // default is no debug except errors, all subsystem
 // application name (from argv[0])
 static char szAppName[PATH_MAX * 2]="";
 
+// profile trace output file (from '--profile'), written on exit
+static char szProfileTraceFile[PATH_MAX]="";
+
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -353,7 +370,10 @@ char *p1;
     WBFree(pTempFileList);
   }
 
+  WBThreadPoolExit(); // stop worker threads (before anything they might use goes away)
+
   WBFreePointerHashes(); // delete pointer hashes
+  WBFreeAtoms(); // delete internal atoms and the atom cache
 
   // lastly, free up the RWLOCK that I created for RW-locking 'Interlocked' things
 
@@ -363,13 +383,36 @@ char *p1;
     fInterlockedRWLockInitFlag = 0; // by convention, in case I re-init [unlikely]
   }
 
-#ifndef NO_DEBUG // I only do this for builds that have DEBUG capability
+  // if I've done any profiling, write the trace file (if requested) and dump the summary
 
-  // FINALLY, if I've done any debug profiling, dump the profile data
+  bWBProfileEnabled = 0;
+
+  if(szProfileTraceFile[0])
+  {
+    WBProfileExportTrace(szProfileTraceFile);
+  }
 
   WBDumpProfileData(); // this dumps any profile data out to stderr
+  __ProfileFree();
+
+  WBDebugLogStop(); // format anything that's still waiting in the deferred debug log
+  __DebugLogFree();
 
-#endif // NO_DEBUG
+  __ArenaScratchFree(); // the main thread's scratch arena (other threads free theirs on exit)
+
+  // report memory that was never freed, if allocation sites were recorded or memory debugging is on
+
+  if(nAllocSites)
+  {
+    WBAllocLeakReport();
+  }
+  else
+  {
+    WB_IF_DEBUG_LEVEL(DebugLevel_Light | DebugSubSystem_Memory)
+    {
+      WBAllocLeakReport();
+    }
+  }
 }
 
 // NOTE: when this function is called first, the arguments will be parsed in order to obtain
@@ -392,12 +435,14 @@ char **argv_orig = argv;
 static const char * const aszCmdLineOptions[]=
 {
   "help","help-all","debug","subsys","display","minimize","maximize","geometry","no-antialias","no-imagecache",
+  "profile","dispatch-stats","xstats","debug-log",
   NULL // marks end of list
 };
 
 static const uint8_t abCmdLineOptions[]= // NON-ZERO means that it expects a parameter
 {
   0, 0, 1, 1, 1, 0, 0, 1, 0, 0,
+  1, 1, 0, 1,
   0
 };
 
@@ -424,7 +469,11 @@ enum
     option_maximize,
     option_geometry,
     option_no_antialias,
-    option_no_image_cache
+    option_no_image_cache,
+    option_profile,
+    option_dispatch_stats,
+    option_xstats,
+    option_debug_log
 };
 
   // grab the name of the program and cache it.  I'll need the path info.
@@ -639,6 +688,63 @@ help_exit: // go here if I displayed help and don't want a 'usage()'
               __internal_disable_imagecache();
               break;
 
+            case option_profile: // enable profiling now, write the trace file on exit
+              if(*szVal == '=')
+              {
+                szVal++;
+              }
+
+              if(!*szVal)
+              {
+                WBDebugPrint("The '--profile' option requires an output file name\n");
+                goto argument_error_exit;
+              }
+
+              strlcpy(szProfileTraceFile, szVal, sizeof(szProfileTraceFile));
+              WBProfileEnable(1);
+              break;
+
+            case option_dispatch_stats: // periodic dump of the dispatch latency statistics
+              if(*szVal == '=')
+              {
+                szVal++;
+              }
+
+              i2 = atoi(szVal);
+
+              if(*szVal < '0' || *szVal > '9' || i2 <= 0)
+              {
+                WBDebugPrint("Invalid '--dispatch-stats' interval %s - must be a number of seconds\n", szVal);
+                goto argument_error_exit;
+              }
+
+              WBDispatchStatsSetDumpInterval(i2);
+              break;
+
+            case option_xstats: // X request statistics, reported by WBExit()
+              WBXCallStatsEnable(1);
+              break;
+
+            case option_debug_log: // deferred (binary) debug output, formatted by a background thread
+              if(*szVal == '=')
+              {
+                szVal++;
+              }
+
+              if(!*szVal)
+              {
+                WBDebugPrint("The '--debug-log' option requires an output file name (or '-' for stderr)\n");
+                goto argument_error_exit;
+              }
+
+              if(WBDebugLogStart(szVal))
+              {
+                WBDebugPrint("Unable to start the debug log on %s\n", szVal);
+                goto argument_error_exit;
+              }
+
+              break;
+
             default:
               WB_ERROR_PRINT("%s.%d - Internal error - unrecognized option: --%s\n",
                              __FUNCTION__, __LINE__, szArg);
@@ -826,6 +932,14 @@ void WBToolkitUsage(void)
         "                 A bit value of 1 is equivalent to the lowest subsystem bit\n"
         "                 NOTE:  this option can be specified multiple times\n"
         "                 (You can specify '--subsys help' to get a list of subsystems)\n"
+        "--profile file   enable profiling, and on exit write a Chrome trace (JSON) to\n"
+        "                 'file' and a profile summary to stderr\n"
+        "--dispatch-stats n  dump event dispatch latency statistics to stderr\n"
+        "                 every 'n' seconds\n"
+        "--xstats         count X requests and round trips for each call site, and\n"
+        "                 report them to stderr on exit\n"
+        "--debug-log file  record debug output in binary form, and format it on a\n"
+        "                 background thread to 'file' ('-' for stderr)\n"
         "    SPECIAL OPTIONS\n"
         "--no-antialias   Disable anti-aliasing (may improve UI performance)\n"
         "--no-imagecache  Disable internal image cache for window paint/expose\n"
@@ -900,10 +1014,15 @@ va_list va;
 
   va_start(va, fmt);
 
-  vfprintf(stderr, fmt, va);
-  fflush(stderr); // dump NOW before (possibly) crashing
-
-  // TODO:  log file?
+  if(WB_UNLIKELY(bWBDebugLogEnabled))
+  {
+    __DebugLogVPrint(fmt, va); // queued for the deferred debug log's background thread
+  }
+  else
+  {
+    vfprintf(stderr, fmt, va);
+    fflush(stderr); // dump NOW before (possibly) crashing
+  }
 
   va_end(va);
 }
@@ -951,7 +1070,20 @@ static const int nCols = 16;
   WBDebugPrint("==========================================================================================\n");
 }
 
-#ifndef NO_DEBUG
+//////////////////////////////////////////////////////////////////////////////
+// PROFILER
+//
+// Each thread that records profile events gets its own ring buffer, allocated the first time it records
+// an event, so recording never needs a lock.  The ring buffers stay on 'pProfileThreads' until exit, even
+// after their thread ends, so that the events can still be exported and summarized.  Time stamps are raw
+// TSC values on x86 (calibrated against CLOCK_MONOTONIC when they are converted), nanoseconds otherwise.
+//////////////////////////////////////////////////////////////////////////////
+
+#define PROFILE_RING_SIZE  65536 /* events per thread, must be a power of 2 */
+#define PROFILE_MAX_DEPTH  256   /* maximum nesting depth when matching begin/end events */
+
+#define PROFILE_EVENT_BEGIN 0
+#define PROFILE_EVENT_END   1
 
 typedef struct __profile_info__
 {
@@ -959,5145 +1091,9630 @@ typedef struct __profile_info__
   const char *szFunction;
   const char *szName;
   const char *szDesc;
-#ifdef HAS_WB_UINT64_BUILTIN
-  WB_INT64 nLine; // for better alignment, assuming 64-bit pointers
-  WB_UINT64 nTime;
-  WB_INT64 nCount;
-  WB_INT64 nReserved; // for alignment
-#else // HAS_WB_UINT64_BUILTIN
-  WB_INT32 nLine;
-  WB_UINT32 nTime;
-  WB_INT32 nCount;
-  WB_INT32 nReserved; // for alignment
-#endif // HAS_WB_UINT64_BUILTIN
+  int nLine;
 } PROFILE_INFO;
 
+typedef struct __profile_event__
+{
+  WB_UINT64 tStamp; // raw time stamp from __ProfileTimeStamp()
+  WB_UINT32 nID;    // profile variable ID (index into 'paProfileInfo')
+  WB_UINT32 iType;  // PROFILE_EVENT_BEGIN or PROFILE_EVENT_END
+} PROFILE_EVENT;
+
+typedef struct __profile_thread__
+{
+  struct __profile_thread__ *pNext; // next in 'pProfileThreads'
+  int nThread;                      // sequential thread number, used as the 'tid' in the trace output
+  volatile WB_UINT64 nWrite;        // total events written.  the next one goes at 'nWrite & (PROFILE_RING_SIZE - 1)'
+  volatile WB_UINT64 nStart;        // events before this one were discarded by WBProfileReset()
+  PROFILE_EVENT aEvents[PROFILE_RING_SIZE];
+} PROFILE_THREAD;
+
+typedef struct __profile_totals__
+{
+  int nID;
+  WB_UINT64 nCount, tTotal, tSelf, tMax; // in raw time stamp units
+} PROFILE_TOTALS;
+
+typedef void (*PROFILE_SCOPE_CALLBACK)(void *pCtx, const PROFILE_THREAD *pT, int nID,
+                                       WB_UINT64 tBegin, WB_UINT64 tEnd, WB_UINT64 tChildren);
+
+volatile int bWBProfileEnabled = 0;
+
+static pthread_mutex_t xProfileMutex = PTHREAD_MUTEX_INITIALIZER; // protects everything below
 static PROFILE_INFO *paProfileInfo = NULL;
 static int nProfileInfo = 0, nMaxProfileInfo = 0;
+static PROFILE_THREAD *pProfileThreads = NULL;
+static int nProfileThreads = 0;
+static WB_UINT64 tProfileBase = 0, nsProfileBase = 0; // time stamp and CLOCK_MONOTONIC when profiling was first enabled
 
-int WBRegisterProfileVar(const char *szFile, int nLine, const char *szFunction, const char *szName, const char *szDesc)
+static pthread_key_t keyProfileThread;
+static pthread_once_t xProfileOnce = PTHREAD_ONCE_INIT;
+static int bProfileKey = 0;
+
+
+static __inline__ WB_UINT64 __ProfileTimeStamp(void)
 {
-int iRval;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+unsigned int uiLow, uiHigh;
 
-  if(WB_UNLIKELY(!paProfileInfo))
-  {
-    nMaxProfileInfo = 256;
-    paProfileInfo = (PROFILE_INFO *)WBAlloc((nMaxProfileInfo + 1) * sizeof(*paProfileInfo));
-    if(!paProfileInfo)
-    {
-      return -1; // an error
-    }
+  __asm__ __volatile__ ("rdtsc" : "=a" (uiLow), "=d" (uiHigh)); // constant-rate and synchronized across cores on current CPUs
 
-    bzero(paProfileInfo, (nMaxProfileInfo + 1) * sizeof(*paProfileInfo)); // make sure
-  }
-  else if(WB_UNLIKELY((nProfileInfo + 1) >= nMaxProfileInfo))
+  return ((WB_UINT64)uiHigh << 32) | uiLow;
+#else // other architectures and compilers
+  return WBGetMonotonicTimeNS();
+#endif // __GNUC__ on x86
+}
+
+// 'tBase' and 'nsBase' are a time stamp and CLOCK_MONOTONIC value that were read at the same time
+static double __ProfileTicksPerMicrosecond(WB_UINT64 tBase, WB_UINT64 nsBase)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+WB_UINT64 tNow, nsNow;
+
+
+  nsNow = WBGetMonotonicTimeNS();
+
+  if(nsNow - nsBase < 10000000) // measure over at least 10msec for a reasonable calibration
   {
-    void *pTemp;
+    usleep((useconds_t)((10000000 - (nsNow - nsBase)) / 1000) + 1);
+  }
 
-    int nOldMaxProfileInfo = nMaxProfileInfo;
+  nsNow = WBGetMonotonicTimeNS();
+  tNow = __ProfileTimeStamp();
 
-    nMaxProfileInfo = (nProfileInfo + 258) & 0xffffff00; // make it 256 bigger
+  return (double)(tNow - tBase) * 1000.0 / (double)(nsNow - nsBase);
+#else // other architectures and compilers
+  return 1000.0; // time stamps are already in nanoseconds
+#endif // __GNUC__ on x86
+}
 
-    pTemp = WBReAlloc(paProfileInfo, (nMaxProfileInfo + 1) * sizeof(*paProfileInfo));
+// the calibration for the profile time stamps.  this may sleep (see __ProfileTicksPerMicrosecond)
+// so it must be called BEFORE locking 'xProfileMutex'
+static double __ProfileTicks(void)
+{
+WB_UINT64 tBase, nsBase;
 
-    if(WB_UNLIKELY(!pTemp))
-    {
-      nMaxProfileInfo = nOldMaxProfileInfo;
-      return -1; // an error
-    }
 
-    paProfileInfo = (PROFILE_INFO *)pTemp; // now is permanent
-    bzero(paProfileInfo + nOldMaxProfileInfo,
-          (nMaxProfileInfo + 1 - nOldMaxProfileInfo) * sizeof(*paProfileInfo)); // the size of the new block
-  }
+  pthread_mutex_lock(&xProfileMutex);
 
-  iRval = nProfileInfo++;
+  tBase = tProfileBase;
+  nsBase = nsProfileBase;
 
-  paProfileInfo[iRval].szFile = szFile;
-  paProfileInfo[iRval].szFunction = szFunction;
-  paProfileInfo[iRval].szName = szName;
-  paProfileInfo[iRval].szDesc = szDesc;
-  paProfileInfo[iRval].nLine = nLine;
+  pthread_mutex_unlock(&xProfileMutex);
 
-  paProfileInfo[iRval].nTime = 0;
-  paProfileInfo[iRval].nCount = 0;
+  return nsBase ? __ProfileTicksPerMicrosecond(tBase, nsBase) : 1000.0;
+}
 
-  return iRval;
+static void __ProfileKeyInit(void)
+{
+  bProfileKey = !pthread_key_create(&keyProfileThread, NULL); // the ring buffers belong to 'pProfileThreads'
 }
 
-void WBStartProfile(int nProfileID)
+static PROFILE_THREAD * __ProfileThread(void)
 {
-  if(WB_UNLIKELY(nProfileID < 0 || !paProfileInfo || nProfileID >= nMaxProfileInfo))
+PROFILE_THREAD *pRval;
+
+
+  if(WB_UNLIKELY(!bProfileKey))
+  {
+    return NULL;
+  }
+
+  pRval = (PROFILE_THREAD *)pthread_getspecific(keyProfileThread);
+
+  if(WB_LIKELY(pRval != NULL))
   {
-    return; // bogus
+    return pRval;
   }
 
-  if(paProfileInfo[nProfileID].nCount >= 0) // this detects 'out of order' invocation
+  pRval = (PROFILE_THREAD *)WBAlloc(sizeof(*pRval));
+
+  if(!pRval)
   {
-    paProfileInfo[nProfileID].nTime -= WBGetTimeIndex();
-    paProfileInfo[nProfileID].nCount = -(paProfileInfo[nProfileID].nCount + 1);
+    return NULL;
   }
+
+  pRval->nWrite = 0; // the events themselves don't need initializing
+  pRval->nStart = 0;
+
+  pthread_mutex_lock(&xProfileMutex);
+
+  pRval->nThread = ++nProfileThreads;
+  pRval->pNext = pProfileThreads;
+  pProfileThreads = pRval;
+
+  pthread_mutex_unlock(&xProfileMutex);
+
+  pthread_setspecific(keyProfileThread, pRval);
+
+  return pRval;
 }
 
-void WBStopProfile(int nProfileID)
+static __inline__ void __ProfileEvent(int nProfileID, unsigned int iType, WB_UINT64 tStamp)
 {
-  if(WB_UNLIKELY(nProfileID < 0 || !paProfileInfo || nProfileID >= nMaxProfileInfo))
+PROFILE_THREAD *pT;
+PROFILE_EVENT *pE;
+
+
+  if(WB_UNLIKELY(nProfileID < 0 || !bWBProfileEnabled))
   {
-    return; // bogus
+    return;
   }
 
-  if(paProfileInfo[nProfileID].nCount < 0) // this detects 'out of order' invocation
+  pT = __ProfileThread();
+
+  if(WB_UNLIKELY(!pT))
   {
-    paProfileInfo[nProfileID].nTime += WBGetTimeIndex();
-    paProfileInfo[nProfileID].nCount = -(paProfileInfo[nProfileID].nCount);
+    return;
   }
+
+  pE = pT->aEvents + (pT->nWrite & (PROFILE_RING_SIZE - 1));
+
+  pE->tStamp = tStamp;
+  pE->nID = (WB_UINT32)nProfileID;
+  pE->iType = iType;
+
+  WB_MEMORY_BARRIER(); // the event is visible to other threads before 'nWrite' is
+
+  pT->nWrite++; // the event is complete; only the owning thread writes this
 }
 
-void WBDumpProfileData(void)
+// walk one thread's events, calling 'pCallback' for every scope that has both a begin and an end.
+// an 'end' without a matching 'begin' (overwritten, or out of order) is ignored, and a 'begin'
+// without a matching 'end' is dropped when an outer scope ends.  'xProfileMutex' must be locked.
+//
+// the owning thread may still be recording, and overwriting the oldest events while they're read.
+// each event is copied, and then 'nWrite' is checked again to see whether its slot has been re-used.
+// the slot for event 'nWrite' (not counted yet) may already be partly written, so it's skipped too.
+static void __ProfileWalkThread(const PROFILE_THREAD *pT, PROFILE_SCOPE_CALLBACK pCallback, void *pCtx)
 {
-int i1, bNotYet = 1;
+struct
+{
+  int nID;
+  WB_UINT64 tBegin, tChildren;
+} aStack[PROFILE_MAX_DEPTH];
+PROFILE_EVENT xE;
+WB_UINT64 n1, nFirst, nWrite, tDuration;
+int i1, iDepth;
+
+
+  nWrite = pT->nWrite; // snapshot; events recorded after this aren't included
+
+  WB_MEMORY_BARRIER(); // read the events after 'nWrite'
 
-  if(!paProfileInfo)
+  nFirst = nWrite > PROFILE_RING_SIZE ? nWrite - PROFILE_RING_SIZE : 0;
+
+  if(nFirst < pT->nStart)
   {
-    return;
+    nFirst = pT->nStart;
   }
 
-  for(i1=0; i1 < nProfileInfo; i1++)
+  for(n1=nFirst, iDepth=0; n1 < nWrite; n1++)
   {
-    if(WB_UNLIKELY(paProfileInfo[i1].nCount == 0))
+    memcpy(&xE, (const void *)(pT->aEvents + (n1 & (PROFILE_RING_SIZE - 1))), sizeof(xE));
+
+    WB_MEMORY_BARRIER(); // re-check 'nWrite' after the copy
+
+    if(n1 + PROFILE_RING_SIZE <= pT->nWrite + 1) // overwritten (or being overwritten) while it was read
     {
-      continue; // skip it
+      continue;
     }
 
-    // in the unlikely event that i just bailed out in the middle of a profiled function
-    if(WB_UNLIKELY(paProfileInfo[i1].nCount < 0)) // this detects I didn't call WBStopProfile() yet...
+
+    if(xE.iType == PROFILE_EVENT_BEGIN)
     {
-      paProfileInfo[i1].nTime += WBGetTimeIndex();
-      paProfileInfo[i1].nCount = -(paProfileInfo[i1].nCount);
+      if(iDepth < PROFILE_MAX_DEPTH)
+      {
+        aStack[iDepth].nID = (int)xE.nID;
+        aStack[iDepth].tBegin = xE.tStamp;
+        aStack[iDepth].tChildren = 0;
+      }
+
+      iDepth++; // scopes nested deeper than PROFILE_MAX_DEPTH are counted, but not recorded
+      continue;
     }
 
-    if(WB_UNLIKELY(bNotYet))
+    if(iDepth > PROFILE_MAX_DEPTH)
     {
-      WBDebugPrint("\n** PROFILE INFO **\n");
-      bNotYet = 0;
+      iDepth--;
+      continue;
     }
 
-    WBDebugPrint("%s : %-8d %s\n    %s  %s\n"
-#ifdef HAS_WB_UINT64_BUILTIN
-                 "    nCount = %lld\n"
-                 "    nTime = %llu microseconds\n"
-#else // HAS_WB_UINT64_BUILTIN
-                 "    nCount = %ld\n"
-                 "    nTime = %lu microseconds\n"
-#endif // HAS_WB_UINT64_BUILTIN
-                 "    Average microseconds per count:  %0.1f\n\n",
-                 paProfileInfo[i1].szFile,
-                 (int)paProfileInfo[i1].nLine,
-                 paProfileInfo[i1].szFunction,
-                 paProfileInfo[i1].szName,
-                 paProfileInfo[i1].szDesc,
-                 paProfileInfo[i1].nCount,
-                 paProfileInfo[i1].nTime,
-                 (double)paProfileInfo[i1].nTime / (double)paProfileInfo[i1].nCount);
-  }
-
-  WBFree(paProfileInfo);
-  paProfileInfo = NULL; // by convention
-  nProfileInfo = 0;
-  nMaxProfileInfo = 0; // these too
-}
+    for(i1=iDepth - 1; i1 >= 0 && aStack[i1].nID != (int)xE.nID; i1--)
+    {
+      // find the matching 'begin'
+    }
 
-#endif // NO_DEBUG
+    if(i1 < 0)
+    {
+      continue;
+    }
 
+    iDepth = i1;
+    tDuration = xE.tStamp - aStack[i1].tBegin;
 
-//////////////////////////////////////////////////////////////////////////////
-//                                                                          //
-//      ____               _                     _   _  _    _  _           //
-//     / ___|  _   _  ___ | |_  ___  _ __ ___   | | | || |_ (_)| | ___      //
-//     \___ \ | | | |/ __|| __|/ _ \| '_ ` _ \  | | | || __|| || |/ __|     //
-//      ___) || |_| |\__ \| |_|  __/| | | | | | | |_| || |_ | || |\__ \     //
-//     |____/  \__, ||___/ \__|\___||_| |_| |_|  \___/  \__||_||_||___/     //
-//             |___/                                                        //
-//                                                                          //
-//////////////////////////////////////////////////////////////////////////////
+    pCallback(pCtx, pT, aStack[i1].nID, aStack[i1].tBegin, xE.tStamp, aStack[i1].tChildren);
 
-#define FOUR_HUNDRED_YEARS (400 * 365 + 24 * 4 + 1)
-static int  total_days[13]={0,31,59,90,120,151,181,212,243,273,304,334,365};
-static int  total_leap[13]={0,31,60,91,121,152,182,213,244,274,305,335,366};
-static WB_TIME epoch_time = 25568; // 1900-based date offset from epoch
+    if(i1 > 0)
+    {
+      aStack[i1 - 1].tChildren += tDuration;
+    }
+  }
+}
 
-WB_TIME WBGetSystemTime(void)
+static void __ProfileFree(void)
 {
-#if defined(WIN32)
+PROFILE_THREAD *pT;
 
-#ifdef _USE_32BIT_TIME_T /* see time.h */
-#error you must not use 32-bit time_t value, use 64-bit only
-#endif // _USE_32BIT_TIME_T
 
-SYSTEMTIME st;
-int64_t l1;
-int n_years;
-long adjustment;
+  bWBProfileEnabled = 0;
 
+  pthread_mutex_lock(&xProfileMutex);
 
-   GetSystemTime(&st);
+  while((pT = pProfileThreads) != NULL)
+  {
+    pProfileThreads = pT->pNext;
+    WBFree(pT);
+  }
 
-    // convert to days since 1/1/1970
+  if(bProfileKey)
+  {
+    pthread_setspecific(keyProfileThread, NULL); // the calling thread's (other threads must not record any more)
+  }
 
-   n_years = st.wYear - 1900;    /* # of years since 1900 */
-   adjustment = 0;
+  if(paProfileInfo)
+  {
+    WBFree(paProfileInfo);
+    paProfileInfo = NULL; // by convention
+  }
 
-   while(n_years<0)
-   {
-      n_years += 400;                       /* add 400 years */
-      adjustment -= FOUR_HUNDRED_YEARS;    /* number of days in 400 years */
-   }
+  nProfileInfo = 0;
+  nMaxProfileInfo = 0; // these too
 
-   while(n_years >=400)
-   {
-      n_years -= 400;
-      adjustment += FOUR_HUNDRED_YEARS;
-   }
-      /*    CALCULATE THE TOTAL NUMBER OF DAYS UP TO 1/1 THIS YEAR    */
-      /* terms:  # of days + # of "Feb/29"s - # of non-leap centuries */
+  pthread_mutex_unlock(&xProfileMutex);
+}
 
-   l1 = 365L * n_years + ((n_years > 4)?((n_years - 1) >> 2):0)
-        + ((n_years > 100)?(1 - (n_years - 1)/ 100):0);
+int WBRegisterProfileVar(int *pnProfileID, const char *szFile, WB_INT32 nLine, const char *szFunction,
+                         const char *szName, const char *szDesc)
+{
+PROFILE_INFO *pTemp;
+int iRval;
 
-   if(((st.wYear % 400)==0 || (st.wYear % 100)!=0) && (st.wYear % 4)==0)
-      l1 += total_leap[st.wMonth - 1];    /* month-to-date totals (leap year) */
-   else
-      l1 += total_days[st.wMonth - 1];    /* month-to-date totals */
 
-   l1 += st.wDay + adjustment; // days since 1/1/1900 (a '1')
+  pthread_mutex_lock(&xProfileMutex);
 
-   // convert to days since epoch (1/1/1970, a '1')
-   l1 -= epoch_time;
+  iRval = *pnProfileID;
 
-   // convert to seconds (00:00:00 AM UTC)
-   l1 *= 86400;
+  if(iRval < 0) // another thread may have registered it while I waited for the lock
+  {
+    if(WB_UNLIKELY(nProfileInfo >= nMaxProfileInfo))
+    {
+      pTemp = (PROFILE_INFO *)WBAlloc((nMaxProfileInfo + 256) * sizeof(*paProfileInfo));
 
-   return (WB_TIME)l1;
-#elif __SIZEOF_LONG__ <= 4 // !WIN32, 32-bit time_t
+      if(!pTemp)
+      {
+        pthread_mutex_unlock(&xProfileMutex);
 
-#ifndef NO_DEBUG
-#warning 32-bit time_t is only valid until 2038 - use 64-bit OS to avoid Y2K38
-#warning rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
-#endif
-//
-// TODO - rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
-struct timeval tv;
+        return -1; // an error
+      }
 
-  // 32-bit time_t - rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
+      if(paProfileInfo)
+      {
+        memcpy(pTemp, paProfileInfo, nProfileInfo * sizeof(*paProfileInfo));
+        WBFree(paProfileInfo);
+      }
 
-  gettimeofday(&tv, NULL); // for now, just use this.
+      paProfileInfo = pTemp;
+      nMaxProfileInfo += 256;
+    }
 
-  return (WB_TIME)tv.tv_sec;
-#else // 64-bit time_t, !WIN32
-struct timeval tv;
+    iRval = nProfileInfo++;
 
-  gettimeofday(&tv, NULL);
+    paProfileInfo[iRval].szFile = szFile;
+    paProfileInfo[iRval].szFunction = szFunction;
+    paProfileInfo[iRval].szName = szName;
+    paProfileInfo[iRval].szDesc = szDesc;
+    paProfileInfo[iRval].nLine = (int)nLine;
 
-  return (WB_TIME)tv.tv_sec;
-#endif // WIN32
-}
+    *pnProfileID = iRval;
+  }
 
+  pthread_mutex_unlock(&xProfileMutex);
 
-#if defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
-WB_UINT64 WBGetTimeIndex(void)
-#else // !defined(HAS_WB_UINT64_BUILTIN) && !defined(__DOXYGEN__)
-WB_UINT32 WBGetTimeIndex(void)
-#endif // defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
-{
-#ifdef WIN32
-SYSTEMTIME st;
-int64_t l1;
-int n_years;
-long adjustment;
+  return iRval;
+}
 
+void WBStartProfile(int nProfileID)
+{
+  __ProfileEvent(nProfileID, PROFILE_EVENT_BEGIN, __ProfileTimeStamp());
+}
 
-   GetSystemTime(&st);
-
-    // convert to days since 1/1/1970
-
-   n_years = st.wYear - 1900;    /* # of years since 1900 */
-   adjustment = 0;
-
-   while(n_years<0)
-   {
-      n_years += 400;                       /* add 400 years */
-      adjustment -= FOUR_HUNDRED_YEARS;    /* number of days in 400 years */
-   }
-
-   while(n_years >=400)
-   {
-      n_years -= 400;
-      adjustment += FOUR_HUNDRED_YEARS;
-   }
-      /*    CALCULATE THE TOTAL NUMBER OF DAYS UP TO 1/1 THIS YEAR    */
-      /* terms:  # of days + # of "Feb/29"s - # of non-leap centuries */
-
-   l1 = 365L * n_years + ((n_years > 4)?((n_years - 1) >> 2):0)
-        + ((n_years > 100)?(1 - (n_years - 1)/ 100):0);
-
-   if(((st.wYear % 400)==0 || (st.wYear % 100)!=0) && (st.wYear % 4)==0)
-      l1 += total_leap[st.wMonth - 1];    /* month-to-date totals (leap year) */
-   else
-      l1 += total_days[st.wMonth - 1];    /* month-to-date totals */
+void WBStopProfile(int nProfileID)
+{
+  __ProfileEvent(nProfileID, PROFILE_EVENT_END, __ProfileTimeStamp());
+}
 
-   l1 += st.wDay + adjustment; // days since 1/1/1900 (a '1')
+void WBProfileEnable(int bEnable)
+{
+  if(bEnable)
+  {
+    pthread_once(&xProfileOnce, __ProfileKeyInit);
 
-   // convert to days since epoch (1/1/1970, a '1')
-   l1 -= epoch_time;
+    pthread_mutex_lock(&xProfileMutex);
 
-   // convert to seconds (00:00:00 AM UTC)
-   l1 *= 86400;
+    if(!nsProfileBase) // the calibration base stays the same from now on
+    {
+      nsProfileBase = WBGetMonotonicTimeNS();
+      tProfileBase = __ProfileTimeStamp();
+    }
 
-   // adjust for UTC time
-   l1 += st.wHour * 3600L + st.wMinute * 60L + st.wSecond;
+    pthread_mutex_unlock(&xProfileMutex);
+  }
 
-   // conver to mucroseconds
-   l1 *= 1000000L;
+  bWBProfileEnabled = bEnable ? 1 : 0;
+}
 
-   // add milliseconds from 'st' a microseconds
-   l1 += st.wMilliseconds * 1000L;
+void WBProfileReset(void)
+{
+PROFILE_THREAD *pT;
 
-   return (WB_UINT64)l1;
-#elif __SIZEOF_LONG__ <= 4 // !WIN32, 32-bit time_t, no support for 64-bit inmteger
-#if defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
-//
-// TODO - rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
-struct timeval tv;
 
-  gettimeofday(&tv, NULL); // for now, just use this.
+  pthread_mutex_lock(&xProfileMutex);
 
-  return (WB_UINT64)tv.tv_sec * (WB_UINT64)1000000
-         + (WB_UINT64)tv.tv_usec;
-#else /// HAS_WB_UINT64_BUILTIN
-struct timeval tv;
+  for(pT=pProfileThreads; pT; pT=pT->pNext)
+  {
+    pT->nStart = pT->nWrite;
+  }
 
-  double d1;
-  gettimeofday(&tv, NULL);
+  pthread_mutex_unlock(&xProfileMutex);
+}
 
-  d1 = tv.tv_sec * 1000000.0;
-  d1 += tv.tv_usec;
+typedef struct __profile_trace_context__
+{
+  FILE *pOut;
+  int nPID;
+  double dTicks; // time stamp ticks per microsecond
+} PROFILE_TRACE_CONTEXT;
 
-  return (WB_UINT32)floor(fmod(d1, (double)0xffffffff));
-#endif // HAS_WB_UINT64_BUILTIN
-#else // 64-bit time_t, !WIN32
-struct timeval tv;
+static void __ProfileWriteJSONString(FILE *pOut, const char *szText)
+{
+  fputc('"', pOut);
 
-  gettimeofday(&tv, NULL);
+  for(; szText && *szText; szText++)
+  {
+    if(*szText == '"' || *szText == '\\')
+    {
+      fputc('\\', pOut);
+      fputc(*szText, pOut);
+    }
+    else if((unsigned char)*szText < ' ')
+    {
+      fprintf(pOut, "\\u%04x", (unsigned char)*szText);
+    }
+    else
+    {
+      fputc(*szText, pOut);
+    }
+  }
 
-  return (WB_UINT64)tv.tv_sec * (WB_UINT64)1000000
-         + (WB_UINT64)tv.tv_usec;
-#endif // WIN32
+  fputc('"', pOut);
 }
 
-void WBDelay(uint32_t uiDelay)  // approximate delay for specified period (in microseconds).  may be interruptible
+static void __ProfileTraceCallback(void *pCtx, const PROFILE_THREAD *pT, int nID,
+                                   WB_UINT64 tBegin, WB_UINT64 tEnd, WB_UINT64 tChildren)
 {
-#ifdef WIN32
-  if(uiDelay <= 1000)
-    Sleep(1);
-  else
-    Sleep(uiDelay / 1000);
-#else // WIN32
-#ifdef HAVE_NANOSLEEP
-struct timespec tsp;
+PROFILE_TRACE_CONTEXT *pTC = (PROFILE_TRACE_CONTEXT *)pCtx;
 
-  if(WB_UNLIKELY(uiDelay >= 1000000L))
-  {
-    tsp.tv_sec = uiDelay / 1000000L;
-    uiDelay = uiDelay % 1000000L; // number of microseconds converted to nanoseconds
-  }
-  else
+
+  if(nID >= nProfileInfo) // registered before the last '__ProfileFree()'
   {
-    tsp.tv_sec = 0; // it's assumed that this method is slightly faster
+    return;
   }
 
-  tsp.tv_nsec = uiDelay * 1000;  // wait for .1 msec
+  fputs(",\n{\"name\":", pTC->pOut);
+  __ProfileWriteJSONString(pTC->pOut, paProfileInfo[nID].szName);
+  fputs(",\"cat\":", pTC->pOut);
+  __ProfileWriteJSONString(pTC->pOut, paProfileInfo[nID].szFunction);
 
-  nanosleep(&tsp, NULL);
-#else  // HAVE_NANOSLEEP
+  // 'complete' events, so that they need not be sorted, with times in microseconds
 
-  usleep(uiDelay);  // 100 microsecs - a POSIX alternative to 'nanosleep'
+  fprintf(pTC->pOut, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"desc\":",
+          (double)(WB_INT64)(tBegin - tProfileBase) / pTC->dTicks,
+          (double)(tEnd - tBegin) / pTC->dTicks,
+          pTC->nPID, pT->nThread);
 
-#endif // HAVE_NANOSLEEP
-#endif // WIN32
+  __ProfileWriteJSONString(pTC->pOut, paProfileInfo[nID].szDesc);
+  fputs("}}", pTC->pOut);
 }
 
-int WBCPUCount(void)
+int WBProfileExportTrace(const char *szFileName)
 {
-// determine # of CPUs to get the default # of jobs during compile
-//    FreeBSD:  sysctl vars:  kern.smp.cpus hw.ncpu  (both have the correct count, even in a VM)
-//    Linux:  /proc/cpuinfo - filter on 'processor:', one line per active core
-//                            (in a VM, only the assigned cores show up, so count them)
-int iCPU = 0;
+PROFILE_TRACE_CONTEXT ctx;
+PROFILE_THREAD *pT;
+int iRval;
 
-#if defined(__FreeBSD__)
-// TODO:  a config option to test for 'sysctlbyname' and the sys/sysctl.h file?
-unsigned long cb;
 
-  cb = sizeof(iCPU);
-  iCPU = 0;
-  if(sysctlbyname("hw.ncpu", &iCPU, &cb, NULL, 0)) // could also use MIBs CTL_HW and HW_NCPU
+  ctx.pOut = fopen(szFileName, "w");
+
+  if(!ctx.pOut)
   {
-//    WB_ERROR_PRINT("ERROR - %s - hw.ncpu, errno=%d  iCPU=%d  cb=%ld\n", __FUNCTION__, errno, iCPU, cb);
-    cb = sizeof(iCPU);
-    iCPU = 0;
+    WB_ERROR_PRINT("ERROR:  %s - unable to create \"%s\", errno=%d\n", __FUNCTION__, szFileName, errno);
 
-    if(sysctlbyname("kern.smp.cpus", &iCPU, &cb, NULL, 0)) // could also use MIBs CTL_HW and HW_NCPU
-    {
-//      WB_ERROR_PRINT("ERROR - %s - kernel.smp.cpus, errno=%d  iCPU=%d  cb=%ld\n", __FUNCTION__, errno, iCPU, cb);
-      return 0;
-    }
+    return -1;
   }
 
-//  WB_ERROR_PRINT("TEMPORARY:  %s - iCPU=%d\n", __FUNCTION__, iCPU);
-
-  return iCPU;
+  ctx.nPID = (int)getpid();
+  ctx.dTicks = __ProfileTicks();
 
-#elif defined(linux)
+  pthread_mutex_lock(&xProfileMutex);
 
-FILE *pF;
-char tbuf[256];
-char *p1, *p2;
+  fprintf(ctx.pOut, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":",
+          ctx.nPID);
+  __ProfileWriteJSONString(ctx.pOut, szAppName);
+  fputs("}}", ctx.pOut);
 
-  pF = fopen("/proc/cpuinfo", "r");
-  if(pF)
+  for(pT=pProfileThreads; pT; pT=pT->pNext)
   {
-    while(fgets(tbuf, sizeof(tbuf), pF))
-    {
-      // read each line, then scan for 'processor' and cound 'em up
-      // NOTE:  if there's a better way, I'd like to see it...
-
-      p1 = tbuf;
-      while(*p1 && *p1 <= ' ')
-      {
-        p1++; // skip leadin white space
-      }
-
-      p2 = p1 + strlen(p1);
-      while(p2 > p1 && *(p2 - 1) <= ' ')
-      {
-        *(--p2) = 0; // trim trailing white space
-      }
-
-      if(!strncmp(p1, "processor", 9) &&  // TODO:  check it's unique?
-         p1[9] && p1[9] <= ' ') // typically is followed by a tab then ':'
-      {
-        iCPU++; // count them!
-      }
-    }
+    fprintf(ctx.pOut, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+            ctx.nPID, pT->nThread, pT->nThread);
 
-    fclose(pF);
+    __ProfileWalkThread(pT, __ProfileTraceCallback, &ctx);
   }
 
-#elif defined(WIN32)
-  iCPU == 0; // just fail (for now)
-#else
-  iCPU == 0; // just fail
-#endif // all of that
+  pthread_mutex_unlock(&xProfileMutex);
 
-  return iCPU;
-}
+  fputs("\n]}\n", ctx.pOut);
 
+  iRval = ferror(ctx.pOut) ? -1 : 0;
 
+  if(fclose(ctx.pOut) || iRval)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - error writing \"%s\"\n", __FUNCTION__, szFileName);
 
+    return -1;
+  }
 
-//////////////////////////////////////////////////////////////////////////////
-//                                                                          //
-//                __  __     _     _      _      ___    ____                //
-//               |  \/  |   / \   | |    | |    / _ \  / ___|               //
-//               | |\/| |  / _ \  | |    | |   | | | || |                   //
-//               | |  | | / ___ \ | |___ | |___| |_| || |___                //
-//               |_|  |_|/_/   \_\|_____||_____|\___/  \____|               //
-//                                                                          //
-//                                                                          //
-//////////////////////////////////////////////////////////////////////////////
+  return 0;
+}
 
-// ********************
-// MEMORY SUB-ALLOCATOR
-// ********************
+static void __ProfileTotalsCallback(void *pCtx, const PROFILE_THREAD *pT, int nID,
+                                    WB_UINT64 tBegin, WB_UINT64 tEnd, WB_UINT64 tChildren)
+{
+PROFILE_TOTALS *pTotals;
+WB_UINT64 tDuration = tEnd - tBegin;
 
-// NOTES TO SELF (design notes)
-// a) allocate Xk blocks of memory for suballocator blocks of a specific size
-// b) the first 'page' of the memory block is an array of indices (double-link list)
-// c) the remainder of the block is an ordered set of memory blocks of a fixed size
-// d) as more blocks are added, they are added to a linked list associated with the size
-// e) blocks "more than Xk" will be malloc'd and added to the 'malloc' list.
-// f) malloc'd blocks will have a double-link list and a header with extra info
-// This way an allocated address will auto-indicate which memory block it belongs to
 
-static const char szWBAllocTag[]="WB_M";
-#define WB_ALLOC_TAG (*((const unsigned int *)szWBAllocTag)) /*< tag indicating it's a __malloc_header__ **/
+  if(nID >= nProfileInfo)
+  {
+    return;
+  }
 
-#define PMALLOC_FLAG (&mallocFlagMalloc) /*< when pPrev and pNext point to THIS, it's a "malloc'd" pointer **/
+  pTotals = (PROFILE_TOTALS *)pCtx + nID;
 
-struct __malloc_header__
-{
-  union
+  pTotals->nCount++;
+  pTotals->tTotal += tDuration;
+  pTotals->tSelf += tChildren < tDuration ? tDuration - tChildren : 0;
+
+  if(pTotals->tMax < tDuration)
   {
-    struct
-    {
-      struct __malloc_header__ *pPrev, *pNext;  ///< For a 'malloc'd block, these are both PMALLOC_FLAG
-      unsigned int iTag;                        ///< see WB_ALLOC_TAG
-      unsigned int cbSize;                      ///< size used for last malloc/realloc
-    };
-    uint8_t reserved[32];                       ///< 32 byte (256 bit) minimum size to improve alignment
-  };
-};
+    pTotals->tMax = tDuration;
+  }
+}
 
-static struct __malloc_header__ mallocFlagMalloc; // pointers to THIS indicate "I am a
+static int __ProfileTotalsCompare(const void *p1, const void *p2)
+{
+const PROFILE_TOTALS *pT1 = (const PROFILE_TOTALS *)p1;
+const PROFILE_TOTALS *pT2 = (const PROFILE_TOTALS *)p2;
 
-//static struct __malloc_header__ *pMallocList = NULL, *pMallocListEnd = NULL;
-// TODO:  when I go to implement this, uncomment the above line
 
-// TODO:  sync object for pMallocList etc.
+  return pT1->tTotal < pT2->tTotal ? 1 : pT1->tTotal > pT2->tTotal ? -1 : pT1->nID - pT2->nID;
+}
 
-void *WBAlloc(int nSize)
+void WBDumpProfileData(void)
 {
-unsigned char *pRval;
-struct __malloc_header__ *pMH;
-unsigned int nAllocSize, nNewSize, nLimit;
+PROFILE_TOTALS *paTotals;
+PROFILE_THREAD *pT;
+double dTicks;
+int i1;
 
 
-  if(nSize <= 0)
-  {
-    WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                   "ERROR:  %s.%d - nSize not valid (%d)\n", __FUNCTION__, __LINE__, nSize);
-    return NULL;
-  }
+  dTicks = __ProfileTicks();
 
-  // TODO:  implement allocation of smaller memory blocks as 'power of 2' blocks.
-  //
+  pthread_mutex_lock(&xProfileMutex);
 
-  nAllocSize = nSize + sizeof(*pMH);
-  // nAllocSize will be converted to the next higher power of 2
+  if(!nProfileInfo || !pProfileThreads)
+  {
+    pthread_mutex_unlock(&xProfileMutex);
 
-  nLimit = nAllocSize + (nAllocSize >> 1);
+    return;
+  }
 
-  for(nNewSize=64; nNewSize < nLimit; nNewSize <<= 1)
-  { } // NOTE:  64 bytes is the smallest allocation unit
+  paTotals = (PROFILE_TOTALS *)WBAlloc(nProfileInfo * sizeof(*paTotals));
 
-//  if(nNewSize < 4096) TODO:  internally sub-allocated blocks
-//  {
-//    TODO:  maintain lists of pre-allocated blocks of memory, allocating new memory as needed
-//           (this memory will need to be re-used intelligently so trash mashing can work properly
-//  }
+  if(!paTotals)
+  {
+    pthread_mutex_unlock(&xProfileMutex);
 
-  // for larger blocks, I use 'malloc'
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory\n", __FUNCTION__);
+    return;
+  }
 
-  pRval = (unsigned char *)malloc(nNewSize); // for now - later, use sub-allocation stuff
+  bzero(paTotals, nProfileInfo * sizeof(*paTotals));
 
-  if(pRval)
+  for(i1=0; i1 < nProfileInfo; i1++)
   {
-#ifdef HAVE_MALLOC_USABLE_SIZE
-    void *pActual = pRval;
-#endif // HAVE_MALLOC_USABLE_SIZE
+    paTotals[i1].nID = i1;
+  }
 
-    pMH = (struct __malloc_header__ *)pRval;
+  for(pT=pProfileThreads; pT; pT=pT->pNext)
+  {
+    __ProfileWalkThread(pT, __ProfileTotalsCallback, paTotals);
+  }
 
-    pRval += sizeof(*pMH);
+  qsort(paTotals, nProfileInfo, sizeof(*paTotals), __ProfileTotalsCompare);
 
-    pMH->pPrev = PMALLOC_FLAG; // this indicates it was 'malloc'd
-    pMH->pNext = PMALLOC_FLAG; // this indicates it was 'malloc'd
-    pMH->iTag = WB_ALLOC_TAG;
+  if(paTotals[0].nCount) // anything recorded at all?
+  {
+    WBDebugPrint("\n** PROFILE SUMMARY **  (%d thread%s, times in microseconds)\n"
+                 "     calls        total         self      average          max  name\n",
+                 nProfileThreads, nProfileThreads == 1 ? "" : "s");
 
-#ifdef HAVE_MALLOC_USABLE_SIZE
-    nLimit = malloc_usable_size(pActual); // the ACTUAL SIZE of the memory block
-    if(nLimit > nNewSize)
+    for(i1=0; i1 < nProfileInfo && paTotals[i1].nCount; i1++)
     {
-      nNewSize = nLimit;
+      const PROFILE_INFO *pInfo = paProfileInfo + paTotals[i1].nID;
+
+      WBDebugPrint("%10llu %12.1f %12.1f %12.2f %12.1f  %s - %s\n"
+                   "%64s%s  %s:%d\n",
+                   (unsigned long long)paTotals[i1].nCount,
+                   (double)paTotals[i1].tTotal / dTicks,
+                   (double)paTotals[i1].tSelf / dTicks,
+                   (double)paTotals[i1].tTotal / dTicks / (double)paTotals[i1].nCount,
+                   (double)paTotals[i1].tMax / dTicks,
+                   pInfo->szName, pInfo->szDesc,
+                   "", pInfo->szFunction, pInfo->szFile, pInfo->nLine);
     }
-#endif // HAVE_MALLOC_USABLE_SIZE
-    pMH->cbSize = nNewSize - sizeof(*pMH);
 
+    WBDebugPrint("\n");
   }
 
-  if(!pRval)
-  {
-    WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
-                   "WARNING:  %s.%d - unable to allocate %d bytes\n", __FUNCTION__, __LINE__, nSize);
-  }
-  else
-  {
-    WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                   "INFO:  %s.%d - allocated %d bytes as %p\n", __FUNCTION__, __LINE__, nSize, pRval);
-  }
+  pthread_mutex_unlock(&xProfileMutex);
 
-  return pRval;
+  WBFree(paTotals);
 }
 
-int WBAllocUsableSize(void *pBuf)
-{
-struct __malloc_header__ *pMH;
-
 
-  if(pBuf)
-  {
-    // validate pointer
-    // TODO:  check against linked list of 'allocated' blocks first
+//////////////////////////////////////////////////////////////////////////////
+// DEFERRED DEBUG LOG
+//
+// While the deferred log is running, WB_DEBUG_PRINT() copies the format string pointer and the raw argument
+// values into a fixed-size record in the calling thread's ring buffer.  Each ring buffer has exactly one writer
+// (its own thread) and one reader (whoever holds 'xLogMutex', normally the flusher thread), so a record only
+// needs a memory barrier before 'nWrite' is advanced.  The reader merges the records from all of the threads
+// in time stamp order, and formats them one conversion at a time.  As with the profiler, the ring buffers stay
+// on 'pLogThreads' until exit, even after their thread ends.
+//
+// Output that is already formatted (WBDebugPrint, and formats that can't be deferred) goes on a separate queue
+// with its own lock, so the caller never waits for (or does) the formatting of other threads' records.
+//////////////////////////////////////////////////////////////////////////////
 
-    pMH = ((struct __malloc_header__ *)pBuf) - 1;
+#define LOG_RING_SIZE      8192 /* records per thread, must be a power of 2 */
+#define LOG_MAX_ARGS       7    /* arguments per record (all of their types must fit in a WB_UINT32 signature) */
+#define LOG_TEXT_SIZE      160  /* bytes per record for copies of string arguments */
+#define LOG_MAX_SPEC       32   /* longest conversion specification that can be deferred */
+#define LOG_LINE_SIZE      4096 /* formatted output is truncated to this size */
+#define LOG_FLUSH_INTERVAL 20   /* milliseconds between passes of the flusher thread */
 
-    if(pMH->iTag == WB_ALLOC_TAG)
-    {
-      WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                     "INFO:  %s.%d - returning allocated size %d for %p\n", __FUNCTION__, __LINE__, pMH->cbSize, pBuf);
+// argument types, 4 bits each in a signature.  The top 4 bits of a signature are the argument count plus 1,
+// or LOG_SIG_SYNC if the format can't be deferred.  A signature of zero has not been parsed yet.
+enum
+{
+  LOG_ARG_INT = 1, // also 'char' and 'short', which are promoted to 'int'
+  LOG_ARG_LONG,
+  LOG_ARG_LLONG,
+  LOG_ARG_SIZE,
+  LOG_ARG_INTMAX,
+  LOG_ARG_PTRDIFF,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_LDOUBLE, // recorded as a 'double'
+  LOG_ARG_PTR,
+  LOG_ARG_STRING
+};
 
-      return pMH->cbSize;
-    }
-  }
+#define LOG_SIG_SYNC       0xfU
+#define LOG_SIG_COUNT(S)   ((unsigned int)((S) >> 28))
+#define LOG_SIG_TYPE(S,N)  ((unsigned int)((S) >> ((N) * 4)) & 0xfU)
 
-  WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
-                 "ERROR:  %s.%d - invalid pointer %p\n", __FUNCTION__, __LINE__, pBuf);
+typedef struct __log_record__
+{
+  WB_UINT64 tStamp;    // raw time stamp from __ProfileTimeStamp()
+  const char *szFmt;   // the format string (a string constant)
+  WB_UINT32 uiSig;     // the signature from __DebugLogParseFormat()
+  union
+  {
+    WB_INT64 llVal;    // integer types, and the offset of a string within 'szText' (-1 for NULL)
+    double dVal;       // floating point types
+    const void *pVal;  // pointers
+  } aArgs[LOG_MAX_ARGS];
+  char szText[LOG_TEXT_SIZE]; // copies of the string arguments, each with a zero byte terminator
+} LOG_RECORD;
 
-  return -1; // an error
+typedef struct __log_thread__
+{
+  struct __log_thread__ *pNext;   // next in 'pLogThreads'
+  int nThread;                    // sequential thread number, shown at the start of each line
+  volatile unsigned int nWrite;   // records written.  only the owning thread changes this
+  volatile unsigned int nRead;    // records formatted.  only changed while 'xLogMutex' is locked
+  volatile unsigned int nDropped; // records dropped because the ring buffer was full
+  unsigned int nDroppedReported;  // 'nDropped' as of the last report
+  unsigned int nLimit;            // 'nWrite' when the current pass started
+  LOG_RECORD aRecords[LOG_RING_SIZE];
+} LOG_THREAD;
+
+typedef struct __log_text__
+{
+  struct __log_text__ *pNext; // next in the queue
+  WB_UINT64 tStamp;           // raw time stamp from __ProfileTimeStamp()
+  int nThread;                // the thread number, as for a LOG_THREAD
+  char szText[1];             // the formatted text (allocated to fit)
+} LOG_TEXT;
+
+volatile int bWBDebugLogEnabled = 0;
+
+static pthread_mutex_t xLogTextMutex = PTHREAD_MUTEX_INITIALIZER; // protects the 'LOG_TEXT' queue (may be locked inside xLogMutex, never the reverse)
+static LOG_TEXT *pLogTextHead = NULL, **ppLogTextTail = &pLogTextHead;
+static int bLogTextOpen = 0; // the queue accepts text while this is set (the log is running)
+
+static pthread_mutex_t xLogMutex = PTHREAD_MUTEX_INITIALIZER; // protects everything below, and reading the ring buffers
+static pthread_cond_t xLogCond = PTHREAD_COND_INITIALIZER;    // wakes up the flusher thread
+static LOG_THREAD *pLogThreads = NULL;
+static volatile int nLogThreads = 0; // thread numbers are assigned with WB_ATOMIC_FETCH_ADD
+static FILE *pLogOut = NULL; // the output file, NULL when the log is not running
+static int bLogThread = 0, bLogQuit = 0, bLogLineStart = 1;
+static pthread_t thrdLog;
+static WB_UINT64 tLogBase = 0, nsLogBase = 0; // time stamp and CLOCK_MONOTONIC when the log was first started
+static double dLogTicks = 0.0; // time stamp ticks per microsecond, once it has been calibrated
+
+static pthread_key_t keyLogThread, keyLogThreadNumber;
+static pthread_once_t xLogOnce = PTHREAD_ONCE_INIT;
+static int bLogKey = 0;
+
+
+static void __DebugLogKeyInit(void)
+{
+  bLogKey = !pthread_key_create(&keyLogThread, NULL) && // the ring buffers belong to 'pLogThreads'
+            !pthread_key_create(&keyLogThreadNumber, NULL);
 }
 
-void WBFree(void *pBuf)
+// the calling thread's number, assigned the first time it's needed (without allocating a ring buffer)
+static int __DebugLogThreadNumber(void)
 {
-struct __malloc_header__ *pMH;
-unsigned int nOldSize;
-
-  if(pBuf)
-  {
-    // validate pointer
-    // TODO:  check against linked list of 'allocated' blocks first
+LOG_THREAD *pT;
+int nRval;
 
-    pMH = ((struct __malloc_header__ *)pBuf) - 1;
 
-    if(pMH->iTag == WB_ALLOC_TAG)
-    {
-      nOldSize = pMH->cbSize;
+  if(WB_UNLIKELY(!bLogKey))
+  {
+    return 0;
+  }
 
-      if(pMH->pPrev == PMALLOC_FLAG &&
-         pMH->pNext == PMALLOC_FLAG)
-      {
-        // assign header values that invalidate re-freeing the same memory
+  pT = (LOG_THREAD *)pthread_getspecific(keyLogThread);
 
-        pMH->iTag = 0; // make sure it's no longer valid (so I don't try to re-free)
-        pMH->pPrev = NULL; // same with these values
-        pMH->pNext = NULL;
-        pMH->cbSize = 0;
+  if(pT)
+  {
+    return pT->nThread;
+  }
 
-        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                       "INFO:  %s.%d - freeing %d bytes of memory at %p\n", __FUNCTION__, __LINE__, nOldSize, pBuf);
-        free(pMH);
-      }
-      else
-      {
-        // TODO:  make sure it's not "already free" somehow since re-freeing free memory is *BAD*
+  nRval = (int)(intptr_t)pthread_getspecific(keyLogThreadNumber);
 
-        WB_ERROR_PRINT("TODO:  %s 'pre-alloc' unimplemented - NOT freeing memory %p\n", __FUNCTION__, pBuf);
-      }
+  if(!nRval)
+  {
+    nRval = WB_ATOMIC_FETCH_ADD(&nLogThreads, 1) + 1;
 
-      return;
-    }
+    pthread_setspecific(keyLogThreadNumber, (void *)(intptr_t)nRval);
   }
 
-  WB_ERROR_PRINT("ERROR:  %s.%d NOT freeing (invalid) memory %p\n", __FUNCTION__, __LINE__, pBuf);
+  return nRval;
 }
 
-void * WBReAlloc(void *pBuf, int nNewSize)
+static LOG_THREAD * __DebugLogThread(void)
 {
-struct __malloc_header__ *pMH;
-unsigned char *pRval = NULL;
-unsigned int nAllocSize, nOldSize, nNewNewSize, nLimit;
+LOG_THREAD *pRval;
 
 
-  if(!pBuf || nNewSize <= 0)
+  if(WB_UNLIKELY(!bLogKey))
   {
-    WB_ERROR_PRINT("ERROR:  %s.%d Invalid parameter (%p, %d)\n", __FUNCTION__, __LINE__, pBuf, nNewSize);
     return NULL;
   }
 
-  // validate pointer
-  // TODO:  check against linked list of 'allocated' blocks first
+  pRval = (LOG_THREAD *)pthread_getspecific(keyLogThread);
 
-  pMH = ((struct __malloc_header__ *)pBuf) - 1;
+  if(WB_LIKELY(pRval != NULL))
+  {
+    return pRval;
+  }
 
-  if(pMH->iTag == WB_ALLOC_TAG)
+  pRval = (LOG_THREAD *)WBAlloc(sizeof(*pRval));
+
+  if(!pRval)
   {
-    nOldSize = pMH->cbSize;
+    return NULL;
+  }
 
-    // the whole point of this is to minimize the actual need to re-allocate the
-    // memory block by maintaining a LARGER block than is actually needed when
-    // allocated or re-allocated.  Gradually increasing size is pretty much assumed.
+  pRval->nWrite = 0; // the records themselves don't need initializing
+  pRval->nRead = 0;
+  pRval->nDropped = 0;
+  pRval->nDroppedReported = 0;
+  pRval->nLimit = 0;
 
-    if(nOldSize >= nNewSize)
-    {
-      WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                     "INFO:  %s.%d - memory at %p is already %d bytes (requested %d)\n",
-                     __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
+  pRval->nThread = __DebugLogThreadNumber(); // the same number, if it already had one
 
-      return pBuf; // no change (same pointer) since it's large enough already
-    }
+  pthread_mutex_lock(&xLogMutex);
 
-    // TODO:  implement re-allocation of smaller memory blocks as 'power of 2' blocks.
-    //
+  pRval->pNext = pLogThreads;
+  pLogThreads = pRval;
 
-    nAllocSize = nNewSize + sizeof(*pMH);
-    // nAllocSize will be converted to the next higher power of 2
+  pthread_mutex_unlock(&xLogMutex);
 
-    nLimit = nAllocSize + (nAllocSize >> 1);
-    for(nNewNewSize=64; nNewNewSize < nLimit; nNewNewSize <<= 1) { } // NOTE:  64 bytes is the smallest allocation unit
+  pthread_setspecific(keyLogThread, pRval);
 
-    if(pMH->pPrev != PMALLOC_FLAG &&
-       pMH->pNext != PMALLOC_FLAG)
-    {
-      if(nNewNewSize >= 4096) // TODO:  internally sub-allocated blocks
-      {
-        // it WAS an internally sub-alloced block.  NOW it is a MALLOC block.
+  return pRval;
+}
 
-        pRval = WBAlloc(nNewNewSize); // just allocate it with 'WBAlloc' and let 'WBAlloc' do the work
-        if(!pRval)
-        {
-          WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
-                         "WARN:  %s.%d - not enough memory to re-allocate %p from %d bytes to %d\n",
-                         __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
+// parse the conversion specification that follows a '%'.  Returns a pointer to the conversion character,
+// or NULL if it can't be deferred.  '*pnStars' is the number of '*' (int) arguments that come before it.
+static const char * __DebugLogSpec(const char *szSpec, int *pnStars, int *piType)
+{
+const char *p1 = szSpec;
+int iLength = 0; // 'l', 'q' (for 'll'), 'L', 'j', 'z', 't', or zero ('h' and 'hh' don't matter)
+int bPrecision = 0;
 
-          return NULL; // not enough memory
-        }
 
-        memcpy(pRval, pBuf, nOldSize); // copy the old data, but not the stuff in the header.
-        WBFree(pBuf); // free 'pBuf' now that it's not needed
+  *pnStars = 0;
+  *piType = 0;
 
-        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                       "INFO:  %s.%d - re-allocated %p using WBAlloc() from %d bytes to %d\n",
-                       __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
+  while(*p1 && strchr("-+ #0'", *p1)) // flags
+  {
+    p1++;
+  }
 
-        return pRval; // return the new pointer (old is no longer valid, new one is 'malloc'ed version).
-      }
-      else
-      {
-        //TODO:  maintain lists of pre-allocated blocks of memory, allocating new memory as needed
-        //       (this memory will need to be re-used intelligently so trash mashing can work properly
+  if(*p1 == '*') // width
+  {
+    (*pnStars)++;
+    p1++;
+  }
+  else
+  {
+    while(*p1 >= '0' && *p1 <= '9')
+    {
+      p1++;
+    }
+  }
 
-        WB_ERROR_PRINT("TODO:  %s - 'pre-alloc' is NOT implemented.  Pointer %p NOT re-allocated\n", __FUNCTION__, pBuf);
-        return NULL;
+  if(*p1 == '.') // precision
+  {
+    bPrecision = 1;
+    p1++;
+
+    if(*p1 == '*')
+    {
+      (*pnStars)++;
+      p1++;
+    }
+    else
+    {
+      while(*p1 >= '0' && *p1 <= '9')
+      {
+        p1++;
       }
     }
+  }
 
-    pRval = realloc(pMH, nNewNewSize); // for now...
-    if(pRval)
-    {
-#ifdef HAVE_MALLOC_USABLE_SIZE
-      void *pActual = pRval;
-#endif // HAVE_MALLOC_USABLE_SIZE
+  if(*p1 == 'h')
+  {
+    p1 += p1[1] == 'h' ? 2 : 1;
+  }
+  else if(*p1 == 'l')
+  {
+    iLength = p1[1] == 'l' ? 'q' : 'l';
+    p1 += p1[1] == 'l' ? 2 : 1;
+  }
+  else if(*p1 == 'q' || *p1 == 'L' || *p1 == 'j' || *p1 == 'z' || *p1 == 't')
+  {
+    iLength = *(p1++);
+  }
 
-      pMH = (struct __malloc_header__ *)pRval;
-      pRval += sizeof(*pMH);
+  if(p1 - szSpec >= LOG_MAX_SPEC) // '$' (positional) also ends up here, or in 'default' below
+  {
+    return NULL;
+  }
 
-#ifdef HAVE_MALLOC_USABLE_SIZE
-      nLimit = malloc_usable_size(pActual); // the ACTUAL SIZE of the memory block
-      if(nLimit > nNewSize)
+  switch(*p1)
+  {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+      *piType = iLength == 'l' ? LOG_ARG_LONG :
+                iLength == 'q' || iLength == 'L' ? LOG_ARG_LLONG :
+                iLength == 'z' ? LOG_ARG_SIZE :
+                iLength == 'j' ? LOG_ARG_INTMAX :
+                iLength == 't' ? LOG_ARG_PTRDIFF : LOG_ARG_INT;
+      break;
+
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      if(iLength && iLength != 'l' && iLength != 'L')
       {
-        nNewSize = nLimit;
+        return NULL;
       }
-#endif // HAVE_MALLOC_USABLE_SIZE
-      pMH->cbSize = nNewNewSize - sizeof(*pMH);
 
-      if(pRval != (void *)pMH)
+      *piType = iLength == 'L' ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+      break;
+
+    case 'c':
+    case 'p':
+      if(iLength) // wide character
       {
-        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                       "INFO:  %s.%d - re-allocated %p as %p, from %d bytes to %d\n",
-                       __FUNCTION__, __LINE__, pBuf, pRval, nOldSize, nNewSize);
+        return NULL;
       }
-      else
+
+      *piType = *p1 == 'c' ? LOG_ARG_INT : LOG_ARG_PTR;
+      break;
+
+    case 's':
+      if(iLength || bPrecision) // wide characters, or it might not be zero-byte terminated
       {
-        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
-                       "INFO:  %s.%d - re-allocated %p from %d bytes to %d\n",
-                       __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
+        return NULL;
       }
-    }
-    else
-    {
-      WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
-                     "WARN:  %s.%d - not enough memory to re-allocate %p from %d bytes to %d\n",
-                     __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
-    }
-  }
-  else
-  {
-    WB_ERROR_PRINT("ERROR - %s NOT re-allocating memory %p\n", __FUNCTION__, pBuf);
+
+      *piType = LOG_ARG_STRING;
+      break;
+
+    default: // '%n', '%m' (errno will have changed), and anything I don't recognize
+      return NULL;
   }
 
-  return pRval;
+  return p1;
 }
 
-void WBSubAllocTrashMasher(void)
+static WB_UINT32 __DebugLogParseFormat(const char *szFmt)
 {
-  // do nothing (for now)
-  // later, walk memory list to see if any blocks are completely unused, and free them.
-  // in debug mode, maybe there's a way to validate memory blocks?
-}
+const char *p1;
+WB_UINT32 uiRval = 0;
+int i1, nArgs = 0, nStars, iType;
 
 
-//////////////////////////////////////////////////////////////////////////////
-//                                                                          //
-//                  ____   _          _                                     //
-//                 / ___| | |_  _ __ (_) _ __    __ _  ___                  //
-//                 \___ \ | __|| '__|| || '_ \  / _` |/ __|                 //
-//                  ___) || |_ | |   | || | | || (_| |\__ \                 //
-//                 |____/  \__||_|   |_||_| |_| \__, ||___/                 //
-//                                              |___/                       //
-//                                                                          //
-//////////////////////////////////////////////////////////////////////////////
+  for(p1=szFmt; *p1; p1++)
+  {
+    if(*p1 != '%')
+    {
+      continue;
+    }
 
+    if(p1[1] == '%')
+    {
+      p1++;
+      continue;
+    }
 
-// ************************
-// generic string utilities
-// ************************
+    p1 = __DebugLogSpec(p1 + 1, &nStars, &iType);
 
-#ifndef  HAVE_STRLCPY
-size_t strlcpy(char * dst, const char * src, size_t dstsize)
-{
-int nRval = 0;
-char *pE = dst + dstsize - 1;
+    if(!p1 || nArgs + nStars >= LOG_MAX_ARGS)
+    {
+      return (WB_UINT32)LOG_SIG_SYNC << 28;
+    }
 
-  if(!dstsize || !dst || !src)
-  {
-    return 0;
-  }
+    for(i1=0; i1 < nStars; i1++)
+    {
+      uiRval |= (WB_UINT32)LOG_ARG_INT << (nArgs++ * 4);
+    }
 
-  while(dst < pE && *src)
-  {
-    *(dst++) = *(src++);
-    nRval++;
+    uiRval |= (WB_UINT32)iType << (nArgs++ * 4);
   }
 
-  *dst = 0; // always
-
-  return nRval; // # of characters up to but not including the 0 byte
+  return uiRval | ((WB_UINT32)(nArgs + 1) << 28);
 }
-#endif //  HAVE_STRLCPY
 
-#ifndef  HAVE_STRLCAT
-size_t strlcat(char * dst, const char * src, size_t dstsize)
+static double __DebugLogTicks(void) // 'xLogMutex' must be locked
 {
-int nRval = 0;
-char *pE = dst + dstsize - 1;
-
-  if(!dstsize || !dst || !src)
+  if(dLogTicks == 0.0) // the first time this is called (within 10msec of starting) it may have to wait
   {
-    return 0;
+    dLogTicks = __ProfileTicksPerMicrosecond(tLogBase, nsLogBase);
   }
 
-  while(dst < pE && *dst)
-  {
-    dst++;
-  }
+  return dLogTicks;
+}
 
-  while(dst < pE && *src)
-  {
-    *(dst++) = *(src++);
-    nRval++;
-  }
+// format one record into 'pBuf', one conversion at a time, and return the length
+static int __DebugLogFormat(const LOG_RECORD *pR, char *pBuf, int cbBuf)
+{
+const char *p1, *p2;
+char szSpec[LOG_MAX_SPEC + 32];
+int cbLen = 0, cb1, iArg = 0, nStars, iType;
 
-  *dst = 0; // always
 
-  return nRval; // # of characters up to but not including the 0 byte
-}
-#endif //  HAVE_STRLCAT
-
-
-
-char * WBFormatString(const char *fmt, ...)
-{
-va_list va;
-int iSize = 1024, iTemp;
-char *pRval, *pTemp;
-
-  pRval = WBAlloc(iSize);
-
-  while(!pRval && iSize >= 256) // desperately try to allocate smaller blocks if out of RAM
+  for(p1=pR->szFmt; *p1 && cbLen < cbBuf - 1; )
   {
-    iSize /= 2;
-    pRval = WBAlloc(iSize);
-  }
+    if(*p1 != '%' || p1[1] == '%')
+    {
+      pBuf[cbLen++] = *p1;
+      p1 += *p1 == '%' ? 2 : 1;
 
-  if(!pRval)
-    return NULL;
+      continue;
+    }
 
-  va_start(va, fmt);
+    p2 = __DebugLogSpec(p1 + 1, &nStars, &iType); // this worked when the record was written
 
-  iTemp = vsnprintf(pRval, iSize, fmt, va);
-  if(iTemp >= iSize) // need to realloc
-  {
-    pTemp = WBReAlloc(pRval, iTemp + 2);
-    if(!pTemp)
-    {
-      WBFree(pRval);
-      pRval = NULL;
-    }
-    else
+    if(!p2)
     {
-      pRval = pTemp;
-      vsnprintf(pRval, iTemp + 2, fmt, va);
+      break; // should not happen
     }
-  }
-
-  va_end(va);
-
-  return(pRval);
-}
 
+    // copy the specification, replacing each '*' with its (int) argument
 
-char *WBCopyString(const char *pSrc)
-{
-char *pDest;
-int iLen;
+    for(cb1=0; p1 <= p2; p1++)
+    {
+      if(*p1 == '*')
+      {
+        cb1 += snprintf(szSpec + cb1, sizeof(szSpec) - cb1, "%d", (int)pR->aArgs[iArg++].llVal);
+      }
+      else
+      {
+        szSpec[cb1++] = *p1;
+      }
+    }
 
-  if(!pSrc || !*pSrc)
-  {
-    pDest = WBAlloc(2);
+    szSpec[cb1] = 0;
 
-    if(pDest)
+    switch(iType)
     {
-      *pDest = 0;
+      case LOG_ARG_INT:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (int)pR->aArgs[iArg].llVal);
+        break;
+      case LOG_ARG_LONG:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (long)pR->aArgs[iArg].llVal);
+        break;
+      case LOG_ARG_LLONG:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (long long)pR->aArgs[iArg].llVal);
+        break;
+      case LOG_ARG_SIZE:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (size_t)pR->aArgs[iArg].llVal);
+        break;
+      case LOG_ARG_INTMAX:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (intmax_t)pR->aArgs[iArg].llVal);
+        break;
+      case LOG_ARG_PTRDIFF:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (ptrdiff_t)pR->aArgs[iArg].llVal);
+        break;
+      case LOG_ARG_DOUBLE:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, pR->aArgs[iArg].dVal);
+        break;
+      case LOG_ARG_LDOUBLE:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, (long double)pR->aArgs[iArg].dVal);
+        break;
+      case LOG_ARG_PTR:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec, pR->aArgs[iArg].pVal);
+        break;
+      case LOG_ARG_STRING:
+        cb1 = snprintf(pBuf + cbLen, cbBuf - cbLen, szSpec,
+                       pR->aArgs[iArg].llVal < 0 ? (const char *)NULL : pR->szText + pR->aArgs[iArg].llVal);
+        break;
+      default:
+        cb1 = 0;
+        break;
     }
-  }
-  else
-  {
-    iLen = strlen(pSrc);
 
-    pDest = WBAlloc(iLen + 1);
+    iArg++;
 
-    if(pDest)
+    if(cb1 > 0)
     {
-      memcpy(pDest, pSrc, iLen);
-      pDest[iLen] = 0;
+      cbLen = cbLen + cb1 < cbBuf ? cbLen + cb1 : cbBuf - 1; // snprintf returns the un-truncated length
     }
   }
 
-  return pDest;
+  pBuf[cbLen] = 0;
+
+  return cbLen;
 }
 
-char *WBCopyStringN(const char *pSrc, unsigned int nMaxChars)
+// write 'szText' to the log output, starting each line with the elapsed time and the thread number.
+// 'xLogMutex' must be locked
+static void __DebugLogEmit(WB_UINT64 tStamp, int nThread, const char *szText)
 {
-char *pDest;
-unsigned int iLen;
 const char *p1;
+double dSeconds;
 
-  if(!pSrc || !*pSrc)
-  {
-    pDest = WBAlloc(2);
 
-    if(pDest)
+  dSeconds = tStamp > tLogBase ? (double)(tStamp - tLogBase) / __DebugLogTicks() / 1000000.0 : 0.0;
+
+  while(*szText)
+  {
+    if(bLogLineStart)
     {
-      *pDest = 0;
+      fprintf(pLogOut, "[%12.6f T%d] ", dSeconds, nThread);
     }
-  }
-  else
-  {
-    for(p1 = pSrc, iLen = 0; iLen < nMaxChars && *p1; p1++, iLen++)
-    { } // determine length of 'pStr' to copy
 
-    pDest = WBAlloc(iLen + 1);
+    p1 = strchr(szText, '\n');
 
-    if(pDest)
+    if(!p1)
     {
-      memcpy(pDest, pSrc, iLen);
-      pDest[iLen] = 0;
+      fputs(szText, pLogOut);
+      bLogLineStart = 0;
+
+      break;
     }
-  }
 
-  return pDest;
-}
+    fwrite(szText, 1, p1 - szText + 1, pLogOut);
+    bLogLineStart = 1;
 
+    szText = p1 + 1;
+  }
+}
 
-void WBCatString(char **ppDest, const char *pSrc)  // concatenate onto WBAlloc'd string
+// format the records that are waiting, merging the threads in time stamp order.  'xLogMutex' must be locked
+static void __DebugLogDrain(void)
 {
-int iLen, iLen2;
-int iMaxLen;
-char *p1, *p2;
+LOG_THREAD *pT, *pNext;
+const LOG_RECORD *pR, *pNextR;
+LOG_TEXT *pText, *pTextList;
+char szLine[LOG_LINE_SIZE];
+unsigned int nDropped;
 
-  if(!ppDest || !pSrc || !*pSrc)
+
+  if(!pLogOut)
   {
     return;
   }
 
-  if(*ppDest)
+  // the pre-formatted text that's waiting.  anything queued after this waits for the next pass
+
+  pthread_mutex_lock(&xLogTextMutex);
+
+  pTextList = pLogTextHead;
+  pLogTextHead = NULL;
+  ppLogTextTail = &pLogTextHead;
+
+  pthread_mutex_unlock(&xLogTextMutex);
+
+  for(pT=pLogThreads; pT; pT=pT->pNext)
   {
-    p1 = p2 = *ppDest;
+    pT->nLimit = pT->nWrite; // records written after this wait for the next pass, so a busy thread can't keep me here
 
-    iMaxLen = WBAllocUsableSize(p1);
+    nDropped = pT->nDropped;
 
-    if(iMaxLen <= 0) // an error
+    if(nDropped != pT->nDroppedReported)
     {
-      return;
-    }
+      snprintf(szLine, sizeof(szLine), "** %u debug log record%s dropped (ring buffer full) **\n",
+               nDropped - pT->nDroppedReported, nDropped - pT->nDroppedReported == 1 ? "" : "s");
 
-    while(*p2
-          && (p2 - p1) < iMaxLen
-         )
-    {
-      p2++;
+      __DebugLogEmit(__ProfileTimeStamp(), pT->nThread, szLine);
+
+      pT->nDroppedReported = nDropped;
     }
+  }
 
-    iLen2 = strlen(pSrc);
-    iLen = iLen2 + (p2 - p1);
+  WB_MEMORY_BARRIER(); // read the records after 'nWrite'
 
-    if((iLen + 1) > iMaxLen)
+  while(1)
+  {
+    pNext = NULL;
+    pNextR = NULL;
+
+    for(pT=pLogThreads; pT; pT=pT->pNext)
     {
-      *ppDest = WBReAlloc(p1, iLen + 1);
-      if(!*ppDest)
+      if(pT->nRead != pT->nLimit)
       {
-        *ppDest = p1;
-        return;  // not enough memory
+        pR = pT->aRecords + (pT->nRead & (LOG_RING_SIZE - 1));
+
+        if(!pNextR || pR->tStamp < pNextR->tStamp)
+        {
+          pNext = pT;
+          pNextR = pR;
+        }
       }
+    }
 
-      p2 = (p2 - p1) + *ppDest;  // re-position end of string
+    if(pTextList && (!pNextR || pTextList->tStamp <= pNextR->tStamp)) // pre-formatted text goes next
+    {
+      pText = pTextList;
+      pTextList = pText->pNext;
+
+      __DebugLogEmit(pText->tStamp, pText->nThread, pText->szText);
+
+      WBFree(pText);
+      continue;
     }
 
-    memcpy(p2, pSrc, iLen2);
-    p2[iLen2] = 0;  // make sure last byte is zero
-  }
-  else
-  {
-    *ppDest = WBCopyString(pSrc);
+    if(!pNext)
+    {
+      break;
+    }
+
+    __DebugLogFormat(pNextR, szLine, sizeof(szLine));
+    __DebugLogEmit(pNextR->tStamp, pNext->nThread, szLine);
+
+    WB_MEMORY_BARRIER(); // finish reading the record before its thread can re-use it
+
+    pNext->nRead++;
   }
+
+  fflush(pLogOut);
 }
 
-void WBCatStringN(char **ppDest, const char *pSrc, unsigned int nMaxChars)
+static void * __DebugLogThreadProc(void *pParam)
 {
-int iLen, iLen2;
-int iMaxLen;
-char *p1, *p2;
-const char *p3;
+struct timespec ts;
 
 
-  if(!ppDest || !pSrc || !*pSrc)
-  {
-    return;
-  }
+  (void)pParam;
 
-  if(*ppDest)
+  pthread_mutex_lock(&xLogMutex);
+
+  while(!bLogQuit)
   {
-    p1 = p2 = *ppDest;
+    clock_gettime(CLOCK_REALTIME, &ts); // the default clock for 'xLogCond'
 
-    iMaxLen = WBAllocUsableSize(p1);
+    ts.tv_nsec += LOG_FLUSH_INTERVAL * 1000000L;
 
-    if(iMaxLen <= 0)
+    if(ts.tv_nsec >= 1000000000L)
     {
-      return;
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000L;
     }
 
+    pthread_cond_timedwait(&xLogCond, &xLogMutex, &ts);
 
-    while(*p2
-          && (p2 - p1) < iMaxLen
-         )
-    {
-      p2++;
-    }
+    __DebugLogDrain();
+  }
 
-    for(iLen2=0, p3 = pSrc; iLen2 < nMaxChars && *p3; p3++, iLen2++)
-    { }  // determine what the length of pSrc is up to a zero byte or 'nMaxChars', whichever is first
+  pthread_mutex_unlock(&xLogMutex);
 
-    iLen = iLen2 + (p2 - p1);
+  return NULL;
+}
 
-    if((iLen + 1) > iMaxLen)
-    {
-      *ppDest = WBReAlloc(p1, iLen + 1);
-      if(!*ppDest)
-      {
-        *ppDest = p1; // restore the old pointer value
-        return;  // not enough memory
-      }
+// output while the log is running that can't be deferred as a record (from WBDebugPrint, or a format that
+// can't be deferred).  It's formatted by the caller and queued for the flusher thread, after anything that
+// was recorded before it.
+static void __DebugLogVPrint(const char *szFmt, va_list va)
+{
+char szBuf[LOG_LINE_SIZE];
+LOG_TEXT *pText;
+int cbLen;
 
-      p2 = (p2 - p1) + *ppDest;  // re-position end of string
-    }
 
-    memcpy(p2, pSrc, iLen2);
-    p2[iLen2] = 0;  // make sure last byte is zero
-  }
-  else
+  cbLen = vsnprintf(szBuf, sizeof(szBuf), szFmt, va);
+
+  if(cbLen < 0)
   {
-    *ppDest = WBCopyStringN(pSrc, nMaxChars);
+    return;
   }
-}
 
-void WBDeQuoteString(char *pString)
-{
-char *p1, *pDest;
+  if(cbLen >= (int)sizeof(szBuf))
+  {
+    cbLen = sizeof(szBuf) - 1; // truncated
+  }
 
-  p1 = pDest = pString;
+  pText = (LOG_TEXT *)WBAlloc(sizeof(*pText) + cbLen);
 
-  while(*p1)
+  if(pText)
   {
-    if(*p1 == '"' || *p1 == '\'')
-    {
-      char c1 = *(p1++);
+    pText->pNext = NULL;
+    pText->nThread = __DebugLogThreadNumber();
+    memcpy(pText->szText, szBuf, cbLen + 1);
 
-      while(*p1 &&
-            (*p1 != c1 || p1[1] == c1))
-      {
-        if(*p1 == c1)
-        {
-          p1++;
-        }
+    pthread_mutex_lock(&xLogTextMutex);
 
-        *(pDest++) = *(p1++);
-      }
+    if(bLogTextOpen)
+    {
+      pText->tStamp = __ProfileTimeStamp(); // while locked, so the queue stays in time stamp order
 
-      if(*p1 == c1)
-      {
-        p1++;
-      }
+      *ppLogTextTail = pText;
+      ppLogTextTail = &(pText->pNext);
+
+      pText = NULL; // it belongs to the queue now
     }
-    else
+
+    pthread_mutex_unlock(&xLogTextMutex);
+
+    if(!pText)
     {
-      if(pDest != p1)
-      {
-        *pDest = *p1;
-      }
+      pthread_cond_signal(&xLogCond); // wake up the flusher thread
 
-      pDest++;
-      p1++;
+      return;
     }
+
+    WBFree(pText);
   }
 
-  *pDest = 0; // make sure
+  // the log was stopped in the mean time (or not enough memory), so write it directly
+
+  fputs(szBuf, stderr);
+  fflush(stderr);
 }
 
-static char __amp_char(char **ppSpot)
+static void __DebugLogFree(void)
 {
-char *pS = *ppSpot;
+LOG_THREAD *pT;
+LOG_TEXT *pText;
 
-  if(!memcmp(pS, "&amp;", 5))
+
+  bWBDebugLogEnabled = 0;
+
+  pthread_mutex_lock(&xLogTextMutex);
+
+  while((pText = pLogTextHead) != NULL) // normally empty, since WBDebugLogStop drains it
   {
-    *ppSpot += 5;
-    return '&';
+    pLogTextHead = pText->pNext;
+    WBFree(pText);
   }
-  else if(!memcmp(pS, "&lt;", 4))
-  {
-    *ppSpot += 4;
-    return '<';
+
+  ppLogTextTail = &pLogTextHead;
+
+  pthread_mutex_unlock(&xLogTextMutex);
+
+  pthread_mutex_lock(&xLogMutex);
+
+  while((pT = pLogThreads) != NULL)
+  {
+    pLogThreads = pT->pNext;
+    WBFree(pT);
   }
-  else if(!memcmp(pS, "&gt;", 4))
+
+  if(bLogKey)
   {
-    *ppSpot += 4;
-    return '>';
+    pthread_setspecific(keyLogThread, NULL); // the calling thread's (other threads must not record any more)
   }
 
-  return 0;
+  pthread_mutex_unlock(&xLogMutex);
 }
 
-void WBNormalizeXMLString(char *pString)
+void WBDebugLogRecord(volatile WB_UINT32 *puiSig, const char *pFmt, ...)
 {
-char *p1, *pDest;
-char c1, c2;
-
+LOG_THREAD *pT;
+LOG_RECORD *pR;
+WB_UINT32 uiSig;
+unsigned int nWrite, nArgs, cbText, cb1;
+const char *p1;
+unsigned int i1;
+va_list va;
 
-  // not only de-quoting, but converting '&amp;' '&lt;' '&gt;' to '&' '<' and '>'
 
-  p1 = pDest = pString;
+  uiSig = *puiSig;
 
-  while(*p1)
+  if(WB_UNLIKELY(!uiSig))
   {
-    if(*p1 == '"' || *p1 == '\'')
-    {
-      c1 = *(p1++);
-
-      while(*p1 &&
-            (*p1 != c1 || p1[1] == c1))
-      {
-        if(*p1 == c1)
-        {
-          p1++;
-        }
-        else if(*p1 == '&') // substitute
-        {
-          c2 = __amp_char(&p1);
-
-          if(c2)
-          {
-            *(pDest++) = c2;
-            continue;
-          }
-
-          // if it's not recognized, just process it as normal chars
-        }
+    uiSig = __DebugLogParseFormat(pFmt);
+    *puiSig = uiSig; // another thread may be doing the same thing, with the same result
+  }
 
-        *(pDest++) = *(p1++);
-      }
+  pT = LOG_SIG_COUNT(uiSig) != LOG_SIG_SYNC ? __DebugLogThread() : NULL;
 
-      if(*p1 == c1)
-      {
-        p1++;
-      }
-    }
-    else if(*p1 == '&') // substitute
-    {
-      c2 = __amp_char(&p1);
+  if(WB_UNLIKELY(!pT))
+  {
+    va_start(va, pFmt);
+    __DebugLogVPrint(pFmt, va);
+    va_end(va);
 
-      if(!c2)
-      {
-        goto normal_char; // just process it as normal chars
-      }
+    return;
+  }
 
-      *(pDest++) = c2;
-    }
-    else
-    {
-normal_char:
+  nWrite = pT->nWrite;
 
-      if(pDest != p1)
-      {
-        *pDest = *p1;
-      }
+  if(WB_UNLIKELY(nWrite - pT->nRead >= LOG_RING_SIZE))
+  {
+    pT->nDropped++; // only this thread changes it
 
-      pDest++;
-      p1++;
-    }
+    return;
   }
 
-  *pDest = 0; // make sure
-}
+  pR = pT->aRecords + (nWrite & (LOG_RING_SIZE - 1));
 
-int WBStringLineCount(const char *pSrc, unsigned int nMaxChars)
-{
-int iRval = 1;
-const char *p1;
+  pR->tStamp = __ProfileTimeStamp();
+  pR->szFmt = pFmt;
+  pR->uiSig = uiSig;
 
-  if(!pSrc || (!nMaxChars && !*pSrc))
-  {
-    return 0;
-  }
+  nArgs = LOG_SIG_COUNT(uiSig) - 1;
+  cbText = 0;
 
-  if(!nMaxChars)
-  {
-    nMaxChars = strlen(pSrc);
-  }
+  va_start(va, pFmt);
 
-  do
+  for(i1=0; i1 < nArgs; i1++)
   {
-    p1 = WBStringNextLine(pSrc, &nMaxChars);
-    if(p1 && nMaxChars) // another line remains
+    switch(LOG_SIG_TYPE(uiSig, i1))
     {
-      iRval++;
+      case LOG_ARG_INT:
+        pR->aArgs[i1].llVal = va_arg(va, int);
+        break;
+      case LOG_ARG_LONG:
+        pR->aArgs[i1].llVal = va_arg(va, long);
+        break;
+      case LOG_ARG_LLONG:
+        pR->aArgs[i1].llVal = va_arg(va, long long);
+        break;
+      case LOG_ARG_SIZE:
+        pR->aArgs[i1].llVal = (WB_INT64)va_arg(va, size_t);
+        break;
+      case LOG_ARG_INTMAX:
+        pR->aArgs[i1].llVal = va_arg(va, intmax_t);
+        break;
+      case LOG_ARG_PTRDIFF:
+        pR->aArgs[i1].llVal = va_arg(va, ptrdiff_t);
+        break;
+      case LOG_ARG_DOUBLE:
+        pR->aArgs[i1].dVal = va_arg(va, double);
+        break;
+      case LOG_ARG_LDOUBLE:
+        pR->aArgs[i1].dVal = (double)va_arg(va, long double);
+        break;
+      case LOG_ARG_PTR:
+        pR->aArgs[i1].pVal = va_arg(va, const void *);
+        break;
+      case LOG_ARG_STRING:
+        p1 = va_arg(va, const char *);
+
+        if(!p1)
+        {
+          pR->aArgs[i1].llVal = -1;
+        }
+        else if(cbText >= LOG_TEXT_SIZE) // no room, so it's empty (the last byte is always a terminator)
+        {
+          pR->aArgs[i1].llVal = LOG_TEXT_SIZE - 1;
+        }
+        else
+        {
+          cb1 = strnlen(p1, LOG_TEXT_SIZE - 1 - cbText);
+
+          memcpy(pR->szText + cbText, p1, cb1);
+          pR->szText[cbText + cb1] = 0;
+
+          pR->aArgs[i1].llVal = cbText;
+          cbText += cb1 + 1;
+        }
+
+        break;
     }
+  }
 
-    pSrc = p1;
+  va_end(va);
 
-  } while(pSrc && nMaxChars);
+  WB_MEMORY_BARRIER(); // the record is complete before the reader can see it
 
-  return iRval;
+  pT->nWrite = nWrite + 1;
 }
 
-const char *WBStringNextLine(const char *pSrc, unsigned int *pnMaxChars)
+int WBDebugLogStart(const char *szFileName)
 {
-int nMaxChars;
+FILE *pOut;
 
-  if(!pSrc)
-  {
-    if(pnMaxChars)
-    {
-      *pnMaxChars = 0;
-    }
 
-    return NULL;
-  }
+  pthread_once(&xLogOnce, __DebugLogKeyInit);
 
-  if(pnMaxChars)
+  if(!bLogKey)
   {
-    nMaxChars = *pnMaxChars;
+    return -1;
   }
-  else if(!*pSrc)
+
+  pthread_mutex_lock(&xLogMutex);
+
+  if(pLogOut) // already running
   {
-    return NULL; // end of string (no more)
+    pthread_mutex_unlock(&xLogMutex);
+
+    return 0;
   }
-  else
+
+  if(!szFileName || !*szFileName || !strcmp(szFileName, "-"))
   {
-    nMaxChars = strlen(pSrc);
+    pOut = stderr;
   }
-
-  // TODO:  handle MBCS differently? (for now, no special handling)
-
-  while(nMaxChars > 0)
+  else
   {
-    if(*pSrc == '\r')
-    {
-      pSrc++;
-      nMaxChars--;
-
-      if(nMaxChars > 0 && *pSrc == '\n')
-      {
-        pSrc++;
-        nMaxChars--;
-      }
+    pOut = fopen(szFileName, "w");
 
-      break;
-    }
-    else if(*pSrc == '\n')
+    if(!pOut)
     {
-      pSrc++;
-      nMaxChars--;
-
-      if(nMaxChars > 0 && *pSrc == '\r')
-      {
-        pSrc++;
-        nMaxChars--;
-      }
+      pthread_mutex_unlock(&xLogMutex);
 
-      break;
-    }
-    else if(*pSrc == '\f' || // form feed is like a newline
-            *pSrc == '\v')   // vertical tab (similar, for now)
-    {
-      pSrc++;
-      nMaxChars--;
+      WB_ERROR_PRINT("ERROR:  %s - unable to create %s, errno=%d\n", __FUNCTION__, szFileName, errno);
 
-      break;
+      return -1;
     }
-// TODO:  check for UTF-8 paragraph and line separators?
-//        http://www.unicodemap.org/details/0x2028/index.html  (line separator - alternate LF?)
-//        http://www.unicodemap.org/details/0x202A/index.html  (paragraph separator - alternate to CTRL+L ?)
-//
-    else if(!*pSrc) // TODO:  test for unicode?  normally we just assume UTF-8 is compatible with ASCII
-    {
-      nMaxChars = 0;
-      break;
-    }
-
-    pSrc++;
-    nMaxChars--;
   }
 
-  if(pnMaxChars)
+  if(!nsLogBase) // the time base stays the same from now on
   {
-    *pnMaxChars = nMaxChars;
+    nsLogBase = WBGetMonotonicTimeNS();
+    tLogBase = __ProfileTimeStamp();
   }
 
-  return pSrc;
-}
-
-
-
-
-/////////////////////////////////////////////////////////////////////////////////////
-//                                                                                 //
-//   ____         _         _                _   _              _                  //
-//  |  _ \  ___  (_) _ __  | |_  ___  _ __  | | | |  __ _  ___ | |__    ___  ___   //
-//  | |_) |/ _ \ | || '_ \ | __|/ _ \| '__| | |_| | / _` |/ __|| '_ \  / _ \/ __|  //
-//  |  __/| (_) || || | | || |_|  __/| |    |  _  || (_| |\__ \| | | ||  __/\__ \  //
-//  |_|    \___/ |_||_| |_| \__|\___||_|    |_| |_| \__,_||___/|_| |_| \___||___/  //
-//                                                                                 //
-//                                                                                 //
-/////////////////////////////////////////////////////////////////////////////////////
-
-typedef struct __pointer_hash__
-{
-  WB_UINT32 uiHash;     // 32-bit pointer hash value, must be zero for 'free' entry
-  void *pValue;         // NULL if unused entry, else the pointer value
-  WB_UINT32 dwTick;     // millis count when I last created/referenced this hash
-  WB_UINT32 dwRefCount; // reference count (deleted on '0')
-} POINTER_HASH;
+  pLogOut = pOut;
+  bLogQuit = 0;
+  bLogLineStart = 1;
 
-typedef struct __hash__aging__entry__
-{
-  WB_UINT32 uiHash;     // 32-bit pointer hash value, must be zero for 'free' entry
-  WB_UINT32 dwTick;     // millis count when I last created/referenced this hash
-} HASH_AGING_ENTRY;
+  if(pthread_create(&thrdLog, NULL, __DebugLogThreadProc, NULL))
+  {
+    if(pOut != stderr)
+    {
+      fclose(pOut);
+    }
 
-static POINTER_HASH *pPointerHashes = NULL; // WBAlloc'd array
-static int nPointerHash = 0, nMaxPointerHash = 0; // for now, simple array
+    pLogOut = NULL;
 
-static HASH_AGING_ENTRY *pHashAgingTable = NULL;
-static int nHashAgingHead = 0, nHashAgingTail = 0;
+    pthread_mutex_unlock(&xLogMutex);
 
-static volatile WB_UINT32 uiPointerHashSpinlock = 0;
+    WB_ERROR_PRINT("ERROR:  %s - unable to create the flusher thread\n", __FUNCTION__);
 
-static void WBFreePointerHashes(void)
-{
-  if(pPointerHashes)
-  {
-    WBFree(pPointerHashes);
-    pPointerHashes = NULL;
+    return -1;
   }
 
-  if(pHashAgingTable)
-  {
-    WBFree(pHashAgingTable);
-    pHashAgingTable = NULL;
-  }
+  bLogThread = 1;
 
-  nPointerHash = 0;
-  nMaxPointerHash = 0;
+  pthread_mutex_unlock(&xLogMutex);
 
-  nHashAgingHead = 0;
-  nHashAgingTail = 0;
+  pthread_mutex_lock(&xLogTextMutex);
+  bLogTextOpen = 1;
+  pthread_mutex_unlock(&xLogTextMutex);
 
-  uiPointerHashSpinlock = 0;
+  bWBDebugLogEnabled = 1;
+
+  return 0;
 }
 
-// only call when uiPointerHashSpinlock owned
-static void __AddPointerHashToAgingTable(WB_UINT32 uiHash, WB_UINT32 dwTick)
+void WBDebugLogStop(void)
 {
-  if(!pHashAgingTable)
-    return;
+  bWBDebugLogEnabled = 0;
 
-//  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
-//  {
-//    WBDelay(100);  // 100 microseconds
-//  }
+  pthread_mutex_lock(&xLogMutex);
 
-  if(((nHashAgingTail + 1) % WB_HASH_JAM_PREVENTER_SIZE)
-     == nHashAgingHead)
+  if(!bLogThread)
   {
-    nHashAgingHead = (nHashAgingHead + 1) % WB_HASH_JAM_PREVENTER_SIZE;
+    pthread_mutex_unlock(&xLogMutex);
+
+    return;
   }
 
-  pHashAgingTable[nHashAgingTail].uiHash = uiHash;
-  pHashAgingTable[nHashAgingTail].dwTick = dwTick;
+  bLogThread = 0;
+  bLogQuit = 1;
 
-  nHashAgingTail = (nHashAgingTail + 1) % WB_HASH_JAM_PREVENTER_SIZE;
+  pthread_cond_signal(&xLogCond);
+  pthread_mutex_unlock(&xLogMutex);
 
-//  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
-}
+  pthread_mutex_lock(&xLogTextMutex);
+  bLogTextOpen = 0; // from now on, text goes directly to stderr (the final drain gets what's queued)
+  pthread_mutex_unlock(&xLogTextMutex);
 
-// only call when uiPointerHashSpinlock owned
-static int __IsPointerHashInAgingTable(WB_UINT32 uiHash, WB_UINT32 dwTick)
-{
-int i1, iRval = 0;
+  pthread_join(thrdLog, NULL);
 
-  if(!pHashAgingTable)
-    return 0;
+  pthread_mutex_lock(&xLogMutex);
 
-//  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
-//  {
-//    WBDelay(100);  // 100 microseconds
-//  }
+  __DebugLogDrain(); // anything that was recorded after the flusher thread's last pass
 
-  for(i1 = nHashAgingHead; i1 != nHashAgingTail;  // wrap around with head/tail pointer
-      i1 = (i1 + 1) % WB_HASH_JAM_PREVENTER_SIZE)
+  if(pLogOut && pLogOut != stderr)
   {
-    if(i1 == nHashAgingHead && (dwTick - pHashAgingTable[i1].dwTick) >= WB_HASH_JAM_PREVENTER_TIMEOUT)
-    {
-      nHashAgingHead++;
-    }
-    else if(pHashAgingTable[i1].uiHash == uiHash)
-    {
-      iRval = 1;
-      break;
-    }
+    fclose(pLogOut);
   }
 
-//  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
-  return iRval;
+  pLogOut = NULL;
+
+  pthread_mutex_unlock(&xLogMutex);
 }
 
-WB_UINT32 WBCreatePointerHash(void *pPointer)
+void WBDebugLogFlush(void)
 {
-int i1, iFreeIndex;
-WB_UINT32 uiRval = 0;
-WB_UINT32 dw1, dwTick = (WB_UINT32)(WBGetTimeIndex() >> 10); // fast 'millis', micros / 1024
-
-
-  if(!pPointer)
-  {
-    return 0; // not valid, just return zero
-  }
+  pthread_mutex_lock(&xLogMutex);
 
-  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
-  {
-    WBDelay(100);
-  }
+  __DebugLogDrain();
 
-  if(!pPointerHashes)
-  {
-    nMaxPointerHash = WB_POINTER_HASH_INITIAL_SIZE;   // initial size
-    pPointerHashes = (POINTER_HASH *)WBAlloc(nMaxPointerHash * sizeof(*pPointerHashes));
+  pthread_mutex_unlock(&xLogMutex);
+}
 
-    nPointerHash = 0;
-  }
 
-  if(!pHashAgingTable)
-  {
-    pHashAgingTable = (HASH_AGING_ENTRY *)WBAlloc(sizeof(*pHashAgingTable)
-                                                  * (WB_HASH_JAM_PREVENTER_SIZE + 1));
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//      ____               _                     _   _  _    _  _           //
+//     / ___|  _   _  ___ | |_  ___  _ __ ___   | | | || |_ (_)| | ___      //
+//     \___ \ | | | |/ __|| __|/ _ \| '_ ` _ \  | | | || __|| || |/ __|     //
+//      ___) || |_| |\__ \| |_|  __/| | | | | | | |_| || |_ | || |\__ \     //
+//     |____/  \__, ||___/ \__|\___||_| |_| |_|  \___/  \__||_||_||___/     //
+//             |___/                                                        //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
 
-    nHashAgingHead = 0;
-    nHashAgingTail = 0;
-  }
+#define FOUR_HUNDRED_YEARS (400 * 365 + 24 * 4 + 1)
+static int  total_days[13]={0,31,59,90,120,151,181,212,243,273,304,334,365};
+static int  total_leap[13]={0,31,60,91,121,152,182,213,244,274,305,335,366};
+static WB_TIME epoch_time = 25568; // 1900-based date offset from epoch
 
-  if(!pPointerHashes || !pHashAgingTable)
-  {
-    goto return_point;
-  }
-  else if(nPointerHash >= nMaxPointerHash)
-  {
-    void *pTemp = WBReAlloc(pPointerHashes,
-                            (nMaxPointerHash + WB_POINTER_HASH_INITIAL_SIZE / 2)
-                            * sizeof(*pPointerHashes));
+WB_TIME WBGetSystemTime(void)
+{
+#if defined(WIN32)
 
-    if(!pTemp)
-    {
-      goto return_point;
-    }
+#ifdef _USE_32BIT_TIME_T /* see time.h */
+#error you must not use 32-bit time_t value, use 64-bit only
+#endif // _USE_32BIT_TIME_T
 
-    pPointerHashes = (POINTER_HASH *)pTemp; // new, re-alloc'd pointer
-    nMaxPointerHash += 256;
+SYSTEMTIME st;
+int64_t l1;
+int n_years;
+long adjustment;
 
-//    WB_ERROR_PRINT("TEMPORARY:  %s - new # of hashes %d\n", __FUNCTION__, nMaxPointerHash);
-  }
 
-  // first, check for a match, and the first 'free' index
-  for(i1=0, iFreeIndex = -1; i1 < nPointerHash; i1++)
-  {
-    if(pPointerHashes[i1].pValue == pPointer)
-    {
-      if(uiRval) // more than one?
-      {
-        WB_ERROR_PRINT("ERROR:  %s - matching 'pPointer' %p for multiple hash entries\n", __FUNCTION__, pPointer);
-      }
-      else // NOTE:  if this entry is too old, I won't re-use it - otherwise I reset the tick
-      {
-        uiRval = pPointerHashes[i1].uiHash;
+   GetSystemTime(&st);
 
-        if((dwTick - pPointerHashes[i1].dwTick) > WB_SECURE_HASH_TIMEOUT) // too old?
-          goto aged_entry_timeout;
+    // convert to days since 1/1/1970
 
-        pPointerHashes[i1].dwTick = dwTick; // new timestamp
-        pPointerHashes[i1].dwRefCount++; // increase ref count
+   n_years = st.wYear - 1900;    /* # of years since 1900 */
+   adjustment = 0;
 
-        // NOTE:  I will only use this one.  but I'll check the rest for timeout by continuing
-      }
-    }
-    else if(!pPointerHashes[i1].pValue &&
-            !pPointerHashes[i1].uiHash) // a free entry
-    {
-      if(iFreeIndex < 0)               // no free index found (yet)
-      {
-        iFreeIndex = i1; // first free entry found
-      }
-    }
-    else if((dwTick - pPointerHashes[i1].dwTick) > WB_SECURE_HASH_TIMEOUT) // auto cleanup part
-    {
-aged_entry_timeout:
-      // checking for timeout, and erasing things if timed out
+   while(n_years<0)
+   {
+      n_years += 400;                       /* add 400 years */
+      adjustment -= FOUR_HUNDRED_YEARS;    /* number of days in 400 years */
+   }
 
-//      WB_ERROR_PRINT("TEMPORARY:  %s - deleting 'aged' entry, timeout = %u\n", __FUNCTION__,
-//                     (dwTick - pPointerHashes[i1].dwTick));
-//      WB_ERROR_PRINT("   %2d : %08xH %10u %4u %p\n",
-//                     i1, pPointerHashes[i1].uiHash, pPointerHashes[i1].dwTick,
-//                     pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue);
+   while(n_years >=400)
+   {
+      n_years -= 400;
+      adjustment += FOUR_HUNDRED_YEARS;
+   }
+      /*    CALCULATE THE TOTAL NUMBER OF DAYS UP TO 1/1 THIS YEAR    */
+      /* terms:  # of days + # of "Feb/29"s - # of non-leap centuries */
 
-      // too old - erase it, freeing up the location
+   l1 = 365L * n_years + ((n_years > 4)?((n_years - 1) >> 2):0)
+        + ((n_years > 100)?(1 - (n_years - 1)/ 100):0);
 
-      __AddPointerHashToAgingTable(pPointerHashes[i1].uiHash, dwTick);
+   if(((st.wYear % 400)==0 || (st.wYear % 100)!=0) && (st.wYear % 4)==0)
+      l1 += total_leap[st.wMonth - 1];    /* month-to-date totals (leap year) */
+   else
+      l1 += total_days[st.wMonth - 1];    /* month-to-date totals */
 
-      pPointerHashes[i1].uiHash = 0; // also needed to mark it 'free'
-      pPointerHashes[i1].dwTick = 0;
-      pPointerHashes[i1].pValue = NULL; // thus marking it 'free'
-      pPointerHashes[i1].dwRefCount = 0; // regardless of ref count, remove it
+   l1 += st.wDay + adjustment; // days since 1/1/1900 (a '1')
 
-      if(iFreeIndex < 0) // no free index yet?  remember it
-      {
-        iFreeIndex = i1;
-      }
-    }
-  }
+   // convert to days since epoch (1/1/1970, a '1')
+   l1 -= epoch_time;
 
-  if(uiRval) // found one??
-  {
-    goto return_point;
-  }
+   // convert to seconds (00:00:00 AM UTC)
+   l1 *= 86400;
 
+   return (WB_TIME)l1;
+#elif __SIZEOF_LONG__ <= 4 // !WIN32, 32-bit time_t
 
-  // at this point, did NOT find a match, so I need to create it
+#ifndef NO_DEBUG
+#warning 32-bit time_t is only valid until 2038 - use 64-bit OS to avoid Y2K38
+#warning rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
+#endif
+//
+// TODO - rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
+struct timeval tv;
 
-  if(iFreeIndex < 0) // not re-using an entry?
-  {
-    iFreeIndex = nPointerHash++; // increment total count, use last entry
-  }
+  // 32-bit time_t - rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
 
-  pPointerHashes[iFreeIndex].pValue = pPointer;
-  pPointerHashes[iFreeIndex].dwTick = dwTick;
-  pPointerHashes[iFreeIndex].dwRefCount = 1;
+  gettimeofday(&tv, NULL); // for now, just use this.
 
-  // calculate a hash and ee if there's a 'crash' between two identical hashes
-  // it's not likely, but it IS possible.  So test for it.
+  return (WB_TIME)tv.tv_sec;
+#else // 64-bit time_t, !WIN32
+struct timeval tv;
 
-  dw1 = dwTick;
+  gettimeofday(&tv, NULL);
 
-  while(1) /* we assume it will bust out eventually */
-  {
-    uiRval = ((WB_UINT32)((WB_UINT64)pPointer) ^ (dw1 * 31)) & 0xffffffff;
-    // NOTE:  this should, in theory, work within a very short time, giving good randomness
+  return (WB_TIME)tv.tv_sec;
+#endif // WIN32
+}
 
-    if(uiRval) // can't allow a zero (this should be RARE, if ever at all)
-    {
-      for(i1=0; i1 < nPointerHash; i1++)
-      {
-        if(pPointerHashes[i1].uiHash == uiRval)
-        {
-          break;
-        }
-      }
 
-      if(i1 >= nPointerHash &&                         // no matching entry found
-         !__IsPointerHashInAgingTable(uiRval, dwTick)) // check aging table
-      {
-        break;
-      }
-    }
+#if defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
+WB_UINT64 WBGetTimeIndex(void)
+#else // !defined(HAS_WB_UINT64_BUILTIN) && !defined(__DOXYGEN__)
+WB_UINT32 WBGetTimeIndex(void)
+#endif // defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
+{
+#ifdef WIN32
+SYSTEMTIME st;
+int64_t l1;
+int n_years;
+long adjustment;
 
-    dw1 -= 113; // decrement it by a prime number so I can test for it
-                // being there again, but with a different hash value
-  }
 
-  pPointerHashes[iFreeIndex].uiHash = uiRval; // save this value where the free index resides
+   GetSystemTime(&st);
 
-//  WB_ERROR_PRINT("TEMOPRARY:  %s - adding hash %u for %p at %d\n", __FUNCTION__, uiRval, pPointer, iFreeIndex);
+    // convert to days since 1/1/1970
 
+   n_years = st.wYear - 1900;    /* # of years since 1900 */
+   adjustment = 0;
 
-return_point:
+   while(n_years<0)
+   {
+      n_years += 400;                       /* add 400 years */
+      adjustment -= FOUR_HUNDRED_YEARS;    /* number of days in 400 years */
+   }
 
-  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
+   while(n_years >=400)
+   {
+      n_years -= 400;
+      adjustment += FOUR_HUNDRED_YEARS;
+   }
+      /*    CALCULATE THE TOTAL NUMBER OF DAYS UP TO 1/1 THIS YEAR    */
+      /* terms:  # of days + # of "Feb/29"s - # of non-leap centuries */
 
-//  if(!uiRval)
-//  {
-//    WB_ERROR_PRINT("TEMPORARY:  %s - did NOT create hash for pointer %p\n", __FUNCTION__, pPointer);
-//  }
+   l1 = 365L * n_years + ((n_years > 4)?((n_years - 1) >> 2):0)
+        + ((n_years > 100)?(1 - (n_years - 1)/ 100):0);
 
-  return uiRval;
-}
+   if(((st.wYear % 400)==0 || (st.wYear % 100)!=0) && (st.wYear % 4)==0)
+      l1 += total_leap[st.wMonth - 1];    /* month-to-date totals (leap year) */
+   else
+      l1 += total_days[st.wMonth - 1];    /* month-to-date totals */
 
-void WBDestroyPointerHash(WB_UINT32 uiHash)
-{
-int i1;
-WB_UINT32 dwTick = (WB_UINT32)(WBGetTimeIndex() >> 10); // fast 'millis', micros / 1024
+   l1 += st.wDay + adjustment; // days since 1/1/1900 (a '1')
 
+   // convert to days since epoch (1/1/1970, a '1')
+   l1 -= epoch_time;
 
-  if(!uiHash)
-  {
-    return; // not valid, just return
-  }
+   // convert to seconds (00:00:00 AM UTC)
+   l1 *= 86400;
 
-  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
-  {
-    WBDelay(100);
-  }
+   // adjust for UTC time
+   l1 += st.wHour * 3600L + st.wMinute * 60L + st.wSecond;
 
-  for(i1=0; i1 < nPointerHash; i1++)
-  {
-    if(!pPointerHashes[i1].pValue &&
-       !pPointerHashes[i1].uiHash) // a free entry
-    {
-      continue;
-    }
+   // conver to mucroseconds
+   l1 *= 1000000L;
 
-    // check timeouts first, THEN destroy via decremented ref count
+   // add milliseconds from 'st' a microseconds
+   l1 += st.wMilliseconds * 1000L;
 
-    if((dwTick - pPointerHashes[i1].dwTick) > WB_SECURE_HASH_TIMEOUT) // check for aging while I'm at it
-    {
-//      WB_ERROR_PRINT("TEMPORARY:  %s - deleting 'aged' entry, timeout = %u\n", __FUNCTION__,
-//                     (dwTick - pPointerHashes[i1].dwTick));
-//      WB_ERROR_PRINT("   %2d : %08xH %10u %4u %p\n",
-//                     i1, pPointerHashes[i1].uiHash, pPointerHashes[i1].dwTick,
-//                     pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue);
+   return (WB_UINT64)l1;
+#elif __SIZEOF_LONG__ <= 4 // !WIN32, 32-bit time_t, no support for 64-bit inmteger
+#if defined(HAS_WB_UINT64_BUILTIN) || defined(__DOXYGEN__)
+//
+// TODO - rewrite this to avoid Y2K38, by getting year, month, day etc. and converting like for WIN32
+struct timeval tv;
 
-      // erase it, freeing up the location
-erase_it:
-      __AddPointerHashToAgingTable(pPointerHashes[i1].uiHash, dwTick);
+  gettimeofday(&tv, NULL); // for now, just use this.
 
-      pPointerHashes[i1].uiHash = 0; // this zero, together with 'pValue == NULL' means it's "free"
-      pPointerHashes[i1].dwTick = 0;
-      pPointerHashes[i1].pValue = NULL; // thus marking it 'free'
-      pPointerHashes[i1].dwRefCount = 0; // regardless of ref count, remove it
-    }
-    else if(pPointerHashes[i1].uiHash == uiHash)
-    {
-//      WB_ERROR_PRINT("TEMPORARY:  %s - ref count prior to decrement = %d for %p (%08xH)\n", __FUNCTION__,
-//                     pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue,
-//                     pPointerHashes[i1].uiHash);
+  return (WB_UINT64)tv.tv_sec * (WB_UINT64)1000000
+         + (WB_UINT64)tv.tv_usec;
+#else /// HAS_WB_UINT64_BUILTIN
+struct timeval tv;
 
-      if(pPointerHashes[i1].dwRefCount)
-      {
-        pPointerHashes[i1].dwRefCount --;
-      }
+  double d1;
+  gettimeofday(&tv, NULL);
 
-      if(!(pPointerHashes[i1].dwRefCount))
-      {
-//        WB_ERROR_PRINT("TEMPORARY:  %s - deleting matching entry\n", __FUNCTION__);
-//        WB_ERROR_PRINT("   %2d : %08xH %10u %4u %p\n",
-//                       i1, pPointerHashes[i1].uiHash, pPointerHashes[i1].dwTick,
-//                       pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue);
+  d1 = tv.tv_sec * 1000000.0;
+  d1 += tv.tv_usec;
 
-        goto erase_it;
-      }
-    }
-  }
+  return (WB_UINT32)floor(fmod(d1, (double)0xffffffff));
+#endif // HAS_WB_UINT64_BUILTIN
+#else // 64-bit time_t, !WIN32
+struct timeval tv;
 
-  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
+  gettimeofday(&tv, NULL);
+
+  return (WB_UINT64)tv.tv_sec * (WB_UINT64)1000000
+         + (WB_UINT64)tv.tv_usec;
+#endif // WIN32
 }
 
-void WBDestroyPointerHashPtr(void *pPointer)
+WB_UINT64 WBGetMonotonicTimeNS(void)
 {
-int i1;
-WB_UINT32 dwTick = (WB_UINT32)(WBGetTimeIndex() >> 10); // fast 'millis', micros / 1024
+struct timespec ts;
 
+  clock_gettime(CLOCK_MONOTONIC, &ts);
 
-  if(!pPointer)
-  {
-    return; // not valid, just return
-  }
+  return (WB_UINT64)ts.tv_sec * 1000000000 + (WB_UINT64)ts.tv_nsec;
+}
 
-  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
+void WBDelay(uint32_t uiDelay)  // approximate delay for specified period (in microseconds).  may be interruptible
+{
+#ifdef WIN32
+  if(uiDelay <= 1000)
+    Sleep(1);
+  else
+    Sleep(uiDelay / 1000);
+#else // WIN32
+#ifdef HAVE_NANOSLEEP
+struct timespec tsp;
+
+  if(WB_UNLIKELY(uiDelay >= 1000000L))
   {
-    WBDelay(100);
+    tsp.tv_sec = uiDelay / 1000000L;
+    uiDelay = uiDelay % 1000000L; // number of microseconds converted to nanoseconds
   }
-
-  for(i1=0; i1 < nPointerHash; i1++)
+  else
   {
-    if(!pPointerHashes[i1].uiHash && !pPointerHashes[i1].pValue)
-    {
-      continue; // free entry, ignore it
-    }
+    tsp.tv_sec = 0; // it's assumed that this method is slightly faster
+  }
 
-    if((dwTick - pPointerHashes[i1].dwTick) > WB_SECURE_HASH_TIMEOUT) // check for aging while I'm at it
-    {
-//      WB_ERROR_PRINT("TEMPORARY:  %s - deleting 'aged' entry, timeout = %u\n", __FUNCTION__,
-//                     (dwTick - pPointerHashes[i1].dwTick));
-//      WB_ERROR_PRINT("   %2d : %08xH %10u %4u %p\n",
-//                     i1, pPointerHashes[i1].uiHash, pPointerHashes[i1].dwTick,
-//                     pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue);
+  tsp.tv_nsec = uiDelay * 1000;  // wait for .1 msec
 
-      // erase it, freeing up the location (hash will be zero)
+  nanosleep(&tsp, NULL);
+#else  // HAVE_NANOSLEEP
 
-erase_it:
-      __AddPointerHashToAgingTable(pPointerHashes[i1].uiHash, dwTick);
+  usleep(uiDelay);  // 100 microsecs - a POSIX alternative to 'nanosleep'
 
-      pPointerHashes[i1].uiHash = 0; // this zero, together with 'pValue == NULL' means it's "free"
-      pPointerHashes[i1].dwTick = 0;
-      pPointerHashes[i1].pValue = NULL; // thus marking it 'free'
-      pPointerHashes[i1].dwRefCount = 0; // regardless of ref count, remove it
-
-    }
-    else if(pPointerHashes[i1].pValue == pPointer) // always free it
-    {
-//      WB_ERROR_PRINT("TEMPORARY:  %s - deleting matching entry\n", __FUNCTION__);
-//      WB_ERROR_PRINT("   %2d : %08xH %10u %4u %p\n",
-//                     i1, pPointerHashes[i1].uiHash, pPointerHashes[i1].dwTick,
-//                     pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue);
-
-      goto erase_it; // regardless of ref count, remove it (buh-bye)
-    }
-  }
-
-  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
+#endif // HAVE_NANOSLEEP
+#endif // WIN32
 }
 
-void * WBGetPointerFromHash(WB_UINT32 uiHash)
+// bucket index for a value.  values below 32 are exact, and after that each power of 2 has
+// (1 << WB_HISTOGRAM_SUB_BITS) buckets, indexed by the value's top WB_HISTOGRAM_SUB_BITS + 1 bits
+static __inline__ unsigned int __HistogramBucket(WB_UINT32 nValue)
 {
-int i1;
-void *pRval = NULL;
-
+unsigned int uiExp;
 
-  if(!uiHash)
-  {
-    return NULL; // not valid, just return NULL
-  }
 
-  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
+  if(nValue < (2U << WB_HISTOGRAM_SUB_BITS))
   {
-    WBDelay(100);
+    return nValue;
   }
 
-  for(i1=0; i1 < nPointerHash; i1++)
+#ifdef __GNUC__
+  uiExp = 31 - __builtin_clz(nValue);
+#else // __GNUC__
+  for(uiExp=31; !(nValue & (1U << uiExp)); uiExp--)
   {
-    if(!pPointerHashes[i1].pValue || // for now just ignore these
-       pPointerHashes[i1].uiHash != uiHash)
-    {
-      continue; // this treats NULL pointers as a 'mismatch'
-    }
-
-    // TODO:  check for timeouts?
-
-    pRval = pPointerHashes[i1].pValue;
-    goto exit_point;
+    // find the highest bit
   }
+#endif // __GNUC__
 
+  uiExp -= WB_HISTOGRAM_SUB_BITS; // the number of low bits that don't matter
 
-exit_point:
-
-  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
-
-//  if(!pRval)
-//  {
-//    WB_ERROR_PRINT("TEMPORARY:  %s - did NOT find pointer for hash %u (%08xH)\n", __FUNCTION__, uiHash, uiHash);
-//
-//    for(i1=0; i1 < nPointerHash; i1++)
-//    {
-//      WB_ERROR_PRINT("   %2d : %08xH %10u %4u %p\n",
-//                     i1, pPointerHashes[i1].uiHash, pPointerHashes[i1].dwTick,
-//                     pPointerHashes[i1].dwRefCount, pPointerHashes[i1].pValue);
-//    }
-//
-//    WB_ERROR_PRINT("---------------------------------------------------------------------\n\n");
-//  }
-
-  return pRval; // NULL if not found
+  return (uiExp << WB_HISTOGRAM_SUB_BITS) + (nValue >> uiExp);
 }
 
+// the highest value that goes in a bucket
+static WB_UINT32 __HistogramBucketMax(unsigned int uiBucket)
+{
+unsigned int uiExp;
 
 
-//////////////////////////////////////////////////////////////////////////////
-//                                                                          //
-//                        _    _                                            //
-//                       / \  | |_  ___   _ __ ___   ___                    //
-//                      / _ \ | __|/ _ \ | '_ ` _ \ / __|                   //
-//                     / ___ \| |_| (_) || | | | | |\__ \                   //
-//                    /_/   \_\\__|\___/ |_| |_| |_||___/                   //
-//                                                                          //
-//                                                                          //
-//////////////////////////////////////////////////////////////////////////////
+  if(uiBucket < (2U << WB_HISTOGRAM_SUB_BITS))
+  {
+    return uiBucket;
+  }
 
-//---------------------------------
-// INTERNAL ATOM 'HELPER' UTILITIES
-//---------------------------------
+  uiExp = (uiBucket >> WB_HISTOGRAM_SUB_BITS) - 1;
 
-// the X11 server maintains a global list of atoms based on unique strings.  These are
-// useful for inter-application communication, but can rapidly become inefficient when applications
-// create large numbers of unique atoms names for their own custom purposes (like the X11 workbench).
-// To combat this obvious problem, these next two functions will create application-unique atoms
-// when a global atom is not available.  Global atoms are NEVER removed.  Once there, they are there
-// until the X11 server is shut down.  For that reason, these functions are really necessary.  It should
-// help minimize the resource impact of an X11 workbench toolkit application.
+  return (WB_UINT32)((((WB_UINT64)(uiBucket - (uiExp << WB_HISTOGRAM_SUB_BITS)) + 1) << uiExp) - 1);
+}
 
-// For more information, see xorg-server source
-//   specifically:  Atom MakeAtom(const char *string, unsigned len, Bool makeit)
-//   this function is located in dix/atom.c .  It allocates atoms SEQUENTIALLY, beginning with XA_LAST_PREDEFINED+1
-//   because the atoms are assigned SEQUENTIALLY, it is possible to pick a "very very big number" as the minimum
-//   internal atom's starting point, i.e. WB_INTERNAL_ATOM_MIN_VAL (which is currently FF000000H) which would allow
-//   for ~16 million internally-defined atoms.
+void WBHistogramRecord(WB_HISTOGRAM *pHist, WB_UINT32 nValue)
+{
+  if(WB_UNLIKELY(!pHist->nCount) || nValue < pHist->nMin)
+  {
+    pHist->nMin = nValue;
+  }
 
-static volatile WB_UINT32 lInternalAtomSpinner = 0L;
-static char **ppInternalAtoms = NULL;  // actual atom value starts with WB_INTERNAL_ATOM_MIN_VAL and is index within this array
-static char *pszAtomNames = NULL;
-static unsigned int cbAtomNames = 0, cbMaxAtomNames = 0;
-static unsigned int nInternalAtoms = 0, nMaxInternalAtoms = 0;
+  if(nValue > pHist->nMax)
+  {
+    pHist->nMax = nValue;
+  }
 
-#define INITIAL_INTERNAL_ATOM_SIZE 4096
-#define INITIAL_INTERNAL_ATOM_STRING_SIZE 262144
+  pHist->nCount++;
+  pHist->nSum += nValue;
+  pHist->aBuckets[__HistogramBucket(nValue)]++;
+}
 
-Atom WBGetAtom(WB_DISPLAY pDisplay, const char *szAtomName)
+WB_UINT32 WBHistogramPercentile(const WB_HISTOGRAM *pHist, double dPercentile)
 {
-Atom aRval;
-//char *p1;
-void *pTemp;
-int iLen;
+WB_UINT64 nRank, nSeen;
+WB_UINT32 nRval;
+unsigned int i1;
 
 
-  if(!szAtomName || !*szAtomName)
+  if(!pHist->nCount)
   {
-    WB_ERROR_PRINT("ERROR:  %s - bad 'szAtomName'\n", __FUNCTION__);
+    return 0;
+  }
 
-    return None;  // bad parameter
+  if(dPercentile >= 100.0)
+  {
+    return pHist->nMax;
   }
 
-  if(!pDisplay)
+  nRank = dPercentile > 0.0 ? (WB_UINT64)ceil(dPercentile * (double)pHist->nCount / 100.0) : 1;
+
+  for(i1=0, nSeen=0; i1 < WB_HISTOGRAM_BUCKETS; i1++)
   {
-    pDisplay = WBGetDefaultDisplay();
+    nSeen += pHist->aBuckets[i1];
 
-    if(!pDisplay)
+    if(nSeen >= nRank)
     {
-      WB_ERROR_PRINT("ERROR - %s - no display!\n", __FUNCTION__);
+      nRval = __HistogramBucketMax(i1);
 
-      return None;
+      return nRval > pHist->nMax ? pHist->nMax : nRval < pHist->nMin ? pHist->nMin : nRval;
     }
   }
 
-  aRval = WBLookupAtom(pDisplay, szAtomName);
+  return pHist->nMax; // should not happen
+}
 
-  if(aRval != None)
+void WBHistogramMerge(WB_HISTOGRAM *pDest, const WB_HISTOGRAM *pSrc)
+{
+unsigned int i1;
+
+
+  if(!pSrc->nCount)
   {
-    return aRval;
+    return;
   }
 
-  // allocate an internal atom
-
-  aRval = None;
+  if(!pDest->nCount || pSrc->nMin < pDest->nMin)
+  {
+    pDest->nMin = pSrc->nMin;
+  }
 
-  while(WBInterlockedExchange(&lInternalAtomSpinner, 1)) // THIS MUST BE SPIN-LOCKED
+  if(pSrc->nMax > pDest->nMax)
   {
-    WBDelay(100); // by convention just do THIS
+    pDest->nMax = pSrc->nMax;
   }
 
-  if(!ppInternalAtoms)
+  pDest->nCount += pSrc->nCount;
+  pDest->nSum += pSrc->nSum;
+
+  for(i1=0; i1 < WB_HISTOGRAM_BUCKETS; i1++)
   {
-    ppInternalAtoms = (char **)WBAlloc(INITIAL_INTERNAL_ATOM_SIZE);
+    pDest->aBuckets[i1] += pSrc->aBuckets[i1];
+  }
+}
 
-    if(!ppInternalAtoms)
-    {
-      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+int WBCPUCount(void)
+{
+// determine # of CPUs to get the default # of jobs during compile
+//    FreeBSD:  sysctl vars:  kern.smp.cpus hw.ncpu  (both have the correct count, even in a VM)
+//    Linux:  /proc/cpuinfo - filter on 'processor:', one line per active core
+//                            (in a VM, only the assigned cores show up, so count them)
+int iCPU = 0;
 
-      goto exit_point;
-    }
+#if defined(__FreeBSD__)
+// TODO:  a config option to test for 'sysctlbyname' and the sys/sysctl.h file?
+unsigned long cb;
 
-    nMaxInternalAtoms = INITIAL_INTERNAL_ATOM_SIZE;
-    nInternalAtoms = 0; // make sure
-  }
-  else if((nInternalAtoms + 1) >= nMaxInternalAtoms)
+  cb = sizeof(iCPU);
+  iCPU = 0;
+  if(sysctlbyname("hw.ncpu", &iCPU, &cb, NULL, 0)) // could also use MIBs CTL_HW and HW_NCPU
   {
-    pTemp = WBReAlloc(ppInternalAtoms, nMaxInternalAtoms + INITIAL_INTERNAL_ATOM_SIZE);
-    if(!pTemp)
-    {
-      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+//    WB_ERROR_PRINT("ERROR - %s - hw.ncpu, errno=%d  iCPU=%d  cb=%ld\n", __FUNCTION__, errno, iCPU, cb);
+    cb = sizeof(iCPU);
+    iCPU = 0;
 
-      goto exit_point;
+    if(sysctlbyname("kern.smp.cpus", &iCPU, &cb, NULL, 0)) // could also use MIBs CTL_HW and HW_NCPU
+    {
+//      WB_ERROR_PRINT("ERROR - %s - kernel.smp.cpus, errno=%d  iCPU=%d  cb=%ld\n", __FUNCTION__, errno, iCPU, cb);
+      return 0;
     }
-
-    ppInternalAtoms = (char **)pTemp;
-    nMaxInternalAtoms += INITIAL_INTERNAL_ATOM_SIZE;
   }
 
-  iLen = strlen(szAtomName) + 1; // include the '0' byte at the end
+//  WB_ERROR_PRINT("TEMPORARY:  %s - iCPU=%d\n", __FUNCTION__, iCPU);
 
-  // now for the names buffer
+  return iCPU;
 
-  if(!pszAtomNames)
-  {
-    pszAtomNames = WBAlloc(INITIAL_INTERNAL_ATOM_STRING_SIZE);
-    if(!pszAtomNames)
-    {
-      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+#elif defined(linux)
 
-      goto exit_point;
-    }
+FILE *pF;
+char tbuf[256];
+char *p1, *p2;
 
-    cbMaxAtomNames = INITIAL_INTERNAL_ATOM_STRING_SIZE;
-    cbAtomNames = 0; // make sure
-  }
-  else if((cbAtomNames + iLen + 1) >= cbMaxAtomNames) // not enough room?
+  pF = fopen("/proc/cpuinfo", "r");
+  if(pF)
   {
-    pTemp = WBReAlloc(pszAtomNames, cbMaxAtomNames + INITIAL_INTERNAL_ATOM_STRING_SIZE);
-    if(!pTemp)
+    while(fgets(tbuf, sizeof(tbuf), pF))
     {
-      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+      // read each line, then scan for 'processor' and cound 'em up
+      // NOTE:  if there's a better way, I'd like to see it...
+
+      p1 = tbuf;
+      while(*p1 && *p1 <= ' ')
+      {
+        p1++; // skip leadin white space
+      }
+
+      p2 = p1 + strlen(p1);
+      while(p2 > p1 && *(p2 - 1) <= ' ')
+      {
+        *(--p2) = 0; // trim trailing white space
+      }
 
-      goto exit_point;
+      if(!strncmp(p1, "processor", 9) &&  // TODO:  check it's unique?
+         p1[9] && p1[9] <= ' ') // typically is followed by a tab then ':'
+      {
+        iCPU++; // count them!
+      }
     }
 
-    pszAtomNames = (char *)pTemp;
-    cbMaxAtomNames += INITIAL_INTERNAL_ATOM_STRING_SIZE;
+    fclose(pF);
   }
 
-  aRval = (Atom)(nInternalAtoms + WB_INTERNAL_ATOM_MIN_VAL);
+#elif defined(WIN32)
+  iCPU == 0; // just fail (for now)
+#else
+  iCPU == 0; // just fail
+#endif // all of that
+
+  return iCPU;
+}
 
-  ppInternalAtoms[nInternalAtoms++] = pszAtomNames + cbAtomNames;
 
-  memcpy(pszAtomNames + cbAtomNames, szAtomName, iLen);
 
-  cbAtomNames += iLen;
-  pszAtomNames[cbAtomNames] = 0; // by convention
 
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//                __  __     _     _      _      ___    ____                //
+//               |  \/  |   / \   | |    | |    / _ \  / ___|               //
+//               | |\/| |  / _ \  | |    | |   | | | || |                   //
+//               | |  | | / ___ \ | |___ | |___| |_| || |___                //
+//               |_|  |_|/_/   \_\|_____||_____|\___/  \____|               //
+//                                                                          //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+// ********************
+// MEMORY SUB-ALLOCATOR
+// ********************
 
-exit_point:
+// DESIGN NOTES
+// a) allocations of up to 4k (including the header) come from 'slabs' for 7 power-of-2 size classes (64 to 4096 bytes)
+// b) a slab is a WB_SLAB_SIZE block from 'mmap', aligned on a WB_SLAB_SIZE boundary.  The WB_SLAB header is at
+//    the beginning, followed by fixed-size blocks that are handed out in order ('nCarved') and then re-used
+//    via a free list, so pages aren't touched until they're needed.
+// c) each thread caches a few free blocks per size class, so most WBAlloc/WBFree calls don't lock anything.
+//    The central per-class lists (protected by a mutex) are used in batches to fill or drain a thread's cache.
+// d) every block has a __malloc_header__.  For a slab block 'pPrev' points to the WB_SLAB and 'pNext' is
+//    PSLAB_FLAG; for a malloc'd block both are PMALLOC_FLAG.  A free block has a zero 'iTag'.
+// e) WBSubAllocTrashMasher() returns completely empty slabs to the OS with 'munmap'
+// f) statistics are counted per thread (in the WB_SLAB_CACHE) without locking, and added together when
+//    they're requested.  The live block bytes are also 'published' to global atomic counters every
+//    WB_ALLOC_STATS_BATCH bytes, which is how the peak values are kept.
+// g) with WB_ALLOC_TRACKING, the header has the index of the allocation site (file and line) in a hash table
 
-  WBInterlockedExchange(&lInternalAtomSpinner, 0);  // I'm done with it now
+static const char szWBAllocTag[]="WB_M";
+#define WB_ALLOC_TAG (*((const unsigned int *)szWBAllocTag)) /*< tag indicating it's a __malloc_header__ **/
 
-  if(aRval == None)
+#define PMALLOC_FLAG (&mallocFlagMalloc) /*< when pPrev and pNext point to THIS, it's a "malloc'd" pointer **/
+#define PSLAB_FLAG (&mallocFlagSlab)     /*< when pNext points to THIS, it's a slab block and pPrev points to its WB_SLAB **/
+
+#define WB_SLAB_SIZE 65536         /* size (and alignment) of a slab, a power of 2 */
+#define WB_SLAB_MIN_BLOCK 64       /* smallest size class (including the header) */
+#define WB_SLAB_MAX_BLOCK 4096     /* largest size class; larger blocks use 'malloc' */
+#define WB_SLAB_CLASSES 7          /* 64, 128, 256, 512, 1024, 2048, 4096 */
+#define WB_SLAB_HEADER_SIZE 64     /* space reserved for the WB_SLAB header */
+#define WB_SLAB_CACHE_BYTES 32768  /* per-thread cache limit for each size class, in bytes */
+#define WB_SLAB_CACHE_MAX 64       /* per-thread cache limit for each size class, in blocks */
+#define WB_ALLOC_STATS_BATCH 65536 /* per-thread change in live block bytes before it's published for the peak values */
+#define WB_ALLOC_SITE_MAX 4096     /* size of the allocation site hash table, a power of 2 */
+#define WB_ALLOC_TOP_SITES_MAX 64  /* maximum number of sites listed by WBAllocDumpStats */
+
+#if WB_ALLOC_STATS_CLASSES != WB_SLAB_CLASSES + 1
+#error WB_ALLOC_STATS_CLASSES must be WB_SLAB_CLASSES + 1 (for 'malloc' blocks)
+#endif // WB_ALLOC_STATS_CLASSES
+
+struct __malloc_header__
+{
+  union
   {
-    WB_ERROR_PRINT("ERROR:  %s - could not allocate new atom %u for %s\n", __FUNCTION__, (unsigned int)aRval, szAtomName);
-  }
-//  else
-//  {
-//    WB_ERROR_PRINT("TEMPORARY:  %s - allocating new atom %u for %s\n", __FUNCTION__, (unsigned int)aRval, szAtomName);
-//  }
+    struct
+    {
+      struct __malloc_header__ *pPrev, *pNext;  ///< For a 'malloc'd block, these are both PMALLOC_FLAG
+      unsigned int iTag;                        ///< see WB_ALLOC_TAG
+      unsigned int cbSize;                      ///< size used for last malloc/realloc
+      unsigned int cbRequest;                   ///< size requested by the caller (for statistics)
+      unsigned int uiSite;                      ///< allocation site index (see WB_ALLOC_TRACKING), or 0
+    };
+    uint8_t reserved[32];                       ///< 32 byte (256 bit) minimum size to improve alignment
+  };
+};
 
-  return aRval;
-//  aRval = XInternAtom(pDisplay, szAtomName, False); // temporarily, just do this
-}
+static struct __malloc_header__ mallocFlagMalloc; // pointers to THIS indicate "I am a 'malloc'd block"
+static struct __malloc_header__ mallocFlagSlab;   // pointers to THIS indicate "I am a slab block"
 
-Atom WBLookupAtom(WB_DISPLAY pDisplay, const char *szAtomName)
+typedef struct __WB_SLAB__
 {
-Atom aRval;
-unsigned int i1;
+  struct __WB_SLAB__ *pNext, *pPrev;  // 'available' list for the size class (only when it has free blocks)
+  struct __malloc_header__ *pFree;    // free blocks, linked via 'pNext'
+  unsigned int nClass;                // size class index
+  unsigned int nBlockSize;            // block size, including the header
+  unsigned int nBlocks;               // total number of blocks
+  unsigned int nCarved;               // blocks [0, nCarved) have been handed out at least once
+  unsigned int nUsed;                 // blocks that are allocated (or in a thread's cache)
+  int bAvailable;                     // non-zero if it's in the 'available' list
+} WB_SLAB;
+
+typedef struct __WB_SLAB_CLASS__
+{
+  pthread_mutex_t mtx;    // protects everything that belongs to this size class
+  WB_SLAB *pAvailable;    // slabs that have at least one free block
+  unsigned int nSlabs;    // total slabs for this size class
+} WB_SLAB_CLASS;
 
+typedef struct __WB_ALLOC_COUNTERS__
+{
+  WB_INT64 nAllocs, nFrees;  // totals
+  WB_INT64 cbLive;           // net requested bytes
+  WB_INT64 cbLiveBlock;      // net block bytes
+  WB_INT64 cbUnpublished;    // change in 'cbLiveBlock' not yet added to 'acbAllocPublished'
+} WB_ALLOC_COUNTERS;
 
-  if(!szAtomName || !*szAtomName)
-  {
-    WB_ERROR_PRINT("ERROR:  %s - bad 'szAtomName'\n", __FUNCTION__);
+typedef struct __WB_SLAB_CACHE__
+{
+  struct __WB_SLAB_CACHE__ *pNext, *pPrev;           // list of all threads' caches (for statistics)
+  struct __malloc_header__ *apFree[WB_SLAB_CLASSES]; // cached free blocks, linked via 'pNext'
+  unsigned int anFree[WB_SLAB_CLASSES];
+  WB_ALLOC_COUNTERS aCounters[WB_ALLOC_STATS_CLASSES]; // this thread's statistics (only this thread writes them)
+} WB_SLAB_CACHE;
 
-    return None;  // bad parameter
-  }
+typedef struct __WB_ALLOC_SITE__
+{
+  const char *szFile;        // NULL if the entry isn't used
+  int iLine;
+  WB_INT64 nAllocs, nLive;   // total allocations, and blocks that are still allocated
+  WB_INT64 cbLive, cbPeak;   // requested bytes for the live blocks, and the high-water mark
+} WB_ALLOC_SITE;
 
-  if(!pDisplay)
-  {
-    pDisplay = WBGetDefaultDisplay();
-  }
+static WB_SLAB_CLASS aSlabClass[WB_SLAB_CLASSES] =
+{
+  { PTHREAD_MUTEX_INITIALIZER, NULL, 0 }, { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+  { PTHREAD_MUTEX_INITIALIZER, NULL, 0 }, { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+  { PTHREAD_MUTEX_INITIALIZER, NULL, 0 }, { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+  { PTHREAD_MUTEX_INITIALIZER, NULL, 0 }
+};
 
+static pthread_key_t keySlabCache;
+static pthread_once_t xSlabCacheOnce = PTHREAD_ONCE_INIT;
+static int bSlabCacheKey = 0;  // non-zero if 'keySlabCache' is valid
 
-  // look up internal atoms FIRST...
+static pthread_mutex_t xAllocStatsMutex = PTHREAD_MUTEX_INITIALIZER; // protects 'pSlabCacheList' and 'aAllocRetired'
+static WB_SLAB_CACHE *pSlabCacheList = NULL;
+static WB_ALLOC_COUNTERS aAllocRetired[WB_ALLOC_STATS_CLASSES]; // counts from exited threads (and threads without a cache)
+static volatile WB_INT64 acbAllocPublished[WB_ALLOC_STATS_CLASSES + 1]; // published live block bytes (the last one is the total)
+static volatile WB_INT64 acbAllocPeak[WB_ALLOC_STATS_CLASSES + 1];      // high-water marks for 'acbAllocPublished'
 
-  aRval = None;
+static pthread_mutex_t xAllocSiteMutex = PTHREAD_MUTEX_INITIALIZER; // protects 'pAllocSites'
+static WB_ALLOC_SITE *pAllocSites = NULL; // hash table with WB_ALLOC_SITE_MAX entries, allocated on first use.  [0] isn't used.
 
-  while(WBInterlockedExchange(&lInternalAtomSpinner, 1)) // THIS MUST BE SPIN-LOCKED
-  {
-    WBDelay(100); // by convention just do THIS
+static void __AllocPublish(unsigned int nClass, WB_INT64 cbDelta);
+
+
+static __inline__ unsigned int __SlabClassSize(unsigned int nClass)
+{
+  return WB_SLAB_MIN_BLOCK << nClass;
+}
+
+static __inline__ unsigned int __SlabCacheLimit(unsigned int nClass)
+{
+unsigned int nRval = WB_SLAB_CACHE_BYTES / __SlabClassSize(nClass);
+
+  return nRval > WB_SLAB_CACHE_MAX ? WB_SLAB_CACHE_MAX : nRval;
+}
+
+static WB_SLAB * __SlabCreate(unsigned int nClass) // size class mutex must be locked
+{
+unsigned char *pMem, *pAligned;
+size_t cbExtra;
+WB_SLAB *pRval;
+
+
+  // allocate twice the size, then trim so the slab is aligned on a WB_SLAB_SIZE boundary
+
+  pMem = (unsigned char *)mmap(NULL, WB_SLAB_SIZE * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+
+  if(pMem == (unsigned char *)MAP_FAILED)
+  {
+    return NULL;
+  }
+
+  pAligned = (unsigned char *)(((unsigned long)pMem + WB_SLAB_SIZE - 1) & ~((unsigned long)WB_SLAB_SIZE - 1));
+  cbExtra = pAligned - pMem;
+
+  if(cbExtra)
+  {
+    munmap(pMem, cbExtra);
+  }
+
+  munmap(pAligned + WB_SLAB_SIZE, WB_SLAB_SIZE - cbExtra);
+
+  pRval = (WB_SLAB *)pAligned; // mmap'd memory is zeroed
+
+  pRval->nClass = nClass;
+  pRval->nBlockSize = __SlabClassSize(nClass);
+  pRval->nBlocks = (WB_SLAB_SIZE - WB_SLAB_HEADER_SIZE) / pRval->nBlockSize;
+
+  aSlabClass[nClass].nSlabs++;
+
+  return pRval;
+}
+
+static void __SlabLinkAvailable(WB_SLAB_CLASS *pSC, WB_SLAB *pSlab) // size class mutex must be locked
+{
+  pSlab->pPrev = NULL;
+  pSlab->pNext = pSC->pAvailable;
+
+  if(pSC->pAvailable)
+  {
+    pSC->pAvailable->pPrev = pSlab;
+  }
+
+  pSC->pAvailable = pSlab;
+  pSlab->bAvailable = 1;
+}
+
+static void __SlabUnlinkAvailable(WB_SLAB_CLASS *pSC, WB_SLAB *pSlab) // size class mutex must be locked
+{
+  if(pSlab->pPrev)
+  {
+    pSlab->pPrev->pNext = pSlab->pNext;
+  }
+  else
+  {
+    pSC->pAvailable = pSlab->pNext;
+  }
+
+  if(pSlab->pNext)
+  {
+    pSlab->pNext->pPrev = pSlab->pPrev;
   }
 
-  if(ppInternalAtoms && pszAtomNames && nInternalAtoms > 0)
+  pSlab->pNext = pSlab->pPrev = NULL;
+  pSlab->bAvailable = 0;
+}
+
+// get up to 'nCount' free blocks for a size class, linked via 'pNext'.  Returns the number of blocks.
+static unsigned int __SlabGetBlocks(unsigned int nClass, unsigned int nCount, struct __malloc_header__ **ppList)
+{
+WB_SLAB_CLASS *pSC = aSlabClass + nClass;
+WB_SLAB *pSlab;
+struct __malloc_header__ *pMH, *pList = NULL;
+unsigned int nRval = 0;
+
+
+  pthread_mutex_lock(&(pSC->mtx));
+
+  while(nRval < nCount)
   {
-    // TODO: use some kind of hashing algorithm?  for now, if the list is short enough,
-    //       this actually replicates what the X Server does with its own atoms.
+    pSlab = pSC->pAvailable;
 
-    for(i1=0; i1 < nInternalAtoms; i1++)
+    if(!pSlab)
     {
-      if(!strcmp(szAtomName, ppInternalAtoms[i1]))
+      pSlab = __SlabCreate(nClass);
+
+      if(!pSlab)
       {
-        aRval = (Atom)(i1 + WB_INTERNAL_ATOM_MIN_VAL);
-        break;
+        break; // out of memory (return what I have)
       }
+
+      __SlabLinkAvailable(pSC, pSlab);
     }
-  }
 
-  WBInterlockedExchange(&lInternalAtomSpinner, 0);  // I'm done with it now
+    while(nRval < nCount)
+    {
+      if(pSlab->pFree)
+      {
+        pMH = pSlab->pFree;
+        pSlab->pFree = pMH->pNext;
+      }
+      else if(pSlab->nCarved < pSlab->nBlocks)
+      {
+        pMH = (struct __malloc_header__ *)((unsigned char *)pSlab + WB_SLAB_HEADER_SIZE
+                                           + pSlab->nBlockSize * (pSlab->nCarved++));
+        pMH->pPrev = (struct __malloc_header__ *)pSlab;
+      }
+      else
+      {
+        break;
+      }
 
-  if(aRval != None)
-  {
-//    WB_ERROR_PRINT("TEMPORARY:  %s - found atom %u for %s\n", __FUNCTION__, (unsigned int)aRval, szAtomName);
+      pSlab->nUsed++;
 
-    return aRval;
+      pMH->pNext = pList;
+      pList = pMH;
+      nRval++;
+    }
+
+    if(pSlab->nUsed >= pSlab->nBlocks) // full
+    {
+      __SlabUnlinkAvailable(pSC, pSlab);
+    }
   }
 
-  aRval = XInternAtom(pDisplay, szAtomName, True);
+  pthread_mutex_unlock(&(pSC->mtx));
 
-  // TODO:  anything else?
+  *ppList = pList;
 
-  return aRval; // regardless
+  return nRval;
 }
 
-char *WBGetAtomName(WB_DISPLAY pDisplay, Atom aAtom)
+// return a list of free blocks (linked via 'pNext') to their slabs
+static void __SlabPutBlocks(unsigned int nClass, struct __malloc_header__ *pList)
 {
-char *pRval, *pTemp;
-unsigned int nAtom;
+WB_SLAB_CLASS *pSC = aSlabClass + nClass;
+WB_SLAB *pSlab;
+struct __malloc_header__ *pNext;
 
 
-  if(aAtom == None)
+  pthread_mutex_lock(&(pSC->mtx));
+
+  for(; pList; pList = pNext)
   {
-    // NOTE:  this can happen under normal circumstances, so don't make it an error
-    //        (especially true for dialog controls without IDs assigned, like static text)
+    pNext = pList->pNext;
+    pSlab = (WB_SLAB *)pList->pPrev;
 
-    WB_WARN_PRINT("ERROR:  %s - passed 'None' for aAtom\n", __FUNCTION__);
+    pList->pNext = pSlab->pFree;
+    pSlab->pFree = pList;
+    pSlab->nUsed--;
 
-    return NULL;
+    if(!pSlab->bAvailable)
+    {
+      __SlabLinkAvailable(pSC, pSlab);
+    }
   }
-  else if((unsigned int)aAtom >= (unsigned int)(WB_INTERNAL_ATOM_MIN_VAL + nInternalAtoms))
-  {
-    WB_ERROR_PRINT("ERROR:  %s - bad (internal) Atom:  %u (%08xH)\n", __FUNCTION__, (unsigned int)aAtom, (unsigned int)aAtom);
 
-    return NULL;  // bad parameter
-  }
+  pthread_mutex_unlock(&(pSC->mtx));
+}
 
-  if(!pDisplay)
-  {
-    pDisplay = WBGetDefaultDisplay();
+static void __SlabCacheFlush(WB_SLAB_CACHE *pCache)
+{
+unsigned int nClass;
 
-    if(!pDisplay)
+
+  for(nClass=0; nClass < WB_SLAB_CLASSES; nClass++)
+  {
+    if(pCache->apFree[nClass])
     {
-      WB_ERROR_PRINT("ERROR - %s - no display!\n", __FUNCTION__);
-      return NULL;
+      __SlabPutBlocks(nClass, pCache->apFree[nClass]);
+
+      pCache->apFree[nClass] = NULL;
+      pCache->anFree[nClass] = 0;
     }
   }
+}
+
+static void __SlabCacheDestructor(void *pData) // called when a thread exits
+{
+WB_SLAB_CACHE *pCache = (WB_SLAB_CACHE *)pData;
+WB_ALLOC_COUNTERS *pC;
+unsigned int nClass;
 
-  if((unsigned int)aAtom < WB_INTERNAL_ATOM_MIN_VAL)
+
+  if(pCache)
   {
-    WBSupressErrorOutput();
+    __SlabCacheFlush(pCache);
 
-    pTemp = XGetAtomName(pDisplay, aAtom);
+    // the thread's statistics are kept after it exits
 
-    WBAllowErrorOutput();
+    pthread_mutex_lock(&xAllocStatsMutex);
 
-    if(pTemp)
+    for(nClass=0; nClass < WB_ALLOC_STATS_CLASSES; nClass++)
     {
-      pRval = WBCopyString(pTemp);
-      XFree(pTemp);
+      pC = pCache->aCounters + nClass;
 
-      return pRval;
+      aAllocRetired[nClass].nAllocs += pC->nAllocs;
+      aAllocRetired[nClass].nFrees += pC->nFrees;
+      aAllocRetired[nClass].cbLive += pC->cbLive;
+      aAllocRetired[nClass].cbLiveBlock += pC->cbLiveBlock;
+
+      if(pC->cbUnpublished)
+      {
+        __AllocPublish(nClass, pC->cbUnpublished);
+      }
+    }
+
+    if(pCache->pPrev)
+    {
+      pCache->pPrev->pNext = pCache->pNext;
+    }
+    else
+    {
+      pSlabCacheList = pCache->pNext;
+    }
+
+    if(pCache->pNext)
+    {
+      pCache->pNext->pPrev = pCache->pPrev;
     }
 
-    WB_DEBUG_PRINT(DebugLevel_Light,
-                   "INFO:  %s - unknown Atom:  %u (%08xH)\n",
-                   __FUNCTION__, (unsigned int)aAtom, (unsigned int)aAtom);
+    pthread_mutex_unlock(&xAllocStatsMutex);
 
-    return NULL;
+    free(pCache);
   }
+}
 
-  pRval = NULL;
+static void __SlabCacheKeyInit(void)
+{
+  bSlabCacheKey = !pthread_key_create(&keySlabCache, __SlabCacheDestructor);
+}
 
-  while(WBInterlockedExchange(&lInternalAtomSpinner, 1)) // THIS MUST BE SPIN-LOCKED
+static WB_SLAB_CACHE * __SlabCache(void) // the calling thread's cache, or NULL
+{
+WB_SLAB_CACHE *pRval;
+
+
+  pthread_once(&xSlabCacheOnce, __SlabCacheKeyInit);
+
+  if(WB_UNLIKELY(!bSlabCacheKey))
   {
-    WBDelay(100); // by convention just do THIS
+    return NULL;
   }
 
-  if(ppInternalAtoms && pszAtomNames && nInternalAtoms > 0)
+  pRval = (WB_SLAB_CACHE *)pthread_getspecific(keySlabCache);
+
+  if(WB_UNLIKELY(!pRval))
   {
-    nAtom = (unsigned int)aAtom - WB_INTERNAL_ATOM_MIN_VAL;
+    pRval = (WB_SLAB_CACHE *)calloc(1, sizeof(*pRval));
 
-    if(nAtom < nInternalAtoms)
+    if(pRval && pthread_setspecific(keySlabCache, pRval))
     {
-      pRval = WBCopyString(ppInternalAtoms[nAtom]);
+      free(pRval);
+      pRval = NULL;
     }
-  }
+    else if(pRval) // add it to the list, for statistics
+    {
+      pthread_mutex_lock(&xAllocStatsMutex);
 
-  WBInterlockedExchange(&lInternalAtomSpinner, 0);  // I'm done with it now
+      pRval->pNext = pSlabCacheList;
 
-  if(!pRval)
-  {
-    WB_DEBUG_PRINT(DebugLevel_Light,
-                   "INFO:  %s - atom index %u (%u) not found, %u atoms stored\n", __FUNCTION__,
-                   (unsigned int)aAtom, (unsigned int)(aAtom - WB_INTERNAL_ATOM_MIN_VAL),
-                   nInternalAtoms);
+      if(pSlabCacheList)
+      {
+        pSlabCacheList->pPrev = pRval;
+      }
+
+      pSlabCacheList = pRval;
+
+      pthread_mutex_unlock(&xAllocStatsMutex);
+    }
   }
-//  else
-//  {
-//    WB_ERROR_PRINT("TEMPORARY:  %s - found %s for Atom %u\n", __FUNCTION__, pRval, (unsigned int)aAtom);
-//  }
 
   return pRval;
 }
 
+static struct __malloc_header__ * __SlabAlloc(unsigned int nClass)
+{
+WB_SLAB_CACHE *pCache = __SlabCache();
+struct __malloc_header__ *pMH;
+unsigned int nCount;
 
 
+  if(WB_LIKELY(pCache != NULL))
+  {
+    pMH = pCache->apFree[nClass];
 
-//////////////////////////////////////////////////////////////////////////////
-//                                                                          //
-//                                           _                              //
-//                   __ _  ___   ___   _ __ | |_       _ __                 //
-//                  / _` |/ __| / _ \ | '__|| __|     | '__|                //
-//                 | (_| |\__ \| (_) || |   | |_      | |                   //
-//                  \__, ||___/ \___/ |_|    \__|_____|_|                   //
-//                     |_|                      |_____|                     //
-//                                                                          //
-//////////////////////////////////////////////////////////////////////////////
-
-// ========================================================
-// Dealing with a lack of or improperly supported qsort_r()
-// ========================================================
+    if(WB_UNLIKELY(!pMH)) // re-fill the cache with half of its limit
+    {
+      nCount = __SlabGetBlocks(nClass, (__SlabCacheLimit(nClass) + 1) / 2, &pMH);
 
-#if (!defined(QSORT_R_BSD) && !defined(QSORT_R_GNUC)) || defined(__DOXYGEN__)
+      if(!nCount)
+      {
+        return NULL;
+      }
 
-struct my_qsort_data
-{
-  void *pData;  // pointer to elements
-  int cbData;   // size of elements
-  void *pThunk; // data to pass to each 'compare' call
-  int (*compare)(void *, const void *, const void *); // compare function
-  void *pSW, *pBR;
-};
+      pCache->anFree[nClass] = nCount;
+    }
 
-static void MyQuickSort2(struct my_qsort_data *pData, int iLow, int iHigh);
+    pCache->apFree[nClass] = pMH->pNext;
+    pCache->anFree[nClass]--;
+  }
+  else if(!__SlabGetBlocks(nClass, 1, &pMH))
+  {
+    return NULL;
+  }
 
-// define exactly like BSD version, but with base types
-// TODO:  multi-thread version?  would need to determine optimum threshold for threading
+  return pMH;
+}
 
-void my_qsort_r(void *base, int nmemb, int size, void *thunk,
-                int (*compar)(void *, const void *, const void *))
+static void __SlabFree(struct __malloc_header__ *pMH)
 {
-struct my_qsort_data sData;
-unsigned char buf[32], buf2[32];
+WB_SLAB_CACHE *pCache = __SlabCache();
+struct __malloc_header__ *pList, *pTail;
+unsigned int nClass, nLimit, nKeep;
 
 
-  if(nmemb <= 1)
+  nClass = ((WB_SLAB *)pMH->pPrev)->nClass;
+
+  if(WB_UNLIKELY(!pCache))
   {
-    return;  // no need to sort 1 item
+    pMH->pNext = NULL;
+    __SlabPutBlocks(nClass, pMH);
+
+    return;
   }
 
-  sData.pData = base;
-  sData.cbData = size;
-  sData.pThunk = thunk;
-  sData.compare = compar;
+  pMH->pNext = pCache->apFree[nClass];
+  pCache->apFree[nClass] = pMH;
 
-  if(sData.cbData <= sizeof(buf))
-  {
-    sData.pBR = buf;
-    sData.pSW = buf2;
-  }
-  else
+  nLimit = __SlabCacheLimit(nClass);
+
+  if(WB_UNLIKELY(++(pCache->anFree[nClass]) > nLimit)) // return half of them to the slabs
   {
-    sData.pBR = WBAlloc(sData.cbData * 2);
-    sData.pSW = (unsigned char *)sData.pBR + sData.cbData;
-  }
+    nKeep = nLimit / 2;
 
-  MyQuickSort2(&sData, 0, nmemb - 1);
+    for(pTail = pCache->apFree[nClass]; nKeep > 1; nKeep--)
+    {
+      pTail = pTail->pNext;
+    }
 
-  if(sData.cbData > sizeof(buf))
-  {
-    WBFree(sData.pBR);
+    pList = pTail->pNext;
+    pTail->pNext = NULL;
+
+    pCache->anFree[nClass] = nLimit / 2 > 0 ? nLimit / 2 : 1;
+
+    __SlabPutBlocks(nClass, pList);
   }
 }
 
-static __inline__ void *ElementFromIndex(struct my_qsort_data *pData, int iElement)
+static void __AllocPublish(unsigned int nClass, WB_INT64 cbDelta)
 {
-  return ((unsigned char *)pData->pData) + pData->cbData * iElement;
-}
+WB_INT64 cbLive;
 
-static int DoCompareI(struct my_qsort_data *pData, int iLeft, int iRight)
-{
-  void *p1 = ElementFromIndex(pData, iLeft);
-  void *p2 = ElementFromIndex(pData, iRight);
 
-  return pData->compare(pData->pThunk, p1, p2);
-}
+  // a race between two threads here only affects the accuracy of the peak a little
 
-static int DoCompareP(struct my_qsort_data *pData, int iLeft, void *pRight)
-{
-  void *p1 = ElementFromIndex(pData, iLeft);
+  cbLive = WB_ATOMIC_ADD64(acbAllocPublished + nClass, cbDelta);
 
-  return pData->compare(pData->pThunk, p1, pRight);
-}
+  if(cbLive > acbAllocPeak[nClass])
+  {
+    acbAllocPeak[nClass] = cbLive;
+  }
 
-static void DoSwapData(struct my_qsort_data *pData, int iLeft, int iRight)
-{
-  void *p1 = ElementFromIndex(pData, iLeft);
-  void *p2 = ElementFromIndex(pData, iRight);
+  cbLive = WB_ATOMIC_ADD64(acbAllocPublished + WB_ALLOC_STATS_CLASSES, cbDelta);
 
-  // TODO:  make this faster?
-  memcpy(pData->pSW, p1, pData->cbData);
-  memcpy(p1, p2, pData->cbData);
-  memcpy(p2, pData->pSW, pData->cbData);
+  if(cbLive > acbAllocPeak[WB_ALLOC_STATS_CLASSES])
+  {
+    acbAllocPeak[WB_ALLOC_STATS_CLASSES] = cbLive;
+  }
 }
 
-void MyQuickSort2(struct my_qsort_data *pData, int iLow, int iHigh )
+static void __AllocCount(unsigned int nClass, int nAllocs, int nFrees, WB_INT64 cbLive, WB_INT64 cbLiveBlock)
 {
-int iUp, iDown, iBreak;
-void *pBreak;
-unsigned char buf[32], buf2[32]; // if smaller than 32 bytes, use THIS for temp object storage
+WB_SLAB_CACHE *pCache = __SlabCache();
+WB_ALLOC_COUNTERS *pC;
 
 
-  if( iLow < iHigh )                 // do not sort 1 element block
+  if(WB_LIKELY(pCache != NULL))
   {
-    iBreak = (iLow + iHigh) / 2;
-    pBreak = ElementFromIndex(pData, iBreak); // initial pivot point
+    pC = pCache->aCounters + nClass;
 
-    if( (iHigh - iLow) > 5 )       // 5 or more elements?
+    pC->nAllocs += nAllocs;
+    pC->nFrees += nFrees;
+    pC->cbLive += cbLive;
+    pC->cbLiveBlock += cbLiveBlock;
+    pC->cbUnpublished += cbLiveBlock;
+
+    if(WB_UNLIKELY(pC->cbUnpublished >= WB_ALLOC_STATS_BATCH ||
+                   pC->cbUnpublished <= -WB_ALLOC_STATS_BATCH))
     {
-      // do a 'median of 3' optimization when practical
-      // this ensures a better pivot point, limiting the
-      // effect of an already sorted or nearly sorted
-      // array on performance.  Pivot points should be
-      // as close to the median value as practical for
-      // the current range of data points.  Otherwise,
-      // a series of bad pivot points could degenerate
-      // the 'quicksort' into a 'slowsort', and possibly
-      // cause stack overflows on large data sets.
+      __AllocPublish(nClass, pC->cbUnpublished);
 
-      if(DoCompareI(pData, iLow, iHigh) <= 0)
-      {
-        if(DoCompareP(pData, iLow, pBreak) < 0)
-        {
-          if(DoCompareP(pData, iHigh, pBreak) < 0)
-          {
-             pBreak = ElementFromIndex(pData, iHigh);
-          }
-        }
-        else
-        {
-          pBreak = ElementFromIndex(pData, iLow);
-        }
-      }
-      else
-      {
-        if(DoCompareP(pData, iHigh, pBreak) < 0)
-        {
-          if(DoCompareP(pData, iLow, pBreak) < 0)
-          {
-             pBreak = ElementFromIndex(pData, iLow);
-          }
-        }
-        else
-        {
-          pBreak = ElementFromIndex(pData, iHigh);
-        }
-      }
+      pC->cbUnpublished = 0;
     }
+  }
+  else
+  {
+    pthread_mutex_lock(&xAllocStatsMutex);
 
-    memcpy(pData->pBR, pBreak, pData->cbData); // make copy of it before swapping anything
-    pBreak = pData->pBR; // and now point to the buffer (faster this way)
-
-    iUp = iLow;                  // initialize indices
-    iDown = iHigh;
+    pC = aAllocRetired + nClass;
 
-    do
-    {
-      // Move in from both sides towards the pivot point.
+    pC->nAllocs += nAllocs;
+    pC->nFrees += nFrees;
+    pC->cbLive += cbLive;
+    pC->cbLiveBlock += cbLiveBlock;
 
-      // note:  it may be possible to thread THESE two loops
-      //        though it's likely not to help a whole lot
+    pthread_mutex_unlock(&xAllocStatsMutex);
 
-      while( iUp < iHigh)
-      {
-        if(DoCompareP(pData, iUp, pBreak) < 0)
-        {
-          iUp++;
-        }
-        else
-        {
-          break;
-        }
-      }
+    __AllocPublish(nClass, cbLiveBlock);
+  }
+}
 
-      while(iDown > iLow)
-      {
-        if(DoCompareP(pData, iDown, pBreak) > 0)
-        {
-          iDown--;
-        }
-        else
-        {
-          break;
-        }
-      }
+static __inline__ unsigned int __AllocClass(const struct __malloc_header__ *pMH)
+{
+  return pMH->pNext == PSLAB_FLAG ? ((const WB_SLAB *)pMH->pPrev)->nClass : WB_SLAB_CLASSES;
+}
 
+// find (or add) the site table entry for 'szFile' and 'iLine'.  Returns 0 if the table is full.
+static unsigned int __AllocSiteIndex(const char *szFile, int iLine) // 'xAllocSiteMutex' must be locked
+{
+unsigned int uiKey, uiIndex;
 
-      // if low/high boundaries have not crossed, swap current
-      // 'boundary' values so that the 'iUp' pointer points
-      // to a value less than or equal to the pivot point,
-      // and the 'iDown' value points to a value greater than
-      // or equal to the pivot point, and continue.
 
-      if( iUp <= iDown )
-      {
-        if(iUp != iDown)
-        {
-          DoSwapData(pData, iUp, iDown);
-        }
+  if(WB_UNLIKELY(!pAllocSites))
+  {
+    pAllocSites = (WB_ALLOC_SITE *)calloc(WB_ALLOC_SITE_MAX, sizeof(*pAllocSites)); // not counted
 
-        iUp++;
-        iDown--;
-      }
+    if(!pAllocSites)
+    {
+      return 0;
+    }
+  }
 
-    } while ( iUp <= iDown );
+  uiKey = (unsigned int)((unsigned long)szFile) ^ ((unsigned int)iLine << 16) ^ (unsigned int)iLine;
+  uiKey *= 0x9e3779b1U;
+  uiIndex = (uiKey ^ (uiKey >> 15)) & (WB_ALLOC_SITE_MAX - 1);
 
-    // the recursive part... [NOTE if I ever want to thread this, I can make work units here]
+  while(1)
+  {
+    if(!uiIndex) // [0] means 'no site'
+    {
+      uiIndex = 1;
+    }
 
-    if(iLow < iDown )  // everything to the left of the pivot point
+    if(!pAllocSites[uiIndex].szFile)
     {
-      MyQuickSort2(pData, iLow, iDown );
+      break;
     }
-    if(iUp < iHigh)    // everything to the right of the pivot point
+    else if(pAllocSites[uiIndex].iLine == iLine &&
+            (pAllocSites[uiIndex].szFile == szFile || !strcmp(pAllocSites[uiIndex].szFile, szFile)))
     {
-      MyQuickSort2(pData, iUp, iHigh );
+      return uiIndex;
     }
+
+    uiIndex = (uiIndex + 1) & (WB_ALLOC_SITE_MAX - 1);
+  }
+
+  if(nAllocSites >= WB_ALLOC_SITE_MAX * 3 / 4) // keep the probe sequences short
+  {
+    return 0;
   }
+
+  pAllocSites[uiIndex].szFile = szFile;
+  pAllocSites[uiIndex].iLine = iLine;
+  nAllocSites++;
+
+  return uiIndex;
 }
 
-#endif // !defined(QSORT_R_BSD) && !defined(QSORT_R_GNUC)
+static void __AllocSiteCount(unsigned int uiSite, int nAllocs, int nLive, WB_INT64 cbLive)
+{
+WB_ALLOC_SITE *pSite;
 
 
-#if !defined(HAVE_XPM) || defined(__DOXYGEN__)
+  pthread_mutex_lock(&xAllocSiteMutex);
 
-//////////////////////////////////////////////////////
-// SUBSTITUTE CODE FOR MISSING (or unwanted) libXpm //
-//////////////////////////////////////////////////////
+  pSite = pAllocSites + uiSite;
 
-// parse an XPM, and generate data that I can THEN create a bitmap from
-//
-// The XPM will have 4 numbers at the start (in ASCII): WIDTH HEIGHT nColors chars_per_color
-// 'nColors' is the size of the color table (one line each)
-// 'chars_per_color' is the # of characters that represent a color
-// following this is the bitmap data itself.
-// To create a transparency mask look for a color called "None" which is the background color
-// for the transparency mask.  The mask will be a monochrome bitmap with '0' for transparency,
-// and '1' for everything else.
-//
-// mono bitmap format will be 1 bit per pixel, 16-bit MSB
-//
-// This function is generally PREFERABLE to the libXpm version as it's a LOT faster
-// Additionally, it can be made 'MS Windows Compatible' so that XPM resources can be
-// used within WIN32 applications.  Should support MSVC, gcc, and llvm compilers
-//
-// checking for MSVC:  use '#ifdef _MSC_VER' or similar
+  pSite->nAllocs += nAllocs;
+  pSite->nLive += nLive;
+  pSite->cbLive += cbLive;
 
-#define MAX_XPM_COLOR_CHAR_SIZE 4
+  if(pSite->cbLive > pSite->cbPeak)
+  {
+    pSite->cbPeak = pSite->cbLive;
+  }
 
-typedef struct _MY_XPM_COLOR_
+  pthread_mutex_unlock(&xAllocSiteMutex);
+}
+
+static unsigned int __AllocSite(const char *szFile, int iLine)
 {
-  char c[MAX_XPM_COLOR_CHAR_SIZE]; // up to MAX_XPM_COLOR_CHAR_SIZE chars that represent a color (use 8 instead?)
-  XColor clrColor; // actual color (32-bit)
-} MY_XPM_COLOR;
+unsigned int uiRval;
 
 
-static int MyXPMColorCompare(const void *p1, const void *p2)
-{
-  // always 1st 4 characters only
+  if(!szFile)
+  {
+    return 0;
+  }
+
+  pthread_mutex_lock(&xAllocSiteMutex);
+
+  uiRval = __AllocSiteIndex(szFile, iLine);
 
-  return memcmp(p1, p2, MAX_XPM_COLOR_CHAR_SIZE);
+  pthread_mutex_unlock(&xAllocSiteMutex);
+
+  return uiRval;
 }
 
-static char * MyXPMToData(const char *pXPM[], int *piW, int *piH, char **ppTransparency)
+static void __AllocCountBlock(const struct __malloc_header__ *pMH, int iSign) // 'iSign' is 1 to allocate, -1 to free
 {
-MY_XPM_COLOR *pClr, *pC;
-int i1, i2, i3, iW, iH;
-int nColors, nCharsPerColor;
-char cNone[MAX_XPM_COLOR_CHAR_SIZE]={0};
-const char *pX, *pY, *pZ;
-const char **ppX;
-Colormap colormap;
-WB_UINT32 *pRval, *pR;
-unsigned char *pT;
-char tbuf[256];
+WB_INT64 cbLive = (WB_INT64)iSign * pMH->cbRequest;
 
 
-  // ------------------
-  // parse the XPM file
-  // ------------------
+  __AllocCount(__AllocClass(pMH), iSign > 0, iSign < 0, cbLive,
+               (WB_INT64)iSign * (pMH->cbSize + sizeof(*pMH)));
 
-  if(pXPM)
-  {
-    ppX = pXPM; // first line is always 4 numbers
-  }
-  else
+  if(pMH->uiSite)
   {
-    ppX = NULL;
+    __AllocSiteCount(pMH->uiSite, iSign > 0, iSign, cbLive);
   }
+}
 
-  if(ppX)
-  {
-    pX = *(ppX++);
-  }
-  else
-  {
-    pX = NULL;
-  }
+// after a block was re-sized in place, or with 'realloc', and its header has the new sizes
+static void __AllocCountResize(const struct __malloc_header__ *pMH, unsigned int cbOldRequest, unsigned int cbOldSize)
+{
+WB_INT64 cbLive = (WB_INT64)pMH->cbRequest - cbOldRequest;
 
-  if(!pX)
+
+  __AllocCount(__AllocClass(pMH), 0, 0, cbLive, (WB_INT64)pMH->cbSize - cbOldSize);
+
+  if(pMH->uiSite)
   {
-    WB_ERROR_PRINT("%s - unexpected parameter, pXPM=%p, ppX=%p, pX=%p\n", __FUNCTION__, pXPM, ppX, pX);
-    return NULL;
+    __AllocSiteCount(pMH->uiSite, 0, 0, cbLive);
   }
+}
 
-  // use a macro to grab 4 integers from text
-
-#define NEXT_INT(iW,pX,pY,pZ){int iLen; NEXT_WORD(pX,pY,pZ); \
-                              iLen=pZ - pY > sizeof(tbuf) - 1 ? sizeof(tbuf) - 1 : pZ - pY; \
-                              if(iLen>0){memcpy(tbuf,pY,iLen);} tbuf[iLen]=0; iW=atoi(tbuf);}
-  NEXT_INT(iW,pX,pY,pZ);
-  NEXT_INT(iH,pX,pY,pZ);
-  NEXT_INT(nColors,pX,pY,pZ);
-  NEXT_INT(nCharsPerColor,pX,pY,pZ);
+static void * __WBAlloc(int nSize, unsigned int uiSite)
+{
+unsigned char *pRval;
+struct __malloc_header__ *pMH;
+unsigned int nAllocSize, nNewSize, nLimit;
 
-#undef NEXT_INT
 
-  if(*pX || !iW || !iH || !nColors || !nCharsPerColor || nCharsPerColor > sizeof(pClr[0].c))
+  if(nSize <= 0)
   {
-    WB_ERROR_PRINT("%s fail, iW=%d iH=%d nColors=%d nCharsPerColor=%d\n",
-                   __FUNCTION__, iW, iH, nColors, nCharsPerColor);
+    WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                   "ERROR:  %s.%d - nSize not valid (%d)\n", __FUNCTION__, __LINE__, nSize);
     return NULL;
   }
 
-  colormap = WBDefaultColormap(WBGetDefaultDisplay());
-
-  pClr = WBAlloc(nColors * sizeof(MY_XPM_COLOR));
-
-  // ------------------------------------------------------------------------------
-  // parse the colors - 1-4 chacters, then white space, then the color as '#nnnnnn'
-  // ------------------------------------------------------------------------------
+  nAllocSize = nSize + sizeof(*pMH);
 
-  for(i1=0; i1 < nColors; i1++)
+  if(nAllocSize <= WB_SLAB_MAX_BLOCK) // internally sub-allocated blocks
   {
-    pY = pX = *(ppX++);
+    unsigned int nClass;
 
-    if(!pX)
-    {
-      WBFree(pClr);
+    // the smallest size class that fits, with no extra room for growth.  A sub-allocated block
+    // can't grow in place anyway; WBReAlloc moves it to a larger block.
 
-      WB_ERROR_PRINT("%s NULL pX unexpected, i1=%d\n", __FUNCTION__, i1);
-      return NULL;
-    }
+    for(nClass=0; __SlabClassSize(nClass) < nAllocSize; nClass++)
+    { }
 
-    bzero(pClr[i1].c, sizeof(pClr[i1].c));
+    nNewSize = __SlabClassSize(nClass);
 
-    for(i2=0; i2 < nCharsPerColor; i2++)
+    pMH = __SlabAlloc(nClass);
+
+    if(pMH)
     {
-      pClr[i1].c[i2] = *(pX++);
-    }
+      // 'pPrev' already points to the slab
+      pMH->pNext = PSLAB_FLAG;
+      pMH->iTag = WB_ALLOC_TAG;
+      pMH->cbSize = nNewSize - sizeof(*pMH);
 
-    while(*pX && *pX <= ' ')
+      pRval = (unsigned char *)(pMH + 1);
+    }
+    else
     {
-      pX++; // next char should be a 'c'
+      pRval = NULL;
     }
+  }
+  else
+  {
+    // for larger blocks, I use 'malloc', with room to grow.  nAllocSize is converted to the
+    // next higher power of 2 that's at least 1.5 times the size, so 'realloc' is needed less often
 
-    // next character is 'c' for color
-    if(*pX != 'c' || pX[1] > ' ' || (pX[2] != '#' && strncmp(pX + 2,"None",4)))
-    {
-      WB_ERROR_PRINT("%s fail 1, pX=\"%s\" pY=\"%s\" %d %c %d\n", __FUNCTION__, pX, pY, pX[1], pX[2], strncmp(pX + 2,"None",4));
-      WBFree(pClr);
+    nLimit = nAllocSize + (nAllocSize >> 1);
 
-      return NULL;
-    }
+    for(nNewSize=WB_SLAB_MAX_BLOCK; nNewSize < nLimit; nNewSize <<= 1)
+    { }
 
-    pX += 2;
+    pRval = (unsigned char *)malloc(nNewSize);
 
-    if(!strncmp(pX,"None",4))
+    if(pRval)
     {
-      memcpy(cNone, pClr[i1].c, sizeof(pClr[i1].c));
-      bzero(&(pClr[i1].clrColor), sizeof(XColor));
+#ifdef HAVE_MALLOC_USABLE_SIZE
+      void *pActual = pRval;
+#endif // HAVE_MALLOC_USABLE_SIZE
 
-      pX += 4;
-    }
-    else if(*pX == '#')
-    {
-      memcpy(tbuf, pX, 7);
-      tbuf[7] = 0;
-      XParseColor(WBGetDefaultDisplay(), colormap, tbuf, &(pClr[i1].clrColor));
-      pX += 7;
-    }
-    else
-    {
-      WB_ERROR_PRINT("%s fail 2, pX=\"%s\"\n", __FUNCTION__, pX);
-      WBFree(pClr);
-      return NULL;
-    }
+      pMH = (struct __malloc_header__ *)pRval;
 
-    if(*pX)
-    {
-      WB_ERROR_PRINT("%s fail 3, pX=\"%s\"\n", __FUNCTION__, pX);
-      WBFree(pClr);
-      return NULL;
-    }
-  }
+      pRval += sizeof(*pMH);
 
-  // first usage of 'pRval'
-  pRval = WBAlloc(iH * iW * 4); // pixel array, always 32-bit-wide values; B is first byte, G is 2nd byte, R is 3rd byte, 4th byte is zero
+      pMH->pPrev = PMALLOC_FLAG; // this indicates it was 'malloc'd
+      pMH->pNext = PMALLOC_FLAG; // this indicates it was 'malloc'd
+      pMH->iTag = WB_ALLOC_TAG;
 
-  if(!pRval)
-  {
-    WBFree(pClr);
-    WB_ERROR_PRINT("%s fail, not enough memory for pRval, size=%d\n", __FUNCTION__, iH * iW * 4);
-    return NULL;
+#ifdef HAVE_MALLOC_USABLE_SIZE
+      nLimit = malloc_usable_size(pActual); // the ACTUAL SIZE of the memory block
+      if(nLimit > nNewSize)
+      {
+        nNewSize = nLimit;
+      }
+#endif // HAVE_MALLOC_USABLE_SIZE
+      pMH->cbSize = nNewSize - sizeof(*pMH);
+    }
   }
 
-  if(ppTransparency && cNone[0]) // there is a 'None'
+  if(!pRval)
   {
-    i3 = (iW + 7) / 8; // total number of bytes needed per row [padded]
-    pT = WBAlloc(iH * i3 + 2);
-    if(!pT)
-    {
-      WBFree(pRval);
-      WBFree(pClr);
-      WB_ERROR_PRINT("%s fail, not enough memory for pT, size=%d\n", __FUNCTION__, (iH * iW) / 8 + 2);
-      return NULL;
-    }
-
-    bzero(pT, iH * i3 + 2); // make sure
+    WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
+                   "WARNING:  %s.%d - unable to allocate %d bytes\n", __FUNCTION__, __LINE__, nSize);
   }
   else
   {
-    pT = NULL;
+    pMH->cbRequest = nSize;
+    pMH->uiSite = uiSite;
+
+    __AllocCountBlock(pMH, 1);
+
+    WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                   "INFO:  %s.%d - allocated %d bytes as %p\n", __FUNCTION__, __LINE__, nSize, pRval);
   }
 
-  qsort(pClr, nColors, sizeof(*pClr), MyXPMColorCompare);
+  return pRval;
+}
 
-  // at this point 'pX' points to the actual RBG color data.  I shall now create
-  // Image binary data in XYPixmap format, 32-bits per pixel with 32-bit padding, based on the default display
+void *WBAlloc(int nSize)
+{
+  return __WBAlloc(nSize, 0);
+}
 
-  for(i2=0, pR=pRval; i2 < iH; i2++)
+void *WBAllocTrack(int nSize, const char *szFile, int iLine)
+{
+  return __WBAlloc(nSize, __AllocSite(szFile, iLine));
+}
+
+int WBAllocUsableSize(void *pBuf)
+{
+struct __malloc_header__ *pMH;
+
+
+  if(pBuf)
   {
-    pX = *(ppX++);
-    if(!pX)
+    // validate pointer
+    // TODO:  check against linked list of 'allocated' blocks first
+
+    pMH = ((struct __malloc_header__ *)pBuf) - 1;
+
+    if(pMH->iTag == WB_ALLOC_TAG)
     {
-      WBFree(pRval);
-      WBFree(pClr);
-      WB_ERROR_PRINT("%s NULL pX unexpected, i2=%d\n", __FUNCTION__, i2);
-      return NULL;
+      WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                     "INFO:  %s.%d - returning allocated size %d for %p\n", __FUNCTION__, __LINE__, pMH->cbSize, pBuf);
+
+      return pMH->cbSize;
     }
+  }
 
-    pY = pX;
+  WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
+                 "ERROR:  %s.%d - invalid pointer %p\n", __FUNCTION__, __LINE__, pBuf);
 
-    for(i1=0; i1 < iW; i1++)
-    {
-      bzero(tbuf, sizeof(pClr[0].c));
+  return -1; // an error
+}
 
-      // read in 'n' characters
-      for(i3=0; i3 < nCharsPerColor; i3++)
-      {
-        if(!*pX)
-        {
-          WBFree(pClr);
-          WB_ERROR_PRINT("%s premature end of string, %ld bytes\n", __FUNCTION__, (long)(pX - pY));
-          return NULL;
-        }
+static void __WBFree(void *pBuf, const char *szFile, int iLine)
+{
+struct __malloc_header__ *pMH;
+unsigned int nOldSize;
 
-        tbuf[i3] = *(pX++);
-      }
+  if(pBuf)
+  {
+    // validate pointer
+    // TODO:  check against linked list of 'allocated' blocks first
+
+    pMH = ((struct __malloc_header__ *)pBuf) - 1;
 
-      pC = (MY_XPM_COLOR *)bsearch(tbuf, pClr, nColors, sizeof(*pClr), MyXPMColorCompare);
+    if(pMH->iTag == WB_ALLOC_TAG)
+    {
+      nOldSize = pMH->cbSize;
 
-      if(!pC || memcmp(tbuf, pC->c, sizeof(pC->c)))
+      if(pMH->pPrev == PMALLOC_FLAG &&
+         pMH->pNext == PMALLOC_FLAG)
       {
-        WBFree(pClr);
-        WB_ERROR_PRINT("%s fail, did not locate color %-4.4s\n", __FUNCTION__, tbuf);
-        return NULL;
-      }
+        __AllocCountBlock(pMH, -1);
 
-      // pixel color order is B, then G, then R so that R == MSB and B == LSB
-      // this being 'low endian' might actually matter with the byte order.
-      // TODO:  do I verify this using the 'Visual' structure info?  Should I get
-      //        the default visual for the default Display+Screen and verify?
-
-      ((unsigned char *)pR)[0] = pC->clrColor.blue >> 8;
-      ((unsigned char *)pR)[1] = pC->clrColor.green >> 8;
-      ((unsigned char *)pR)[2] = pC->clrColor.red >> 8;   // these are 16-bit values, so I want 8-bits out of them
-      ((unsigned char *)pR)[3] = 0;
+        // assign header values that invalidate re-freeing the same memory
 
-      pR++;
+        pMH->iTag = 0; // make sure it's no longer valid (so I don't try to re-free)
+        pMH->pPrev = NULL; // same with these values
+        pMH->pNext = NULL;
+        pMH->cbSize = 0;
 
-      if(pT) // bitmap for transparency
+        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                       "INFO:  %s.%d - freeing %d bytes of memory at %p\n", __FUNCTION__, __LINE__, nOldSize, pBuf);
+        free(pMH);
+      }
+      else if(pMH->pNext == PSLAB_FLAG)
       {
-        register unsigned int uiBit;
-        register unsigned char *pRow;
+        // a free slab block has a zero 'iTag', so re-freeing it is caught above
 
-        // NOTE:  in some test code that was written for VMS, the byte order seems to be
-        //        BACKWARDS in a 16-bittedness way.  It may be that the machine in question
-        //        used a 16-bit word with byte-order determined by an internal function,
-        //        which could cause a 'swap' of each consecutive pair of bytes.  I am going
-        //        to IGNORE THAT for the moment and (by experimentation) determine how I'm
-        //        supposed to order the bits.
-        // TODO:  figure out a system-independent way of doing this that works every time
-        //        even if I have to create an image and manipulate pixels individually
+        __AllocCountBlock(pMH, -1);
 
-        // width in bytes must be a multiple of 8 bits
-        i3 = (iW + 7) / 8; // total number of bytes needed per row [padded]
+        pMH->iTag = 0;
+        pMH->cbSize = 0;
 
-        pRow = pT + i3 * i2; // 'pR' points to the row
-        i3 = iW - 1 - i1;
-        uiBit = 1 << (i3 & 7);
+        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                       "INFO:  %s.%d - freeing %d bytes of memory at %p\n", __FUNCTION__, __LINE__, nOldSize, pBuf);
 
-        if(!memcmp(tbuf, cNone, sizeof(cNone)))
-        {
-          pRow[i3 / 8] &= ~uiBit; // bit is clear
-        }
-        else
-        {
-          pRow[i3 / 8] |= uiBit; // bit is set
-        }
+        __SlabFree(pMH);
+      }
+      else if(szFile)
+      {
+        WB_ERROR_PRINT("ERROR:  %s - corrupt memory header - NOT freeing memory %p (from %s:%d)\n",
+                       __FUNCTION__, pBuf, szFile, iLine);
+      }
+      else
+      {
+        WB_ERROR_PRINT("ERROR:  %s - corrupt memory header - NOT freeing memory %p\n", __FUNCTION__, pBuf);
       }
-    }
-  }
-
-  WBFree(pClr);
-  pClr = NULL;
 
-  if(ppTransparency)
-  {
-    *ppTransparency = (char *)pT;
+      return;
+    }
   }
 
-  if(piW)
+  if(szFile)
   {
-    *piW = iW;
+    WB_ERROR_PRINT("ERROR:  %s.%d NOT freeing (invalid) memory %p (from %s:%d)\n",
+                   __FUNCTION__, __LINE__, pBuf, szFile, iLine);
   }
-
-  if(piH)
+  else
   {
-    *piH = iH;
+    WB_ERROR_PRINT("ERROR:  %s.%d NOT freeing (invalid) memory %p\n", __FUNCTION__, __LINE__, pBuf);
   }
+}
 
-  return (char *)pRval;
+void WBFree(void *pBuf)
+{
+  __WBFree(pBuf, NULL, 0);
 }
 
+void WBFreeTrack(void *pBuf, const char *szFile, int iLine)
+{
+  __WBFree(pBuf, szFile, iLine);
+}
 
-// function body - TODO:  move to pixmap_helper.c instead?
-int MyLoadPixmapFromData(WB_DISPLAY pDisplay, Window wID, char *aData[],
-                         Pixmap *pPixmap, Pixmap *pMask, XPM_ATTRIBUTES *pAttr)
+static void * __WBReAlloc(void *pBuf, int nNewSize, const char *szFile, int iLine)
 {
-int iW, iH;
-char *pTrans = NULL; // transparency data
-char *pB;
-Pixmap pxImage, pxMask;
-int iRval = 0;
+struct __malloc_header__ *pMH;
+unsigned char *pRval = NULL;
+unsigned int nAllocSize, nOldSize, nNewNewSize, nLimit, cbOldRequest, uiSite;
 
 
-  if(pAttr)
+  if(!pBuf || nNewSize <= 0)
   {
-    bzero(pAttr, sizeof(XPM_ATTRIBUTES));
+    WB_ERROR_PRINT("ERROR:  %s.%d Invalid parameter (%p, %d)\n", __FUNCTION__, __LINE__, pBuf, nNewSize);
+    return NULL;
   }
 
-  pB = MyXPMToData((const char **)aData, &iW, &iH, &pTrans);
-
-  if(!pB)
-  {
-    WB_ERROR_PRINT("%s - MyXPMToData failed\n", __FUNCTION__);
-
-    if(pPixmap)
-    {
-      *pPixmap = None;
-    }
-    if(pMask)
-    {
-      *pMask = None;
-    }
+  // validate pointer
+  // TODO:  check against linked list of 'allocated' blocks first
 
-    return -1;
-  }
+  pMH = ((struct __malloc_header__ *)pBuf) - 1;
 
-  if(pTrans && pMask) // there is transparency information - I'll need a transparency mask
+  if(pMH->iTag == WB_ALLOC_TAG)
   {
-    pxMask = XCreatePixmapFromBitmapData(pDisplay, wID, pTrans, iW, iH,
-                                         1,//BlackPixel(pDisplay, DefaultScreen(pDisplay)), mask 'allow' foreground = 1
-                                         0,//WhitePixel(pDisplay, DefaultScreen(pDisplay)), transparent background = 0
-                                         1); // depth of one, always
-    WBFree(pTrans);
+    nOldSize = pMH->cbSize;
+    cbOldRequest = pMH->cbRequest;
 
-    if(!pxMask)
+    if(szFile && !pMH->uiSite && (uiSite = __AllocSite(szFile, iLine)) != 0)
     {
-      iRval = -2; // sort of error, but do the rest anyway
+      // an untracked block is counted for this site from now on
+
+      pMH->uiSite = uiSite;
+      __AllocSiteCount(uiSite, 1, 1, cbOldRequest);
     }
-  }
-  else
-  {
-    pxMask = None; // no mask
-  }
 
-  if(pPixmap)
-  {
-    pxImage = XCreatePixmap(pDisplay, wID, iW, iH, DefaultDepth(pDisplay, DefaultScreen(pDisplay)));
+    // the whole point of this is to minimize the actual need to re-allocate the
+    // memory block by maintaining a LARGER block than is actually needed when
+    // allocated or re-allocated.  Gradually increasing size is pretty much assumed.
 
-    if(!pxImage)
+    if(nOldSize >= nNewSize)
     {
-      WB_ERROR_PRINT("%s - XCreatePixmap failed\n", __FUNCTION__);
+      WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                     "INFO:  %s.%d - memory at %p is already %d bytes (requested %d)\n",
+                     __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
 
-      if(pxMask)
-      {
-        XFreePixmap(pDisplay, pxMask);
-        pxMask = None;
-      }
+      pMH->cbRequest = nNewSize;
+      __AllocCountResize(pMH, cbOldRequest, nOldSize);
 
-      iRval = -1;
+      return pBuf; // no change (same pointer) since it's large enough already
     }
-    else
+
+    if(pMH->pNext == PSLAB_FLAG)
     {
-      // create an image from the pB data
-      XImage *pImage = XCreateImage(pDisplay, DefaultVisual(pDisplay, DefaultScreen(pDisplay)),
-                                    DefaultDepth(pDisplay, DefaultScreen(pDisplay)),
-                                    ZPixmap,
-                                    0,
-                                    pB,
-                                    iW, iH, 32, iW * 4);
+      // it's an internally sub-allocated block, which can't grow in place.  Allocate a new one
+      // with 'WBAlloc' (which may be another sub-allocated block, or a 'malloc' block) and copy it.
 
-      if(!pImage)
+      pRval = __WBAlloc(nNewSize, pMH->uiSite); // the new block keeps the allocation site
+
+      if(!pRval)
       {
-        WB_ERROR_PRINT("%s - XCreateImage failed\n", __FUNCTION__);
+        WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
+                       "WARN:  %s.%d - not enough memory to re-allocate %p from %d bytes to %d\n",
+                       __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
 
-        if(pxMask)
-        {
-          XFreePixmap(pDisplay, pxMask);
-          pxMask = None;
-        }
+        return NULL; // not enough memory
+      }
 
-        XFreePixmap(pDisplay, pxImage);
-        pxImage = None;
+      memcpy(pRval, pBuf, nOldSize); // copy the old data, but not the stuff in the header.
+      __WBFree(pBuf, szFile, iLine); // free 'pBuf' now that it's not needed
 
-        iRval = -1;
-      }
-      else
-      {
-        GC gc;
-        XGCValues gcv;
+      WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                     "INFO:  %s.%d - re-allocated %p as %p from %d bytes to %d\n",
+                     __FUNCTION__, __LINE__, pBuf, pRval, nOldSize, nNewSize);
 
-        gcv.foreground = BlackPixel(pDisplay, DefaultScreen(pDisplay));
-        gcv.background = WhitePixel(pDisplay, DefaultScreen(pDisplay));
+      return pRval;
+    }
+    else if(pMH->pPrev != PMALLOC_FLAG || pMH->pNext != PMALLOC_FLAG)
+    {
+      WB_ERROR_PRINT("ERROR:  %s - corrupt memory header - NOT re-allocating memory %p\n", __FUNCTION__, pBuf);
+      return NULL;
+    }
 
-        gc = XCreateGC(pDisplay, wID, (GCForeground | GCBackground), &gcv);
+    nAllocSize = nNewSize + sizeof(*pMH);
+    // nAllocSize will be converted to the next higher power of 2, with room to grow
 
-        if(gc == None)
-        {
-          WB_ERROR_PRINT("%s - XCreateGC failed\n", __FUNCTION__);
+    nLimit = nAllocSize + (nAllocSize >> 1);
+    for(nNewNewSize=64; nNewNewSize < nLimit; nNewNewSize <<= 1) { } // NOTE:  64 bytes is the smallest allocation unit
 
-          if(pxMask)
-          {
-            XFreePixmap(pDisplay, pxMask);
-            pxMask = None;
-          }
+    pRval = realloc(pMH, nNewNewSize); // for now...
+    if(pRval)
+    {
+#ifdef HAVE_MALLOC_USABLE_SIZE
+      void *pActual = pRval;
+#endif // HAVE_MALLOC_USABLE_SIZE
 
-          XFreePixmap(pDisplay, pxImage);
-          pxImage = None;
+      pMH = (struct __malloc_header__ *)pRval;
+      pRval += sizeof(*pMH);
 
-          iRval = -1;
-        }
-        else
-        {
-          // I will need to create a GC
-          // TODO:  use WBXPutImage instead?  For now, no.
-          XPutImage(pDisplay, pxImage, gc, pImage, 0, 0, 0, 0, iW, iH); // and now I have a copy of it
+      pMH->cbRequest = nNewSize;
 
-          if(WB_LIKELY(pImage->data == pB)) // data pointer matches my allocated data 'pB'
-          {
-            pImage->data = NULL; // MUST do this before calling XDestroyImage - I free pB later
-          }
+#ifdef HAVE_MALLOC_USABLE_SIZE
+      nLimit = malloc_usable_size(pActual); // the ACTUAL SIZE of the memory block
+      if(nLimit > nNewSize)
+      {
+        nNewSize = nLimit;
+      }
+#endif // HAVE_MALLOC_USABLE_SIZE
+      pMH->cbSize = nNewNewSize - sizeof(*pMH);
 
-          XFreeGC(pDisplay, gc);
-        }
+      __AllocCountResize(pMH, cbOldRequest, nOldSize);
 
-        // TODO:  use WBXDestroyImage instead?  For now, no.
-        XDestroyImage(pImage);
+      if(pRval != (void *)pMH)
+      {
+        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                       "INFO:  %s.%d - re-allocated %p as %p, from %d bytes to %d\n",
+                       __FUNCTION__, __LINE__, pBuf, pRval, nOldSize, nNewSize);
       }
+      else
+      {
+        WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Memory,
+                       "INFO:  %s.%d - re-allocated %p from %d bytes to %d\n",
+                       __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
+      }
+    }
+    else
+    {
+      WB_DEBUG_PRINT(DebugLevel_WARN | DebugSubSystem_Memory,
+                     "WARN:  %s.%d - not enough memory to re-allocate %p from %d bytes to %d\n",
+                     __FUNCTION__, __LINE__, pBuf, nOldSize, nNewSize);
     }
   }
-
-  WBFree(pB); // assume it wasn't realloc'd before
-
-  if(pPixmap)
+  else
   {
-    *pPixmap = pxImage;
+    WB_ERROR_PRINT("ERROR - %s NOT re-allocating memory %p\n", __FUNCTION__, pBuf);
   }
 
-  if(pMask)
-  {
-    *pMask = pxMask;
-  }
+  return pRval;
+}
 
-  if(pAttr)
-  {
-    pAttr->width = iW;
-    pAttr->height = iH;
-    pAttr->depth = DefaultDepth(pDisplay, DefaultScreen(pDisplay));
-  }
+void * WBReAlloc(void *pBuf, int nNewSize)
+{
+  return __WBReAlloc(pBuf, nNewSize, NULL, 0);
+}
 
-  return iRval;
+void * WBReAllocTrack(void *pBuf, int nNewSize, const char *szFile, int iLine)
+{
+  return __WBReAlloc(pBuf, nNewSize, szFile, iLine);
 }
 
+void WBSubAllocTrashMasher(void)
+{
+WB_SLAB_CACHE *pCache;
+WB_SLAB_CLASS *pSC;
+WB_SLAB *pSlab, *pNext;
+unsigned int nClass;
 
 
+  // the calling thread's cached blocks go back to their slabs first, so that more of them might be empty
 
+  pCache = bSlabCacheKey ? (WB_SLAB_CACHE *)pthread_getspecific(keySlabCache) : NULL;
 
+  if(pCache)
+  {
+    __SlabCacheFlush(pCache);
+  }
 
+  // completely empty slabs are returned to the OS
 
-// some code may have been adapted from libXpm source - SEE ORIGINAL COPYRIGHT NOTICE BELOW
-// I actually DID re-write it from scratch, after studying their code _AND_ doing a bunch of
-// online research for standard X11 documentation, but just in case here's their copyright
+  for(nClass=0; nClass < WB_SLAB_CLASSES; nClass++)
+  {
+    pSC = aSlabClass + nClass;
 
-/********************** libXpm ORIGINAL SOURCE COPYRIGHT **************************/
-/*
- * Copyright (C) 1989-95 GROUPE BULL
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to
- * deal in the Software without restriction, including without limitation the
- * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
- * sell copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
- * GROUPE BULL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
- * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
- * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- *
- * Except as contained in this notice, the name of GROUPE BULL shall not be
- * used in advertising or otherwise to promote the sale, use or other dealings
- * in this Software without prior written authorization from GROUPE BULL.
- */
+    pthread_mutex_lock(&(pSC->mtx));
 
+    for(pSlab = pSC->pAvailable; pSlab; pSlab = pNext)
+    {
+      pNext = pSlab->pNext;
 
+      if(!pSlab->nUsed)
+      {
+        __SlabUnlinkAvailable(pSC, pSlab);
 
-#endif // !defined(HAVE_XPM)
+        munmap(pSlab, WB_SLAB_SIZE);
 
+        pSC->nSlabs--;
+      }
+    }
 
+    pthread_mutex_unlock(&(pSC->mtx));
+  }
+}
 
-////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                        //
-//   _____  _  _         ____                         _            _                      //
-//  |  ___|(_)| |  ___  |  _ \  ___  _ __  _ __ ___  (_) ___  ___ (_)  ___   _ __   ___   //
-//  | |_   | || | / _ \ | |_) |/ _ \| '__|| '_ ` _ \ | |/ __|/ __|| | / _ \ | '_ \ / __|  //
-//  |  _|  | || ||  __/ |  __/|  __/| |   | | | | | || |\__ \\__ \| || (_) || | | |\__ \  //
-//  |_|    |_||_| \___| |_|    \___||_|   |_| |_| |_||_||___/|___/|_| \___/ |_| |_||___/  //
-//                                                                                        //
-//                                                                                        //
-////////////////////////////////////////////////////////////////////////////////////////////
+static void __AllocAddCounters(WB_ALLOC_STATS *pStats, const WB_ALLOC_COUNTERS *pC)
+{
+  pStats->nAllocs += pC->nAllocs;
+  pStats->nFrees += pC->nFrees;
+  pStats->cbLive += pC->cbLive;
+  pStats->cbLiveBlock += pC->cbLiveBlock;
+}
 
-#if !defined(WIN32) || defined(__DOXYGEN__)
-/** \ingroup internal
-  * \brief obtain group 'GID' list via 'getgroups()'
-  *
-  * \returns A 'WBAlloc()'d pointer to a list of GIDs, the first of which is the count
-**/
-gid_t * internalWBGetGroupList(void)
+void WBAllocGetStats(WB_ALLOC_STATS *pTotal, WB_ALLOC_STATS *paClass)
 {
-gid_t *pRval;
-gid_t temp;
-int nEntries;
+WB_ALLOC_STATS aStats[WB_ALLOC_STATS_CLASSES], xTotal;
+WB_SLAB_CACHE *pCache;
+unsigned int nClass;
 
-  nEntries = getgroups(0, &temp);
 
-  if(nEntries < 0)
-    return NULL;
+  memset(aStats, 0, sizeof(aStats));
+  memset(&xTotal, 0, sizeof(xTotal));
 
-  pRval = (gid_t *)WBAlloc(sizeof(gid_t) * (nEntries + 2));
+  // other threads' counters are read while they may be changing.  Each value is
+  // consistent by itself, which is good enough for statistics.
 
-  if(pRval)
+  pthread_mutex_lock(&xAllocStatsMutex);
+
+  for(nClass=0; nClass < WB_ALLOC_STATS_CLASSES; nClass++)
   {
-    memset(pRval, 0, sizeof(gid_t) * (nEntries + 2));
-    pRval[0] = nEntries;
+    __AllocAddCounters(aStats + nClass, aAllocRetired + nClass);
 
-    if(getgroups(nEntries, pRval + 1))
+    for(pCache = pSlabCacheList; pCache; pCache = pCache->pNext)
     {
-      WBFree(pRval);
-      return NULL;
+      __AllocAddCounters(aStats + nClass, pCache->aCounters + nClass);
     }
   }
 
-  return pRval;
-}
-#endif // !WIN32 || __DOXYGEN__
+  pthread_mutex_unlock(&xAllocStatsMutex);
 
-int WBFileIsReadable(const char *szFileName)
-{
-#ifdef WIN32
-#error implement for WIN32
-#else // !WIN32
-//int iRval;
-//struct stat sF;
-//
-//  iRval = stat(szFileName, &sF);
-//
-//  // TODO check sF.st_mode for permision flags via matches to geteuid() and the group list from above
+  for(nClass=0; nClass < WB_ALLOC_STATS_CLASSES; nClass++)
+  {
+    aStats[nClass].nLive = aStats[nClass].nAllocs - aStats[nClass].nFrees;
 
-  return eaccess(szFileName, R_OK);
-#endif // WIN32
+    aStats[nClass].cbPeak = acbAllocPeak[nClass] > aStats[nClass].cbLiveBlock
+                          ? acbAllocPeak[nClass] : aStats[nClass].cbLiveBlock;
+
+    xTotal.nAllocs += aStats[nClass].nAllocs;
+    xTotal.nFrees += aStats[nClass].nFrees;
+    xTotal.nLive += aStats[nClass].nLive;
+    xTotal.cbLive += aStats[nClass].cbLive;
+    xTotal.cbLiveBlock += aStats[nClass].cbLiveBlock;
+  }
+
+  xTotal.cbPeak = acbAllocPeak[WB_ALLOC_STATS_CLASSES] > xTotal.cbLiveBlock
+                ? acbAllocPeak[WB_ALLOC_STATS_CLASSES] : xTotal.cbLiveBlock;
+
+  if(pTotal)
+  {
+    memcpy(pTotal, &xTotal, sizeof(*pTotal));
+  }
+
+  if(paClass)
+  {
+    memcpy(paClass, aStats, sizeof(aStats));
+  }
 }
 
-int WBFileIsWriteable(const char *szFileName)
+static void __AllocDumpStatsLine(const char *szName, const WB_ALLOC_STATS *pStats)
 {
-#ifdef WIN32
-#error implement for WIN32
-#else // !WIN32
-  return eaccess(szFileName, W_OK);
-#endif // WIN32
+  WBDebugPrint("  %-7s %10lld %10lld %8lld %12lld %12lld %10lld %12lld\n", szName,
+               (long long)pStats->nAllocs, (long long)pStats->nFrees, (long long)pStats->nLive,
+               (long long)pStats->cbLive, (long long)pStats->cbLiveBlock,
+               (long long)(pStats->cbLiveBlock - pStats->cbLive), (long long)pStats->cbPeak);
 }
 
+void WBAllocDumpStats(int nTopSites)
+{
+WB_ALLOC_STATS aStats[WB_ALLOC_STATS_CLASSES], xTotal;
+unsigned int auiTop[WB_ALLOC_TOP_SITES_MAX];
+WB_INT64 cbSlabBlocks = 0;
+unsigned int nClass, nSlabs = 0, uiSite;
+int i1, i2, nTop = 0;
+char tbuf[16];
 
 
+  WBAllocGetStats(&xTotal, aStats);
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                                               //
-//   ____         _    _                              _   _____                         _____  _  _              //
-//  |  _ \  __ _ | |_ | |__   ___    __ _  _ __    __| | |_   _|___  _ __ ___   _ __   |  ___|(_)| |  ___  ___   //
-//  | |_) |/ _` || __|| '_ \ / __|  / _` || '_ \  / _` |   | | / _ \| '_ ` _ \ | '_ \  | |_   | || | / _ \/ __|  //
-//  |  __/| (_| || |_ | | | |\__ \ | (_| || | | || (_| |   | ||  __/| | | | | || |_) | |  _|  | || ||  __/\__ \  //
-//  |_|    \__,_| \__||_| |_||___/  \__,_||_| |_| \__,_|   |_| \___||_| |_| |_|| .__/  |_|    |_||_| \___||___/  //
-//                                                                             |_|                               //
-//                                                                                                               //
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  WBDebugPrint("Memory allocation statistics (bytes)\n");
+  WBDebugPrint("  %-7s %10s %10s %8s %12s %12s %10s %12s\n", "class",
+               "allocs", "frees", "live", "requested", "in use", "slack", "peak");
 
+  for(nClass=0; nClass < WB_SLAB_CLASSES; nClass++)
+  {
+    snprintf(tbuf, sizeof(tbuf), "%u", __SlabClassSize(nClass));
 
-// NOTE:  this does NOT canonicalize the path, so '~' and whatnot need
-//        to be handled separately
-int WBMkDir(const char *szFileName, int flags)
-{
-int iRval = -1;
+    __AllocDumpStatsLine(tbuf, aStats + nClass);
 
-  if(!szFileName || !*szFileName)
-  {
-    return -1; // always an error to create a 'blank' directory
+    nSlabs += aSlabClass[nClass].nSlabs; // a snapshot, so no lock
+    cbSlabBlocks += aStats[nClass].cbLiveBlock;
   }
 
-#ifdef WIN32
-//#error not yet implemented
-  iRval = !CreateDirectory(szFileName, NULL)   // TODO assign 'flags' for security?
-        ? 0 : GetLastError();
+  __AllocDumpStatsLine("malloc", aStats + WB_SLAB_CLASSES);
+  __AllocDumpStatsLine("total", &xTotal);
 
-  _chmod(szFileName, flags);  // attempt it
-#else // WIN32
+  WBDebugPrint("  %u slabs (%lld bytes), %lld bytes in use (%d%%)\n", nSlabs,
+               (long long)nSlabs * WB_SLAB_SIZE, (long long)cbSlabBlocks,
+               nSlabs ? (int)(cbSlabBlocks * 100 / ((WB_INT64)nSlabs * WB_SLAB_SIZE)) : 0);
 
-  if(szFileName[0] == '/' && !szFileName[1])
+  if(nTopSites <= 0)
   {
-    return 0; // always succeed if attempting to create the root dir
+    return;
   }
 
-  iRval = mkdir(szFileName, flags); // attempt it
-  if(iRval && errno == ENOENT) // need to recursively create it
+  if(nTopSites > WB_ALLOC_TOP_SITES_MAX)
   {
-    char *p1, *p2;
-    // remove one element of the path, and recursively attempt to make THAT one
+    nTopSites = WB_ALLOC_TOP_SITES_MAX;
+  }
 
-    p1 = WBCopyString(szFileName);
-    if(p1)
+  pthread_mutex_lock(&xAllocSiteMutex);
+
+  if(!nAllocSites)
+  {
+    WBDebugPrint("  (allocation sites are only recorded with WB_ALLOC_TRACKING)\n");
+  }
+  else
+  {
+    // select the top sites by live bytes (insertion sort, largest first)
+
+    for(uiSite=1; uiSite < WB_ALLOC_SITE_MAX; uiSite++)
     {
-      p2 = p1 + strlen(p1) - 1;
-      if(*p2 == '/') // already?
+      if(!pAllocSites[uiSite].szFile)
       {
-        p2--;
+        continue;
       }
-      while(p2 > p1 && *p2 != '/')
+
+      for(i1=nTop; i1 > 0 && pAllocSites[auiTop[i1 - 1]].cbLive < pAllocSites[uiSite].cbLive; i1--)
+      { }
+
+      if(i1 >= nTopSites)
       {
-        p2--;
+        continue;
       }
 
-      if(p2 > p1)
+      if(nTop < nTopSites)
       {
-        *p2 = 0;
-        iRval = WBMkDir(p1, flags);
+        nTop++;
+      }
 
-        if(!iRval) // I was able to create things 'above this'
-        {
-          iRval = mkdir(szFileName, flags);
-        }
+      for(i2=nTop - 1; i2 > i1; i2--)
+      {
+        auiTop[i2] = auiTop[i2 - 1];
       }
 
-      WBFree(p1);
+      auiTop[i1] = uiSite;
     }
-  }
-#endif // WIN32
 
-  return iRval;
-}
+    WBDebugPrint("  top %d of %u allocation sites by live bytes:\n", nTop, nAllocSites);
 
-char * WBSearchPath(const char *szFileName)
-{
-char *pRval = NULL;
-const char *p1, *pCur, *pPath;
-char *p2;
-int iTemp, cbRval;
+    for(i1=0; i1 < nTop; i1++)
+    {
+      WB_ALLOC_SITE *pSite = pAllocSites + auiTop[i1];
 
+      WBDebugPrint("    %s:%d - %lld live blocks, %lld bytes (peak %lld), %lld allocations\n",
+                   pSite->szFile, pSite->iLine, (long long)pSite->nLive,
+                   (long long)pSite->cbLive, (long long)pSite->cbPeak, (long long)pSite->nAllocs);
+    }
+  }
 
-  if(0 > WBStat(szFileName, NULL)) // file does not exist?
+  pthread_mutex_unlock(&xAllocSiteMutex);
+}
+
+void WBAllocLeakReport(void)
+{
+WB_ALLOC_STATS xTotal;
+WB_INT64 nLive = 0, cbLive = 0;
+unsigned int uiSite;
+
+
+  WBAllocGetStats(&xTotal, NULL);
+
+  if(!xTotal.nLive)
   {
-    if(*szFileName == '/') // absolute path
-    {
-no_stat:
-      WB_ERROR_PRINT("%s - File does not exist: \"%s\"\n", __FUNCTION__, szFileName);
-      return NULL;
-    }
+    WBDebugPrint("Memory leak report:  all blocks were freed\n");
+    return;
+  }
 
-    // check PATH environment variable, and locate first match
-    cbRval = 2 * PATH_MAX + strlen(szFileName);
-    pRval = WBAlloc(cbRval + 2);
+  WBDebugPrint("Memory leak report:  %lld blocks, %lld bytes not freed\n",
+               (long long)xTotal.nLive, (long long)xTotal.cbLive);
 
-    if(pRval)
-    {
-#ifdef WIN32
-      int cb1 = SearchPath(NULL, szFileName, NULL, PATH_MAX, pRval,(TCHAR **)&p1);
+  pthread_mutex_lock(&xAllocSiteMutex);
 
-      if(cb1 > 0)
-      {
-        pRval[cb1] = 0;
-      }
-      else
+  if(nAllocSites)
+  {
+    for(uiSite=1; uiSite < WB_ALLOC_SITE_MAX; uiSite++)
+    {
+      if(pAllocSites[uiSite].szFile && pAllocSites[uiSite].nLive)
       {
-        free(pRval);
-        pRval = WBCopyString(szFileName);
+        WBDebugPrint("    %s:%d - %lld blocks, %lld bytes\n",
+                     pAllocSites[uiSite].szFile, pAllocSites[uiSite].iLine,
+                     (long long)pAllocSites[uiSite].nLive, (long long)pAllocSites[uiSite].cbLive);
+
+        nLive += pAllocSites[uiSite].nLive;
+        cbLive += pAllocSites[uiSite].cbLive;
       }
+    }
 
-      if(pRval && !WBStat(pRval, NULL))
-      {
-        // this function returns non-zero if file not found
-        if(0 > WBStat(pRval, NULL))
-        {
-          if(pRval)
-          {
-            free(pRval);
-          }
+    if(nLive < xTotal.nLive)
+    {
+      WBDebugPrint("    (untracked) - %lld blocks, %lld bytes\n",
+                   (long long)(xTotal.nLive - nLive), (long long)(xTotal.cbLive - cbLive));
+    }
+  }
 
-          goto no_stat;
-        }
+  pthread_mutex_unlock(&xAllocSiteMutex);
+}
 
-        return pRval; // FOUND!
-      }
 
-      if(pRval)
-      {
-        free(pRval);
-        pRval = NULL;
-      }
-#else // WIN32
-      pPath = getenv("PATH"); // not malloc'd, but should not modify
-      if(pPath)
-      {
-        pCur = pPath;
+// *************************
+// SCOPED 'ARENA' ALLOCATION
+// *************************
 
-        while(*pCur)
-        {
-          *pRval = 0; // reset
+// DESIGN NOTES
+// a) an arena is a list of chunks (newest first), each one WBAlloc'd.  Memory is handed out from the
+//    newest chunk by advancing 'pCur', aligned to WB_ARENA_ALIGN.
+// b) a mark is just the value of 'pCur'.  Resetting to a mark discards every chunk that doesn't contain
+//    it, then sets 'pCur' back.  A NULL mark (taken when the arena was empty) discards everything.
+// c) one discarded chunk of the default size is kept as 'pSpare', so that repeated mark/alloc/reset
+//    cycles don't allocate anything.
 
-          p1 = pCur;
-          while(*p1 && *p1 != ':')
-          {
-            p1++;
-          }
+#define WB_ARENA_ALIGN 16                  /* alignment of arena memory, a power of 2 */
+#define WB_ARENA_DEFAULT_CHUNK 16384       /* default chunk size, including the WB_ARENA_CHUNK header */
+#define WB_ARENA_ROUND(X) (((X) + WB_ARENA_ALIGN - 1) & ~(WB_ARENA_ALIGN - 1))
 
-          iTemp = p1 - pCur; // the position of the ':'
+typedef struct __WB_ARENA_CHUNK__
+{
+  struct __WB_ARENA_CHUNK__ *pPrev;  // the previous (older) chunk
+  unsigned char *pEnd;               // end of this chunk
+} WB_ARENA_CHUNK;
 
-          if(iTemp + 2 < 2 * PATH_MAX) // only if not a buffer overrun
-          {
-            // build path name
-            memcpy(pRval, pCur, iTemp);
-            pRval[iTemp] = 0;
+#define WB_ARENA_CHUNK_DATA(X) ((unsigned char *)(X) + WB_ARENA_ROUND(sizeof(WB_ARENA_CHUNK)))
 
-            WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_File,
-                           "%s.%d - searching \"%s\"\n", __FUNCTION__, __LINE__, pRval);
+struct __WB_ARENA__
+{
+  WB_ARENA_CHUNK *pChunk;   // the current (newest) chunk, or NULL
+  unsigned char *pCur;      // next free byte in 'pChunk', or NULL
+  unsigned char *pLast;     // the most recent allocation (which can grow in place), or NULL
+  WB_ARENA_CHUNK *pSpare;   // an empty chunk that's kept for re-use, or NULL
+  unsigned int cbChunk;     // chunk size, including the header
+};
 
-            if(pRval[iTemp - 1] != '/')
-            {
-              pRval[iTemp] = '/';
-              strlcpy(pRval + iTemp + 1, szFileName, cbRval - (iTemp + 1));
-            }
-            else
-            {
-              strlcpy(pRval + iTemp, szFileName, cbRval - iTemp);
-            }
+static pthread_key_t keyArenaScratch;
+static pthread_once_t xArenaScratchOnce = PTHREAD_ONCE_INIT;
+static int bArenaScratchKey = 0;  // non-zero if 'keyArenaScratch' is valid
 
-            WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
-                           "%s.%d - trying \"%s\"\n", __FUNCTION__, __LINE__, pRval);
 
-            if(!WBStat(pRval, NULL))
-            {
-              return pRval; // FOUND!
-            }
-          }
+WB_ARENA WBArenaCreate(int cbChunk)
+{
+WB_ARENA pRval;
 
-          if(*p1)
-          {
-            p1++;
-          }
 
-          pCur = p1; // pointer to next path to search, or end of string
-        }
-      }
+  pRval = (WB_ARENA)WBAlloc(sizeof(*pRval));
 
-      pPath = pCur = p1 = NULL; // make sure I NULL them out (prevent pointer re-use)
+  if(!pRval)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory\n", __FUNCTION__);
+    return NULL;
+  }
 
-      // if I get here I should check ONE MORE TIME at the location of X11workbench in case
-      // it was installed into a non-standard path someplace and I need one of its utilities
+  memset(pRval, 0, sizeof(*pRval));
 
-      p2 = WBCopyString(GetStartupAppName());
-      if(p2)
-      {
-        if(*p2 && strlen(p2) < 2 * PATH_MAX) // so I don't overflow
-        {
-          p1 = strrchr(p2, '/'); // find the last '/'
-          if(p1)
-          {
-            p2[p1 - p2 + 1] = 0; // terminate with 0 byte (p1 is const)
-          }
-          else
-          {
-            WBFree(p2);
-            p2 = NULL;
-          }
-        }
-        else
-        {
-          WBFree(p2);
-          p2 = NULL;
-        }
-      }
+  pRval->cbChunk = cbChunk > 0 ? WB_ARENA_ROUND((unsigned int)cbChunk) : WB_ARENA_DEFAULT_CHUNK;
 
-      p1 = NULL; // prevents pointer re-use
+  return pRval;
+}
 
-      if(p2)
-      {
-        strlcpy(pRval, p2, cbRval);         // the path for X11workbench's install directory
-        strlcat(pRval, szFileName, cbRval); // use path of X11workbench executable with szFileName
+void WBArenaDestroy(WB_ARENA hArena)
+{
+WB_ARENA_CHUNK *pChunk;
 
-        WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
-                       "%s.%d - trying \"%s\"\n", __FUNCTION__, __LINE__, pRval);
-      }
-      else // could not find, nor get path info
+
+  if(!hArena)
+  {
+    return;
+  }
+
+  while((pChunk = hArena->pChunk) != NULL)
+  {
+    hArena->pChunk = pChunk->pPrev;
+
+    WBFree(pChunk);
+  }
+
+  if(hArena->pSpare)
+  {
+    WBFree(hArena->pSpare);
+  }
+
+  WBFree(hArena);
+}
+
+void *WBArenaAlloc(WB_ARENA hArena, int nSize)
+{
+WB_ARENA_CHUNK *pChunk;
+unsigned char *pRval;
+unsigned int cbSize, cbNeed;
+
+
+  if(WB_UNLIKELY(!hArena || nSize < 0))
+  {
+    return NULL;
+  }
+
+  cbSize = WB_ARENA_ROUND((unsigned int)nSize);
+
+  if(WB_UNLIKELY(!hArena->pChunk || cbSize > (unsigned int)(hArena->pChunk->pEnd - hArena->pCur)))
+  {
+    // a new chunk - the spare one if it's big enough, otherwise a new one
+
+    cbNeed = cbSize + WB_ARENA_ROUND(sizeof(WB_ARENA_CHUNK));
+
+    if(hArena->pSpare && cbNeed <= (unsigned int)(hArena->pSpare->pEnd - (unsigned char *)hArena->pSpare))
+    {
+      pChunk = hArena->pSpare;
+      hArena->pSpare = NULL;
+    }
+    else
+    {
+      if(cbNeed < hArena->cbChunk)
       {
-        WBFree(pRval);
-        pRval = NULL;
+        cbNeed = hArena->cbChunk;
       }
-    }
 
-    if(!pRval || 0 > WBStat(pRval, NULL))
-    {
-      if(pRval)
+      pChunk = (WB_ARENA_CHUNK *)WBAlloc(cbNeed);
+
+      if(!pChunk)
       {
-        WBFree(pRval);
+        WB_ERROR_PRINT("ERROR:  %s - not enough memory for %d bytes\n", __FUNCTION__, nSize);
+        return NULL;
       }
 
-      goto no_stat;
-#endif // WIN32
+      pChunk->pEnd = (unsigned char *)pChunk + cbNeed;
     }
 
-    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
-                   "%s.%d - found \"%s\"\n", __FUNCTION__, __LINE__, pRval);
+    pChunk->pPrev = hArena->pChunk;
+    hArena->pChunk = pChunk;
+    hArena->pCur = WB_ARENA_CHUNK_DATA(pChunk);
   }
-  else
-  {
-    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
-                   "%s.%d - directly found \"%s\"\n", __FUNCTION__, __LINE__, szFileName);
 
-    pRval = WBCopyString(szFileName); // file exists, so return as-is
-  }
+  pRval = hArena->pCur;
+  hArena->pCur += cbSize;
+  hArena->pLast = pRval;
 
   return pRval;
 }
 
-
-char * WBTempFile0(const char *szExt)
-{
-char *pRval = NULL;
-const char *szDir = NULL;
-int i1;
-WB_FILE_HANDLE h1;
-union
+void *WBArenaReAlloc(WB_ARENA hArena, void *pBuf, int nOldSize, int nNewSize)
 {
-  WB_UINT64 ullTime;
-  unsigned short sA[4];
-} uX;
-static const char szH[17]="0123456789ABCDEF";
+unsigned char *pRval;
+unsigned int cbNew;
 
 
-#ifdef WIN32
-char szTemp[MAX_PATH + 1];
+  if(!pBuf)
+  {
+    return WBArenaAlloc(hArena, nNewSize);
+  }
 
-  GetEnvironmentVariable("TEMP", szTemp, MAX_PATH);
+  if(!hArena || nNewSize < 0)
+  {
+    return NULL;
+  }
 
-  szDir = szTemp;
+  if(nNewSize <= nOldSize)
+  {
+    return pBuf;
+  }
 
-#else // !WIN32
+  cbNew = WB_ARENA_ROUND((unsigned int)nNewSize);
 
-  // On POSIX systems, first use /var/tmp and if not available, use /tmp
+  if((unsigned char *)pBuf == hArena->pLast &&
+     cbNew <= (unsigned int)(hArena->pChunk->pEnd - hArena->pLast)) // grow it in place
+  {
+    hArena->pCur = hArena->pLast + cbNew;
 
-  szDir = "/var/tmp";
+    return pBuf;
+  }
 
-  if(0 > WBStat(szDir, NULL))
+  pRval = (unsigned char *)WBArenaAlloc(hArena, nNewSize);
+
+  if(pRval)
   {
-    szDir = "/tmp";
-    if(0 > WBStat(szDir, NULL))
-    {
-      return NULL; // unable to 'stat' the temp file directory
-    }
+    memcpy(pRval, pBuf, nOldSize);
   }
 
-#endif // !WIN32
+  return pRval;
+}
 
-  for(i1=0; i1 < 256; i1++) // don't try forever
+char *WBArenaCopyStringN(WB_ARENA hArena, const char *pStr, int nMaxChars)
+{
+const char *p1;
+char *pRval;
+int cbLen;
+
+
+  if(!pStr)
   {
-    pRval = WBCopyString(szDir);
+    return NULL;
+  }
 
-    if(pRval)
+  for(p1 = pStr, cbLen = 0; (nMaxChars < 0 || cbLen < nMaxChars) && *p1; p1++, cbLen++)
+  { } // same as 'strnlen'
+
+  pRval = (char *)WBArenaAlloc(hArena, cbLen + 1);
+
+  if(pRval)
+  {
+    if(cbLen)
     {
-#ifdef WIN32
-      WBCatString(&pRval, "\\wbtk0000");
-#else // !WIN32
-      WBCatString(&pRval, "/wbtk0000");
-#endif // !WIN32
+      memcpy(pRval, pStr, cbLen);
     }
 
+    pRval[cbLen] = 0;
+  }
 
-    uX.ullTime = WBGetTimeIndex();
-    uX.sA[0] ^= uX.sA[1];
-    uX.sA[0] ^= uX.sA[2];
-    uX.sA[0] ^= uX.sA[3];
+  return pRval;
+}
 
-    if(pRval)
-    {
-      char *pX = pRval + strlen(pRval) - 4; // point to first '0'
+WB_ARENA_MARK WBArenaMark(WB_ARENA hArena)
+{
+  return hArena ? (WB_ARENA_MARK)hArena->pCur : NULL;
+}
 
-      pX[0] = szH[(uX.sA[0] >> 12) & 0xf];
-      pX[1] = szH[(uX.sA[0] >> 8) & 0xf];
-      pX[2] = szH[(uX.sA[0] >> 4) & 0xf];
-      pX[3] = szH[uX.sA[0] & 0xf];
+void WBArenaReset(WB_ARENA hArena, WB_ARENA_MARK pMark)
+{
+WB_ARENA_CHUNK *pChunk;
 
-      if(szExt && *szExt)
-      {
-        if(*szExt != '.')
-        {
-          WBCatString(&pRval, ".");
-        }
-        if(pRval)
-        {
-          WBCatString(&pRval, szExt);
-        }
-      }
-    }
 
-    if(pRval)
+  if(!hArena)
+  {
+    return;
+  }
+
+  while((pChunk = hArena->pChunk) != NULL &&
+        ((unsigned char *)pMark < WB_ARENA_CHUNK_DATA(pChunk) || (unsigned char *)pMark > pChunk->pEnd))
+  {
+    hArena->pChunk = pChunk->pPrev;
+
+    if(!hArena->pSpare && pChunk->pEnd - (unsigned char *)pChunk == hArena->cbChunk)
     {
-#ifdef WIN32
-      h1 = CreateFile(pRval, GENERIC_READ|GENERIC_WRITE, 0,
-                      NULL, // security descriptor - 0644 mode???
-                      CREATE_ALWAYS,
-                      /*FILE_ATTRIBUTE_TEMPORARY |*/ FILE_ATTRIBUTE_NORMAL,
-                      NULL);
-#else // !WIN32
-      h1 = open(pRval, O_CREAT | O_EXCL | O_RDWR, 0644); // create file, using '644' permissions, fail if exists
-      if(h1 < 0)
-        h1 = INVALID_HANDLE_VALUE;
-#endif // !WIN32
+      hArena->pSpare = pChunk;
+    }
+    else
+    {
+      WBFree(pChunk);
+    }
+  }
 
-      if(h1 == INVALID_HANDLE_VALUE) // error
-      {
-        WBFree(pRval);
-        pRval = NULL;
+  hArena->pCur = hArena->pChunk ? (unsigned char *)pMark : NULL;
+  hArena->pLast = NULL;
+}
 
-        if(errno == EEXIST)
-        {
-          WBDelay(499);
-          continue; // try again with a different name
-        }
+static void __ArenaScratchDestructor(void *pData) // called when a thread exits
+{
+  WBArenaDestroy((WB_ARENA)pData);
+}
 
-        if(errno == ENOTDIR || errno == ENOENT || errno == EACCES ||
-           errno == EPERM || errno == EROFS || errno == EMFILE || errno == ENFILE)
-        {
-          // these errors are fatal, so I exit now
-          break;
-        }
-      }
-      else
-      {
-#ifdef WIN32
-        CloseHandle(h1);
-#else  // !WIN32
-        close(h1);
-#endif // !WIN32
+static void __ArenaScratchKeyInit(void)
+{
+  bArenaScratchKey = !pthread_key_create(&keyArenaScratch, __ArenaScratchDestructor);
+}
 
-        // add this file to the existing list of temp files to be destroyed
-        // on exit from the program.
+static void __ArenaScratchFree(void) // the calling thread's scratch arena, for threads that don't 'exit' (like the main one)
+{
+WB_ARENA hArena;
 
-        break; // file name is valid and ready for use
-      }
-    }
-  }
 
-  return pRval;
+  if(bArenaScratchKey && (hArena = (WB_ARENA)pthread_getspecific(keyArenaScratch)) != NULL)
+  {
+    pthread_setspecific(keyArenaScratch, NULL);
+
+    WBArenaDestroy(hArena);
+  }
 }
 
-static void __add_to_temp_file_list(const char *szFile)
+WB_ARENA WBArenaScratch(void)
 {
-int i1 = strlen(szFile);
-char *pTemp;
+WB_ARENA pRval;
 
-  // TODO:  thread-safe?
 
-  if(!pTempFileList)
+  pthread_once(&xArenaScratchOnce, __ArenaScratchKeyInit);
+
+  if(WB_UNLIKELY(!bArenaScratchKey))
   {
-    cbTempFileList = PATH_MAX * 256;
-    pTempFileList = WBAlloc(cbTempFileList);
+    return NULL;
+  }
 
-    if(!pTempFileList)
-    {
-      return;
-    }
+  pRval = (WB_ARENA)pthread_getspecific(keyArenaScratch);
 
-    pTempFileListEnd = pTempFileList;
-  }
-  else if((pTempFileListEnd - pTempFileList) + i1 + 2 >= cbTempFileList)
+  if(WB_UNLIKELY(!pRval))
   {
-    pTemp = WBReAlloc(pTempFileList, cbTempFileList + (128 * PATH_MAX));
-    if(!pTemp)
-    {
-      return;
-    }
+    pRval = WBArenaCreate(0);
 
-    cbTempFileList += 128 * PATH_MAX; // using a 'while' loop sanity checks this against i1
-
-    if((pTempFileListEnd - pTempFileList) + i1 + 2 >= cbTempFileList) // sanity check
+    if(pRval && pthread_setspecific(keyArenaScratch, pRval))
     {
-      return; // don't bother re-allocating, this is probably NOT sane
+      WBArenaDestroy(pRval);
+      pRval = NULL;
     }
   }
 
-  memcpy(pTempFileListEnd, szFile, i1);
-  pTempFileListEnd += i1;
-
-  *(pTempFileListEnd++) = 0;
-  *pTempFileListEnd = 0; // always end with 2 0-bytes, point to 2nd one
+  return pRval;
 }
 
-char * WBTempFile(const char *szExt)
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//                  ____   _          _                                     //
+//                 / ___| | |_  _ __ (_) _ __    __ _  ___                  //
+//                 \___ \ | __|| '__|| || '_ \  / _` |/ __|                 //
+//                  ___) || |_ | |   | || | | || (_| |\__ \                 //
+//                 |____/  \__||_|   |_||_| |_| \__, ||___/                 //
+//                                              |___/                       //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+
+// ************************
+// generic string utilities
+// ************************
+
+#ifndef  HAVE_STRLCPY
+size_t strlcpy(char * dst, const char * src, size_t dstsize)
 {
-char *pRval = WBTempFile0(szExt);
+int nRval = 0;
+char *pE = dst + dstsize - 1;
 
-  if(pRval)
+  if(!dstsize || !dst || !src)
   {
-    __add_to_temp_file_list(pRval);
+    return 0;
   }
 
-  return pRval;
+  while(dst < pE && *src)
+  {
+    *(dst++) = *(src++);
+    nRval++;
+  }
+
+  *dst = 0; // always
+
+  return nRval; // # of characters up to but not including the 0 byte
 }
+#endif //  HAVE_STRLCPY
 
+#ifndef  HAVE_STRLCAT
+size_t strlcat(char * dst, const char * src, size_t dstsize)
+{
+int nRval = 0;
+char *pE = dst + dstsize - 1;
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                                                       //
-//   _____        _                             _      _                   _  _              _    _                      //
-//  | ____|__  __| |_  ___  _ __  _ __    __ _ | |    / \    _ __   _ __  | |(_)  ___  __ _ | |_ (_)  ___   _ __   ___   //
-//  |  _|  \ \/ /| __|/ _ \| '__|| '_ \  / _` || |   / _ \  | '_ \ | '_ \ | || | / __|/ _` || __|| | / _ \ | '_ \ / __|  //
-//  | |___  >  < | |_|  __/| |   | | | || (_| || |  / ___ \ | |_) || |_) || || || (__| (_| || |_ | || (_) || | | |\__ \  //
-//  |_____|/_/\_\ \__|\___||_|   |_| |_| \__,_||_| /_/   \_\| .__/ | .__/ |_||_| \___|\__,_| \__||_| \___/ |_| |_||___/  //
-//                                                          |_|    |_|                                                   //
-//                                                                                                                       //
-//                          _                _   ____                                                                    //
-//                         / \    _ __    __| | |  _ \  _ __  ___    ___  ___  ___  ___   ___  ___                       //
-//                        / _ \  | '_ \  / _` | | |_) || '__|/ _ \  / __|/ _ \/ __|/ __| / _ \/ __|                      //
-//                       / ___ \ | | | || (_| | |  __/ | |  | (_) || (__|  __/\__ \\__ \|  __/\__ \                      //
-//                      /_/   \_\|_| |_| \__,_| |_|    |_|   \___/  \___|\___||___/|___/ \___||___/                      //
-//                                                                                                                       //
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  if(!dstsize || !dst || !src)
+  {
+    return 0;
+  }
 
-///////////////////////////////////
-// EXTERNAL APPLICATION EXECUTION
-///////////////////////////////////
+  while(dst < pE && *dst)
+  {
+    dst++;
+  }
 
-WB_PROCESS_ID WBRunAsyncPipeV(WB_FILE_HANDLE hStdIn, WB_FILE_HANDLE hStdOut, WB_FILE_HANDLE hStdErr,
-                              const char *szAppName, va_list va)
-{
-const char *pArg;//, *pPath;
-char *pCur, *p1, *pAppName = NULL;
-#ifdef WIN32
-STARTUPINFO si;
-PROCESS_INFORMATION pi;
-#else // !WIN32
-char **argv;
-int i1, nItems, cbItems;
-va_list va2;
-#endif // WIN32
-WB_PROCESS_ID hRval = WB_INVALID_PROCESS_ID;
-WB_FILE_HANDLE hIn, hOut, hErr;
+  while(dst < pE && *src)
+  {
+    *(dst++) = *(src++);
+    nRval++;
+  }
 
+  *dst = 0; // always
 
-  // NOTE:  to avoid zombies, must assign SIGCHLD to 'SIG_IGN' or process them correctly
-  //        (this is done in 'WBInit')
+  return nRval; // # of characters up to but not including the 0 byte
+}
+#endif //  HAVE_STRLCAT
 
-  hIn = hOut = hErr = WB_INVALID_FILE_HANDLE; // by convention (WIN32 needs this anyway)
 
-  // FIRST, locate 'szAppName'
 
-  pAppName = WBSearchPath(szAppName);
+char * WBFormatString(const char *fmt, ...)
+{
+va_list va;
+int iSize = 1024, iTemp;
+char *pRval, *pTemp;
 
-  if(!pAppName)
-    return WB_INVALID_PROCESS_ID;
+  pRval = WBAlloc(iSize);
 
-  if(hStdIn == WB_INVALID_FILE_HANDLE) // re-dir to/from /dev/null
+  while(!pRval && iSize >= 256) // desperately try to allocate smaller blocks if out of RAM
   {
-#ifndef WIN32
-    hIn = open("/dev/null", O_RDONLY, 0);
-#else // WIN32
-    SECURITY_DESCRIPTOR *pSD = (SECURITY_DESCRIPTOR *)WBAlloc(SECURITY_DESCRIPTOR_MIN_LENGTH);
-
-    if(pSD)
-    {
-      SECURITY_ATTRIBUTES sa;
+    iSize /= 2;
+    pRval = WBAlloc(iSize);
+  }
 
-      InitializeSecurityDescriptor(pSD,SECURITY_DESCRIPTOR_REVISION);
+  if(!pRval)
+    return NULL;
 
-      sa.nLength = sizeof(sa);
-      sa.lpSecurityDescriptor = pSD;
-      sa.bInheritHandle = TRUE; // what a pain
+  va_start(va, fmt);
 
-      hIn = CreateFile("NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
-                       &sa, OPEN_EXISTING, NULL, NULL);
-      WBFree(pSD);
-    }
-#endif // WIN32
-  }
-  else
+  iTemp = vsnprintf(pRval, iSize, fmt, va);
+  if(iTemp >= iSize) // need to realloc
   {
-#ifndef WIN32
-    hIn = dup(hStdIn);
-#else // WIN32
-    if(!DuplicateHandle(GetCurrentProcess(), hStdIn,
-                        GetCurrentProcess(), &hIn, GENERIC_READ,
-                        TRUE, 0))
+    pTemp = WBReAlloc(pRval, iTemp + 2);
+    if(!pTemp)
     {
-      hIn = WB_INVALID_FILE_HANDLE;
+      WBFree(pRval);
+      pRval = NULL;
+    }
+    else
+    {
+      pRval = pTemp;
+      vsnprintf(pRval, iTemp + 2, fmt, va);
     }
-#endif // WIN32
   }
 
-  if(hStdOut == WB_INVALID_FILE_HANDLE) // re-dir to/from /dev/null
-  {
-#ifndef WIN32
-    hOut = open("/dev/null", O_WRONLY, 0);
-#else // WIN32
-    SECURITY_DESCRIPTOR *pSD = (SECURITY_DESCRIPTOR *)WBAlloc(SECURITY_DESCRIPTOR_MIN_LENGTH);
+  va_end(va);
 
-    if(pSD)
-    {
-      SECURITY_ATTRIBUTES sa;
+  return(pRval);
+}
 
-      InitializeSecurityDescriptor(pSD,SECURITY_DESCRIPTOR_REVISION);
 
-      sa.nLength = sizeof(sa);
-      sa.lpSecurityDescriptor = pSD;
-      sa.bInheritHandle = TRUE; // what a pain
+char *WBCopyString(const char *pSrc)
+{
+char *pDest;
+int iLen;
 
-      hOut = CreateFile("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
-                        &sa, OPEN_EXISTING, 0, NULL);
-      WBFree(pSD);
-    }
-#endif // WIN32
-  }
-  else
+  if(!pSrc || !*pSrc)
   {
-#ifndef WIN32
-    hOut = dup(hStdOut);
-#else // WIN32
-    if(!DuplicateHandle(GetCurrentProcess(), hStdOut,
-                        GetCurrentProcess(), &hOut, GENERIC_WRITE,
-                        TRUE, 0))
+    pDest = WBAlloc(2);
+
+    if(pDest)
     {
-      hOut = WB_INVALID_FILE_HANDLE;
+      *pDest = 0;
     }
-#endif // WIN32
   }
-
-  if(hStdErr == WB_INVALID_FILE_HANDLE) // re-dir to/from /dev/null
+  else
   {
-#ifndef WIN32
-    hErr = open("/dev/null", O_WRONLY, 0);
-#else // WIN32
-#ifdef DEBUG_STDERR_TO_STDOUT
-    if(hStdOut != WB_INVALID_FILE_HANDLE)
+    iLen = strlen(pSrc);
+
+    pDest = WBAlloc(iLen + 1);
+
+    if(pDest)
     {
-      if(!DuplicateHandle(GetCurrentProcess(), hStdOut,
-                          GetCurrentProcess(), &hErr, GENERIC_WRITE,
-                          TRUE, 0))
-      {
-        hErr = WB_INVALID_FILE_HANDLE;
-      }
+      memcpy(pDest, pSrc, iLen);
+      pDest[iLen] = 0;
     }
-    else
-#endif // DEBUG_STDERR_TO_STDOUT
-    {
-      SECURITY_DESCRIPTOR *pSD = (SECURITY_DESCRIPTOR *)WBAlloc(SECURITY_DESCRIPTOR_MIN_LENGTH);
+  }
 
-      if(pSD)
-      {
-        SECURITY_ATTRIBUTES sa;
+  return pDest;
+}
 
-        InitializeSecurityDescriptor(pSD,SECURITY_DESCRIPTOR_REVISION);
+char *WBCopyStringN(const char *pSrc, unsigned int nMaxChars)
+{
+char *pDest;
+unsigned int iLen;
+const char *p1;
 
-        sa.nLength = sizeof(sa);
-        sa.lpSecurityDescriptor = pSD;
-        sa.bInheritHandle = TRUE; // what a pain
+  if(!pSrc || !*pSrc)
+  {
+    pDest = WBAlloc(2);
 
-        hErr = CreateFile("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
-                          &sa, OPEN_EXISTING, 0, NULL);
-        WBFree(pSD);
-      }
+    if(pDest)
+    {
+      *pDest = 0;
     }
-#endif // WIN32
   }
   else
   {
-#ifndef WIN32
-    hErr = dup(hStdErr);
-#else // WIN32
-    if(!DuplicateHandle(GetCurrentProcess(), hStdErr,
-                        GetCurrentProcess(), &hErr, GENERIC_WRITE,
-                        TRUE, 0))
+    for(p1 = pSrc, iLen = 0; iLen < nMaxChars && *p1; p1++, iLen++)
+    { } // determine length of 'pStr' to copy
+
+    pDest = WBAlloc(iLen + 1);
+
+    if(pDest)
     {
-      hErr = WB_INVALID_FILE_HANDLE;
+      memcpy(pDest, pSrc, iLen);
+      pDest[iLen] = 0;
     }
-#endif // WIN32
   }
 
-  // if file handle duplication fails, exit now with an error
+  return pDest;
+}
 
-  if(hIn == WB_INVALID_FILE_HANDLE ||
-     hOut == WB_INVALID_FILE_HANDLE ||
-     hErr == WB_INVALID_FILE_HANDLE)
+
+void WBCatString(char **ppDest, const char *pSrc)  // concatenate onto WBAlloc'd string
+{
+int iLen, iLen2;
+int iMaxLen;
+char *p1, *p2;
+
+  if(!ppDest || !pSrc || !*pSrc)
   {
-//    WB_ERROR_PRINT("TEMPORARY:  %s hIn=%d hOut=%d hErr=%d\n", __FUNCTION__, hIn, hOut, hErr);
+    return;
+  }
 
-    if(hIn != WB_INVALID_FILE_HANDLE)
-    {
-#ifndef WIN32
-      close(hIn);
-#else // WIN32
-      CloseHandle(hIn);
-#endif // WIN32
-    }
-    if(hOut != WB_INVALID_FILE_HANDLE)
-    {
-#ifndef WIN32
-      close(hOut);
-#else // WIN32
-      CloseHandle(hOut);
-#endif // WIN32
-    }
-    if(hErr != WB_INVALID_FILE_HANDLE)
+  if(*ppDest)
+  {
+    p1 = p2 = *ppDest;
+
+    iMaxLen = WBAllocUsableSize(p1);
+
+    if(iMaxLen <= 0) // an error
     {
-#ifndef WIN32
-      close(hErr);
-#else // WIN32
-      CloseHandle(hErr);
-#endif // WIN32
+      return;
     }
 
-    if(pAppName != szAppName)
+    while(*p2
+          && (p2 - p1) < iMaxLen
+         )
     {
-      WBFree(pAppName);
+      p2++;
     }
 
-    return WB_INVALID_PROCESS_ID;
-  }
-
-#ifdef WIN32
+    iLen2 = strlen(pSrc);
+    iLen = iLen2 + (p2 - p1);
 
-  memset(&si, 0, sizeof(si));
-  memset(&pi, 0, sizeof(pi));
+    if((iLen + 1) > iMaxLen)
+    {
+      *ppDest = WBReAlloc(p1, iLen + 1);
+      if(!*ppDest)
+      {
+        *ppDest = p1;
+        return;  // not enough memory
+      }
 
-  si.cb = sizeof(si);
+      p2 = (p2 - p1) + *ppDest;  // re-position end of string
+    }
 
-  si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
-  si.hStdInput = hIn;
-  si.hStdOutput = hOut;
-  si.hStdError = hErr;
+    memcpy(p2, pSrc, iLen2);
+    p2[iLen2] = 0;  // make sure last byte is zero
+  }
+  else
+  {
+    *ppDest = WBCopyString(pSrc);
+  }
+}
 
-  // make sure it is hidden
-  si.wShowWindow = SW_HIDE;
+void WBCatStringN(char **ppDest, const char *pSrc, unsigned int nMaxChars)
+{
+int iLen, iLen2;
+int iMaxLen;
+char *p1, *p2;
+const char *p3;
 
-#if 1
-  // get application name from path
 
-  p1 = _tcsrchr((TCHAR *)pAppName, '\\');
-  if(p1)
+  if(!ppDest || !pSrc || !*pSrc)
   {
-    pCur = WBCopyString(p1 + 1); // just the name
+    return;
   }
-  else
+
+  if(*ppDest)
   {
-    pCur = WBCopyString(pAppName);
-  }
-#else // 0,1
-  pCur = WBCopyString(""); // need non-null pointer
-#endif // 0
+    p1 = p2 = *ppDest;
 
-  // build the command line
+    iMaxLen = WBAllocUsableSize(p1);
 
-  while(1)
-  {
-    pArg = va_arg(va, const TCHAR *);
-    if(!pArg)
+    if(iMaxLen <= 0)
     {
-      break;
+      return;
     }
 
-    WBCatString(&pCur, _T(" "));
 
-    // if the parameter contains a space, windows requires quotes.
-    if(strchr(pArg, ' '))
+    while(*p2
+          && (p2 - p1) < iMaxLen
+         )
     {
-      if(strchr(pArg, '"'))
-      {
-        WBCatString(&pCur, "'");
-        WBCatString(&pCur, pArg); // caller must add quotes as needed
-        WBCatString(&pCur, "'");
-      }
-      else
-      {
-        WBCatString(&pCur, "\"");
-        WBCatString(&pCur, pArg); // caller must add quotes as needed
-        WBCatString(&pCur, "\"");
-      }
+      p2++;
     }
-    else
-      WBCatString(&pCur, pArg); // caller must add quotes as needed
-  }
 
-  if(CreateProcess(pAppName, pCur, NULL, NULL, TRUE, NORMAL_PRIORITY_CLASS,
-                   NULL, NULL, &si, &pi))  // it worked?
-  {
-      // wait for process to complete before continuing...
+    for(iLen2=0, p3 = pSrc; iLen2 < nMaxChars && *p3; p3++, iLen2++)
+    { }  // determine what the length of pSrc is up to a zero byte or 'nMaxChars', whichever is first
 
-//        SetCursor(LoadCursor(NULL, IDC_WAIT));
-    hRval.uiProcessID = pi.dwProcessId;
-    hRval.hProcess = pi.hProcess;
-    hRval.iCachedExitCode = -1;
+    iLen = iLen2 + (p2 - p1);
 
-    WaitForInputIdle(pi.hProcess, 1000); // wait up to 1 sec to help it run
+    if((iLen + 1) > iMaxLen)
+    {
+      *ppDest = WBReAlloc(p1, iLen + 1);
+      if(!*ppDest)
+      {
+        *ppDest = p1; // restore the old pointer value
+        return;  // not enough memory
+      }
+
+      p2 = (p2 - p1) + *ppDest;  // re-position end of string
+    }
+
+    memcpy(p2, pSrc, iLen2);
+    p2[iLen2] = 0;  // make sure last byte is zero
   }
   else
   {
-    hRval = WB_INVALID_PROCESS_ID;
+    *ppDest = WBCopyStringN(pSrc, nMaxChars);
   }
+}
 
-  free(pCur);
-  pCur = NULL;
-
-  CloseHandle(hIn);
-  CloseHandle(hOut);
-  CloseHandle(hErr);
-
-#else // WIN32
-
-  // count arguments, determine memory requirement
+void WBDeQuoteString(char *pString)
+{
+char *p1, *pDest;
 
-  nItems = 0;
-  cbItems = 2 * sizeof(char *) + strlen(szAppName) + 1;
-  va_copy(va2, va);
+  p1 = pDest = pString;
 
-  while(1)
+  while(*p1)
   {
-    pArg = va_arg(va2, const char *);
-    if(!pArg)
+    if(*p1 == '"' || *p1 == '\'')
     {
-      break;
-    }
+      char c1 = *(p1++);
 
-    cbItems += strlen(pArg) + 1 + sizeof(char *);
-    nItems++;
-  }
+      while(*p1 &&
+            (*p1 != c1 || p1[1] == c1))
+      {
+        if(*p1 == c1)
+        {
+          p1++;
+        }
 
-  argv = (char **)WBAlloc(64 + cbItems);
-  if(!argv)
-  {
-    close(hIn);
-    close(hOut);
-    close(hErr);
+        *(pDest++) = *(p1++);
+      }
 
-    if(pAppName != szAppName)
-    {
-      WBFree(pAppName);
+      if(*p1 == c1)
+      {
+        p1++;
+      }
     }
+    else
+    {
+      if(pDest != p1)
+      {
+        *pDest = *p1;
+      }
 
-//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (1)\n", __FUNCTION__);
-    return WB_INVALID_FILE_HANDLE;
+      pDest++;
+      p1++;
+    }
   }
 
-  pCur = (char *)(argv + nItems + 2); // enough room for argument pointers
+  *pDest = 0; // make sure
+}
 
-  p1 = strrchr(szAppName, '/');
-  if(p1)
+static char __amp_char(char **ppSpot)
+{
+char *pS = *ppSpot;
+
+  if(!memcmp(pS, "&amp;", 5))
   {
-    strcpy(pCur, p1 + 1); // just the name (note - safe to use strcpy, I already did a size test before alloc'ing)
+    *ppSpot += 5;
+    return '&';
   }
-  else
+  else if(!memcmp(pS, "&lt;", 4))
   {
-    strcpy(pCur, szAppName); // having already tested for 'big enough' it's ok to use strcpy here
+    *ppSpot += 4;
+    return '<';
   }
-
-  argv[0] = pCur;
-  pCur += strlen(pCur) + 1;
-
-  for(i1=1; i1 <= nItems; i1++)
+  else if(!memcmp(pS, "&gt;", 4))
   {
-    pArg = va_arg(va, const char *);
-
-    strcpy(pCur, pArg); // having already tested for 'big enough' it's ok to use strcpy here
-    argv[i1] = pCur;
-    pCur += strlen(pCur) + 1;
+    *ppSpot += 4;
+    return '>';
   }
 
-  argv[nItems + 1] = NULL;
+  return 0;
+}
 
-  // now that I have a valid 'argv' I can spawn the process.
-  // I will return the PID so that the caller can wait on it
+void WBNormalizeXMLString(char *pString)
+{
+char *p1, *pDest;
+char c1, c2;
 
-  hRval = vfork();
 
-  if(!hRval) // the 'forked' process
-  {
-    // vfork jumps here FIRST and temporarily suspends the calling thread
-    // it also does NOT make a copy of memory so I must treat it as 'read only'
+  // not only de-quoting, but converting '&amp;' '&lt;' '&gt;' to '&' '<' and '>'
 
-    if(dup2(hIn, 0) != -1 && dup2(hOut, 1) != -1 && dup2(hErr, 2) != -1) // stdin, stdout, stderr
+  p1 = pDest = pString;
+
+  while(*p1)
+  {
+    if(*p1 == '"' || *p1 == '\'')
     {
-      static const char szMsg[]="ERROR: 'execve()' failure\n";
-      extern char **environ; // this is what the man page says to do (it's part of libc)
+      c1 = *(p1++);
 
-      // TODO:  customize environment?
+      while(*p1 &&
+            (*p1 != c1 || p1[1] == c1))
+      {
+        if(*p1 == c1)
+        {
+          p1++;
+        }
+        else if(*p1 == '&') // substitute
+        {
+          c2 = __amp_char(&p1);
 
-      signal(SIGHUP, SIG_IGN); // ignore 'HUP' signal before 'setsid' call ['daemon()' does this]
-      setsid(); // so that I am my own process group (NOTE doing this might make it impossible to get the exit status... must verify everywhere)
-      signal(SIGHUP, SIG_DFL); // restore default handling of 'HUP' ['daemon()' does this]
+          if(c2)
+          {
+            *(pDest++) = c2;
+            continue;
+          }
 
-      execve(pAppName, argv, environ); // NOTE:  execute clears all existing signal handlers back to 'default' but retains 'ignored' signals
+          // if it's not recognized, just process it as normal chars
+        }
 
-      write(2, szMsg, sizeof(szMsg) - 1); // stderr is still 'the old one' at this point
-      fsync(2);
+        *(pDest++) = *(p1++);
+      }
 
-      // TODO:  if execve fails, should I forcibly close the duplicated handles??
-//      close(0);
-//      close(1);
-//      close(2);
+      if(*p1 == c1)
+      {
+        p1++;
+      }
     }
-    else
+    else if(*p1 == '&') // substitute
     {
-      static const char szMsg[]="ERROR: 'dup2()' failure\n";
-      write(2, szMsg, sizeof(szMsg) - 1); // stderr is still 'the old one' at this point
+      c2 = __amp_char(&p1);
+
+      if(!c2)
+      {
+        goto normal_char; // just process it as normal chars
+      }
+
+      *(pDest++) = c2;
     }
+    else
+    {
+normal_char:
 
-    close(hIn); // explicitly close these if I get here
-    close(hOut);
-    close(hErr);
+      if(pDest != p1)
+      {
+        *pDest = *p1;
+      }
 
-    _exit(-1); // should never get here, but this must be done if execve fails
+      pDest++;
+      p1++;
+    }
   }
 
-  // once I've forked, I don't have to worry about copied memory or shared memory
-  // and it's safe to free the allocated 'argv' array.
-
-  WBFree(argv);
+  *pDest = 0; // make sure
+}
 
-  close(hIn);
-  close(hOut);
-  close(hErr);
+int WBStringLineCount(const char *pSrc, unsigned int nMaxChars)
+{
+int iRval = 1;
+const char *p1;
 
-#endif // WIN32
+  if(!pSrc || (!nMaxChars && !*pSrc))
+  {
+    return 0;
+  }
 
-  if(pAppName != szAppName)
+  if(!nMaxChars)
   {
-    WBFree(pAppName);
+    nMaxChars = strlen(pSrc);
   }
 
+  do
+  {
+    p1 = WBStringNextLine(pSrc, &nMaxChars);
+    if(p1 && nMaxChars) // another line remains
+    {
+      iRval++;
+    }
 
-  return hRval;
-}
+    pSrc = p1;
 
+  } while(pSrc && nMaxChars);
 
-WB_PROCESS_ID WBRunAsync(const char *szAppName, ...)
-{
-WB_PROCESS_ID idRval;
-va_list va;
+  return iRval;
+}
 
-  va_start(va, szAppName);
+const char *WBStringNextLine(const char *pSrc, unsigned int *pnMaxChars)
+{
+int nMaxChars;
 
-  idRval = WBRunAsyncPipeV(WB_INVALID_FILE_HANDLE, WB_INVALID_FILE_HANDLE,
-                           WB_INVALID_FILE_HANDLE, szAppName, va);
+  if(!pSrc)
+  {
+    if(pnMaxChars)
+    {
+      *pnMaxChars = 0;
+    }
 
-  va_end(va);
+    return NULL;
+  }
 
-  if(WB_PROCESS_ID_INVALID(idRval))
+  if(pnMaxChars)
   {
-    WB_ERROR_PRINT("Unable to run '%s'\n", szAppName);
+    nMaxChars = *pnMaxChars;
+  }
+  else if(!*pSrc)
+  {
+    return NULL; // end of string (no more)
+  }
+  else
+  {
+    nMaxChars = strlen(pSrc);
   }
-//  else
-//  {
-//    WB_ERROR_PRINT("Running '%s' - pid=%d\n", szAppName, idRval);
-//  }
 
-  return idRval;
+  // TODO:  handle MBCS differently? (for now, no special handling)
+
+  while(nMaxChars > 0)
+  {
+    if(*pSrc == '\r')
+    {
+      pSrc++;
+      nMaxChars--;
+
+      if(nMaxChars > 0 && *pSrc == '\n')
+      {
+        pSrc++;
+        nMaxChars--;
+      }
+
+      break;
+    }
+    else if(*pSrc == '\n')
+    {
+      pSrc++;
+      nMaxChars--;
+
+      if(nMaxChars > 0 && *pSrc == '\r')
+      {
+        pSrc++;
+        nMaxChars--;
+      }
+
+      break;
+    }
+    else if(*pSrc == '\f' || // form feed is like a newline
+            *pSrc == '\v')   // vertical tab (similar, for now)
+    {
+      pSrc++;
+      nMaxChars--;
+
+      break;
+    }
+// TODO:  check for UTF-8 paragraph and line separators?
+//        http://www.unicodemap.org/details/0x2028/index.html  (line separator - alternate LF?)
+//        http://www.unicodemap.org/details/0x202A/index.html  (paragraph separator - alternate to CTRL+L ?)
+//
+    else if(!*pSrc) // TODO:  test for unicode?  normally we just assume UTF-8 is compatible with ASCII
+    {
+      nMaxChars = 0;
+      break;
+    }
+
+    pSrc++;
+    nMaxChars--;
+  }
+
+  if(pnMaxChars)
+  {
+    *pnMaxChars = nMaxChars;
+  }
+
+  return pSrc;
 }
 
-WB_PROCESS_ID WBRunAsyncPipe(WB_FILE_HANDLE hStdIn, WB_FILE_HANDLE hStdOut, WB_FILE_HANDLE hStdErr,
-                             const char *szAppName, ...)
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+//                                                                                 //
+//   ____         _         _                _   _              _                  //
+//  |  _ \  ___  (_) _ __  | |_  ___  _ __  | | | |  __ _  ___ | |__    ___  ___   //
+//  | |_) |/ _ \ | || '_ \ | __|/ _ \| '__| | |_| | / _` |/ __|| '_ \  / _ \/ __|  //
+//  |  __/| (_) || || | | || |_|  __/| |    |  _  || (_| |\__ \| | | ||  __/\__ \  //
+//  |_|    \___/ |_||_| |_| \__|\___||_|    |_| |_| \__,_||___/|_| |_| \___||___/  //
+//                                                                                 //
+//                                                                                 //
+/////////////////////////////////////////////////////////////////////////////////////
+
+// The pointer hashes are kept in an open-addressed (linear probing) table keyed by the hash value.
+// Deleting an entry shifts the rest of its probe sequence back, so there are no 'deleted' markers.
+//
+// A hash value that is no longer valid stays in the table as a 'retired' entry (pValue == NULL) for
+// WB_HASH_JAM_PREVENTER_TIMEOUT milliseconds, so that the same value is not handed out again right away.
+// A second table (used only while holding the write lock) maps each pointer to its current hash.
+//
+// WBGetPointerFromHash() does not lock anything.  Writers bump 'uiPointerHashSeq' to an odd value while
+// they modify the table, and back to even when done; a reader that sees an odd value, or a value that
+// changed while it was looking, simply looks again.  When the table grows, the old one is kept until
+// exit, so that a reader that is still looking at it never touches free'd memory.
+
+typedef struct __pointer_hash__
 {
-WB_PROCESS_ID idRval;
-va_list va;
+  WB_UINT32 uiHash;     // 32-bit pointer hash value, zero for an empty slot
+  WB_UINT32 dwTick;     // millis count when I last created/referenced this hash (or when it was retired)
+  WB_UINT32 dwRefCount; // reference count (retired on '0')
+  void *pValue;         // the pointer value, or NULL for a 'retired' hash
+} POINTER_HASH;
 
-  va_start(va, szAppName);
+typedef struct __pointer_hash_table__
+{
+  struct __pointer_hash_table__ *pRetired; // the previous (smaller) table, free'd on exit
+  unsigned int nMax;    // number of entries in 'aSlot', always a power of 2
+  unsigned int nUsed;   // number of non-empty slots, including 'retired' hashes
+  POINTER_HASH aSlot[1];
+} POINTER_HASH_TABLE;
 
-  idRval = WBRunAsyncPipeV(hStdIn, hStdOut, hStdErr, szAppName, va);
+typedef struct __pointer_hash_index__
+{
+  void *pValue;         // the pointer, NULL for an empty slot
+  WB_UINT32 uiHash;     // its current hash value
+} POINTER_HASH_INDEX;
 
-  va_end(va);
+static POINTER_HASH_TABLE * volatile pPointerHashTable = NULL; // WBAlloc'd
+static POINTER_HASH_INDEX *pPointerHashIndex = NULL; // WBAlloc'd, only accessed by writers
+static unsigned int nPointerHashIndex = 0, nMaxPointerHashIndex = 0;
+static unsigned int uiPointerHashSweep = 0; // next slot to check for aging
 
-  return idRval;
+static volatile WB_UINT32 uiPointerHashSpinlock = 0; // writers only
+static volatile WB_UINT32 uiPointerHashSeq = 0;      // odd while a writer is modifying the table
+
+static void WBFreePointerHashes(void)
+{
+POINTER_HASH_TABLE *pTable;
+
+
+  while((pTable = pPointerHashTable) != NULL)
+  {
+    pPointerHashTable = pTable->pRetired;
+    WBFree(pTable);
+  }
+
+  if(pPointerHashIndex)
+  {
+    WBFree(pPointerHashIndex);
+    pPointerHashIndex = NULL;
+  }
+
+  nPointerHashIndex = 0;
+  nMaxPointerHashIndex = 0;
+  uiPointerHashSweep = 0;
+
+  uiPointerHashSpinlock = 0;
+  uiPointerHashSeq = 0;
 }
 
+static __inline__ unsigned int __PointerHashHome(WB_UINT32 uiKey, unsigned int nMax)
+{
+  // Fibonacci hashing
 
-#define WBRUNRESULT_BUFFER_MINSIZE 65536
-#define WBRUNRESULT_BYTES_TO_READ 256
+  uiKey *= 0x9e3779b1U;
 
-static char * WBRunResultInternal(WB_FILE_HANDLE hStdIn, WB_INT32 *pExitCode, const char *szAppName, va_list va)
+  return (unsigned int)((uiKey ^ (uiKey >> 15)) & (nMax - 1));
+}
+
+static __inline__ unsigned int __PointerIndexHome(const void *pValue, unsigned int nMax)
 {
-WB_PROCESS_ID idRval;
-#ifdef WIN32
-DWORD cb1;
-#endif // WIN32
-WB_FILE_HANDLE hP[2]; // [0] is read end, [1] is write end
-char *p1, *p2, *pRval;
-int i2, iRunning;
-#ifndef WIN32
-int i1, iStat;
-#endif // WIN32
-/*unsigned*/ int cbBuf;
+  return __PointerHashHome((WB_UINT32)((unsigned long)pValue >> 4) ^ (WB_UINT32)(((unsigned long)pValue >> 16) >> 20),
+                           nMax);
+}
 
+// returns the slot index for 'uiHash' in 'pTable', or -1 if not found.  Readers call this without
+// a lock, so it must never loop more than 'nMax' times, no matter what it reads.
+static __inline__ int __PointerHashFind(const POINTER_HASH_TABLE *pTable, WB_UINT32 uiHash)
+{
+unsigned int uiIndex, uiCount, nMax;
+WB_UINT32 uiSlotHash;
 
-  cbBuf = WBRUNRESULT_BUFFER_MINSIZE;
-  pRval = WBAlloc(cbBuf);
 
-  if(!pRval)
+  if(!pTable)
   {
-    return NULL;
+    return -1;
   }
 
-  // use WBRunAsyncPipeV to create a process, with all stdout piped to a char * buffer capture
-  // stdin and stderr still piped to/from /dev/null
+  nMax = pTable->nMax;
+  uiIndex = __PointerHashHome(uiHash, nMax);
 
-  // create an anonymous pipe.  hP[0] is the INPUT pipe, hP[1] is the OUTPUT pipe
-  // this is important in windows.  for POSIX it doesn't really matter which one you use,
-  // but by convention [0] will be input, [1] will be output
+  for(uiCount=0; uiCount < nMax; uiCount++, uiIndex = (uiIndex + 1) & (nMax - 1))
+  {
+    uiSlotHash = pTable->aSlot[uiIndex].uiHash;
 
-  hP[0] = hP[1] = WB_INVALID_FILE_HANDLE;
+    if(uiSlotHash == uiHash)
+    {
+      return (int)uiIndex;
+    }
+    else if(!uiSlotHash)
+    {
+      break;
+    }
+  }
 
-#ifdef WIN32 /* the WINDOWS way */
-  if(!CreatePipe(&(hP[0]), &(hP[1]), NULL, 0))
-#else // !WIN32 (everybody else)
-  if(0 > pipe(hP))
-#endif // WIN32
+  return -1;
+}
+
+// copy an entry into the first empty slot of its probe sequence.  The caller must ensure there is room.
+static POINTER_HASH *__PointerHashPlace(POINTER_HASH_TABLE *pTable, const POINTER_HASH *pEntry)
+{
+unsigned int uiIndex = __PointerHashHome(pEntry->uiHash, pTable->nMax);
+
+
+  while(pTable->aSlot[uiIndex].uiHash)
   {
-    WBFree(pRval);
-//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
-    return NULL;
+    uiIndex = (uiIndex + 1) & (pTable->nMax - 1);
   }
 
-#ifdef WIN32 /* the WINDOWS way */
-  SetHandleInformation(hP[1], HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
-#endif // WIN32
+  memcpy(pTable->aSlot + uiIndex, pEntry, sizeof(*pEntry));
 
-  idRval = WBRunAsyncPipeV(hStdIn, hP[1], // the 'write' end is passed as stdout
-                           WB_INVALID_FILE_HANDLE, szAppName, va);
+  return pTable->aSlot + uiIndex;
+}
 
-  if(WB_PROCESS_ID_INVALID(idRval))
+// writers only - remove slot 'iIndex', moving entries later in the probe sequence back as needed
+static void __PointerHashRemoveSlot(POINTER_HASH_TABLE *pTable, int iIndex)
+{
+unsigned int uiHole = (unsigned int)iIndex, uiIndex, uiHome, nMask = pTable->nMax - 1;
+
+
+  for(uiIndex = (uiHole + 1) & nMask; pTable->aSlot[uiIndex].uiHash; uiIndex = (uiIndex + 1) & nMask)
   {
-//    WB_ERROR_PRINT("TEMPORARY:  %s failed to run \"%s\" errno=%d\n", __FUNCTION__, szAppName, errno);
+    uiHome = __PointerHashHome(pTable->aSlot[uiIndex].uiHash, pTable->nMax);
 
-#ifdef WIN32 /* the WINDOWS way */
-    CloseHandle(hP[0]);
-    CloseHandle(hP[1]);
-#else // !WIN32 (everybody else)
-    close(hP[0]);
-    close(hP[1]);
-#endif // WIN32
+    // an entry can only move back to the hole if its home slot is not between the two
 
-    return NULL;
+    if(((uiIndex - uiHome) & nMask) >= ((uiIndex - uiHole) & nMask))
+    {
+      memcpy(pTable->aSlot + uiHole, pTable->aSlot + uiIndex, sizeof(pTable->aSlot[0]));
+      uiHole = uiIndex;
+    }
   }
 
-#ifndef WIN32
-  close(hP[1]); // by convention, this will 'widow' the read end of the pipe once the process is done with it
-  hP[1] = INVALID_HANDLE_VALUE;
+  bzero(pTable->aSlot + uiHole, sizeof(pTable->aSlot[0]));
+  pTable->nUsed--;
+}
 
-  fcntl(hP[0], F_SETFL, O_NONBLOCK); // set non-blocking I/O
-#endif // WIN32
+// writers only - returns the index in 'pPointerHashIndex' for 'pValue', or -1 if not found
+static int __PointerIndexFind(const void *pValue)
+{
+unsigned int uiIndex;
 
-  // so long as the process is alive, read data from the pipe and stuff it into the output buffer
-  // (the buffer will need to be reallocated periodically if it fills up)
 
-  p1 = pRval;
-  *p1 = 0;       // always do this
-  iRunning = 1;  // iRunning will be used as a flag to indicate the process exited.
+  if(!nPointerHashIndex)
+  {
+    return -1;
+  }
 
-  while(1)
+  for(uiIndex = __PointerIndexHome(pValue, nMaxPointerHashIndex);
+      pPointerHashIndex[uiIndex].pValue;
+      uiIndex = (uiIndex + 1) & (nMaxPointerHashIndex - 1))
   {
-    i2 = WBRUNRESULT_BYTES_TO_READ; // number of bytes to read at one time
-    if((p1 - pRval) + i2 >= cbBuf) // enough room for it?
+    if(pPointerHashIndex[uiIndex].pValue == pValue)
     {
-      i2 = cbBuf - (p1 - pRval);
-      if(i2 < WBRUNRESULT_BYTES_TO_READ / 8) // time to re-allocate
-      {
-        p2 = WBReAlloc(pRval, cbBuf + WBRUNRESULT_BUFFER_MINSIZE / 2);
-        if(!p2)
-        {
-          WBFree(pRval);
-          pRval = NULL;
+      return (int)uiIndex;
+    }
+  }
 
-//          WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (4)\n", __FUNCTION__);
-          break;
-        }
+  return -1;
+}
 
-        cbBuf += WBRUNRESULT_BUFFER_MINSIZE / 2;
-        p1 = p2 + (p1 - pRval);
-        pRval = p2;
-        i2 = WBRUNRESULT_BYTES_TO_READ;
-      }
-    }
+// writers only - the caller must ensure there is room, and that 'pValue' is not already there
+static void __PointerIndexInsert(void *pValue, WB_UINT32 uiHash)
+{
+unsigned int uiIndex = __PointerIndexHome(pValue, nMaxPointerHashIndex);
 
-    // if no data available I'll return immediately
-#ifdef WIN32 /* the Windows way */
-    cb1 = 0;
 
-    if(!PeekNamedPipe(hP[0], NULL, 0, NULL, &cb1, NULL))
-    {
-      DWORD dwErr;
-check_pipe_no_data_avail:
+  while(pPointerHashIndex[uiIndex].pValue)
+  {
+    uiIndex = (uiIndex + 1) & (nMaxPointerHashIndex - 1);
+  }
 
-      dwErr = GetLastError();
+  pPointerHashIndex[uiIndex].pValue = pValue;
+  pPointerHashIndex[uiIndex].uiHash = uiHash;
 
-      if(!iRunning)
-      {
-        break; // assume end of file, process ended, bail out now
-      }
+  nPointerHashIndex++;
+}
 
-      if(dwErr == ERROR_MORE_DATA || dwErr == ERROR_PIPE_BUSY || dwErr == ERROR_IO_PENDING
-         || dwErr == ERROR_NO_MORE_ITEMS/* EAGAIN */ )
-      {
-        Sleep(10); // wait 1/2 msec
-      }
-      else
+// writers only - same algorithm as __PointerHashRemoveSlot()
+static void __PointerIndexRemove(int iIndex)
+{
+unsigned int uiHole = (unsigned int)iIndex, uiIndex, uiHome, nMask = nMaxPointerHashIndex - 1;
+
+
+  for(uiIndex = (uiHole + 1) & nMask; pPointerHashIndex[uiIndex].pValue; uiIndex = (uiIndex + 1) & nMask)
+  {
+    uiHome = __PointerIndexHome(pPointerHashIndex[uiIndex].pValue, nMaxPointerHashIndex);
+
+    if(((uiIndex - uiHome) & nMask) >= ((uiIndex - uiHole) & nMask))
+    {
+      pPointerHashIndex[uiHole] = pPointerHashIndex[uiIndex];
+      uiHole = uiIndex;
+    }
+  }
+
+  pPointerHashIndex[uiHole].pValue = NULL;
+  pPointerHashIndex[uiHole].uiHash = 0;
+
+  nPointerHashIndex--;
+}
+
+// writers only - the hash stays in the table (with a NULL pointer) so that it won't be re-used right away
+static void __PointerHashRetire(POINTER_HASH *pEntry, WB_UINT32 dwTick)
+{
+int iIndex = __PointerIndexFind(pEntry->pValue);
+
+
+  if(iIndex >= 0 && pPointerHashIndex[iIndex].uiHash == pEntry->uiHash)
+  {
+    __PointerIndexRemove(iIndex);
+  }
+
+  pEntry->pValue = NULL; // thus marking it 'retired'
+  pEntry->dwRefCount = 0; // regardless of ref count, remove it
+  pEntry->dwTick = dwTick;
+}
+
+// writers only - check up to 'nCount' slots for hashes that have timed out, or retired hashes
+// that no longer need to be kept.  A few slots are checked each time, so the cost is spread out.
+static void __PointerHashSweep(WB_UINT32 dwTick, unsigned int nCount)
+{
+POINTER_HASH_TABLE *pTable = pPointerHashTable;
+POINTER_HASH *pEntry;
+
+
+  if(!pTable)
+  {
+    return;
+  }
+
+  if(nCount > pTable->nMax)
+  {
+    nCount = pTable->nMax;
+  }
+
+  while(nCount--)
+  {
+    uiPointerHashSweep &= pTable->nMax - 1;
+    pEntry = pTable->aSlot + uiPointerHashSweep;
+
+    if(!pEntry->uiHash)
+    {
+      // empty slot
+    }
+    else if(pEntry->pValue)
+    {
+      if((dwTick - pEntry->dwTick) > WB_SECURE_HASH_TIMEOUT) // too old?
       {
-        break; // an error of some kind, so bail out [pipe closed?]
+        __PointerHashRetire(pEntry, dwTick);
       }
     }
-    else if(!cb1)
+    else if((dwTick - pEntry->dwTick) > WB_HASH_JAM_PREVENTER_TIMEOUT)
     {
-      if(!iRunning)
-        break; // end of file
+      __PointerHashRemoveSlot(pTable, (int)uiPointerHashSweep);
+
+      continue; // another entry may have moved into this slot, so check it again
     }
-    else if(!ReadFile(hP[0], p1, i2, &cb1, NULL))
+
+    uiPointerHashSweep++;
+  }
+}
+
+// writers only - make room for one more hash, growing the tables as needed.  returns non-zero on error
+static int __PointerHashReserve(WB_UINT32 dwTick)
+{
+POINTER_HASH_TABLE *pTable = pPointerHashTable, *pNew;
+POINTER_HASH_INDEX *pOldIndex;
+unsigned int i1, nNewMax;
+
+
+  if(pTable && (pTable->nUsed + 1) * 2 > pTable->nMax)
+  {
+    __PointerHashSweep(dwTick, pTable->nMax); // check everything first, it may free up enough
+  }
+
+  if(!pTable || (pTable->nUsed + 1) * 2 > pTable->nMax)
+  {
+    nNewMax = pTable ? pTable->nMax * 2 : WB_POINTER_HASH_INITIAL_SIZE;
+
+    pNew = (POINTER_HASH_TABLE *)WBAlloc(sizeof(*pNew) + (nNewMax - 1) * sizeof(pNew->aSlot[0]));
+
+    if(!pNew)
     {
-      goto check_pipe_no_data_avail;
+      return -1;
     }
-    else if(!cb1)  // this just might be an error
+
+    bzero(pNew, sizeof(*pNew) + (nNewMax - 1) * sizeof(pNew->aSlot[0]));
+
+    pNew->nMax = nNewMax;
+    pNew->pRetired = pTable; // readers may still be looking at it
+
+    if(pTable)
     {
-      if(!iRunning)
-        break; // end of file
+      for(i1=0; i1 < pTable->nMax; i1++)
+      {
+        if(pTable->aSlot[i1].uiHash)
+        {
+          __PointerHashPlace(pNew, pTable->aSlot + i1);
+        }
+      }
+
+      pNew->nUsed = pTable->nUsed;
     }
-    else
+
+    WB_MEMORY_BARRIER(); // the new table must be complete before anyone can see it
+
+    pPointerHashTable = pNew;
+  }
+
+  if((nPointerHashIndex + 1) * 2 > nMaxPointerHashIndex)
+  {
+    pOldIndex = pPointerHashIndex;
+    nNewMax = nMaxPointerHashIndex ? nMaxPointerHashIndex * 2 : WB_POINTER_HASH_INITIAL_SIZE;
+
+    pPointerHashIndex = (POINTER_HASH_INDEX *)WBAlloc(nNewMax * sizeof(*pPointerHashIndex));
+
+    if(!pPointerHashIndex)
     {
-      p1 += cb1; // point past the # of bytes I just read in
-      *p1 = 0; // by convention [to make sure the string is ALWAYS terminated with a 0-byte]
+      pPointerHashIndex = pOldIndex;
+      return -1;
     }
 
-    if(iRunning) // only if "still running"
+    bzero(pPointerHashIndex, nNewMax * sizeof(*pPointerHashIndex));
+
+    i1 = nMaxPointerHashIndex;
+    nMaxPointerHashIndex = nNewMax;
+    nPointerHashIndex = 0;
+
+    while(i1 > 0)
     {
-      // for waitpid(), if WNOHANG is specified and there are no stopped, continued or exited children, 0 is returned
+      i1--;
 
-      if(WBGetProcessState(idRval, pExitCode) <= 0) // ended or error
+      if(pOldIndex[i1].pValue)
       {
-        iRunning = 0; // my flag that it's not running
+        __PointerIndexInsert(pOldIndex[i1].pValue, pOldIndex[i1].uiHash);
       }
+    }
 
-      Sleep(10); // so I don't 'spin' and IO completes at end of process
+    if(pOldIndex)
+    {
+      WBFree(pOldIndex);
     }
   }
 
-  // always kill the process at this point (in case there was an error)
+  return 0;
+}
 
-  Sleep(10); // wait 10 msec - prevents certain problems
+static void __PointerHashWriteLock(void)
+{
+  while(WBInterlockedExchange(&uiPointerHashSpinlock, 1))
+  {
+    WBDelay(100);
+  }
 
-  if(hP[1] != INVALID_HANDLE_VALUE)
-    CloseHandle(hP[1]); // done with the pipes - close them now
-  if(hP[0] != INVALID_HANDLE_VALUE)
-    CloseHandle(hP[0]);
+  uiPointerHashSeq++; // now odd - readers will wait for me
 
-#else // !WIN32 - everybody else
+  WB_MEMORY_BARRIER();
+}
 
-    i1 = read(hP[0], p1, i2);
+static void __PointerHashWriteUnlock(void)
+{
+  WB_MEMORY_BARRIER();
 
-    if(i1 <= 0)
+  uiPointerHashSeq++; // even again
+
+  WBInterlockedExchange(&uiPointerHashSpinlock, 0);
+}
+
+WB_UINT32 WBCreatePointerHash(void *pPointer)
+{
+int iIndex;
+POINTER_HASH *pEntry, xNew;
+WB_UINT32 uiRval = 0;
+WB_UINT32 dw1, dwTick = (WB_UINT32)(WBGetTimeIndex() >> 10); // fast 'millis', micros / 1024
+
+
+  if(!pPointer)
+  {
+    return 0; // not valid, just return zero
+  }
+
+  __PointerHashWriteLock();
+
+  __PointerHashSweep(dwTick, WB_POINTER_HASH_SWEEP_COUNT); // auto cleanup part
+
+  if(__PointerHashReserve(dwTick))
+  {
+    goto return_point;
+  }
+
+  // first, check for a match.  NOTE:  if this entry is too old, I won't re-use it - otherwise I reset the tick
+
+  iIndex = __PointerIndexFind(pPointer);
+
+  if(iIndex >= 0)
+  {
+    iIndex = __PointerHashFind(pPointerHashTable, pPointerHashIndex[iIndex].uiHash);
+
+    if(iIndex >= 0)
     {
-      if(!iRunning)
-      {
-        if(i1 == 0)
-        {
-          break; // end of file, process ended, bail out now
-        }
-//        else // this could be caused by the process forking, and the program failing to run
-//        {
-//          // TODO:  allow a few retries, then bail??
-//
-//          break; // for now, bail out on this as well.  should still get "all of it" in the output
-//        }
-      }
+      pEntry = pPointerHashTable->aSlot + iIndex;
 
-      if(errno == EAGAIN)
-      {
-        WBDelay(500); // wait 1/2 msec
-      }
-      else
+      if((dwTick - pEntry->dwTick) <= WB_SECURE_HASH_TIMEOUT)
       {
-        break; // an error of some kind, so bail out [pipe closed?]
+        pEntry->dwTick = dwTick; // new timestamp
+        pEntry->dwRefCount++; // increase ref count
+
+        uiRval = pEntry->uiHash;
+        goto return_point;
       }
+
+      __PointerHashRetire(pEntry, dwTick); // too old - retire it and make a new one
     }
-    else
+  }
+
+
+  // at this point, did NOT find a match, so I need to create it
+
+  // calculate a hash and see if there's a 'crash' between two identical hashes (including
+  // recently retired hashes).  it's not likely, but it IS possible.  So test for it.
+
+  dw1 = dwTick;
+
+  while(1) /* we assume it will bust out eventually */
+  {
+    uiRval = ((WB_UINT32)((WB_UINT64)pPointer) ^ (dw1 * 31)) & 0xffffffff;
+    // NOTE:  this should, in theory, work within a very short time, giving good randomness
+
+    if(uiRval && // can't allow a zero (this should be RARE, if ever at all)
+       __PointerHashFind(pPointerHashTable, uiRval) < 0)
     {
-      p1 += i1; // point past the # of bytes I just read in
-      *p1 = 0; // by convention [to make sure the string is ALWAYS terminated with a 0-byte]
+      break;
     }
 
-    if(iRunning) // only if "still running"
-    {
-      // for waitpid(), if WNOHANG is specified and there are no stopped, continued or exited children, 0 is returned
+    dw1 -= 113; // decrement it by a prime number so I can test for it
+                // being there again, but with a different hash value
+  }
 
-      if(waitpid(idRval, &iStat, WNOHANG) && // note this might return non-zero for stopped or continued processes
-         WIFEXITED(iStat))                   // so test if process exits also.
+  xNew.uiHash = uiRval;
+  xNew.dwTick = dwTick;
+  xNew.dwRefCount = 1;
+  xNew.pValue = pPointer;
+
+  __PointerHashPlace(pPointerHashTable, &xNew);
+  pPointerHashTable->nUsed++;
+
+  __PointerIndexInsert(pPointer, uiRval);
+
+//  WB_ERROR_PRINT("TEMOPRARY:  %s - adding hash %u for %p\n", __FUNCTION__, uiRval, pPointer);
+
+
+return_point:
+
+  __PointerHashWriteUnlock();
+
+//  if(!uiRval)
+//  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s - did NOT create hash for pointer %p\n", __FUNCTION__, pPointer);
+//  }
+
+  return uiRval;
+}
+
+void WBDestroyPointerHash(WB_UINT32 uiHash)
+{
+int iIndex;
+POINTER_HASH *pEntry;
+WB_UINT32 dwTick = (WB_UINT32)(WBGetTimeIndex() >> 10); // fast 'millis', micros / 1024
+
+
+  if(!uiHash)
+  {
+    return; // not valid, just return
+  }
+
+  __PointerHashWriteLock();
+
+  __PointerHashSweep(dwTick, WB_POINTER_HASH_SWEEP_COUNT); // check for aging while I'm at it
+
+  iIndex = __PointerHashFind(pPointerHashTable, uiHash);
+
+  if(iIndex >= 0)
+  {
+    pEntry = pPointerHashTable->aSlot + iIndex;
+
+    if(pEntry->pValue)
+    {
+      if(pEntry->dwRefCount)
       {
-        iRunning = 0; // my flag that it's not running
-        WBDelay(5000); // wait for a bit to make sure the I/O completes
+        pEntry->dwRefCount --;
       }
-      else
+
+      if(!(pEntry->dwRefCount))
       {
-        WBDelay(500); // so I don't 'spin'
+        __PointerHashRetire(pEntry, dwTick);
       }
     }
   }
 
-  // always kill the process at this point (in case there was an error)
+  __PointerHashWriteUnlock();
+}
+
+void WBDestroyPointerHashPtr(void *pPointer)
+{
+int iIndex;
+WB_UINT32 dwTick = (WB_UINT32)(WBGetTimeIndex() >> 10); // fast 'millis', micros / 1024
+
+
+  if(!pPointer)
+  {
+    return; // not valid, just return
+  }
+
+  __PointerHashWriteLock();
+
+  __PointerHashSweep(dwTick, WB_POINTER_HASH_SWEEP_COUNT); // check for aging while I'm at it
+
+  iIndex = __PointerIndexFind(pPointer);
+
+  if(iIndex >= 0)
+  {
+    iIndex = __PointerHashFind(pPointerHashTable, pPointerHashIndex[iIndex].uiHash);
+
+    if(iIndex >= 0)
+    {
+      __PointerHashRetire(pPointerHashTable->aSlot + iIndex, dwTick); // regardless of ref count, remove it (buh-bye)
+    }
+  }
+
+  __PointerHashWriteUnlock();
+}
+
+void * WBGetPointerFromHash(WB_UINT32 uiHash)
+{
+int iIndex;
+WB_UINT32 uiSeq;
+POINTER_HASH_TABLE *pTable;
+void *pRval;
+
+
+  if(!uiHash)
+  {
+    return NULL; // not valid, just return NULL
+  }
+
+  // no lock - if a writer was busy while I was looking, look again
+
+  while(1)
+  {
+    uiSeq = uiPointerHashSeq;
+
+    WB_MEMORY_BARRIER();
+
+    if(WB_LIKELY(!(uiSeq & 1)))
+    {
+      pTable = pPointerHashTable;
+      iIndex = __PointerHashFind(pTable, uiHash);
+
+      pRval = iIndex >= 0 ? pTable->aSlot[iIndex].pValue : NULL; // NULL for a retired hash
+
+      WB_MEMORY_BARRIER();
+
+      if(WB_LIKELY(uiSeq == uiPointerHashSeq))
+      {
+        break;
+      }
+    }
+  }
+
+//  if(!pRval)
+//  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s - did NOT find pointer for hash %u (%08xH)\n", __FUNCTION__, uiHash, uiHash);
+//  }
+
+  return pRval; // NULL if not found
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//                        _    _                                            //
+//                       / \  | |_  ___   _ __ ___   ___                    //
+//                      / _ \ | __|/ _ \ | '_ ` _ \ / __|                   //
+//                     / ___ \| |_| (_) || | | | | |\__ \                   //
+//                    /_/   \_\\__|\___/ |_| |_| |_||___/                   //
+//                                                                          //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+//---------------------------------
+// INTERNAL ATOM 'HELPER' UTILITIES
+//---------------------------------
+
+// the X11 server maintains a global list of atoms based on unique strings.  These are
+// useful for inter-application communication, but can rapidly become inefficient when applications
+// create large numbers of unique atoms names for their own custom purposes (like the X11 workbench).
+// To combat this obvious problem, these next two functions will create application-unique atoms
+// when a global atom is not available.  Global atoms are NEVER removed.  Once there, they are there
+// until the X11 server is shut down.  For that reason, these functions are really necessary.  It should
+// help minimize the resource impact of an X11 workbench toolkit application.
+
+// For more information, see xorg-server source
+//   specifically:  Atom MakeAtom(const char *string, unsigned len, Bool makeit)
+//   this function is located in dix/atom.c .  It allocates atoms SEQUENTIALLY, beginning with XA_LAST_PREDEFINED+1
+//   because the atoms are assigned SEQUENTIALLY, it is possible to pick a "very very big number" as the minimum
+//   internal atom's starting point, i.e. WB_INTERNAL_ATOM_MIN_VAL (which is currently FF000000H) which would allow
+//   for ~16 million internally-defined atoms.
+
+// All of the atom names, for both internal atoms and (cached) X11 atoms, are stored in 'pszAtomNames'
+// and referenced by their offset, so that the buffer can be re-allocated.  A hash table keyed by the
+// name finds the atom for a name, internal atoms find their name by index, and an index keyed by the
+// Atom finds the name for a cached X11 atom.  X11 atoms are only cached for the default display, and
+// only when they exist (an atom can't be removed from the server, but it can be created at any time).
+
+typedef struct __atom_name_slot__
+{
+  WB_UINT32 uiHash;     // hash of the atom name
+  unsigned int nName;   // offset of the name within 'pszAtomNames'
+  Atom aAtom;           // the atom (internal or X11), 'None' for an empty slot
+} ATOM_NAME_SLOT;
+
+typedef struct __atom_index_slot__
+{
+  Atom aAtom;           // an X11 atom, 'None' for an empty slot
+  unsigned int nName;   // offset of the name within 'pszAtomNames'
+} ATOM_INDEX_SLOT;
+
+static volatile WB_UINT32 lInternalAtomSpinner = 0L;
+static unsigned int *pInternalAtomNames = NULL; // name offset for each internal atom; the atom is WB_INTERNAL_ATOM_MIN_VAL + index
+static char *pszAtomNames = NULL;
+static unsigned int cbAtomNames = 0, cbMaxAtomNames = 0;
+static unsigned int nInternalAtoms = 0, nMaxInternalAtoms = 0;
+static ATOM_NAME_SLOT *pAtomNameHash = NULL; // name to atom, internal and cached X11 atoms
+static unsigned int nAtomNameHash = 0, nMaxAtomNameHash = 0;
+static ATOM_INDEX_SLOT *pAtomIndex = NULL;   // atom to name, cached X11 atoms
+static unsigned int nAtomIndex = 0, nMaxAtomIndex = 0;
+
+#define INITIAL_INTERNAL_ATOM_SIZE 4096
+#define INITIAL_INTERNAL_ATOM_STRING_SIZE 262144
+#define INITIAL_ATOM_HASH_SIZE 1024 /* must be a power of 2 */
+#define ATOM_BATCH_SIZE 64 /* XInternAtoms() batches of this size or less use the stack for temporary arrays */
+
+static void WBFreeAtoms(void)
+{
+  if(pInternalAtomNames)
+  {
+    WBFree(pInternalAtomNames);
+    pInternalAtomNames = NULL;
+  }
+
+  if(pszAtomNames)
+  {
+    WBFree(pszAtomNames);
+    pszAtomNames = NULL;
+  }
+
+  if(pAtomNameHash)
+  {
+    WBFree(pAtomNameHash);
+    pAtomNameHash = NULL;
+  }
+
+  if(pAtomIndex)
+  {
+    WBFree(pAtomIndex);
+    pAtomIndex = NULL;
+  }
+
+  cbAtomNames = cbMaxAtomNames = 0;
+  nInternalAtoms = nMaxInternalAtoms = 0;
+  nAtomNameHash = nMaxAtomNameHash = 0;
+  nAtomIndex = nMaxAtomIndex = 0;
+
+  lInternalAtomSpinner = 0;
+}
+
+static __inline__ void __AtomLock(void)
+{
+  while(WBInterlockedExchange(&lInternalAtomSpinner, 1)) // THIS MUST BE SPIN-LOCKED
+  {
+    WBDelay(100); // by convention just do THIS
+  }
+}
+
+static __inline__ void __AtomUnlock(void)
+{
+  WBInterlockedExchange(&lInternalAtomSpinner, 0);  // I'm done with it now
+}
+
+static __inline__ WB_UINT32 __AtomNameHash(const char *szAtomName)
+{
+WB_UINT32 uiRval = 2166136261U; // FNV-1a
+
+  while(*szAtomName)
+  {
+    uiRval = (uiRval ^ (unsigned char)*(szAtomName++)) * 16777619U;
+  }
+
+  return uiRval;
+}
+
+static __inline__ unsigned int __AtomIndexHome(Atom aAtom, unsigned int nMax)
+{
+WB_UINT32 uiKey = (WB_UINT32)aAtom * 0x9e3779b1U; // Fibonacci hashing
+
+  return (unsigned int)((uiKey ^ (uiKey >> 15)) & (nMax - 1));
+}
+
+// only call when lInternalAtomSpinner owned.  returns 'None' if not found
+static Atom __FindAtomByName(const char *szAtomName, WB_UINT32 uiHash)
+{
+unsigned int uiIndex;
+
+
+  if(!nAtomNameHash)
+  {
+    return None;
+  }
+
+  for(uiIndex = uiHash & (nMaxAtomNameHash - 1); pAtomNameHash[uiIndex].aAtom != None;
+      uiIndex = (uiIndex + 1) & (nMaxAtomNameHash - 1))
+  {
+    if(pAtomNameHash[uiIndex].uiHash == uiHash &&
+       !strcmp(pszAtomNames + pAtomNameHash[uiIndex].nName, szAtomName))
+    {
+      return pAtomNameHash[uiIndex].aAtom;
+    }
+  }
+
+  return None;
+}
+
+// only call when lInternalAtomSpinner owned.  returns NULL if not found (or not cached)
+static const char *__FindAtomName(Atom aAtom)
+{
+unsigned int uiIndex;
+
+
+  if((unsigned int)aAtom >= WB_INTERNAL_ATOM_MIN_VAL)
+  {
+    uiIndex = (unsigned int)aAtom - WB_INTERNAL_ATOM_MIN_VAL;
+
+    return uiIndex < nInternalAtoms ? pszAtomNames + pInternalAtomNames[uiIndex] : NULL;
+  }
+
+  if(!nAtomIndex)
+  {
+    return NULL;
+  }
+
+  for(uiIndex = __AtomIndexHome(aAtom, nMaxAtomIndex); pAtomIndex[uiIndex].aAtom != None;
+      uiIndex = (uiIndex + 1) & (nMaxAtomIndex - 1))
+  {
+    if(pAtomIndex[uiIndex].aAtom == aAtom)
+    {
+      return pszAtomNames + pAtomIndex[uiIndex].nName;
+    }
+  }
+
+  return NULL;
+}
+
+// only call when lInternalAtomSpinner owned.  Grows an open-addressed table so that it is at most half full
+// after adding one more entry.  'iType' is 0 for the name hash, 1 for the atom index.  returns non-zero on error
+static int __AtomTableReserve(int iType)
+{
+void *pOld;
+unsigned int i1, nOldMax, nNewMax, uiIndex;
+unsigned int nCount = iType ? nAtomIndex : nAtomNameHash;
+unsigned int nMax = iType ? nMaxAtomIndex : nMaxAtomNameHash;
+size_t cbSlot = iType ? sizeof(ATOM_INDEX_SLOT) : sizeof(ATOM_NAME_SLOT);
+void *pNew;
+
+
+  if((nCount + 1) * 2 <= nMax)
+  {
+    return 0;
+  }
+
+  nOldMax = nMax;
+  nNewMax = nMax ? nMax * 2 : INITIAL_ATOM_HASH_SIZE;
+
+  pNew = WBAlloc(nNewMax * cbSlot);
+
+  if(!pNew)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+
+    return -1;
+  }
+
+  memset(pNew, 0, nNewMax * cbSlot); // 'None' is zero
+
+  if(iType)
+  {
+    ATOM_INDEX_SLOT *pOldIndex = pAtomIndex, *pNewIndex = (ATOM_INDEX_SLOT *)pNew;
+
+    for(i1=0; i1 < nOldMax; i1++)
+    {
+      if(pOldIndex[i1].aAtom != None)
+      {
+        for(uiIndex = __AtomIndexHome(pOldIndex[i1].aAtom, nNewMax); pNewIndex[uiIndex].aAtom != None;
+            uiIndex = (uiIndex + 1) & (nNewMax - 1))
+        { }
+
+        pNewIndex[uiIndex] = pOldIndex[i1];
+      }
+    }
+
+    pOld = pAtomIndex;
+    pAtomIndex = pNewIndex;
+    nMaxAtomIndex = nNewMax;
+  }
+  else
+  {
+    ATOM_NAME_SLOT *pOldHash = pAtomNameHash, *pNewHash = (ATOM_NAME_SLOT *)pNew;
+
+    for(i1=0; i1 < nOldMax; i1++)
+    {
+      if(pOldHash[i1].aAtom != None)
+      {
+        for(uiIndex = pOldHash[i1].uiHash & (nNewMax - 1); pNewHash[uiIndex].aAtom != None;
+            uiIndex = (uiIndex + 1) & (nNewMax - 1))
+        { }
+
+        pNewHash[uiIndex] = pOldHash[i1];
+      }
+    }
+
+    pOld = pAtomNameHash;
+    pAtomNameHash = pNewHash;
+    nMaxAtomNameHash = nNewMax;
+  }
+
+  if(pOld)
+  {
+    WBFree(pOld);
+  }
+
+  return 0;
+}
+
+// only call when lInternalAtomSpinner owned.  Copies the name into 'pszAtomNames' and returns its offset, or -1 on error
+static int __AddAtomName(const char *szAtomName)
+{
+void *pTemp;
+int iLen, iRval;
+
+
+  iLen = strlen(szAtomName) + 1; // include the '0' byte at the end
+
+  if(!pszAtomNames)
+  {
+    pszAtomNames = WBAlloc(INITIAL_INTERNAL_ATOM_STRING_SIZE);
+    if(!pszAtomNames)
+    {
+      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+
+      return -1;
+    }
+
+    cbMaxAtomNames = INITIAL_INTERNAL_ATOM_STRING_SIZE;
+    cbAtomNames = 0; // make sure
+  }
+  else if((cbAtomNames + iLen + 1) >= cbMaxAtomNames) // not enough room?
+  {
+    pTemp = WBReAlloc(pszAtomNames, cbMaxAtomNames + INITIAL_INTERNAL_ATOM_STRING_SIZE);
+    if(!pTemp)
+    {
+      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+
+      return -1;
+    }
+
+    pszAtomNames = (char *)pTemp;
+    cbMaxAtomNames += INITIAL_INTERNAL_ATOM_STRING_SIZE;
+  }
+
+  iRval = (int)cbAtomNames;
+
+  memcpy(pszAtomNames + cbAtomNames, szAtomName, iLen);
+
+  cbAtomNames += iLen;
+  pszAtomNames[cbAtomNames] = 0; // by convention
+
+  return iRval;
+}
+
+// only call when lInternalAtomSpinner owned, and when 'szAtomName' is known not to be in the name hash.
+// For an internal atom, 'aAtom' must be the next one (i.e. WB_INTERNAL_ATOM_MIN_VAL + nInternalAtoms).
+// returns non-zero on error
+static int __AddAtom(const char *szAtomName, WB_UINT32 uiHash, Atom aAtom)
+{
+int iName;
+unsigned int uiIndex;
+void *pTemp;
+
+
+  if(__AtomTableReserve(0))
+  {
+    return -1;
+  }
+
+  if((unsigned int)aAtom >= WB_INTERNAL_ATOM_MIN_VAL)
+  {
+    if(nInternalAtoms >= nMaxInternalAtoms)
+    {
+      pTemp = WBReAlloc(pInternalAtomNames, (nMaxInternalAtoms + INITIAL_INTERNAL_ATOM_SIZE) * sizeof(*pInternalAtomNames));
+
+      if(!pTemp)
+      {
+        WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+
+        return -1;
+      }
+
+      pInternalAtomNames = (unsigned int *)pTemp;
+      nMaxInternalAtoms += INITIAL_INTERNAL_ATOM_SIZE;
+    }
+  }
+  else if(__AtomTableReserve(1))
+  {
+    return -1;
+  }
+
+  iName = __AddAtomName(szAtomName);
+
+  if(iName < 0)
+  {
+    return -1;
+  }
+
+  if((unsigned int)aAtom >= WB_INTERNAL_ATOM_MIN_VAL)
+  {
+    pInternalAtomNames[nInternalAtoms++] = (unsigned int)iName;
+  }
+  else
+  {
+    for(uiIndex = __AtomIndexHome(aAtom, nMaxAtomIndex); pAtomIndex[uiIndex].aAtom != None;
+        uiIndex = (uiIndex + 1) & (nMaxAtomIndex - 1))
+    {
+      if(pAtomIndex[uiIndex].aAtom == aAtom) // the name of a cached atom can't change, but just in case
+      {
+        break;
+      }
+    }
+
+    if(pAtomIndex[uiIndex].aAtom == None)
+    {
+      nAtomIndex++;
+    }
+
+    pAtomIndex[uiIndex].aAtom = aAtom;
+    pAtomIndex[uiIndex].nName = (unsigned int)iName;
+  }
+
+  for(uiIndex = uiHash & (nMaxAtomNameHash - 1); pAtomNameHash[uiIndex].aAtom != None;
+      uiIndex = (uiIndex + 1) & (nMaxAtomNameHash - 1))
+  { }
+
+  pAtomNameHash[uiIndex].uiHash = uiHash;
+  pAtomNameHash[uiIndex].nName = (unsigned int)iName;
+  pAtomNameHash[uiIndex].aAtom = aAtom;
+
+  nAtomNameHash++;
+
+  return 0;
+}
+
+// cache an X11 atom for the default display (other displays aren't cached)
+static void __CacheServerAtom(WB_DISPLAY pDisplay, const char *szAtomName, Atom aAtom)
+{
+WB_UINT32 uiHash;
+
+
+  if(aAtom == None || (unsigned int)aAtom >= WB_INTERNAL_ATOM_MIN_VAL ||
+     pDisplay != WBGetDefaultDisplay())
+  {
+    return;
+  }
+
+  uiHash = __AtomNameHash(szAtomName);
+
+  __AtomLock();
+
+  if(__FindAtomByName(szAtomName, uiHash) == None) // an internal atom with the same name takes precedence
+  {
+    __AddAtom(szAtomName, uiHash, aAtom);
+  }
+
+  __AtomUnlock();
+}
+
+// look up X11 atoms, using the cache for the default display.  Whatever isn't cached is
+// requested with a single call to XInternAtoms().  Internal atoms are never returned.
+static void __InternAtoms(WB_DISPLAY pDisplay, const char * const *ppszNames, int nCount,
+                          int bOnlyIfExists, Atom *paRval)
+{
+char *apszTemp[ATOM_BATCH_SIZE], **ppszMiss;
+Atom aTemp[ATOM_BATCH_SIZE], *paMiss;
+int aiTemp[ATOM_BATCH_SIZE], *piMiss;
+int i1, nMiss, bCache;
+Atom aAtom;
+
+
+  bCache = pDisplay == WBGetDefaultDisplay();
+
+  if(nCount <= ATOM_BATCH_SIZE)
+  {
+    ppszMiss = apszTemp;
+    paMiss = aTemp;
+    piMiss = aiTemp;
+  }
+  else
+  {
+    ppszMiss = (char **)WBAlloc(nCount * (sizeof(*ppszMiss) + sizeof(*paMiss) + sizeof(*piMiss)));
+
+    if(!ppszMiss)
+    {
+      WB_ERROR_PRINT("ERROR:  %s - no memory\n", __FUNCTION__);
+
+      for(i1=0; i1 < nCount; i1++)
+      {
+        paRval[i1] = XInternAtom(pDisplay, ppszNames[i1], bOnlyIfExists ? True : False);
+      }
+
+      return;
+    }
+
+    paMiss = (Atom *)(ppszMiss + nCount);
+    piMiss = (int *)(paMiss + nCount);
+  }
+
+  nMiss = 0;
+
+  if(bCache)
+  {
+    __AtomLock();
+  }
+
+  for(i1=0; i1 < nCount; i1++)
+  {
+    aAtom = bCache ? __FindAtomByName(ppszNames[i1], __AtomNameHash(ppszNames[i1])) : None;
+
+    if(aAtom != None && (unsigned int)aAtom < WB_INTERNAL_ATOM_MIN_VAL)
+    {
+      paRval[i1] = aAtom;
+    }
+    else
+    {
+      paRval[i1] = None;
+
+      ppszMiss[nMiss] = (char *)ppszNames[i1];
+      piMiss[nMiss++] = i1;
+    }
+  }
+
+  if(bCache)
+  {
+    __AtomUnlock();
+  }
+
+  if(nMiss > 0)
+  {
+    // one round trip for all of them.  the return value only says whether they ALL exist, so ignore it
+
+    XInternAtoms(pDisplay, ppszMiss, nMiss, bOnlyIfExists ? True : False, paMiss);
+
+    for(i1=0; i1 < nMiss; i1++)
+    {
+      paRval[piMiss[i1]] = paMiss[i1];
+
+      if(bCache && paMiss[i1] != None)
+      {
+        __CacheServerAtom(pDisplay, ppszMiss[i1], paMiss[i1]);
+      }
+    }
+  }
+
+  if(ppszMiss != apszTemp)
+  {
+    WBFree(ppszMiss);
+  }
+}
+
+// allocate an internal atom for a name that is not an X11 atom.  returns 'None' on error
+static Atom __AllocInternalAtom(const char *szAtomName)
+{
+Atom aRval;
+WB_UINT32 uiHash = __AtomNameHash(szAtomName);
+
+
+  __AtomLock();
+
+  aRval = __FindAtomByName(szAtomName, uiHash); // in case another thread just added it
+
+  if(aRval == None)
+  {
+    aRval = (Atom)(nInternalAtoms + WB_INTERNAL_ATOM_MIN_VAL);
+
+    if(__AddAtom(szAtomName, uiHash, aRval))
+    {
+      aRval = None;
+    }
+  }
+
+  __AtomUnlock();
+
+  if(aRval == None)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - could not allocate new atom for %s\n", __FUNCTION__, szAtomName);
+  }
+//  else
+//  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s - allocating new atom %u for %s\n", __FUNCTION__, (unsigned int)aRval, szAtomName);
+//  }
+
+  return aRval;
+}
+
+int WBInternAtoms(WB_DISPLAY pDisplay, const char * const *ppszNames, int nCount, int bOnlyIfExists, Atom *paRval)
+{
+int i1, iRval;
+
+
+  if(!ppszNames || !paRval || nCount <= 0)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - bad parameters\n", __FUNCTION__);
+
+    return -1;
+  }
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+
+    if(!pDisplay)
+    {
+      WB_ERROR_PRINT("ERROR - %s - no display!\n", __FUNCTION__);
+
+      return -1;
+    }
+  }
+
+  __InternAtoms(pDisplay, ppszNames, nCount, bOnlyIfExists, paRval);
+
+  for(i1=0, iRval=0; i1 < nCount; i1++)
+  {
+    if(paRval[i1] == None)
+    {
+      iRval++;
+    }
+  }
+
+  return iRval;
+}
+
+Atom WBInternAtom(WB_DISPLAY pDisplay, const char *szAtomName, int bOnlyIfExists)
+{
+Atom aRval = None;
+
+
+  if(!szAtomName || !*szAtomName)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - bad 'szAtomName'\n", __FUNCTION__);
+
+    return None;  // bad parameter
+  }
+
+  WBInternAtoms(pDisplay, &szAtomName, 1, bOnlyIfExists, &aRval);
+
+  return aRval;
+}
+
+int WBGetAtoms(WB_DISPLAY pDisplay, const char * const *ppszNames, int nCount, Atom *paRval)
+{
+int i1, iRval;
+
+
+  if(!ppszNames || !paRval || nCount <= 0)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - bad parameters\n", __FUNCTION__);
+
+    return -1;
+  }
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+
+    if(!pDisplay)
+    {
+      WB_ERROR_PRINT("ERROR - %s - no display!\n", __FUNCTION__);
+
+      return -1;
+    }
+  }
+
+  // internal atoms FIRST, since they take precedence
+
+  __AtomLock();
+
+  for(i1=0; i1 < nCount; i1++)
+  {
+    paRval[i1] = __FindAtomByName(ppszNames[i1], __AtomNameHash(ppszNames[i1]));
+  }
+
+  __AtomUnlock();
+
+  // the rest are looked up as X11 atoms with a single request (see WBLookupAtom)
+
+  for(i1=0; i1 < nCount && paRval[i1] != None; i1++)
+  { }
+
+  if(i1 < nCount)
+  {
+    Atom aTemp[ATOM_BATCH_SIZE], *paTemp = aTemp;
+
+    if(nCount > ATOM_BATCH_SIZE)
+    {
+      paTemp = (Atom *)WBAlloc(nCount * sizeof(*paTemp));
+    }
+
+    if(paTemp)
+    {
+      __InternAtoms(pDisplay, ppszNames, nCount, 1, paTemp);
+
+      for(i1=0; i1 < nCount; i1++)
+      {
+        if(paRval[i1] == None)
+        {
+          paRval[i1] = paTemp[i1];
+        }
+      }
+
+      if(paTemp != aTemp)
+      {
+        WBFree(paTemp);
+      }
+    }
+  }
+
+  // and anything that's left gets an internal atom (see WBGetAtom)
+
+  for(i1=0, iRval=0; i1 < nCount; i1++)
+  {
+    if(paRval[i1] == None)
+    {
+      paRval[i1] = __AllocInternalAtom(ppszNames[i1]);
+
+      if(paRval[i1] == None)
+      {
+        iRval++;
+      }
+    }
+  }
+
+  return iRval;
+}
+
+Atom WBGetAtom(WB_DISPLAY pDisplay, const char *szAtomName)
+{
+Atom aRval;
+
+
+  if(!szAtomName || !*szAtomName)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - bad 'szAtomName'\n", __FUNCTION__);
+
+    return None;  // bad parameter
+  }
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+
+    if(!pDisplay)
+    {
+      WB_ERROR_PRINT("ERROR - %s - no display!\n", __FUNCTION__);
+
+      return None;
+    }
+  }
+
+  aRval = WBLookupAtom(pDisplay, szAtomName);
+
+  if(aRval != None)
+  {
+    return aRval;
+  }
+
+  // allocate an internal atom
+
+  return __AllocInternalAtom(szAtomName);
+}
+
+Atom WBLookupAtom(WB_DISPLAY pDisplay, const char *szAtomName)
+{
+Atom aRval;
+
+
+  if(!szAtomName || !*szAtomName)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - bad 'szAtomName'\n", __FUNCTION__);
+
+    return None;  // bad parameter
+  }
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+  }
+
+
+  // look up internal (and cached X11) atoms FIRST...
+
+  __AtomLock();
+
+  aRval = __FindAtomByName(szAtomName, __AtomNameHash(szAtomName));
+
+  __AtomUnlock();
+
+  if(aRval != None)
+  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s - found atom %u for %s\n", __FUNCTION__, (unsigned int)aRval, szAtomName);
+
+    return aRval;
+  }
+
+  aRval = XInternAtom(pDisplay, szAtomName, True);
+
+  __CacheServerAtom(pDisplay, szAtomName, aRval); // only if it exists
+
+  return aRval; // regardless
+}
+
+char *WBGetAtomName(WB_DISPLAY pDisplay, Atom aAtom)
+{
+char *pRval, *pTemp;
+const char *pName;
+
+
+  if(aAtom == None)
+  {
+    // NOTE:  this can happen under normal circumstances, so don't make it an error
+    //        (especially true for dialog controls without IDs assigned, like static text)
+
+    WB_WARN_PRINT("ERROR:  %s - passed 'None' for aAtom\n", __FUNCTION__);
+
+    return NULL;
+  }
+  else if((unsigned int)aAtom >= (unsigned int)(WB_INTERNAL_ATOM_MIN_VAL + nInternalAtoms))
+  {
+    WB_ERROR_PRINT("ERROR:  %s - bad (internal) Atom:  %u (%08xH)\n", __FUNCTION__, (unsigned int)aAtom, (unsigned int)aAtom);
+
+    return NULL;  // bad parameter
+  }
+
+  if(!pDisplay)
+  {
+    pDisplay = WBGetDefaultDisplay();
+
+    if(!pDisplay)
+    {
+      WB_ERROR_PRINT("ERROR - %s - no display!\n", __FUNCTION__);
+      return NULL;
+    }
+  }
+
+  pRval = NULL;
+
+  // internal atoms, and X11 atoms that were cached for the default display
+
+  if((unsigned int)aAtom >= WB_INTERNAL_ATOM_MIN_VAL || pDisplay == WBGetDefaultDisplay())
+  {
+    __AtomLock();
+
+    pName = __FindAtomName(aAtom);
+
+    if(pName)
+    {
+      pRval = WBCopyString(pName);
+    }
+
+    __AtomUnlock();
+
+    if(pRval || (unsigned int)aAtom >= WB_INTERNAL_ATOM_MIN_VAL)
+    {
+      if(!pRval)
+      {
+        WB_DEBUG_PRINT(DebugLevel_Light,
+                       "INFO:  %s - atom index %u (%u) not found, %u atoms stored\n", __FUNCTION__,
+                       (unsigned int)aAtom, (unsigned int)(aAtom - WB_INTERNAL_ATOM_MIN_VAL),
+                       nInternalAtoms);
+      }
+//      else
+//      {
+//        WB_ERROR_PRINT("TEMPORARY:  %s - found %s for Atom %u\n", __FUNCTION__, pRval, (unsigned int)aAtom);
+//      }
+
+      return pRval;
+    }
+  }
+
+  WBSupressErrorOutput();
+
+  pTemp = XGetAtomName(pDisplay, aAtom);
+
+  WBAllowErrorOutput();
+
+  if(pTemp)
+  {
+    pRval = WBCopyString(pTemp);
+
+    __CacheServerAtom(pDisplay, pTemp, aAtom);
+
+    XFree(pTemp);
+
+    return pRval;
+  }
+
+  WB_DEBUG_PRINT(DebugLevel_Light,
+                 "INFO:  %s - unknown Atom:  %u (%08xH)\n",
+                 __FUNCTION__, (unsigned int)aAtom, (unsigned int)aAtom);
+
+  return NULL;
+}
+
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+//                                                                          //
+//                                           _                              //
+//                   __ _  ___   ___   _ __ | |_       _ __                 //
+//                  / _` |/ __| / _ \ | '__|| __|     | '__|                //
+//                 | (_| |\__ \| (_) || |   | |_      | |                   //
+//                  \__, ||___/ \___/ |_|    \__|_____|_|                   //
+//                     |_|                      |_____|                     //
+//                                                                          //
+//////////////////////////////////////////////////////////////////////////////
+
+// ========================================================
+// Dealing with a lack of or improperly supported qsort_r()
+// ========================================================
+
+#if (!defined(QSORT_R_BSD) && !defined(QSORT_R_GNUC)) || defined(__DOXYGEN__)
+
+struct my_qsort_data
+{
+  void *pData;  // pointer to elements
+  int cbData;   // size of elements
+  void *pThunk; // data to pass to each 'compare' call
+  int (*compare)(void *, const void *, const void *); // compare function
+  void *pSW, *pBR;
+};
+
+static void MyQuickSort2(struct my_qsort_data *pData, int iLow, int iHigh);
+
+// define exactly like BSD version, but with base types
+// TODO:  multi-thread version?  would need to determine optimum threshold for threading
+
+void my_qsort_r(void *base, int nmemb, int size, void *thunk,
+                int (*compar)(void *, const void *, const void *))
+{
+struct my_qsort_data sData;
+unsigned char buf[32], buf2[32];
+
+
+  if(nmemb <= 1)
+  {
+    return;  // no need to sort 1 item
+  }
+
+  sData.pData = base;
+  sData.cbData = size;
+  sData.pThunk = thunk;
+  sData.compare = compar;
+
+  if(sData.cbData <= sizeof(buf))
+  {
+    sData.pBR = buf;
+    sData.pSW = buf2;
+  }
+  else
+  {
+    sData.pBR = WBAlloc(sData.cbData * 2);
+    sData.pSW = (unsigned char *)sData.pBR + sData.cbData;
+  }
+
+  MyQuickSort2(&sData, 0, nmemb - 1);
+
+  if(sData.cbData > sizeof(buf))
+  {
+    WBFree(sData.pBR);
+  }
+}
+
+static __inline__ void *ElementFromIndex(struct my_qsort_data *pData, int iElement)
+{
+  return ((unsigned char *)pData->pData) + pData->cbData * iElement;
+}
+
+static int DoCompareI(struct my_qsort_data *pData, int iLeft, int iRight)
+{
+  void *p1 = ElementFromIndex(pData, iLeft);
+  void *p2 = ElementFromIndex(pData, iRight);
+
+  return pData->compare(pData->pThunk, p1, p2);
+}
+
+static int DoCompareP(struct my_qsort_data *pData, int iLeft, void *pRight)
+{
+  void *p1 = ElementFromIndex(pData, iLeft);
+
+  return pData->compare(pData->pThunk, p1, pRight);
+}
+
+static void DoSwapData(struct my_qsort_data *pData, int iLeft, int iRight)
+{
+  void *p1 = ElementFromIndex(pData, iLeft);
+  void *p2 = ElementFromIndex(pData, iRight);
+
+  // TODO:  make this faster?
+  memcpy(pData->pSW, p1, pData->cbData);
+  memcpy(p1, p2, pData->cbData);
+  memcpy(p2, pData->pSW, pData->cbData);
+}
+
+void MyQuickSort2(struct my_qsort_data *pData, int iLow, int iHigh )
+{
+int iUp, iDown, iBreak;
+void *pBreak;
+unsigned char buf[32], buf2[32]; // if smaller than 32 bytes, use THIS for temp object storage
+
+
+  if( iLow < iHigh )                 // do not sort 1 element block
+  {
+    iBreak = (iLow + iHigh) / 2;
+    pBreak = ElementFromIndex(pData, iBreak); // initial pivot point
+
+    if( (iHigh - iLow) > 5 )       // 5 or more elements?
+    {
+      // do a 'median of 3' optimization when practical
+      // this ensures a better pivot point, limiting the
+      // effect of an already sorted or nearly sorted
+      // array on performance.  Pivot points should be
+      // as close to the median value as practical for
+      // the current range of data points.  Otherwise,
+      // a series of bad pivot points could degenerate
+      // the 'quicksort' into a 'slowsort', and possibly
+      // cause stack overflows on large data sets.
+
+      if(DoCompareI(pData, iLow, iHigh) <= 0)
+      {
+        if(DoCompareP(pData, iLow, pBreak) < 0)
+        {
+          if(DoCompareP(pData, iHigh, pBreak) < 0)
+          {
+             pBreak = ElementFromIndex(pData, iHigh);
+          }
+        }
+        else
+        {
+          pBreak = ElementFromIndex(pData, iLow);
+        }
+      }
+      else
+      {
+        if(DoCompareP(pData, iHigh, pBreak) < 0)
+        {
+          if(DoCompareP(pData, iLow, pBreak) < 0)
+          {
+             pBreak = ElementFromIndex(pData, iLow);
+          }
+        }
+        else
+        {
+          pBreak = ElementFromIndex(pData, iHigh);
+        }
+      }
+    }
+
+    memcpy(pData->pBR, pBreak, pData->cbData); // make copy of it before swapping anything
+    pBreak = pData->pBR; // and now point to the buffer (faster this way)
+
+    iUp = iLow;                  // initialize indices
+    iDown = iHigh;
+
+    do
+    {
+      // Move in from both sides towards the pivot point.
+
+      // note:  it may be possible to thread THESE two loops
+      //        though it's likely not to help a whole lot
+
+      while( iUp < iHigh)
+      {
+        if(DoCompareP(pData, iUp, pBreak) < 0)
+        {
+          iUp++;
+        }
+        else
+        {
+          break;
+        }
+      }
+
+      while(iDown > iLow)
+      {
+        if(DoCompareP(pData, iDown, pBreak) > 0)
+        {
+          iDown--;
+        }
+        else
+        {
+          break;
+        }
+      }
+
+
+      // if low/high boundaries have not crossed, swap current
+      // 'boundary' values so that the 'iUp' pointer points
+      // to a value less than or equal to the pivot point,
+      // and the 'iDown' value points to a value greater than
+      // or equal to the pivot point, and continue.
+
+      if( iUp <= iDown )
+      {
+        if(iUp != iDown)
+        {
+          DoSwapData(pData, iUp, iDown);
+        }
+
+        iUp++;
+        iDown--;
+      }
+
+    } while ( iUp <= iDown );
+
+    // the recursive part... [NOTE if I ever want to thread this, I can make work units here]
+
+    if(iLow < iDown )  // everything to the left of the pivot point
+    {
+      MyQuickSort2(pData, iLow, iDown );
+    }
+    if(iUp < iHigh)    // everything to the right of the pivot point
+    {
+      MyQuickSort2(pData, iUp, iHigh );
+    }
+  }
+}
+
+#endif // !defined(QSORT_R_BSD) && !defined(QSORT_R_GNUC)
+
+
+#if !defined(HAVE_XPM) || defined(__DOXYGEN__)
+
+//////////////////////////////////////////////////////
+// SUBSTITUTE CODE FOR MISSING (or unwanted) libXpm //
+//////////////////////////////////////////////////////
+
+// parse an XPM, and generate data that I can THEN create a bitmap from
+//
+// The XPM will have 4 numbers at the start (in ASCII): WIDTH HEIGHT nColors chars_per_color
+// 'nColors' is the size of the color table (one line each)
+// 'chars_per_color' is the # of characters that represent a color
+// following this is the bitmap data itself.
+// To create a transparency mask look for a color called "None" which is the background color
+// for the transparency mask.  The mask will be a monochrome bitmap with '0' for transparency,
+// and '1' for everything else.
+//
+// mono bitmap format will be 1 bit per pixel, 16-bit MSB
+//
+// This function is generally PREFERABLE to the libXpm version as it's a LOT faster
+// Additionally, it can be made 'MS Windows Compatible' so that XPM resources can be
+// used within WIN32 applications.  Should support MSVC, gcc, and llvm compilers
+//
+// checking for MSVC:  use '#ifdef _MSC_VER' or similar
+
+#define MAX_XPM_COLOR_CHAR_SIZE 4
+#define MY_XPM_DIRECT_INDEX_CHARS 2 /* 1 and 2 character color keys use a direct-indexed lookup table */
+
+typedef struct _MY_XPM_COLOR_
+{
+  WB_UINT32 uiKey;   // up to MAX_XPM_COLOR_CHAR_SIZE chars that represent a color, packed MSB first (see MyXPMPackKey)
+  WB_UINT32 uiPixel; // pre-computed pixel value in 'B, G, R, 0' byte order, stored as-is into the image data
+  int bNone;         // non-zero if this is the 'None' (transparent) color
+} MY_XPM_COLOR;
+
+typedef struct _MY_XPM_HASH_ENTRY_
+{
+  WB_UINT32 uiKey;   // packed color key
+  WB_UINT32 uiIndex; // index into the color array PLUS ONE (zero marks an empty slot)
+} MY_XPM_HASH_ENTRY;
+
+typedef struct _MY_XPM_LOOKUP_
+{
+  int nCharsPerColor;
+  WB_UINT32 *pDirect;      // 1 or 2 chars:  direct-indexed by packed key, value is color index PLUS ONE (zero if unused)
+  MY_XPM_HASH_ENTRY *pHash; // 3 or 4 chars:  open-addressed hash table with linear probing
+  WB_UINT32 uiHashMask;    // size of 'pHash' minus 1 (size is always a power of 2)
+} MY_XPM_LOOKUP;
+
+
+static __inline__ WB_UINT32 MyXPMPackKey(const char *pX, int nCharsPerColor)
+{
+WB_UINT32 uiRval = 0;
+
+  while(nCharsPerColor-- > 0)
+  {
+    uiRval = (uiRval << 8) | (unsigned char)*(pX++);
+  }
+
+  return uiRval;
+}
+
+static __inline__ WB_UINT32 MyXPMHashKey(WB_UINT32 uiKey, WB_UINT32 uiMask)
+{
+  // multiplicative (Fibonacci) hashing, folding the high bits down so the mask sees them
+
+  uiKey *= 0x9e3779b1U;
+
+  return (uiKey ^ (uiKey >> 15)) & uiMask;
+}
+
+static int MyXPMLookupInit(MY_XPM_LOOKUP *pL, int nCharsPerColor, int nColors)
+{
+  bzero(pL, sizeof(*pL));
+
+  pL->nCharsPerColor = nCharsPerColor;
+
+  if(nCharsPerColor <= MY_XPM_DIRECT_INDEX_CHARS)
+  {
+    int cbDirect = sizeof(WB_UINT32) << (8 * nCharsPerColor); // 256 or 65536 entries
+
+    pL->pDirect = (WB_UINT32 *)WBAlloc(cbDirect);
+
+    if(!pL->pDirect)
+    {
+      return -1;
+    }
+
+    bzero(pL->pDirect, cbDirect);
+  }
+  else
+  {
+    WB_UINT32 uiSize = 16;
+
+    while(uiSize < (WB_UINT32)nColors * 2) // keep the load factor at or below 50%
+    {
+      uiSize <<= 1;
+    }
+
+    pL->pHash = (MY_XPM_HASH_ENTRY *)WBAlloc(uiSize * sizeof(MY_XPM_HASH_ENTRY));
+
+    if(!pL->pHash)
+    {
+      return -1;
+    }
+
+    bzero(pL->pHash, uiSize * sizeof(MY_XPM_HASH_ENTRY));
+    pL->uiHashMask = uiSize - 1;
+  }
+
+  return 0;
+}
+
+static void MyXPMLookupFree(MY_XPM_LOOKUP *pL)
+{
+  if(pL->pDirect)
+  {
+    WBFree(pL->pDirect);
+    pL->pDirect = NULL;
+  }
+
+  if(pL->pHash)
+  {
+    WBFree(pL->pHash);
+    pL->pHash = NULL;
+  }
+}
+
+static void MyXPMLookupAdd(MY_XPM_LOOKUP *pL, WB_UINT32 uiKey, int iIndex)
+{
+WB_UINT32 uiSlot;
+
+  // NOTE:  when a key is duplicated, the FIRST one wins
+
+  if(pL->pDirect)
+  {
+    if(!pL->pDirect[uiKey])
+    {
+      pL->pDirect[uiKey] = (WB_UINT32)iIndex + 1;
+    }
+
+    return;
+  }
+
+  uiSlot = MyXPMHashKey(uiKey, pL->uiHashMask);
+
+  while(pL->pHash[uiSlot].uiIndex) // the table is never more than half full, so this always terminates
+  {
+    if(pL->pHash[uiSlot].uiKey == uiKey)
+    {
+      return;
+    }
+
+    uiSlot = (uiSlot + 1) & pL->uiHashMask;
+  }
+
+  pL->pHash[uiSlot].uiKey = uiKey;
+  pL->pHash[uiSlot].uiIndex = (WB_UINT32)iIndex + 1;
+}
+
+static __inline__ int MyXPMLookupFind(const MY_XPM_LOOKUP *pL, WB_UINT32 uiKey) // returns index, or -1 if not found
+{
+WB_UINT32 uiSlot;
+
+  if(WB_LIKELY(pL->pDirect != NULL))
+  {
+    return (int)pL->pDirect[uiKey] - 1;
+  }
+
+  uiSlot = MyXPMHashKey(uiKey, pL->uiHashMask);
+
+  while(pL->pHash[uiSlot].uiIndex)
+  {
+    if(pL->pHash[uiSlot].uiKey == uiKey)
+    {
+      return (int)pL->pHash[uiSlot].uiIndex - 1;
+    }
+
+    uiSlot = (uiSlot + 1) & pL->uiHashMask;
+  }
+
+  return -1;
+}
+
+static __inline__ int MyXPMHexDigit(char c)
+{
+  if(c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  else if(c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  else if(c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+
+  return -1;
+}
+
+static char * MyXPMToData(const char *pXPM[], int *piW, int *piH, char **ppTransparency)
+{
+MY_XPM_COLOR *pClr, *pC;
+MY_XPM_LOOKUP xLookup;
+int i1, i2, i3, iW, iH, cbRow, bHasNone;
+int nColors, nCharsPerColor;
+const char *pX, *pY, *pZ;
+const char **ppX;
+Colormap colormap;
+WB_UINT32 *pRval, *pR;
+unsigned char *pT, *pRow;
+char tbuf[256];
+
+
+  // ------------------
+  // parse the XPM file
+  // ------------------
+
+  if(pXPM)
+  {
+    ppX = pXPM; // first line is always 4 numbers
+  }
+  else
+  {
+    ppX = NULL;
+  }
+
+  if(ppX)
+  {
+    pX = *(ppX++);
+  }
+  else
+  {
+    pX = NULL;
+  }
+
+  if(!pX)
+  {
+    WB_ERROR_PRINT("%s - unexpected parameter, pXPM=%p, ppX=%p, pX=%p\n", __FUNCTION__, pXPM, ppX, pX);
+    return NULL;
+  }
+
+  // use a macro to grab 4 integers from text
+
+#define NEXT_INT(iW,pX,pY,pZ){int iLen; NEXT_WORD(pX,pY,pZ); \
+                              iLen=pZ - pY > sizeof(tbuf) - 1 ? sizeof(tbuf) - 1 : pZ - pY; \
+                              if(iLen>0){memcpy(tbuf,pY,iLen);} tbuf[iLen]=0; iW=atoi(tbuf);}
+  NEXT_INT(iW,pX,pY,pZ);
+  NEXT_INT(iH,pX,pY,pZ);
+  NEXT_INT(nColors,pX,pY,pZ);
+  NEXT_INT(nCharsPerColor,pX,pY,pZ);
+
+#undef NEXT_INT
+
+  if(*pX || iW <= 0 || iH <= 0 || nColors <= 0 || nCharsPerColor <= 0 || nCharsPerColor > MAX_XPM_COLOR_CHAR_SIZE)
+  {
+    WB_ERROR_PRINT("%s fail, iW=%d iH=%d nColors=%d nCharsPerColor=%d\n",
+                   __FUNCTION__, iW, iH, nColors, nCharsPerColor);
+    return NULL;
+  }
+
+  pClr = WBAlloc(nColors * sizeof(MY_XPM_COLOR));
+
+  if(!pClr)
+  {
+    WB_ERROR_PRINT("%s fail, not enough memory for color table, nColors=%d\n", __FUNCTION__, nColors);
+    return NULL;
+  }
+
+  if(MyXPMLookupInit(&xLookup, nCharsPerColor, nColors))
+  {
+    WBFree(pClr);
+    WB_ERROR_PRINT("%s fail, not enough memory for color lookup, nColors=%d\n", __FUNCTION__, nColors);
+    return NULL;
+  }
+
+  pRval = NULL;
+  pT = NULL;
+  bHasNone = 0;
+
+  // ------------------------------------------------------------------------------
+  // parse the colors - 1-4 chacters, then white space, then the color as '#nnnnnn'
+  // ------------------------------------------------------------------------------
+
+  for(i1=0; i1 < nColors; i1++)
+  {
+    pY = pX = *(ppX++);
+
+    if(!pX)
+    {
+      WB_ERROR_PRINT("%s NULL pX unexpected, i1=%d\n", __FUNCTION__, i1);
+      goto error_exit;
+    }
+
+    for(i2=0; i2 < nCharsPerColor; i2++)
+    {
+      if(!pX[i2])
+      {
+        WB_ERROR_PRINT("%s fail, color key too short, pY=\"%s\"\n", __FUNCTION__, pY);
+        goto error_exit;
+      }
+    }
+
+    pC = pClr + i1;
+    pC->uiKey = MyXPMPackKey(pX, nCharsPerColor);
+    pC->uiPixel = 0;
+    pC->bNone = 0;
+
+    pX += nCharsPerColor;
+
+    while(*pX && *pX <= ' ')
+    {
+      pX++; // next char should be a 'c'
+    }
+
+    // next character is 'c' for color
+    if(*pX != 'c' || pX[1] > ' ' || (pX[2] != '#' && strncmp(pX + 2,"None",4)))
+    {
+      WB_ERROR_PRINT("%s fail 1, pX=\"%s\" pY=\"%s\" %d %c %d\n", __FUNCTION__, pX, pY, pX[1], pX[2], strncmp(pX + 2,"None",4));
+      goto error_exit;
+    }
+
+    pX += 2;
+
+    if(!strncmp(pX,"None",4))
+    {
+      pC->bNone = 1;
+      bHasNone = 1;
+
+      pX += 4;
+    }
+    else if(*pX == '#')
+    {
+      int iR, iG, iB;
+
+      // the usual '#RRGGBB' is decoded directly; anything else goes through XParseColor
+
+      for(i2=1; MyXPMHexDigit(pX[i2]) >= 0; i2++)
+      { } // i2 ends up as the length including the '#'
+
+      if(i2 == 7)
+      {
+        iR = (MyXPMHexDigit(pX[1]) << 4) | MyXPMHexDigit(pX[2]);
+        iG = (MyXPMHexDigit(pX[3]) << 4) | MyXPMHexDigit(pX[4]);
+        iB = (MyXPMHexDigit(pX[5]) << 4) | MyXPMHexDigit(pX[6]);
+      }
+      else
+      {
+        XColor clrColor;
+
+        if(i2 >= (int)sizeof(tbuf))
+        {
+          i2 = sizeof(tbuf) - 1;
+        }
+
+        memcpy(tbuf, pX, i2);
+        tbuf[i2] = 0;
+
+        colormap = WBDefaultColormap(WBGetDefaultDisplay());
+
+        bzero(&clrColor, sizeof(clrColor));
+        XParseColor(WBGetDefaultDisplay(), colormap, tbuf, &clrColor);
+
+        iR = clrColor.red >> 8;   // these are 16-bit values, so I want 8-bits out of them
+        iG = clrColor.green >> 8;
+        iB = clrColor.blue >> 8;
+      }
+
+      // pixel color order is B, then G, then R so that R == MSB and B == LSB
+      // this being 'low endian' might actually matter with the byte order.
+      // TODO:  do I verify this using the 'Visual' structure info?  Should I get
+      //        the default visual for the default Display+Screen and verify?
+
+      ((unsigned char *)&(pC->uiPixel))[0] = (unsigned char)iB;
+      ((unsigned char *)&(pC->uiPixel))[1] = (unsigned char)iG;
+      ((unsigned char *)&(pC->uiPixel))[2] = (unsigned char)iR;
+      ((unsigned char *)&(pC->uiPixel))[3] = 0;
+
+      pX += i2;
+    }
+    else
+    {
+      WB_ERROR_PRINT("%s fail 2, pX=\"%s\"\n", __FUNCTION__, pX);
+      goto error_exit;
+    }
+
+    if(*pX)
+    {
+      WB_ERROR_PRINT("%s fail 3, pX=\"%s\"\n", __FUNCTION__, pX);
+      goto error_exit;
+    }
+
+    MyXPMLookupAdd(&xLookup, pC->uiKey, i1);
+  }
+
+  // first usage of 'pRval'
+  pRval = WBAlloc(iH * iW * 4); // pixel array, always 32-bit-wide values; B is first byte, G is 2nd byte, R is 3rd byte, 4th byte is zero
+
+  if(!pRval)
+  {
+    WB_ERROR_PRINT("%s fail, not enough memory for pRval, size=%d\n", __FUNCTION__, iH * iW * 4);
+    goto error_exit;
+  }
+
+  cbRow = (iW + 7) / 8; // total number of bytes needed per row of the transparency mask [padded]
+
+  if(ppTransparency && bHasNone) // there is a 'None'
+  {
+    pT = WBAlloc(iH * cbRow + 2);
+    if(!pT)
+    {
+      WB_ERROR_PRINT("%s fail, not enough memory for pT, size=%d\n", __FUNCTION__, iH * cbRow + 2);
+      goto error_exit;
+    }
+
+    bzero(pT, iH * cbRow + 2); // make sure
+  }
+
+  // at this point 'pX' points to the actual RBG color data.  I shall now create
+  // Image binary data in XYPixmap format, 32-bits per pixel with 32-bit padding, based on the default display
+  // Each pixel is a single table lookup followed by a single 32-bit store of the pre-computed pixel value
+
+  for(i2=0, pR=pRval; i2 < iH; i2++)
+  {
+    pX = *(ppX++);
+    if(!pX)
+    {
+      WB_ERROR_PRINT("%s NULL pX unexpected, i2=%d\n", __FUNCTION__, i2);
+      goto error_exit;
+    }
+
+    pY = pX;
+    pRow = pT ? pT + cbRow * i2 : NULL; // transparency mask row
+
+    for(i1=0; i1 < iW; i1++)
+    {
+      // make sure there are 'n' characters left (the terminating zero ends the check)
+      for(i3=0; i3 < nCharsPerColor; i3++)
+      {
+        if(WB_UNLIKELY(!pX[i3]))
+        {
+          WB_ERROR_PRINT("%s premature end of string, %ld bytes\n", __FUNCTION__, (long)(pX - pY));
+          goto error_exit;
+        }
+      }
+
+      i3 = MyXPMLookupFind(&xLookup, MyXPMPackKey(pX, nCharsPerColor));
+
+      if(WB_UNLIKELY(i3 < 0))
+      {
+        WB_ERROR_PRINT("%s fail, did not locate color %-*.*s\n", __FUNCTION__, nCharsPerColor, nCharsPerColor, pX);
+        goto error_exit;
+      }
+
+      pX += nCharsPerColor;
+      pC = pClr + i3;
+
+      *(pR++) = pC->uiPixel;
+
+      if(pRow) // bitmap for transparency
+      {
+        register unsigned int uiBit;
+
+        // NOTE:  in some test code that was written for VMS, the byte order seems to be
+        //        BACKWARDS in a 16-bittedness way.  It may be that the machine in question
+        //        used a 16-bit word with byte-order determined by an internal function,
+        //        which could cause a 'swap' of each consecutive pair of bytes.  I am going
+        //        to IGNORE THAT for the moment and (by experimentation) determine how I'm
+        //        supposed to order the bits.
+        // TODO:  figure out a system-independent way of doing this that works every time
+        //        even if I have to create an image and manipulate pixels individually
+
+        i3 = iW - 1 - i1;
+        uiBit = 1 << (i3 & 7);
+
+        if(pC->bNone)
+        {
+          pRow[i3 / 8] &= ~uiBit; // bit is clear
+        }
+        else
+        {
+          pRow[i3 / 8] |= uiBit; // bit is set
+        }
+      }
+    }
+  }
+
+  MyXPMLookupFree(&xLookup);
+  WBFree(pClr);
+  pClr = NULL;
+
+  if(ppTransparency)
+  {
+    *ppTransparency = (char *)pT;
+  }
+
+  if(piW)
+  {
+    *piW = iW;
+  }
+
+  if(piH)
+  {
+    *piH = iH;
+  }
+
+  return (char *)pRval;
+
+error_exit:
+
+  MyXPMLookupFree(&xLookup);
+  WBFree(pClr);
+
+  if(pRval)
+  {
+    WBFree(pRval);
+  }
+
+  if(pT)
+  {
+    WBFree(pT);
+  }
+
+  return NULL;
+}
+
+
+// function body - TODO:  move to pixmap_helper.c instead?
+int MyLoadPixmapFromData(WB_DISPLAY pDisplay, Window wID, char *aData[],
+                         Pixmap *pPixmap, Pixmap *pMask, XPM_ATTRIBUTES *pAttr)
+{
+int iW, iH;
+char *pTrans = NULL; // transparency data
+char *pB;
+Pixmap pxImage, pxMask;
+int iRval = 0;
+
+
+  if(pAttr)
+  {
+    bzero(pAttr, sizeof(XPM_ATTRIBUTES));
+  }
+
+  pB = MyXPMToData((const char **)aData, &iW, &iH, &pTrans);
+
+  if(!pB)
+  {
+    WB_ERROR_PRINT("%s - MyXPMToData failed\n", __FUNCTION__);
+
+    if(pPixmap)
+    {
+      *pPixmap = None;
+    }
+    if(pMask)
+    {
+      *pMask = None;
+    }
+
+    return -1;
+  }
+
+  if(pTrans && pMask) // there is transparency information - I'll need a transparency mask
+  {
+    pxMask = XCreatePixmapFromBitmapData(pDisplay, wID, pTrans, iW, iH,
+                                         1,//BlackPixel(pDisplay, DefaultScreen(pDisplay)), mask 'allow' foreground = 1
+                                         0,//WhitePixel(pDisplay, DefaultScreen(pDisplay)), transparent background = 0
+                                         1); // depth of one, always
+    WBFree(pTrans);
+
+    if(!pxMask)
+    {
+      iRval = -2; // sort of error, but do the rest anyway
+    }
+  }
+  else
+  {
+    pxMask = None; // no mask
+  }
+
+  if(pPixmap)
+  {
+    pxImage = XCreatePixmap(pDisplay, wID, iW, iH, DefaultDepth(pDisplay, DefaultScreen(pDisplay)));
+
+    if(!pxImage)
+    {
+      WB_ERROR_PRINT("%s - XCreatePixmap failed\n", __FUNCTION__);
+
+      if(pxMask)
+      {
+        XFreePixmap(pDisplay, pxMask);
+        pxMask = None;
+      }
+
+      iRval = -1;
+    }
+    else
+    {
+      // create an image from the pB data
+      XImage *pImage = XCreateImage(pDisplay, DefaultVisual(pDisplay, DefaultScreen(pDisplay)),
+                                    DefaultDepth(pDisplay, DefaultScreen(pDisplay)),
+                                    ZPixmap,
+                                    0,
+                                    pB,
+                                    iW, iH, 32, iW * 4);
+
+      if(!pImage)
+      {
+        WB_ERROR_PRINT("%s - XCreateImage failed\n", __FUNCTION__);
+
+        if(pxMask)
+        {
+          XFreePixmap(pDisplay, pxMask);
+          pxMask = None;
+        }
+
+        XFreePixmap(pDisplay, pxImage);
+        pxImage = None;
+
+        iRval = -1;
+      }
+      else
+      {
+        GC gc;
+        XGCValues gcv;
+
+        gcv.foreground = BlackPixel(pDisplay, DefaultScreen(pDisplay));
+        gcv.background = WhitePixel(pDisplay, DefaultScreen(pDisplay));
+
+        gc = XCreateGC(pDisplay, wID, (GCForeground | GCBackground), &gcv);
+
+        if(gc == None)
+        {
+          WB_ERROR_PRINT("%s - XCreateGC failed\n", __FUNCTION__);
+
+          if(pxMask)
+          {
+            XFreePixmap(pDisplay, pxMask);
+            pxMask = None;
+          }
+
+          XFreePixmap(pDisplay, pxImage);
+          pxImage = None;
+
+          iRval = -1;
+        }
+        else
+        {
+          // I will need to create a GC
+          // TODO:  use WBXPutImage instead?  For now, no.
+          XPutImage(pDisplay, pxImage, gc, pImage, 0, 0, 0, 0, iW, iH); // and now I have a copy of it
+
+          if(WB_LIKELY(pImage->data == pB)) // data pointer matches my allocated data 'pB'
+          {
+            pImage->data = NULL; // MUST do this before calling XDestroyImage - I free pB later
+          }
+
+          XFreeGC(pDisplay, gc);
+        }
+
+        // TODO:  use WBXDestroyImage instead?  For now, no.
+        XDestroyImage(pImage);
+      }
+    }
+  }
+
+  WBFree(pB); // assume it wasn't realloc'd before
+
+  if(pPixmap)
+  {
+    *pPixmap = pxImage;
+  }
+
+  if(pMask)
+  {
+    *pMask = pxMask;
+  }
+
+  if(pAttr)
+  {
+    pAttr->width = iW;
+    pAttr->height = iH;
+    pAttr->depth = DefaultDepth(pDisplay, DefaultScreen(pDisplay));
+  }
+
+  return iRval;
+}
+
+
+
+
+
+
+
+// some code may have been adapted from libXpm source - SEE ORIGINAL COPYRIGHT NOTICE BELOW
+// I actually DID re-write it from scratch, after studying their code _AND_ doing a bunch of
+// online research for standard X11 documentation, but just in case here's their copyright
+
+/********************** libXpm ORIGINAL SOURCE COPYRIGHT **************************/
+/*
+ * Copyright (C) 1989-95 GROUPE BULL
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * GROUPE BULL BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the name of GROUPE BULL shall not be
+ * used in advertising or otherwise to promote the sale, use or other dealings
+ * in this Software without prior written authorization from GROUPE BULL.
+ */
+
+
+
+#endif // !defined(HAVE_XPM)
+
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                        //
+//   _____  _  _         ____                         _            _                      //
+//  |  ___|(_)| |  ___  |  _ \  ___  _ __  _ __ ___  (_) ___  ___ (_)  ___   _ __   ___   //
+//  | |_   | || | / _ \ | |_) |/ _ \| '__|| '_ ` _ \ | |/ __|/ __|| | / _ \ | '_ \ / __|  //
+//  |  _|  | || ||  __/ |  __/|  __/| |   | | | | | || |\__ \\__ \| || (_) || | | |\__ \  //
+//  |_|    |_||_| \___| |_|    \___||_|   |_| |_| |_||_||___/|___/|_| \___/ |_| |_||___/  //
+//                                                                                        //
+//                                                                                        //
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(WIN32) || defined(__DOXYGEN__)
+/** \ingroup internal
+  * \brief obtain group 'GID' list via 'getgroups()'
+  *
+  * \returns A 'WBAlloc()'d pointer to a list of GIDs, the first of which is the count
+**/
+gid_t * internalWBGetGroupList(void)
+{
+gid_t *pRval;
+gid_t temp;
+int nEntries;
+
+  nEntries = getgroups(0, &temp);
+
+  if(nEntries < 0)
+    return NULL;
+
+  pRval = (gid_t *)WBAlloc(sizeof(gid_t) * (nEntries + 2));
+
+  if(pRval)
+  {
+    memset(pRval, 0, sizeof(gid_t) * (nEntries + 2));
+    pRval[0] = nEntries;
+
+    if(getgroups(nEntries, pRval + 1))
+    {
+      WBFree(pRval);
+      return NULL;
+    }
+  }
+
+  return pRval;
+}
+#endif // !WIN32 || __DOXYGEN__
+
+int WBFileIsReadable(const char *szFileName)
+{
+#ifdef WIN32
+#error implement for WIN32
+#else // !WIN32
+//int iRval;
+//struct stat sF;
+//
+//  iRval = stat(szFileName, &sF);
+//
+//  // TODO check sF.st_mode for permision flags via matches to geteuid() and the group list from above
+
+  return eaccess(szFileName, R_OK);
+#endif // WIN32
+}
+
+int WBFileIsWriteable(const char *szFileName)
+{
+#ifdef WIN32
+#error implement for WIN32
+#else // !WIN32
+  return eaccess(szFileName, W_OK);
+#endif // WIN32
+}
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                               //
+//   ____         _    _                              _   _____                         _____  _  _              //
+//  |  _ \  __ _ | |_ | |__   ___    __ _  _ __    __| | |_   _|___  _ __ ___   _ __   |  ___|(_)| |  ___  ___   //
+//  | |_) |/ _` || __|| '_ \ / __|  / _` || '_ \  / _` |   | | / _ \| '_ ` _ \ | '_ \  | |_   | || | / _ \/ __|  //
+//  |  __/| (_| || |_ | | | |\__ \ | (_| || | | || (_| |   | ||  __/| | | | | || |_) | |  _|  | || ||  __/\__ \  //
+//  |_|    \__,_| \__||_| |_||___/  \__,_||_| |_| \__,_|   |_| \___||_| |_| |_|| .__/  |_|    |_||_| \___||___/  //
+//                                                                             |_|                               //
+//                                                                                                               //
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+// NOTE:  this does NOT canonicalize the path, so '~' and whatnot need
+//        to be handled separately
+int WBMkDir(const char *szFileName, int flags)
+{
+int iRval = -1;
+
+  if(!szFileName || !*szFileName)
+  {
+    return -1; // always an error to create a 'blank' directory
+  }
+
+#ifdef WIN32
+//#error not yet implemented
+  iRval = !CreateDirectory(szFileName, NULL)   // TODO assign 'flags' for security?
+        ? 0 : GetLastError();
+
+  _chmod(szFileName, flags);  // attempt it
+#else // WIN32
+
+  if(szFileName[0] == '/' && !szFileName[1])
+  {
+    return 0; // always succeed if attempting to create the root dir
+  }
+
+  iRval = mkdir(szFileName, flags); // attempt it
+  if(iRval && errno == ENOENT) // need to recursively create it
+  {
+    char *p1, *p2;
+    // remove one element of the path, and recursively attempt to make THAT one
+
+    p1 = WBCopyString(szFileName);
+    if(p1)
+    {
+      p2 = p1 + strlen(p1) - 1;
+      if(*p2 == '/') // already?
+      {
+        p2--;
+      }
+      while(p2 > p1 && *p2 != '/')
+      {
+        p2--;
+      }
+
+      if(p2 > p1)
+      {
+        *p2 = 0;
+        iRval = WBMkDir(p1, flags);
+
+        if(!iRval) // I was able to create things 'above this'
+        {
+          iRval = mkdir(szFileName, flags);
+        }
+      }
+
+      WBFree(p1);
+    }
+  }
+#endif // WIN32
+
+  return iRval;
+}
+
+char * WBSearchPath(const char *szFileName)
+{
+char *pRval = NULL;
+const char *p1, *pCur, *pPath;
+char *p2;
+int iTemp, cbRval;
+
+
+  if(0 > WBStat(szFileName, NULL)) // file does not exist?
+  {
+    if(*szFileName == '/') // absolute path
+    {
+no_stat:
+      WB_ERROR_PRINT("%s - File does not exist: \"%s\"\n", __FUNCTION__, szFileName);
+      return NULL;
+    }
+
+    // check PATH environment variable, and locate first match
+    cbRval = 2 * PATH_MAX + strlen(szFileName);
+    pRval = WBAlloc(cbRval + 2);
+
+    if(pRval)
+    {
+#ifdef WIN32
+      int cb1 = SearchPath(NULL, szFileName, NULL, PATH_MAX, pRval,(TCHAR **)&p1);
+
+      if(cb1 > 0)
+      {
+        pRval[cb1] = 0;
+      }
+      else
+      {
+        free(pRval);
+        pRval = WBCopyString(szFileName);
+      }
+
+      if(pRval && !WBStat(pRval, NULL))
+      {
+        // this function returns non-zero if file not found
+        if(0 > WBStat(pRval, NULL))
+        {
+          if(pRval)
+          {
+            free(pRval);
+          }
+
+          goto no_stat;
+        }
+
+        return pRval; // FOUND!
+      }
+
+      if(pRval)
+      {
+        free(pRval);
+        pRval = NULL;
+      }
+#else // WIN32
+      pPath = getenv("PATH"); // not malloc'd, but should not modify
+      if(pPath)
+      {
+        pCur = pPath;
+
+        while(*pCur)
+        {
+          *pRval = 0; // reset
+
+          p1 = pCur;
+          while(*p1 && *p1 != ':')
+          {
+            p1++;
+          }
+
+          iTemp = p1 - pCur; // the position of the ':'
+
+          if(iTemp + 2 < 2 * PATH_MAX) // only if not a buffer overrun
+          {
+            // build path name
+            memcpy(pRval, pCur, iTemp);
+            pRval[iTemp] = 0;
+
+            WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_File,
+                           "%s.%d - searching \"%s\"\n", __FUNCTION__, __LINE__, pRval);
+
+            if(pRval[iTemp - 1] != '/')
+            {
+              pRval[iTemp] = '/';
+              strlcpy(pRval + iTemp + 1, szFileName, cbRval - (iTemp + 1));
+            }
+            else
+            {
+              strlcpy(pRval + iTemp, szFileName, cbRval - iTemp);
+            }
+
+            WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
+                           "%s.%d - trying \"%s\"\n", __FUNCTION__, __LINE__, pRval);
+
+            if(!WBStat(pRval, NULL))
+            {
+              return pRval; // FOUND!
+            }
+          }
+
+          if(*p1)
+          {
+            p1++;
+          }
+
+          pCur = p1; // pointer to next path to search, or end of string
+        }
+      }
+
+      pPath = pCur = p1 = NULL; // make sure I NULL them out (prevent pointer re-use)
+
+      // if I get here I should check ONE MORE TIME at the location of X11workbench in case
+      // it was installed into a non-standard path someplace and I need one of its utilities
+
+      p2 = WBCopyString(GetStartupAppName());
+      if(p2)
+      {
+        if(*p2 && strlen(p2) < 2 * PATH_MAX) // so I don't overflow
+        {
+          p1 = strrchr(p2, '/'); // find the last '/'
+          if(p1)
+          {
+            p2[p1 - p2 + 1] = 0; // terminate with 0 byte (p1 is const)
+          }
+          else
+          {
+            WBFree(p2);
+            p2 = NULL;
+          }
+        }
+        else
+        {
+          WBFree(p2);
+          p2 = NULL;
+        }
+      }
+
+      p1 = NULL; // prevents pointer re-use
+
+      if(p2)
+      {
+        strlcpy(pRval, p2, cbRval);         // the path for X11workbench's install directory
+        strlcat(pRval, szFileName, cbRval); // use path of X11workbench executable with szFileName
+
+        WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
+                       "%s.%d - trying \"%s\"\n", __FUNCTION__, __LINE__, pRval);
+      }
+      else // could not find, nor get path info
+      {
+        WBFree(pRval);
+        pRval = NULL;
+      }
+    }
+
+    if(!pRval || 0 > WBStat(pRval, NULL))
+    {
+      if(pRval)
+      {
+        WBFree(pRval);
+      }
+
+      goto no_stat;
+#endif // WIN32
+    }
+
+    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
+                   "%s.%d - found \"%s\"\n", __FUNCTION__, __LINE__, pRval);
+  }
+  else
+  {
+    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_File,
+                   "%s.%d - directly found \"%s\"\n", __FUNCTION__, __LINE__, szFileName);
+
+    pRval = WBCopyString(szFileName); // file exists, so return as-is
+  }
+
+  return pRval;
+}
+
+
+char * WBTempFile0(const char *szExt)
+{
+char *pRval = NULL;
+const char *szDir = NULL;
+int i1;
+WB_FILE_HANDLE h1;
+union
+{
+  WB_UINT64 ullTime;
+  unsigned short sA[4];
+} uX;
+static const char szH[17]="0123456789ABCDEF";
+
+
+#ifdef WIN32
+char szTemp[MAX_PATH + 1];
+
+  GetEnvironmentVariable("TEMP", szTemp, MAX_PATH);
+
+  szDir = szTemp;
+
+#else // !WIN32
+
+  // On POSIX systems, first use /var/tmp and if not available, use /tmp
+
+  szDir = "/var/tmp";
+
+  if(0 > WBStat(szDir, NULL))
+  {
+    szDir = "/tmp";
+    if(0 > WBStat(szDir, NULL))
+    {
+      return NULL; // unable to 'stat' the temp file directory
+    }
+  }
+
+#endif // !WIN32
+
+  for(i1=0; i1 < 256; i1++) // don't try forever
+  {
+    pRval = WBCopyString(szDir);
+
+    if(pRval)
+    {
+#ifdef WIN32
+      WBCatString(&pRval, "\\wbtk0000");
+#else // !WIN32
+      WBCatString(&pRval, "/wbtk0000");
+#endif // !WIN32
+    }
+
+
+    uX.ullTime = WBGetTimeIndex();
+    uX.sA[0] ^= uX.sA[1];
+    uX.sA[0] ^= uX.sA[2];
+    uX.sA[0] ^= uX.sA[3];
+
+    if(pRval)
+    {
+      char *pX = pRval + strlen(pRval) - 4; // point to first '0'
+
+      pX[0] = szH[(uX.sA[0] >> 12) & 0xf];
+      pX[1] = szH[(uX.sA[0] >> 8) & 0xf];
+      pX[2] = szH[(uX.sA[0] >> 4) & 0xf];
+      pX[3] = szH[uX.sA[0] & 0xf];
+
+      if(szExt && *szExt)
+      {
+        if(*szExt != '.')
+        {
+          WBCatString(&pRval, ".");
+        }
+        if(pRval)
+        {
+          WBCatString(&pRval, szExt);
+        }
+      }
+    }
+
+    if(pRval)
+    {
+#ifdef WIN32
+      h1 = CreateFile(pRval, GENERIC_READ|GENERIC_WRITE, 0,
+                      NULL, // security descriptor - 0644 mode???
+                      CREATE_ALWAYS,
+                      /*FILE_ATTRIBUTE_TEMPORARY |*/ FILE_ATTRIBUTE_NORMAL,
+                      NULL);
+#else // !WIN32
+      h1 = open(pRval, O_CREAT | O_EXCL | O_RDWR, 0644); // create file, using '644' permissions, fail if exists
+      if(h1 < 0)
+        h1 = INVALID_HANDLE_VALUE;
+#endif // !WIN32
+
+      if(h1 == INVALID_HANDLE_VALUE) // error
+      {
+        WBFree(pRval);
+        pRval = NULL;
+
+        if(errno == EEXIST)
+        {
+          WBDelay(499);
+          continue; // try again with a different name
+        }
+
+        if(errno == ENOTDIR || errno == ENOENT || errno == EACCES ||
+           errno == EPERM || errno == EROFS || errno == EMFILE || errno == ENFILE)
+        {
+          // these errors are fatal, so I exit now
+          break;
+        }
+      }
+      else
+      {
+#ifdef WIN32
+        CloseHandle(h1);
+#else  // !WIN32
+        close(h1);
+#endif // !WIN32
+
+        // add this file to the existing list of temp files to be destroyed
+        // on exit from the program.
+
+        break; // file name is valid and ready for use
+      }
+    }
+  }
+
+  return pRval;
+}
+
+static void __add_to_temp_file_list(const char *szFile)
+{
+int i1 = strlen(szFile);
+char *pTemp;
+
+  // TODO:  thread-safe?
+
+  if(!pTempFileList)
+  {
+    cbTempFileList = PATH_MAX * 256;
+    pTempFileList = WBAlloc(cbTempFileList);
+
+    if(!pTempFileList)
+    {
+      return;
+    }
+
+    pTempFileListEnd = pTempFileList;
+  }
+  else if((pTempFileListEnd - pTempFileList) + i1 + 2 >= cbTempFileList)
+  {
+    pTemp = WBReAlloc(pTempFileList, cbTempFileList + (128 * PATH_MAX));
+    if(!pTemp)
+    {
+      return;
+    }
+
+    cbTempFileList += 128 * PATH_MAX; // using a 'while' loop sanity checks this against i1
+
+    if((pTempFileListEnd - pTempFileList) + i1 + 2 >= cbTempFileList) // sanity check
+    {
+      return; // don't bother re-allocating, this is probably NOT sane
+    }
+  }
+
+  memcpy(pTempFileListEnd, szFile, i1);
+  pTempFileListEnd += i1;
+
+  *(pTempFileListEnd++) = 0;
+  *pTempFileListEnd = 0; // always end with 2 0-bytes, point to 2nd one
+}
+
+char * WBTempFile(const char *szExt)
+{
+char *pRval = WBTempFile0(szExt);
+
+  if(pRval)
+  {
+    __add_to_temp_file_list(pRval);
+  }
+
+  return pRval;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                                       //
+//   _____        _                             _      _                   _  _              _    _                      //
+//  | ____|__  __| |_  ___  _ __  _ __    __ _ | |    / \    _ __   _ __  | |(_)  ___  __ _ | |_ (_)  ___   _ __   ___   //
+//  |  _|  \ \/ /| __|/ _ \| '__|| '_ \  / _` || |   / _ \  | '_ \ | '_ \ | || | / __|/ _` || __|| | / _ \ | '_ \ / __|  //
+//  | |___  >  < | |_|  __/| |   | | | || (_| || |  / ___ \ | |_) || |_) || || || (__| (_| || |_ | || (_) || | | |\__ \  //
+//  |_____|/_/\_\ \__|\___||_|   |_| |_| \__,_||_| /_/   \_\| .__/ | .__/ |_||_| \___|\__,_| \__||_| \___/ |_| |_||___/  //
+//                                                          |_|    |_|                                                   //
+//                                                                                                                       //
+//                          _                _   ____                                                                    //
+//                         / \    _ __    __| | |  _ \  _ __  ___    ___  ___  ___  ___   ___  ___                       //
+//                        / _ \  | '_ \  / _` | | |_) || '__|/ _ \  / __|/ _ \/ __|/ __| / _ \/ __|                      //
+//                       / ___ \ | | | || (_| | |  __/ | |  | (_) || (__|  __/\__ \\__ \|  __/\__ \                      //
+//                      /_/   \_\|_| |_| \__,_| |_|    |_|   \___/  \___|\___||___/|___/ \___||___/                      //
+//                                                                                                                       //
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////
+// EXTERNAL APPLICATION EXECUTION
+///////////////////////////////////
+
+WB_PROCESS_ID WBRunAsyncPipeV(WB_FILE_HANDLE hStdIn, WB_FILE_HANDLE hStdOut, WB_FILE_HANDLE hStdErr,
+                              const char *szAppName, va_list va)
+{
+const char *pArg;//, *pPath;
+char *pCur, *p1, *pAppName = NULL;
+#ifdef WIN32
+STARTUPINFO si;
+PROCESS_INFORMATION pi;
+#else // !WIN32
+char **argv;
+int i1, nItems, cbItems;
+va_list va2;
+#endif // WIN32
+WB_PROCESS_ID hRval = WB_INVALID_PROCESS_ID;
+WB_FILE_HANDLE hIn, hOut, hErr;
+
+
+  // NOTE:  to avoid zombies, must assign SIGCHLD to 'SIG_IGN' or process them correctly
+  //        (this is done in 'WBInit')
+
+  hIn = hOut = hErr = WB_INVALID_FILE_HANDLE; // by convention (WIN32 needs this anyway)
+
+  // FIRST, locate 'szAppName'
+
+  pAppName = WBSearchPath(szAppName);
+
+  if(!pAppName)
+    return WB_INVALID_PROCESS_ID;
+
+  if(hStdIn == WB_INVALID_FILE_HANDLE) // re-dir to/from /dev/null
+  {
+#ifndef WIN32
+    hIn = open("/dev/null", O_RDONLY, 0);
+#else // WIN32
+    SECURITY_DESCRIPTOR *pSD = (SECURITY_DESCRIPTOR *)WBAlloc(SECURITY_DESCRIPTOR_MIN_LENGTH);
+
+    if(pSD)
+    {
+      SECURITY_ATTRIBUTES sa;
+
+      InitializeSecurityDescriptor(pSD,SECURITY_DESCRIPTOR_REVISION);
+
+      sa.nLength = sizeof(sa);
+      sa.lpSecurityDescriptor = pSD;
+      sa.bInheritHandle = TRUE; // what a pain
+
+      hIn = CreateFile("NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       &sa, OPEN_EXISTING, NULL, NULL);
+      WBFree(pSD);
+    }
+#endif // WIN32
+  }
+  else
+  {
+#ifndef WIN32
+    hIn = dup(hStdIn);
+#else // WIN32
+    if(!DuplicateHandle(GetCurrentProcess(), hStdIn,
+                        GetCurrentProcess(), &hIn, GENERIC_READ,
+                        TRUE, 0))
+    {
+      hIn = WB_INVALID_FILE_HANDLE;
+    }
+#endif // WIN32
+  }
+
+  if(hStdOut == WB_INVALID_FILE_HANDLE) // re-dir to/from /dev/null
+  {
+#ifndef WIN32
+    hOut = open("/dev/null", O_WRONLY, 0);
+#else // WIN32
+    SECURITY_DESCRIPTOR *pSD = (SECURITY_DESCRIPTOR *)WBAlloc(SECURITY_DESCRIPTOR_MIN_LENGTH);
+
+    if(pSD)
+    {
+      SECURITY_ATTRIBUTES sa;
+
+      InitializeSecurityDescriptor(pSD,SECURITY_DESCRIPTOR_REVISION);
+
+      sa.nLength = sizeof(sa);
+      sa.lpSecurityDescriptor = pSD;
+      sa.bInheritHandle = TRUE; // what a pain
+
+      hOut = CreateFile("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        &sa, OPEN_EXISTING, 0, NULL);
+      WBFree(pSD);
+    }
+#endif // WIN32
+  }
+  else
+  {
+#ifndef WIN32
+    hOut = dup(hStdOut);
+#else // WIN32
+    if(!DuplicateHandle(GetCurrentProcess(), hStdOut,
+                        GetCurrentProcess(), &hOut, GENERIC_WRITE,
+                        TRUE, 0))
+    {
+      hOut = WB_INVALID_FILE_HANDLE;
+    }
+#endif // WIN32
+  }
+
+  if(hStdErr == WB_INVALID_FILE_HANDLE) // re-dir to/from /dev/null
+  {
+#ifndef WIN32
+    hErr = open("/dev/null", O_WRONLY, 0);
+#else // WIN32
+#ifdef DEBUG_STDERR_TO_STDOUT
+    if(hStdOut != WB_INVALID_FILE_HANDLE)
+    {
+      if(!DuplicateHandle(GetCurrentProcess(), hStdOut,
+                          GetCurrentProcess(), &hErr, GENERIC_WRITE,
+                          TRUE, 0))
+      {
+        hErr = WB_INVALID_FILE_HANDLE;
+      }
+    }
+    else
+#endif // DEBUG_STDERR_TO_STDOUT
+    {
+      SECURITY_DESCRIPTOR *pSD = (SECURITY_DESCRIPTOR *)WBAlloc(SECURITY_DESCRIPTOR_MIN_LENGTH);
+
+      if(pSD)
+      {
+        SECURITY_ATTRIBUTES sa;
+
+        InitializeSecurityDescriptor(pSD,SECURITY_DESCRIPTOR_REVISION);
+
+        sa.nLength = sizeof(sa);
+        sa.lpSecurityDescriptor = pSD;
+        sa.bInheritHandle = TRUE; // what a pain
+
+        hErr = CreateFile("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                          &sa, OPEN_EXISTING, 0, NULL);
+        WBFree(pSD);
+      }
+    }
+#endif // WIN32
+  }
+  else
+  {
+#ifndef WIN32
+    hErr = dup(hStdErr);
+#else // WIN32
+    if(!DuplicateHandle(GetCurrentProcess(), hStdErr,
+                        GetCurrentProcess(), &hErr, GENERIC_WRITE,
+                        TRUE, 0))
+    {
+      hErr = WB_INVALID_FILE_HANDLE;
+    }
+#endif // WIN32
+  }
+
+  // if file handle duplication fails, exit now with an error
+
+  if(hIn == WB_INVALID_FILE_HANDLE ||
+     hOut == WB_INVALID_FILE_HANDLE ||
+     hErr == WB_INVALID_FILE_HANDLE)
+  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s hIn=%d hOut=%d hErr=%d\n", __FUNCTION__, hIn, hOut, hErr);
+
+    if(hIn != WB_INVALID_FILE_HANDLE)
+    {
+#ifndef WIN32
+      close(hIn);
+#else // WIN32
+      CloseHandle(hIn);
+#endif // WIN32
+    }
+    if(hOut != WB_INVALID_FILE_HANDLE)
+    {
+#ifndef WIN32
+      close(hOut);
+#else // WIN32
+      CloseHandle(hOut);
+#endif // WIN32
+    }
+    if(hErr != WB_INVALID_FILE_HANDLE)
+    {
+#ifndef WIN32
+      close(hErr);
+#else // WIN32
+      CloseHandle(hErr);
+#endif // WIN32
+    }
+
+    if(pAppName != szAppName)
+    {
+      WBFree(pAppName);
+    }
+
+    return WB_INVALID_PROCESS_ID;
+  }
+
+#ifdef WIN32
+
+  memset(&si, 0, sizeof(si));
+  memset(&pi, 0, sizeof(pi));
+
+  si.cb = sizeof(si);
+
+  si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+  si.hStdInput = hIn;
+  si.hStdOutput = hOut;
+  si.hStdError = hErr;
+
+  // make sure it is hidden
+  si.wShowWindow = SW_HIDE;
+
+#if 1
+  // get application name from path
+
+  p1 = _tcsrchr((TCHAR *)pAppName, '\\');
+  if(p1)
+  {
+    pCur = WBCopyString(p1 + 1); // just the name
+  }
+  else
+  {
+    pCur = WBCopyString(pAppName);
+  }
+#else // 0,1
+  pCur = WBCopyString(""); // need non-null pointer
+#endif // 0
+
+  // build the command line
+
+  while(1)
+  {
+    pArg = va_arg(va, const TCHAR *);
+    if(!pArg)
+    {
+      break;
+    }
+
+    WBCatString(&pCur, _T(" "));
+
+    // if the parameter contains a space, windows requires quotes.
+    if(strchr(pArg, ' '))
+    {
+      if(strchr(pArg, '"'))
+      {
+        WBCatString(&pCur, "'");
+        WBCatString(&pCur, pArg); // caller must add quotes as needed
+        WBCatString(&pCur, "'");
+      }
+      else
+      {
+        WBCatString(&pCur, "\"");
+        WBCatString(&pCur, pArg); // caller must add quotes as needed
+        WBCatString(&pCur, "\"");
+      }
+    }
+    else
+      WBCatString(&pCur, pArg); // caller must add quotes as needed
+  }
+
+  if(CreateProcess(pAppName, pCur, NULL, NULL, TRUE, NORMAL_PRIORITY_CLASS,
+                   NULL, NULL, &si, &pi))  // it worked?
+  {
+      // wait for process to complete before continuing...
+
+//        SetCursor(LoadCursor(NULL, IDC_WAIT));
+    hRval.uiProcessID = pi.dwProcessId;
+    hRval.hProcess = pi.hProcess;
+    hRval.iCachedExitCode = -1;
+
+    WaitForInputIdle(pi.hProcess, 1000); // wait up to 1 sec to help it run
+  }
+  else
+  {
+    hRval = WB_INVALID_PROCESS_ID;
+  }
+
+  free(pCur);
+  pCur = NULL;
+
+  CloseHandle(hIn);
+  CloseHandle(hOut);
+  CloseHandle(hErr);
+
+#else // WIN32
+
+  // count arguments, determine memory requirement
+
+  nItems = 0;
+  cbItems = 2 * sizeof(char *) + strlen(szAppName) + 1;
+  va_copy(va2, va);
+
+  while(1)
+  {
+    pArg = va_arg(va2, const char *);
+    if(!pArg)
+    {
+      break;
+    }
+
+    cbItems += strlen(pArg) + 1 + sizeof(char *);
+    nItems++;
+  }
+
+  argv = (char **)WBAlloc(64 + cbItems);
+  if(!argv)
+  {
+    close(hIn);
+    close(hOut);
+    close(hErr);
+
+    if(pAppName != szAppName)
+    {
+      WBFree(pAppName);
+    }
+
+//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (1)\n", __FUNCTION__);
+    return WB_INVALID_FILE_HANDLE;
+  }
+
+  pCur = (char *)(argv + nItems + 2); // enough room for argument pointers
+
+  p1 = strrchr(szAppName, '/');
+  if(p1)
+  {
+    strcpy(pCur, p1 + 1); // just the name (note - safe to use strcpy, I already did a size test before alloc'ing)
+  }
+  else
+  {
+    strcpy(pCur, szAppName); // having already tested for 'big enough' it's ok to use strcpy here
+  }
+
+  argv[0] = pCur;
+  pCur += strlen(pCur) + 1;
+
+  for(i1=1; i1 <= nItems; i1++)
+  {
+    pArg = va_arg(va, const char *);
+
+    strcpy(pCur, pArg); // having already tested for 'big enough' it's ok to use strcpy here
+    argv[i1] = pCur;
+    pCur += strlen(pCur) + 1;
+  }
+
+  argv[nItems + 1] = NULL;
+
+  // now that I have a valid 'argv' I can spawn the process.
+  // I will return the PID so that the caller can wait on it
+
+  hRval = vfork();
+
+  if(!hRval) // the 'forked' process
+  {
+    // vfork jumps here FIRST and temporarily suspends the calling thread
+    // it also does NOT make a copy of memory so I must treat it as 'read only'
+
+    if(dup2(hIn, 0) != -1 && dup2(hOut, 1) != -1 && dup2(hErr, 2) != -1) // stdin, stdout, stderr
+    {
+      static const char szMsg[]="ERROR: 'execve()' failure\n";
+      extern char **environ; // this is what the man page says to do (it's part of libc)
+
+      // TODO:  customize environment?
+
+      signal(SIGHUP, SIG_IGN); // ignore 'HUP' signal before 'setsid' call ['daemon()' does this]
+      setsid(); // so that I am my own process group (NOTE doing this might make it impossible to get the exit status... must verify everywhere)
+      signal(SIGHUP, SIG_DFL); // restore default handling of 'HUP' ['daemon()' does this]
+
+      execve(pAppName, argv, environ); // NOTE:  execute clears all existing signal handlers back to 'default' but retains 'ignored' signals
+
+      write(2, szMsg, sizeof(szMsg) - 1); // stderr is still 'the old one' at this point
+      fsync(2);
+
+      // TODO:  if execve fails, should I forcibly close the duplicated handles??
+//      close(0);
+//      close(1);
+//      close(2);
+    }
+    else
+    {
+      static const char szMsg[]="ERROR: 'dup2()' failure\n";
+      write(2, szMsg, sizeof(szMsg) - 1); // stderr is still 'the old one' at this point
+    }
+
+    close(hIn); // explicitly close these if I get here
+    close(hOut);
+    close(hErr);
+
+    _exit(-1); // should never get here, but this must be done if execve fails
+  }
+
+  // once I've forked, I don't have to worry about copied memory or shared memory
+  // and it's safe to free the allocated 'argv' array.
+
+  WBFree(argv);
+
+  close(hIn);
+  close(hOut);
+  close(hErr);
+
+#endif // WIN32
+
+  if(pAppName != szAppName)
+  {
+    WBFree(pAppName);
+  }
+
+
+  return hRval;
+}
+
+
+WB_PROCESS_ID WBRunAsync(const char *szAppName, ...)
+{
+WB_PROCESS_ID idRval;
+va_list va;
+
+  va_start(va, szAppName);
+
+  idRval = WBRunAsyncPipeV(WB_INVALID_FILE_HANDLE, WB_INVALID_FILE_HANDLE,
+                           WB_INVALID_FILE_HANDLE, szAppName, va);
+
+  va_end(va);
+
+  if(WB_PROCESS_ID_INVALID(idRval))
+  {
+    WB_ERROR_PRINT("Unable to run '%s'\n", szAppName);
+  }
+//  else
+//  {
+//    WB_ERROR_PRINT("Running '%s' - pid=%d\n", szAppName, idRval);
+//  }
+
+  return idRval;
+}
+
+WB_PROCESS_ID WBRunAsyncPipe(WB_FILE_HANDLE hStdIn, WB_FILE_HANDLE hStdOut, WB_FILE_HANDLE hStdErr,
+                             const char *szAppName, ...)
+{
+WB_PROCESS_ID idRval;
+va_list va;
+
+  va_start(va, szAppName);
+
+  idRval = WBRunAsyncPipeV(hStdIn, hStdOut, hStdErr, szAppName, va);
+
+  va_end(va);
+
+  return idRval;
+}
+
+
+#define WBRUNRESULT_BUFFER_MINSIZE 65536
+#define WBRUNRESULT_BYTES_TO_READ 256
+
+static char * WBRunResultInternal(WB_FILE_HANDLE hStdIn, WB_INT32 *pExitCode, const char *szAppName, va_list va)
+{
+WB_PROCESS_ID idRval;
+#ifdef WIN32
+DWORD cb1;
+#endif // WIN32
+WB_FILE_HANDLE hP[2]; // [0] is read end, [1] is write end
+char *p1, *p2, *pRval;
+int i2, iRunning;
+#ifndef WIN32
+int i1, iStat;
+#endif // WIN32
+/*unsigned*/ int cbBuf;
+
+
+  cbBuf = WBRUNRESULT_BUFFER_MINSIZE;
+  pRval = WBAlloc(cbBuf);
+
+  if(!pRval)
+  {
+    return NULL;
+  }
+
+  // use WBRunAsyncPipeV to create a process, with all stdout piped to a char * buffer capture
+  // stdin and stderr still piped to/from /dev/null
+
+  // create an anonymous pipe.  hP[0] is the INPUT pipe, hP[1] is the OUTPUT pipe
+  // this is important in windows.  for POSIX it doesn't really matter which one you use,
+  // but by convention [0] will be input, [1] will be output
+
+  hP[0] = hP[1] = WB_INVALID_FILE_HANDLE;
+
+#ifdef WIN32 /* the WINDOWS way */
+  if(!CreatePipe(&(hP[0]), &(hP[1]), NULL, 0))
+#else // !WIN32 (everybody else)
+  if(0 > pipe(hP))
+#endif // WIN32
+  {
+    WBFree(pRval);
+//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
+    return NULL;
+  }
+
+#ifdef WIN32 /* the WINDOWS way */
+  SetHandleInformation(hP[1], HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+#endif // WIN32
+
+  idRval = WBRunAsyncPipeV(hStdIn, hP[1], // the 'write' end is passed as stdout
+                           WB_INVALID_FILE_HANDLE, szAppName, va);
+
+  if(WB_PROCESS_ID_INVALID(idRval))
+  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s failed to run \"%s\" errno=%d\n", __FUNCTION__, szAppName, errno);
+
+#ifdef WIN32 /* the WINDOWS way */
+    CloseHandle(hP[0]);
+    CloseHandle(hP[1]);
+#else // !WIN32 (everybody else)
+    close(hP[0]);
+    close(hP[1]);
+#endif // WIN32
+
+    return NULL;
+  }
+
+#ifndef WIN32
+  close(hP[1]); // by convention, this will 'widow' the read end of the pipe once the process is done with it
+  hP[1] = INVALID_HANDLE_VALUE;
+
+  fcntl(hP[0], F_SETFL, O_NONBLOCK); // set non-blocking I/O
+#endif // WIN32
+
+  // so long as the process is alive, read data from the pipe and stuff it into the output buffer
+  // (the buffer will need to be reallocated periodically if it fills up)
+
+  p1 = pRval;
+  *p1 = 0;       // always do this
+  iRunning = 1;  // iRunning will be used as a flag to indicate the process exited.
+
+  while(1)
+  {
+    i2 = WBRUNRESULT_BYTES_TO_READ; // number of bytes to read at one time
+    if((p1 - pRval) + i2 >= cbBuf) // enough room for it?
+    {
+      i2 = cbBuf - (p1 - pRval);
+      if(i2 < WBRUNRESULT_BYTES_TO_READ / 8) // time to re-allocate
+      {
+        p2 = WBReAlloc(pRval, cbBuf + WBRUNRESULT_BUFFER_MINSIZE / 2);
+        if(!p2)
+        {
+          WBFree(pRval);
+          pRval = NULL;
+
+//          WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (4)\n", __FUNCTION__);
+          break;
+        }
+
+        cbBuf += WBRUNRESULT_BUFFER_MINSIZE / 2;
+        p1 = p2 + (p1 - pRval);
+        pRval = p2;
+        i2 = WBRUNRESULT_BYTES_TO_READ;
+      }
+    }
+
+    // if no data available I'll return immediately
+#ifdef WIN32 /* the Windows way */
+    cb1 = 0;
+
+    if(!PeekNamedPipe(hP[0], NULL, 0, NULL, &cb1, NULL))
+    {
+      DWORD dwErr;
+check_pipe_no_data_avail:
+
+      dwErr = GetLastError();
+
+      if(!iRunning)
+      {
+        break; // assume end of file, process ended, bail out now
+      }
+
+      if(dwErr == ERROR_MORE_DATA || dwErr == ERROR_PIPE_BUSY || dwErr == ERROR_IO_PENDING
+         || dwErr == ERROR_NO_MORE_ITEMS/* EAGAIN */ )
+      {
+        Sleep(10); // wait 1/2 msec
+      }
+      else
+      {
+        break; // an error of some kind, so bail out [pipe closed?]
+      }
+    }
+    else if(!cb1)
+    {
+      if(!iRunning)
+        break; // end of file
+    }
+    else if(!ReadFile(hP[0], p1, i2, &cb1, NULL))
+    {
+      goto check_pipe_no_data_avail;
+    }
+    else if(!cb1)  // this just might be an error
+    {
+      if(!iRunning)
+        break; // end of file
+    }
+    else
+    {
+      p1 += cb1; // point past the # of bytes I just read in
+      *p1 = 0; // by convention [to make sure the string is ALWAYS terminated with a 0-byte]
+    }
+
+    if(iRunning) // only if "still running"
+    {
+      // for waitpid(), if WNOHANG is specified and there are no stopped, continued or exited children, 0 is returned
+
+      if(WBGetProcessState(idRval, pExitCode) <= 0) // ended or error
+      {
+        iRunning = 0; // my flag that it's not running
+      }
+
+      Sleep(10); // so I don't 'spin' and IO completes at end of process
+    }
+  }
+
+  // always kill the process at this point (in case there was an error)
+
+  Sleep(10); // wait 10 msec - prevents certain problems
+
+  if(hP[1] != INVALID_HANDLE_VALUE)
+    CloseHandle(hP[1]); // done with the pipes - close them now
+  if(hP[0] != INVALID_HANDLE_VALUE)
+    CloseHandle(hP[0]);
+
+#else // !WIN32 - everybody else
+
+    i1 = read(hP[0], p1, i2);
+
+    if(i1 <= 0)
+    {
+      if(!iRunning)
+      {
+        if(i1 == 0)
+        {
+          break; // end of file, process ended, bail out now
+        }
+//        else // this could be caused by the process forking, and the program failing to run
+//        {
+//          // TODO:  allow a few retries, then bail??
+//
+//          break; // for now, bail out on this as well.  should still get "all of it" in the output
+//        }
+      }
+
+      if(errno == EAGAIN)
+      {
+        WBDelay(500); // wait 1/2 msec
+      }
+      else
+      {
+        break; // an error of some kind, so bail out [pipe closed?]
+      }
+    }
+    else
+    {
+      p1 += i1; // point past the # of bytes I just read in
+      *p1 = 0; // by convention [to make sure the string is ALWAYS terminated with a 0-byte]
+    }
+
+    if(iRunning) // only if "still running"
+    {
+      // for waitpid(), if WNOHANG is specified and there are no stopped, continued or exited children, 0 is returned
+
+      if(waitpid(idRval, &iStat, WNOHANG) && // note this might return non-zero for stopped or continued processes
+         WIFEXITED(iStat))                   // so test if process exits also.
+      {
+        iRunning = 0; // my flag that it's not running
+        WBDelay(5000); // wait for a bit to make sure the I/O completes
+      }
+      else
+      {
+        WBDelay(500); // so I don't 'spin'
+      }
+    }
+  }
+
+  // always kill the process at this point (in case there was an error)
+
+  kill(idRval, SIGKILL); // not so nice way but oh well
+  WBDelay(5000); // wait 5msec
+
+  close(hP[0]); // done with the pipe - close it now
+
+#endif // WIN32
+
+//  WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (4) pRval=%p *pRval=%c\n", __FUNCTION__, pRval, (char)(pRval ? *pRval : 0));
+
+  return pRval;
+}
+
+int WBGetProcessState(WB_PROCESS_ID idProcess, WB_INT32 *pExitCode)
+{
+#ifdef WIN32
+  int iRval = -1;
+  HANDLE hProcess = idProcess.hProcess; //OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, idProcess);
+  DWORD dwWait, dwTemp = -1;
+
+  if(pExitCode)
+    *pExitCode = -1;;
+
+  if(hProcess == INVALID_HANDLE_VALUE)
+  {
+    if(idProcess.uiProcessID != 0) // for now this indicates valid.  process 0 is inaccessible
+      return idProcess.iCachedExitCode; // return cached value
+
+    return -1;
+  }
+
+  dwWait = WaitForMultipleObjects(1, &hProcess, FALSE, 10);
+
+  if(dwWait == WAIT_TIMEOUT)
+  {
+    iRval = 1; // still running
+  }
+  else if(dwWait == WAIT_OBJECT_0) // process has stopped
+  {
+    iRval = 0;
+  }
+  else // if(dwWait == WAIT_ABANDONED_0)
+  {
+    iRval = -1;  // like 'quit' baby, quit!
+  }
+
+  if(!iRval)
+  {
+    if(GetExitCodeProcess(hProcess, &dwTemp))
+    {
+      if(pExitCode)
+        *pExitCode = dwTemp;
+      idProcess.iCachedExitCode = dwTemp;
+    }
+    else
+    {
+      iRval = -1; // oops
+    }
+
+    CloseHandle(idProcess.hProcess); // clean up
+    idProcess.hProcess = INVALID_HANDLE_VALUE; //  because I closed it
+  }
+
+//  CloseHandle(hProcess);
+  return iRval;
+
+#else // WIN32
+  int iStat, iRval;
+
+  // for waitpid(), if WNOHANG is specified and there are no stopped, continued or exited children, 0 is returned
+
+  iStat = 0;
+  iRval = waitpid(idProcess, &iStat, WNOHANG); // note this might return non-zero for stopped or continued processes
+
+  if(iRval > 0 && (iRval == (int)idProcess || (int)idProcess == -1 || (int)idProcess == 0))
+  {
+    if(WIFEXITED(iStat))                   // test if process exits also.
+    {
+      if(pExitCode)
+      {
+        *pExitCode = (WB_INT32)WEXITSTATUS(iStat);
+      }
+
+      return 0; // not running
+    }
+
+    return 1; // still running
+  }
+
+  if(iRval > 0)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - waitpid returns %d, but does not match %d\n",
+                   __FUNCTION__, iRval, (int)idProcess);
+  }
+
+  return -1; // error
+#endif // WIN32
+}
+
+char *WBRunResult(const char *szAppName, ...)
+{
+char *pRval;
+va_list va;
+
+
+  va_start(va, szAppName);
+
+  pRval = WBRunResultInternal(WB_INVALID_FILE_HANDLE, NULL, szAppName, va);
+
+  va_end(va);
+
+  return pRval;
+}
+
+char *WBRunResult2(const char *szAppName, ...)
+{
+char *pRval;
+int32_t nExitCode;
+va_list va;
+
+
+  va_start(va, szAppName);
+
+  pRval = WBRunResultInternal(INVALID_HANDLE_VALUE, &nExitCode, szAppName, va);
+
+  if(pRval && nExitCode)
+  {
+//    fprintf(stderr, "%s - %s ended with error code %d\n", __FUNCTION__, szAppName, nExitCode);
+//    fflush(stderr);
+
+    free(pRval);
+    pRval = NULL;
+  }
+
+  va_end(va);
+
+  return pRval;
+}
+
+#ifdef WIN32
+struct __RunResult3_worker_thread_params
+{
+  volatile HANDLE hStdin[2];  // pipe for STDIN
+  const void * pStdin;
+  int cbStdin;
+  volatile HANDLE hThread;
+  volatile unsigned int dwThreadID;
+  volatile int bStateFlag; // 0 = not running, 1 = running, -1 force stop
+};
+
+static unsigned int __stdcall __RunResult3_worker_thread(void *pData)
+{
+int i2;
+const BYTE *p1;
+DWORD cb1, cbData;
+HANDLE hTemp;
+struct __RunResult3_worker_thread_params *pParams = (struct __RunResult3_worker_thread_params *)pData;
+
+  // so long as the process is alive, write data to the pipe
+#define RUNRESULT3_BUFFER_LENGTH 256
+  pParams->bStateFlag = 1; // indicates I'm running
+
+  p1 = (const BYTE *)pParams->pStdin;
+  cbData = pParams->cbStdin;
+
+  while(cbData && pParams->dwThreadID)
+  {
+    cb1 = 0;
+     // if buffer empty, fill it
+#if 0
+    if(!PeekNamedPipe(pParams->hStdin[0], NULL, 0, NULL, &cb1, NULL))
+    {
+      goto check_pipe_io_error;
+    }
+    else if(cb1 > RUNRESULT3_BUFFER_LENGTH / 2)
+    {
+      Sleep(20);
+    }
+    else
+#endif // 0
+    {
+      i2 = RUNRESULT3_BUFFER_LENGTH - cb1; // available write space
+      if(i2 > (int)cbData)
+        i2 = cbData;
+
+      if(!WriteFile(pParams->hStdin[1], p1, i2, &cb1, NULL))
+      {
+        DWORD dwErr;
+#if 0
+check_pipe_io_error:
+#endif // 0
+
+        dwErr = GetLastError();
+
+        if(dwErr == ERROR_MORE_DATA || dwErr == ERROR_PIPE_BUSY || dwErr == ERROR_IO_PENDING
+           || dwErr == ERROR_NO_MORE_ITEMS/* EAGAIN */ )
+        {
+          Sleep(10); // wait 1/2 msec
+        }
+        else
+        {
+          break; // an error of some kind, so bail out [pipe closed?]
+        }
+      }
+      else if(!cb1)  // this just might be an error
+      {
+        // TODO: anything?
+        Sleep(50);
+      }
+      else
+      {
+        p1 += cb1; // point past the # of bytes I just read in
+        cbData -= cb1;
+      }
+    }
+  }
+
+  Sleep(10); // wait 10 msec
+
+  // close my end of the pipe
+  hTemp = pParams->hStdin[1];
+  pParams->hStdin[1] = INVALID_HANDLE_VALUE;
+  CloseHandle(hTemp);
+
+  hTemp = pParams->hStdin[0];
+  pParams->hStdin[0] = INVALID_HANDLE_VALUE;
+  CloseHandle(hTemp);
+
+  // mark as 'exited'
+  pParams->bStateFlag = -1; // indicates I'm ending
+  _endthreadex(0);
+  return 0;
+}
+#endif // WIN32
+
+
+char *RunResult3(const void *pStdin, int cbStdin, const char *szAppName, ...) // windows-specific
+{
+#ifdef WIN32
+char *pRval;
+INT32 nExitCode;
+va_list va;
+struct __RunResult3_worker_thread_params xParams = {{INVALID_HANDLE_VALUE,INVALID_HANDLE_VALUE},
+                                                    NULL, 0, INVALID_HANDLE_VALUE, 0, 0 };
+
+
+  va_start(va, szAppName);
+
+  // create a pipe and worker thread for stdin using pStdin and cbStdin
+
+  if(!CreatePipe((HANDLE *)&(xParams.hStdin[0]), (HANDLE *)&(xParams.hStdin[1]), NULL, 0))
+  {
+//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
+    return NULL;
+  }
+
+  SetHandleInformation(xParams.hStdin[0], HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+
+  // start worker thread
+  xParams.hThread = (HANDLE)_beginthreadex(NULL, 65536, __RunResult3_worker_thread,
+                                           &xParams, CREATE_SUSPENDED,
+                                           (unsigned int *)&xParams.dwThreadID);
+
+  if(xParams.hThread == INVALID_HANDLE_VALUE)
+  {
+//    WB_ERROR_PRINT("* ERROR * - unable to create thread, %d (%x) (a)\n",
+//                   GetLastError(), GetLastError());
+    goto error_exit;
+  }
+
+  xParams.pStdin = pStdin;
+  xParams.cbStdin = cbStdin;
+
+  ResumeThread(xParams.hThread);
+
+  while(xParams.dwThreadID && xParams.bStateFlag == 0)
+    Sleep(10); // wait for it to begin (avoid race condition if program does not start)
+
+  pRval = WBRunResultInternal(xParams.hStdin[0], &nExitCode, szAppName, va);
+
+  // wait for worker thread close
+
+  if(pRval && nExitCode)
+  {
+#ifdef _DEBUG
+    {
+      char tbuf[1024];
+      _sntprintf(tbuf, sizeof(tbuf), "%s ended with error code %d\n", szAppName, nExitCode);
+#ifdef __cplusplus
+      ::MessageBox
+#else // __cplusplus
+      MessageBox
+#endif // __cplusplus
+        (NULL, tbuf, "** EXTERNAL APPLICATION ERROR **", MB_OK |  MB_ICONERROR);
+      OutputDebugString(pRval);
+    }
+#endif _DEBUG
+
+    free(pRval);
+    pRval = NULL;
+  }
+
+  va_end(va);
+
+error_exit:
+
+  xParams.dwThreadID = 0; // tells thread to exit
+
+  if(xParams.hThread != INVALID_HANDLE_VALUE)
+  {
+    while(xParams.bStateFlag > 0)
+      Sleep(10); // wait for it to end
+
+    CloseHandle(xParams.hThread);
+  }
+
+  if(xParams.hStdin[1] != INVALID_HANDLE_VALUE)
+    CloseHandle(xParams.hStdin[1]);
+
+  if(xParams.hStdin[0] != INVALID_HANDLE_VALUE)
+    CloseHandle(xParams.hStdin[0]);
+
+  return pRval;
+
+#else // WIN32
+
+char *pRval, *pTemp = NULL;
+va_list va;
+WB_FILE_HANDLE hIn = WB_INVALID_FILE_HANDLE;
+
+
+  va_start(va, szAppName);
+
+  if(pStdin && cbStdin > 0)
+  {
+    unsigned int nLen = cbStdin;
+    const unsigned char *szStdInBuf = (const unsigned char *)pStdin;
+
+    pTemp = WBTempFile0(".tmp");
+
+    if(!pTemp)
+    {
+//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (1)\n", __FUNCTION__);
+
+      va_end(va);
+      return NULL;
+    }
+
+    hIn = open(pTemp, O_RDWR, 0);
+
+    if(hIn < 0)
+    {
+bad_file:
+      unlink(pTemp);
+      WBFree(pTemp);
+
+//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
+
+      va_end(va);
+      return NULL;
+    }
+
+    if(write(hIn, szStdInBuf, nLen) != (ssize_t)nLen)
+    {
+      close(hIn);
+      goto bad_file;
+    }
+
+    lseek(hIn, 0, SEEK_SET); // rewind file
+
+//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (3) temp file \"%s\"\n", __FUNCTION__, pTemp);
+  }
+
+  pRval = WBRunResultInternal(hIn, NULL, szAppName, va);
+
+  va_end(va);
+
+  if(pTemp)
+  {
+    close(hIn);
+    unlink(pTemp);
+
+    WBFree(pTemp);
+  }
+
+  return pRval;
+
+#endif // WIN32
+}
+
+
+
+char *WBRunResultWithInput(const char *szStdInBuf, const char *szAppName, ...)
+{
+char *pRval, *pTemp = NULL;
+va_list va;
+#ifdef WIN32
+DWORD cb1;
+#endif // WIN32
+WB_FILE_HANDLE hIn = WB_INVALID_FILE_HANDLE;
+
+
+  va_start(va, szAppName);
+
+  if(szStdInBuf && *szStdInBuf)
+  {
+    unsigned int nLen = strlen(szStdInBuf);
+
+    pTemp = WBTempFile0(".tmp");
+
+    if(!pTemp)
+    {
+//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (1)\n", __FUNCTION__);
+
+      va_end(va);
+      return NULL;
+    }
+
+#ifdef WIN32
+    hIn = CreateFile(pTemp, GENERIC_READ|GENERIC_WRITE,0,NULL,
+                     OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+#else // WIN32
+    hIn = open(pTemp, O_RDWR, 0);
+#endif // WIN32
+
+    if(hIn < 0)
+    {
+bad_file:
+#ifdef WIN32
+      DeleteFile(pTemp);
+#else // WIN32
+      unlink(pTemp);
+#endif // WIN32
+      WBFree(pTemp);
+
+//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
+
+      va_end(va);
+      return NULL;
+    }
+
+    if(
+#ifdef WIN32
+       !WriteFile(hIn, szStdInBuf, nLen, &cb1,NULL)
+        || cb1 != nLen
+#else // WIN32
+       write(hIn, szStdInBuf, nLen) != (ssize_t)nLen
+#endif // WIN32
+       )
+    {
+#ifdef WIN32
+      CloseHandle(hIn);
+#else // WIN32
+      close(hIn);
+#endif // WIN32
+      goto bad_file;
+    }
+
+#ifdef WIN32
+    SetFilePointer(hIn, 0, NULL, FILE_BEGIN);
+#else // WIN32
+    lseek(hIn, 0, SEEK_SET); // rewind file
+#endif // WIN32
+
+//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (3) temp file \"%s\"\n", __FUNCTION__, pTemp);
+  }
+
+  pRval = WBRunResultInternal(hIn, NULL, szAppName, va);
+
+  va_end(va);
+
+  if(pTemp)
+  {
+#ifdef WIN32
+      DeleteFile(pTemp);
+#else // WIN32
+    close(hIn);
+    unlink(pTemp);
+#endif // WIN32
+
+    WBFree(pTemp);
+  }
+
+  return pRval;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                      //
+//   ____   _                            _   _      _  _                                //
+//  / ___| | |__    __ _  _ __  ___   __| | | |    (_)| |__   _ __  __ _  _ __  _   _   //
+//  \___ \ | '_ \  / _` || '__|/ _ \ / _` | | |    | || '_ \ | '__|/ _` || '__|| | | |  //
+//   ___) || | | || (_| || |  |  __/| (_| | | |___ | || |_) || |  | (_| || |   | |_| |  //
+//  |____/ |_| |_| \__,_||_|   \___| \__,_| |_____||_||_.__/ |_|   \__,_||_|    \__, |  //
+//                                                                              |___/   //
+//                                                                                      //
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+WB_MODULE WBLoadLibrary(const char * szModuleName)
+{
+#ifdef WIN32
+  return LoadLibrary(szModuleName);
+#else // !WIN32 aka POSIX
+#ifndef NO_SHARED_LIB_SUPPORT
+  return((WB_MODULE)dlopen(szModuleName, RTLD_LAZY | RTLD_LOCAL));
+#else  // NO_SHARED_LIB_SUPPORT
+  return NULL;
+#endif // NO_SHARED_LIB_SUPPORT
+#endif // WIN3,POSIX
+}
+
+void WBFreeLibrary(WB_MODULE hModule)
+{
+#ifdef WIN32
+  FreeLibrary(hModule);
+#else // !WIN32 aka POSIX
+#ifndef NO_SHARED_LIB_SUPPORT
+  dlclose(hModule);
+#endif // NO_SHARED_LIB_SUPPORT
+#endif // WIN32,POSIX
+}
+
+WB_PROCADDRESS WBGetProcAddress(WB_MODULE hModule, const char *szProcName)
+{
+#ifdef WIN32
+  return GetProcAddress(hModule, szProcName);
+#else // !WIN32 aka POSIX
+#ifndef NO_SHARED_LIB_SUPPORT
+// freebsd has the 'dlfunc' API, which is basically 'dlsym' cast to a function pointer
+#ifdef __FreeBSD__
+  return((WB_PROCADDRESS)dlfunc(hModule, szProcName));
+#else // other POSIX systems - TODO, check for 'dlfunc'/'dlsym' for this particular OS
+  return((WB_PROCADDRESS)dlsym(hModule, szProcName));
+#endif // 'dlfunc' check
+#else  // NO_SHARED_LIB_SUPPORT
+  return NULL;
+#endif // NO_SHARED_LIB_SUPPORT
+#endif // WIN32,POSIX
+}
+
+void * WBGetDataAddress(WB_MODULE hModule, const char *szDataName)
+{
+#ifdef WIN32
+  return (void *)GetProcAddress(hModule, szDataName);
+#else // !WIN32 aka POSIX
+#ifndef NO_SHARED_LIB_SUPPORT
+  return((void *)dlsym(hModule, szDataName));
+#else  // NO_SHARED_LIB_SUPPORT
+  return NULL;
+#endif // NO_SHARED_LIB_SUPPORT
+#endif // WIN32,POSIX
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//   _____  _                            _   ____                                     _     //
+//  |_   _|| |__   _ __  ___   __ _   __| | / ___|  _   _  _ __   _ __    ___   _ __ | |_   //
+//    | |  | '_ \ | '__|/ _ \ / _` | / _` | \___ \ | | | || '_ \ | '_ \  / _ \ | '__|| __|  //
+//    | |  | | | || |  |  __/| (_| || (_| |  ___) || |_| || |_) || |_) || (_) || |   | |_   //
+//    |_|  |_| |_||_|   \___| \__,_| \__,_| |____/  \__,_|| .__/ | .__/  \___/ |_|    \__|  //
+//                                                        |_|    |_|                        //
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+
+WB_THREAD_KEY WBThreadAllocLocal(void)
+{
+#ifdef WIN32
+  return TlsAlloc();
+#else // !WIN32 aka POSIX
+WB_THREAD_KEY keyRval;
+  if(!pthread_key_create(&keyRval, NULL))
+  {
+    return keyRval;
+  }
+
+  return (WB_THREAD_KEY)INVALID_HANDLE_VALUE;
+#endif // WIN32,POSIX
+}
+
+void WBThreadFreeLocal(WB_THREAD_KEY keyVal)
+{
+#ifdef WIN32
+  TlsFree(keyVal);
+#else // !WIN32 aka POSIX
+  pthread_key_delete(keyVal); // TODO:  check return?
+#endif // WIN32,POSIX
+}
+
+void * WBThreadGetLocal(WB_THREAD_KEY keyVal)
+{
+#ifdef WIN32
+  return TlsGetValue(keyVal);
+#else // !WIN32 aka POSIX
+  return pthread_getspecific(keyVal);
+#endif // WIN32,POSIX
+}
+
+void WBThreadSetLocal(WB_THREAD_KEY keyVal, void *pValue)
+{
+#ifdef WIN32
+  TlsSetValue(keyVal, pValue);
+#else // !WIN32 aka POSIX
+  pthread_setspecific(keyVal, pValue);
+#endif // WIN32,POSIX
+}
+
+WB_THREAD WBThreadGetCurrent(void)
+{
+#ifdef WIN32
+  return GetCurrentThreadId();
+#else // !WIN32 aka POSIX
+  return pthread_self();
+#endif // WIN32,POSIX
+}
+
 
-  kill(idRval, SIGKILL); // not so nice way but oh well
-  WBDelay(5000); // wait 5msec
+#ifdef WIN32
+struct WB_THREAD_PROC_PARAM
+{
+  WB_THREAD_PROC pFunction;
+  void *pParam;
+  volatile HANDLE hThread; // becomes NULL as a flag
+};
 
-  close(hP[0]); // done with the pipe - close it now
+DWORD WINAPI W32ThreadCaller(void *pParam0)
+{
+WB_THREAD_PROC pFunction;
+void *pParam;
+HANDLE hThread; // handle to me
+struct WB_THREAD_PROC_PARAM *pP = (struct WB_THREAD_PROC_PARAM *)pParam0;
+DWORD dwRval;
 
-#endif // WIN32
+  pFunction = pP->pFunction;
+  pParam = pP->pParam;
+  hThread = pP->hThread;
 
-//  WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (4) pRval=%p *pRval=%c\n", __FUNCTION__, pRval, (char)(pRval ? *pRval : 0));
+  pP->hThread = NULL; // flag to creator
 
-  return pRval;
+  dwRval = (DWORD)pFunction(pParam);  // do the thread
+
+  CloseHandle(hThread);
+
+  return dwRval;
 }
+#endif // WIN32
 
-int WBGetProcessState(WB_PROCESS_ID idProcess, WB_INT32 *pExitCode)
+WB_THREAD WBThreadCreate(WB_THREAD_PROC function, void *pParam)
 {
+  WB_THREAD thrdRval = WB_INVALID_THREAD;
 #ifdef WIN32
-  int iRval = -1;
-  HANDLE hProcess = idProcess.hProcess; //OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, idProcess);
-  DWORD dwWait, dwTemp = -1;
+  struct WB_THREAD_PROC_PARAM pp;
+  pp.pFunction = function;
+  pp.pParam = pParam;
 
-  if(pExitCode)
-    *pExitCode = -1;;
+  // CreateThread returns a handle
+  // consider calling _beginthreadex and using a wrapper to call _endthreadex
+  pp.hThread = CreateThread(NULL, 0, W32ThreadCaller, &pp, CREATE_SUSPENDED, &thrdRval);
 
-  if(hProcess == INVALID_HANDLE_VALUE)
+  if(pp.hThread) // returns NULL on error
   {
-    if(idProcess.uiProcessID != 0) // for now this indicates valid.  process 0 is inaccessible
-      return idProcess.iCachedExitCode; // return cached value
+    ResumeThread(pp.hThread);  // thread proc wrapper closes it
 
-    return -1;
+    while(pp.hThread) // assigned 0 when safe for this function to return
+      Sleep(0); // this should happen quickly
+
+    return thrdRval;
   }
+#else // !WIN32 aka POSIX
 
-  dwWait = WaitForMultipleObjects(1, &hProcess, FALSE, 10);
+  // TODO:  call my own thread startup proc, passing a struct that contains
+  //        'function' and 'pParam' as the param.  use a linked list of
+  //        pre-allocated buffers for that.
+  // see possible implementation, above
 
-  if(dwWait == WAIT_TIMEOUT)
-  {
-    iRval = 1; // still running
-  }
-  else if(dwWait == WAIT_OBJECT_0) // process has stopped
-  {
-    iRval = 0;
-  }
-  else // if(dwWait == WAIT_ABANDONED_0)
+  if(!pthread_create(&thrdRval, NULL, function, pParam))
   {
-    iRval = -1;  // like 'quit' baby, quit!
+    return thrdRval;
   }
+#endif // WIN32,POSIX
 
-  if(!iRval)
+  return WB_INVALID_THREAD;
+}
+
+void *WBThreadWait(WB_THREAD hThread)        // closes hThread, returns exit code, waits for thread to terminate (blocks)
+{
+#ifdef WIN32
+  HANDLE hT = OpenThread(READ_CONTROL|SYNCHRONIZE,FALSE,hThread);
+  if(hT)
   {
-    if(GetExitCodeProcess(hProcess, &dwTemp))
-    {
-      if(pExitCode)
-        *pExitCode = dwTemp;
-      idProcess.iCachedExitCode = dwTemp;
-    }
-    else
-    {
-      iRval = -1; // oops
-    }
+    DWORD dwR;
+    WaitForSingleObject(hT, INFINITE);
 
-    CloseHandle(idProcess.hProcess); // clean up
-    idProcess.hProcess = INVALID_HANDLE_VALUE; //  because I closed it
+    GetExitCodeThread(hT, &dwR);
+    CloseHandle(hT);
+    return (void *)dwR;
   }
 
-//  CloseHandle(hProcess);
-  return iRval;
-
-#else // WIN32
-  int iStat, iRval;
+  return NULL;
+#else // !WIN32 aka POSIX
+void *pRval = NULL;
 
-  // for waitpid(), if WNOHANG is specified and there are no stopped, continued or exited children, 0 is returned
+  if(pthread_join(hThread, &pRval))
+  {
+    // TODO:  error return??
+    pRval = (void *)-1;
+  }
 
-  iStat = 0;
-  iRval = waitpid(idProcess, &iStat, WNOHANG); // note this might return non-zero for stopped or continued processes
+  return pRval;
+#endif // WIN32,POSIX
+}
 
-  if(iRval > 0 && (iRval == (int)idProcess || (int)idProcess == -1 || (int)idProcess == 0))
+int WBThreadRunning(WB_THREAD hThread)        // >0 if thread is running, <0 error - use 'pthread_kill(thread,0)' which returns ESRCH if terminated i.e. 'PS_DEAD'
+{
+int iR = -1;
+#ifdef WIN32
+  // use 'WaitForSingleObject with 0 timeout
+  HANDLE hT = OpenThread(READ_CONTROL|SYNCHRONIZE,FALSE,hThread);
+  if(hT)
   {
-    if(WIFEXITED(iStat))                   // test if process exits also.
-    {
-      if(pExitCode)
-      {
-        *pExitCode = (WB_INT32)WEXITSTATUS(iStat);
-      }
+    DWORD dwR = WaitForSingleObject(hT, 0);
+    if(dwR == WAIT_TIMEOUT)
+      iR = 1;
+    else if(dwR == WAIT_OBJECT_0)
+      iR = 0;
+    else
+      iR = -1;
 
-      return 0; // not running
-    }
+    CloseHandle(hT);
+  }
+  return iR;
+#else // !WIN32 aka POSIX
+  iR = pthread_kill(hThread,0);
 
-    return 1; // still running
+  if(!iR)
+  {
+    return 1; // no signal sent, handle is valid (and did not exit)
   }
 
-  if(iRval > 0)
+  if(iR == ESRCH)
   {
-    WB_ERROR_PRINT("ERROR:  %s - waitpid returns %d, but does not match %d\n",
-                   __FUNCTION__, iRval, (int)idProcess);
+    return 0; // for now, allow this to indicate 'done'
   }
 
-  return -1; // error
-#endif // WIN32
+  return -1;
+#endif // WIN32,POSIX
 }
 
-char *WBRunResult(const char *szAppName, ...)
+void WBThreadExit(void *pRval)
 {
-char *pRval;
-va_list va;
-
-
-  va_start(va, szAppName);
-
-  pRval = WBRunResultInternal(WB_INVALID_FILE_HANDLE, NULL, szAppName, va);
-
-  va_end(va);
-
-  return pRval;
+#ifdef WIN32
+#else // !WIN32 aka POSIX
+  pthread_exit(pRval);
+#endif // WIN32,POSIX
 }
 
-char *WBRunResult2(const char *szAppName, ...)
+void WBThreadClose(WB_THREAD hThread)
 {
-char *pRval;
-int32_t nExitCode;
-va_list va;
-
+#ifdef WIN32
+#else // !WIN32 aka POSIX
+  pthread_detach(hThread);
+#endif // WIN32,POSIX
+}
 
-  va_start(va, szAppName);
 
-  pRval = WBRunResultInternal(INVALID_HANDLE_VALUE, &nExitCode, szAppName, va);
 
-  if(pRval && nExitCode)
-  {
-//    fprintf(stderr, "%s - %s ended with error code %d\n", __FUNCTION__, szAppName, nExitCode);
-//    fflush(stderr);
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                                               //
+//    ____                   _  _  _    _                         _                _   __  __         _                          //
+//   / ___| ___   _ __    __| |(_)| |_ (_)  ___   _ __   ___     / \    _ __    __| | |  \/  | _   _ | |_  ___ __  __ ___  ___   //
+//  | |    / _ \ | '_ \  / _` || || __|| | / _ \ | '_ \ / __|   / _ \  | '_ \  / _` | | |\/| || | | || __|/ _ \\ \/ // _ \/ __|  //
+//  | |___| (_) || | | || (_| || || |_ | || (_) || | | |\__ \  / ___ \ | | | || (_| | | |  | || |_| || |_|  __/ >  <|  __/\__ \  //
+//   \____|\___/ |_| |_| \__,_||_| \__||_| \___/ |_| |_||___/ /_/   \_\|_| |_| \__,_| |_|  |_| \__,_| \__|\___|/_/\_\\___||___/  //
+//                                                                                                                               //
+//                                                                                                                               //
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    free(pRval);
-    pRval = NULL;
-  }
+#ifndef WIN32
 
-  va_end(va);
+// A 'WB_COND' is a latching 'auto-reset event' stored in a single WB_UINT32 (1 if signaled).  Rather than
+// polling it, waiters sleep on one of a small, fixed set of pthread condition variables that is selected by
+// hashing the address of the WB_COND.  A signal sets the flag and broadcasts the bucket's condition, so the
+// waiter wakes immediately.  Because the condition variables are never created or destroyed along with the
+// WB_COND itself, WBCondFree() can still safely wake anything that is waiting on it, and a signal that arrives
+// before the wait begins is not lost (same as before).  This is essentially a portable 'futex'.
 
-  return pRval;
-}
+#define WB_COND_BUCKET_COUNT 16 /* must be a power of 2 */
 
-#ifdef WIN32
-struct __RunResult3_worker_thread_params
+typedef struct __WB_COND_BUCKET__
 {
-  volatile HANDLE hStdin[2];  // pipe for STDIN
-  const void * pStdin;
-  int cbStdin;
-  volatile HANDLE hThread;
-  volatile unsigned int dwThreadID;
-  volatile int bStateFlag; // 0 = not running, 1 = running, -1 force stop
-};
+  pthread_mutex_t mtx;  // protects the WB_COND flags that hash to this bucket
+  pthread_cond_t cond;  // broadcast whenever one of those flags is set
+  int nWaiters;         // number of threads waiting on 'cond' (no broadcast needed when zero)
+} WB_COND_BUCKET;
 
-static unsigned int __stdcall __RunResult3_worker_thread(void *pData)
+static WB_COND_BUCKET aCondBuckets[WB_COND_BUCKET_COUNT];
+static pthread_once_t xCondBucketOnce = PTHREAD_ONCE_INIT;
+
+static void __CondBucketInit(void)
 {
-int i2;
-const BYTE *p1;
-DWORD cb1, cbData;
-HANDLE hTemp;
-struct __RunResult3_worker_thread_params *pParams = (struct __RunResult3_worker_thread_params *)pData;
+pthread_condattr_t attr;
+int i1, bAttr;
 
-  // so long as the process is alive, write data to the pipe
-#define RUNRESULT3_BUFFER_LENGTH 256
-  pParams->bStateFlag = 1; // indicates I'm running
 
-  p1 = (const BYTE *)pParams->pStdin;
-  cbData = pParams->cbStdin;
+  // the condition variables use CLOCK_MONOTONIC so that a change to the system time won't affect timeouts
 
-  while(cbData && pParams->dwThreadID)
+  bAttr = !pthread_condattr_init(&attr);
+
+  if(bAttr)
   {
-    cb1 = 0;
-     // if buffer empty, fill it
-#if 0
-    if(!PeekNamedPipe(pParams->hStdin[0], NULL, 0, NULL, &cb1, NULL))
-    {
-      goto check_pipe_io_error;
-    }
-    else if(cb1 > RUNRESULT3_BUFFER_LENGTH / 2)
-    {
-      Sleep(20);
-    }
-    else
-#endif // 0
-    {
-      i2 = RUNRESULT3_BUFFER_LENGTH - cb1; // available write space
-      if(i2 > (int)cbData)
-        i2 = cbData;
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_PRIVATE);
+  }
 
-      if(!WriteFile(pParams->hStdin[1], p1, i2, &cb1, NULL))
-      {
-        DWORD dwErr;
-#if 0
-check_pipe_io_error:
-#endif // 0
+  for(i1=0; i1 < WB_COND_BUCKET_COUNT; i1++)
+  {
+    pthread_mutex_init(&(aCondBuckets[i1].mtx), NULL);
+    pthread_cond_init(&(aCondBuckets[i1].cond), bAttr ? &attr : NULL);
 
-        dwErr = GetLastError();
+    aCondBuckets[i1].nWaiters = 0;
+  }
 
-        if(dwErr == ERROR_MORE_DATA || dwErr == ERROR_PIPE_BUSY || dwErr == ERROR_IO_PENDING
-           || dwErr == ERROR_NO_MORE_ITEMS/* EAGAIN */ )
-        {
-          Sleep(10); // wait 1/2 msec
-        }
-        else
-        {
-          break; // an error of some kind, so bail out [pipe closed?]
-        }
-      }
-      else if(!cb1)  // this just might be an error
-      {
-        // TODO: anything?
-        Sleep(50);
-      }
-      else
-      {
-        p1 += cb1; // point past the # of bytes I just read in
-        cbData -= cb1;
-      }
-    }
+  if(bAttr)
+  {
+    pthread_condattr_destroy(&attr);
   }
+}
 
-  Sleep(10); // wait 10 msec
+static WB_COND_BUCKET * __CondBucket(const volatile WB_COND *pCond)
+{
+WB_UINT32 uiKey = (WB_UINT32)((unsigned long)pCond >> 2);
 
-  // close my end of the pipe
-  hTemp = pParams->hStdin[1];
-  pParams->hStdin[1] = INVALID_HANDLE_VALUE;
-  CloseHandle(hTemp);
 
-  hTemp = pParams->hStdin[0];
-  pParams->hStdin[0] = INVALID_HANDLE_VALUE;
-  CloseHandle(hTemp);
+  pthread_once(&xCondBucketOnce, __CondBucketInit);
 
-  // mark as 'exited'
-  pParams->bStateFlag = -1; // indicates I'm ending
-  _endthreadex(0);
-  return 0;
-}
-#endif // WIN32
+  uiKey *= 0x9e3779b1U; // Fibonacci hash
 
+  return aCondBuckets + ((uiKey ^ (uiKey >> 15)) & (WB_COND_BUCKET_COUNT - 1));
+}
 
-char *RunResult3(const void *pStdin, int cbStdin, const char *szAppName, ...) // windows-specific
+static void __CondSetSignal(volatile WB_COND *pCond)
 {
-#ifdef WIN32
-char *pRval;
-INT32 nExitCode;
-va_list va;
-struct __RunResult3_worker_thread_params xParams = {{INVALID_HANDLE_VALUE,INVALID_HANDLE_VALUE},
-                                                    NULL, 0, INVALID_HANDLE_VALUE, 0, 0 };
+WB_COND_BUCKET *pB = __CondBucket(pCond);
 
 
-  va_start(va, szAppName);
+  pthread_mutex_lock(&(pB->mtx));
 
-  // create a pipe and worker thread for stdin using pStdin and cbStdin
+  *pCond = 1; // this is my trigger
 
-  if(!CreatePipe((HANDLE *)&(xParams.hStdin[0]), (HANDLE *)&(xParams.hStdin[1]), NULL, 0))
+  if(pB->nWaiters)
   {
-//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
-    return NULL;
+    pthread_cond_broadcast(&(pB->cond)); // the bucket is shared, so everyone checks their own flag
   }
 
-  SetHandleInformation(xParams.hStdin[0], HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+  pthread_mutex_unlock(&(pB->mtx));
+}
 
-  // start worker thread
-  xParams.hThread = (HANDLE)_beginthreadex(NULL, 65536, __RunResult3_worker_thread,
-                                           &xParams, CREATE_SUSPENDED,
-                                           (unsigned int *)&xParams.dwThreadID);
+// calculate an absolute time 'nTimeout' microseconds from now, using the specified clock
+static void __TimeoutToTimespec(clockid_t clk, int nTimeout, struct timespec *pTS)
+{
+  clock_gettime(clk, pTS);
 
-  if(xParams.hThread == INVALID_HANDLE_VALUE)
+  pTS->tv_sec += nTimeout / 1000000;
+  pTS->tv_nsec += (nTimeout % 1000000) * 1000L;
+
+  if(pTS->tv_nsec >= 1000000000L)
   {
-//    WB_ERROR_PRINT("* ERROR * - unable to create thread, %d (%x) (a)\n",
-//                   GetLastError(), GetLastError());
-    goto error_exit;
+    pTS->tv_sec++;
+    pTS->tv_nsec -= 1000000000L;
   }
+}
 
-  xParams.pStdin = pStdin;
-  xParams.cbStdin = cbStdin;
+#endif // !WIN32
 
-  ResumeThread(xParams.hThread);
+int WBCondCreate(WB_COND *pCond)
+{
+int iRval = -1;
 
-  while(xParams.dwThreadID && xParams.bStateFlag == 0)
-    Sleep(10); // wait for it to begin (avoid race condition if program does not start)
+  if(pCond)
+  {
+#ifdef WIN32
+    // because of problems under Windows, this will be defined as 'unsigned int'
+    // and I'll use the increment/decrement interlock functions and wait loops to
+    // monitor the signaling.
 
-  pRval = WBRunResultInternal(xParams.hStdin[0], &nExitCode, szAppName, va);
+    *pCond = 0;
 
-  // wait for worker thread close
+    iRval = 0; // success!
+#else  // WIN23
 
-  if(pRval && nExitCode)
+    // the flag itself is the condition; waiters block on a shared pthread_cond (see __CondBucket)
+
+    *pCond = 0;
+
+    iRval = 0; // success!
+#endif // WIN32
+  }
+
+  return iRval;
+}
+
+int WBMutexCreate(WB_MUTEX *pMtx)
+{
+  if(pMtx)
   {
-#ifdef _DEBUG
+#ifdef WIN32
+#else  // WIN23
+    if(!pthread_mutex_init(pMtx, NULL))
     {
-      char tbuf[1024];
-      _sntprintf(tbuf, sizeof(tbuf), "%s ended with error code %d\n", szAppName, nExitCode);
-#ifdef __cplusplus
-      ::MessageBox
-#else // __cplusplus
-      MessageBox
-#endif // __cplusplus
-        (NULL, tbuf, "** EXTERNAL APPLICATION ERROR **", MB_OK |  MB_ICONERROR);
-      OutputDebugString(pRval);
+      return 0;
     }
-#endif _DEBUG
+#endif // WIN32
+  }
 
-    free(pRval);
-    pRval = NULL;
+  return -1;
+}
+
+
+void WBCondFree(WB_COND *pCond)
+{
+#ifdef WIN32
+//  CloseHandle(*pCond);
+  if(pCond)
+  {
+    *pCond = 1; // forces a waiting thread to signal (though only one will probably do it)
   }
+#else  // WIN23
+  if(pCond)
+  {
+    // there is no per-condition resource to free, but a waiting thread needs to wake up
 
-  va_end(va);
+    __CondSetSignal(pCond); // forces a waiting thread to signal (though only one will probably do it)
+  }
+#endif // WIN32
+}
 
-error_exit:
+void WBMutexFree(WB_MUTEX *pMtx)
+{
+#ifdef WIN32
+  CloseHandle(*pMtx);
+#else  // WIN23
+  pthread_mutex_destroy(pMtx);
+#endif // WIN32
+}
 
-  xParams.dwThreadID = 0; // tells thread to exit
+int WBMutexLock(WB_MUTEX *pMtx, int nTimeout)
+{
+int iRval;
+#ifdef WIN32
+#else  // WIN23
+struct timespec ts;
 
-  if(xParams.hThread != INVALID_HANDLE_VALUE)
+  if(nTimeout < 0)
   {
-    while(xParams.bStateFlag > 0)
-      Sleep(10); // wait for it to end
+    iRval = pthread_mutex_lock(pMtx);
 
-    CloseHandle(xParams.hThread);
+    return iRval ? -1 : 0; // either an error, or success [but never a timeout]
   }
 
-  if(xParams.hStdin[1] != INVALID_HANDLE_VALUE)
-    CloseHandle(xParams.hStdin[1]);
+  iRval = pthread_mutex_trylock(pMtx); // the most common case, and the only one for a zero timeout
 
-  if(xParams.hStdin[0] != INVALID_HANDLE_VALUE)
-    CloseHandle(xParams.hStdin[0]);
+  if(iRval == EBUSY && nTimeout > 0)
+  {
+    // pthread_mutex_timedlock always uses CLOCK_REALTIME for the absolute time
 
-  return pRval;
+    __TimeoutToTimespec(CLOCK_REALTIME, nTimeout, &ts);
 
-#else // WIN32
+    do
+    {
+      iRval = pthread_mutex_timedlock(pMtx, &ts);
+    } while(iRval == EINTR);
+  }
 
-char *pRval, *pTemp = NULL;
-va_list va;
-WB_FILE_HANDLE hIn = WB_INVALID_FILE_HANDLE;
+  if(!iRval)
+  {
+    return 0;
+  }
+  else if(iRval == EBUSY || iRval == ETIMEDOUT)
+  {
+    return 1; // timed out
+  }
+#endif // WIN32
 
+  return -1; // an error
+}
 
-  va_start(va, szAppName);
+int WBMutexUnlock(WB_MUTEX *pMtx)
+{
+#ifdef WIN32
+#else  // WIN23
+  return pthread_mutex_unlock(pMtx);
+#endif // WIN32
+}
 
-  if(pStdin && cbStdin > 0)
+
+int WBCondSignal(WB_COND *pCond)
+{
+  if(pCond)
   {
-    unsigned int nLen = cbStdin;
-    const unsigned char *szStdInBuf = (const unsigned char *)pStdin;
+#ifdef WIN32
+    WBInterlockedExchange(pCond, 1); // assign to 1 [this is my trigger]
+#else  // WIN23
+    __CondSetSignal(pCond); // assign to 1 and wake up anything that's waiting on it
+#endif // WIN32
+    return 0;
+  }
 
-    pTemp = WBTempFile0(".tmp");
+  return -1;
+}
 
-    if(!pTemp)
+int WBCondWait(WB_COND *pCond, int nTimeout)
+{
+int iRval = -1;
+#ifndef WIN32
+WB_COND_BUCKET *pB;
+struct timespec ts;
+#endif // !WIN32
+
+  if(!pCond)
+  {
+    WB_ERROR_PRINT("TEMPORARY: %s - returns -1 (NULL pCond)\n", __FUNCTION__);
+
+    return -1;
+  }
+
+#ifdef WIN32
+  if(nTimeout >= 0)
+  {
+    WB_UINT64 ullTime = WBGetTimeIndex();
+
+    iRval = 0;
+
+    while(!WBInterlockedExchange(pCond, 0)) // if return is zero, it wasn't 'signaled'
     {
-//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (1)\n", __FUNCTION__);
+      if((WBGetTimeIndex() - ullTime) > (WB_UINT64)nTimeout)
+      {
+        iRval = ETIMEDOUT; // timeout error
+        break;
+      }
 
-      va_end(va);
-      return NULL;
+      WBDelay(50);
+    }
+  }
+  else
+  {
+    while(!WBInterlockedExchange(pCond, 0)) // if return is zero, it wasn't 'signaled'
+    {
+      WBDelay(100);
     }
 
-    hIn = open(pTemp, O_RDWR, 0);
+    iRval = 0;
+  }
+#else // WIN32
+
+  pB = __CondBucket(pCond);
+
+  if(nTimeout > 0)
+  {
+    __TimeoutToTimespec(CLOCK_MONOTONIC, nTimeout, &ts); // matches the clock assigned in __CondBucketInit
+  }
+
+  pthread_mutex_lock(&(pB->mtx));
+
+  iRval = 0;
 
-    if(hIn < 0)
+  while(!*pCond) // if it's zero, it wasn't 'signaled'
+  {
+    if(!nTimeout)
     {
-bad_file:
-      unlink(pTemp);
-      WBFree(pTemp);
+      iRval = ETIMEDOUT; // zero timeout means 'just check it'
+      break;
+    }
 
-//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
+    pB->nWaiters++;
 
-      va_end(va);
-      return NULL;
+    if(nTimeout < 0)
+    {
+      iRval = pthread_cond_wait(&(pB->cond), &(pB->mtx));
     }
-
-    if(write(hIn, szStdInBuf, nLen) != (ssize_t)nLen)
+    else
     {
-      close(hIn);
-      goto bad_file;
+      iRval = pthread_cond_timedwait(&(pB->cond), &(pB->mtx), &ts);
     }
 
-    lseek(hIn, 0, SEEK_SET); // rewind file
+    pB->nWaiters--;
 
-//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (3) temp file \"%s\"\n", __FUNCTION__, pTemp);
-  }
+    if(iRval == ETIMEDOUT)
+    {
+      if(*pCond) // signaled at the last moment, so it's not a timeout
+      {
+        iRval = 0;
+      }
 
-  pRval = WBRunResultInternal(hIn, NULL, szAppName, va);
+      break;
+    }
+    else if(iRval && iRval != EINTR)
+    {
+      WB_ERROR_PRINT("ERROR:  %s - pthread_cond_wait error %d\n", __FUNCTION__, iRval);
 
-  va_end(va);
+      iRval = -1;
+      break;
+    }
 
-  if(pTemp)
-  {
-    close(hIn);
-    unlink(pTemp);
+    iRval = 0; // spurious wakeup, or someone else's signal - check again
+  }
 
-    WBFree(pTemp);
+  if(!iRval)
+  {
+    *pCond = 0; // consume the signal (auto-reset, like an 'Event')
   }
 
-  return pRval;
+  pthread_mutex_unlock(&(pB->mtx));
 
 #endif // WIN32
-}
-
 
+  return iRval;
+}
 
-char *WBRunResultWithInput(const char *szStdInBuf, const char *szAppName, ...)
+int WBCondWaitMutex(WB_COND *pCond, WB_MUTEX *pMtx, int nTimeout)
 {
-char *pRval, *pTemp = NULL;
-va_list va;
-#ifdef WIN32
-DWORD cb1;
-#endif // WIN32
-WB_FILE_HANDLE hIn = WB_INVALID_FILE_HANDLE;
+int iRval;
 
+  if(!pCond || !pMtx)
+    return -1;
 
-  va_start(va, szAppName);
+  // NOTE:  the signal latches, so one that arrives between unlocking 'pMtx' and the start of
+  //        the wait is not lost.  Therefore it's safe to release the caller's mutex first.
 
-  if(szStdInBuf && *szStdInBuf)
-  {
-    unsigned int nLen = strlen(szStdInBuf);
+  WBMutexUnlock(pMtx);
 
-    pTemp = WBTempFile0(".tmp");
+  iRval = WBCondWait(pCond, nTimeout);
 
-    if(!pTemp)
-    {
-//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (1)\n", __FUNCTION__);
+  WBMutexLock(pMtx, -1); // this is a safe way of replicating the behavior [wait infinitely on mutex]
 
-      va_end(va);
-      return NULL;
-    }
+  return iRval;
+}
 
-#ifdef WIN32
-    hIn = CreateFile(pTemp, GENERIC_READ|GENERIC_WRITE,0,NULL,
-                     OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
-#else // WIN32
-    hIn = open(pTemp, O_RDWR, 0);
-#endif // WIN32
 
-    if(hIn < 0)
-    {
-bad_file:
+unsigned int WBInterlockedDecrement(volatile unsigned int *pValue)
+{
 #ifdef WIN32
-      DeleteFile(pTemp);
-#else // WIN32
-      unlink(pTemp);
-#endif // WIN32
-      WBFree(pTemp);
+  return InterlockedDecrement(pValue);
+#else // !WIN32
+unsigned int iRval;
 
-//      WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (2)\n", __FUNCTION__);
+  pthread_rwlock_wrlock(&xInterlockedRWLock);
 
-      va_end(va);
-      return NULL;
-    }
+  (*pValue)++;
+  iRval = *pValue;
 
-    if(
-#ifdef WIN32
-       !WriteFile(hIn, szStdInBuf, nLen, &cb1,NULL)
-        || cb1 != nLen
-#else // WIN32
-       write(hIn, szStdInBuf, nLen) != (ssize_t)nLen
-#endif // WIN32
-       )
-    {
-#ifdef WIN32
-      CloseHandle(hIn);
-#else // WIN32
-      close(hIn);
+  pthread_rwlock_unlock(&xInterlockedRWLock);
+
+  return iRval;
 #endif // WIN32
-      goto bad_file;
-    }
+}
 
+unsigned int WBInterlockedIncrement(volatile unsigned int *pValue)
+{
 #ifdef WIN32
-    SetFilePointer(hIn, 0, NULL, FILE_BEGIN);
-#else // WIN32
-    lseek(hIn, 0, SEEK_SET); // rewind file
-#endif // WIN32
+  return InterlockedIncrement(pValue);
+#else // !WIN32
+unsigned int iRval;
 
-//    WB_ERROR_PRINT("TEMPORARY:  %s HERE I AM (3) temp file \"%s\"\n", __FUNCTION__, pTemp);
-  }
+  pthread_rwlock_wrlock(&xInterlockedRWLock);
 
-  pRval = WBRunResultInternal(hIn, NULL, szAppName, va);
+  (*pValue)++;
+  iRval = *pValue;
 
-  va_end(va);
+  pthread_rwlock_unlock(&xInterlockedRWLock);
 
-  if(pTemp)
-  {
-#ifdef WIN32
-      DeleteFile(pTemp);
-#else // WIN32
-    close(hIn);
-    unlink(pTemp);
+  return iRval;
 #endif // WIN32
-
-    WBFree(pTemp);
-  }
-
-  return pRval;
 }
 
+unsigned int WBInterlockedExchange(volatile unsigned int *pValue, unsigned int nNewVal)
+{
+#ifdef WIN32
+  return InterlockedExchange(pValue, nNewVal); // pretty sure this is right...
+#else // !WIN32
+unsigned int iRval;
 
-//////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                      //
-//   ____   _                            _   _      _  _                                //
-//  / ___| | |__    __ _  _ __  ___   __| | | |    (_)| |__   _ __  __ _  _ __  _   _   //
-//  \___ \ | '_ \  / _` || '__|/ _ \ / _` | | |    | || '_ \ | '__|/ _` || '__|| | | |  //
-//   ___) || | | || (_| || |  |  __/| (_| | | |___ | || |_) || |  | (_| || |   | |_| |  //
-//  |____/ |_| |_| \__,_||_|   \___| \__,_| |_____||_||_.__/ |_|   \__,_||_|    \__, |  //
-//                                                                              |___/   //
-//                                                                                      //
-//////////////////////////////////////////////////////////////////////////////////////////
+  pthread_rwlock_wrlock(&xInterlockedRWLock);
 
+  iRval = *pValue;
+  *pValue = nNewVal;
 
-WB_MODULE WBLoadLibrary(const char * szModuleName)
-{
-#ifdef WIN32
-  return LoadLibrary(szModuleName);
-#else // !WIN32 aka POSIX
-#ifndef NO_SHARED_LIB_SUPPORT
-  return((WB_MODULE)dlopen(szModuleName, RTLD_LAZY | RTLD_LOCAL));
-#else  // NO_SHARED_LIB_SUPPORT
-  return NULL;
-#endif // NO_SHARED_LIB_SUPPORT
-#endif // WIN3,POSIX
+  pthread_rwlock_unlock(&xInterlockedRWLock);
+
+  return iRval;
+#endif // WIN32
 }
 
-void WBFreeLibrary(WB_MODULE hModule)
+unsigned int WBInterlockedRead(volatile unsigned int *pValue)
 {
 #ifdef WIN32
-  FreeLibrary(hModule);
-#else // !WIN32 aka POSIX
-#ifndef NO_SHARED_LIB_SUPPORT
-  dlclose(hModule);
-#endif // NO_SHARED_LIB_SUPPORT
-#endif // WIN32,POSIX
+  return *pValue; // for now; later, there might be a better way
+#else // !WIN32
+unsigned int iRval;
+
+  pthread_rwlock_rdlock(&xInterlockedRWLock); // this only does a read lock
+
+  iRval = *pValue;
+
+  pthread_rwlock_unlock(&xInterlockedRWLock);
+
+  return iRval;
+#endif // WIN32
 }
 
-WB_PROCADDRESS WBGetProcAddress(WB_MODULE hModule, const char *szProcName)
+
+// Worker thread pool
+//
+// Each worker has its own deque (a ring buffer with its own mutex).  The owner pushes and pops at the
+// 'tail' end (most recent first, which is cache-friendly for tasks that submit sub-tasks) and idle workers
+// steal from the 'head' end (oldest first) of the other workers' deques.  Tasks submitted from outside of
+// the pool are distributed round-robin.  Idle workers sleep on a condition variable, and finished tasks
+// are posted to the application as WB_TASK events (WBPostAppEvent can be called from any thread).  Until
+// the event is dispatched, the task stays on a completion list that the pool owns, and the event carries its
+// completion ID rather than a pointer (so nothing can expire or dangle while the event is queued).
+
+#define WB_TASK_QUEUE_INITIAL_SIZE 64 /* must be a power of 2 */
+
+typedef struct __WB_TASK__
 {
-#ifdef WIN32
-  return GetProcAddress(hModule, szProcName);
-#else // !WIN32 aka POSIX
-#ifndef NO_SHARED_LIB_SUPPORT
-// freebsd has the 'dlfunc' API, which is basically 'dlsym' cast to a function pointer
-#ifdef __FreeBSD__
-  return((WB_PROCADDRESS)dlfunc(hModule, szProcName));
-#else // other POSIX systems - TODO, check for 'dlfunc'/'dlsym' for this particular OS
-  return((WB_PROCADDRESS)dlsym(hModule, szProcName));
-#endif // 'dlfunc' check
-#else  // NO_SHARED_LIB_SUPPORT
-  return NULL;
-#endif // NO_SHARED_LIB_SUPPORT
-#endif // WIN32,POSIX
+  WB_TASK_PROC pProc;          // task proc (worker thread)
+  WB_TASK_CALLBACK pCallback;  // completion callback (UI thread)
+  void *pParam;                // parameter for both
+  void *pResult;               // return value from pProc
+  volatile int iState;         // WBTaskStateEnum
+  volatile int bCancel;        // set by WBTaskCancel or WBThreadPoolExit
+  int nRefCount;               // the caller's handle plus the pool's reference (xTaskPoolMutex)
+  unsigned long ulDoneID;      // completion ID, while it's on the completion list (xTaskPoolMutex)
+  struct __WB_TASK__ *pNextDone; // next task on the completion list (xTaskPoolMutex)
+} WB_TASK_ENTRY;
+
+typedef struct __WB_TASK_QUEUE__
+{
+  pthread_mutex_t mtx;         // protects everything below
+  WB_TASK *pTasks;             // ring buffer of tasks
+  unsigned int nMax;           // size of 'pTasks', always a power of 2
+  unsigned int nHead, nTail;   // steal from 'nHead', owner pushes and pops at 'nTail'
+} WB_TASK_QUEUE;
+
+static pthread_mutex_t xTaskPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t xTaskPoolWork = PTHREAD_COND_INITIALIZER; // workers wait for work on this
+static pthread_cond_t xTaskPoolDone = PTHREAD_COND_INITIALIZER; // WBTaskWait waits on this
+static WB_TASK_QUEUE *pTaskQueues = NULL;      // one per worker
+static WB_THREAD *pTaskThreads = NULL;         // the worker threads
+static int nTaskThreads = 0;                   // number of workers (0 if the pool isn't running)
+static int nTaskPending = 0;                   // number of tasks in all of the queues (xTaskPoolMutex)
+static int bTaskPoolExit = 0;                  // workers exit when this is set (xTaskPoolMutex)
+static volatile unsigned int uiTaskNextQueue = 0; // round-robin queue for tasks submitted from outside the pool
+static WB_TASK pTaskDoneHead = NULL;           // completion list, oldest first (xTaskPoolMutex)
+static WB_TASK *ppTaskDoneTail = &pTaskDoneHead;
+static unsigned long ulTaskNextDoneID = 0;     // last completion ID that was assigned (xTaskPoolMutex)
+
+
+static void __TaskRelease(WB_TASK pTask) // xTaskPoolMutex must be locked
+{
+  if(--(pTask->nRefCount) <= 0)
+  {
+    WBFree(pTask);
+  }
 }
 
-void * WBGetDataAddress(WB_MODULE hModule, const char *szDataName)
+static int __TaskQueuePush(WB_TASK_QUEUE *pQ, WB_TASK pTask)
 {
-#ifdef WIN32
-  return (void *)GetProcAddress(hModule, szDataName);
-#else // !WIN32 aka POSIX
-#ifndef NO_SHARED_LIB_SUPPORT
-  return((void *)dlsym(hModule, szDataName));
-#else  // NO_SHARED_LIB_SUPPORT
-  return NULL;
-#endif // NO_SHARED_LIB_SUPPORT
-#endif // WIN32,POSIX
-}
+WB_TASK *pNew;
+unsigned int i1, nCount;
 
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                          //
-//   _____  _                            _   ____                                     _     //
-//  |_   _|| |__   _ __  ___   __ _   __| | / ___|  _   _  _ __   _ __    ___   _ __ | |_   //
-//    | |  | '_ \ | '__|/ _ \ / _` | / _` | \___ \ | | | || '_ \ | '_ \  / _ \ | '__|| __|  //
-//    | |  | | | || |  |  __/| (_| || (_| |  ___) || |_| || |_) || |_) || (_) || |   | |_   //
-//    |_|  |_| |_||_|   \___| \__,_| \__,_| |____/  \__,_|| .__/ | .__/  \___/ |_|    \__|  //
-//                                                        |_|    |_|                        //
-//                                                                                          //
-//////////////////////////////////////////////////////////////////////////////////////////////
+  pthread_mutex_lock(&(pQ->mtx));
+
+  nCount = pQ->nTail - pQ->nHead;
+
+  if(nCount >= pQ->nMax) // full, so double the size (and 'unwrap' it)
+  {
+    pNew = (WB_TASK *)WBAlloc(sizeof(*pNew) * pQ->nMax * 2);
+
+    if(!pNew)
+    {
+      pthread_mutex_unlock(&(pQ->mtx));
+      return -1;
+    }
+
+    for(i1=0; i1 < nCount; i1++)
+    {
+      pNew[i1] = pQ->pTasks[(pQ->nHead + i1) & (pQ->nMax - 1)];
+    }
+
+    WBFree(pQ->pTasks);
+
+    pQ->pTasks = pNew;
+    pQ->nMax *= 2;
+    pQ->nHead = 0;
+    pQ->nTail = nCount;
+  }
 
+  pQ->pTasks[(pQ->nTail++) & (pQ->nMax - 1)] = pTask;
 
-WB_THREAD_KEY WBThreadAllocLocal(void)
+  pthread_mutex_unlock(&(pQ->mtx));
+
+  return 0;
+}
+
+static WB_TASK __TaskQueuePop(WB_TASK_QUEUE *pQ, int bSteal)
 {
-#ifdef WIN32
-  return TlsAlloc();
-#else // !WIN32 aka POSIX
-WB_THREAD_KEY keyRval;
-  if(!pthread_key_create(&keyRval, NULL))
+WB_TASK pRval = NULL;
+
+
+  pthread_mutex_lock(&(pQ->mtx));
+
+  if(pQ->nTail != pQ->nHead)
   {
-    return keyRval;
+    if(bSteal)
+    {
+      pRval = pQ->pTasks[(pQ->nHead++) & (pQ->nMax - 1)]; // oldest
+    }
+    else
+    {
+      pRval = pQ->pTasks[(--(pQ->nTail)) & (pQ->nMax - 1)]; // newest
+    }
   }
 
-  return (WB_THREAD_KEY)INVALID_HANDLE_VALUE;
-#endif // WIN32,POSIX
-}
+  pthread_mutex_unlock(&(pQ->mtx));
 
-void WBThreadFreeLocal(WB_THREAD_KEY keyVal)
-{
-#ifdef WIN32
-  TlsFree(keyVal);
-#else // !WIN32 aka POSIX
-  pthread_key_delete(keyVal); // TODO:  check return?
-#endif // WIN32,POSIX
+  return pRval;
 }
 
-void * WBThreadGetLocal(WB_THREAD_KEY keyVal)
+// the index of the calling thread's queue, or -1 if it isn't a worker thread
+static int __TaskThreadIndex(void)
 {
-#ifdef WIN32
-  return TlsGetValue(keyVal);
-#else // !WIN32 aka POSIX
-  return pthread_getspecific(keyVal);
-#endif // WIN32,POSIX
-}
+pthread_t thrdSelf = pthread_self();
+int i1;
 
-void WBThreadSetLocal(WB_THREAD_KEY keyVal, void *pValue)
-{
-#ifdef WIN32
-  TlsSetValue(keyVal, pValue);
-#else // !WIN32 aka POSIX
-  pthread_setspecific(keyVal, pValue);
-#endif // WIN32,POSIX
+
+  for(i1=0; i1 < nTaskThreads; i1++)
+  {
+    if(pthread_equal(pTaskThreads[i1], thrdSelf))
+    {
+      return i1;
+    }
+  }
+
+  return -1;
 }
 
-WB_THREAD WBThreadGetCurrent(void)
+// called with xTaskPoolMutex locked
+static void __TaskComplete(WB_TASK pTask, int iState)
 {
-#ifdef WIN32
-  return GetCurrentThreadId();
-#else // !WIN32 aka POSIX
-  return pthread_self();
-#endif // WIN32,POSIX
-}
+  pTask->iState = iState;
 
+  pthread_cond_broadcast(&xTaskPoolDone);
+}
 
-#ifdef WIN32
-struct WB_THREAD_PROC_PARAM
+// remove the task with completion ID 'ulID' from the completion list, or NULL if it's not there.
+// called with xTaskPoolMutex locked.  Completions are normally dispatched in order, so it's usually first.
+static WB_TASK __TaskDoneRemove(unsigned long ulID)
 {
-  WB_THREAD_PROC pFunction;
-  void *pParam;
-  volatile HANDLE hThread; // becomes NULL as a flag
-};
+WB_TASK *ppTask, pRval;
 
-DWORD WINAPI W32ThreadCaller(void *pParam0)
-{
-WB_THREAD_PROC pFunction;
-void *pParam;
-HANDLE hThread; // handle to me
-struct WB_THREAD_PROC_PARAM *pP = (struct WB_THREAD_PROC_PARAM *)pParam0;
-DWORD dwRval;
 
-  pFunction = pP->pFunction;
-  pParam = pP->pParam;
-  hThread = pP->hThread;
+  for(ppTask = &pTaskDoneHead; *ppTask; ppTask = &((*ppTask)->pNextDone))
+  {
+    if((*ppTask)->ulDoneID == ulID)
+    {
+      pRval = *ppTask;
+      *ppTask = pRval->pNextDone;
 
-  pP->hThread = NULL; // flag to creator
+      if(ppTaskDoneTail == &(pRval->pNextDone))
+      {
+        ppTaskDoneTail = ppTask;
+      }
 
-  dwRval = (DWORD)pFunction(pParam);  // do the thread
+      pRval->pNextDone = NULL;
+      pRval->ulDoneID = 0;
 
-  CloseHandle(hThread);
+      return pRval;
+    }
+  }
 
-  return dwRval;
+  return NULL;
 }
-#endif // WIN32
 
-WB_THREAD WBThreadCreate(WB_THREAD_PROC function, void *pParam)
+// post the WB_TASK event that delivers the completion callback on the UI thread.  The pool's reference
+// stays on the completion list until WBTaskDispatch removes it, so 'pTask' must not be used afterwards.
+static void __TaskPostCompletion(WB_TASK pTask)
 {
-  WB_THREAD thrdRval = WB_INVALID_THREAD;
-#ifdef WIN32
-  struct WB_THREAD_PROC_PARAM pp;
-  pp.pFunction = function;
-  pp.pParam = pParam;
+XClientMessageEvent evt;
+unsigned long ulID;
 
-  // CreateThread returns a handle
-  // consider calling _beginthreadex and using a wrapper to call _endthreadex
-  pp.hThread = CreateThread(NULL, 0, W32ThreadCaller, &pp, CREATE_SUSPENDED, &thrdRval);
 
-  if(pp.hThread) // returns NULL on error
+  pthread_mutex_lock(&xTaskPoolMutex);
+
+  do
   {
-    ResumeThread(pp.hThread);  // thread proc wrapper closes it
+    ulID = ++ulTaskNextDoneID;
+  } while(!ulID); // zero is never a valid ID
 
-    while(pp.hThread) // assigned 0 when safe for this function to return
-      Sleep(0); // this should happen quickly
+  pTask->ulDoneID = ulID;
+  pTask->pNextDone = NULL;
 
-    return thrdRval;
-  }
-#else // !WIN32 aka POSIX
+  *ppTaskDoneTail = pTask;
+  ppTaskDoneTail = &(pTask->pNextDone);
 
-  // TODO:  call my own thread startup proc, passing a struct that contains
-  //        'function' and 'pParam' as the param.  use a linked list of
-  //        pre-allocated buffers for that.
-  // see possible implementation, above
+  pthread_mutex_unlock(&xTaskPoolMutex);
 
-  if(!pthread_create(&thrdRval, NULL, function, pParam))
-  {
-    return thrdRval;
-  }
-#endif // WIN32,POSIX
+  bzero(&evt, sizeof(evt));
 
-  return WB_INVALID_THREAD;
-}
+  evt.type = ClientMessage;
+  evt.display = WBGetDefaultDisplay();
+  evt.window = None; // application event
+  evt.message_type = aWB_TASK;
+  evt.format = 32;
+  evt.data.l[0] = (long)ulID;
 
-void *WBThreadWait(WB_THREAD hThread)        // closes hThread, returns exit code, waits for thread to terminate (blocks)
-{
-#ifdef WIN32
-  HANDLE hT = OpenThread(READ_CONTROL|SYNCHRONIZE,FALSE,hThread);
-  if(hT)
+  if(WBPostAppEvent((XEvent *)&evt))
   {
-    DWORD dwR;
-    WaitForSingleObject(hT, INFINITE);
+    WB_ERROR_PRINT("ERROR:  %s - unable to post completion for task %p\n", __FUNCTION__, pTask);
 
-    GetExitCodeThread(hT, &dwR);
-    CloseHandle(hT);
-    return (void *)dwR;
-  }
+    pthread_mutex_lock(&xTaskPoolMutex);
 
-  return NULL;
-#else // !WIN32 aka POSIX
-void *pRval = NULL;
+    if(__TaskDoneRemove(ulID) == pTask)
+    {
+      __TaskRelease(pTask);
+    }
 
-  if(pthread_join(hThread, &pRval))
-  {
-    // TODO:  error return??
-    pRval = (void *)-1;
+    pthread_mutex_unlock(&xTaskPoolMutex);
   }
-
-  return pRval;
-#endif // WIN32,POSIX
 }
 
-int WBThreadRunning(WB_THREAD hThread)        // >0 if thread is running, <0 error - use 'pthread_kill(thread,0)' which returns ESRCH if terminated i.e. 'PS_DEAD'
+static void * __TaskWorkerThread(void *pParam)
 {
-int iR = -1;
-#ifdef WIN32
-  // use 'WaitForSingleObject with 0 timeout
-  HANDLE hT = OpenThread(READ_CONTROL|SYNCHRONIZE,FALSE,hThread);
-  if(hT)
-  {
-    DWORD dwR = WaitForSingleObject(hT, 0);
-    if(dwR == WAIT_TIMEOUT)
-      iR = 1;
-    else if(dwR == WAIT_OBJECT_0)
-      iR = 0;
-    else
-      iR = -1;
+int iIndex = (int)(long)pParam;
+int i1, iState;
+WB_TASK pTask;
+void *pResult;
 
-    CloseHandle(hT);
-  }
-  return iR;
-#else // !WIN32 aka POSIX
-  iR = pthread_kill(hThread,0);
 
-  if(!iR)
+  while(1)
   {
-    return 1; // no signal sent, handle is valid (and did not exit)
-  }
+    // my own queue first (newest task), then steal from the others (oldest task)
 
-  if(iR == ESRCH)
-  {
-    return 0; // for now, allow this to indicate 'done'
+    pTask = __TaskQueuePop(pTaskQueues + iIndex, 0);
+
+    for(i1=1; !pTask && i1 < nTaskThreads; i1++)
+    {
+      pTask = __TaskQueuePop(pTaskQueues + (iIndex + i1) % nTaskThreads, 1);
+    }
+
+    pthread_mutex_lock(&xTaskPoolMutex);
+
+    if(!pTask)
+    {
+      if(bTaskPoolExit)
+      {
+        pthread_mutex_unlock(&xTaskPoolMutex);
+        break;
+      }
+
+      if(!nTaskPending) // nothing queued anywhere - sleep until something is submitted
+      {
+        pthread_cond_wait(&xTaskPoolWork, &xTaskPoolMutex);
+      }
+
+      pthread_mutex_unlock(&xTaskPoolMutex);
+      continue;
+    }
+
+    nTaskPending--;
+
+    if(pTask->bCancel || bTaskPoolExit) // canceled before it started
+    {
+      __TaskComplete(pTask, WBTaskState_Canceled);
+
+      pthread_mutex_unlock(&xTaskPoolMutex);
+
+      __TaskPostCompletion(pTask);
+      continue;
+    }
+
+    pTask->iState = WBTaskState_Running;
+
+    pthread_mutex_unlock(&xTaskPoolMutex);
+
+    pResult = pTask->pProc(pTask, pTask->pParam);
+
+    pthread_mutex_lock(&xTaskPoolMutex);
+
+    pTask->pResult = pResult;
+
+    iState = pTask->bCancel ? WBTaskState_Canceled : WBTaskState_Complete;
+
+    __TaskComplete(pTask, iState);
+
+    pthread_mutex_unlock(&xTaskPoolMutex);
+
+    __TaskPostCompletion(pTask);
   }
 
-  return -1;
-#endif // WIN32,POSIX
+  return NULL;
 }
 
-void WBThreadExit(void *pRval)
+int WBThreadPoolInit(int nThreads)
 {
-#ifdef WIN32
-#else // !WIN32 aka POSIX
-  pthread_exit(pRval);
-#endif // WIN32,POSIX
-}
+int i1, i2;
 
-void WBThreadClose(WB_THREAD hThread)
-{
-#ifdef WIN32
-#else // !WIN32 aka POSIX
-  pthread_detach(hThread);
-#endif // WIN32,POSIX
-}
 
+  pthread_mutex_lock(&xTaskPoolMutex);
 
+  if(nTaskThreads)
+  {
+    pthread_mutex_unlock(&xTaskPoolMutex);
+    return 1; // already running
+  }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                                                               //
-//    ____                   _  _  _    _                         _                _   __  __         _                          //
-//   / ___| ___   _ __    __| |(_)| |_ (_)  ___   _ __   ___     / \    _ __    __| | |  \/  | _   _ | |_  ___ __  __ ___  ___   //
-//  | |    / _ \ | '_ \  / _` || || __|| | / _ \ | '_ \ / __|   / _ \  | '_ \  / _` | | |\/| || | | || __|/ _ \\ \/ // _ \/ __|  //
-//  | |___| (_) || | | || (_| || || |_ | || (_) || | | |\__ \  / ___ \ | | | || (_| | | |  | || |_| || |_|  __/ >  <|  __/\__ \  //
-//   \____|\___/ |_| |_| \__,_||_| \__||_| \___/ |_| |_||___/ /_/   \_\|_| |_| \__,_| |_|  |_| \__,_| \__|\___|/_/\_\\___||___/  //
-//                                                                                                                               //
-//                                                                                                                               //
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  if(nThreads <= 0)
+  {
+    nThreads = WBCPUCount();
 
-int WBCondCreate(WB_COND *pCond)
-{
-int iRval = -1;
+    if(nThreads <= 0)
+    {
+      nThreads = 1;
+    }
+  }
 
-  if(pCond)
+  pTaskQueues = (WB_TASK_QUEUE *)WBAlloc(sizeof(*pTaskQueues) * nThreads);
+  pTaskThreads = (WB_THREAD *)WBAlloc(sizeof(*pTaskThreads) * nThreads);
+
+  if(!pTaskQueues || !pTaskThreads)
   {
-#ifdef WIN32
-    // because of problems under Windows, this will be defined as 'unsigned int'
-    // and I'll use the increment/decrement interlock functions and wait loops to
-    // monitor the signaling.
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory\n", __FUNCTION__);
 
-    *pCond = 0;
+    goto error_exit;
+  }
 
-    iRval = 0; // success!
-#else  // WIN23
-//    pthread_condattr_t attr;
-//    iRval = pthread_condattr_init(&attr);
-//
-//    if(!iRval)
-//    {
-//      pthread_condattr_setclock(&attr, CLOCK_REALTIME); // *MUST* use *THIS* one
-//      pthread_condattr_setpshared(&attr, PTHREAD_PROCESS_PRIVATE);
-//
-//      iRval = pthread_cond_init(pCond, &attr);
-//
-//      pthread_condattr_destroy(&attr);
-//    }
+  for(i1=0; i1 < nThreads; i1++)
+  {
+    pthread_mutex_init(&(pTaskQueues[i1].mtx), NULL);
 
-    // note:  Implementing with 'interlock' in POSIX as well
+    pTaskQueues[i1].nMax = WB_TASK_QUEUE_INITIAL_SIZE;
+    pTaskQueues[i1].nHead = pTaskQueues[i1].nTail = 0;
+    pTaskQueues[i1].pTasks = (WB_TASK *)WBAlloc(sizeof(WB_TASK) * WB_TASK_QUEUE_INITIAL_SIZE);
 
-    *pCond = 0;
+    if(!pTaskQueues[i1].pTasks)
+    {
+      WB_ERROR_PRINT("ERROR:  %s - not enough memory\n", __FUNCTION__);
 
-    iRval = 0; // success!
-#endif // WIN32
+      for(i1--; i1 >= 0; i1--)
+      {
+        WBFree(pTaskQueues[i1].pTasks);
+        pthread_mutex_destroy(&(pTaskQueues[i1].mtx));
+      }
+
+      goto error_exit;
+    }
   }
 
-  return iRval;
-}
+  bTaskPoolExit = 0;
 
-int WBMutexCreate(WB_MUTEX *pMtx)
-{
-  if(pMtx)
+  // the workers don't start looking at the queues until 'nTaskThreads' is assigned, and this mutex
+  // is held until then, so they can all be created before any of them run
+
+  for(i1=0; i1 < nThreads; i1++)
   {
-#ifdef WIN32
-#else  // WIN23
-    if(!pthread_mutex_init(pMtx, NULL))
+    pTaskThreads[i1] = WBThreadCreate(__TaskWorkerThread, (void *)(long)i1);
+
+    if(pTaskThreads[i1] == WB_INVALID_THREAD)
     {
-      return 0;
+      WB_ERROR_PRINT("ERROR:  %s - unable to create worker thread %d\n", __FUNCTION__, i1);
+      break; // use the ones I have
     }
-#endif // WIN32
   }
 
-  return -1;
-}
+  for(i2=i1; i2 < nThreads; i2++) // free the queues that have no worker thread
+  {
+    WBFree(pTaskQueues[i2].pTasks);
+    pthread_mutex_destroy(&(pTaskQueues[i2].mtx));
+  }
 
+  if(!i1)
+  {
+    goto error_exit;
+  }
 
-void WBCondFree(WB_COND *pCond)
-{
-#ifdef WIN32
-//  CloseHandle(*pCond);
-  if(pCond)
+  nTaskThreads = i1;
+
+  pthread_mutex_unlock(&xTaskPoolMutex);
+
+  return 0;
+
+error_exit:
+
+  if(pTaskQueues)
   {
-    *pCond = 1; // forces a waiting thread to signal (though only one will probably do it)
+    WBFree(pTaskQueues);
+    pTaskQueues = NULL;
   }
-#else  // WIN23
-  if(pCond)
+
+  if(pTaskThreads)
   {
-//    pthread_cond_destroy(pCond);  // not using pthread version
+    WBFree(pTaskThreads);
+    pTaskThreads = NULL;
+  }
 
-    // because of problems under Windows, this will be defined as 'unsigned int'
-    // and I'll use the increment/decrement interlock functions and wait loops to
-    // monitor the signaling.
+  pthread_mutex_unlock(&xTaskPoolMutex);
 
-    *pCond = 1; // forces a waiting thread to signal (though only one will probably do it)
-  }
-#endif // WIN32
+  return -1;
 }
 
-void WBMutexFree(WB_MUTEX *pMtx)
+void WBThreadPoolExit(void)
 {
-#ifdef WIN32
-  CloseHandle(*pMtx);
-#else  // WIN23
-  pthread_mutex_destroy(pMtx);
-#endif // WIN32
-}
+WB_TASK pTask;
+int i1, nThreads;
 
-int WBMutexLock(WB_MUTEX *pMtx, int nTimeout)
-{
-int iRval;
-#ifdef WIN32
-#else  // WIN23
-WB_UINT64 ullTime = WBGetTimeIndex(); // current time index in microseconds
-WB_UINT64 ullTemp;
 
-  if(nTimeout < 0)
-  {
-    iRval = pthread_mutex_lock(pMtx);
+  pthread_mutex_lock(&xTaskPoolMutex);
 
-    return iRval ? -1 : 0; // either an error, or success [but never a timeout]
-  }
+  nThreads = nTaskThreads;
 
-  while(1)
+  if(!nThreads)
   {
-    iRval = pthread_mutex_trylock(pMtx);
+    pthread_mutex_unlock(&xTaskPoolMutex);
+    return;
+  }
 
-    if(!iRval)
-    {
-      return 0;
-    }
-    else if(iRval != EBUSY)
-    {
-      return -1; // an error
-    }
+  bTaskPoolExit = 1;
 
-    ullTemp = WBGetTimeIndex(); // TODO:  use clock_gettime instead?
+  pthread_cond_broadcast(&xTaskPoolWork);
 
-    if((ullTemp - ullTime) > nTimeout)
+  pthread_mutex_unlock(&xTaskPoolMutex);
+
+  // cancel everything that's still queued, then wait for the workers to finish
+
+  // NOTE:  WBTaskSubmit locks a queue while holding xTaskPoolMutex, so never lock them in the other order
+
+  for(i1=0; i1 < nThreads; i1++)
+  {
+    while((pTask = __TaskQueuePop(pTaskQueues + i1, 1)) != NULL)
     {
-      return 1; // timed out
+      pthread_mutex_lock(&xTaskPoolMutex);
+
+      nTaskPending--;
+      pTask->bCancel = 1;
+      __TaskComplete(pTask, WBTaskState_Canceled); // wakes up WBTaskWait
+      __TaskRelease(pTask); // the completion callback won't be called, so release the pool's reference
+
+      pthread_mutex_unlock(&xTaskPoolMutex);
     }
+  }
 
-    WBDelay(83 + (ullTemp / 13) % 37); // sleep a 'sort of' random wait time
+  for(i1=0; i1 < nThreads; i1++)
+  {
+    WBThreadWait(pTaskThreads[i1]); // running tasks finish first
   }
-#endif // WIN32
 
-  return -1; // should never get here
+  pthread_mutex_lock(&xTaskPoolMutex);
+
+  for(i1=0; i1 < nThreads; i1++)
+  {
+    WBFree(pTaskQueues[i1].pTasks);
+    pthread_mutex_destroy(&(pTaskQueues[i1].mtx));
+  }
+
+  WBFree(pTaskQueues);
+  WBFree(pTaskThreads);
+
+  pTaskQueues = NULL;
+  pTaskThreads = NULL;
+  nTaskThreads = 0;
+  nTaskPending = 0;
+
+  pthread_mutex_unlock(&xTaskPoolMutex);
 }
 
-int WBMutexUnlock(WB_MUTEX *pMtx)
+WB_TASK WBTaskSubmit(WB_TASK_PROC pProc, void *pParam, WB_TASK_CALLBACK pCallback)
 {
-#ifdef WIN32
-#else  // WIN23
-  return pthread_mutex_unlock(pMtx);
-#endif // WIN32
-}
+WB_TASK pRval;
+int iIndex;
 
 
-int WBCondSignal(WB_COND *pCond)
-{
-//#ifdef WIN32
-//#else  // WIN23
-//  return pthread_cond_signal(pCond);
+  if(!pProc)
+  {
+    return NULL;
+  }
 
-  if(pCond)
+  pRval = (WB_TASK)WBAlloc(sizeof(*pRval));
+
+  if(!pRval)
   {
-    WBInterlockedExchange(pCond, 1); // assign to 1 [this is my trigger]
-    return 0;
+    return NULL;
   }
-//#endif // WIN32
 
-  return -1;
-}
+  bzero(pRval, sizeof(*pRval));
 
-int WBCondWait(WB_COND *pCond, int nTimeout)
-{
-int iRval = -1;
+  pRval->pProc = pProc;
+  pRval->pParam = pParam;
+  pRval->pCallback = pCallback;
+  pRval->iState = WBTaskState_Queued;
+  pRval->nRefCount = 2; // the caller's handle, and the pool's reference (released after the callback)
 
-  if(!pCond)
-  {
-    WB_ERROR_PRINT("TEMPORARY: %s - returns -1 (NULL pCond)\n", __FUNCTION__);
+  // the pool state is only valid while xTaskPoolMutex is locked.  holding it across the push means that
+  // WBThreadPoolExit either sees this task when it drains the queues, or this sees 'bTaskPoolExit'.
 
-    return -1;
-  }
+  pthread_mutex_lock(&xTaskPoolMutex);
 
-  if(nTimeout >= 0)
+  if(WB_UNLIKELY(!nTaskThreads)) // start it on first use
   {
-    struct timespec ts, tsNow;
+    pthread_mutex_unlock(&xTaskPoolMutex);
 
-    clock_gettime(CLOCK_REALTIME, &ts);
+    WBThreadPoolInit(0); // if another thread started it first, this fails and that's ok
 
-    ts.tv_sec += nTimeout / 1000000;
-    ts.tv_nsec += (nTimeout % 1000000) * 1000L;
+    pthread_mutex_lock(&xTaskPoolMutex);
+  }
 
-    if(ts.tv_nsec > 1000000000L)
-    {
-      ts.tv_sec++;
-      ts.tv_nsec -= 1000000000L;
-    }
+  if(!nTaskThreads || bTaskPoolExit) // not running, or WBThreadPoolExit has started
+  {
+    pthread_mutex_unlock(&xTaskPoolMutex);
 
-    iRval = 0;
+    WBFree(pRval);
+    return NULL;
+  }
 
-    while(!WBInterlockedExchange(pCond, 0)) // if return is zero, it wasn't 'signaled'
-    {
-      clock_gettime(CLOCK_REALTIME, &tsNow);
+  // tasks submitted by a worker go into its own queue; others are distributed round-robin
 
-      if(tsNow.tv_sec > ts.tv_sec ||
-         (tsNow.tv_sec == ts.tv_sec &&
-          tsNow.tv_nsec > ts.tv_nsec))
-      {
-        iRval = ETIMEDOUT; // timeout error
-        break;
-      }
+  iIndex = __TaskThreadIndex();
 
-      WBDelay(37 + tsNow.tv_nsec % 29); // a slightly random ~0.05 msec delay
-    }
+  if(iIndex < 0)
+  {
+    iIndex = (int)(WB_ATOMIC_FETCH_ADD(&uiTaskNextQueue, 1) % (unsigned int)nTaskThreads);
   }
-  else
+
+  if(__TaskQueuePush(pTaskQueues + iIndex, pRval))
   {
-    while(!WBInterlockedExchange(pCond, 0)) // if return is zero, it wasn't 'signaled'
-    {
-      WBDelay(100); // for now, it's the same time period (TODO:  adjust like above?)
-    }
+    pthread_mutex_unlock(&xTaskPoolMutex);
+
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory\n", __FUNCTION__);
+
+    WBFree(pRval);
+    return NULL;
   }
 
-//#endif // WIN32
+  nTaskPending++;
 
-  return iRval;
+  pthread_cond_signal(&xTaskPoolWork);
+
+  pthread_mutex_unlock(&xTaskPoolMutex);
+
+  return pRval;
 }
 
-int WBCondWaitMutex(WB_COND *pCond, WB_MUTEX *pMtx, int nTimeout)
+int WBTaskCancel(WB_TASK hTask)
 {
 int iRval;
-//#ifdef WIN32
-//#else  // WIN23
 
-  if(!pCond || !pMtx)
+
+  if(!hTask)
+  {
     return -1;
+  }
 
-  WBMutexUnlock(pMtx);
+  pthread_mutex_lock(&xTaskPoolMutex);
 
-  iRval = WBCondWait(pCond, nTimeout);
+  iRval = hTask->iState == WBTaskState_Queued ? 0 :
+          hTask->iState == WBTaskState_Running ? 1 : -1;
 
-  WBMutexLock(pMtx, -1); // this is a safe way of replicating the behavior [wait infinitely on mutex]
+  if(iRval >= 0)
+  {
+    hTask->bCancel = 1; // a queued task is skipped (and completed) when a worker gets to it
+  }
 
-//#endif // WIN32
+  pthread_mutex_unlock(&xTaskPoolMutex);
 
   return iRval;
 }
 
+int WBTaskCanceled(WB_TASK hTask)
+{
+  return hTask ? (hTask->bCancel || bTaskPoolExit) : 1;
+}
 
-unsigned int WBInterlockedDecrement(volatile unsigned int *pValue)
+int WBTaskState(WB_TASK hTask)
 {
-#ifdef WIN32
-  return InterlockedDecrement(pValue);
-#else // !WIN32
-unsigned int iRval;
+  if(!hTask)
+  {
+    return -1;
+  }
 
-  pthread_rwlock_wrlock(&xInterlockedRWLock);
+  return hTask->iState;
+}
 
-  (*pValue)++;
-  iRval = *pValue;
+int WBTaskWait(WB_TASK hTask, int nTimeout, void **ppResult)
+{
+struct timespec ts;
+int iRval = 0;
 
-  pthread_rwlock_unlock(&xInterlockedRWLock);
 
-  return iRval;
-#endif // WIN32
-}
+  if(!hTask)
+  {
+    return -1;
+  }
 
-unsigned int WBInterlockedIncrement(volatile unsigned int *pValue)
-{
-#ifdef WIN32
-  return InterlockedIncrement(pValue);
-#else // !WIN32
-unsigned int iRval;
+  if(nTimeout > 0)
+  {
+    __TimeoutToTimespec(CLOCK_REALTIME, nTimeout, &ts); // xTaskPoolDone uses the default clock
+  }
 
-  pthread_rwlock_wrlock(&xInterlockedRWLock);
+  pthread_mutex_lock(&xTaskPoolMutex);
 
-  (*pValue)++;
-  iRval = *pValue;
+  while(hTask->iState == WBTaskState_Queued || hTask->iState == WBTaskState_Running)
+  {
+    if(!nTimeout)
+    {
+      iRval = ETIMEDOUT;
+    }
+    else if(nTimeout < 0)
+    {
+      iRval = pthread_cond_wait(&xTaskPoolDone, &xTaskPoolMutex);
+    }
+    else
+    {
+      iRval = pthread_cond_timedwait(&xTaskPoolDone, &xTaskPoolMutex, &ts);
+    }
 
-  pthread_rwlock_unlock(&xInterlockedRWLock);
+    if(iRval == ETIMEDOUT)
+    {
+      break;
+    }
+    else if(iRval && iRval != EINTR)
+    {
+      pthread_mutex_unlock(&xTaskPoolMutex);
+      return -1;
+    }
 
-  return iRval;
-#endif // WIN32
-}
+    iRval = 0;
+  }
 
-unsigned int WBInterlockedExchange(volatile unsigned int *pValue, unsigned int nNewVal)
-{
-#ifdef WIN32
-  return InterlockedExchange(pValue, nNewVal); // pretty sure this is right...
-#else // !WIN32
-unsigned int iRval;
+  if(iRval == ETIMEDOUT && // signaled at the last moment, so it's not a timeout
+     hTask->iState != WBTaskState_Queued && hTask->iState != WBTaskState_Running)
+  {
+    iRval = 0;
+  }
 
-  pthread_rwlock_wrlock(&xInterlockedRWLock);
+  if(!iRval)
+  {
+    if(ppResult)
+    {
+      *ppResult = hTask->pResult;
+    }
 
-  iRval = *pValue;
-  *pValue = nNewVal;
+    if(hTask->iState == WBTaskState_Canceled)
+    {
+      iRval = -1;
+    }
+  }
 
-  pthread_rwlock_unlock(&xInterlockedRWLock);
+  pthread_mutex_unlock(&xTaskPoolMutex);
 
   return iRval;
-#endif // WIN32
 }
 
-unsigned int WBInterlockedRead(volatile unsigned int *pValue)
+void WBTaskClose(WB_TASK hTask)
 {
-#ifdef WIN32
-  return *pValue; // for now; later, there might be a better way
-#else // !WIN32
-unsigned int iRval;
+  if(hTask)
+  {
+    pthread_mutex_lock(&xTaskPoolMutex);
 
-  pthread_rwlock_rdlock(&xInterlockedRWLock); // this only does a read lock
+    __TaskRelease(hTask);
 
-  iRval = *pValue;
+    pthread_mutex_unlock(&xTaskPoolMutex);
+  }
+}
 
-  pthread_rwlock_unlock(&xInterlockedRWLock);
+int WBTaskDispatch(XEvent *pEvent)
+{
+WB_TASK pTask;
 
-  return iRval;
-#endif // WIN32
+
+  if(pEvent->type != ClientMessage || pEvent->xclient.message_type != aWB_TASK)
+  {
+    return 0;
+  }
+
+  pthread_mutex_lock(&xTaskPoolMutex);
+  pTask = __TaskDoneRemove((unsigned long)pEvent->xclient.data.l[0]);
+  pthread_mutex_unlock(&xTaskPoolMutex);
+
+  if(!pTask)
+  {
+    WB_WARN_PRINT("WARNING:  %s - no completed task with ID %lu\n", __FUNCTION__,
+                  (unsigned long)pEvent->xclient.data.l[0]);
+  }
+  else
+  {
+    if(pTask->pCallback)
+    {
+      pTask->pCallback(pTask, pTask->pParam, pTask->pResult, pTask->iState);
+    }
+
+    pthread_mutex_lock(&xTaskPoolMutex);
+    __TaskRelease(pTask); // the pool's reference
+    pthread_mutex_unlock(&xTaskPoolMutex);
+  }
+
+  return 1; // handled
 }
 
 
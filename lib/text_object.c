@@ -66,6 +66,7 @@
 #include <limits.h>
 
 #include "draw_text.h"
+#include "pixmap_helper.h"
 #include "text_object.h"
 #include "conf_help.h"
 
@@ -1828,8 +1829,14 @@ static void __internal_init(TEXT_OBJECT *pThis)
   pThis->pUndo = NULL;
   pThis->pRedo = NULL;
 
-  // get initial default highlight colors
+  // get initial default highlight colors (there is no display when used headless, as in the benchmarks)
 
+  if(!WBGetDefaultDisplay())
+  {
+    bzero(&(pThis->clrHFG), sizeof(pThis->clrHFG));
+    bzero(&(pThis->clrHBG), sizeof(pThis->clrHBG));
+  }
+  else
   {
     char szHFG[16], szHBG[16];
     Colormap colormap = DefaultColormap(WBGetDefaultDisplay(), DefaultScreen(WBGetDefaultDisplay()));
@@ -1848,10 +1855,10 @@ static void __internal_init(TEXT_OBJECT *pThis)
     COPY_COLOR_NAME(CHGetHighlightForegroundColor,szHFG,"#ffffff");
     COPY_COLOR_NAME(CHGetHighlightBackgroundColor,szHBG,"#0040FF");
 
-    XParseColor(WBGetDefaultDisplay(), colormap, szHFG, &(pThis->clrHFG));
-    XAllocColor(WBGetDefaultDisplay(), colormap, &(pThis->clrHFG)); // TODO:  calculate missing pieces myself?
-    XParseColor(WBGetDefaultDisplay(), colormap, szHBG, &(pThis->clrHBG));
-    XAllocColor(WBGetDefaultDisplay(), colormap, &(pThis->clrHBG)); // TODO:  calculate missing pieces myself?
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHFG, &(pThis->clrHFG));
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pThis->clrHFG));
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHBG, &(pThis->clrHBG));
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &(pThis->clrHBG));
   }
 
   // TODO:  do I re-initialize the owner-maintained values?  for now, NO!
@@ -88,8 +88,7 @@ static int iInitScrollColorFlag = 0;
 **/
 static void CheckInitScrollColors(void)
 {
-  // TODO:  consider freeing the colors with XFreeColors on exit
-  // TODO:  consider not even bothering with 'XAllocColor' and just use PXM_RGBToPixel()
+  // NOTE:  colors come from PXM_ParseColor/PXM_AllocColor, which cache them (do not XFreeColors)
 
   if(!iInitScrollColorFlag)
   {
@@ -131,34 +130,34 @@ static void CheckInitScrollColors(void)
 //     else LOAD_COLOR0("*borderColor", szBD)
 //     else LOAD_COLOR("*border", szBD, "black"); // default for gnome
 
-    XParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrScrollFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrScrollBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollBG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szAFG, &clrScrollAFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollAFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szABG, &clrScrollABG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollABG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szHFG, &clrScrollHFG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollHFG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szHBG, &clrScrollHBG);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollHBG);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBD, &clrScrollBD);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szFG, &clrScrollFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBG, &clrScrollBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szAFG, &clrScrollAFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollAFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szABG, &clrScrollABG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollABG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHFG, &clrScrollHFG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollHFG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szHBG, &clrScrollHBG);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollHBG);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBD, &clrScrollBD);
 
     // 3D border colors for now these are hard-coded - later derive them from FG and BG colors
     if(clrScrollBG.red >= 60000 && clrScrollBG.green >= 60000 &&
        clrScrollBG.blue >= 60000) // note see man page on XColor, values 0 through 65535 for RGB
     {
-      XParseColor(WBGetDefaultDisplay(), colormap, szBorder2W, &clrScrollBD2);
+      PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBorder2W, &clrScrollBD2);
     }
     else
     {
-      XParseColor(WBGetDefaultDisplay(), colormap, szBorder2, &clrScrollBD2);
+      PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBorder2, &clrScrollBD2);
     }
 
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollBD2);
-    XParseColor(WBGetDefaultDisplay(), colormap, szBorder3, &clrScrollBD3);
-    XAllocColor(WBGetDefaultDisplay(), colormap, &clrScrollBD3);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollBD2);
+    PXM_ParseColor(WBGetDefaultDisplay(), colormap, szBorder3, &clrScrollBD3);
+    PXM_AllocColor(WBGetDefaultDisplay(), colormap, &clrScrollBD3);
 
     iInitScrollColorFlag = 1;
   }
@@ -73,6 +73,10 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/time.h> // for 'gettimeofday'
+#include <poll.h>     // for 'poll' in WBWaitForEvent
+#ifdef __linux__
+#include <sys/eventfd.h> // wakeup descriptor for WBWaitForEvent (elsewhere a pipe is used)
+#endif // __linux__
 
 // TODO:  determine if pthread is available, optionally use for timers
 #include <pthread.h> /* currently required */
@@ -92,8 +96,6 @@
 
 
 #define MIN_EVENT_LOOP_SLEEP_PERIOD 100    /* 0.1 millisec */
-#define MAX_EVENT_LOOP_SLEEP_PERIOD 50000 /* 50 msecs - better for Linux within a VM - worst was 3.6% during idle */
-//#define MAX_EVENT_LOOP_SLEEP_PERIOD 100000 /* 0.1 sec - way too long, actually */
 
 const char *sz_xcall_func = NULL;
 int i_xcall_line = 0;
@@ -104,18 +106,24 @@ int i_xcall_line = 0;
 
 // **************************************************************************
 //                       ALGORITHMS AND OTHER RELATED NOTES
-// the hash algorithm is simple.  First, apply 'WINDOW_ENTRY_HASH' to the
-// window ID.  Then use it as an index into the array of '_WINDOW_ENTRY_'
-// structures.  If the entry it points to does NOT match the window ID I'm
-// interested in, increment the index 'mod ARRAY SIZE' until I either find
-// the matching window ID, wrap around, or find a zero window ID.  Wrapping
-// around is basically prevented by ensuring that the array is at least twice
-// the size of the maximum allowed window count. And, for the above reasons,
-// the size of the array must be a power of 2 so that the hash works properly.
+// window entries are located by window ID through a Robin Hood hash table
+// ('pWindowHash').  The slot index is a Fibonacci hash of the window ID.
+// On a collision, the entry that is farther from its 'home' slot keeps the
+// slot and the other one moves on, so probe sequences stay short and a
+// lookup can stop as soon as it passes the point where the window ID would
+// have been.  Removing an entry shifts the following entries back by one
+// slot, so there are no 'unused' markers to clean up.  The table is kept at
+// most half full, and doubles in size (re-hashing everything) as needed.
+//
+// The '_WINDOW_ENTRY_' structures themselves are allocated individually and
+// never move, so a pointer to one remains valid while the window is known.
+// When an entry is deleted, it goes onto a free list for re-use rather than
+// being freed, and so a stale pointer still points to valid (zeroed) memory.
+// All of the entries are also kept in a linked list, for enumeration.
 
 // NOTE:  window assignments tend to be consecutive so I must scramble them
-//        up or risk inefficiency in the hash algorithm.  This can be
-//        improved later to minimize the impact of this behavior.
+//        up or risk inefficiency in the hash algorithm.  The Fibonacci
+//        hash takes care of this.
 //
 // NOTE 2:  Window ID and other XID values APPEAR to depend on the definition
 //          of 'RESOURCE_AND_CLIENT_COUNT' and the max # of clients
@@ -398,6 +406,7 @@ Atom aSET_FOCUS=None;
   * data.l[1] is *piAltCtrlShift from WBKeyEventProcessKey\n
   * data.l[2] is # of characters decoded into data.l[3..4]\n
   * data.l[3..4] (as char[]) is decode buffer (at least 8 chars long, possibly 16 for 64-bit)\n
+  * data.l[4] is the repeat count for WB_KEYEVENT_KEYSYM when greater than 1 (see WBGetCharEventRepeat())\n
   * \n
   * see also:   WBKeyEventProcessKey()
 **/
@@ -464,6 +473,25 @@ Atom aWB_TIMER=None;         ///< timer notifications (generated by API)
 **/
 Atom aWB_POINTER=None;       ///< 'pointer' notifications (generated by API)
 
+/** \ingroup events_atoms
+  * \hideinitializer
+  * \brief worker thread pool task completion notifications generated by API
+  *
+  * When a task submitted with WBTaskSubmit() completes (or is canceled), a WB_TASK notification
+  * is posted to the application, and WBAppDispatch() calls the task's completion callback.
+  * This message is internal, and is not passed to the application's event callback.
+  *
+  * WB_TASK message format (relative to XEvent.xclient)\n
+  * \n
+  * type == ClientMessage\n
+  * message_type == aWB_TASK\n
+  * format == 32 (always)\n
+  * data.l[0] is a pointer hash for the task (see WBCreatePointerHash())
+  * \n
+  * see also:  WBTaskSubmit(), WBTaskDispatch()
+**/
+Atom aWB_TASK=None;          ///< task completion notifications (generated by API)
+
 // things used by window managers
 /** \ingroup wmatom
   * \hideinitializer
@@ -734,8 +762,13 @@ Atom aNULL=None;             // Atom for 'NULL'
     Pixmap pxMask;                             // icon mask pixmap (may be None)
     int (* pCallback)(Window wIDEvent, XEvent *pEvent); // Pointer to the window's event callback function
     WB_GEOM geomAbsolute;                      // absolute window geometry (from notification)
+    WB_GEOM geomCache;                         // parent-relative window geometry, as XGetGeometry would report it
+    int iGeomCacheState;                       // state of 'geomCache' - WB_GEOM_CACHE_NONE, WB_GEOM_CACHE_VALID, or WB_GEOM_CACHE_STALE
     Region rgnClip;                            // complex clip (aka 'invalid') region (0 implies 'none')
     Region rgnPaint;                           // rectangular paint region (0 implies 'none')
+    Region rgnExpose;                          // exposed region for the most recently dequeued Expose event (0 implies 'none')
+    int iCompressFlags;                        // event compression flags, WB_COMPRESS_MOTION and/or WB_COMPRESS_KEYREPEAT
+    int iKeyRepeat;                            // repeat count for the most recent (compressed) KeyPress
     Window wIDMenu;                            // window ID for attached menu window
     int (* pMenuCallback)(Window wIDEvent, XEvent *pEvent); // Pointer to the window's MENU callback function - may be NULL, valid only for windows with menus
     Cursor curRecent;                          // most recent cursor resource (must be freed via XFreeCursor)
@@ -750,8 +783,10 @@ Atom aNULL=None;             // Atom for 'NULL'
     int iWindowState;                          // indicates if window mapped
     enum WMPropertiesWindowType eWindowType;   // a combination of WMPropertiesWindowType values (default None)
     enum WMPropertiesWMProtocols eWMProtocols; // a combination of WMPropertiesWMProtocols values, indicating supported protocols (default None)
-    struct timeval tvLastActivity;             // time of last activity (TODO:  find a better way than 'gettimeofday')
+    WB_UINT64 qwLastActivity;                  // time index of last activity, tracked only while waiting to be deleted
     void *aWindowData[WINDOW_DATA_SIZE];       // 4 void pointers, to be uased as needed for 'window data'
+    struct s_internal_window_entry *pNextEntry; // next entry in the list of all window entries (or the free list)
+    struct s_internal_window_entry *pPrevEntry; // previous entry in the list of all window entries
   } _WINDOW_ENTRY_;
 
   * \endcode
@@ -782,8 +817,13 @@ typedef struct s_internal_window_entry       // the structure that identifies th
   **/
   int (* pCallback)(Window wIDEvent, XEvent *pEvent);
   WB_GEOM geomAbsolute;                      ///< absolute window geometry (from notification)
+  WB_GEOM geomCache;                         ///< parent-relative window geometry, as XGetGeometry would report it (see 'iGeomCacheState')
+  int iGeomCacheState;                       ///< state of 'geomCache' - WB_GEOM_CACHE_NONE, WB_GEOM_CACHE_VALID, or WB_GEOM_CACHE_STALE
   Region rgnClip;                            ///< complex clip (aka 'invalid') region (0 implies 'none')
   Region rgnPaint;                           ///< rectangular paint region (0 implies 'none')
+  Region rgnExpose;                          ///< exposed region for the most recently dequeued Expose event (0 implies 'none')
+  int iCompressFlags;                        ///< event compression flags, WB_COMPRESS_MOTION and/or WB_COMPRESS_KEYREPEAT (see WBSetWindowEventCompression())
+  int iKeyRepeat;                            ///< repeat count for the most recent (compressed) KeyPress
   Window wIDMenu;                            ///< window ID for attached menu window
   /** \brief Pointer to the window's MENU callback function - may be NULL, valid only for windows with menus */
   int (* pMenuCallback)(Window wIDEvent, XEvent *pEvent);
@@ -799,18 +839,29 @@ typedef struct s_internal_window_entry       // the structure that identifies th
   int iWindowState;                          ///< indicates if window mapped
   enum WMPropertiesWindowType eWindowType;   ///< a combination of WMPropertiesWindowType values (default None)
   enum WMPropertiesWMProtocols eWMProtocols; ///< a combination of WMPropertiesWMProtocols values, indicating supported protocols (default None)
-  struct timeval tvLastActivity;             ///< time of last activity (TODO:  find a better way than 'gettimeofday')
+  WB_UINT64 qwLastActivity;                  ///< time index of last activity, tracked only while waiting to be deleted (see WBGetTimeIndex())
   void *aWindowData[WINDOW_DATA_SIZE];       ///< 4 void pointers, to be uased as needed for 'window data'
+  struct s_internal_window_entry *pNextEntry; ///< next entry in the list of all window entries (or the free list)
+  struct s_internal_window_entry *pPrevEntry; ///< previous entry in the list of all window entries
 } _WINDOW_ENTRY_;
 
-#define WINDOW_ENTRY_ARRAY_SIZE 2048 /* must be a power of 2 and twice the max expected # of windows */
-#define WINDOW_ENTRY_ARRAY_MAX 2047  /* must be the above value minus 1 */
-#define WINDOW_ENTRY_HASH(X) (((((unsigned long)X & 0xf00) + \
-                                (((unsigned long)X >> 3) & 0x1f) + \
-                                (((unsigned long)X << 5) & 0xe0)) ^ \
-                               ((unsigned long)X >> 12)) & WINDOW_ENTRY_ARRAY_MAX)
+#define WINDOW_HASH_INITIAL_SIZE 256 /* initial size of the window hash table, must be a power of 2 */
 
-#define WINDOW_ENTRY_UNUSED ((Window)-1)
+/** \struct s_WINDOW_HASH_SLOT
+  * \ingroup wcore_internal
+  * \copydoc WINDOW_HASH_SLOT
+**/
+/** \typedef WINDOW_HASH_SLOT
+  * \ingroup wcore_internal
+  * \brief Core (internal) structure for a slot in the window entry hash table
+  *
+  * The window ID is kept in the slot so that probing does not need to touch the '_WINDOW_ENTRY_'
+**/
+typedef struct s_WINDOW_HASH_SLOT
+{
+  Window wID;                                ///< window ID for this slot, or 'None' if the slot is empty
+  _WINDOW_ENTRY_ *pEntry;                    ///< the window entry for 'wID'
+} WINDOW_HASH_SLOT;
 
 #define WB_WINDOW_DELETE    -3       /* entry to be deleted during cleanup phase */
 #define WB_WINDOW_DESTROYED -2       /* window has been destroyed, entry remains */
@@ -820,6 +871,10 @@ typedef struct s_internal_window_entry       // the structure that identifies th
 #define WB_WINDOW_SET_FOCUS_ON_MAP 2 /* focus is to be set when the window is mapped */
 #define WB_WINDOW_DELETE_TIMEOUT 5   /* seconds to wait before deleting hash entry (was 30, now 5) */
 
+#define WB_GEOM_CACHE_NONE  0        /* geometry is not being tracked - always ask the X server */
+#define WB_GEOM_CACHE_VALID 1        /* 'geomCache' is current, maintained via ConfigureNotify and ReparentNotify */
+#define WB_GEOM_CACHE_STALE 2        /* tracked, but a local move/resize/reparent makes it stale until re-read */
+
 #define WB_CHECK_SET_FOCUS_ON_MAP(X) ((X).iWindowState == WB_WINDOW_SET_FOCUS_ON_MAP)
 #define WB_IS_WINDOW_UNMAPPED(X) ((X).iWindowState == WB_WINDOW_UNMAPPED || (X).iWindowState == WB_WINDOW_SET_FOCUS_ON_MAP)
 #define WB_IS_WINDOW_MAPPED(X) ((X).iWindowState == WB_WINDOW_MAPPED)
@@ -832,8 +887,13 @@ typedef struct s_internal_window_entry       // the structure that identifies th
 // NOT globally visible variables that define the application, default display params, hash table, etc.
 //------------------------------------------------------------------------------------------------------
 
-static _WINDOW_ENTRY_ sWBHashEntries[WINDOW_ENTRY_ARRAY_SIZE]={{0,0}};
-static volatile int nWBHashEntries = 0;
+static WINDOW_HASH_SLOT *pWindowHash = NULL;           // Robin Hood hash table (WBAlloc'd), 'nWindowHashMax' slots
+static unsigned int nWindowHashMax = 0;                 // always a power of 2 (or zero)
+static volatile int nWBHashEntries = 0;                 // number of entries in 'pWindowHash'
+static _WINDOW_ENTRY_ *pWindowEntryHead = NULL;         // list of all window entries, in the order they were created
+static _WINDOW_ENTRY_ *pWindowEntryTail = NULL;
+static _WINDOW_ENTRY_ *pFreeWindowEntries = NULL;       // deleted entries, for re-use (freed on exit)
+static int iWindowEntryEnumDepth = 0;                   // non-zero while walking the list - entries are not deleted
 static Window wWBFakeWindow = 0;  // fake window keeps me from losing connection when I close all windows
 static Window wIDApplication = None; // application window ID
 
@@ -855,8 +915,8 @@ XStandardColormap cmapDefault; // a copy of teh XStandardColormap for the Colorm
 /*                                                                    */
 /**********************************************************************/
 
-#define EVENT_ARRAY_SIZE 0x2000 /* this many events maximum */
-#define EVENT_ARRAY_MASK 0x1fff /* 'and' this for modular math */
+#define EVENT_BLOCK_SIZE 256 /* event entries are allocated this many at a time, as needed */
+#define PAINT_RECT_MAX 8 /* maximum number of distinct rectangles kept for a consolidated Expose event */
 
 /** \struct s_EVENT_ENTRY
   * \ingroup wcore_internal
@@ -866,34 +926,99 @@ XStandardColormap cmapDefault; // a copy of teh XStandardColormap for the Colorm
   * \ingroup wcore_internal
   * \brief Core (internal) structure for storing and dispatching events
   *
+  * Entries are re-linked (never copied) as they move between the free list and a display's queues
 **/
 typedef struct s_EVENT_ENTRY
 {
-  Display *pDisplay; ///< the Display pointer for the event
-  int iNext;         ///< index for 'next' in a linked list
-  Window wID;        ///< the window for which the event is queued
-  XEvent xEvt;       ///< the event I'm queueing
+  struct s_EVENT_ENTRY *pNext; ///< next entry in the queue (or the free list)
+  struct s_EVENT_ENTRY *pPrev; ///< previous entry in the queue, for O(1) removal
+  Window wID;                  ///< the window for which the event is queued
+  int nPaintRect;              ///< (paint queue only) number of valid entries in 'aPaintRect'
+  XRectangle aPaintRect[PAINT_RECT_MAX]; ///< (paint queue only) the exposed areas, merged as needed.  'xEvt' has the bounding rectangle.
+  WB_UINT64 tQueued;           ///< when the entry was queued (see __DispatchTimeIndex), or 0 if the dispatch statistics are disabled
+  XEvent xEvt;                 ///< the event I'm queueing
+} EVENT_ENTRY;
 
-  /** \brief alignment padding to make the struct exactly 256 bytes in length
-    *
-    * Make the structure 256 bytes in length in order to support variable length data payloads (in addition to the event stuff)
-    *
-    * TODO:  this may not be necessary
-  **/
-  char padding[256 - sizeof(Display *) - sizeof(Window) - sizeof(int) - sizeof(XEvent)];
+/** \struct s_EVENT_QUEUE
+  * \ingroup wcore_internal
+  * \copydoc EVENT_QUEUE
+**/
+/** \typedef EVENT_QUEUE
+  * \ingroup wcore_internal
+  * \brief Core (internal) structure for the event queues belonging to a single Display
+**/
+typedef struct s_EVENT_QUEUE
+{
+  struct s_EVENT_QUEUE *pNext; ///< next display's queues
+  Display *pDisplay;           ///< the Display that owns these queues
+  EVENT_ENTRY *pHead;          ///< first queued event (priority events are inserted here)
+  EVENT_ENTRY *pTail;          ///< last queued event
+  EVENT_ENTRY *pPaintHead;     ///< first (consolidated) Expose event, at most one per window
+  EVENT_ENTRY *pPaintTail;     ///< last Expose event
+} EVENT_QUEUE;
 
-} EVENT_ENTRY;
+static EVENT_QUEUE *pEventQueues = NULL;    // one per display (typically only one)
+static EVENT_QUEUE *pLastEventQueue = NULL; // most recently used, for a quick lookup
+static EVENT_ENTRY *pFreeEvents = NULL;     // free list
+static void **ppEventBlocks = NULL;         // WBAlloc'd blocks of EVENT_BLOCK_SIZE entries, freed on exit
+static int nEventBlocks = 0;
+static int nEventsQueued = 0;               // entries in use (in any queue), for WBDispatchStatsGauges
+static int nEventsQueuedMax = 0;            // high-water mark for 'nEventsQueued'
+static int nXEventsQueued = 0;              // Xlib's queue length the last time it was checked
+static int nXEventsQueuedMax = 0;           // high-water mark for 'nXEventsQueued'
+static int bDispatchStats = 1;              // see WBDispatchStatsEnable()
+static WB_HISTOGRAM histQueueAge;           // time that events spend in the internal queues
+
+// dispatch statistics time index, in microseconds (CLOCK_MONOTONIC, so that changes to the system time don't matter)
+static __inline__ WB_UINT64 __DispatchTimeIndex(void)
+{
+  return WBGetMonotonicTimeNS() / 1000;
+}
+
+static __inline__ void __DispatchStatsXQueued(int iQueued)
+{
+  nXEventsQueued = iQueued;
+
+  if(WB_UNLIKELY(iQueued > nXEventsQueuedMax))
+  {
+    nXEventsQueuedMax = iQueued;
+  }
+}
+
+/** \struct s_POSTED_EVENT
+  * \ingroup wcore_internal
+  * \copydoc POSTED_EVENT
+**/
+/** \typedef POSTED_EVENT
+  * \ingroup wcore_internal
+  * \brief Core (internal) structure for an event posted by a thread other than the event loop's thread
+  *
+  * Other threads can't touch the event queues (or the window list) directly, so WBPostEvent() and friends
+  * push a WBAlloc'd copy onto a lock-free stack instead, and wake up the event loop.  The event loop takes
+  * the entire stack with a single atomic exchange, reverses it, and re-posts each event in the original order.
+**/
+typedef struct s_POSTED_EVENT
+{
+  struct s_POSTED_EVENT *pNext; ///< next (older) entry
+  int iType;                    ///< one of the POSTED_EVENT_xxx values, identifying which 'WBPostXXX' function to use
+  Window wID;                   ///< the window ID that was passed to the 'post' function
+  unsigned int nDelay;          ///< the delay for WBPostDelayedEvent()
+  XEvent xEvt;                  ///< the event
+} POSTED_EVENT;
 
-static EVENT_ENTRY axWBEvt[EVENT_ARRAY_SIZE];
+#define POSTED_EVENT_NORMAL   0 /* WBPostEvent */
+#define POSTED_EVENT_PRIORITY 1 /* WBPostPriorityEvent */
+#define POSTED_EVENT_APP      2 /* WBPostAppEvent */
+#define POSTED_EVENT_DELAYED  3 /* WBPostDelayedEvent */
 
-static int iWBQueuedEvent = -1, iWBQueueLast = -1, iWBPaintEvent = -1, iWBPaintLast = -1, iWBFreeEvent = -1;
-static int iInitEventFlag = 0;
+static POSTED_EVENT * volatile pPostedEvents = NULL; // lock-free stack of events posted by other threads (newest first)
+static pthread_t thrdEventLoop;             // the thread that called WBInitDisplay (the event loop runs here)
+static int bHaveEventLoopThread = 0;        // non-zero once 'thrdEventLoop' is valid
 
 //static WBAppEvent pAppEventCallback = NULL;
 static int (* pAppEventCallback)(XEvent *pEvent) = NULL;
 
 
-#define TIMER_ARRAY_SIZE  512
 
 /** \struct s_TIMER_ENTRY
   * \ingroup wcore_internal
@@ -905,18 +1030,19 @@ static int (* pAppEventCallback)(XEvent *pEvent) = NULL;
 **/
 typedef struct s_TIMER_ENTRY
 {
-  struct s_TIMER_ENTRY *pNext;  ///< linked lists for performance
+  struct s_TIMER_ENTRY *pNext;  ///< next entry in the same (display, window) hash bucket
   WB_UINT64 lTimeIndex;          ///< time index for which this timer next expires
   unsigned long lTimeInterval;   ///< interval (or zero for one-shot timer)
+  int iHeapIndex;                ///< position of this entry within the timer heap
 
   Display *pDisplay;             ///< display associated with timer
   Window wID;                    ///< window to receive timer event
   long lID;                      ///< timer identifier
 } TIMER_ENTRY;
 
-static TIMER_ENTRY axWBTimer[TIMER_ARRAY_SIZE];
-static TIMER_ENTRY *pTimerEntryActive = NULL, *pTimerEntryFree = NULL;
-  // pointers for two linked lists.  entries must be in either 'active' or 'free' list.
+static TIMER_ENTRY **ppTimerHeap = NULL; // binary min-heap of WBAlloc'd timers, ordered by 'lTimeIndex'
+static TIMER_ENTRY **ppTimerHash = NULL; // hash buckets on (display, window), chained via 'pNext'
+static int nTimerHeap = 0, nTimerHeapMax = 0, nTimerHashMax = 0; // both sizes grow as powers of 2
 
 /** \struct s_DELAYED_EVENT_ENTRY
   * \ingroup wcore_internal
@@ -928,15 +1054,19 @@ static TIMER_ENTRY *pTimerEntryActive = NULL, *pTimerEntryFree = NULL;
 **/
 typedef struct s_DELAYED_EVENT_ENTRY
 {
-  struct s_DELAYED_EVENT_ENTRY *pNext;  ///< linked lists for performance
-  WB_UINT64 lTimeIndex;                  ///< time index for which this timer next expires
+  WB_UINT64 lTimeIndex;                  ///< time index at which the event is to be delivered
+  WB_UINT64 qwSequence;                  ///< order of posting, so that equal time indices are delivered FIFO
 
   XEvent event;                          ///< copy of delayed event
 } DELAYED_EVENT_ENTRY;
 
-static DELAYED_EVENT_ENTRY axWBDelayedEvent[TIMER_ARRAY_SIZE]; // same size as timers
-static DELAYED_EVENT_ENTRY *pDelayedEventEntryActive = NULL, *pDelayedEventEntryFree = NULL;
-  // pointers for two linked lists.  entries must be in either 'active' or 'free' list.
+static DELAYED_EVENT_ENTRY **ppDelayedEventHeap = NULL; // binary min-heap of WBAlloc'd entries, in delivery order
+static int nDelayedEventHeap = 0, nDelayedEventHeapMax = 0;
+static WB_UINT64 qwDelayedEventSequence = 0;
+
+// wakeup descriptors for WBWaitForEvent - an eventfd on Linux (both the same), otherwise a pipe.
+// [0] is polled by WBWaitForEvent(), [1] is written by WBWakeEventLoop()
+static int aWakeupFD[2] = { -1, -1 };
 
 
 /**********************************************************************/
@@ -952,19 +1082,32 @@ static __inline__ _WINDOW_ENTRY_ *WBGetWindowEntry(Window wID);
 static __inline__ _WINDOW_ENTRY_ *Debug_WBGetWindowEntry(Window wID, const char *szFunction, int nLine);
 #endif // NO_DEBUG
 
-static void __WBInitEvent();
+static void __WBExitEvent(void);
+static void __WindowEntryExit(void);
+static int __WBHasQueuedEvents(WB_DISPLAY pDisp);
 static int __WBAddEvent(WB_DISPLAY pDisp, Window wID, XEvent *pEvent);
 static void __WBDelWindowPaintEvents(WB_DISPLAY pDisp, Window wID);
 static void __WBDelWindowEvents(WB_DISPLAY pDisp, Window wID);
 static int __WBInsertPriorityEvent(WB_DISPLAY pDisp, Window wID, XEvent *pEvent);
 static int __WBNextPaintEvent(WB_DISPLAY pDisp, XEvent *pEvent, Window wID);
 static int __WBNextDisplayEvent(WB_DISPLAY pDisp, XEvent *pEvent);
+static int __WBDrainPostedEvents(void);
 static void WBInternalProcessExposeEvent(XExposeEvent *pEvent);
+static WBGC __InternalBeginPaint(Window wID, Region rgnBounds, WB_GEOM *pgBounds);
 static int __internal_alloc_WMHints(_WINDOW_ENTRY_ *pEntry);
 static Window __internal_GetParent(WB_DISPLAY pDisplay, Window wID, Window *pwRoot);
 static const char * __internal_event_type_string(int iEventType);
 static int __InternalCheckGetEvent(WB_DISPLAY pDisplay, XEvent *pEvent, Window wIDModal);
 static void DeletAllTimersForWindow(WB_DISPLAY pDisplay, Window wID);
+static void __DeleteAllTimers(void);
+static TIMER_ENTRY *__NextTimer(WB_DISPLAY pDisplay);
+static void __DeleteAllDelayedEvents(void);
+static int __NextDelayedEvent(WB_DISPLAY pDisplay);
+static WB_UINT64 __NextTimeIndex(WB_DISPLAY pDisplay);
+static int __InternalInitWakeup(void);
+static void __InternalExitWakeup(void);
+static void __InternalUpdateGeomCache(_WINDOW_ENTRY_ *pEntry, const XConfigureEvent *pEvent);
+static void __XCallStatsFree(void);
 
 void __InternalDestroyWindow(WB_DISPLAY pDisp, Window wID, _WINDOW_ENTRY_ *pEntry);
 
@@ -1161,6 +1304,176 @@ static int WBXIOErrorHandler(WB_DISPLAY pDisp)
 }
 
 
+/** \struct s_WELL_KNOWN_ATOM
+  * \ingroup wcore_internal
+  * \copydoc WELL_KNOWN_ATOM
+**/
+/** \typedef WELL_KNOWN_ATOM
+  * \ingroup wcore_internal
+  * \brief Core (internal) structure that associates a well-known Atom with its name (see WBInitAtoms())
+**/
+typedef struct s_WELL_KNOWN_ATOM
+{
+  Atom *pAtom;          ///< where to store the Atom, or NULL to simply look it up so that it's cached
+  const char *szName;   ///< the Atom name
+} WELL_KNOWN_ATOM;
+
+// 'WorkBench internal' atoms, assigned with WBGetAtom() - see WBInitDisplay()
+static const WELL_KNOWN_ATOM aWBInternalAtoms[] =
+{
+  // ClientMessage events (in general) for various notifications
+  { &aMENU_COMMAND,     "MENU_COMMAND" },
+  { &aMENU_UI_COMMAND,  "MENU_UI_COMMAND" },
+  { &aRESIZE_NOTIFY,    "RESIZE_NOTIFY" },
+  { &aCONTROL_NOTIFY,   "CONTROL_NOTIFY" },
+  { &aSCROLL_NOTIFY,    "SCROLL_NOTIFY" },
+  { &aQUERY_CLOSE,      "QUERY_CLOSE" },
+  { &aRECALC_LAYOUT,    "RECALC_LAYOUT" },
+  { &aDESTROY_NOTIFY,   "DESTROY_NOTIFY" },
+  { &aDLG_FOCUS,        "DLG_FOCUS" },
+  { &aSET_FOCUS,        "SET_FOCUS" },
+
+  // no doubt the above list will grow as new types of ClientMessage events are added
+
+  // internally-generated 'TIMER' event notification
+  { &aWB_TIMER,         "WB_TIMER" },
+
+  // additional 'window manager' ClientMessage events that are generated internally by the toolkit
+  // as a result of 'message translation' (basically user input 'RAW' to something more usable)
+  { &aWB_CHAR,          "WB_CHAR" },
+  { &aWB_POINTER,       "WB_POINTER" },
+  { &aWB_TASK,          "WB_TASK" },
+};
+
+// these atoms REQUIRE the use of 'XInternAtom' since they have 'global' scope for the entire X11 system
+static const WELL_KNOWN_ATOM aWBGlobalAtoms[] =
+{
+  // window manager messages (see open desktop specification for window managers)
+  // these should already be on the server since the WM would create them
+  { &aWM_PROTOCOLS,     "WM_PROTOCOLS" },
+  { &aWM_DELETE_WINDOW, "WM_DELETE_WINDOW" },
+  { &aWM_TAKE_FOCUS,    "WM_TAKE_FOCUS" },
+
+  // atoms used for fonts (font properties, basically)
+  { &aAVERAGE_WIDTH,    "AVERAGE_WIDTH" },
+
+  // atoms for the clipboard (these are all standards, should be on the server already)
+  { &aCLIPBOARD,        "CLIPBOARD" },
+  { &aMANAGER,          "MANAGER" },
+  { &aTARGET,           "TARGET" },
+  { &aINCR,             "INCR" },
+  { &aPIXEL,            "PIXEL" },
+  { &aTEXT,             "TEXT" },
+#ifdef X_HAVE_UTF8_STRING /* this indicates the extension is present - rarely would it NOT be */
+  { &aUTF8_STRING,      "UTF8_STRING" },
+#endif // X_HAVE_UTF8_STRING
+  { &aC_STRING,         "C_STRING" },
+  { &aCOMPOUND_TEXT,    "COMPOUND_TEXT" },
+  { &aTARGETS,          "TARGETS" },
+  { &aMULTIPLE,         "MULTIPLE" },
+  { &aTIMESTAMP,        "TIMESTAMP" },
+
+// other atoms that are pre-defined - left as comments for future reference, as needed
+//
+//  aPRIMARY          = XA_PRIMARY;   //XInternAtom(pDisplay, "PRIMARY", False);
+//  aSECONDARY        = XA_SECONDARY; //XInternAtom(pDisplay, "SECONDARY", False);
+//  aWINDOW           = XA_WINDOW;    //XInternAtom(pDisplay, "WINDOW", False);
+//  aBITMAP           = XA_BITMAP;    //XInternAtom(pDisplay, "BITMAP", False);
+//  aDRAWABLE         = XA_DRAWABLE;  //XInternAtom(pDisplay, "DRAWABLE", False);
+//  aCOLORMAP         = XA_COLORMAP;  //XInternAtom(pDisplay, "COLORMAP", False);
+//  aPIXMAP           = XA_PIXMAP;    //XInternAtom(pDisplay, "PIXMAP", False);
+//  aSTRING           = XA_STRING;    //XInternAtom(pDisplay, "STRING", False);
+
+  // and, of course, the string 'NULL' which should be globally defined
+  { &aNULL,             "NULL" },
+
+  // atoms that are looked up by name when windows, dialogs, and menus are created.  Looking
+  // them up now means they are cached, and won't need a round trip later on.
+  { NULL,               "_NET_CLOSE_WINDOW" },
+  { NULL,               "_NET_ACTIVE_WINDOW" },
+  { NULL,               "_NET_WM_STATE" },
+  { NULL,               "_NET_WM_STATE_MODAL" },
+  { NULL,               "_NET_WM_STATE_SKIP_TASKBAR" },
+  { NULL,               "_NET_WM_STATE_SKIP_PAGER" },
+  { NULL,               "_NET_WM_WINDOW_TYPE" },
+  { NULL,               "_NET_WM_WINDOW_TYPE_MENU" },
+  { NULL,               "_NET_WM_WINDOW_TYPE_SPLASH" },
+  { NULL,               "WM_NAME" },
+  { NULL,               "WM_ICON_NAME" },
+  { NULL,               "WM_TRANSIENT_FOR" },
+};
+
+#define WELL_KNOWN_ATOM_MAX 64 /* must be at least as large as the larger of the above arrays */
+
+static int __InternalInitAtomList(WB_DISPLAY pDisplay, const WELL_KNOWN_ATOM *pList, int nCount, int bInternal)
+{
+const char *apszNames[WELL_KNOWN_ATOM_MAX];
+Atom aAtoms[WELL_KNOWN_ATOM_MAX];
+int i1, iRval;
+
+
+  if(nCount > WELL_KNOWN_ATOM_MAX)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - too many atoms (%d)\n", __FUNCTION__, nCount);
+    return -1;
+  }
+
+  for(i1=0; i1 < nCount; i1++)
+  {
+    apszNames[i1] = pList[i1].szName;
+  }
+
+  if(bInternal)
+  {
+    iRval = WBGetAtoms(pDisplay, apszNames, nCount, aAtoms);
+  }
+  else
+  {
+    iRval = WBInternAtoms(pDisplay, apszNames, nCount, 0, aAtoms);
+  }
+
+  if(iRval < 0)
+  {
+    return iRval;
+  }
+
+  for(i1=0; i1 < nCount; i1++)
+  {
+    if(pList[i1].pAtom)
+    {
+      *(pList[i1].pAtom) = aAtoms[i1];
+    }
+  }
+
+  return iRval;
+}
+
+int WBInitAtoms(WB_DISPLAY pDisplay)
+{
+int iRval, iRval2;
+
+
+  if(!pDisplay)
+  {
+    pDisplay = pDefaultDisplay;
+  }
+
+  iRval = __InternalInitAtomList(pDisplay, aWBInternalAtoms,
+                                 sizeof(aWBInternalAtoms) / sizeof(aWBInternalAtoms[0]), 1);
+
+  iRval2 = __InternalInitAtomList(pDisplay, aWBGlobalAtoms,
+                                  sizeof(aWBGlobalAtoms) / sizeof(aWBGlobalAtoms[0]), 0);
+
+  if(iRval || iRval2)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - unable to assign some of the atoms (%d, %d)\n", __FUNCTION__, iRval, iRval2);
+
+    return 1;
+  }
+
+  return 0;
+}
+
 int WBInitDisplay(WB_DISPLAY pDisplay)
 {
 unsigned long long ullTick;
@@ -1169,6 +1482,9 @@ unsigned long long ullTick;
 
   pDefaultDisplay = pDisplay;
 
+  thrdEventLoop = pthread_self(); // events posted from any other thread go through 'pPostedEvents'
+  bHaveEventLoopThread = 1;
+
   // create a 'fake' window that will keep me from losing connection when I terminate the app
   wWBFakeWindow = XCreateSimpleWindow(pDisplay, DefaultRootWindow(pDisplay), -1, -1, 1, 1, 0, 0, 0);
 
@@ -1227,69 +1543,7 @@ unsigned long long ullTick;
   // To compensate, MANY of the atoms that I create will use WBGetAtom() rather than XInternAtom()
   // and are considered to be 'WorkBench internal' only - so don't use outside of the toolkit
 
-  // ClientMessage events (in general) for various notifications
-  aMENU_COMMAND     = WBGetAtom(pDisplay, "MENU_COMMAND");    //XInternAtom(pDisplay, "MENU_COMMAND", False);
-  aMENU_UI_COMMAND  = WBGetAtom(pDisplay, "MENU_UI_COMMAND"); //XInternAtom(pDisplay, "MENU_UI_COMMAND", False);
-  aRESIZE_NOTIFY    = WBGetAtom(pDisplay, "RESIZE_NOTIFY");   //XInternAtom(pDisplay, "RESIZE_NOTIFY", False);
-  aCONTROL_NOTIFY   = WBGetAtom(pDisplay, "CONTROL_NOTIFY");  //XInternAtom(pDisplay, "CONTROL_NOTIFY", False);
-  aSCROLL_NOTIFY    = WBGetAtom(pDisplay, "SCROLL_NOTIFY");   //XInternAtom(pDisplay, "SCROLL_NOTIFY", False);
-  aQUERY_CLOSE      = WBGetAtom(pDisplay, "QUERY_CLOSE");     //XInternAtom(pDisplay, "QUERY_CLOSE", False);
-  aRECALC_LAYOUT    = WBGetAtom(pDisplay, "RECALC_LAYOUT");   //XInternAtom(pDisplay, "QUERY_CLOSE", False);
-  aDESTROY_NOTIFY   = WBGetAtom(pDisplay, "DESTROY_NOTIFY");  //XInternAtom(pDisplay, "DESTROY_NOTIFY", False);
-  aDLG_FOCUS        = WBGetAtom(pDisplay, "DLG_FOCUS");       //XInternAtom(pDisplay, "DLG_FOCUS", False);
-  aSET_FOCUS        = WBGetAtom(pDisplay, "SET_FOCUS");       //XInternAtom(pDisplay, "SET_FOCUS", False);
-
-  // no doubt the above list will grow as new types of ClientMessage events are added
-
-  // internally-generated 'TIMER' event notification
-  aWB_TIMER         = WBGetAtom(pDisplay, "WB_TIMER");        //XInternAtom(pDisplay, "WB_TIMER", False);
-
-  // additional 'window manager' ClientMessage events that are generated internally by the toolkit
-  // as a result of 'message translation' (basically user input 'RAW' to something more usable)
-  aWB_CHAR          = WBGetAtom(pDisplay, "WB_CHAR");         //XInternAtom(pDisplay, "WB_CHAR", False);
-  aWB_POINTER       = WBGetAtom(pDisplay, "WB_POINTER");      //XInternAtom(pDisplay, "WB_POINTER", False);
-
-
-  // these next atoms REQUIRE the use of 'XInternAtom' since they have 'global' scope for the entire X11 system
-
-  // window manager messages (see open desktop specification for window managers)
-  // these should already be on the server since the WM would create them
-  aWM_PROTOCOLS     = XInternAtom(pDisplay, "WM_PROTOCOLS", False);
-  aWM_DELETE_WINDOW = XInternAtom(pDisplay, "WM_DELETE_WINDOW", False);
-  aWM_TAKE_FOCUS    = XInternAtom(pDisplay, "WM_TAKE_FOCUS", False);
-
-  // atoms used for fonts (font properties, basically)
-  aAVERAGE_WIDTH    = XInternAtom(pDisplay, "AVERAGE_WIDTH", False);
-
-  // atoms for the clipboard (these are all standards, should be on the server already)
-  aCLIPBOARD        = XInternAtom(pDisplay, "CLIPBOARD", False);
-  aMANAGER          = XInternAtom(pDisplay, "MANAGER", False);
-  aTARGET           = XInternAtom(pDisplay, "TARGET", False);
-  aINCR             = XInternAtom(pDisplay, "INCR", False);
-  aPIXEL            = XInternAtom(pDisplay, "PIXEL", False);
-  aTEXT             = XInternAtom(pDisplay, "TEXT", False);
-#ifdef X_HAVE_UTF8_STRING /* this indicates the extension is present - rarely would it NOT be */
-  aUTF8_STRING      = XInternAtom(pDisplay, "UTF8_STRING", False);
-#endif // X_HAVE_UTF8_STRING
-  aC_STRING         = XInternAtom(pDisplay, "C_STRING", False);
-  aCOMPOUND_TEXT    = XInternAtom(pDisplay, "COMPOUND_TEXT", False);
-  aTARGETS          = XInternAtom(pDisplay, "TARGETS", False);
-  aMULTIPLE         = XInternAtom(pDisplay, "MULTIPLE", False);
-  aTIMESTAMP        = XInternAtom(pDisplay, "TIMESTAMP", False);
-
-// other atoms that are pre-defined - left as comments for future reference, as needed
-//
-//  aPRIMARY          = XA_PRIMARY;   //XInternAtom(pDisplay, "PRIMARY", False);
-//  aSECONDARY        = XA_SECONDARY; //XInternAtom(pDisplay, "SECONDARY", False);
-//  aWINDOW           = XA_WINDOW;    //XInternAtom(pDisplay, "WINDOW", False);
-//  aBITMAP           = XA_BITMAP;    //XInternAtom(pDisplay, "BITMAP", False);
-//  aDRAWABLE         = XA_DRAWABLE;  //XInternAtom(pDisplay, "DRAWABLE", False);
-//  aCOLORMAP         = XA_COLORMAP;  //XInternAtom(pDisplay, "COLORMAP", False);
-//  aPIXMAP           = XA_PIXMAP;    //XInternAtom(pDisplay, "PIXMAP", False);
-//  aSTRING           = XA_STRING;    //XInternAtom(pDisplay, "STRING", False);
-
-  // and, of course, the string 'NULL' which should be globally defined
-  aNULL             = XInternAtom(pDisplay, "NULL", False);
+  WBInitAtoms(pDisplay); // two round trips in total, rather than one per atom
 
   // make sure my atoms work.  Mostly, they're pre-defined or 'WorkBench internal'
   // atoms,  so no reason why they should not
@@ -1310,6 +1564,7 @@ unsigned long long ullTick;
      aWB_CHAR          == None ||
      aWB_TIMER         == None ||
      aWB_POINTER       == None ||
+     aWB_TASK          == None ||
      aCLIPBOARD        == None ||
      aMANAGER          == None ||
      aTARGET           == None ||
@@ -1437,7 +1692,7 @@ void __InternalDestroyWindow(WB_DISPLAY pDisp, Window wID, _WINDOW_ENTRY_ *pEntr
   XClientMessageEvent xMsg;
   Status st;
   XImage *pTempImage;
-  int i1;
+  _WINDOW_ENTRY_ *pChild;
 
 
 //  WB_ERROR_PRINT("TEMPORARY - %s - Destroying window %u (%08xH), %d hash entries\n",
@@ -1445,48 +1700,46 @@ void __InternalDestroyWindow(WB_DISPLAY pDisp, Window wID, _WINDOW_ENTRY_ *pEntr
 
   // first, I want to destroy any child windows that have window entries, FIRST.  Do that now.
 
-  for(i1=0; i1 < WINDOW_ENTRY_ARRAY_SIZE; i1++)
-  {
-    if(WB_LIKELY(sWBHashEntries[i1].wID == WINDOW_ENTRY_UNUSED) ||
-       WB_LIKELY(sWBHashEntries[i1].wID == None))
-    {
-      continue;  // ignore 'None' and 'UNUSED'
-    }
+  iWindowEntryEnumDepth++; // entries won't be deleted while I walk the list
 
-    if(sWBHashEntries[i1].wID == wID)
+  for(pChild = pWindowEntryHead; pChild; pChild = pChild->pNextEntry)
+  {
+    if(pChild->wID == wID)
     {
 //      WB_ERROR_PRINT("TEMPORARY - %s - Destroy child windows, found 'me' %u (%08xH)\n",
 //                     __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
       continue;  // ignore "me"
     }
 
-    if(sWBHashEntries[i1].wParent == wID)
+    if(pChild->wParent == wID)
     {
-      if(WB_IS_WINDOW_BEING_DESTROYED(sWBHashEntries[i1]))
+      if(WB_IS_WINDOW_BEING_DESTROYED(*pChild))
       {
 //        WB_ERROR_PRINT("TEMPORARY - %s - child window already being destroyed %u (%08xH)\n",
-//                       __FUNCTION__, (unsigned int)sWBHashEntries[i1].wID, (unsigned int)sWBHashEntries[i1].wID);
+//                       __FUNCTION__, (unsigned int)pChild->wID, (unsigned int)pChild->wID);
       }
-      else if(WB_IS_WINDOW_DESTROYED(sWBHashEntries[i1])) // not already destroyed (or being deleted)
+      else if(WB_IS_WINDOW_DESTROYED(*pChild)) // not already destroyed (or being deleted)
       {
 //        WB_ERROR_PRINT("TEMPORARY - %s - child window already destroyed %u (%08xH)\n",
-//                       __FUNCTION__, (unsigned int)sWBHashEntries[i1].wID, (unsigned int)sWBHashEntries[i1].wID);
+//                       __FUNCTION__, (unsigned int)pChild->wID, (unsigned int)pChild->wID);
       }
-      else if(WB_TO_DELETE_WINDOW_ENTRY(sWBHashEntries[i1]))
+      else if(WB_TO_DELETE_WINDOW_ENTRY(*pChild))
       {
 //        WB_ERROR_PRINT("TEMPORARY - %s - child window entry to be deleted %u (%08xH)\n",
-//                       __FUNCTION__, (unsigned int)sWBHashEntries[i1].wID, (unsigned int)sWBHashEntries[i1].wID);
+//                       __FUNCTION__, (unsigned int)pChild->wID, (unsigned int)pChild->wID);
       }
       else
       {
 //        WB_ERROR_PRINT("TEMPORARY - %s - Destroying child window %u (%08xH)\n",
-//                       __FUNCTION__, (unsigned int)sWBHashEntries[i1].wID, (unsigned int)sWBHashEntries[i1].wID);
+//                       __FUNCTION__, (unsigned int)pChild->wID, (unsigned int)pChild->wID);
 
-        __InternalDestroyWindow(pDisp, sWBHashEntries[i1].wID, &(sWBHashEntries[i1]));
+        __InternalDestroyWindow(pDisp, pChild->wID, pChild);
       }
     }
   }
 
+  iWindowEntryEnumDepth--;
+
 
   if(!pEntry || !(pEntry->eWMProtocols & WMPropertiesWMProtocols_DeleteWindow))
   {
@@ -1644,11 +1897,13 @@ destroy_without_wm:
 
 void WBExit()
 {
-int i1;
+_WINDOW_ENTRY_ *pEntry;
 //Window wIDRoot, wIDTemp;
 
   bQuitFlag = TRUE;  // in case this makes something happen
 
+  WBThreadPoolExit(); // worker threads stop before anything else goes away
+
   WB_DEBUG_PRINT(DebugLevel_Heavy | DebugSubSystem_Init,
                  "TRACE:  WBExit\n");
 
@@ -1664,13 +1919,16 @@ int i1;
 
   XFlush(pDefaultDisplay);
 
-  // for each remaining window in my list, destroy it
-  for(i1=WINDOW_ENTRY_ARRAY_MAX - 1; i1 >= 0; i1--)
+  // for each remaining window in my list, destroy it (most recently created first)
+
+  iWindowEntryEnumDepth++; // entries won't be deleted while I walk the list
+
+  for(pEntry = pWindowEntryTail; pEntry; pEntry = pEntry->pPrevEntry)
   {
-    WB_DISPLAY pDisp = sWBHashEntries[i1].pDisplay;
-    Window wID = sWBHashEntries[i1].wID;
+    WB_DISPLAY pDisp = pEntry->pDisplay;
+    Window wID = pEntry->wID;
 
-    if(!wID || wID == WINDOW_ENTRY_UNUSED)
+    if(!wID)
     {
       continue;
     }
@@ -1680,13 +1938,13 @@ int i1;
       pDisp = pDefaultDisplay;
     }
 
-    if(WB_IS_WINDOW_MAPPED(sWBHashEntries[i1]))
+    if(WB_IS_WINDOW_MAPPED(*pEntry))
     {
       WB_ERROR_PRINT("INFO: %s destroying window %d\n", __FUNCTION__, (int)wID);
 
       // send a 'destroy' request to the window manager
 
-      __InternalDestroyWindow(pDisp, wID, &(sWBHashEntries[i1]));
+      __InternalDestroyWindow(pDisp, wID, pEntry);
     }
 
     WBUnregisterWindowCallback(wID);
@@ -1694,6 +1952,8 @@ int i1;
     XFlush(pDisp);
   }
 
+  iWindowEntryEnumDepth--;
+
 // TODO:  cache font sets within the font helper, and manage all of them there.
 //  Font_OnExit(pDefaultDisplay); // call this _BEFORE_ I close the display
 
@@ -1719,6 +1979,11 @@ int i1;
     END_XCALL_DEBUG_WRAPPER
   }
 
+  // report the X request statistics (if any), and stop collecting them before the display goes away
+
+  WBXCallStatsDump(0);
+  __XCallStatsFree();
+
   BEGIN_XCALL_DEBUG_WRAPPER
   XSync(pDefaultDisplay, FALSE);  // try sync'ing first to avoid certain errors
   XCloseDisplay(pDefaultDisplay); // display is to be destroyed now
@@ -1727,6 +1992,11 @@ int i1;
   wWBFakeWindow = None;
   pDefaultDisplay = NULL;
 
+  __DeleteAllTimers();           // any remaining timers
+  __DeleteAllDelayedEvents();    // and delayed events
+  __WBExitEvent();               // event queues
+  __WindowEntryExit();           // window entries and the hash table
+  __InternalExitWakeup();        // WBWaitForEvent wakeup descriptors
   __internal_font_helper_exit(); // font helper
   PXM_OnExit();                  // pixmap_helper
   CHOnExit();                    // config_helper
@@ -1868,7 +2138,6 @@ void WBInitSizeHints(XSizeHints *pSH, WB_DISPLAY pDisplay, int iMinHeight, int i
 int WBShowModal(Window wID, int bMenuSplashFlag)
 {
 int iRval = -1;
-int iSleepPeriod;
 WB_GEOM geom;
 _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 
@@ -1937,8 +2206,6 @@ _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 
 //  WB_ERROR_PRINT("TEMPORARY:  %s - begin modal event processing\n", __FUNCTION__);
 
-  iSleepPeriod = MIN_EVENT_LOOP_SLEEP_PERIOD; // initial value, in microseconds
-
   while(!bQuitFlag)
   {
     XEvent event;
@@ -1965,21 +2232,11 @@ _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 
     if(!__InternalCheckGetEvent(pEntry->pDisplay, &event, wID))
     {
-      WBDelay(iSleepPeriod);  // 100 microsecs (0.1 milliseconds) initially, grows over time
-      if(iSleepPeriod < MAX_EVENT_LOOP_SLEEP_PERIOD) // up to 'MAX_EVENT_LOOP_SLEEP_PERIOD' microseconds
-      {
-        iSleepPeriod += (iSleepPeriod >> 1); // increase by 50%
-      }
-      else
-      {
-        iSleepPeriod = MAX_EVENT_LOOP_SLEEP_PERIOD; // the maximum
-      }
+      WBWaitForEvent(pEntry->pDisplay); // blocks until there is something to do
 
       continue;
     }
 
-    iSleepPeriod = MIN_EVENT_LOOP_SLEEP_PERIOD; // reset to the initial value
-
     // check for application events - these will continue to happen
     // even during a modal loop.
 
@@ -2399,361 +2656,526 @@ void WBUnregisterAppCallback()
 /**********************************************************************/
 
 
-static __inline__ void InternalRestoreWindowDefaults(int iIndex)
-{
-  sWBHashEntries[iIndex].szClassName = NULL; // no class name, initially
-  sWBHashEntries[iIndex].wParent = 0;  // mark it as "unassigned"
-  sWBHashEntries[iIndex].idCursor = WB_DEFAULT_CURSOR;
-  sWBHashEntries[iIndex].idDefaultCursor = WB_DEFAULT_CURSOR;
-  sWBHashEntries[iIndex].iWaitCursorCount = 0;
-  sWBHashEntries[iIndex].curRecent = None;
-  bzero(&(sWBHashEntries[iIndex].geomAbsolute), sizeof(sWBHashEntries[iIndex].geomAbsolute));
-  sWBHashEntries[iIndex].rgnClip = 0;
-  sWBHashEntries[iIndex].rgnPaint = 0;
-
-  sWBHashEntries[iIndex].iModalFlag = 0;
-  sWBHashEntries[iIndex].iModalReturn = -1;
-
-  sWBHashEntries[iIndex].width = sWBHashEntries[iIndex].height
-    = sWBHashEntries[iIndex].border = 0; // make sure these are zero as well (indicates 'not yet visible')
+// Robin Hood hashing - see 'ALGORITHMS AND OTHER RELATED NOTES' at the top of this file
 
+static __inline__ unsigned int __WindowHashHome(Window wID, unsigned int nMax)
+{
+WB_UINT32 uiKey = (WB_UINT32)wID ^ (WB_UINT32)(((unsigned long)wID >> 16) >> 16);
 
-  // this is primarily for when I unregister the callback (I must also unregister the menu)
-  sWBHashEntries[iIndex].wIDMenu = 0;
-  sWBHashEntries[iIndex].pMenuCallback = 0;
-  sWBHashEntries[iIndex].iWindowState = WB_WINDOW_UNMAPPED;
+  // Fibonacci hashing.  Consecutive window IDs end up well spread out.
 
-  sWBHashEntries[iIndex].eWindowType = WMPropertiesWindowType_Normal;  // TODO: notify window manager?
-  sWBHashEntries[iIndex].eWMProtocols = WMPropertiesWMProtocols_None;  // TODO: notify window manager?
+  uiKey *= 0x9e3779b1U;
 
-  // zero out the window data (TODO: zero out everything?)
-  bzero(sWBHashEntries[iIndex].aWindowData, sizeof(sWBHashEntries[iIndex].aWindowData));
+  return (unsigned int)((uiKey ^ (uiKey >> 15)) & (nMax - 1));
 }
 
-//static /*__inline*/ WBWindow WBWindowFromWindow(Window wID)
-//{
-//  return (WBWindow)((unsigned long long)wID | WBWINDOW_FLAGS_NORMAL);
-//}
-
-//static /*__inline*/ Window WBWindowToWindow(WBWindow wID)
-//{
-//  return (Window)(wID & WBWINDOW_MASK);
-//}
-
-
-// WBGetWindowEntry - the debug version indicates what the caller's line number and function are
+// how far slot 'uiIndex' is from the 'home' slot for 'wID'
+static __inline__ unsigned int __WindowHashDistance(unsigned int uiIndex, Window wID)
+{
+  return (uiIndex - __WindowHashHome(wID, nWindowHashMax)) & (nWindowHashMax - 1);
+}
 
-#ifdef NO_DEBUG
-static /*__inline__*/ _WINDOW_ENTRY_ *WBGetWindowEntry(Window wID)
-#else
-#define WBGetWindowEntry(X) Debug_WBGetWindowEntry(X, __FUNCTION__, __LINE__)
-static /*__inline__*/ _WINDOW_ENTRY_ *Debug_WBGetWindowEntry(Window wID, const char *szFunction, int nLine)
-#endif // NO_DEBUG
+// returns the slot index for 'wID' in 'pWindowHash', or -1 if not found
+static __inline__ int __WindowHashFind(Window wID)
 {
-  int i1, iStart;
+unsigned int uiIndex, uiDist;
+
 
-  if(!nWBHashEntries)
+  if(WB_UNLIKELY(!nWBHashEntries) || WB_UNLIKELY(wID == None))
   {
-#ifndef NO_DEBUG
-    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_Window,
-                   "%s:%d - Window hash table empty, %d (%08xH) not found\n",
-                   szFunction, nLine, (int)wID, (int)wID);
-#endif // NO_DEBUG
-    return(NULL);
+    return -1;
   }
 
-  i1 = iStart = WINDOW_ENTRY_HASH(wID);
+  uiIndex = __WindowHashHome(wID, nWindowHashMax);
+
+  // the table is never more than half full, so there is always an empty slot to stop at
 
-  while(sWBHashEntries[i1].wID)  // this must be assigned to zero for this to work properly
+  for(uiDist=0; ; uiDist++, uiIndex = (uiIndex + 1) & (nWindowHashMax - 1))
   {
-    if(sWBHashEntries[i1].wID == wID)
+    if(WB_LIKELY(pWindowHash[uiIndex].wID == wID))
     {
-      gettimeofday(&(sWBHashEntries[i1].tvLastActivity), NULL);
-      return(sWBHashEntries + i1);
+      return (int)uiIndex;
     }
 
-    i1++;
-    i1 &= WINDOW_ENTRY_ARRAY_MAX;
-
-    if(i1 == iStart)
-      break;
+    if(pWindowHash[uiIndex].wID == None ||
+       __WindowHashDistance(uiIndex, pWindowHash[uiIndex].wID) < uiDist)
+    {
+      return -1; // 'wID' would have displaced this one, so it's not here
+    }
   }
-
-#ifndef NO_DEBUG
-    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_Window,
-                   "%s:%d - Window ID %d (%08xH) not found\n",
-                   szFunction, nLine, (int)wID, (int)wID);
-#endif // NO_DEBUG
-
-  return(NULL);
 }
 
-// window callback registration - this also adds a window entry if one does
-// not already exist for the specified window ID.  This function assumes
-// that the window's display is the default display.
-
-static _WINDOW_ENTRY_ *__AddOrLocateEntry(Window wID)
+// insert an entry that is known not to be present.  The caller must ensure there is room.
+static void __WindowHashInsert(Window wID, _WINDOW_ENTRY_ *pEntry)
 {
-register int i1, i2, iStart;
-_WINDOW_ENTRY_ *pRval = NULL;
+WINDOW_HASH_SLOT slot, slotTemp;
+unsigned int uiIndex, uiDist, uiResDist;
 
 
-  i2 = -1;  // 'unused' entry marker
-  i1 = WINDOW_ENTRY_HASH(wID);
+  slot.wID = wID;
+  slot.pEntry = pEntry;
 
-  if(!nWBHashEntries)
-  {
-    WB_DEBUG_PRINT(DebugLevel_Excessive | DebugSubSystem_Window,
-                   "__AddOrLocateEntry - zero out window hash/array since it's empty\n");
-    bzero(sWBHashEntries, sizeof(sWBHashEntries));
-  }
-  else
-  {
-    // keep track of the one I start with as 'iStart'
+  uiIndex = __WindowHashHome(wID, nWindowHashMax);
 
-    iStart = i1;
+  for(uiDist=0; pWindowHash[uiIndex].wID != None; uiDist++, uiIndex = (uiIndex + 1) & (nWindowHashMax - 1))
+  {
+    uiResDist = __WindowHashDistance(uiIndex, pWindowHash[uiIndex].wID);
 
-    while(sWBHashEntries[i1].wID)  // the array must be pre-assigned to zero for this to work properly
+    if(uiResDist < uiDist) // the resident is closer to home than I am, so it moves instead
     {
-      if(sWBHashEntries[i1].wID == wID)
-      {
-        pRval = sWBHashEntries + i1;
-        break;
-      }
-
-      if(sWBHashEntries[i1].wID == WINDOW_ENTRY_UNUSED)
-      {
-        i2 = i1;  // keep track of the 1st unused entry in the chain
-      }
-
-      i1++;
-      i1 &= WINDOW_ENTRY_ARRAY_MAX;
+      slotTemp = pWindowHash[uiIndex];
+      pWindowHash[uiIndex] = slot;
+      slot = slotTemp;
 
-      if(i1 == iStart)
-      {
-        i1 = -1;  // error flag (hash table full)
-        break;
-      }
+      uiDist = uiResDist;
     }
   }
 
-  // if pRval is NULL, I need to add the entry
-  // in that case, either i2 or i1 points to it.
-  // if both i1 and i2 are negative, it's an error
-  // The number of active entries is limited to 3/4
-  // of the hash table size for speed and efficiency.
+  pWindowHash[uiIndex] = slot;
+}
+
+// remove the entry in slot 'iIndex', shifting the rest of its probe sequence back by one
+static void __WindowHashRemove(int iIndex)
+{
+unsigned int uiIndex, uiNext;
+
+
+  for(uiIndex = (unsigned int)iIndex; ; uiIndex = uiNext)
+  {
+    uiNext = (uiIndex + 1) & (nWindowHashMax - 1);
+
+    if(pWindowHash[uiNext].wID == None ||
+       !__WindowHashDistance(uiNext, pWindowHash[uiNext].wID)) // already at home
+    {
+      break;
+    }
+
+    pWindowHash[uiIndex] = pWindowHash[uiNext];
+  }
+
+  pWindowHash[uiIndex].wID = None;
+  pWindowHash[uiIndex].pEntry = NULL;
+}
+
+// make room for one more entry, keeping the table at most half full.  returns non-zero on error
+static int __WindowHashReserve(void)
+{
+WINDOW_HASH_SLOT *pOld;
+unsigned int i1, nOldMax, nNewMax;
 
-  if(!pRval)
-  {
-    if(i1 < 0 && i2 < 0)
-      return NULL;
 
-    // --------------------------
-    // HASH TABLE SIZE LIMITATION
-    // --------------------------
+  if((unsigned int)(nWBHashEntries + 1) * 2 <= nWindowHashMax)
+  {
+    return 0;
+  }
+
+  nNewMax = nWindowHashMax ? nWindowHashMax * 2 : WINDOW_HASH_INITIAL_SIZE;
 
-    // if 4 times the # of entries is larger than 3 times the # of hash entries,
-    // then the hash is 3/4 full and grossly inefficient.  This is my limit.
+  pOld = pWindowHash;
+  nOldMax = nWindowHashMax;
 
-    if((nWBHashEntries * 4) > (3 * sizeof(sWBHashEntries)/sizeof(sWBHashEntries[0]))) // an efficient algorithm
-      return NULL;  // enforce hash table twice maximum
+  pWindowHash = (WINDOW_HASH_SLOT *)WBAlloc(nNewMax * sizeof(*pWindowHash));
 
-    nWBHashEntries++;  // keep track
+  if(!pWindowHash)
+  {
+    pWindowHash = pOld;
 
-    if(i2 >= 0)
-      i1 = i2;
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory to grow the window hash table to %u\n",
+                   __FUNCTION__, nNewMax);
+    return -1;
+  }
 
-    pRval = sWBHashEntries + i1;
-    pRval->wID = wID;  // mark it "mine"
-    pRval->pDisplay = pDefaultDisplay;  // for now - TODO get the real display
-    pRval->pImage = NULL;               // pre-assign the cached image to NULL
+  memset(pWindowHash, 0, nNewMax * sizeof(*pWindowHash));
+  nWindowHashMax = nNewMax;
 
-    InternalRestoreWindowDefaults(i1);
+  for(i1=0; i1 < nOldMax; i1++)
+  {
+    if(pOld[i1].wID != None)
+    {
+      __WindowHashInsert(pOld[i1].wID, pOld[i1].pEntry);
+    }
+  }
 
-    WBRestoreDefaultCursor(wID);  // assign the default cursor for a new entry
+  if(pOld)
+  {
+    WBFree(pOld);
   }
 
+  return 0;
+}
+
+// get a zeroed entry (from the free list if possible) and add it to the end of the list of entries
+static _WINDOW_ENTRY_ *__WindowEntryAlloc(void)
+{
+_WINDOW_ENTRY_ *pRval = pFreeWindowEntries;
+
+
   if(pRval)
   {
-    gettimeofday(&(pRval->tvLastActivity), NULL);
+    pFreeWindowEntries = pRval->pNextEntry;
+  }
+  else
+  {
+    pRval = (_WINDOW_ENTRY_ *)WBAlloc(sizeof(*pRval));
+
+    if(!pRval)
+    {
+      return NULL;
+    }
+  }
+
+  bzero(pRval, sizeof(*pRval));
+
+  pRval->pPrevEntry = pWindowEntryTail;
+
+  if(pWindowEntryTail)
+  {
+    pWindowEntryTail->pNextEntry = pRval;
+  }
+  else
+  {
+    pWindowEntryHead = pRval;
+  }
+
+  pWindowEntryTail = pRval;
+
+  return pRval;
+}
+
+// remove an entry from the list of entries and put it on the free list.  The memory stays valid.
+static void __WindowEntryFree(_WINDOW_ENTRY_ *pEntry)
+{
+  if(pEntry->pPrevEntry)
+  {
+    pEntry->pPrevEntry->pNextEntry = pEntry->pNextEntry;
+  }
+  else
+  {
+    pWindowEntryHead = pEntry->pNextEntry;
+  }
+
+  if(pEntry->pNextEntry)
+  {
+    pEntry->pNextEntry->pPrevEntry = pEntry->pPrevEntry;
+  }
+  else
+  {
+    pWindowEntryTail = pEntry->pPrevEntry;
+  }
+
+  pEntry->pPrevEntry = NULL;
+  pEntry->pNextEntry = pFreeWindowEntries;
+  pFreeWindowEntries = pEntry;
+}
+
+static __inline__ void InternalRestoreWindowDefaults(_WINDOW_ENTRY_ *pEntry)
+{
+  pEntry->szClassName = NULL; // no class name, initially
+  pEntry->wParent = 0;  // mark it as "unassigned"
+  pEntry->idCursor = WB_DEFAULT_CURSOR;
+  pEntry->idDefaultCursor = WB_DEFAULT_CURSOR;
+  pEntry->iWaitCursorCount = 0;
+  pEntry->curRecent = None;
+  bzero(&(pEntry->geomAbsolute), sizeof(pEntry->geomAbsolute));
+  bzero(&(pEntry->geomCache), sizeof(pEntry->geomCache));
+  pEntry->iGeomCacheState = WB_GEOM_CACHE_NONE; // until the first ConfigureNotify
+  pEntry->rgnClip = 0;
+  pEntry->rgnPaint = 0;
+  pEntry->rgnExpose = 0;
+  pEntry->iCompressFlags = 0;
+  pEntry->iKeyRepeat = 0;
+
+  pEntry->iModalFlag = 0;
+  pEntry->iModalReturn = -1;
+
+  pEntry->width = pEntry->height
+    = pEntry->border = 0; // make sure these are zero as well (indicates 'not yet visible')
+
+
+  // this is primarily for when I unregister the callback (I must also unregister the menu)
+  pEntry->wIDMenu = 0;
+  pEntry->pMenuCallback = 0;
+  pEntry->iWindowState = WB_WINDOW_UNMAPPED;
+
+  pEntry->eWindowType = WMPropertiesWindowType_Normal;  // TODO: notify window manager?
+  pEntry->eWMProtocols = WMPropertiesWMProtocols_None;  // TODO: notify window manager?
+
+  // zero out the window data (TODO: zero out everything?)
+  bzero(pEntry->aWindowData, sizeof(pEntry->aWindowData));
+}
+
+//static /*__inline*/ WBWindow WBWindowFromWindow(Window wID)
+//{
+//  return (WBWindow)((unsigned long long)wID | WBWINDOW_FLAGS_NORMAL);
+//}
+
+//static /*__inline*/ Window WBWindowToWindow(WBWindow wID)
+//{
+//  return (Window)(wID & WBWINDOW_MASK);
+//}
+
+
+// WBGetWindowEntry - the debug version indicates what the caller's line number and function are
+
+#ifdef NO_DEBUG
+static /*__inline__*/ _WINDOW_ENTRY_ *WBGetWindowEntry(Window wID)
+#else
+#define WBGetWindowEntry(X) Debug_WBGetWindowEntry(X, __FUNCTION__, __LINE__)
+static /*__inline__*/ _WINDOW_ENTRY_ *Debug_WBGetWindowEntry(Window wID, const char *szFunction, int nLine)
+#endif // NO_DEBUG
+{
+int i1;
+_WINDOW_ENTRY_ *pRval;
+
+
+  i1 = __WindowHashFind(wID);
+
+  if(WB_LIKELY(i1 >= 0))
+  {
+    pRval = pWindowHash[i1].pEntry;
+
+    if(WB_UNLIKELY(pRval->iWindowState == WB_WINDOW_DELETE))
+    {
+      pRval->qwLastActivity = WBGetTimeIndex(); // still in use, so postpone deleting it
+    }
+
+    return pRval;
+  }
+
+#ifndef NO_DEBUG
+    WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_Window,
+                   "%s:%d - Window ID %d (%08xH) not found\n",
+                   szFunction, nLine, (int)wID, (int)wID);
+#endif // NO_DEBUG
+
+  return(NULL);
+}
+
+// window callback registration - this also adds a window entry if one does
+// not already exist for the specified window ID.  This function assumes
+// that the window's display is the default display.
+
+static _WINDOW_ENTRY_ *__AddOrLocateEntry(Window wID)
+{
+int i1;
+_WINDOW_ENTRY_ *pRval;
+
+
+  if(wID == None)
+  {
+    return NULL;
+  }
+
+  i1 = __WindowHashFind(wID);
+
+  if(i1 >= 0)
+  {
+    pRval = pWindowHash[i1].pEntry;
+
+    if(pRval->iWindowState == WB_WINDOW_DELETE)
+    {
+      pRval->qwLastActivity = WBGetTimeIndex(); // still in use, so postpone deleting it
+    }
+
+    return pRval;
+  }
+
+  // not found, so add it
+
+  if(__WindowHashReserve())
+  {
+    return NULL;
+  }
+
+  pRval = __WindowEntryAlloc();
+
+  if(!pRval)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory for window entry, %d (%08xH)\n",
+                   __FUNCTION__, (int)wID, (int)wID);
+    return NULL;
   }
 
+  __WindowHashInsert(wID, pRval);
+  nWBHashEntries++;  // keep track
+
+  pRval->wID = wID;  // mark it "mine"
+  pRval->pDisplay = pDefaultDisplay;  // for now - TODO get the real display
+  pRval->pImage = NULL;               // pre-assign the cached image to NULL
+
+  InternalRestoreWindowDefaults(pRval);
+
+  WBRestoreDefaultCursor(wID);  // assign the default cursor for a new entry
+
   return pRval;
 }
 
-static void __WindowEntryRestoreDefaultResources(int iIndex)
+static void __WindowEntryRestoreDefaultResources(_WINDOW_ENTRY_ *pEntry)
 {
   WB_DISPLAY pDisp = pDefaultDisplay;
 
-  if(sWBHashEntries[iIndex].pDisplay)
+  if(pEntry->pDisplay)
   {
-    pDisp = sWBHashEntries[iIndex].pDisplay;
+    pDisp = pEntry->pDisplay;
   }
 
   BEGIN_XCALL_DEBUG_WRAPPER
-//  if(sWBHashEntries[iIndex].fontSet != None && sWBHashEntries[iIndex].fontSet != fontsetDefault)  // must delete it
+//  if(pEntry->fontSet != None && pEntry->fontSet != fontsetDefault)  // must delete it
 //  {
-//    XFreeFontSet(pDisp, sWBHashEntries[iIndex].fontSet);
-//    sWBHashEntries[iIndex].fontSet = None;
+//    XFreeFontSet(pDisp, pEntry->fontSet);
+//    pEntry->fontSet = None;
 //  }
-//  if(sWBHashEntries[iIndex].pFontStruct && sWBHashEntries[iIndex].pFontStruct != pDefaultFont)  // must delete it
+//  if(pEntry->pFontStruct && pEntry->pFontStruct != pDefaultFont)  // must delete it
 //  {
-//    XFreeFont(pDisp, sWBHashEntries[iIndex].pFontStruct);
-//    sWBHashEntries[iIndex].pFontStruct = NULL;
+//    XFreeFont(pDisp, pEntry->pFontStruct);
+//    pEntry->pFontStruct = NULL;
 //  }
-  if(sWBHashEntries[iIndex].pFont && sWBHashEntries[iIndex].pFont != pDefaultFont)  // must delete it
+  if(pEntry->pFont && pEntry->pFont != pDefaultFont)  // must delete it
   {
-    WBFreeFont(pDisp, sWBHashEntries[iIndex].pFont);
-    sWBHashEntries[iIndex].pFont = NULL;
+    WBFreeFont(pDisp, pEntry->pFont);
+    pEntry->pFont = NULL;
   }
-  if(sWBHashEntries[iIndex].pxIcon)
+  if(pEntry->pxIcon)
   {
-    XFreePixmap(pDisp, sWBHashEntries[iIndex].pxIcon);
-    sWBHashEntries[iIndex].pxIcon = 0;
+    XFreePixmap(pDisp, pEntry->pxIcon);
+    pEntry->pxIcon = 0;
   }
-  if(sWBHashEntries[iIndex].pxMask)
+  if(pEntry->pxMask)
   {
-    XFreePixmap(pDisp, sWBHashEntries[iIndex].pxMask);
-    sWBHashEntries[iIndex].pxMask = 0;
+    XFreePixmap(pDisp, pEntry->pxMask);
+    pEntry->pxMask = 0;
   }
-  if(sWBHashEntries[iIndex].pWMHints)
+  if(pEntry->pWMHints)
   {
-    XFree(sWBHashEntries[iIndex].pWMHints);
-    sWBHashEntries[iIndex].pWMHints = NULL;
+    XFree(pEntry->pWMHints);
+    pEntry->pWMHints = NULL;
   }
-  if(sWBHashEntries[iIndex].curRecent != None)
+  if(pEntry->curRecent != None)
   {
-    XFreeCursor(pDisp, sWBHashEntries[iIndex].curRecent);
-    sWBHashEntries[iIndex].curRecent = None;
+    XFreeCursor(pDisp, pEntry->curRecent);
+    pEntry->curRecent = None;
   }
-  if(sWBHashEntries[iIndex].rgnClip != 0)
+  if(pEntry->rgnClip != 0)
   {
-    XDestroyRegion(sWBHashEntries[iIndex].rgnClip);
-    sWBHashEntries[iIndex].rgnClip = 0;
+    XDestroyRegion(pEntry->rgnClip);
+    pEntry->rgnClip = 0;
   }
-  if(sWBHashEntries[iIndex].rgnPaint != 0)
+  if(pEntry->rgnPaint != 0)
   {
     WB_WARN_PRINT("WARNING:  paint region non-zero in __WindowEntryRestoreDefaultResources\n");
-    XDestroyRegion(sWBHashEntries[iIndex].rgnPaint);
-    sWBHashEntries[iIndex].rgnPaint = 0;
+    XDestroyRegion(pEntry->rgnPaint);
+    pEntry->rgnPaint = 0;
+  }
+  if(pEntry->rgnExpose != 0)
+  {
+    XDestroyRegion(pEntry->rgnExpose);
+    pEntry->rgnExpose = 0;
   }
-  if(sWBHashEntries[iIndex].pImage != NULL)
+  if(pEntry->pImage != NULL)
   {
-    XDestroyImage(sWBHashEntries[iIndex].pImage);
-    sWBHashEntries[iIndex].pImage = NULL;
+    XDestroyImage(pEntry->pImage);
+    pEntry->pImage = NULL;
   }
   END_XCALL_DEBUG_WRAPPER
 
 }
 
-static void __WindowEntryDestructor(int iIndex)
+static void __WindowEntryDestructor(_WINDOW_ENTRY_ *pEntry)
 {
-int iPrev, iNext;
+int iIndex;
 
-  __WindowEntryRestoreDefaultResources(iIndex);  // make sure no resources are allocated
+  __WindowEntryRestoreDefaultResources(pEntry);  // make sure no resources are allocated
 
-  sWBHashEntries[iIndex].pCallback = 0;
-  sWBHashEntries[iIndex].pDisplay = NULL;  // must happen AFTER restoring default resources
+  pEntry->pCallback = 0;
+  pEntry->pDisplay = NULL;  // must happen AFTER restoring default resources
 
   // restore these and additional default values
-  InternalRestoreWindowDefaults(iIndex);
-
-  //////////////////////////////////////////////////////////////////////////////////////////////
-  //   _   _           _       _____     _     _         ____ _                               //
-  //  | | | | __ _ ___| |__   |_   _|_ _| |__ | | ___   / ___| | ___  __ _ _ __  _   _ _ __   //
-  //  | |_| |/ _` / __| '_ \    | |/ _` | '_ \| |/ _ \ | |   | |/ _ \/ _` | '_ \| | | | '_ \  //
-  //  |  _  | (_| \__ \ | | |   | | (_| | |_) | |  __/ | |___| |  __/ (_| | | | | |_| | |_) | //
-  //  |_| |_|\__,_|___/_| |_|   |_|\__,_|_.__/|_|\___|  \____|_|\___|\__,_|_| |_|\__,_| .__/  //
-  //                                                                                  |_|     //
-  //////////////////////////////////////////////////////////////////////////////////////////////
-
-  // NOW, I have to 'zero out' or mark the entry 'unused'.  To do this I
-  // have to define what an unused window ID is ('WINDOW_ENTRY_UNUSED').
-  // (this MUST happen or the hash table won't work)
-  // there are a couple of cases where deleting an entry might break a 'chain'
-  // As a result I need to ensure that I make use of 'unused' markers and only
-  // remove them when the final entry in the chain is followed by a 'NULL'.
-  //
-  // Preceding entries that aren't 'NULL' indicate I am part of a 'chain' and
-  // so I can't mark it 'NULL' if this entry isn't the last entry in the 'chain'
-  // or the 'chain' breaks.  Therefore it will be marked 'unused'.
+  InternalRestoreWindowDefaults(pEntry);
 
-  iPrev = (iIndex - 1) & WINDOW_ENTRY_ARRAY_MAX;
-  iNext = (iIndex + 1) & WINDOW_ENTRY_ARRAY_MAX;
+  // remove it from the hash table.  The following entries in the probe sequence shift
+  // back by one slot, so no 'unused' marker is needed to keep the chain intact.
 
-  if(!sWBHashEntries[iNext].wID) // next isn't NULL so I'm the end of the chain
-  {
-    sWBHashEntries[iIndex].wID = 0;  // it's safe to do this now
+  iIndex = __WindowHashFind(pEntry->wID);
 
-    for(iIndex=iPrev; iIndex != iNext && sWBHashEntries[iIndex].wID == WINDOW_ENTRY_UNUSED;
-        iIndex = (iIndex - 1) & WINDOW_ENTRY_ARRAY_MAX) // roundie roundie
-    {
-      sWBHashEntries[iIndex].wID = 0;  // zero out back up the chain until I hit something that's not 'unused'
-    }
-  }
-  else
+  if(iIndex >= 0 && pWindowHash[iIndex].pEntry == pEntry)
   {
-    if(!sWBHashEntries[iPrev].wID)  // previous is NULL
-    {
-      // I'm not a chain.  I can mark this zero
-      sWBHashEntries[iIndex].wID = 0;  // just zero it out (the normal case)
-    }
-    else
-    {
-      sWBHashEntries[iIndex].wID = WINDOW_ENTRY_UNUSED;  // mark this as "unused" but not the end of a chain
-    }
+    __WindowHashRemove(iIndex);
+    nWBHashEntries--;
   }
 
-  nWBHashEntries--;
+  pEntry->wID = None;
+
+  __WindowEntryFree(pEntry); // goes on the free list; the memory remains valid
 }
 
 static void __PeriodicWindowEntryCleanup(void)
 {
-int i1;
-struct timeval tvNow;
-static struct timeval tvLastTime = {0,0};
+_WINDOW_ENTRY_ *pEntry, *pNext;
+WB_UINT64 qwNow;
+static WB_UINT64 qwLastTime = 0;
+
+
+  if(iWindowEntryEnumDepth > 0)
+  {
+    return; // something is walking the list of entries, so don't delete any right now
+  }
 
-  gettimeofday(&tvNow, NULL);
+  qwNow = WBGetTimeIndex();
 
-  if(tvNow.tv_sec == tvLastTime.tv_sec)
+  if(qwNow - qwLastTime < 1000000)
   {
     return;  // so I don't do this too often - only once per second
   }
 
-  tvLastTime.tv_sec = tvNow.tv_sec;
+  qwLastTime = qwNow;
 
-  tvNow.tv_sec -= WB_WINDOW_DELETE_TIMEOUT;
+  // delete the entries that have been marked 'to be deleted' for long enough
 
-  // for each remaining window in my list, destroy it
-  // TODO:  a more intelligent way to do this.  Currently it loops 2048 times
-  //        and this is NOT efficient.  however, at 1Ghz, 2048 loops should easily
-  //        be less than 1 msec (maybe 10 to 20 cycles per loop on average).
-  for(i1=WINDOW_ENTRY_ARRAY_MAX - 1; i1 >= 0; i1--)
+  for(pEntry = pWindowEntryHead; pEntry; pEntry = pNext)
   {
-    Window wID = sWBHashEntries[i1].wID;
+    pNext = pEntry->pNextEntry;
 
-    if(!wID || wID == WINDOW_ENTRY_UNUSED)
+    if(pEntry->iWindowState == WB_WINDOW_DELETE &&
+       qwNow - pEntry->qwLastActivity > (WB_UINT64)WB_WINDOW_DELETE_TIMEOUT * 1000000) // aged enough?
     {
-      continue;
+      WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_Window,
+                     "%s - destroying entry for window %u (%08xH)\n",
+                     __FUNCTION__, (int)pEntry->wID, (int)pEntry->wID);
+
+      __WindowEntryDestructor(pEntry); // finalizes destruction and puts it on the free list
     }
+  }
+}
 
-    if(sWBHashEntries[i1].iWindowState == WB_WINDOW_DELETE &&
-       sWBHashEntries[i1].tvLastActivity.tv_sec < tvNow.tv_sec) // aged enough?
-    {
-      WB_DEBUG_PRINT(DebugLevel_Light | DebugSubSystem_Window,
-                     "%s - destroying entry %d for window %u (%08xH)\n",
-                     __FUNCTION__, i1,
-                     (int)sWBHashEntries[i1].wID, (int)sWBHashEntries[i1].wID);
+static void __WindowEntryExit(void)
+{
+_WINDOW_ENTRY_ *pEntry;
 
 
-//      WB_ERROR_PRINT("TEMPORARY:  %s - delete window entry %d for window %u (%08xH)\n",
-//                     __FUNCTION__, i1,
-//                     (int)sWBHashEntries[i1].wID, (int)sWBHashEntries[i1].wID);
+  // the display has been closed by now, so any remaining entries are simply freed
 
-//      __WindowEntryRestoreDefaultResources(i1);  // make sure no resources are allocated - actually next function does this already
-      __WindowEntryDestructor(i1); // finalizes destruction and marks it 'unused'
-    }
+  while((pEntry = pWindowEntryHead) != NULL)
+  {
+    pWindowEntryHead = pEntry->pNextEntry;
+    WBFree(pEntry);
   }
+
+  pWindowEntryTail = NULL;
+
+  while((pEntry = pFreeWindowEntries) != NULL)
+  {
+    pFreeWindowEntries = pEntry->pNextEntry;
+    WBFree(pEntry);
+  }
+
+  if(pWindowHash)
+  {
+    WBFree(pWindowHash);
+    pWindowHash = NULL;
+  }
+
+  nWindowHashMax = 0;
+  nWBHashEntries = 0;
 }
 
 Window WBCreateWindow(WB_DISPLAY pDisplay, Window wIDParent,
@@ -3056,36 +3478,25 @@ _WINDOW_ENTRY_ *pEntry = __AddOrLocateEntry(wID);
 
 void WBUnregisterWindowCallback(Window wID)
 {
-  int i1, /*iPrev, iNext,*/ iStart;
+int i1;
+_WINDOW_ENTRY_ *pEntry;
+
 
   if(wID == wIDApplication)
   {
     wIDApplication = None; // application window being unregistered
   }
 
-  if(!nWBHashEntries)
+  i1 = __WindowHashFind(wID);
+
+  if(i1 < 0)
   {
     WB_DEBUG_PRINT(DebugLevel_Excessive | DebugSubSystem_Window,
-                   "%s - nWBHashEntries == NULL\n", __FUNCTION__);
+                   "%s - no entry for window %d (%08xH)\n", __FUNCTION__, (int)wID, (int)wID);
     return;
   }
 
-  i1 = iStart = WINDOW_ENTRY_HASH(wID);
-
-  while(sWBHashEntries[i1].wID)  // the array must be pre-assigned to zero for this to work properly
-  {
-    if(sWBHashEntries[i1].wID == wID)
-      break;
-
-    i1++;
-    i1 &= WINDOW_ENTRY_ARRAY_MAX;
-
-    if(i1 == iStart)
-    {
-      i1 = -1;  // as a flag that I didn't find it
-      break;
-    }
-  }
+  pEntry = pWindowHash[i1].pEntry;
 
   // free resources, mark the 'last activity' time, and
   // mark this entry as "to be destroyed"
@@ -3093,31 +3504,26 @@ void WBUnregisterWindowCallback(Window wID)
   // NOTE:  used to NOT actually change the callback address (TODO:  change name of function?)
   //        but in this case I'm going to NULL it.  I don't want window callbacks being called
 
-  if(i1 >= 0 && sWBHashEntries[i1].wID == wID)  // guarantees I have the right one
-  {
-    // look through all of the timers and unregister any that involve this window
-    // this is to avoid certain problems where windows aren't being notified properly
-
-    DeletAllTimersForWindow(sWBHashEntries[i1].pDisplay, wID);
+  // look through all of the timers and unregister any that involve this window
+  // this is to avoid certain problems where windows aren't being notified properly
 
-    if(sWBHashEntries[i1].iWindowState != WB_WINDOW_DELETE)
-    {
-      WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Window,
-                     "Entry %d for window %d (%08xH) marked as 'to be destroyed'\n",
-                     i1, (int)wID, (int)wID);
+  DeletAllTimersForWindow(pEntry->pDisplay, wID);
 
-//      __WindowEntryDestructor(i1);
-      __WindowEntryRestoreDefaultResources(i1);  // make sure no resources are allocated
+  if(pEntry->iWindowState != WB_WINDOW_DELETE)
+  {
+    WB_DEBUG_PRINT(DebugLevel_Medium | DebugSubSystem_Window,
+                   "Entry for window %d (%08xH) marked as 'to be destroyed'\n",
+                   (int)wID, (int)wID);
 
-      gettimeofday(&(sWBHashEntries[i1].tvLastActivity), NULL);
+    __WindowEntryRestoreDefaultResources(pEntry);  // make sure no resources are allocated
 
-      sWBHashEntries[i1].iWindowState = WB_WINDOW_DELETE;
-    }
+    pEntry->qwLastActivity = WBGetTimeIndex();
 
-    sWBHashEntries[i1].pCallback = NULL; // no more callback function.  'DestroyNotify' may still happen.
-    // for 'DestroyNotify' events following this, WBDispatch will deal with that.
+    pEntry->iWindowState = WB_WINDOW_DELETE;
   }
 
+  pEntry->pCallback = NULL; // no more callback function.  'DestroyNotify' may still happen.
+  // for 'DestroyNotify' events following this, WBDispatch will deal with that.
 }
 
 // this one is ONLY called before mapping the window
@@ -3268,31 +3674,38 @@ _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 
 Window WBLocateWindow(WBLocateWindowCallback callback, void *pData)
 {
-int i1, i2;
+_WINDOW_ENTRY_ *pEntry;
+Window wRval = 0;
+int i2;
 
   if(!callback)
   {
     return (Window)0;
   }
 
-  for(i1=0; i1 <= WINDOW_ENTRY_ARRAY_MAX; i1++)
+  iWindowEntryEnumDepth++; // entries won't be deleted while I walk the list
+
+  for(pEntry = pWindowEntryHead; pEntry; pEntry = pEntry->pNextEntry)
   {
-    Window wID = sWBHashEntries[i1].wID;
-    if(wID && wID != WINDOW_ENTRY_UNUSED)
+    Window wID = pEntry->wID;
+    if(wID)
     {
       i2 = callback(wID, pData);
       if(i2 > 0)
       {
-        return wID;
+        wRval = wID;
+        break;
       }
       else if(i2 < 0)
       {
-        return 0;
+        break;
       }
     }
   }
 
-  return 0;
+  iWindowEntryEnumDepth--;
+
+  return wRval;
 }
 
 
@@ -3333,64 +3746,201 @@ _WINDOW_ENTRY_ *pEntry;
 /*                                                                    */
 /**********************************************************************/
 
-//#define TIMER_ARRAY_SIZE  512
-//
-//static struct s_TIMER_ENTRY
-//{
-//  struct s_TIMER_ENTRY *pNext; // linked lists for performance
-//  unsigned long long lTimeIndex; // time index for which this timer next expires
-//  unsigned long lTimeInterval;   // interval (or zero for one-shot timer)
-//
-//  Display *pDisplay;             // display associated with timer
-//  Window wID;                    // window to receive timer event
-//  long lID;                      // timer identifier
-//} TIMER_ENTRY;
-//
-//static TIMER_ENTRY axWBTimer[TIMER_ARRAY_SIZE];
-//static TIMER_ENTRY *pTimerEntryActive = NULL, *pTimerEntryFree = NULL;
-//  // pointers for two linked lists.  entries must be in either 'active' or 'free' list.
+#define TIMER_INITIAL_SIZE 64 /* initial heap and hash size; must be a power of 2 */
 
-int CreateTimer(WB_DISPLAY pDisplay, Window wID, unsigned long lInterval, long lID, int iPeriodic)
+static unsigned int __TimerBucket(WB_DISPLAY pDisplay, Window wID, int nBuckets)
 {
-int i1;
-TIMER_ENTRY *pCur;
-// if timer linked lists aren't set up yet, do that now
+WB_UINT32 uiKey = (WB_UINT32)((unsigned long)pDisplay >> 4) ^ (WB_UINT32)wID;
+
+  // Fibonacci hashing.  All timers for a window share a bucket, so DeletAllTimersForWindow() only walks one chain
+
+  uiKey *= 0x9e3779b1U;
+
+  return (unsigned int)((uiKey ^ (uiKey >> 15)) & (nBuckets - 1));
+}
+
+static void __TimerHeapSet(int iIndex, TIMER_ENTRY *pEntry)
+{
+  ppTimerHeap[iIndex] = pEntry;
+  pEntry->iHeapIndex = iIndex;
+}
 
+static void __TimerHeapSiftUp(int iIndex)
+{
+TIMER_ENTRY *pEntry = ppTimerHeap[iIndex];
+int iParent;
 
-  if(!pTimerEntryActive && !pTimerEntryFree) // initial state
+  while(iIndex > 0)
   {
-    bzero(axWBTimer, sizeof(axWBTimer));
+    iParent = (iIndex - 1) >> 1;
 
-    for(i1=1; i1 < TIMER_ARRAY_SIZE; i1++)
+    if(ppTimerHeap[iParent]->lTimeIndex <= pEntry->lTimeIndex)
     {
-      axWBTimer[i1 - 1].pNext = axWBTimer + i1; // build linked list
+      break;
     }
 
-    pTimerEntryFree = axWBTimer;
+    __TimerHeapSet(iIndex, ppTimerHeap[iParent]);
+    iIndex = iParent;
   }
 
-  // search for match, return -2 if found
-  pCur = pTimerEntryActive;
-  while(pCur)
+  __TimerHeapSet(iIndex, pEntry);
+}
+
+static void __TimerHeapSiftDown(int iIndex)
+{
+TIMER_ENTRY *pEntry = ppTimerHeap[iIndex];
+int iChild;
+
+  while((iChild = (iIndex << 1) + 1) < nTimerHeap)
   {
-    if(pCur->pDisplay == pDisplay &&
-       pCur->wID == wID &&
-       pCur->lID == lID)
+    if(iChild + 1 < nTimerHeap &&
+       ppTimerHeap[iChild + 1]->lTimeIndex < ppTimerHeap[iChild]->lTimeIndex)
     {
-      return -2;
+      iChild++; // the smaller of the two
     }
 
-    pCur = pCur->pNext;
-  }
+    if(pEntry->lTimeIndex <= ppTimerHeap[iChild]->lTimeIndex)
+    {
+      break;
+    }
 
-  if(!pTimerEntryFree)
-  {
-    return -1; // no memory
+    __TimerHeapSet(iIndex, ppTimerHeap[iChild]);
+    iIndex = iChild;
   }
 
-  pCur = pTimerEntryFree;
-  pTimerEntryFree = pTimerEntryFree->pNext;
-//  pCur->pNext = NULL;  // TODO in case I have to add locking later
+  __TimerHeapSet(iIndex, pEntry);
+}
+
+static void __TimerHeapRemove(TIMER_ENTRY *pEntry)
+{
+int iIndex = pEntry->iHeapIndex;
+
+  nTimerHeap--;
+
+  if(iIndex < nTimerHeap) // move the last one into the hole, then restore the heap order
+  {
+    __TimerHeapSet(iIndex, ppTimerHeap[nTimerHeap]);
+
+    if(iIndex > 0 && ppTimerHeap[iIndex]->lTimeIndex < ppTimerHeap[(iIndex - 1) >> 1]->lTimeIndex)
+    {
+      __TimerHeapSiftUp(iIndex);
+    }
+    else
+    {
+      __TimerHeapSiftDown(iIndex);
+    }
+  }
+
+  ppTimerHeap[nTimerHeap] = NULL;
+  pEntry->iHeapIndex = -1;
+}
+
+// make room for one more timer, growing the heap and re-hashing as needed.  returns non-zero on error
+static int __TimerReserve(void)
+{
+TIMER_ENTRY **ppNew, *pCur, *pNext;
+int i1, iNewMax;
+unsigned int uiBucket;
+
+
+  if(nTimerHeap < nTimerHeapMax)
+  {
+    return 0;
+  }
+
+  iNewMax = nTimerHeapMax ? nTimerHeapMax * 2 : TIMER_INITIAL_SIZE;
+
+  ppNew = (TIMER_ENTRY **)WBReAlloc(ppTimerHeap, iNewMax * sizeof(*ppNew));
+
+  if(!ppNew)
+  {
+    return -1;
+  }
+
+  ppTimerHeap = ppNew;
+  nTimerHeapMax = iNewMax;
+
+  // the hash table is kept the same size as the heap (load factor <= 1)
+
+  ppNew = (TIMER_ENTRY **)WBAlloc(iNewMax * sizeof(*ppNew));
+
+  if(!ppNew)
+  {
+    return -1; // the larger heap is still fine; try again next time
+  }
+
+  memset(ppNew, 0, iNewMax * sizeof(*ppNew));
+
+  for(i1=0; i1 < nTimerHashMax; i1++)
+  {
+    for(pCur = ppTimerHash[i1]; pCur; pCur = pNext)
+    {
+      pNext = pCur->pNext;
+
+      uiBucket = __TimerBucket(pCur->pDisplay, pCur->wID, iNewMax);
+
+      pCur->pNext = ppNew[uiBucket];
+      ppNew[uiBucket] = pCur;
+    }
+  }
+
+  if(ppTimerHash)
+  {
+    WBFree(ppTimerHash);
+  }
+
+  ppTimerHash = ppNew;
+  nTimerHashMax = iNewMax;
+
+  return 0;
+}
+
+static TIMER_ENTRY *__FindTimer(WB_DISPLAY pDisplay, Window wID, long lID)
+{
+TIMER_ENTRY *pCur;
+
+  if(!ppTimerHash)
+  {
+    return NULL;
+  }
+
+  for(pCur = ppTimerHash[__TimerBucket(pDisplay, wID, nTimerHashMax)]; pCur; pCur = pCur->pNext)
+  {
+    if(pCur->pDisplay == pDisplay &&
+       pCur->wID == wID &&
+       pCur->lID == lID)
+    {
+      return pCur;
+    }
+  }
+
+  return NULL;
+}
+
+int CreateTimer(WB_DISPLAY pDisplay, Window wID, unsigned long lInterval, long lID, int iPeriodic)
+{
+TIMER_ENTRY *pCur;
+unsigned int uiBucket;
+
+
+  // search for match, return -2 if found
+
+  if(__FindTimer(pDisplay, wID, lID))
+  {
+    return -2;
+  }
+
+  if(__TimerReserve() || !ppTimerHash)
+  {
+    return -1; // no memory
+  }
+
+  pCur = (TIMER_ENTRY *)WBAlloc(sizeof(*pCur));
+
+  if(!pCur)
+  {
+    return -1; // no memory
+  }
 
   pCur->pDisplay = pDisplay;
   pCur->wID = wID;
@@ -3406,260 +3956,397 @@ TIMER_ENTRY *pCur;
     pCur->lTimeInterval = 0;
   }
 
-  pCur->pNext = pTimerEntryActive; // goes at the beginning of the list (it's easier)
-  pTimerEntryActive = pCur;
+  uiBucket = __TimerBucket(pDisplay, wID, nTimerHashMax);
+  pCur->pNext = ppTimerHash[uiBucket];
+  ppTimerHash[uiBucket] = pCur;
+
+  ppTimerHeap[nTimerHeap] = pCur;
+  __TimerHeapSiftUp(nTimerHeap++);
 
   return 0;
 }
 
-static void __DeleteTimer(TIMER_ENTRY *pPrev, TIMER_ENTRY *pEntry)
+static void __DeleteTimer(TIMER_ENTRY *pEntry)
 {
-  pEntry->lTimeIndex = pEntry->lTimeInterval = 0;
-  pEntry->pDisplay = NULL;
-  pEntry->wID = 0;
-  pEntry->lID = 0;
+TIMER_ENTRY **ppCur;
 
-  if(!pPrev) // assume head of linked list
+  for(ppCur = ppTimerHash + __TimerBucket(pEntry->pDisplay, pEntry->wID, nTimerHashMax); *ppCur; ppCur = &((*ppCur)->pNext))
   {
-    if(pTimerEntryActive != pEntry) // sanity checks
-    {
-      // a leak is better than a crash
-      WB_ERROR_PRINT("%s - (1) unable to properly delete timer due to pointer inconsistency %p %p %p\n",
-                     __FUNCTION__, pTimerEntryActive, pEntry, pEntry->pNext);
-    }
-    else
+    if(*ppCur == pEntry)
     {
-      pTimerEntryActive = pEntry->pNext;
-      pEntry->pNext = pTimerEntryFree;
-      pTimerEntryFree = pEntry;
+      break;
     }
   }
-  else if(pPrev->pNext == pEntry) // more sanity checks
+
+  if(!*ppCur || pEntry->iHeapIndex < 0 || ppTimerHeap[pEntry->iHeapIndex] != pEntry) // sanity checks
   {
-    pPrev->pNext = pEntry->pNext;
-    pEntry->pNext = pTimerEntryFree;
-    pTimerEntryFree = pEntry;
+    // a leak is better than a crash
+    WB_ERROR_PRINT("%s - unable to properly delete timer due to pointer inconsistency %p\n",
+                   __FUNCTION__, pEntry);
+    return;
   }
-  else
+
+  *ppCur = pEntry->pNext;
+
+  __TimerHeapRemove(pEntry);
+
+  WBFree(pEntry);
+}
+
+void DeleteTimer(WB_DISPLAY pDisplay, Window wID, long lID)
+{
+TIMER_ENTRY *pCur = __FindTimer(pDisplay, wID, lID);
+
+  if(pCur)
   {
-      WB_ERROR_PRINT("%s - (2) unable to properly delete timer due to pointer inconsistency %p %p %p %p\n",
-                     __FUNCTION__, pPrev, pPrev->pNext, pEntry, pEntry->pNext);
+    __DeleteTimer(pCur);
   }
 }
 
-void DeleteTimer(WB_DISPLAY pDisplay, Window wID, long lID)
+static void DeletAllTimersForWindow(WB_DISPLAY pDisplay, Window wID)
 {
-TIMER_ENTRY *pCur, *pPrev;
+TIMER_ENTRY *pCur, *pNext;
 
-  pCur = pTimerEntryActive;
-  pPrev = NULL;
+  if(!ppTimerHash)
+  {
+    return;
+  }
 
-  while(pCur)
+  for(pCur = ppTimerHash[__TimerBucket(pDisplay, wID, nTimerHashMax)]; pCur; pCur = pNext)
   {
+    pNext = pCur->pNext; // __DeleteTimer frees 'pCur'
+
     if(pCur->pDisplay == pDisplay &&
-       pCur->wID == wID &&
-       pCur->lID == lID)
+       pCur->wID == wID)
     {
-      __DeleteTimer(pPrev, pCur);
-      return;
+      __DeleteTimer(pCur);
     }
-
-    pPrev = pCur;
-    pCur = pCur->pNext;
   }
 }
 
-static void DeletAllTimersForWindow(WB_DISPLAY pDisplay, Window wID)
+static void __DeleteAllTimers(void)
 {
-TIMER_ENTRY *pCur, *pPrev, *pNext;
+int i1;
 
-  pCur = pTimerEntryActive;
-  pPrev = NULL;
+  for(i1=0; i1 < nTimerHeap; i1++)
+  {
+    WBFree(ppTimerHeap[i1]);
+  }
 
-  while(pCur)
+  if(ppTimerHeap)
   {
-    if(pCur->pDisplay == pDisplay &&
-       pCur->wID == wID)
-    {
-      pNext = pCur->pNext;
+    WBFree(ppTimerHeap);
+  }
 
-      __DeleteTimer(pPrev, pCur);
+  if(ppTimerHash)
+  {
+    WBFree(ppTimerHash);
+  }
 
-      pCur = pNext; // must do it THIS way if I remove the entry in between
-                    // note:  'pPrev' doesn't change, but 'pNext' does (pPrev->pNext should equal pCur now)
-    }
-    else
+  ppTimerHeap = ppTimerHash = NULL;
+  nTimerHeap = nTimerHeapMax = nTimerHashMax = 0;
+}
+
+// the timer that expires next for 'pDisplay', or NULL.  With a single display this is always the top of the heap.
+static TIMER_ENTRY *__NextTimer(WB_DISPLAY pDisplay)
+{
+TIMER_ENTRY *pRval = NULL;
+int i1;
+
+  if(WB_LIKELY(nTimerHeap > 0 && ppTimerHeap[0]->pDisplay == pDisplay))
+  {
+    return ppTimerHeap[0];
+  }
+
+  for(i1=1; i1 < nTimerHeap; i1++) // timers for more than one display - not the usual case
+  {
+    if(ppTimerHeap[i1]->pDisplay == pDisplay &&
+       (!pRval || ppTimerHeap[i1]->lTimeIndex < pRval->lTimeIndex))
     {
-      pPrev = pCur;
-      pCur = pCur->pNext;
+      pRval = ppTimerHeap[i1];
     }
   }
+
+  return pRval;
 }
 
 static int __CheckTimers(WB_DISPLAY pDisplay, XEvent *pEvent)
 {
-TIMER_ENTRY *pCur, *pPrev;
-WB_UINT64 lTime = WBGetTimeIndex();
+TIMER_ENTRY *pCur;
+WB_UINT64 lTime;
 
 // Find the _NEXT_ registered timer for which the current time 'crosses'
 
-  pCur = pTimerEntryActive;
-  pPrev = NULL;
+  if(!nTimerHeap)
+  {
+    return 0;
+  }
 
-  while(pCur)
+  lTime = WBGetTimeIndex();
+
+  if(ppTimerHeap[0]->lTimeIndex > lTime) // nothing is due for ANY display
   {
-    if(pCur->pDisplay == pDisplay &&
-       lTime >= pCur->lTimeIndex) // time index has crossed "the threshold" for the timer
+    return 0;
+  }
+
+  pCur = __NextTimer(pDisplay);
+
+  if(!pCur || lTime < pCur->lTimeIndex) // time index has not crossed "the threshold" for the timer
+  {
+    return 0;  // no timer found/processed
+  }
+
+  if(!pEvent)
+  {
+    return 1; // only indicate that I found a timer that's active (don't process it)
+  }
+
+  // fill out the event structure pointed to by 'pEvent' (before a one-shot timer is deleted)
+  bzero(pEvent, sizeof(*pEvent));
+
+  pEvent->xclient.type = ClientMessage;
+  pEvent->xclient.serial = 0;
+  pEvent->xclient.send_event = 0;
+  pEvent->xclient.display = pDisplay;
+  pEvent->xclient.window = pCur->wID;
+  pEvent->xclient.message_type = aWB_TIMER;
+  pEvent->xclient.format=32;  // 32-bit integers
+  pEvent->xclient.data.l[0] = pCur->lID;
+
+  if(pCur->lTimeInterval)
+  {
+    pCur->lTimeIndex += pCur->lTimeInterval;
+
+    if(lTime >= pCur->lTimeIndex) // to prevent 'spinning'
     {
-      if(!pEvent)
-      {
-        return 1; // only indicate that I found a timer that's active (don't process it)
-      }
+      pCur->lTimeIndex = lTime + pCur->lTimeInterval;
+    }
 
-      if(pCur->lTimeInterval)
-      {
-        pCur->lTimeIndex += pCur->lTimeInterval;
+    __TimerHeapSiftDown(pCur->iHeapIndex); // it only moves later
+  }
+  else
+  {
+    __DeleteTimer(pCur);
+  }
 
-        if(lTime >= pCur->lTimeIndex) // to prevent 'spinning'
-        {
-          pCur->lTimeIndex = lTime + pCur->lTimeInterval;
-        }
-      }
-      else
-      {
-        __DeleteTimer(pPrev, pCur);
-      }
+  return 1; // found/processed a timer
+}
+
+#define DELAYED_EVENT_INITIAL_SIZE 64 /* initial heap size */
+
+// deadline order; events with the same deadline are delivered in the order they were posted
+#define DELAYED_EVENT_BEFORE(X,Y) ((X)->lTimeIndex < (Y)->lTimeIndex || \
+                                   ((X)->lTimeIndex == (Y)->lTimeIndex && (X)->qwSequence < (Y)->qwSequence))
+
+static void __DelayedEventHeapSiftUp(int iIndex)
+{
+DELAYED_EVENT_ENTRY *pEntry = ppDelayedEventHeap[iIndex];
+int iParent;
+
+  while(iIndex > 0)
+  {
+    iParent = (iIndex - 1) >> 1;
+
+    if(!DELAYED_EVENT_BEFORE(pEntry, ppDelayedEventHeap[iParent]))
+    {
+      break;
+    }
 
-      // now fill out the event structure pointed to by 'pEvent'
-      bzero(pEvent, sizeof(*pEvent));
+    ppDelayedEventHeap[iIndex] = ppDelayedEventHeap[iParent];
+    iIndex = iParent;
+  }
+
+  ppDelayedEventHeap[iIndex] = pEntry;
+}
 
-      pEvent->xclient.type = ClientMessage;
-      pEvent->xclient.serial = 0;
-      pEvent->xclient.send_event = 0;
-      pEvent->xclient.display = pDisplay;
-      pEvent->xclient.window = pCur->wID;
-      pEvent->xclient.message_type = aWB_TIMER;
-      pEvent->xclient.format=32;  // 32-bit integers
-      pEvent->xclient.data.l[0] = pCur->lID;
+static void __DelayedEventHeapSiftDown(int iIndex)
+{
+DELAYED_EVENT_ENTRY *pEntry = ppDelayedEventHeap[iIndex];
+int iChild;
 
-      return 1; // found/processed a timer
+  while((iChild = (iIndex << 1) + 1) < nDelayedEventHeap)
+  {
+    if(iChild + 1 < nDelayedEventHeap &&
+       DELAYED_EVENT_BEFORE(ppDelayedEventHeap[iChild + 1], ppDelayedEventHeap[iChild]))
+    {
+      iChild++; // the earlier of the two
     }
 
-    pPrev = pCur;
-    pCur = pCur->pNext;
+    if(!DELAYED_EVENT_BEFORE(ppDelayedEventHeap[iChild], pEntry))
+    {
+      break;
+    }
+
+    ppDelayedEventHeap[iIndex] = ppDelayedEventHeap[iChild];
+    iIndex = iChild;
   }
 
-  return 0;  // no timer found/processed
+  ppDelayedEventHeap[iIndex] = pEntry;
 }
 
 static void __CreateDelayedEvent(XEvent *pEvent, unsigned int uiInterval)
 {
-int i1;
 DELAYED_EVENT_ENTRY *pCur;
-// if timer linked lists aren't set up yet, do that now
 
 
-  if(!pDelayedEventEntryActive && !pDelayedEventEntryFree) // initial state
+  if(nDelayedEventHeap >= nDelayedEventHeapMax) // grow the heap as needed
   {
-    bzero(axWBDelayedEvent, sizeof(axWBDelayedEvent));
+    int iNewMax = nDelayedEventHeapMax ? nDelayedEventHeapMax * 2 : DELAYED_EVENT_INITIAL_SIZE;
+    DELAYED_EVENT_ENTRY **ppNew = (DELAYED_EVENT_ENTRY **)WBReAlloc(ppDelayedEventHeap, iNewMax * sizeof(*ppNew));
 
-    for(i1=1; i1 < TIMER_ARRAY_SIZE; i1++)
+    if(!ppNew)
     {
-      axWBDelayedEvent[i1 - 1].pNext = axWBDelayedEvent + i1; // build linked list
+      WB_ERROR_PRINT("ERROR:  %s - not enough memory to post delayed event\n", __FUNCTION__);
+      return;
     }
 
-    pDelayedEventEntryFree = axWBDelayedEvent;
+    ppDelayedEventHeap = ppNew;
+    nDelayedEventHeapMax = iNewMax;
   }
 
-  // search for match, return -2 if found
-  pCur = pDelayedEventEntryFree;
-  pDelayedEventEntryFree = pDelayedEventEntryFree->pNext;
-//  pCur->pNext = NULL;  // TODO in case I have to add locking later
+  pCur = (DELAYED_EVENT_ENTRY *)WBAlloc(sizeof(*pCur));
+
+  if(!pCur)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory to post delayed event\n", __FUNCTION__);
+    return;
+  }
 
   memcpy(&(pCur->event), pEvent, sizeof(pCur->event));
 
   pCur->lTimeIndex = WBGetTimeIndex() + uiInterval;
+  pCur->qwSequence = qwDelayedEventSequence++;
 
-  pCur->pNext = pDelayedEventEntryActive; // goes at the beginning of the list (it's easier)
-  pDelayedEventEntryActive = pCur;
+  ppDelayedEventHeap[nDelayedEventHeap] = pCur;
+  __DelayedEventHeapSiftUp(nDelayedEventHeap++);
 }
 
-static void __DeleteDelayedEvent(DELAYED_EVENT_ENTRY *pPrev, DELAYED_EVENT_ENTRY *pEntry)
+static void __DeleteDelayedEvent(int iIndex)
 {
-  pEntry->lTimeIndex = 0;
-  bzero(&(pEntry->event), sizeof(pEntry->event));
+DELAYED_EVENT_ENTRY *pEntry = ppDelayedEventHeap[iIndex];
 
-  if(!pPrev) // assume head of linked list
+  nDelayedEventHeap--;
+
+  if(iIndex < nDelayedEventHeap) // move the last one into the hole, then restore the heap order
   {
-    if(pDelayedEventEntryActive != pEntry) // sanity checks
+    ppDelayedEventHeap[iIndex] = ppDelayedEventHeap[nDelayedEventHeap];
+
+    if(iIndex > 0 && DELAYED_EVENT_BEFORE(ppDelayedEventHeap[iIndex], ppDelayedEventHeap[(iIndex - 1) >> 1]))
     {
-      // a leak is better than a crash
-      WB_ERROR_PRINT("%s - (1) unable to properly delete delayed event due to pointer inconsistency %p %p %p\n",
-                     __FUNCTION__, pTimerEntryActive, pEntry, pEntry->pNext);
+      __DelayedEventHeapSiftUp(iIndex);
     }
     else
     {
-      pDelayedEventEntryActive = pEntry->pNext;
-      pEntry->pNext = pDelayedEventEntryFree;
-      pDelayedEventEntryFree = pEntry;
+      __DelayedEventHeapSiftDown(iIndex);
     }
   }
-  else if(pPrev->pNext == pEntry) // more sanity checks
+
+  ppDelayedEventHeap[nDelayedEventHeap] = NULL;
+
+  WBFree(pEntry);
+}
+
+static void __DeleteAllDelayedEvents(void)
+{
+int i1;
+
+  for(i1=0; i1 < nDelayedEventHeap; i1++)
   {
-    pPrev->pNext = pEntry->pNext;
-    pEntry->pNext = pDelayedEventEntryFree;
-    pDelayedEventEntryFree = pEntry;
+    WBFree(ppDelayedEventHeap[i1]);
   }
-  else
+
+  if(ppDelayedEventHeap)
   {
-    WB_ERROR_PRINT("%s - (2) unable to properly delete delayed event due to pointer inconsistency %p %p %p %p\n",
-                   __FUNCTION__, pPrev, pPrev->pNext, pEntry, pEntry->pNext);
+    WBFree(ppDelayedEventHeap);
   }
+
+  ppDelayedEventHeap = NULL;
+  nDelayedEventHeap = nDelayedEventHeapMax = 0;
+}
+
+// heap index of the earliest delayed event for 'pDisplay' (or for the application), -1 if none.
+// With a single display this is always the top of the heap.
+static int __NextDelayedEvent(WB_DISPLAY pDisplay)
+{
+DELAYED_EVENT_ENTRY *pCur;
+int i1, iRval = -1;
+
+  for(i1=0; i1 < nDelayedEventHeap; i1++)
+  {
+    pCur = ppDelayedEventHeap[i1];
+
+    if((pCur->event.xany.display == pDisplay || pCur->event.xany.window == None) &&
+       (iRval < 0 || DELAYED_EVENT_BEFORE(pCur, ppDelayedEventHeap[iRval])))
+    {
+      iRval = i1;
+
+      if(WB_LIKELY(!i1))
+      {
+        break; // the top of the heap is the earliest of them all
+      }
+    }
+  }
+
+  return iRval;
 }
 
 static int __attribute__((noinline)) __CheckDelayedEvents(WB_DISPLAY pDisplay, XEvent *pEvent)
 {
-DELAYED_EVENT_ENTRY *pCur, *pPrev;
-WB_UINT64 lTime = WBGetTimeIndex();
+DELAYED_EVENT_ENTRY *pCur;
+WB_UINT64 lTime;
+int iIndex;
 
   // Find the _NEXT_ registered delayed event for which the current time 'crosses'
 
-  pCur = pDelayedEventEntryActive;
-  pPrev = NULL;
+  if(!nDelayedEventHeap)
+  {
+    return 0;
+  }
+
+  lTime = WBGetTimeIndex();
 
-  while(pCur)
+  while(nDelayedEventHeap > 0 &&
+        ppDelayedEventHeap[0]->lTimeIndex <= lTime) // otherwise nothing is due, for ANY display
   {
-    if((pCur->event.xany.display == pDisplay || pCur->event.xany.window == None) &&
-       lTime >= pCur->lTimeIndex)
+    iIndex = __NextDelayedEvent(pDisplay);
+
+    if(iIndex < 0)
     {
-      // fill out the event structure pointed to by 'pEvent'
+      break;
+    }
 
-      if(pCur->event.xany.window != None)
-      {
-        _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(pCur->event.xany.window);
+    pCur = ppDelayedEventHeap[iIndex];
 
-        if(!pEntry || WB_IS_WINDOW_DESTROYED(*pEntry))
-        {
-          __DeleteDelayedEvent(pPrev, pCur);
-          return 0; // none processed [code is easier this way]
-        }
-      }
+    if(lTime < pCur->lTimeIndex)
+    {
+      break;
+    }
+
+    if(pCur->event.xany.window != None)
+    {
+      _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(pCur->event.xany.window);
 
-      if(pEvent) // if NULL, I'm only looking to see if there IS one
+      if(!pEntry || WB_IS_WINDOW_DESTROYED(*pEntry))
       {
-        memcpy(pEvent, &(pCur->event), sizeof(*pEvent));
+        __DeleteDelayedEvent(iIndex); // window is gone; discard it and look at the next one
 
-        __DeleteDelayedEvent(pPrev, pCur);
+        continue;
       }
+    }
+
+    // fill out the event structure pointed to by 'pEvent'
+
+    if(pEvent) // if NULL, I'm only looking to see if there IS one
+    {
+      memcpy(pEvent, &(pCur->event), sizeof(*pEvent));
 
-      return 1; // processed
+      __DeleteDelayedEvent(iIndex);
     }
 
-    pPrev = pCur;
-    pCur = pCur->pNext;
+    return 1; // processed
   }
 
-  return 0;  // no timer processed
+  return 0;  // no delayed event processed
 }
 
 
@@ -3697,6 +4384,138 @@ static Bool __WBCheckIfEventPredicate0(WB_DISPLAY pDisplay, XEvent *pEvent, XPoi
   }
 }
 
+static int __InternalIsCursorKey(XKeyEvent *pEvent)
+{
+  switch(XLookupKeysym(pEvent, 0))
+  {
+    case XK_Left:
+    case XK_Right:
+    case XK_Up:
+    case XK_Down:
+    case XK_Home:
+    case XK_End:
+    case XK_Prior:
+    case XK_Next:
+    case XK_KP_Left:
+    case XK_KP_Right:
+    case XK_KP_Up:
+    case XK_KP_Down:
+    case XK_KP_Home:
+    case XK_KP_End:
+    case XK_KP_Prior:
+    case XK_KP_Next:
+      return 1;
+  }
+
+  return 0;
+}
+
+// event compression for windows that opt in via WBSetWindowEventCompression().  Only events that are
+// already in the X11 queue are considered, and only when they immediately follow 'pEvent'.
+
+static void __InternalCompressEvent(WB_DISPLAY pDisplay, XEvent *pEvent)
+{
+_WINDOW_ENTRY_ *pEntry;
+XEvent evt, evt2;
+
+
+  pEntry = WBGetWindowEntry(pEvent->xany.window);
+
+  if(WB_LIKELY(!pEntry || !pEntry->iCompressFlags))
+  {
+    return;
+  }
+
+  if(pEvent->type == MotionNotify)
+  {
+    if(!(pEntry->iCompressFlags & WB_COMPRESS_MOTION))
+    {
+      return;
+    }
+
+    // collapse a run of motion events with the same button/modifier state into the latest one
+
+    BEGIN_XCALL_DEBUG_WRAPPER
+    while(XEventsQueued(pDisplay, QueuedAlready) > 0)
+    {
+      XPeekEvent(pDisplay, &evt);
+
+      if(evt.type != MotionNotify ||
+         evt.xmotion.window != pEvent->xmotion.window ||
+         evt.xmotion.state != pEvent->xmotion.state)
+      {
+        break;
+      }
+
+      XNextEvent(pDisplay, pEvent);
+    }
+    END_XCALL_DEBUG_WRAPPER
+  }
+  else if(pEvent->type == KeyPress)
+  {
+    pEntry->iKeyRepeat = 0;
+
+    if(!(pEntry->iCompressFlags & WB_COMPRESS_KEYREPEAT) ||
+       !__InternalIsCursorKey(&(pEvent->xkey)))
+    {
+      return;
+    }
+
+    pEntry->iKeyRepeat = 1;
+
+    BEGIN_XCALL_DEBUG_WRAPPER
+    while(XEventsQueued(pDisplay, QueuedAlready) > 0)
+    {
+      XPeekEvent(pDisplay, &evt);
+
+      if((evt.type != KeyPress && evt.type != KeyRelease) ||
+         evt.xkey.window != pEvent->xkey.window ||
+         evt.xkey.keycode != pEvent->xkey.keycode)
+      {
+        break;
+      }
+
+      if(evt.type == KeyPress) // 'detectable' auto-repeat, a KeyPress with no KeyRelease
+      {
+        if(evt.xkey.state != pEvent->xkey.state)
+        {
+          break;
+        }
+
+        XNextEvent(pDisplay, pEvent);
+        pEntry->iKeyRepeat++;
+      }
+      else
+      {
+        // normal auto-repeat sends a KeyRelease immediately followed by a KeyPress with the same time stamp
+
+        XNextEvent(pDisplay, &evt);
+
+        if(XEventsQueued(pDisplay, QueuedAlready) > 0)
+        {
+          XPeekEvent(pDisplay, &evt2);
+
+          if(evt2.type == KeyPress &&
+             evt2.xkey.window == pEvent->xkey.window &&
+             evt2.xkey.keycode == pEvent->xkey.keycode &&
+             evt2.xkey.state == pEvent->xkey.state &&
+             evt2.xkey.time == evt.xkey.time)
+          {
+            XNextEvent(pDisplay, pEvent);
+            pEntry->iKeyRepeat++;
+
+            continue;
+          }
+        }
+
+        XPutBackEvent(pDisplay, &evt); // an actual key release
+        break;
+      }
+    }
+    END_XCALL_DEBUG_WRAPPER
+  }
+}
+
 // WBCheckGetEvent - get next (prioritized) event, do translations
 
 static int iMouseState = 0;           // artificial mouse state (global) for dbl-click and drag
@@ -3733,43 +4552,142 @@ int WBCheckGetEvent(WB_DISPLAY pDisplay, XEvent *pEvent)
   return __InternalCheckGetEvent(pDisplay, pEvent, None);  // no modal window implies "do certain things differently"
 }
 
-void WBWaitForEvent(WB_DISPLAY pDisplay)
+// the earliest time index at which a timer or delayed event for 'pDisplay' becomes ready, or 0 if none
+static WB_UINT64 __NextTimeIndex(WB_DISPLAY pDisplay)
 {
-int iTemp, iSleepPeriod;
+TIMER_ENTRY *pTimer;
+DELAYED_EVENT_ENTRY *pDelayed;
+WB_UINT64 qwRval = 0;
+int iIndex;
 
-  // First, see if I have any priority or other queued events
 
-  iTemp = iWBQueuedEvent;
+  pTimer = __NextTimer(pDisplay);
 
-  // check internal queues first, if there's something there
-  // these queues won't change without calling WBCheckGetEvent()
+  if(pTimer)
+  {
+    qwRval = pTimer->lTimeIndex;
+  }
 
-  iSleepPeriod = MIN_EVENT_LOOP_SLEEP_PERIOD; // the initial value
+  iIndex = __NextDelayedEvent(pDisplay);
 
-  while(WB_LIKELY(iTemp >= 0))
+  if(iIndex >= 0)
   {
-    if(WB_LIKELY(axWBEvt[iTemp].pDisplay == pDisplay))
+    pDelayed = ppDelayedEventHeap[iIndex];
+
+    if(!qwRval || pDelayed->lTimeIndex < qwRval)
     {
-      return; // found one
+      qwRval = pDelayed->lTimeIndex;
     }
+  }
+
+  return qwRval;
+}
+
+static int __InternalInitWakeup(void)
+{
+  if(aWakeupFD[0] >= 0)
+  {
+    return 0; // already done
+  }
+
+#ifdef __linux__
+  aWakeupFD[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if(aWakeupFD[0] < 0)
+  {
+    WB_ERROR_PRINT("ERROR:  %s - unable to create eventfd, errno=%d\n", __FUNCTION__, errno);
+    return -1;
+  }
+
+  aWakeupFD[1] = aWakeupFD[0];
+#else // __linux__
+  if(pipe(aWakeupFD))
+  {
+    WB_ERROR_PRINT("ERROR:  %s - unable to create pipe, errno=%d\n", __FUNCTION__, errno);
+
+    aWakeupFD[0] = aWakeupFD[1] = -1;
+    return -1;
+  }
+
+  fcntl(aWakeupFD[0], F_SETFL, fcntl(aWakeupFD[0], F_GETFL) | O_NONBLOCK);
+  fcntl(aWakeupFD[1], F_SETFL, fcntl(aWakeupFD[1], F_GETFL) | O_NONBLOCK);
+  fcntl(aWakeupFD[0], F_SETFD, FD_CLOEXEC);
+  fcntl(aWakeupFD[1], F_SETFD, FD_CLOEXEC);
+#endif // __linux__
+
+  return 0;
+}
+
+static void __InternalExitWakeup(void)
+{
+  if(aWakeupFD[1] >= 0 && aWakeupFD[1] != aWakeupFD[0])
+  {
+    close(aWakeupFD[1]);
+  }
 
-    iTemp = axWBEvt[iTemp].iNext;
+  if(aWakeupFD[0] >= 0)
+  {
+    close(aWakeupFD[0]);
   }
 
-  iTemp = iWBPaintEvent;
+  aWakeupFD[0] = aWakeupFD[1] = -1;
+}
 
-  while(iTemp >= 0)
+static void __InternalDrainWakeup(void)
+{
+char tbuf[64];
+
+  // for an eventfd a single 8-byte read resets the counter; for a pipe, read until empty
+  while(read(aWakeupFD[0], tbuf, sizeof(tbuf)) > 0)
   {
-    if(WB_LIKELY(axWBEvt[iTemp].pDisplay == pDisplay))
+#ifdef __linux__
+    break;
+#endif // __linux__
+  }
+}
+
+void WBWakeEventLoop(void)
+{
+int iFD = aWakeupFD[1];
+WB_UINT64 qwOne = 1;
+
+  // async-signal-safe and thread-safe; a 'full' descriptor already means "wake up" so errors are ignored
+
+  if(iFD >= 0)
+  {
+    if(write(iFD, &qwOne, sizeof(qwOne)) < 0)
     {
-      return; // found one
+      // EAGAIN - a wakeup is already pending
     }
+  }
+}
+
+void WBWaitForEvent(WB_DISPLAY pDisplay)
+{
+int iTemp, iTimeout, nFD;
+WB_UINT64 qwNext, qwNow;
+struct pollfd aFD[2];
+
+
+  // First, see if I have any priority or other queued events
 
-    iTemp = axWBEvt[iTemp].iNext;
+  // check internal queues first, if there's something there
+  // these queues won't change without calling WBCheckGetEvent()
+
+  if(__WBHasQueuedEvents(pDisplay) || pPostedEvents)
+  {
+    return; // found one
   }
 
+  __InternalInitWakeup(); // if this fails, I can still wait on the display connection
+
   while(!bQuitFlag) // forever, unless I quit
   {
+    if(pPostedEvents) // posted by another thread
+    {
+      return;
+    }
+
     // check timers and internal event queues
 
     if(__CheckTimers(pDisplay, NULL))  // a timer is ready to create an event?
@@ -3782,26 +4700,75 @@ int iTemp, iSleepPeriod;
       return;
     }
 
-    if(XEventsQueued(pDisplay, QueuedAfterFlush)) // this appears to be the most efficient method to use
+    BEGIN_XCALL_DEBUG_WRAPPER
+    iTemp = XEventsQueued(pDisplay, QueuedAfterFlush); // flushes output, reads anything already available
+    END_XCALL_DEBUG_WRAPPER
+
+    if(iTemp)
     {
       return; // I have events waiting!
     }
 
-    // perform a variable delay, up to MAX_EVENT_LOOP_SLEEP_PERIOD, before checking again, so I don't 'spin'
-    // we start with the min period, so we'll more effectively capture 'bunches' of events, which would be
-    // typical for UI actions - this makes it appear 'snappier'.  But when no events happen, the sleep period
-    // will increase until it hits 'MAX_EVENT_LOOP_SLEEP_PERIOD', which should be tweeked accordingly to get
-    // minimum CPU usage while "idling" (and yet still respond to important things).
+    // block until the X server connection is readable, another thread calls WBWakeEventLoop(),
+    // or the next timer or delayed event is due.  Nothing wakes up while idle.
 
-    WBDelay(iSleepPeriod);  // 100 microsecs (0.1 milliseconds) initially, grows over time
+    qwNext = __NextTimeIndex(pDisplay);
 
-    if(iSleepPeriod < MAX_EVENT_LOOP_SLEEP_PERIOD) // up to 'MAX_EVENT_LOOP_SLEEP_PERIOD' microseconds
+    if(!qwNext)
     {
-      iSleepPeriod += (iSleepPeriod >> 2); // increase by 25%
+      iTimeout = -1; // no timers, wait indefinitely
     }
     else
     {
-      iSleepPeriod = MAX_EVENT_LOOP_SLEEP_PERIOD; // the maximum
+      qwNow = WBGetTimeIndex();
+
+      if(qwNext <= qwNow)
+      {
+        continue; // already due (loop back and let __CheckTimers or __CheckDelayedEvents see it)
+      }
+
+      qwNext = (qwNext - qwNow + 999) / 1000; // microseconds to milliseconds, rounded up
+
+      iTimeout = qwNext > INT_MAX ? INT_MAX : (int)qwNext;
+    }
+
+    aFD[0].fd = ConnectionNumber(pDisplay);
+    aFD[0].events = POLLIN;
+    aFD[0].revents = 0;
+    nFD = 1;
+
+    if(aWakeupFD[0] >= 0)
+    {
+      aFD[1].fd = aWakeupFD[0];
+      aFD[1].events = POLLIN;
+      aFD[1].revents = 0;
+      nFD = 2;
+    }
+
+    iTemp = poll(aFD, nFD, iTimeout);
+
+    if(iTemp < 0)
+    {
+      if(errno != EINTR && errno != EAGAIN)
+      {
+        WB_ERROR_PRINT("ERROR:  %s - poll() failed, errno=%d\n", __FUNCTION__, errno);
+
+        WBDelay(MIN_EVENT_LOOP_SLEEP_PERIOD); // so I don't 'spin'
+      }
+
+      continue; // a signal may have set 'bQuitFlag'
+    }
+
+    if(nFD > 1 && (aFD[1].revents & POLLIN))
+    {
+      __InternalDrainWakeup();
+
+      return; // something was posted from another thread (or a signal handler)
+    }
+
+    if(aFD[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+    {
+      return; // let the caller's next X call find the error (the I/O error handler sets bQuitFlag)
     }
   }
 }
@@ -3831,6 +4798,8 @@ int iFirstTime = 1;
 
     END_XCALL_DEBUG_WRAPPER
 
+    __DispatchStatsXQueued(iQueued);
+
     // check for selection events first...
 
     BEGIN_XCALL_DEBUG_WRAPPER
@@ -3861,6 +4830,11 @@ int iFirstTime = 1;
 
     if(iRval)
     {
+      if(pEvent->type == MotionNotify || pEvent->type == KeyPress)
+      {
+        __InternalCompressEvent(pDisplay, pEvent);
+      }
+
       if(pDisplay == pDefaultDisplay) // for default display, grab the timestamp
       {
         Time tmEvent = 0;
@@ -3968,6 +4942,11 @@ int iFirstTime = 1;
 
       if(pEntry) // notification needs to update internal 'absolute geometry' data
       {
+        // the parent-relative geometry cache is updated FIRST, so that the
+        // WBGetWindowGeom() calls below see the new values without a round trip
+
+        __InternalUpdateGeomCache(pEntry, &(pEvent->xconfigure));
+
         // NOTE:  window will get at least one of these when it becomes visible
         //        until then the values are initialized as zeros
 
@@ -4038,6 +5017,19 @@ int iFirstTime = 1;
                        pEntry->geomAbsolute.width, pEntry->geomAbsolute.height);
       }
     }
+    else if(pEvent->type == ReparentNotify)
+    {
+      _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(pEvent->xreparent.window);
+
+      // re-parenting moves the window to a new position relative to the new parent.  The
+      // size and border width do not change, so a valid cache only needs the new position
+
+      if(pEntry && pEntry->iGeomCacheState == WB_GEOM_CACHE_VALID)
+      {
+        pEntry->geomCache.x = pEvent->xreparent.x;
+        pEntry->geomCache.y = pEvent->xreparent.y;
+      }
+    }
 
     // MOUSE translations (double-click, drag help)
     // to use these, the client shouldn't handle the system mouse events
@@ -4645,7 +5637,7 @@ XEvent evtTemp;
     // bring window forward
     BEGIN_XCALL_DEBUG_WRAPPER
 
-    XConfigureWindow(pDisplay, wID, CWStackMode, &xwc);
+    XConfigureWindow(pDisplay, wID, CWStackMode, &xwc); // stacking only, geometry cache is unaffected
     XMapWindow(pDisplay, wID);
 
     END_XCALL_DEBUG_WRAPPER
@@ -4653,6 +5645,12 @@ XEvent evtTemp;
     return 1; // handled
   }
 
+  if(pEvent->xany.type == ClientMessage
+     && pEvent->xclient.message_type == aWB_TASK) // worker thread pool task completion
+  {
+    return WBTaskDispatch(pEvent);
+  }
+
   if(!pAppEventCallback || !pAppEventCallback(pEvent))
   {
     return WBAppDefault(pEvent);
@@ -4661,8 +5659,345 @@ XEvent evtTemp;
   return 0;
 }
 
+/**********************************************************************/
+/*                                                                    */
+/*                     dispatch latency statistics                    */
+/*                                                                    */
+/**********************************************************************/
+
+#define DISPATCH_CLASS_MAX 32 /* distinct window classes that are tracked; the rest are combined as "(other)" */
+
+typedef struct s_DISPATCH_CLASS_STATS
+{
+  const char *szClassName; // persistent string (see WBSetWindowClassName) or one of the special names, below
+  WB_HISTOGRAM hist;
+} DISPATCH_CLASS_STATS;
+
+static const char szDispatchClassNone[] = "(none)";
+static const char szDispatchClassApp[] = "(application)";
+static const char szDispatchClassOther[] = "(other)";
+
+static WB_HISTOGRAM aDispatchByType[LASTEvent + 1];               // the last one is for unknown event types
+static DISPATCH_CLASS_STATS aDispatchByClass[DISPATCH_CLASS_MAX + 1]; // the last one is "(other)"
+static int nDispatchClass = 0;
+static WB_HISTOGRAM histInputLatency;
+static WB_INT64 iInputOffsetMin = 0;  // smallest (local time - X server time) for an input event, in microseconds
+static int bInputOffset = 0;          // non-zero when 'iInputOffsetMin' is valid
+static WB_UINT64 nDispatchSeq = 0;    // incremented on each WBDispatch, to detect nested event loops
+static WB_UINT64 nDispatchNested = 0; // number of dispatches that weren't recorded because of a nested event loop
+static WB_UINT64 tDispatchDumpInterval = 0, tDispatchNextDump = 0; // for WBDispatchStatsSetDumpInterval
+
+static const char *__DispatchClassName(Window wID)
+{
+_WINDOW_ENTRY_ *pEntry;
+
+
+  if(wID == None)
+  {
+    return szDispatchClassApp;
+  }
+
+  pEntry = WBGetWindowEntry(wID);
+
+  return pEntry && pEntry->szClassName ? pEntry->szClassName : szDispatchClassNone;
+}
+
+// the X server's time stamp for keyboard and mouse events, or 0 for everything else
+static Time __DispatchInputTime(const XEvent *pEvent)
+{
+  if(pEvent->xany.send_event) // sent by a client, not the server
+  {
+    return 0;
+  }
+
+  switch(pEvent->type)
+  {
+    case KeyPress:
+    case KeyRelease:
+      return pEvent->xkey.time;
+
+    case ButtonPress:
+    case ButtonRelease:
+      return pEvent->xbutton.time;
+
+    case MotionNotify:
+      return pEvent->xmotion.time;
+  }
+
+  return 0;
+}
+
+static DISPATCH_CLASS_STATS *__DispatchClassStats(const char *szClassName, int bCreate)
+{
+int i1;
+
+
+  for(i1=0; i1 < nDispatchClass; i1++)
+  {
+    if(aDispatchByClass[i1].szClassName == szClassName || // the same persistent string, normally
+       !strcmp(aDispatchByClass[i1].szClassName, szClassName))
+    {
+      return aDispatchByClass + i1;
+    }
+  }
+
+  if(nDispatchClass < DISPATCH_CLASS_MAX)
+  {
+    if(!bCreate)
+    {
+      return NULL;
+    }
+
+    aDispatchByClass[nDispatchClass].szClassName = szClassName;
+
+    return aDispatchByClass + nDispatchClass++;
+  }
+
+  if(bCreate)
+  {
+    aDispatchByClass[DISPATCH_CLASS_MAX].szClassName = szDispatchClassOther;
+  }
+  else if(!aDispatchByClass[DISPATCH_CLASS_MAX].szClassName ||
+          strcmp(szClassName, szDispatchClassOther))
+  {
+    return NULL;
+  }
+
+  return aDispatchByClass + DISPATCH_CLASS_MAX;
+}
+
+static void __DispatchStatsEnd(int iType, const char *szClassName, Time tmInput, WB_UINT64 tStart, WB_UINT64 nSeq)
+{
+WB_UINT64 tEnd;
+WB_UINT32 nElapsed;
+WB_INT64 iOffset;
+
+
+  tEnd = __DispatchTimeIndex();
+
+  if(nDispatchSeq != nSeq) // a nested event loop ran, so the elapsed time doesn't mean anything
+  {
+    nDispatchNested++;
+  }
+  else
+  {
+    nElapsed = tEnd - tStart > 0xffffffffUL ? 0xffffffffUL : (WB_UINT32)(tEnd - tStart);
+
+    WBHistogramRecord(aDispatchByType + (iType >= 0 && iType < LASTEvent ? iType : LASTEvent), nElapsed);
+    WBHistogramRecord(&(__DispatchClassStats(szClassName, 1)->hist), nElapsed);
+
+    if(tmInput)
+    {
+      // The X server's clock has nothing to do with mine, so the latency is measured relative to the
+      // fastest delivery seen so far.  A jump of more than an hour means the server's (32-bit) time
+      // wrapped around, or that the X server was restarted, so that starts a new baseline.
+
+      iOffset = (WB_INT64)tEnd - (WB_INT64)tmInput * 1000;
+
+      if(!bInputOffset || iOffset < iInputOffsetMin ||
+         iOffset - iInputOffsetMin > (WB_INT64)3600 * 1000000)
+      {
+        iInputOffsetMin = iOffset;
+        bInputOffset = 1;
+      }
+
+      WBHistogramRecord(&histInputLatency, (WB_UINT32)(iOffset - iInputOffsetMin));
+    }
+  }
+
+  if(WB_UNLIKELY(tDispatchDumpInterval) && tEnd >= tDispatchNextDump)
+  {
+    WBDispatchStatsDump();
+
+    tDispatchNextDump = tEnd + tDispatchDumpInterval;
+  }
+}
+
+void WBDispatchStatsEnable(int bEnable)
+{
+  bDispatchStats = bEnable ? 1 : 0;
+}
+
+const WB_HISTOGRAM *WBDispatchStatsByType(int iEventType)
+{
+  if(iEventType < 0 || iEventType >= LASTEvent || !aDispatchByType[iEventType].nCount)
+  {
+    return NULL;
+  }
+
+  return aDispatchByType + iEventType;
+}
+
+const WB_HISTOGRAM *WBDispatchStatsByClass(const char *szClassName)
+{
+DISPATCH_CLASS_STATS *pStats;
+
+
+  pStats = __DispatchClassStats(szClassName ? szClassName : szDispatchClassNone, 0);
+
+  return pStats && pStats->hist.nCount ? &(pStats->hist) : NULL;
+}
+
+const WB_HISTOGRAM *WBDispatchStatsInputLatency(void)
+{
+  return &histInputLatency;
+}
+
+const WB_HISTOGRAM *WBDispatchStatsQueueAge(void)
+{
+  return &histQueueAge;
+}
+
+void WBDispatchStatsGauges(WB_DISPATCH_GAUGES *pGauges)
+{
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry;
+WB_UINT64 tNow, tOldest = 0;
+
+
+  pGauges->nQueued = nEventsQueued;
+  pGauges->nQueuedMax = nEventsQueuedMax;
+  pGauges->nXQueued = nXEventsQueued;
+  pGauges->nXQueuedMax = nXEventsQueuedMax;
+
+  // priority events go to the head of the queue, so the oldest one could be anywhere
+
+  for(pQ=pEventQueues; pQ; pQ=pQ->pNext)
+  {
+    for(pEntry=pQ->pHead; pEntry; pEntry=pEntry->pNext)
+    {
+      if(pEntry->tQueued && (!tOldest || pEntry->tQueued < tOldest))
+      {
+        tOldest = pEntry->tQueued;
+      }
+    }
+
+    for(pEntry=pQ->pPaintHead; pEntry; pEntry=pEntry->pNext)
+    {
+      if(pEntry->tQueued && (!tOldest || pEntry->tQueued < tOldest))
+      {
+        tOldest = pEntry->tQueued;
+      }
+    }
+  }
+
+  tNow = __DispatchTimeIndex();
+
+  if(!tOldest || tNow <= tOldest)
+  {
+    pGauges->nOldestAge = 0;
+  }
+  else
+  {
+    pGauges->nOldestAge = tNow - tOldest > 0xffffffffUL ? 0xffffffffUL : (WB_UINT32)(tNow - tOldest);
+  }
+}
+
+void WBDispatchStatsReset(void)
+{
+  bzero(aDispatchByType, sizeof(aDispatchByType));
+  bzero(aDispatchByClass, sizeof(aDispatchByClass));
+  bzero(&histInputLatency, sizeof(histInputLatency));
+  bzero(&histQueueAge, sizeof(histQueueAge));
+
+  nDispatchClass = 0;
+  bInputOffset = 0;
+  nDispatchNested = 0;
+
+  nEventsQueuedMax = nEventsQueued;
+  nXEventsQueuedMax = nXEventsQueued;
+}
+
+static void __DispatchStatsDumpLine(const char *szTitle, const char *szName, const WB_HISTOGRAM *pHist)
+{
+  WBDebugPrint("  %-14s %-24s %10llu %10.1f %10u %10u %10u %10u %10u\n",
+               szTitle, szName,
+               (unsigned long long)pHist->nCount,
+               pHist->nCount ? (double)pHist->nSum / (double)pHist->nCount : 0.0,
+               (unsigned int)WBHistogramPercentile(pHist, 50.0),
+               (unsigned int)WBHistogramPercentile(pHist, 90.0),
+               (unsigned int)WBHistogramPercentile(pHist, 99.0),
+               (unsigned int)WBHistogramPercentile(pHist, 99.9),
+               (unsigned int)pHist->nMax);
+}
+
+void WBDispatchStatsDump(void)
+{
+WB_DISPATCH_GAUGES gauges;
+const char *szName;
+char tbuf[32];
+int i1;
+
+
+  WBDebugPrint("\n** DISPATCH STATISTICS **  (times in microseconds)\n"
+               "  %-14s %-24s %10s %10s %10s %10s %10s %10s %10s\n",
+               "", "", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+
+  for(i1=0; i1 <= LASTEvent; i1++)
+  {
+    if(aDispatchByType[i1].nCount)
+    {
+      szName = i1 < LASTEvent ? WBEventName(i1) : NULL;
+
+      if(!szName)
+      {
+        snprintf(tbuf, sizeof(tbuf), "(type %d)", i1);
+        szName = tbuf;
+      }
+
+      __DispatchStatsDumpLine("event", szName, aDispatchByType + i1);
+    }
+  }
+
+  for(i1=0; i1 <= DISPATCH_CLASS_MAX; i1++)
+  {
+    if(aDispatchByClass[i1].hist.nCount)
+    {
+      __DispatchStatsDumpLine("window class", aDispatchByClass[i1].szClassName, &(aDispatchByClass[i1].hist));
+    }
+  }
+
+  __DispatchStatsDumpLine("input latency", "(key, button, motion)", &histInputLatency);
+  __DispatchStatsDumpLine("queue age", "(internal queues)", &histQueueAge);
+
+  WBDispatchStatsGauges(&gauges);
+
+  WBDebugPrint("  queued events:  %d (max %d), Xlib queue:  %d (max %d), oldest:  %u usec, nested (not timed):  %llu\n\n",
+               gauges.nQueued, gauges.nQueuedMax, gauges.nXQueued, gauges.nXQueuedMax,
+               (unsigned int)gauges.nOldestAge, (unsigned long long)nDispatchNested);
+}
+
+void WBDispatchStatsSetDumpInterval(int nSeconds)
+{
+  tDispatchDumpInterval = nSeconds > 0 ? (WB_UINT64)nSeconds * 1000000 : 0;
+  tDispatchNextDump = __DispatchTimeIndex() + tDispatchDumpInterval;
+}
+
+WB_DEFINE_PROFILE(dispatch);
+
 void WBDispatch(XEvent *pEvent)
 {
+const char *szClassName = NULL;
+WB_UINT64 tStart = 0, nSeq = 0;
+Time tmInput = 0;
+int iType = pEvent->type;
+
+
+  WB_ENABLE_PROFILE(dispatch, "WBDispatch - dispatch one event");
+  WB_START_PROFILE(dispatch);
+
+  if(WB_LIKELY(bDispatchStats))
+  {
+    // the window's class and the event's time stamp are obtained now, because the
+    // window might be destroyed (and the event modified) by the time I'm done
+
+    szClassName = __DispatchClassName(pEvent->xany.window);
+    tmInput = __DispatchInputTime(pEvent);
+
+    nSeq = ++nDispatchSeq;
+    tStart = __DispatchTimeIndex();
+  }
+
   // determine the window ID for the message, if applicable
 
 //  if(pEvent->type == KeymapEvent)
@@ -4678,6 +6013,13 @@ void WBDispatch(XEvent *pEvent)
   }
 
   __PeriodicWindowEntryCleanup(); // TODO:  find a more intelligent way to make this work
+
+  if(WB_LIKELY(tStart != 0))
+  {
+    __DispatchStatsEnd(iType, szClassName, tmInput, tStart, nSeq);
+  }
+
+  WB_STOP_PROFILE(dispatch);
 }
 
 
@@ -5143,6 +6485,21 @@ int WBDefault(Window wID, XEvent *pEvent)
       evt.data.l[1] = iACS;
       evt.data.l[2] = cbData;
 
+      if(iACS & WB_KEYEVENT_KEYSYM) // pass along the repeat count from event compression (the decode buffer is not used)
+      {
+        _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(pEvent->xany.window);
+
+        if(pEntry)
+        {
+          if(pEntry->iKeyRepeat > 1)
+          {
+            evt.data.l[4] = pEntry->iKeyRepeat;
+          }
+
+          pEntry->iKeyRepeat = 0;
+        }
+      }
+
       // pressing or releasing shift, ctrl, alt, or 'meta' must not
       // generate an event.  Fortunately these are all within a range
 
@@ -5189,14 +6546,14 @@ int WBDefault(Window wID, XEvent *pEvent)
       // TODO: make this more efficient, eh?
       // TODO:  see if I even need this.  I've not been sharing WBMenu resources at all...
 
-      for(i1=0; i1 <= WINDOW_ENTRY_ARRAY_MAX; i1++)
+      for(pEntry = pWindowEntryHead; pEntry; pEntry = pEntry->pNextEntry)
       {
-        if(sWBHashEntries[i1].wIDMenu == wIDMenu)
+        if(pEntry->wIDMenu == wIDMenu)
           break;
       }
 
       // am I the last guy using the menu?
-      if(i1 > WINDOW_ENTRY_ARRAY_MAX)
+      if(!pEntry)
       {
         WBDestroyWindow(wIDMenu);
       }
@@ -6274,6 +7631,29 @@ const char *WBGetWindowClassName(Window wID)
   return(NULL);
 }
 
+void WBSetWindowEventCompression(Window wID, int iFlags)
+{
+  _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+  if(pEntry)
+  {
+    pEntry->iCompressFlags = iFlags & (WB_COMPRESS_MOTION | WB_COMPRESS_KEYREPEAT);
+    pEntry->iKeyRepeat = 0;
+  }
+}
+
+int WBGetWindowEventCompression(Window wID)
+{
+  _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+  if(pEntry)
+  {
+    return(pEntry->iCompressFlags);
+  }
+
+  return(0);
+}
+
 void *WBGetWindowData(Window wID, int iIndex)
 {
   _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
@@ -6466,16 +7846,70 @@ void WBRestoreDefaultCursor(Window wID)
 {
   _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 
-  if(pEntry)
+  if(pEntry)
+  {
+    pEntry->idCursor = pEntry->idDefaultCursor;
+    __InternalSetWindowCursor(wID, pEntry->idDefaultCursor); // restore the cursor immediately
+  }
+}
+
+
+// read-only window properties
+
+static void __InternalUpdateGeomCache(_WINDOW_ENTRY_ *pEntry, const XConfigureEvent *pEvent)
+{
+  if(pEvent->send_event) // synthetic, typically from the window manager
+  {
+    // a synthetic ConfigureNotify reports ROOT-relative coordinates, which is not what
+    // XGetGeometry returns for a re-parented window.  Size and border are still correct.
+
+    if(pEntry->iGeomCacheState == WB_GEOM_CACHE_VALID)
+    {
+      pEntry->geomCache.width = pEvent->width;
+      pEntry->geomCache.height = pEvent->height;
+      pEntry->geomCache.border = pEvent->border_width;
+    }
+
+    return;
+  }
+
+  pEntry->geomCache.x = pEvent->x;
+  pEntry->geomCache.y = pEvent->y;
+  pEntry->geomCache.width = pEvent->width;
+  pEntry->geomCache.height = pEvent->height;
+  pEntry->geomCache.border = pEvent->border_width;
+
+  pEntry->iGeomCacheState = WB_GEOM_CACHE_VALID; // from now on, this window's geometry is tracked
+}
+
+int WBGetCachedWindowGeom(Window wID, WB_GEOM *pGeom)
+{
+  _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+  if(!pEntry || pEntry->iGeomCacheState != WB_GEOM_CACHE_VALID ||
+     WB_IS_WINDOW_DESTROYED(*pEntry) || WB_IS_WINDOW_BEING_DESTROYED(*pEntry))
+  {
+    return -1;
+  }
+
+  if(pGeom)
+  {
+    memcpy(pGeom, &(pEntry->geomCache), sizeof(*pGeom));
+  }
+
+  return 0;
+}
+
+void WBMarkWindowGeomStale(Window wID)
+{
+  _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+  if(pEntry && pEntry->iGeomCacheState == WB_GEOM_CACHE_VALID)
   {
-    pEntry->idCursor = pEntry->idDefaultCursor;
-    __InternalSetWindowCursor(wID, pEntry->idDefaultCursor); // restore the cursor immediately
+    pEntry->iGeomCacheState = WB_GEOM_CACHE_STALE; // re-read on next query, or updated by ConfigureNotify
   }
 }
 
-
-// read-only window properties
-
 void WBGetWindowGeom0(Window wID, WB_GEOM *pGeom)  // absolute window geometry (from latest notification)
 {
   _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
@@ -6596,6 +8030,13 @@ void WBGetWindowGeom(Window wID, WB_GEOM *pGeom)
 
     return;
   }
+  else if(pEntry->iGeomCacheState == WB_GEOM_CACHE_VALID)
+  {
+    // cached geometry is kept current via ConfigureNotify, so there's no need to ask the server
+
+    memcpy(pGeom, &(pEntry->geomCache), sizeof(*pGeom));
+    return;
+  }
 //  else if(!WB_IS_WINDOW_MAPPED(*pEntry))
 //  {
 //    WB_ERROR_PRINT("TEMPORARY:  %s - unmapped window, no 'absolute' GEOM available (pre 'X' calls)\n", __FUNCTION__);
@@ -6609,6 +8050,15 @@ void WBGetWindowGeom(Window wID, WB_GEOM *pGeom)
                &(pGeom->border), &uiDepth);
   END_XCALL_DEBUG_WRAPPER
 
+  if(pEntry && pEntry->iGeomCacheState == WB_GEOM_CACHE_STALE)
+  {
+    // the window is tracked via ConfigureNotify, but a local change made the cache stale.
+    // now that I have the real values, it's valid again.
+
+    memcpy(&(pEntry->geomCache), pGeom, sizeof(*pGeom));
+    pEntry->iGeomCacheState = WB_GEOM_CACHE_VALID;
+  }
+
 //  if(pEntry && !WB_IS_WINDOW_MAPPED(*pEntry))
 //  {
 //    WB_ERROR_PRINT("TEMPORARY:  %s - unmapped window, no 'absolute' GEOM available (post 'X' calls)\n", __FUNCTION__);
@@ -6681,12 +8131,19 @@ void WBGetWindowGeom2(Window wID, WB_GEOM *pGeom)
 //  }
 
 
-  BEGIN_XCALL_DEBUG_WRAPPER
-  XGetGeometry(pDisp, wID, &winRoot,
-               &(pGeom->x), &(pGeom->y),
-               &(pGeom->width), &(pGeom->height),
-               &(pGeom->border), &uiDepth);
-  END_XCALL_DEBUG_WRAPPER
+  if(!WBGetCachedWindowGeom(wID, pGeom))
+  {
+    winRoot = DefaultRootWindow(pDisp); // only used to terminate the loop below
+  }
+  else
+  {
+    BEGIN_XCALL_DEBUG_WRAPPER
+    XGetGeometry(pDisp, wID, &winRoot,
+                 &(pGeom->x), &(pGeom->y),
+                 &(pGeom->width), &(pGeom->height),
+                 &(pGeom->border), &uiDepth);
+    END_XCALL_DEBUG_WRAPPER
+  }
 
   WB_DEBUG_PRINT(DebugLevel_Excessive | DebugSubSystem_Window,
                  "%s - geometry for window %d (%08xH) = %d,%d,%d,%d,%d\n",
@@ -6709,12 +8166,15 @@ void WBGetWindowGeom2(Window wID, WB_GEOM *pGeom)
 
     bzero(&geom, sizeof(geom));
 
-    BEGIN_XCALL_DEBUG_WRAPPER
-    XGetGeometry(pDisp, wParent, &winRoot,  // assumes parent windows have same display, which is reasonable
-                 &geom.x, &geom.y,
-                 &geom.width, &geom.height,
-                 &geom.border, &uiDepth);
-    END_XCALL_DEBUG_WRAPPER
+    if(WBGetCachedWindowGeom(wParent, &geom))
+    {
+      BEGIN_XCALL_DEBUG_WRAPPER
+      XGetGeometry(pDisp, wParent, &winRoot,  // assumes parent windows have same display, which is reasonable
+                   &geom.x, &geom.y,
+                   &geom.width, &geom.height,
+                   &geom.border, &uiDepth);
+      END_XCALL_DEBUG_WRAPPER
+    }
 
     WB_DEBUG_PRINT(DebugLevel_Excessive | DebugSubSystem_Window,
                    "%s - geometry for parent window %d (%08xH) = %d,%d,%d,%d,%d\n",
@@ -6967,6 +8427,18 @@ int bKeySym = 0;
   return cRval;
 }
 
+int WBGetCharEventRepeat(const XClientMessageEvent *pEvent)
+{
+  if(pEvent && pEvent->message_type == aWB_CHAR &&
+     (pEvent->data.l[1] & WB_KEYEVENT_KEYSYM) &&
+     pEvent->data.l[4] > 1)
+  {
+    return (int)pEvent->data.l[4];
+  }
+
+  return 1;
+}
+
 
 
 // parent-child relationships
@@ -7041,6 +8513,8 @@ int WBReparentWindow(Window wID, Window wIDParent, int iX, int iY)
 
   iRval = XReparentWindow(pDisplay, wID, wIDParent, iX, iY);
 
+  WBMarkWindowGeomStale(wID); // until ReparentNotify arrives
+
   if(iRval < 0 && pEntry)  // TODO: verify if non-zero or negative is error
   {
     pEntry->wParent = wIDParent;
@@ -7207,17 +8681,16 @@ Window WBGetMenuWindow(Window wID)
 
 void WBRemoveMenuWindow(Window wID, Window wIDMenu)
 {
-  int i1;
   _WINDOW_ENTRY_ *pEntry = NULL;
 
 
   if(wID == -1)  // meaning ALL of them
   {
-    for(i1=0; i1 <= WINDOW_ENTRY_ARRAY_MAX; i1++)
+    for(pEntry = pWindowEntryHead; pEntry; pEntry = pEntry->pNextEntry)
     {
-      if(sWBHashEntries[i1].wIDMenu == wIDMenu)
+      if(pEntry->wIDMenu == wIDMenu)
       {
-        sWBHashEntries[i1].wIDMenu = 0;
+        pEntry->wIDMenu = 0;
       }
     }
 
@@ -7773,6 +9246,8 @@ WBGC WBBeginPaint(Window wID, XExposeEvent *pEvent, WB_GEOM *pgBounds)
 _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 WB_GEOM geomTemp;
 WBGC gcRval;
+Region rgnExpose;
+XRectangle xrct;
 int iRet;
 
 
@@ -7788,6 +9263,26 @@ int iRet;
   geomTemp.width  = pEvent->width;
   geomTemp.height = pEvent->height;
 
+  // if this is a consolidated Expose event from the paint queue, the exposed region was handed off
+  // to the window entry.  Use it (instead of the bounding rectangle) to limit the paint region.
+
+  rgnExpose = pEntry->rgnExpose;
+  pEntry->rgnExpose = None;
+
+  if(rgnExpose != None)
+  {
+    BEGIN_XCALL_DEBUG_WRAPPER
+    XClipBox(rgnExpose, &xrct);
+    END_XCALL_DEBUG_WRAPPER
+
+    if(xrct.x != pEvent->x || xrct.y != pEvent->y ||
+       xrct.width != pEvent->width || xrct.height != pEvent->height) // not for this event
+    {
+      XDestroyRegion(rgnExpose);
+      rgnExpose = None;
+    }
+  }
+
   BEGIN_XCALL_DEBUG_WRAPPER
   iRet = XEmptyRegion(pEntry->rgnClip);
   END_XCALL_DEBUG_WRAPPER
@@ -7802,7 +9297,7 @@ int iRet;
   }
   else
   {
-    gcRval = WBBeginPaintGeom(wID, &geomTemp);
+    gcRval = __InternalBeginPaint(wID, rgnExpose, &geomTemp);
 
     if(gcRval && pgBounds)
     {
@@ -7813,16 +9308,26 @@ int iRet;
     }
   }
 
+  if(rgnExpose != None)
+  {
+    XDestroyRegion(rgnExpose);
+  }
+
   return gcRval;
 }
 
 WBGC WBBeginPaintGeom(Window wID, WB_GEOM *pgBounds) // WBGC will get the 'invalid' region assigned as clip region
+{
+  return __InternalBeginPaint(wID, None, pgBounds);
+}
+
+static WBGC __InternalBeginPaint(Window wID, Region rgnBounds, WB_GEOM *pgBounds)
 {
   _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
   WBGC gcRval;
   Region rgnPaint;
   XRectangle xrct;
-  int iRet;
+  int iRet = 0;
 
 
   if(!pEntry || !pgBounds)
@@ -7924,12 +9429,20 @@ WBGC WBBeginPaintGeom(Window wID, WB_GEOM *pgBounds) // WBGC will get the 'inval
         xrct.height = pgBounds->height;
 
         BEGIN_XCALL_DEBUG_WRAPPER
-        XUnionRectWithRegion(&xrct, rgnTemp, rgnTemp);  // the paint rectangle as a region
+        if(rgnBounds != None)
+        {
+          XUnionRegion(rgnBounds, rgnTemp, rgnTemp);      // the exposed area, which lies within xrct
+        }
+        else
+        {
+          XUnionRectWithRegion(&xrct, rgnTemp, rgnTemp);  // the paint rectangle as a region
+        }
         XUnionRegion(pEntry->rgnClip, rgnPaint, rgnPaint);  // a copy of the invalid region
         XIntersectRegion(rgnTemp, rgnPaint, rgnPaint);      // INTERSECT with xrct (usually from the Expose event)
 
         // so now the paint region includes the intersect of the xrct passed as 'pgBounds' with the invalid region
-        // (if called by WBBeginPaint, 'pgBounds' will be the rectangular area from the Expose event)
+        // (if called by WBBeginPaint, 'pgBounds' will be the rectangular area from the Expose event, and
+        //  'rgnBounds' the actual exposed area when several Expose events were consolidated into one)
 
         XDestroyRegion(rgnTemp);
         END_XCALL_DEBUG_WRAPPER
@@ -8165,6 +9678,7 @@ _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
 #ifdef USE_WINDOW_XIMAGE
   if(!disable_imagecache && !(pEntry->pImage)) // this allows me to do a 'soft disable' of the image cache
   {
+    WB_GEOM geom;
     Window winRoot = None;
     int iX0=0, iY0=0;
     unsigned int iWidth0=0, iHeight0=0, iBorder;
@@ -8180,7 +9694,15 @@ _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
     }
 
     BEGIN_XCALL_DEBUG_WRAPPER
-    XGetGeometry(pDisplay, wID, &winRoot, &iX0, &iY0, &iWidth0, &iHeight0, &iBorder, &uiDepth);
+    if(!WBGetCachedWindowGeom(wID, &geom)) // avoids a round trip whenever possible
+    {
+      iWidth0 = geom.width;
+      iHeight0 = geom.height;
+    }
+    else
+    {
+      XGetGeometry(pDisplay, wID, &winRoot, &iX0, &iY0, &iWidth0, &iHeight0, &iBorder, &uiDepth);
+    }
 
     // TODO:  if the window has never been painted, create a blank pixmap and fill with the background color
     //        It may also be possible (for a completely invalid window) to erase its pixmap and then create
@@ -8198,255 +9720,583 @@ _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
   }
 #endif // USE_WINDOW_XIMAGE
 
-  return pEntry->pImage;
+  return pEntry->pImage;
+}
+
+
+int WBAssignWindowImage(WB_DISPLAY pDisplay, Window wID, XImage *pImage)
+{
+_WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+
+  if(!pEntry || (pEntry->iFlags & WBCreateWindow_flagsNoImageCache))
+  {
+    return -1; // not using an image, can't assign one
+  }
+
+
+  return -1; // for now
+}
+
+
+int WBCopyIntoWindowImage(WB_DISPLAY pDisplay, Window wID, XImage *pSrcImage,
+                          int xSrc, int ySrc, int width, int height,
+                          int xOffs, int yOffs)
+{
+_WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+
+  if(!pEntry || (pEntry->iFlags & WBCreateWindow_flagsNoImageCache))
+  {
+    return -1; // not using an image, can't assign one nor copy
+    // TODO:  handle this situation using a Pixmap and copy to window instead??
+  }
+
+
+  return -1; // for now
+}
+
+
+void WBUpdateWindowWithImage(WB_DISPLAY pDisplay, Window wID)
+{
+_WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+
+  // TODO:  see __internalDoAntiAlias in draw_text.c for similar operations
+
+  if(!pEntry || pEntry->iWindowState == WB_WINDOW_DESTROYED) // so that there is no attempt to use the window
+  {
+    if(!pEntry)
+    {
+      WB_WARN_PRINT("WARNING:  %s - no 'window entry' for Window %d (%08xH)\n",
+                    __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
+    }
+    else
+    {
+      WB_DEBUG_PRINT(DebugLevel_Medium, "WARNING:  %s - NOT updating 'destroyed' Window %d (%08xH)\n",
+                    __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
+    }
+
+    return;
+  }
+
+  // use the current (default) graphics context.  if not valid, fail.
+  // TODO:  make a copy and ONLY update the current 'invalid' region instead??
+  //        this might actually speed things up a LOT
+
+  if(pEntry->hGC == None) // no default GC - can't do this
+  {
+    WB_DEBUG_PRINT(DebugLevel_Light, "WARNING:  %s - no GC for Window %d (%08xH)\n",
+                  __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
+    return;
+  }
+
+  if(!(pEntry->pImage))
+  {
+    WB_WARN_PRINT("WARNING:  %s - no XImage for %d (%08xH) - this should never happen\n",
+                  __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
+  }
+  else
+  {
+    WB_GEOM geom;
+    Window winRoot = None;
+    int iX0=0, iY0=0;
+    unsigned int iWidth0=0, iHeight0=0, iBorder;
+    unsigned int uiDepth = 0;
+
+    if(!pDisplay)
+    {
+      pDisplay = pEntry->pDisplay;
+      if(!pDisplay)
+      {
+        pDisplay = WBGetDefaultDisplay();
+      }
+    }
+
+    if(!WBGetCachedWindowGeom(wID, &geom)) // avoids a round trip whenever possible
+    {
+      iX0 = geom.x;
+      iY0 = geom.y;
+      iWidth0 = geom.width;
+      iHeight0 = geom.height;
+    }
+    else
+    {
+      BEGIN_XCALL_DEBUG_WRAPPER
+      XGetGeometry(pDisplay, wID, &winRoot, &iX0, &iY0, &iWidth0, &iHeight0, &iBorder, &uiDepth);
+      END_XCALL_DEBUG_WRAPPER
+    }
+
+    // if the image size is too small, reduce width and height accordingly
+
+    if(WB_UNLIKELY(pEntry->pImage->width < iWidth0))
+    {
+      iWidth0 = pEntry->pImage->width;
+    }
+
+    if(WB_UNLIKELY(pEntry->pImage->height < iHeight0))
+    {
+      iHeight0 = pEntry->pImage->height;
+    }
+
+    // TODO:  limit the update to the bounding rectangle of the invalid/clipping region.  This
+    //        might be fastest.  But, when the invalid/clip region is empty, do it ALL.
+
+    WBXPutImage(pDisplay, wID, pEntry->hGC, pEntry->pImage, 0, 0, iX0, iY0, iWidth0, iHeight0);
+    // NOTE:  this process should be very fast by comparison to getting the image from the drawable (window)
+  }
+}
+
+
+
+/**********************************************************************/
+/*                                                                    */
+/*                  internal event queue processing                   */
+/*                                                                    */
+/**********************************************************************/
+
+static EVENT_QUEUE *__WBGetEventQueue(WB_DISPLAY pDisp, int bCreate)
+{
+EVENT_QUEUE *pQ;
+
+  if(WB_LIKELY(pLastEventQueue && pLastEventQueue->pDisplay == pDisp))
+  {
+    return pLastEventQueue;
+  }
+
+  for(pQ = pEventQueues; pQ; pQ = pQ->pNext)
+  {
+    if(pQ->pDisplay == pDisp)
+    {
+      pLastEventQueue = pQ;
+      return pQ;
+    }
+  }
+
+  if(!bCreate)
+  {
+    return NULL;
+  }
+
+  pQ = (EVENT_QUEUE *)WBAlloc(sizeof(*pQ));
+
+  if(!pQ)
+  {
+    WB_ERROR_PRINT("ERROR: %s - not enough memory for event queue\n", __FUNCTION__);
+    return NULL;
+  }
+
+  bzero(pQ, sizeof(*pQ));
+  pQ->pDisplay = pDisp;
+  pQ->pNext = pEventQueues;
+  pEventQueues = pQ;
+
+  pLastEventQueue = pQ;
+
+  return pQ;
+}
+
+static EVENT_ENTRY *__WBAllocEventEntry(void)
+{
+EVENT_ENTRY *pRval;
+int i1;
+
+  if(WB_UNLIKELY(!pFreeEvents)) // allocate another block
+  {
+    void **ppNew = (void **)WBReAlloc(ppEventBlocks, (nEventBlocks + 1) * sizeof(*ppNew));
+
+    if(!ppNew)
+    {
+      return NULL;
+    }
+
+    ppEventBlocks = ppNew;
+
+    pRval = (EVENT_ENTRY *)WBAlloc(EVENT_BLOCK_SIZE * sizeof(EVENT_ENTRY));
+
+    if(!pRval)
+    {
+      return NULL;
+    }
+
+    ppEventBlocks[nEventBlocks++] = pRval;
+
+    for(i1=0; i1 < EVENT_BLOCK_SIZE; i1++)
+    {
+      pRval[i1].pNext = pFreeEvents;
+      pFreeEvents = pRval + i1;
+    }
+  }
+
+  pRval = pFreeEvents;
+  pFreeEvents = pRval->pNext;
+
+  pRval->pNext = pRval->pPrev = NULL;
+  pRval->tQueued = bDispatchStats ? __DispatchTimeIndex() : 0; // entries are only allocated to be queued
+
+  if(++nEventsQueued > nEventsQueuedMax)
+  {
+    nEventsQueuedMax = nEventsQueued;
+  }
+
+  return pRval;
+}
+
+static void __WBFreeEventEntry(EVENT_ENTRY *pEntry)
+{
+  pEntry->pPrev = NULL;
+  pEntry->pNext = pFreeEvents;
+  pFreeEvents = pEntry;
+
+  nEventsQueued--;
+}
+
+// an entry is about to be dispatched, so record how long it was queued
+static __inline__ void __WBEventEntryDequeued(const EVENT_ENTRY *pEntry)
+{
+WB_UINT64 tAge;
+
+
+  if(bDispatchStats && pEntry->tQueued)
+  {
+    tAge = __DispatchTimeIndex() - pEntry->tQueued;
+
+    WBHistogramRecord(&histQueueAge, tAge > 0xffffffffUL ? 0xffffffffUL : (WB_UINT32)tAge);
+  }
 }
 
+// O(1) insert/remove within one of the queues, identified by its head and tail pointers
 
-int WBAssignWindowImage(WB_DISPLAY pDisplay, Window wID, XImage *pImage)
+static void __WBLinkEventTail(EVENT_ENTRY **ppHead, EVENT_ENTRY **ppTail, EVENT_ENTRY *pEntry)
 {
-_WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
-
+  pEntry->pNext = NULL;
+  pEntry->pPrev = *ppTail;
 
-  if(!pEntry || (pEntry->iFlags & WBCreateWindow_flagsNoImageCache))
+  if(*ppTail)
   {
-    return -1; // not using an image, can't assign one
+    (*ppTail)->pNext = pEntry;
+  }
+  else
+  {
+    *ppHead = pEntry;
   }
 
-
-  return -1; // for now
+  *ppTail = pEntry;
 }
 
-
-int WBCopyIntoWindowImage(WB_DISPLAY pDisplay, Window wID, XImage *pSrcImage,
-                          int xSrc, int ySrc, int width, int height,
-                          int xOffs, int yOffs)
+static void __WBLinkEventHead(EVENT_ENTRY **ppHead, EVENT_ENTRY **ppTail, EVENT_ENTRY *pEntry)
 {
-_WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+  pEntry->pPrev = NULL;
+  pEntry->pNext = *ppHead;
+
+  if(*ppHead)
+  {
+    (*ppHead)->pPrev = pEntry;
+  }
+  else
+  {
+    *ppTail = pEntry;
+  }
 
+  *ppHead = pEntry;
+}
 
-  if(!pEntry || (pEntry->iFlags & WBCreateWindow_flagsNoImageCache))
+static void __WBUnlinkEvent(EVENT_ENTRY **ppHead, EVENT_ENTRY **ppTail, EVENT_ENTRY *pEntry)
+{
+  if(pEntry->pPrev)
   {
-    return -1; // not using an image, can't assign one nor copy
-    // TODO:  handle this situation using a Pixmap and copy to window instead??
+    pEntry->pPrev->pNext = pEntry->pNext;
+  }
+  else
+  {
+    *ppHead = pEntry->pNext;
   }
 
+  if(pEntry->pNext)
+  {
+    pEntry->pNext->pPrev = pEntry->pPrev;
+  }
+  else
+  {
+    *ppTail = pEntry->pPrev;
+  }
 
-  return -1; // for now
+  pEntry->pNext = pEntry->pPrev = NULL;
 }
 
+static unsigned long __PaintRectArea(const XRectangle *pRect)
+{
+  return (unsigned long)pRect->width * (unsigned long)pRect->height;
+}
 
-void WBUpdateWindowWithImage(WB_DISPLAY pDisplay, Window wID)
+static void __PaintRectUnion(const XRectangle *pR1, const XRectangle *pR2, XRectangle *pRval)
 {
-_WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+int iX, iY, iX2, iY2;
 
-  // TODO:  see __internalDoAntiAlias in draw_text.c for similar operations
+  iX  = pR1->x < pR2->x ? pR1->x : pR2->x;
+  iY  = pR1->y < pR2->y ? pR1->y : pR2->y;
+  iX2 = pR1->x + pR1->width > pR2->x + pR2->width ? pR1->x + pR1->width : pR2->x + pR2->width;
+  iY2 = pR1->y + pR1->height > pR2->y + pR2->height ? pR1->y + pR1->height : pR2->y + pR2->height;
 
-  if(!pEntry || pEntry->iWindowState == WB_WINDOW_DESTROYED) // so that there is no attempt to use the window
-  {
-    if(!pEntry)
-    {
-      WB_WARN_PRINT("WARNING:  %s - no 'window entry' for Window %d (%08xH)\n",
-                    __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
-    }
-    else
-    {
-      WB_DEBUG_PRINT(DebugLevel_Medium, "WARNING:  %s - NOT updating 'destroyed' Window %d (%08xH)\n",
-                    __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
-    }
+  pRval->x = iX;
+  pRval->y = iY;
+  pRval->width = iX2 - iX;
+  pRval->height = iY2 - iY;
+}
 
-    return;
-  }
+// add a rectangle to a paint queue entry's list of exposed areas.  Rectangles that can be combined without
+// adding (much) area that was not exposed are merged.  When the list is full, the new rectangle is merged
+// with whichever existing one grows the least, so the list over-approximates but never loses area.
 
-  // use the current (default) graphics context.  if not valid, fail.
-  // TODO:  make a copy and ONLY update the current 'invalid' region instead??
-  //        this might actually speed things up a LOT
+static void __WBAddPaintRect(EVENT_ENTRY *pEntry, const XRectangle *pRect)
+{
+XRectangle xrct, xrctU;
+unsigned long ulCost, ulBestCost;
+int i1, iBest;
 
-  if(pEntry->hGC == None) // no default GC - can't do this
+
+  if(!pRect->width || !pRect->height)
   {
-    WB_DEBUG_PRINT(DebugLevel_Light, "WARNING:  %s - no GC for Window %d (%08xH)\n",
-                  __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
     return;
   }
 
-  if(!(pEntry->pImage))
-  {
-    WB_WARN_PRINT("WARNING:  %s - no XImage for %d (%08xH) - this should never happen\n",
-                  __FUNCTION__, (unsigned int)wID, (unsigned int)wID);
-  }
-  else
+  xrct = *pRect;
+
+  for(;;)
   {
-    Window winRoot = None;
-    int iX0=0, iY0=0;
-    unsigned int iWidth0=0, iHeight0=0, iBorder;
-    unsigned int uiDepth = 0;
+    i1 = 0;
 
-    if(!pDisplay)
+    while(i1 < pEntry->nPaintRect)
     {
-      pDisplay = pEntry->pDisplay;
-      if(!pDisplay)
+      __PaintRectUnion(&xrct, pEntry->aPaintRect + i1, &xrctU);
+
+      // merge when the union is no larger than the two areas separately (this includes containment)
+
+      if(__PaintRectArea(&xrctU) <= __PaintRectArea(&xrct) + __PaintRectArea(pEntry->aPaintRect + i1))
       {
-        pDisplay = WBGetDefaultDisplay();
-      }
-    }
+        xrct = xrctU;
 
-    BEGIN_XCALL_DEBUG_WRAPPER
-    // TODO:  always use cached information from pEntry ???
-    XGetGeometry(pDisplay, wID, &winRoot, &iX0, &iY0, &iWidth0, &iHeight0, &iBorder, &uiDepth);
-    END_XCALL_DEBUG_WRAPPER
+        pEntry->aPaintRect[i1] = pEntry->aPaintRect[--(pEntry->nPaintRect)];
 
-    // if the image size is too small, reduce width and height accordingly
+        i1 = 0; // the larger rectangle might absorb one I already checked
+      }
+      else
+      {
+        i1++;
+      }
+    }
 
-    if(WB_UNLIKELY(pEntry->pImage->width < iWidth0))
+    if(pEntry->nPaintRect < PAINT_RECT_MAX)
     {
-      iWidth0 = pEntry->pImage->width;
+      pEntry->aPaintRect[(pEntry->nPaintRect)++] = xrct;
+      return;
     }
 
-    if(WB_UNLIKELY(pEntry->pImage->height < iHeight0))
+    // full - merge with the rectangle that grows the least, then try again
+
+    for(i1=0, iBest=0, ulBestCost=(unsigned long)-1; i1 < pEntry->nPaintRect; i1++)
     {
-      iHeight0 = pEntry->pImage->height;
+      __PaintRectUnion(&xrct, pEntry->aPaintRect + i1, &xrctU);
+
+      ulCost = __PaintRectArea(&xrctU) - __PaintRectArea(pEntry->aPaintRect + i1);
+
+      if(ulCost < ulBestCost)
+      {
+        ulBestCost = ulCost;
+        iBest = i1;
+      }
     }
 
-    // TODO:  limit the update to the bounding rectangle of the invalid/clipping region.  This
-    //        might be fastest.  But, when the invalid/clip region is empty, do it ALL.
+    __PaintRectUnion(&xrct, pEntry->aPaintRect + iBest, &xrct);
 
-    WBXPutImage(pDisplay, wID, pEntry->hGC, pEntry->pImage, 0, 0, iX0, iY0, iWidth0, iHeight0);
-    // NOTE:  this process should be very fast by comparison to getting the image from the drawable (window)
+    pEntry->aPaintRect[iBest] = pEntry->aPaintRect[--(pEntry->nPaintRect)];
   }
 }
 
+static int __WBHasQueuedEvents(WB_DISPLAY pDisp)
+{
+EVENT_QUEUE *pQ = __WBGetEventQueue(pDisp, 0);
 
+  return pQ && (pQ->pHead || pQ->pPaintHead);
+}
 
-/**********************************************************************/
-/*                                                                    */
-/*                  internal event queue processing                   */
-/*                                                                    */
-/**********************************************************************/
-
-static void __WBInitEvent()
+static void __WBExitEvent(void)
 {
-  int i1;
+EVENT_QUEUE *pQ;
+int i1;
 
-  if(iInitEventFlag)
+  while(pEventQueues)
   {
-    return; // already done
-  }
+    pQ = pEventQueues;
+    pEventQueues = pQ->pNext;
 
-  iInitEventFlag = 1;
+    WBFree(pQ);
+  }
 
-  // initialize the 'free' event pool, and all of the other event queue entries
+  for(i1=0; i1 < nEventBlocks; i1++)
+  {
+    WBFree(ppEventBlocks[i1]);
+  }
 
-  iWBFreeEvent = 0;
-  for(i1=1; i1 < EVENT_ARRAY_SIZE; i1++)
+  if(ppEventBlocks)
   {
-    axWBEvt[i1 - 1].iNext = i1;
+    WBFree(ppEventBlocks);
   }
 
-  axWBEvt[EVENT_ARRAY_SIZE - 1].iNext = -1;  // end of chain
-  iWBQueuedEvent = iWBQueueLast = -1;  // because the queue is empty
-  iWBPaintEvent = iWBPaintLast = -1;  // same here
+  ppEventBlocks = NULL;
+  nEventBlocks = 0;
+  nEventsQueued = 0;
+
+  pLastEventQueue = NULL;
+  pFreeEvents = NULL;
+
+  __WBDrainPostedEvents(); // with no display, these are simply discarded
+
+  bHaveEventLoopThread = 0;
 }
 
+static __inline__ int __WBIsEventLoopThread(void)
+{
+  return !bHaveEventLoopThread || pthread_equal(pthread_self(), thrdEventLoop);
+}
 
-static int __WBAddEvent(WB_DISPLAY pDisp, Window wID, XEvent *pEvent)
+// called by the 'WBPostXXX' functions from any thread other than the event loop's.  Only WBAlloc and
+// atomic operations are used here, so nothing that the event loop owns is touched.
+static int __WBPostFromThread(int iType, Window wID, XEvent *pEvent, unsigned int nDelay)
 {
-  int iEvent = -1;
-  // TODO:  synchronization objects?
+POSTED_EVENT *pNew, *pOld;
 
-  if(!iInitEventFlag)
-  {
-    __WBInitEvent();
-  }
 
-  if(iWBFreeEvent < 0) // none left
+  pNew = (POSTED_EVENT *)WBAlloc(sizeof(*pNew));
+
+  if(!pNew)
   {
+    WB_ERROR_PRINT("ERROR: %s - not enough memory to post event\n", __FUNCTION__);
     return -1;
   }
 
-  if(pEvent->type == Expose)
+  pNew->iType = iType;
+  pNew->wID = wID;
+  pNew->nDelay = nDelay;
+  memcpy(&(pNew->xEvt), pEvent, sizeof(XEvent));
+
+  do
   {
-    WBProcessExposeEvent((XExposeEvent *)pEvent);
-  }
+    pOld = pPostedEvents;
+    pNew->pNext = pOld;
+  } while(!WB_ATOMIC_CAS_PTR(&pPostedEvents, pOld, pNew));
+
+  WBWakeEventLoop(); // in case it's blocked in WBWaitForEvent
+
+  return 0;
+}
+
+// move events posted by other threads into the event queues.  Only the event loop's thread calls this.
+// returns the number of events that were moved.
+static int __WBDrainPostedEvents(void)
+{
+POSTED_EVENT *pList, *pNext, *pRev;
+int iRval = 0;
 
-  iEvent = iWBFreeEvent;
-  iWBFreeEvent = axWBEvt[iWBFreeEvent].iNext; // new 'free' pointer
-  axWBEvt[iEvent].iNext = -1;                 // mark the end of the 'iEvent's entry
 
-  // add to iWBQueuedEvent linked list
+  if(WB_LIKELY(!pPostedEvents))
+  {
+    return 0;
+  }
+
+  pList = WB_ATOMIC_XCHG_PTR(&pPostedEvents, (POSTED_EVENT *)NULL);
 
-  if(iWBQueuedEvent < 0)
+  for(pRev = NULL; pList; pList = pNext) // newest first, so reverse it
   {
-    iWBQueuedEvent = iEvent;
-    iWBQueueLast = iEvent;
+    pNext = pList->pNext;
+    pList->pNext = pRev;
+    pRev = pList;
   }
-  else
+
+  for(; pRev; pRev = pNext)
   {
-    if(iWBQueueLast < 0)
+    pNext = pRev->pNext;
+
+    if(pDefaultDisplay) // otherwise, I'm exiting
     {
-      // traverse the queue
-      iWBQueueLast = iWBQueuedEvent;
-      while(axWBEvt[iWBQueueLast].iNext != -1)
+      switch(pRev->iType)
       {
-        iWBQueueLast = axWBEvt[iWBQueueLast].iNext;
+        case POSTED_EVENT_PRIORITY:
+          WBPostPriorityEvent(pRev->wID, &(pRev->xEvt));
+          break;
+
+        case POSTED_EVENT_APP:
+          WBPostAppEvent(&(pRev->xEvt));
+          break;
+
+        case POSTED_EVENT_DELAYED:
+          WBPostDelayedEvent(&(pRev->xEvt), pRev->nDelay);
+          break;
+
+        default:
+          WBPostEvent(pRev->wID, &(pRev->xEvt));
+          break;
       }
+
+      iRval++;
     }
 
-    axWBEvt[iWBQueueLast].iNext = iEvent;
-    iWBQueueLast = iEvent;
+    WBFree(pRev);
   }
 
-  axWBEvt[iEvent].pDisplay = pDisp;
-  axWBEvt[iEvent].wID = wID;
-  memcpy(&(axWBEvt[iEvent].xEvt), pEvent, sizeof(XEvent));
+  return iRval;
+}
+
+
+static int __WBAddEvent(WB_DISPLAY pDisp, Window wID, XEvent *pEvent)
+{
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry;
+  // TODO:  synchronization objects?
+
+  pQ = __WBGetEventQueue(pDisp, 1);
+  pEntry = pQ ? __WBAllocEventEntry() : NULL;
+
+  if(!pEntry) // out of memory
+  {
+    WB_ERROR_PRINT("ERROR: %s - not enough memory to queue event\n", __FUNCTION__);
+    return -1;
+  }
+
+  if(pEvent->type == Expose)
+  {
+    WBProcessExposeEvent((XExposeEvent *)pEvent);
+  }
+
+  pEntry->wID = wID;
+  memcpy(&(pEntry->xEvt), pEvent, sizeof(XEvent));
+
+  __WBLinkEventTail(&(pQ->pHead), &(pQ->pTail), pEntry);
 
   return 0; // success
 }
 
 static void __WBDelWindowPaintEvents(WB_DISPLAY pDisp, Window wID)
 {
-  int iEvent, iPrev, iTemp;
-  XEvent event;
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry, *pNext;
+XEvent event;
 
-  if(iWBPaintEvent < 0)
+
+  pQ = __WBGetEventQueue(pDisp, 0);
+
+  if(!pQ || !pQ->pPaintHead)
   {
     return;
   }
 
-  iEvent = iWBPaintEvent;
-  iPrev = -1;
-
-  while(iEvent >= 0)
+  for(pEntry = pQ->pPaintHead; pEntry; pEntry = pNext)
   {
-    if(axWBEvt[iEvent].wID == wID &&
-       axWBEvt[iEvent].pDisplay == pDisp)
-    {
-      if(iPrev < 0)
-      {
-        iWBPaintEvent = axWBEvt[iEvent].iNext;  // remove from head
-        if(iWBPaintEvent < 0)
-        {
-          iWBPaintLast = -1;
-        }
-      }
-      else
-      {
-        axWBEvt[iPrev].iNext = axWBEvt[iEvent].iNext;  // remove from chain
-        if(axWBEvt[iPrev].iNext < 0)
-        {
-          iWBPaintLast = iPrev;
-        }
-      }
-
-      iTemp = iEvent;
+    pNext = pEntry->pNext;
 
-      // add 'iEvent' to the chain of free events
-      iEvent = axWBEvt[iTemp].iNext;
-      axWBEvt[iTemp].iNext = iWBFreeEvent;
-      iWBFreeEvent = iTemp;
-    }
-    else
+    if(pEntry->wID == wID)
     {
-      iPrev = iEvent;
-      iEvent = axWBEvt[iEvent].iNext;
+      __WBUnlinkEvent(&(pQ->pPaintHead), &(pQ->pPaintTail), pEntry);
+      __WBFreeEventEntry(pEntry);
     }
   }
 
@@ -8459,91 +10309,39 @@ static void __WBDelWindowPaintEvents(WB_DISPLAY pDisp, Window wID)
 
 static void __WBDelWindowEvents(WB_DISPLAY pDisp, Window wID)
 {
-  int iEvent, iPrev, iTemp;
-  XEvent event;
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry, *pNext;
+XEvent event;
 
-//  if(iWBQueuedEvent < 0 && iWBPaintEvent < 0)
-//  {
-//    return;
-//  }
 
-  // traverse iWBQueuedEvent
+  pQ = __WBGetEventQueue(pDisp, 0);
 
-  iEvent = iWBQueuedEvent;
-  iPrev = -1;
-  while(iEvent >= 0)
+  if(pQ)
   {
-    if(axWBEvt[iEvent].wID == wID &&
-       axWBEvt[iEvent].pDisplay == pDisp)
+    // traverse the event queue
+
+    for(pEntry = pQ->pHead; pEntry; pEntry = pNext)
     {
-      if(iPrev < 0)
-      {
-        iWBQueuedEvent = axWBEvt[iEvent].iNext;  // remove from head
-        if(iWBQueuedEvent < 0)
-        {
-          iWBQueueLast = -1;
-        }
-      }
-      else
+      pNext = pEntry->pNext;
+
+      if(pEntry->wID == wID)
       {
-        axWBEvt[iPrev].iNext = axWBEvt[iEvent].iNext;  // remove from chain
-        if(axWBEvt[iPrev].iNext < 0)
-        {
-          iWBQueueLast = iPrev;
-        }
+        __WBUnlinkEvent(&(pQ->pHead), &(pQ->pTail), pEntry);
+        __WBFreeEventEntry(pEntry);
       }
-
-      iTemp = iEvent;
-
-      // add 'iEvent' to the chain of free events
-      iEvent = axWBEvt[iTemp].iNext;
-      axWBEvt[iTemp].iNext = iWBFreeEvent;
-      iWBFreeEvent = iTemp;
-    }
-    else
-    {
-      iPrev = iEvent;
-      iEvent = axWBEvt[iEvent].iNext;
     }
-  }
 
-  // NOW traverse iWBPaintEvent
+    // NOW traverse the paint queue
 
-  iEvent = iWBPaintEvent;
-  iPrev = -1;
-  while(iEvent >= 0)
-  {
-    if(axWBEvt[iEvent].wID == wID &&
-       axWBEvt[iEvent].pDisplay == pDisp)
+    for(pEntry = pQ->pPaintHead; pEntry; pEntry = pNext)
     {
-      if(iPrev < 0)
-      {
-        iWBPaintEvent = axWBEvt[iEvent].iNext;  // remove from head
-        if(iWBPaintEvent < 0)
-        {
-          iWBPaintLast = -1;
-        }
-      }
-      else
+      pNext = pEntry->pNext;
+
+      if(pEntry->wID == wID)
       {
-        axWBEvt[iPrev].iNext = axWBEvt[iEvent].iNext;  // remove from chain
-        if(axWBEvt[iPrev].iNext < 0)
-        {
-          iWBPaintLast = iPrev;
-        }
+        __WBUnlinkEvent(&(pQ->pPaintHead), &(pQ->pPaintTail), pEntry);
+        __WBFreeEventEntry(pEntry);
       }
-
-      iTemp = iEvent;
-
-      // add 'iEvent' to the chain of free events
-      iEvent = axWBEvt[iTemp].iNext;
-      axWBEvt[iTemp].iNext = iWBFreeEvent;
-      iWBFreeEvent = iTemp;
-    }
-    else
-    {
-      iPrev = iEvent;
-      iEvent = axWBEvt[iEvent].iNext;
     }
   }
 
@@ -8564,16 +10362,16 @@ static void __WBDelWindowEvents(WB_DISPLAY pDisp, Window wID)
 
 static int __WBInsertPriorityEvent(WB_DISPLAY pDisp, Window wID, XEvent *pEvent)
 {
-  int iEvent = -1;
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry;
   // TODO:  synchronization objects?
 
-  if(!iInitEventFlag)
-  {
-    __WBInitEvent();
-  }
+  pQ = __WBGetEventQueue(pDisp, 1);
+  pEntry = pQ ? __WBAllocEventEntry() : NULL;
 
-  if(iWBFreeEvent < 0) // none left
+  if(!pEntry) // out of memory
   {
+    WB_ERROR_PRINT("ERROR: %s - not enough memory to queue event\n", __FUNCTION__);
     return -1;
   }
 
@@ -8581,171 +10379,144 @@ static int __WBInsertPriorityEvent(WB_DISPLAY pDisp, Window wID, XEvent *pEvent)
 //  if(pEvent->type == Expose)
 //    WBProcessExposeEvent((XExposeEvent *)pEvent);
 
-  iEvent = iWBFreeEvent;
-  iWBFreeEvent = axWBEvt[iEvent].iNext;
-  axWBEvt[iEvent].iNext = -1;  // the end
-
-  // add to iWBQueuedEvent linked list
-
-  if(iWBQueuedEvent < 0)
-  {
-    iWBQueuedEvent = iEvent;
-    iWBQueueLast = iEvent;
-  }
-  else
-  {
-    int iTempEvent = iWBQueuedEvent;
+  pEntry->wID = wID;
+  memcpy(&(pEntry->xEvt), pEvent, sizeof(XEvent));
 
-    // insert at the beginning of the chain
-    iWBQueuedEvent = iEvent;
-    axWBEvt[iWBQueuedEvent].iNext = iTempEvent;
-  }
+  // insert at the beginning of the queue
 
-  axWBEvt[iEvent].pDisplay = pDisp;
-  axWBEvt[iEvent].wID = wID;
-  memcpy(&(axWBEvt[iEvent].xEvt), pEvent, sizeof(XEvent));
+  __WBLinkEventHead(&(pQ->pHead), &(pQ->pTail), pEntry);
 
   return 0;
 }
 
 static int __WBNextPaintEvent(WB_DISPLAY pDisp, XEvent *pEvent, Window wID)
 {
-  int iRval = iWBPaintEvent, iPrev = -1;
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry;
+
+
+  pQ = __WBGetEventQueue(pDisp, 0);
+
+  if(!pQ)
+  {
+    return -1;
+  }
+
+  pEntry = pQ->pPaintHead;
 
-  while(iRval >= 0)
+  if(WB_UNLIKELY(wID != None)) // a specific window (one entry per window, so this is short)
   {
-    if(WB_LIKELY(axWBEvt[iRval].pDisplay == pDisp) &&
-       (WB_LIKELY(wID == None) || axWBEvt[iRval].xEvt.xany.window == wID))
+    while(pEntry && pEntry->xEvt.xany.window != wID)
     {
-      break;
+      pEntry = pEntry->pNext;
     }
-
-    iPrev = iRval;
-    iRval = axWBEvt[iRval].iNext;
   }
 
-  if(iRval >= 0)
+  if(!pEntry)
   {
-    WB_DEBUG_PRINT(DebugLevel_Verbose | DebugSubSystem_Window | DebugSubSystem_Event,
+    return -1;
+  }
+
+  WB_DEBUG_PRINT(DebugLevel_Verbose | DebugSubSystem_Window | DebugSubSystem_Event,
                  "%s - getting an EXPOSE event for %d (%08xH)\n",
                  __FUNCTION__,
-                 (int)axWBEvt[iRval].xEvt.xany.window,
-                 (int)axWBEvt[iRval].xEvt.xany.window);
+                 (int)pEntry->xEvt.xany.window,
+                 (int)pEntry->xEvt.xany.window);
 
-    if(iRval == iWBPaintEvent)
-    {
-      iWBPaintEvent = axWBEvt[iRval].iNext;
-    }
-    else
+  __WBUnlinkEvent(&(pQ->pPaintHead), &(pQ->pPaintTail), pEntry);
+  __WBEventEntryDequeued(pEntry);
+
+  if(pEvent)
+  {
+    _WINDOW_ENTRY_ *pWindowEntry = WBGetWindowEntry(pEntry->wID);
+
+    memcpy(pEvent, &(pEntry->xEvt), sizeof(XEvent));
+
+    // hand the exposed area to the window so that WBBeginPaint() can use it as the clip region.
+    // a single rectangle is the same as the event's own bounds, so there's nothing to pass along.
+
+    if(pWindowEntry)
     {
-      if(iRval == iWBPaintLast)
+      if(pWindowEntry->rgnExpose != None)
       {
-        iWBPaintLast = iPrev;
-        axWBEvt[iPrev].iNext = -1;
+        XDestroyRegion(pWindowEntry->rgnExpose);
+        pWindowEntry->rgnExpose = None;
       }
-      else if(iPrev >= 0)
+
+      if(pEntry->nPaintRect > 1)
       {
-        axWBEvt[iPrev].iNext = axWBEvt[iRval].iNext;
-      }
-    }
+        int i1;
 
-    if(iWBPaintEvent < 0)
-    {
-      iWBPaintLast = -1;
-    }
+        pWindowEntry->rgnExpose = XCreateRegion();
 
-    if(pEvent)
-    {
-      memcpy(pEvent, &(axWBEvt[iRval].xEvt), sizeof(XEvent));
+        for(i1=0; pWindowEntry->rgnExpose && i1 < pEntry->nPaintRect; i1++)
+        {
+          XUnionRectWithRegion(pEntry->aPaintRect + i1, pWindowEntry->rgnExpose, pWindowEntry->rgnExpose);
+        }
+      }
     }
-
-    axWBEvt[iRval].iNext = iWBFreeEvent;
-    iWBFreeEvent = iRval;
   }
 
-  return iRval;
+  __WBFreeEventEntry(pEntry);
+
+  return 0;
 }
 
 
 static int __WBNextDisplayEvent(WB_DISPLAY pDisp, XEvent *pEvent)
 {
-  int iRval = iWBQueuedEvent, iPrev = -1;
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry;
 
-  while(WB_LIKELY(iRval >= 0))
-  {
-    if(WB_LIKELY(axWBEvt[iRval].pDisplay == pDisp))
-    {
-      break;
-    }
 
-    iPrev = iRval;
-    iRval = axWBEvt[iRval].iNext;
-  }
+  __WBDrainPostedEvents(); // events posted by other threads go to the end of the queue
 
-  if(WB_LIKELY(iRval >= 0)) // I want the "I have an event" path to be faster
+  pQ = __WBGetEventQueue(pDisp, 0);
+
+  if(WB_UNLIKELY(!pQ))
   {
-    if(WB_LIKELY(iRval == iWBQueuedEvent)) // TODO:  is this "likely" ?
-    {
-      iWBQueuedEvent = axWBEvt[iRval].iNext;
+    return 0;
+  }
 
-      if(iWBQueuedEvent < 0)
-      {
-        iWBQueueLast = -1;
-      }
-    }
-    else
-    {
-      if(iRval == iWBQueueLast)
-      {
-        iWBQueueLast = iPrev;
-        axWBEvt[iPrev].iNext = -1;
-      }
-      else if(iPrev >= 0)
-      {
-        axWBEvt[iPrev].iNext = axWBEvt[iRval].iNext;
-      }
-    }
+  pEntry = pQ->pHead;
+
+  if(WB_LIKELY(pEntry != NULL)) // I want the "I have an event" path to be faster
+  {
+    __WBUnlinkEvent(&(pQ->pHead), &(pQ->pTail), pEntry);
+    __WBEventEntryDequeued(pEntry);
 
     WB_DEBUG_PRINT(DebugLevel_Excessive | DebugSubSystem_Window | DebugSubSystem_Event,
                    "%s - getting %s event for %d (%08xH)\n",
                    __FUNCTION__,
-                   WBEventName(axWBEvt[iRval].xEvt.type),
-                   (int)axWBEvt[iRval].xEvt.xany.window,
-                   (int)axWBEvt[iRval].xEvt.xany.window);
+                   WBEventName(pEntry->xEvt.type),
+                   (int)pEntry->xEvt.xany.window,
+                   (int)pEntry->xEvt.xany.window);
 
     if(WB_LIKELY(pEvent))
     {
-      memcpy(pEvent, &(axWBEvt[iRval].xEvt), sizeof(XEvent));
+      memcpy(pEvent, &(pEntry->xEvt), sizeof(XEvent));
     }
 
-    axWBEvt[iRval].iNext = iWBFreeEvent;
-    iWBFreeEvent = iRval;
-  }
-
-  // TODO:  is this really "unlikely" ?
-  if(WB_UNLIKELY(iRval < 0))  // no event found in normal queue - try paint queue
-  {
-    // this function is separated out so I can call it directly - see WBUpdateWindowImmediately()
+    __WBFreeEventEntry(pEntry);
 
-    iRval = __WBNextPaintEvent(pDisp, pEvent, None);
+    return 1;
   }
 
-  return iRval >= 0;
+  // no event found in normal queue - try paint queue
+  // this function is separated out so I can call it directly - see WBUpdateWindowImmediately()
+
+  return __WBNextPaintEvent(pDisp, pEvent, None) >= 0;
 }
 
 static void WBInternalProcessExposeEvent(XExposeEvent *pEvent)
 {
-int iEvent;
+EVENT_QUEUE *pQ;
+EVENT_ENTRY *pEntry;
 Window wID;
 WB_DISPLAY pDisp;
 WB_GEOM geom;
 
 
-  if(!iInitEventFlag)
-  {
-    __WBInitEvent();
-  }
-
   // expose events are combined whenever possible
   // so that I can choose to respond to them immediately, increment
   // the 'count' member to indicate that at least one more event is waiting
@@ -8759,36 +10530,49 @@ WB_GEOM geom;
 
   // STEP 1:  search the 'paint' queue for a matching window ID
 
-  for(iEvent=iWBPaintEvent; iEvent >= 0; iEvent = axWBEvt[iEvent].iNext)
+  pQ = __WBGetEventQueue(pDisp, 1);
+
+  for(pEntry = pQ ? pQ->pPaintHead : NULL; pEntry; pEntry = pEntry->pNext)
   {
-    if(axWBEvt[iEvent].wID == wID && axWBEvt[iEvent].pDisplay == pDisp)
+    if(pEntry->wID == wID)
     {
       break;
     }
   }
 
-  if(iEvent >= 0)  // found!
+  if(pEntry)  // found!
   {
-    // expand the expose event's rectangle to include THIS one
+    XRectangle xrct;
+
+    // keep track of the actual exposed area, so that two small areas don't cause everything between them to be painted
+
+    xrct.x = pEvent->x;
+    xrct.y = pEvent->y;
+    xrct.width = pEvent->width;
+    xrct.height = pEvent->height;
+
+    __WBAddPaintRect(pEntry, &xrct);
 
-    if(axWBEvt[iEvent].xEvt.xexpose.x > pEvent->x)
+    // expand the expose event's rectangle (the bounds) to include THIS one
+
+    if(pEntry->xEvt.xexpose.x > pEvent->x)
     {
-      axWBEvt[iEvent].xEvt.xexpose.x = pEvent->x;
+      pEntry->xEvt.xexpose.x = pEvent->x;
     }
 
-    if(axWBEvt[iEvent].xEvt.xexpose.y > pEvent->y)
+    if(pEntry->xEvt.xexpose.y > pEvent->y)
     {
-      axWBEvt[iEvent].xEvt.xexpose.y = pEvent->y;
+      pEntry->xEvt.xexpose.y = pEvent->y;
     }
 
-    if(axWBEvt[iEvent].xEvt.xexpose.x + axWBEvt[iEvent].xEvt.xexpose.width < pEvent->x + pEvent->width)
+    if(pEntry->xEvt.xexpose.x + pEntry->xEvt.xexpose.width < pEvent->x + pEvent->width)
     {
-      axWBEvt[iEvent].xEvt.xexpose.width = pEvent->x + pEvent->width - axWBEvt[iEvent].xEvt.xexpose.x;
+      pEntry->xEvt.xexpose.width = pEvent->x + pEvent->width - pEntry->xEvt.xexpose.x;
     }
 
-    if(axWBEvt[iEvent].xEvt.xexpose.y + axWBEvt[iEvent].xEvt.xexpose.height < pEvent->y + pEvent->height)
+    if(pEntry->xEvt.xexpose.y + pEntry->xEvt.xexpose.height < pEvent->y + pEvent->height)
     {
-      axWBEvt[iEvent].xEvt.xexpose.height = pEvent->y + pEvent->height - axWBEvt[iEvent].xEvt.xexpose.y;
+      pEntry->xEvt.xexpose.height = pEvent->y + pEvent->height - pEntry->xEvt.xexpose.y;
     }
   }
   else
@@ -8796,46 +10580,27 @@ WB_GEOM geom;
     // make a copy of the event and put it into the 'paint' queue
     // note that if I have no room, I'll simply have to reject it
 
-    if(iWBFreeEvent < 0) // I check here because an existing event might be editable
+    pEntry = pQ ? __WBAllocEventEntry() : NULL;
+
+    if(!pEntry)
     {
-      WB_ERROR_PRINT("ERROR: %s - no more free 'event queue' entries\n", __FUNCTION__);
+      WB_ERROR_PRINT("ERROR: %s - not enough memory for 'event queue' entry\n", __FUNCTION__);
       return; // can't do anything else, really
     }
     else
     {
-      iEvent = iWBFreeEvent;
-      iWBFreeEvent = axWBEvt[iWBFreeEvent].iNext; // remove 'iEvent' from the head of the free chain
-
-      axWBEvt[iEvent].iNext = -1;  // the end of the chain on my new "not free any more" event 'iEvent'
-
-      // add to iWBPaintEvent linked list
-
-      if(iWBPaintEvent < 0)
-      {
-        iWBPaintEvent = iEvent;
-        iWBPaintLast = iEvent;
-      }
-      else
-      {
-        if(iWBPaintLast < 0)
-        {
-          // traverse the queue
-          iWBPaintLast = iWBPaintEvent;
-          while(axWBEvt[iWBPaintLast].iNext != -1)
-          {
-            iWBPaintLast = axWBEvt[iWBPaintLast].iNext;
-          }
-        }
+      pEntry->wID = wID;
+      memcpy(&(pEntry->xEvt), pEvent, sizeof(XExposeEvent));
 
-        axWBEvt[iWBPaintLast].iNext = iEvent;
-        iWBPaintLast = iEvent;
-      }
+      pEntry->xEvt.xexpose.count = 0;  // always make this a zero
 
-      axWBEvt[iEvent].pDisplay = pDisp;
-      axWBEvt[iEvent].wID = wID;
-      memcpy(&(axWBEvt[iEvent].xEvt), pEvent, sizeof(XEvent));
+      pEntry->nPaintRect = 1;
+      pEntry->aPaintRect[0].x = pEvent->x;
+      pEntry->aPaintRect[0].y = pEvent->y;
+      pEntry->aPaintRect[0].width = pEvent->width;
+      pEntry->aPaintRect[0].height = pEvent->height;
 
-      axWBEvt[iEvent].xEvt.xexpose.count = 0;  // always make this a zero
+      __WBLinkEventTail(&(pQ->pPaintHead), &(pQ->pPaintTail), pEntry);
     }
   }
 
@@ -8882,7 +10647,14 @@ int WBNextEvent(WB_DISPLAY pDisplay, XEvent *pEvent)
 
 int WBPostEvent(Window wID, XEvent *pEvent)
 {
-  _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+  _WINDOW_ENTRY_ *pEntry;
+
+  if(WB_UNLIKELY(!__WBIsEventLoopThread()))
+  {
+    return __WBPostFromThread(POSTED_EVENT_NORMAL, wID, pEvent, 0);
+  }
+
+  pEntry = WBGetWindowEntry(wID);
 
   if(!pEntry)
     return -1;
@@ -8895,12 +10667,25 @@ int WBPostEvent(Window wID, XEvent *pEvent)
 
 void WBPostDelayedEvent(XEvent *pEvent, unsigned int nDelay)
 {
+  if(WB_UNLIKELY(!__WBIsEventLoopThread()))
+  {
+    __WBPostFromThread(POSTED_EVENT_DELAYED, None, pEvent, nDelay);
+    return;
+  }
+
   __CreateDelayedEvent(pEvent, nDelay);
 }
 
 int WBPostPriorityEvent(Window wID, XEvent *pEvent)
 {
-  _WINDOW_ENTRY_ *pEntry = WBGetWindowEntry(wID);
+  _WINDOW_ENTRY_ *pEntry;
+
+  if(WB_UNLIKELY(!__WBIsEventLoopThread()))
+  {
+    return __WBPostFromThread(POSTED_EVENT_PRIORITY, wID, pEvent, 0);
+  }
+
+  pEntry = WBGetWindowEntry(wID);
 
 //  if(pEvent->type == ClientMessage)
 //      fprintf(stderr, "TEMPORARY: client message in WBPostPriorityEvent\n");
@@ -8918,6 +10703,11 @@ int WBPostAppEvent(XEvent *pEvent)
 {
   WB_DISPLAY pDisp = pDefaultDisplay;
 
+  if(WB_UNLIKELY(!__WBIsEventLoopThread()))
+  {
+    return __WBPostFromThread(POSTED_EVENT_APP, None, pEvent, 0);
+  }
+
 //  pEvent->xany.window = 0;  // make sure
   if(pEvent->xany.display)
   {
@@ -9448,6 +11238,350 @@ int iW, iH;
 }
 
 
+// ****************************************************
+//
+//     X   R E Q U E S T   S T A T I S T I C S
+//
+// ****************************************************
+
+#define XCALL_SITE_MAX  1024 /* call sites in the hash table (must be a power of 2) */
+#define XCALL_DEPTH_MAX 16   /* nesting depth for BEGIN_XCALL_DEBUG_WRAPPER that's tracked separately */
+
+typedef struct s_XCALL_SITE
+{
+  const char *szFunc;      // function name (from __FUNCTION__), or NULL for an unused entry
+  int iLine;
+  WB_UINT64 nCalls;
+  WB_UINT64 nRequests;     // X requests sent (not counting nested wrappers)
+  WB_UINT64 nRoundTrips;   // calls that waited for the X server
+  WB_UINT64 tTotal;        // nanoseconds (not counting nested wrappers)
+  WB_UINT64 tMax;
+} XCALL_SITE;
+
+typedef struct s_XCALL_THREAD
+{
+  int iDepth; // current BEGIN_XCALL_DEBUG_WRAPPER nesting level
+  struct
+  {
+    WB_UINT64 nRequests, nRoundTrips, tTime;
+  } aChild[XCALL_DEPTH_MAX + 1]; // totals for the nested wrappers at each level, subtracted from their parent
+} XCALL_THREAD;
+
+volatile int bWBXCallStats = 0;
+
+static pthread_mutex_t xXCallMutex = PTHREAD_MUTEX_INITIALIZER; // protects 'pXCallSites' and 'nXCallSites'
+static XCALL_SITE *pXCallSites = NULL;
+static int nXCallSites = 0;
+
+static pthread_key_t keyXCallThread;
+static pthread_once_t xXCallOnce = PTHREAD_ONCE_INIT;
+static int bXCallKey = 0;
+
+
+static void __XCallThreadDestructor(void *pData)
+{
+  WBFree(pData);
+}
+
+static void __XCallKeyInit(void)
+{
+  bXCallKey = !pthread_key_create(&keyXCallThread, __XCallThreadDestructor);
+}
+
+static XCALL_THREAD *__XCallThread(void)
+{
+XCALL_THREAD *pRval;
+
+
+  pthread_once(&xXCallOnce, __XCallKeyInit);
+
+  if(WB_UNLIKELY(!bXCallKey))
+  {
+    return NULL;
+  }
+
+  pRval = (XCALL_THREAD *)pthread_getspecific(keyXCallThread);
+
+  if(WB_UNLIKELY(!pRval))
+  {
+    pRval = (XCALL_THREAD *)WBAlloc(sizeof(*pRval));
+
+    if(pRval)
+    {
+      bzero(pRval, sizeof(*pRval));
+      pthread_setspecific(keyXCallThread, pRval);
+    }
+  }
+
+  return pRval;
+}
+
+// find (or add) the site table entry for 'szFunc' and 'iLine'.  Returns NULL if the table is full.
+static XCALL_SITE *__XCallSite(const char *szFunc, int iLine) // 'xXCallMutex' must be locked
+{
+unsigned int uiKey, uiIndex;
+
+
+  if(WB_UNLIKELY(!pXCallSites))
+  {
+    pXCallSites = (XCALL_SITE *)WBAlloc(XCALL_SITE_MAX * sizeof(*pXCallSites));
+
+    if(!pXCallSites)
+    {
+      return NULL;
+    }
+
+    bzero(pXCallSites, XCALL_SITE_MAX * sizeof(*pXCallSites));
+  }
+
+  uiKey = (unsigned int)((unsigned long)szFunc) ^ ((unsigned int)iLine << 16) ^ (unsigned int)iLine;
+  uiKey *= 0x9e3779b1U;
+  uiIndex = (uiKey ^ (uiKey >> 15)) & (XCALL_SITE_MAX - 1);
+
+  while(pXCallSites[uiIndex].szFunc)
+  {
+    if(pXCallSites[uiIndex].iLine == iLine &&
+       (pXCallSites[uiIndex].szFunc == szFunc || !strcmp(pXCallSites[uiIndex].szFunc, szFunc)))
+    {
+      return pXCallSites + uiIndex;
+    }
+
+    uiIndex = (uiIndex + 1) & (XCALL_SITE_MAX - 1);
+  }
+
+  if(nXCallSites >= XCALL_SITE_MAX * 3 / 4) // keep the probe sequences short
+  {
+    return NULL;
+  }
+
+  pXCallSites[uiIndex].szFunc = szFunc;
+  pXCallSites[uiIndex].iLine = iLine;
+  nXCallSites++;
+
+  return pXCallSites + uiIndex;
+}
+
+static void __XCallStatsFree(void)
+{
+XCALL_THREAD *pT;
+
+
+  bWBXCallStats = 0;
+
+  pthread_mutex_lock(&xXCallMutex);
+
+  if(pXCallSites)
+  {
+    WBFree(pXCallSites);
+    pXCallSites = NULL;
+  }
+
+  nXCallSites = 0;
+
+  pthread_mutex_unlock(&xXCallMutex);
+
+  if(bXCallKey && (pT = (XCALL_THREAD *)pthread_getspecific(keyXCallThread)) != NULL)
+  {
+    pthread_setspecific(keyXCallThread, NULL); // the calling thread's (other threads free theirs on exit)
+    WBFree(pT);
+  }
+}
+
+void WBXCallStatsBegin(WB_XCALL_SCOPE *pScope, const char *szFunc, int iLine)
+{
+XCALL_THREAD *pT;
+
+
+  pT = __XCallThread();
+
+  if(!pT)
+  {
+    return; // 'tStart' remains 0, so WBXCallStatsEnd won't be called
+  }
+
+  pScope->iDepth = ++(pT->iDepth);
+
+  if(pScope->iDepth <= XCALL_DEPTH_MAX)
+  {
+    bzero(pT->aChild + pScope->iDepth, sizeof(pT->aChild[0]));
+  }
+
+  pScope->szFunc = szFunc;
+  pScope->iLine = iLine;
+  pScope->ulRequest = pDefaultDisplay && __WBIsEventLoopThread() ? NextRequest(pDefaultDisplay) : 0;
+  pScope->tStart = WBGetMonotonicTimeNS();
+}
+
+void WBXCallStatsEnd(WB_XCALL_SCOPE *pScope)
+{
+XCALL_THREAD *pT;
+XCALL_SITE *pSite;
+WB_UINT64 tElapsed, tSelf, nRequests, nSelf;
+int bRoundTrip, bSelfRoundTrip;
+
+
+  tElapsed = WBGetMonotonicTimeNS() - pScope->tStart;
+  nRequests = 0;
+  bRoundTrip = 0;
+
+  if(pScope->ulRequest && pDefaultDisplay)
+  {
+    nRequests = NextRequest(pDefaultDisplay) - pScope->ulRequest;
+
+    // if the server has acknowledged a request that I sent, I must have waited for it
+
+    bRoundTrip = nRequests && (long)(LastKnownRequestProcessed(pDefaultDisplay) - pScope->ulRequest) >= 0;
+  }
+
+  pT = (XCALL_THREAD *)pthread_getspecific(keyXCallThread);
+
+  if(WB_UNLIKELY(!pT))
+  {
+    return;
+  }
+
+  pT->iDepth = pScope->iDepth - 1; // this also recovers from a nested wrapper that was exited without END_XCALL_DEBUG_WRAPPER
+
+  // subtract whatever the nested wrappers recorded, and add my totals to my parent's nested totals
+
+  tSelf = tElapsed;
+  nSelf = nRequests;
+  bSelfRoundTrip = bRoundTrip;
+
+  if(pScope->iDepth <= XCALL_DEPTH_MAX)
+  {
+    tSelf -= pT->aChild[pScope->iDepth].tTime < tSelf ? pT->aChild[pScope->iDepth].tTime : tSelf;
+    nSelf -= pT->aChild[pScope->iDepth].nRequests < nSelf ? pT->aChild[pScope->iDepth].nRequests : nSelf;
+    bSelfRoundTrip = bRoundTrip && !pT->aChild[pScope->iDepth].nRoundTrips;
+  }
+
+  if(pT->iDepth <= XCALL_DEPTH_MAX)
+  {
+    pT->aChild[pT->iDepth].tTime += tElapsed;
+    pT->aChild[pT->iDepth].nRequests += nRequests;
+    pT->aChild[pT->iDepth].nRoundTrips += bRoundTrip;
+  }
+
+  pthread_mutex_lock(&xXCallMutex);
+
+  pSite = __XCallSite(pScope->szFunc, pScope->iLine);
+
+  if(pSite)
+  {
+    pSite->nCalls++;
+    pSite->nRequests += nSelf;
+    pSite->nRoundTrips += bSelfRoundTrip;
+    pSite->tTotal += tSelf;
+
+    if(pSite->tMax < tSelf)
+    {
+      pSite->tMax = tSelf;
+    }
+  }
+
+  pthread_mutex_unlock(&xXCallMutex);
+}
+
+void WBXCallStatsEnable(int bEnable)
+{
+  bWBXCallStats = bEnable ? 1 : 0;
+}
+
+void WBXCallStatsReset(void)
+{
+  pthread_mutex_lock(&xXCallMutex);
+
+  if(pXCallSites)
+  {
+    bzero(pXCallSites, XCALL_SITE_MAX * sizeof(*pXCallSites));
+  }
+
+  nXCallSites = 0;
+
+  pthread_mutex_unlock(&xXCallMutex);
+}
+
+static int __XCallSiteCompare(const void *p1, const void *p2)
+{
+const XCALL_SITE *pS1 = *(const XCALL_SITE * const *)p1;
+const XCALL_SITE *pS2 = *(const XCALL_SITE * const *)p2;
+
+
+  return pS1->tTotal < pS2->tTotal ? 1 : pS1->tTotal > pS2->tTotal ? -1 : 0;
+}
+
+void WBXCallStatsDump(int nTopSites)
+{
+XCALL_SITE **ppSites;
+XCALL_SITE xTotal;
+int i1, nSites;
+
+
+  pthread_mutex_lock(&xXCallMutex);
+
+  if(!nXCallSites)
+  {
+    pthread_mutex_unlock(&xXCallMutex);
+
+    return;
+  }
+
+  ppSites = (XCALL_SITE **)WBAlloc(nXCallSites * sizeof(*ppSites));
+
+  if(!ppSites)
+  {
+    pthread_mutex_unlock(&xXCallMutex);
+
+    WB_ERROR_PRINT("ERROR:  %s - not enough memory\n", __FUNCTION__);
+    return;
+  }
+
+  bzero(&xTotal, sizeof(xTotal));
+
+  for(i1=0, nSites=0; i1 < XCALL_SITE_MAX; i1++)
+  {
+    if(pXCallSites[i1].szFunc)
+    {
+      ppSites[nSites++] = pXCallSites + i1;
+
+      xTotal.nCalls += pXCallSites[i1].nCalls;
+      xTotal.nRequests += pXCallSites[i1].nRequests;
+      xTotal.nRoundTrips += pXCallSites[i1].nRoundTrips;
+      xTotal.tTotal += pXCallSites[i1].tTotal;
+    }
+  }
+
+  qsort(ppSites, nSites, sizeof(*ppSites), __XCallSiteCompare);
+
+  WBDebugPrint("\n** X REQUEST STATISTICS **  (%d call sites, times in microseconds)\n"
+               "     calls   requests  round trips        total      average          max  call site\n"
+               "%10llu %10llu %12llu %12.1f %12.2f %12s  (all)\n",
+               nSites,
+               (unsigned long long)xTotal.nCalls, (unsigned long long)xTotal.nRequests,
+               (unsigned long long)xTotal.nRoundTrips,
+               (double)xTotal.tTotal / 1000.0,
+               (double)xTotal.tTotal / 1000.0 / (double)xTotal.nCalls,
+               "");
+
+  for(i1=0; i1 < nSites && (nTopSites <= 0 || i1 < nTopSites); i1++)
+  {
+    WBDebugPrint("%10llu %10llu %12llu %12.1f %12.2f %12.1f  %s:%d\n",
+                 (unsigned long long)ppSites[i1]->nCalls, (unsigned long long)ppSites[i1]->nRequests,
+                 (unsigned long long)ppSites[i1]->nRoundTrips,
+                 (double)ppSites[i1]->tTotal / 1000.0,
+                 (double)ppSites[i1]->tTotal / 1000.0 / (double)ppSites[i1]->nCalls,
+                 (double)ppSites[i1]->tMax / 1000.0,
+                 ppSites[i1]->szFunc, ppSites[i1]->iLine);
+  }
+
+  WBDebugPrint("\n");
+
+  pthread_mutex_unlock(&xXCallMutex);
+
+  WBFree(ppSites);
+}
+
+
 // ****************************************************
 //
 //            E R R O R   H A N D L I N G